@@ -5,15 +5,82 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <libgen.h>
 #include <ctype.h>
+#include <limits.h>
 #include <unistd.h>
 
 #include "data_storage.h"
 
 #define WARN(str) fprintf(stderr, "WARNING: " str "\n")
 
+/*
+ * Measured runtime database, loaded with -r. One record per line, the
+ * test name followed by the measured wall time in milliseconds; the
+ * values are distilled from the per-test rusage records the library
+ * prints when LTP_RUSAGE is set. Matching tests get a "runtime_ms" key
+ * in the metadata output, which a parallel runner can use to schedule
+ * the longest tests first.
+ */
+static struct runtime {
+	char *name;
+	long long ms;
+} *runtimes;
+static unsigned int runtimes_cnt;
+
+static int runtime_cmp(const void *a, const void *b)
+{
+	return strcmp(((const struct runtime *)a)->name,
+		      ((const struct runtime *)b)->name);
+}
+
+static int load_runtimes(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	unsigned int cap = 128;
+	char line[512], name[256];
+	long long ms;
+
+	if (!f) {
+		fprintf(stderr, "can't open runtimes file %s\n", path);
+		return 1;
+	}
+
+	runtimes = malloc(cap * sizeof(*runtimes));
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%255s %lld", name, &ms) != 2 ||
+		    name[0] == '#')
+			continue;
+
+		if (runtimes_cnt >= cap) {
+			cap *= 2;
+			runtimes = realloc(runtimes, cap * sizeof(*runtimes));
+		}
+
+		runtimes[runtimes_cnt].name = strdup(name);
+		runtimes[runtimes_cnt].ms = ms;
+		runtimes_cnt++;
+	}
+
+	fclose(f);
+	qsort(runtimes, runtimes_cnt, sizeof(*runtimes), runtime_cmp);
+	return 0;
+}
+
+static long long runtime_lookup(const char *name)
+{
+	struct runtime key = { .name = (char *)name };
+	struct runtime *res;
+
+	res = bsearch(&key, runtimes, runtimes_cnt, sizeof(*runtimes),
+		      runtime_cmp);
+
+	return res ? res->ms : -1;
+}
+
 static void oneline_comment(FILE *f)
 {
 	int c;
@@ -382,19 +449,14 @@ const char *strip_name(char *path)
 	return name;
 }
 
-int main(int argc, char *argv[])
+static void process_file(char *path, FILE *out)
 {
 	unsigned int i;
 	struct data_node *res;
 
-	if (argc != 2) {
-		fprintf(stderr, "Usage: docparse filename.c\n");
-		return 1;
-	}
-
-	res = parse_file(argv[1]);
+	res = parse_file(path);
 	if (!res)
-		return 0;
+		return;
 
 	/* Filter out useless data */
 	for (i = 0; filter_out[i]; i++)
@@ -404,7 +466,7 @@ int main(int argc, char *argv[])
 	for (i = 0; implies[i].flag; i++) {
 		if (data_node_hash_get(res, implies[i].flag) &&
 		    data_node_hash_get(res, implies[i].implies))
-			fprintf(stderr, "%s: useless tag: %s\n", argv[1], implies[i].implies);
+			fprintf(stderr, "%s: useless tag: %s\n", path, implies[i].implies);
 	}
 
 	for (i = 0; implies[i].flag; i++) {
@@ -413,10 +475,81 @@ int main(int argc, char *argv[])
 			data_node_hash_add(res, implies[i].implies, data_node_string("1"));
 	}
 
-	data_node_hash_add(res, "fname", data_node_string(argv[1]));
-	printf("  \"%s\": ", strip_name(argv[1]));
-	data_to_json(res, stdout, 2);
+	data_node_hash_add(res, "fname", data_node_string(path));
+
+	const char *name = strip_name(path);
+
+	if (runtimes_cnt) {
+		long long ms = runtime_lookup(name);
+
+		if (ms >= 0) {
+			char buf[32];
+
+			snprintf(buf, sizeof(buf), "%lld", ms);
+			data_node_hash_add(res, "runtime_ms",
+					   data_node_string(buf));
+		}
+	}
+
+	fprintf(out, "  \"%s\": ", name);
+	data_to_json(res, out, 2);
 	data_node_free(res);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *cache_dir = NULL;
+	char frag_path[PATH_MAX];
+	FILE *out;
+	int c, i;
+
+	while ((c = getopt(argc, argv, "c:r:")) != -1) {
+		switch (c) {
+		case 'c':
+			cache_dir = optarg;
+		break;
+		case 'r':
+			if (load_runtimes(optarg))
+				return 1;
+		break;
+		default:
+			goto usage;
+		}
+	}
+
+	if (optind >= argc)
+		goto usage;
+
+	for (i = optind; i < argc; i++) {
+		if (!cache_dir) {
+			process_file(argv[i], stdout);
+			continue;
+		}
+
+		/*
+		 * Cached mode: the JSON fragment goes to a file mirroring
+		 * the source path under cache_dir.  An empty fragment is
+		 * written even when the source has no tst_test struct, so
+		 * that the file is not re-parsed until it changes.
+		 */
+		if (snprintf(frag_path, sizeof(frag_path), "%s/%s.json",
+			     cache_dir, argv[i]) >= (int)sizeof(frag_path)) {
+			fprintf(stderr, "%s: path too long\n", argv[i]);
+			return 1;
+		}
+
+		out = fopen(frag_path, "w");
+		if (!out) {
+			fprintf(stderr, "can't write %s\n", frag_path);
+			return 1;
+		}
+
+		process_file(argv[i], out);
+		fclose(out);
+	}
 
 	return 0;
+usage:
+	fprintf(stderr, "Usage: docparse [-c cache_dir] [-r runtimes_file] filename.c ...\n");
+	return 1;
 }
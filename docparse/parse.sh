@@ -23,18 +23,50 @@ echo ' "timeout": 300,'
 echo " \"version\": \"$version\","
 echo ' "tests": {'
 
+docparse_bin=$top_builddir/docparse/docparse
+jobs=$(getconf _NPROCESSORS_ONLN 2>/dev/null) || jobs=1
+
+# Optional measured-runtime database ('test wall_ms' per line, distilled
+# from LTP_RUSAGE records); matching tests get a runtime_ms metadata key.
+runtimes_opt=
+if [ -n "$LTP_RUNTIMES" ] && [ -f "$LTP_RUNTIMES" ]; then
+	runtimes_opt="-r $LTP_RUNTIMES"
+fi
+
+# Per-file JSON fragments are cached in a tree mirroring testcases/ and
+# only re-parsed when the source (or the docparse binary) is newer, so
+# incremental rebuilds skip unchanged files entirely.
+cache="$top_builddir/docparse/metadata.cache"
+find testcases/ -type d | sed "s|^|$cache/|" | xargs mkdir -p
+
+stale="$cache/.stale"
+> "$stale"
+
+for test in `find testcases/ -name '*.c'`; do
+	frag="$cache/$test.json"
+	if [ ! -f "$frag" ] || [ "$test" -nt "$frag" ] || [ "$docparse_bin" -nt "$frag" ] || \
+	   { [ -n "$runtimes_opt" ] && [ "$LTP_RUNTIMES" -nt "$frag" ]; }; then
+		echo "$test" >> "$stale"
+	fi
+done
+
+# Shard the stale files across the available CPUs.
+if [ -s "$stale" ]; then
+	xargs -n 128 -P "$jobs" "$docparse_bin" $runtimes_opt -c "$cache" < "$stale"
+fi
+rm -f "$stale"
+
 first=1
 
 for test in `find testcases/ -name '*.c'`; do
-	a=$($top_builddir/docparse/docparse "$test")
-	if [ -n "$a" ]; then
+	frag="$cache/$test.json"
+	if [ -s "$frag" ]; then
 		if [ -z "$first" ]; then
 			echo ','
 		fi
 		first=
-		cat <<EOF
-$a
-EOF
+		cat "$frag"
+		echo
 	fi
 done
 
@@ -99,6 +99,11 @@ enum bpf_cmd {
 	BPF_TASK_FD_QUERY,
 	BPF_MAP_LOOKUP_AND_DELETE_ELEM,
 	BPF_MAP_FREEZE,
+	BPF_BTF_GET_NEXT_ID,
+	BPF_MAP_LOOKUP_BATCH,
+	BPF_MAP_LOOKUP_AND_DELETE_BATCH,
+	BPF_MAP_UPDATE_BATCH,
+	BPF_MAP_DELETE_BATCH,
 };
 
 enum bpf_map_type {
@@ -225,6 +230,23 @@ union bpf_attr {
 		uint32_t		line_info_cnt;	/* number of bpf_line_info records */
 	};
 
+	struct { /* struct used by BPF_MAP_*_BATCH commands */
+		aligned_uint64_t	in_batch;	/* start batch,
+							 * NULL to start from beginning
+							 */
+		aligned_uint64_t	out_batch;	/* output: next start batch */
+		aligned_uint64_t	keys;
+		aligned_uint64_t	values;
+		uint32_t		count;		/* input/output:
+							 * input: # of key/value
+							 * elements
+							 * output: # of filled elements
+							 */
+		uint32_t		map_fd;
+		uint64_t		elem_flags;
+		uint64_t		flags;
+	} batch;
+
 	struct { /* anonymous struct used by BPF_OBJ_* commands */
 		aligned_uint64_t	pathname;
 		uint32_t		bpf_fd;
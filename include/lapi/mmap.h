@@ -66,6 +66,23 @@
 # define MADV_KEEPONFORK 19
 #endif
 
+#ifndef MADV_COLD
+# define MADV_COLD    20
+#endif
+
+#ifndef MADV_PAGEOUT
+# define MADV_PAGEOUT 21
+#endif
+
+#ifndef MADV_POPULATE_READ
+# define MADV_POPULATE_READ  22
+# define MADV_POPULATE_WRITE 23
+#endif
+
+#ifndef MADV_COLLAPSE
+# define MADV_COLLAPSE 25
+#endif
+
 #ifndef MAP_FIXED_NOREPLACE
 
 #ifdef __alpha__
@@ -8,6 +8,8 @@
 
 #ifdef HAVE_NETINET_SCTP_H
 # include <netinet/sctp.h>
+#else
+# include <linux/sctp.h>
 #endif
 
 #ifndef SCTP_SOCKOPT_BINDX_ADD
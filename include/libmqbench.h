@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Common routines for the POSIX message queue benchmarks, implemented
+ * in libs/libltpnewipc/libmqbench.c. Tests using them have to link
+ * against -lltpnewipc and -lrt.
+ */
+
+#ifndef __LIBMQBENCH_H
+#define __LIBMQBENCH_H	1
+
+#include <mqueue.h>
+
+/*
+ * Creates a queue with the given depth and message size under a unique
+ * name and unlinks it immediately; TCONFs when the depth exceeds what
+ * the system is willing to provide.
+ */
+mqd_t mqbench_open(const char *file, const int lineno,
+		   long depth, long msgsize);
+#define MQBENCH_OPEN(depth, msgsize) \
+	mqbench_open(__FILE__, __LINE__, (depth), (msgsize))
+
+void mqbench_send(const char *file, const int lineno,
+		  mqd_t fd, const char *buf, size_t len);
+#define MQBENCH_SEND(fd, buf, len) \
+	mqbench_send(__FILE__, __LINE__, (fd), (buf), (len))
+
+ssize_t mqbench_recv(const char *file, const int lineno,
+		     mqd_t fd, char *buf, size_t len);
+#define MQBENCH_RECV(fd, buf, len) \
+	mqbench_recv(__FILE__, __LINE__, (fd), (buf), (len))
+
+#endif /* __LIBMQBENCH_H */
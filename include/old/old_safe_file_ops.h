@@ -38,6 +38,10 @@
 	safe_file_scanf(__FILE__, __LINE__, (cleanup_fn), \
 	                (path), (fmt), ## __VA_ARGS__)
 
+#define SAFE_FILE_SCANF_FD(cleanup_fn, fd, fmt, ...) \
+	safe_file_scanf_fd(__FILE__, __LINE__, (cleanup_fn), \
+	                   (fd), (fmt), ## __VA_ARGS__)
+
 #define FILE_LINES_SCANF(cleanup_fn, path, fmt, ...) \
 	file_lines_scanf(__FILE__, __LINE__, (cleanup_fn), 0, \
 			(path), (fmt), ## __VA_ARGS__)
@@ -54,6 +58,10 @@
 	safe_file_printf(__FILE__, __LINE__, (cleanup_fn), \
 	                 (path), (fmt), ## __VA_ARGS__)
 
+#define SAFE_FILE_PRINTF_FD(cleanup_fn, fd, fmt, ...) \
+	safe_file_printf_fd(__FILE__, __LINE__, (cleanup_fn), \
+	                    (fd), (fmt), ## __VA_ARGS__)
+
 #define SAFE_CP(cleanup_fn, src, dst) \
 	safe_cp(__FILE__, __LINE__, (cleanup_fn), (src), (dst))
 
@@ -30,6 +30,14 @@
  */
 void tst_tmpdir(void);
 
+/*
+ * Makes the next tst_tmpdir() call back the directory with a private tmpfs
+ * of size_mb megabytes (256MB when 0). When mounting the tmpfs fails the
+ * plain directory is used instead. The LTP_TMPDIR_TMPFS environment
+ * variable forces the tmpfs on (1) or off (0) regardless of this call.
+ */
+void tst_tmpdir_use_tmpfs(unsigned int size_mb);
+
 /*
  * Recursively remove the temporary directory created by tst_tmpdir().
  * This function is intended ONLY as a companion to tst_tmpdir().
@@ -36,6 +36,9 @@
 #define LIO_IO_ALISTIO          00010   /* single stride async listio */
 #define LIO_IO_SYNCV            00020   /* single-buffer readv/writev */
 #define LIO_IO_SYNCP            00040   /* pread/pwrite */
+#if defined(__linux__) && !defined(__UCLIBC__)
+#define LIO_IO_URING            00100   /* io_uring submit/reap */
+#endif
 
 #ifdef sgi
 #define LIO_IO_ATYPES           00077   /* all io types */
@@ -43,7 +46,7 @@
 #endif /* sgi */
 #if defined(__linux__) && !defined(__UCLIBC__)
 #define LIO_IO_TYPES            00061   /* all io types */
-#define LIO_IO_ATYPES           00077   /* all io types */
+#define LIO_IO_ATYPES           00177   /* all io types */
 #endif
 #if defined(__sun) || defined(__hpux) || defined(_AIX) || defined(__UCLIBC__)
 #define LIO_IO_TYPES            00021   /* all io types except pread/pwrite */
@@ -35,6 +35,22 @@ void safe_file_scanf(const char *file, const int lineno,
 		     const char *path, const char *fmt, ...)
 		     __attribute__ ((format (scanf, 5, 6)));
 
+/*
+ * Variants for hot polling loops: the caller keeps the file open and we
+ * pread()/pwrite() at offset 0, so re-reading a /proc or /sys value
+ * thousands of times does not redo the path lookup and stdio setup on
+ * every iteration.
+ */
+void safe_file_scanf_fd(const char *file, const int lineno,
+			void (*cleanup_fn)(void),
+			int fd, const char *fmt, ...)
+			__attribute__ ((format (scanf, 5, 6)));
+
+void safe_file_printf_fd(const char *file, const int lineno,
+			void (*cleanup_fn)(void),
+			int fd, const char *fmt, ...)
+			__attribute__ ((format (printf, 5, 6)));
+
 int file_lines_scanf(const char *file, const int lineno,
 		     void (*cleanup_fn)(void), int strict,
 		     const char *path, const char *fmt, ...)
@@ -50,6 +50,19 @@ ssize_t safe_sendmsg(const char *file, const int lineno, size_t msg_len,
 ssize_t safe_recvmsg(const char *file, const int lineno, size_t msg_len,
 		  int sockfd, struct msghdr *msg, int flags);
 
+struct mmsghdr;
+
+int safe_sendmmsg(const char *file, const int lineno, int sockfd,
+		  struct mmsghdr *msgvec, unsigned int vlen, int flags);
+
+int safe_recvmmsg(const char *file, const int lineno, int sockfd,
+		  struct mmsghdr *msgvec, unsigned int vlen, int flags,
+		  struct timespec *timeout);
+
+ssize_t safe_send_zerocopy(const char *file, const int lineno,
+			   char len_strict, int sockfd, const void *buf,
+			   size_t len, int flags);
+
 int safe_bind(const char *file, const int lineno, void (cleanup_fn)(void),
 	      int socket, const struct sockaddr *address,
 	      socklen_t address_len);
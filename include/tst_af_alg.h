@@ -165,4 +165,43 @@ struct tst_alg_sendmsg_params {
 void tst_alg_sendmsg(int reqfd, const void *data, size_t datalen,
 		     const struct tst_alg_sendmsg_params *params);
 
+/**
+ * Send some data to an AF_ALG request socket without copying it.
+ * @param reqfd An AF_ALG request socket
+ * @param data The data to send
+ * @param datalen The length of data in bytes
+ * @param params Specification of the control data to send
+ *
+ * Like tst_alg_sendmsg(), except the payload is gifted to the socket via
+ * vmsplice() and splice() instead of being copied, so the caller must not
+ * modify the data until the result has been read back.  The control data
+ * is still sent with sendmsg() since it cannot travel through a pipe.
+ *
+ * On failure, tst_brk() is called with TBROK.
+ */
+void tst_alg_sendmsg_splice(int reqfd, const void *data, size_t datalen,
+			    const struct tst_alg_sendmsg_params *params);
+
+/**
+ * Pump a number of identical requests through an AF_ALG request socket.
+ * @param reqfd An AF_ALG request socket
+ * @param data The request payload
+ * @param datalen The length of the payload in bytes
+ * @param nreqs How many requests to process
+ * @param depth How many requests to keep submitted ahead of the reads
+ * @param zerocopy Submit via tst_alg_sendmsg_splice() instead of
+ *	tst_alg_sendmsg()
+ * @param params Specification of the control data to send
+ *
+ * Keeps up to depth requests in flight so that submission and processing
+ * overlap, which is what it takes to saturate hardware offload engines.
+ * The results are read back and discarded; use plain tst_alg_sendmsg()
+ * and read() when the output matters.
+ *
+ * On failure, tst_brk() is called with TBROK.
+ */
+void tst_alg_pipeline(int reqfd, const void *data, size_t datalen,
+		      unsigned int nreqs, unsigned int depth, bool zerocopy,
+		      const struct tst_alg_sendmsg_params *params);
+
 #endif /* TST_AF_ALG_H */
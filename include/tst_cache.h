@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#ifndef TST_CACHE_H__
+#define TST_CACHE_H__
+
+#include <stddef.h>
+
+/*
+ * Run-scoped host capability cache.
+ *
+ * Host properties that cannot change within a boot (virtualization type,
+ * lockdown state, driver availability, ...) may be probed once and shared
+ * between all tests of a run through a cache directory pointed to by the
+ * LTP_CACHE_DIR environment variable, which is exported by runltp. Entries
+ * are keyed by the kernel boot id so that a stale directory is never
+ * trusted.
+ *
+ * The cache is best-effort, any error as well as an unset LTP_CACHE_DIR is
+ * reported as a cache miss and the caller falls back to probing the host.
+ */
+
+/*
+ * Looks up key in the cache, on a hit copies the value into buf and
+ * returns 0, returns -1 on a miss.
+ */
+int tst_cache_get(const char *key, char *buf, size_t buf_len);
+
+/*
+ * Stores value under key, overwriting any previous value. The store is
+ * atomic so that concurrently running tests see either the old or the new
+ * value. Returns 0 on success and -1 when the value couldn't be stored.
+ */
+int tst_cache_put(const char *key, const char *value);
+
+/*
+ * Same as above for integer values.
+ */
+int tst_cache_get_int(const char *key, int *val);
+int tst_cache_put_int(const char *key, int val);
+
+/*
+ * Fills in the path of the cache file for key, for values too large to pass
+ * through tst_cache_get()/tst_cache_put(). The file does not have to exist,
+ * callers populating it must write a temporary file first and rename() it
+ * into place. Returns -1 when the cache is not available.
+ */
+int tst_cache_file_path(const char *key, char *path, size_t path_len);
+
+#endif /* TST_CACHE_H__ */
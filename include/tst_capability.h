@@ -51,6 +51,10 @@ int tst_capget(struct tst_cap_user_header *hdr,
  *
  * Note that the memory pointed to by data should be large enough to store two
  * structs.
+ *
+ * The library keeps a cached copy of the current thread's capability state
+ * which this function updates, so capability changes should go through here
+ * rather than through a raw capset() call.
  */
 int tst_capset(struct tst_cap_user_header *hdr,
 	       const struct tst_cap_user_data *data);
@@ -75,8 +79,9 @@ void tst_cap_action(struct tst_cap *cap);
  *
  * Takes a NULL terminated array of structs which describe whether some
  * capabilities are needed or not and mask that determines subset of the
- * actions to be performed. Loops over the array and if mask matches the
- * element action it's passed to tst_cap_action().
+ * actions to be performed. All matching actions are composed into a single
+ * capability state, so the whole list is applied with one capset() call no
+ * matter how many entries it has.
  */
 void tst_cap_setup(struct tst_cap *cap, unsigned int action_mask);
 
@@ -13,4 +13,18 @@
  */
 uint32_t tst_crc32c(uint8_t *buf, size_t buf_len);
 
+/*
+ * Incremental interface for data too large for one buffer: seed crc
+ * with TST_CRC32C_INIT, feed the chunks to tst_crc32c_update() and
+ * finalize with tst_crc32c_final().
+ */
+#define TST_CRC32C_INIT 0xffffffff
+
+uint32_t tst_crc32c_update(uint32_t crc, uint8_t *buf, size_t buf_len);
+
+static inline uint32_t tst_crc32c_final(uint32_t crc)
+{
+	return ~crc;
+}
+
 #endif
@@ -13,6 +13,16 @@ int tst_clock_getres(clockid_t clk_id, struct timespec *res);
 
 int tst_clock_gettime(clockid_t clk_id, struct timespec *ts);
 
+/*
+ * Same as tst_clock_gettime() but dispatches through the vDSO when the
+ * test is linked against libltpvdso, which avoids the syscall overhead
+ * when timestamping measurements. Falls back to tst_clock_gettime()
+ * when the vDSO or the clock id is not available, so it is always safe
+ * to call. See lib/tst_clocks.c for the Makefile bits needed to get
+ * the fast path.
+ */
+int tst_clock_gettime_fast(clockid_t clk_id, struct timespec *ts);
+
 int tst_clock_settime(clockid_t clk_id, struct timespec *ts);
 
 /*
@@ -14,6 +14,8 @@ int ltp_clone_alloc(unsigned long clone_flags, int (*fn)(void *arg),
 		void *arg, size_t stacksize);
 int ltp_clone_quick(unsigned long clone_flags, int (*fn)(void *arg),
 		void *arg);
+int ltp_spawn_batch(unsigned long clone_flags, int (*fn)(void *arg),
+		void *arg, unsigned int nspawns, unsigned int max_parallel);
 void *ltp_alloc_stack(size_t size);
 
 #define clone(...) (use_the_ltp_clone_functions__do_not_use_clone)
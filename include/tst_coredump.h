@@ -6,6 +6,8 @@
 #ifndef TST_COREDUMP__
 #define TST_COREDUMP__
 
+#include <signal.h>
+
 /*
  * If crash is expected, avoid dumping corefile.
  * 1 is a special value, that disables core-to-pipe.
@@ -14,5 +16,32 @@
  */
 void tst_no_corefile(int verbose);
 
+/*
+ * Redirects core dumps to "core-%p" in the test's working directory
+ * (lift RLIMIT_CORE, point core_pattern there) and starts an inotify
+ * watch on it, so tst_wait_coredump() can detect a finished dump the
+ * instant the kernel closes the file. Call from setup(); the caller
+ * must have a tmpdir and list /proc/sys/kernel/core_pattern in
+ * .save_restore.
+ */
+void tst_enable_coredumps(void);
+
+/*
+ * Waits for the kernel to finish writing the core of pid, using the
+ * IN_CLOSE_WRITE event from the watch set up by tst_enable_coredumps()
+ * instead of polling the directory. Fills in the dump's path and
+ * returns 0; a missing dump within timeout_ms ends the test with
+ * TBROK.
+ */
+int tst_wait_coredump(pid_t pid, char *path, size_t path_size,
+		      int timeout_ms);
+
+/*
+ * Reaps a child that is expected to crash through a pidfd, which is
+ * immune to PID reuse, and fills in its exit siginfo; si_code is
+ * CLD_DUMPED when a core was written.
+ */
+void tst_reap_crasher(pid_t pid, siginfo_t *info);
+
 #endif /* TST_COREDUMP_H */
 
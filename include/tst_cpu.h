@@ -9,6 +9,32 @@ long tst_ncpus(void);
 long tst_ncpus_conf(void);
 long tst_ncpus_max(void);
 
+struct tst_cpu_info {
+	int id;
+	int core_id;
+	int package_id;
+};
+
+/*
+ * Returns the number of CPUs the test can run on, i.e. online CPUs
+ * intersected with the affinity mask (which reflects any cpuset the test
+ * was placed in), and optionally a pointer to their topology records.
+ * The topology is parsed from sysfs once and cached; on kernels without
+ * the topology directory each CPU is reported as its own core/package.
+ *
+ * Returns -1 when the topology cannot be determined at all.
+ */
+int tst_cpu_topology(const struct tst_cpu_info **cpus);
+
+/*
+ * Picks two usable CPUs that do not share a physical core, for tests
+ * where SMT siblings would disturb timing measurements. Returns 0 on
+ * success and -1 when no such pair exists (single core or fully
+ * restricted affinity), in which case the caller decides whether that
+ * is a TCONF or just a noisier run.
+ */
+int tst_cpu_pick_isolated_pair(int *cpu_a, int *cpu_b);
+
 #define VIRT_ANY	0	/* catch-all argument for tst_is_virt() */
 #define VIRT_XEN	1	/* xen dom0/domU */
 #define VIRT_KVM	2	/* only default virtual CPU */
@@ -12,6 +12,8 @@
 #ifndef TST_CRYPTO_H
 #define TST_CRYPTO_H
 
+#include <stdbool.h>
+
 #include "lapi/cryptouser.h"
 
 /**
@@ -30,6 +32,8 @@
  * Use TST_CRYPTO_SESSION_INIT to statically initialize this struct with sane
  * defaults.
  */
+struct tst_netlink_batch;
+
 struct tst_crypto_session {
 	/** File descriptor for the netlink socket */
 	int fd;
@@ -37,6 +41,8 @@ struct tst_crypto_session {
 	uint32_t seq_num;
 	/** Number of times some operations will be retried. */
 	uint32_t retries;
+	/** Batch in progress, see tst_crypto_batch_begin(). */
+	struct tst_netlink_batch *batch;
 };
 
 /**
@@ -47,7 +53,8 @@ struct tst_crypto_session {
 #define TST_CRYPTO_SESSION_INIT {\
 	.fd = 0,                 \
 	.seq_num = 0,            \
-	.retries = 1000          \
+	.retries = 1000,         \
+	.batch = 0               \
 }
 
 /**
@@ -109,4 +116,80 @@ int tst_crypto_add_alg(struct tst_crypto_session *ses,
 int tst_crypto_del_alg(struct tst_crypto_session *ses,
 		       const struct crypto_user_alg *alg);
 
+/**
+ * Start queueing add/del operations instead of executing them.
+ *
+ * @relates tst_crypto_session
+ * @param ses An open session.
+ *
+ * Each tst_crypto_add_alg()/tst_crypto_del_alg() call is one synchronous
+ * kernel round-trip, which serializes tests sweeping over many algorithms.
+ * Between tst_crypto_batch_begin() and tst_crypto_batch_commit() any number
+ * of operations can be queued with the _queued variants below; the commit
+ * pushes them to the kernel in a single sendmsg() and collects all the
+ * acknowledgements in one receive sweep.
+ */
+void tst_crypto_batch_begin(struct tst_crypto_session *ses);
+
+/**
+ * Queue an algorithm addition in the current batch.
+ *
+ * @relates tst_crypto_session
+ * @param ses A session with a batch in progress.
+ * @param alg The crypto algorithm or module to add.
+ *
+ * The request is only submitted by tst_crypto_batch_commit().
+ */
+void tst_crypto_add_alg_queued(struct tst_crypto_session *ses,
+			       const struct crypto_user_alg *alg);
+
+/**
+ * Queue an algorithm deletion in the current batch.
+ *
+ * @relates tst_crypto_session
+ * @param ses A session with a batch in progress.
+ * @param alg The crypto algorithm to delete.
+ *
+ * Unlike tst_crypto_del_alg() there is no automatic EBUSY retry, a busy
+ * algorithm makes the commit return -EBUSY and the caller decides whether
+ * to queue the deletion again.
+ */
+void tst_crypto_del_alg_queued(struct tst_crypto_session *ses,
+			       const struct crypto_user_alg *alg);
+
+/**
+ * Submit all queued operations and reap their acknowledgements.
+ *
+ * @relates tst_crypto_session
+ * @param ses A session with a batch in progress.
+ *
+ * @return Zero when every queued operation succeeded, otherwise the
+ *         inverted error code of the first failed one.
+ */
+int tst_crypto_batch_commit(struct tst_crypto_session *ses);
+
+/**
+ * Check whether an algorithm is known to the kernel.
+ *
+ * @relates tst_crypto_session
+ * @param ses An open session.
+ * @param driver_name Driver name (or algorithm name) to look for.
+ *
+ * The algorithm list is dumped from the kernel once and cached for the
+ * lifetime of the process, so sweeping over hundreds of algorithms costs a
+ * single netlink dump instead of one round-trip each. Algorithms registered
+ * after the first call are not visible until the snapshot is dropped with
+ * tst_crypto_alg_snapshot_drop().
+ *
+ * @return True when the algorithm is in the snapshot.
+ */
+bool tst_crypto_alg_exists(struct tst_crypto_session *ses,
+			   const char *driver_name);
+
+/**
+ * Drop the cached algorithm-list snapshot, forcing a fresh dump on the
+ * next tst_crypto_alg_exists() call.
+ */
+void tst_crypto_alg_snapshot_drop(void);
+
 #endif	/* TST_CRYPTO_H */
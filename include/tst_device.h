@@ -24,6 +24,15 @@ extern struct tst_device *tst_device;
  */
 int tst_umount(const char *path);
 
+/*
+ * Lazy variant of tst_umount() using MNT_DETACH, which returns without
+ * waiting for the superblock sync and never blocks on transient opens.
+ * Only suitable when nothing will reuse the underlying device before
+ * reformatting it, as the all_filesystems cycle does.
+ * @path: Path to umount
+ */
+int tst_umount_detach(const char *path);
+
 /*
  * Verifies if an earlier mount is successful or not.
  * @path: Mount path to verify
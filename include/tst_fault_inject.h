@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Native kernel fault-injection sweeps.
+ *
+ * When the LTP_FAULT_PROBABILITY environment variable is set to a percentage
+ * the library iterates the test once per fault-injection site (failslab,
+ * fail_page_alloc, fail_make_request, fail_io_timeout - whichever of them
+ * the running kernel exposes under /sys/kernel/debug), enabling one site at
+ * a time at the requested probability. The debugfs control files are opened
+ * once upfront and each iteration just rewrites probability values through
+ * the pre-opened fds, so a sweep runs at the speed of the test itself
+ * rather than of the old cmdfile-rewriting awk pipeline which paid the
+ * full test startup for every fault site and loop.
+ *
+ * LTP_FAULT_LOOPS (default 1) reruns the test that many times under each
+ * site, which is what LOOPS did in the awk pipeline.
+ *
+ * All functions are called automatically by the library, tests do not use
+ * them directly.
+ */
+
+#ifndef TST_FAULT_INJECT_H__
+#define TST_FAULT_INJECT_H__
+
+/*
+ * Opens the fault-injection control files and returns the number of sweep
+ * configurations, i.e. available sites times LTP_FAULT_LOOPS. Returns 0
+ * when LTP_FAULT_PROBABILITY is unset or no site is available.
+ */
+unsigned int tst_fault_sweep_init(void);
+
+/*
+ * Enables the fault site for the i-th sweep configuration and disables the
+ * others. Safe to call only after a successful tst_fault_sweep_init().
+ */
+void tst_fault_sweep_apply(unsigned int i);
+
+/*
+ * Disables fault injection and restores the control files to their kernel
+ * defaults. Safe to call when the sweep is disabled.
+ */
+void tst_fault_sweep_stop(void);
+
+#endif	/* TST_FAULT_INJECT_H__ */
@@ -190,6 +190,20 @@ void tst_fill_fs(const char *path, int verbose);
  */
 int tst_fibmap(const char *filename);
 
+/*
+ * Returns how many bytes of the file range [offset, offset + len) are
+ * resident in the page cache, or -1 on error. The range is checked
+ * with a single large-vector mincore() call over a transient PROT_NONE
+ * mapping, so the cost is one syscall even for multi-GB files; offset
+ * must be page aligned and the file has to be mappable.
+ */
+long long tst_pagecache_resident_bytes(int fd, off_t offset, size_t len);
+
+/*
+ * As tst_pagecache_resident_bytes() for a whole file given by path.
+ */
+long long tst_pagecache_resident_file(const char *path);
+
 #ifdef TST_TEST_H__
 static inline long tst_fs_type(const char *path)
 {
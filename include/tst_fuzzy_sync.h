@@ -62,6 +62,7 @@
 #include <sys/time.h>
 #include <time.h>
 #include <math.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include "tst_atomic.h"
@@ -74,6 +75,26 @@
 /* how much of exec time is sampling allowed to take */
 #define SAMPLING_SLICE 0.5f
 
+/**
+ * Relax the CPU in a spin loop
+ *
+ * Tells the core we are busy waiting, so that it stops speculating loads
+ * of the contended counter and hands pipeline resources to the SMT
+ * sibling. Where no suitable instruction exists this is just a compiler
+ * barrier, which also stops the spin loops below from being optimised
+ * out.
+ */
+static inline void tst_fzsync_cpu_relax(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__("rep; nop" ::: "memory");
+#elif defined(__aarch64__)
+	__asm__ __volatile__("isb" ::: "memory");
+#else
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
 /** Some statistics for a variable */
 struct tst_fzsync_stat {
 	float avg;
@@ -120,6 +141,12 @@ struct tst_fzsync_pair {
 	/** Internal; Number of spins while waiting for the slower thread */
 	int spins;
 	struct tst_fzsync_stat spins_avg;
+	/** Internal; Distribution of the delays actually applied */
+	struct tst_fzsync_stat delay_stat;
+	/** Internal; Loops where the two race windows overlapped in time */
+	int overlap_loops;
+	/** Internal; Smallest |start_a - start_b| gap observed, in ns */
+	float min_ss_ns;
 	/**
 	 * Internal; Number of spins to use in the delay.
 	 *
@@ -209,6 +236,8 @@ static void tst_fzsync_pair_init(struct tst_fzsync_pair *pair)
 }
 #undef CHK
 
+static void tst_fzsync_pair_telemetry(struct tst_fzsync_pair *pair);
+
 /**
  * Exit and join thread B if necessary.
  *
@@ -228,6 +257,8 @@ static void tst_fzsync_pair_cleanup(struct tst_fzsync_pair *pair)
 		SAFE_PTHREAD_JOIN(pair->thread_b, NULL);
 		pair->thread_b = 0;
 	}
+
+	tst_fzsync_pair_telemetry(pair);
 }
 
 /** To store the run_b pointer and pass to tst_fzsync_thread_wrapper */
@@ -288,6 +319,9 @@ static void tst_fzsync_pair_reset(struct tst_fzsync_pair *pair,
 	tst_init_stat(&pair->diff_sb);
 	tst_init_stat(&pair->diff_ab);
 	tst_init_stat(&pair->spins_avg);
+	tst_init_stat(&pair->delay_stat);
+	pair->overlap_loops = 0;
+	pair->min_ss_ns = -1;
 	pair->delay = 0;
 	pair->sampling = pair->min_samples;
 
@@ -336,6 +370,38 @@ static void tst_fzsync_pair_info(struct tst_fzsync_pair *pair)
 	tst_fzsync_stat_info(pair->spins_avg, "  ", "spins");
 }
 
+/**
+ * Print the convergence telemetry collected over one run
+ *
+ * @relates tst_fzsync_pair
+ *
+ * Emitted automatically when the pair is cleaned up, either because the
+ * loop bounds were hit or because the test broke out early (e.g. on
+ * reproduction). A plain pass/fail verdict does not show how close the
+ * run came to the race; the overlap ratio and attempt rate do, so spin
+ * budgets can be tuned per platform and negative results judged.
+ */
+static void tst_fzsync_pair_telemetry(struct tst_fzsync_pair *pair)
+{
+	float elapsed = pair->exec_time_start - (float)tst_timeout_remaining();
+	int loops = pair->exec_loop;
+
+	if (loops <= 0)
+		return;
+
+	tst_res(TINFO, "fzsync: %d race attempts in %.0fs (%.0f attempts/s)",
+		loops, elapsed, elapsed > 0 ? loops / elapsed : 0);
+	tst_res(TINFO,
+		"fzsync: race windows overlapped in %d of %d loops (%.1f%%), closest start gap %.0fns",
+		pair->overlap_loops, loops,
+		100.0 * pair->overlap_loops / loops,
+		pair->min_ss_ns < 0 ? 0 : pair->min_ss_ns);
+	tst_fzsync_stat_info(pair->delay_stat, "  ", "applied delay");
+
+	/* guard against double reporting from repeated cleanup calls */
+	pair->exec_loop = 0;
+}
+
 /** Wraps clock_gettime */
 static inline void tst_fzsync_time(struct timespec *t)
 {
@@ -485,6 +551,25 @@ static void tst_fzsync_pair_update(struct tst_fzsync_pair *pair)
 	float max_dev = pair->max_dev_ratio;
 	int over_max_dev;
 
+	/*
+	 * Telemetry over the previous loop's timestamps: whether the two
+	 * race windows overlapped at all, how close the window starts
+	 * came and which delay got us there.
+	 */
+	if (pair->exec_loop > 1) {
+		float ss = fabsf((float)tst_timespec_diff_ns(pair->a_start,
+							     pair->b_start));
+
+		if (pair->min_ss_ns < 0 || ss < pair->min_ss_ns)
+			pair->min_ss_ns = ss;
+
+		if (tst_timespec_diff_ns(pair->a_end, pair->b_start) > 0 &&
+		    tst_timespec_diff_ns(pair->b_end, pair->a_start) > 0)
+			pair->overlap_loops++;
+
+		tst_upd_stat(&pair->delay_stat, alpha, pair->delay);
+	}
+
 	pair->delay = pair->delay_bias;
 
 	over_max_dev = pair->diff_ss.dev_ratio > max_dev
@@ -539,6 +624,8 @@ static void tst_fzsync_pair_update(struct tst_fzsync_pair *pair)
  * @param our_cntr The counter for the thread we are on
  * @param other_cntr The counter for the thread we are synchronising with
  * @param spins A pointer to the spin counter or NULL
+ * @param yield_after Spin count after which to back off with sched_yield()
+ *        or zero to spin indefinitely
  *
  * Used by tst_fzsync_pair_wait_a(), tst_fzsync_pair_wait_b(),
  * tst_fzsync_start_race_a(), etc. If the calling thread is ahead of the other
@@ -550,8 +637,11 @@ static void tst_fzsync_pair_update(struct tst_fzsync_pair *pair)
  */
 static inline void tst_fzsync_pair_wait(int *our_cntr,
 					int *other_cntr,
-					int *spins)
+					int *spins,
+					int yield_after)
 {
+	int waited = 0;
+
 	if (tst_atomic_inc(other_cntr) == INT_MAX) {
 		/*
 		 * We are about to break the invariant that the thread with
@@ -564,6 +654,10 @@ static inline void tst_fzsync_pair_wait(int *our_cntr,
 		       && tst_atomic_load(our_cntr) < INT_MAX) {
 			if (spins)
 				(*spins)++;
+			if (yield_after && ++waited > yield_after)
+				sched_yield();
+			else
+				tst_fzsync_cpu_relax();
 		}
 
 		tst_atomic_store(0, other_cntr);
@@ -572,7 +666,7 @@ static inline void tst_fzsync_pair_wait(int *our_cntr,
 		 * is restored and we can continue.
 		 */
 		while (tst_atomic_load(our_cntr) > 1)
-			;
+			tst_fzsync_cpu_relax();
 	} else {
 		/*
 		 * If our counter is less than the other thread's we are ahead
@@ -581,10 +675,29 @@ static inline void tst_fzsync_pair_wait(int *our_cntr,
 		while (tst_atomic_load(our_cntr) < tst_atomic_load(other_cntr)) {
 			if (spins)
 				(*spins)++;
+			if (yield_after && ++waited > yield_after)
+				sched_yield();
+			else
+				tst_fzsync_cpu_relax();
 		}
 	}
 }
 
+/**
+ * Spin count after which a waiting thread should back off
+ *
+ * @relates tst_fzsync_pair
+ *
+ * Waiting for much longer than the average wait means the other thread has
+ * most likely been preempted, so spinning on only keeps it off the
+ * CPU. The floor covers the sampling phase before the average has
+ * converged.
+ */
+static inline int tst_fzsync_yield_after(struct tst_fzsync_pair *pair)
+{
+	return MAX(100000, (int)(16 * pair->spins_avg.avg));
+}
+
 /**
  * Wait in thread A
  *
@@ -593,7 +706,8 @@ static inline void tst_fzsync_pair_wait(int *our_cntr,
  */
 static inline void tst_fzsync_wait_a(struct tst_fzsync_pair *pair)
 {
-	tst_fzsync_pair_wait(&pair->a_cntr, &pair->b_cntr, NULL);
+	tst_fzsync_pair_wait(&pair->a_cntr, &pair->b_cntr, NULL,
+			     tst_fzsync_yield_after(pair));
 }
 
 /**
@@ -604,7 +718,8 @@ static inline void tst_fzsync_wait_a(struct tst_fzsync_pair *pair)
  */
 static inline void tst_fzsync_wait_b(struct tst_fzsync_pair *pair)
 {
-	tst_fzsync_pair_wait(&pair->b_cntr, &pair->a_cntr, NULL);
+	tst_fzsync_pair_wait(&pair->b_cntr, &pair->a_cntr, NULL,
+			     tst_fzsync_yield_after(pair));
 }
 
 /**
@@ -694,8 +809,15 @@ static inline void tst_fzsync_start_race_a(struct tst_fzsync_pair *pair)
 	tst_fzsync_wait_a(pair);
 
 	delay = pair->delay;
-	while (delay < 0)
+	/*
+	 * Include the same CPU relax as the wait loops the delay was
+	 * calibrated against, so one delay spin costs about as much as
+	 * one counted wait spin.
+	 */
+	while (delay < 0) {
 		delay++;
+		tst_fzsync_cpu_relax();
+	}
 
 	tst_fzsync_time(&pair->a_start);
 }
@@ -709,7 +831,8 @@ static inline void tst_fzsync_start_race_a(struct tst_fzsync_pair *pair)
 static inline void tst_fzsync_end_race_a(struct tst_fzsync_pair *pair)
 {
 	tst_fzsync_time(&pair->a_end);
-	tst_fzsync_pair_wait(&pair->a_cntr, &pair->b_cntr, &pair->spins);
+	tst_fzsync_pair_wait(&pair->a_cntr, &pair->b_cntr, &pair->spins,
+			     tst_fzsync_yield_after(pair));
 }
 
 /**
@@ -725,8 +848,10 @@ static inline void tst_fzsync_start_race_b(struct tst_fzsync_pair *pair)
 	tst_fzsync_wait_b(pair);
 
 	delay = pair->delay;
-	while (delay > 0)
+	while (delay > 0) {
 		delay--;
+		tst_fzsync_cpu_relax();
+	}
 
 	tst_fzsync_time(&pair->b_start);
 }
@@ -740,7 +865,8 @@ static inline void tst_fzsync_start_race_b(struct tst_fzsync_pair *pair)
 static inline void tst_fzsync_end_race_b(struct tst_fzsync_pair *pair)
 {
 	tst_fzsync_time(&pair->b_end);
-	tst_fzsync_pair_wait(&pair->b_cntr, &pair->a_cntr, &pair->spins);
+	tst_fzsync_pair_wait(&pair->b_cntr, &pair->a_cntr, &pair->spins,
+			     tst_fzsync_yield_after(pair));
 }
 
 /**
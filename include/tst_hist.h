@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * High-dynamic-range histogram for latency measurements.
+ *
+ * Each power of two is split into 2^bits sub-buckets, so the bucket
+ * width grows with the magnitude and the relative resolution stays at
+ * about 2^-bits over the whole range. The first two octaves are stored
+ * with width one since they cannot be subdivided further.
+ *
+ * The samples are dimensionless, tests usually feed in microseconds.
+ */
+
+#ifndef TST_HIST_H__
+#define TST_HIST_H__
+
+#define TST_HIST_DEFAULT_BITS 7
+
+struct tst_hist {
+	unsigned int bits;
+	unsigned int nbuckets;
+	unsigned int nsamples;
+	unsigned int *buckets;
+};
+
+/*
+ * Allocates the buckets, 2^bits sub-buckets per power of two.
+ */
+void tst_hist_init(struct tst_hist *hist, unsigned int bits);
+
+/*
+ * Zeroes the buckets so that the histogram can be reused.
+ */
+void tst_hist_reset(struct tst_hist *hist);
+
+void tst_hist_free(struct tst_hist *hist);
+
+void tst_hist_add(struct tst_hist *hist, long long sample);
+
+/*
+ * Adds the samples of src into dst; both histograms have to be
+ * initialized with the same number of bits. Useful when each worker
+ * fills a private histogram and the results are combined afterwards.
+ */
+void tst_hist_merge(struct tst_hist *dst, const struct tst_hist *src);
+
+/*
+ * Returns the lowest sample value that falls into the bucket.
+ */
+long long tst_hist_bucket_low(struct tst_hist *hist, unsigned int idx);
+
+/*
+ * Returns the p-th percentile of the samples added so far, rounded down
+ * to the start of the bucket it fell into.
+ */
+long long tst_hist_percentile(struct tst_hist *hist, float p);
+
+#endif	/* TST_HIST_H__ */
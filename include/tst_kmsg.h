@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Live kernel log capture for test runs.
+ *
+ * When the LTP_KMSG_LOG environment variable names a writable file, the
+ * library opens a non-blocking /dev/kmsg fd before the test starts and
+ * keeps it across the forked test runs. Every record the kernel emits
+ * while the test runs is appended to the file prefixed with the test
+ * name, so kernel messages are attributed to tests as they happen
+ * instead of by correlating timestamps with the full dmesg buffer
+ * afterwards, which misses records once the ring buffer wraps.
+ *
+ * Records that look like kernel problems (WARNING, BUG, Oops, Call
+ * Trace) are additionally reported through tst_res(TWARN) right after
+ * the test run that triggered them.
+ *
+ * Both functions are called automatically by the library, tests do not
+ * use them directly.
+ */
+
+#ifndef TST_KMSG_H__
+#define TST_KMSG_H__
+
+/*
+ * Opens /dev/kmsg and the log file and skips the message backlog.
+ * Does nothing unless LTP_KMSG_LOG is set.
+ */
+void tst_kmsg_init(const char *test_name);
+
+/*
+ * Drains new kernel records to the log file and reports suspicious
+ * ones. Called after each test run; safe to call when capture is
+ * disabled.
+ */
+void tst_kmsg_check(void);
+
+#endif	/* TST_KMSG_H__ */
@@ -0,0 +1,268 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/**
+ * @file tst_lockfree.h
+ *
+ * Small lock-free toolkit for multi-process stress tests.
+ *
+ * All the structures here are plain data and work across fork() when
+ * placed in MAP_SHARED memory (e.g. SAFE_MMAP with MAP_ANONYMOUS or the
+ * guarded buffers), so stress tests can coordinate at millions of
+ * operations per second without serializing on semop() or reinventing
+ * racy counters. Initialize them in the parent before forking.
+ *
+ * The primitives are:
+ *
+ *  - a striped counter where concurrent increments hit per-CPU slots
+ *    and only the reader pays for the aggregation,
+ *
+ *  - a sense-reversing barrier for repeated all-process rendezvous,
+ *
+ *  - a bounded multi-producer multi-consumer queue based on per-slot
+ *    sequence numbers.
+ *
+ * Like tst_atomic.h everything uses __ATOMIC_SEQ_CST for the sake of
+ * simplicity; these are test coordination helpers, not a performance
+ * library.
+ */
+
+#ifndef TST_LOCKFREE_H__
+#define TST_LOCKFREE_H__
+
+#include <sched.h>
+#include <unistd.h>
+#include "tst_atomic.h"
+
+/* present in every libc we run against, but hidden without _GNU_SOURCE */
+#ifndef _GNU_SOURCE
+extern int sched_getcpu(void);
+#endif
+
+#ifndef TST_CACHELINE_SIZE
+# define TST_CACHELINE_SIZE 64
+#endif
+
+/* Spins before a waiter starts yielding the CPU */
+#define TST_LOCKFREE_SPINS 10000
+
+static inline void tst_lockfree_wait(unsigned int *spins)
+{
+	if (++*spins > TST_LOCKFREE_SPINS)
+		sched_yield();
+}
+
+/**
+ * Striped counter
+ *
+ * Increments go to one of the per-CPU stripes, so concurrent writers do
+ * not bounce a single cacheline between packages. Reading sums all the
+ * stripes and is approximate while writers are running, which is fine
+ * for progress accounting.
+ */
+#define TST_STRIPED_CNT_SLOTS 64
+
+struct tst_striped_cnt {
+	struct {
+		long long cnt;
+		char pad[TST_CACHELINE_SIZE - sizeof(long long)];
+	} stripe[TST_STRIPED_CNT_SLOTS];
+};
+
+static inline void tst_striped_cnt_add(struct tst_striped_cnt *c, long long v)
+{
+	int cpu = sched_getcpu();
+
+	if (cpu < 0)
+		cpu = getpid();
+
+	__atomic_add_fetch(&c->stripe[cpu % TST_STRIPED_CNT_SLOTS].cnt, v,
+			   __ATOMIC_SEQ_CST);
+}
+
+static inline void tst_striped_cnt_inc(struct tst_striped_cnt *c)
+{
+	tst_striped_cnt_add(c, 1);
+}
+
+static inline long long tst_striped_cnt_read(struct tst_striped_cnt *c)
+{
+	long long sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < TST_STRIPED_CNT_SLOTS; i++)
+		sum += __atomic_load_n(&c->stripe[i].cnt, __ATOMIC_SEQ_CST);
+
+	return sum;
+}
+
+/**
+ * Sense-reversing barrier
+ *
+ * Unlike the checkpoint rendezvous this does not enter the kernel at
+ * all when the processes arrive close together, which is the common
+ * case in a tight stress loop. Each process keeps its own sense flag,
+ * the last arrival flips the shared one and releases everybody.
+ */
+struct tst_sr_barrier {
+	int nproc;
+	int count;
+	int sense;
+};
+
+static inline void tst_sr_barrier_init(struct tst_sr_barrier *b, int nproc)
+{
+	b->nproc = nproc;
+	b->count = 0;
+	b->sense = 0;
+}
+
+/**
+ * @param b The shared barrier
+ * @param local_sense Per-process sense, zero initialized, owned by the caller
+ */
+static inline void tst_sr_barrier_wait(struct tst_sr_barrier *b,
+				       int *local_sense)
+{
+	int sense = !*local_sense;
+	unsigned int spins = 0;
+
+	*local_sense = sense;
+
+	if (tst_atomic_inc(&b->count) == b->nproc) {
+		b->count = 0;
+		tst_atomic_store(sense, &b->sense);
+	} else {
+		while (tst_atomic_load(&b->sense) != sense)
+			tst_lockfree_wait(&spins);
+	}
+}
+
+/**
+ * Bounded MPMC queue
+ *
+ * Any number of producers and consumers, no locks, no syscalls unless a
+ * side has to wait. Each slot carries a sequence number that encodes
+ * whether it is free or full for the current lap, so producers and
+ * consumers only compete with their own kind on a single counter.
+ *
+ * The queue stores ints (pids, fds, indexes into a shared array); the
+ * capacity must be a power of two. Use the TST_MPMC_QUEUE_SIZE() macro
+ * to size the shared mapping.
+ */
+struct tst_mpmc_queue {
+	unsigned int mask;
+	char pad0[TST_CACHELINE_SIZE - sizeof(unsigned int)];
+	unsigned int head;
+	char pad1[TST_CACHELINE_SIZE - sizeof(unsigned int)];
+	unsigned int tail;
+	char pad2[TST_CACHELINE_SIZE - sizeof(unsigned int)];
+	struct {
+		unsigned int seq;
+		int val;
+	} slot[];
+};
+
+#define TST_MPMC_QUEUE_SIZE(capacity) \
+	(sizeof(struct tst_mpmc_queue) + \
+	 (capacity) * sizeof(((struct tst_mpmc_queue *)0)->slot[0]))
+
+static inline void tst_mpmc_queue_init(struct tst_mpmc_queue *q,
+				       unsigned int capacity)
+{
+	unsigned int i;
+
+	q->mask = capacity - 1;
+	q->head = 0;
+	q->tail = 0;
+
+	for (i = 0; i < capacity; i++) {
+		q->slot[i].seq = i;
+		q->slot[i].val = 0;
+	}
+}
+
+/**
+ * Tries to enqueue val, returns zero on success and -1 when full.
+ */
+static inline int tst_mpmc_queue_try_push(struct tst_mpmc_queue *q, int val)
+{
+	unsigned int pos, seq;
+
+	for (;;) {
+		pos = __atomic_load_n(&q->tail, __ATOMIC_SEQ_CST);
+		seq = __atomic_load_n(&q->slot[pos & q->mask].seq,
+				      __ATOMIC_SEQ_CST);
+
+		if (seq == pos) {
+			if (__atomic_compare_exchange_n(&q->tail, &pos,
+					pos + 1, 0, __ATOMIC_SEQ_CST,
+					__ATOMIC_SEQ_CST))
+				break;
+		} else if ((int)(seq - pos) < 0) {
+			return -1;
+		}
+		/* Lost the race to another producer, retry */
+	}
+
+	q->slot[pos & q->mask].val = val;
+	__atomic_store_n(&q->slot[pos & q->mask].seq, pos + 1,
+			 __ATOMIC_SEQ_CST);
+
+	return 0;
+}
+
+/**
+ * Tries to dequeue, returns zero on success and -1 when empty.
+ */
+static inline int tst_mpmc_queue_try_pop(struct tst_mpmc_queue *q, int *val)
+{
+	unsigned int pos, seq;
+
+	for (;;) {
+		pos = __atomic_load_n(&q->head, __ATOMIC_SEQ_CST);
+		seq = __atomic_load_n(&q->slot[pos & q->mask].seq,
+				      __ATOMIC_SEQ_CST);
+
+		if ((int)(seq - (pos + 1)) == 0) {
+			if (__atomic_compare_exchange_n(&q->head, &pos,
+					pos + 1, 0, __ATOMIC_SEQ_CST,
+					__ATOMIC_SEQ_CST))
+				break;
+		} else if ((int)(seq - (pos + 1)) < 0) {
+			return -1;
+		}
+		/* Lost the race to another consumer, retry */
+	}
+
+	*val = q->slot[pos & q->mask].val;
+	__atomic_store_n(&q->slot[pos & q->mask].seq, pos + q->mask + 1,
+			 __ATOMIC_SEQ_CST);
+
+	return 0;
+}
+
+/**
+ * Blocking variants, spin then yield while the queue is full/empty.
+ */
+static inline void tst_mpmc_queue_push(struct tst_mpmc_queue *q, int val)
+{
+	unsigned int spins = 0;
+
+	while (tst_mpmc_queue_try_push(q, val))
+		tst_lockfree_wait(&spins);
+}
+
+static inline int tst_mpmc_queue_pop(struct tst_mpmc_queue *q)
+{
+	unsigned int spins = 0;
+	int val;
+
+	while (tst_mpmc_queue_try_pop(q, &val))
+		tst_lockfree_wait(&spins);
+
+	return val;
+}
+
+#endif	/* TST_LOCKFREE_H__ */
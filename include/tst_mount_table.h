@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Internal per-process snapshot of /proc/self/mountinfo, serving the
+ * mount-table queries (tst_fs_type(), tst_path_has_mnt_flags()) from
+ * memory instead of re-parsing proc on every call. The snapshot is
+ * invalidated by an epoch counter that the mount/umount wrappers bump.
+ * Do not use directly in test programs.
+ */
+
+#ifndef TST_MOUNT_TABLE_H__
+#define TST_MOUNT_TABLE_H__
+
+struct tst_mntent {
+	char *dir;		/* mount point */
+	size_t dir_len;
+	char *fs_type;		/* filesystem type string */
+	char *opts;		/* per-mount and superblock options */
+	long f_type;		/* statfs magic, cached lazily; -1 unknown */
+};
+
+/*
+ * Invalidates the snapshot; called from the mount/umount wrappers.
+ * Mounts done behind the wrappers' back are not noticed.
+ */
+void tst_mount_epoch_bump(void);
+
+/*
+ * Returns the longest-prefix mount entry for path, (re)parsing the
+ * mount table first when the epoch moved. Returns NULL when the mount
+ * table cannot be parsed.
+ */
+struct tst_mntent *tst_mount_table_lookup(const char *path);
+
+/* hasmntopt()-style match of a single option in the entry's options */
+int tst_mntent_has_opt(const struct tst_mntent *mnt, const char *opt);
+
+#endif /* TST_MOUNT_TABLE_H__ */
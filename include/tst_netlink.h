@@ -85,4 +85,66 @@ static inline ssize_t safe_netlink_recv(const char *file, const int lineno,
 #define SAFE_NETLINK_RECV(fd, nl_header_buf, buf_len)			\
 	safe_netlink_recv(__FILE__, __LINE__, fd, nl_header_buf, buf_len)
 
+/**
+ * Context for batching netlink requests.
+ *
+ * Each SAFE_NETLINK_SEND() round-trips to the kernel and waits for the
+ * answer, which serializes tests that issue many small requests (large
+ * virtual topologies being the typical case). A batch context instead
+ * coalesces any number of messages into one buffer, pushes them to the
+ * kernel with a single sendmsg() and then collects all the ACKs in one
+ * sweep.
+ *
+ * The context assigns sequence numbers to the queued messages and forces
+ * NLM_F_ACK so that the sweep knows when it has seen every answer.
+ */
+struct tst_netlink_batch;
+
+/** @private */
+struct tst_netlink_batch *tst_netlink_batch_start(const char *file,
+						  const int lineno, int fd);
+
+/** @private */
+void tst_netlink_batch_add(const char *file, const int lineno,
+			   struct tst_netlink_batch *batch,
+			   struct nlmsghdr *nh, const void *payload);
+
+/** @private */
+int tst_netlink_batch_send(const char *file, const int lineno,
+			   struct tst_netlink_batch *batch);
+
+/** @private */
+void tst_netlink_batch_free(struct tst_netlink_batch *batch);
+
+/**
+ * Creates a batch context for the given netlink socket.
+ */
+#define TST_NETLINK_BATCH_START(fd) \
+	tst_netlink_batch_start(__FILE__, __LINE__, (fd))
+
+/**
+ * Queues one message in the batch. The header's length, type and flags
+ * are set by the caller as for SAFE_NETLINK_SEND(); the sequence number
+ * is filled in by the batch.
+ */
+#define TST_NETLINK_BATCH_ADD(batch, nl_header, payload) \
+	tst_netlink_batch_add(__FILE__, __LINE__, (batch), (nl_header), \
+			      (payload))
+
+/**
+ * Sends all queued messages in one sendmsg() and sweeps up their ACKs.
+ * The batch is empty afterwards and can be reused.
+ *
+ * @return Zero when every message was acked successfully, otherwise the
+ *         (negative) error code of the first failed message.
+ */
+#define TST_NETLINK_BATCH_SEND(batch) \
+	tst_netlink_batch_send(__FILE__, __LINE__, (batch))
+
+/**
+ * Frees the batch context. Queued but unsent messages are discarded.
+ */
+#define TST_NETLINK_BATCH_FREE(batch) \
+	tst_netlink_batch_free(batch)
+
 #endif /* TST_NETLINK_H */
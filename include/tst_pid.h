@@ -13,11 +13,17 @@
 pid_t tst_get_unused_pid_(void (*cleanup_fn)(void));
 
 /*
- * Returns number of free pids by substarction of the number of pids
- * currently used ('ps -eT') from max_pids
+ * Returns number of free pids by substraction of the number of tasks
+ * currently running (from /proc/loadavg) from max_pids
  */
 int tst_get_free_pids_(void (*cleanup_fn)(void));
 
+/*
+ * Drops the cached pid_max value so the next call re-reads the sysctl;
+ * only needed after a test changes /proc/sys/kernel/pid_max itself.
+ */
+void tst_flush_pid_max(void);
+
 #ifdef TST_TEST_H__
 static inline pid_t tst_get_unused_pid(void)
 {
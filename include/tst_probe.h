@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Static tracepoints (USDT) at the harness lifecycle boundaries.
+ *
+ * When <sys/sdt.h> is found at configure time the macros emit probes
+ * under the "ltp" provider, so perf and bpftrace can attribute wall
+ * time to harness phases (setup, tmpdir and device acquisition, the
+ * forked test runs and the individual test iterations) across a whole
+ * run without instrumenting the binaries. A probe that nothing is
+ * attached to costs a single nop; without the header the macros
+ * compile to nothing.
+ *
+ * List the probes of a built test with:
+ *
+ *   readelf -n testcase | grep -A2 stapsdt
+ *
+ * and e.g. time the test runs of a whole runtest file with:
+ *
+ *   bpftrace -e 'usdt:*:ltp:testrun_* { ... }' -p ...
+ *
+ * The macros are internal to the library; tests report timings through
+ * tst_res() instead.
+ */
+
+#ifndef TST_PROBE_H__
+#define TST_PROBE_H__
+
+#include "config.h"
+
+#ifdef HAVE_SYS_SDT_H
+# include <sys/sdt.h>
+# define TST_PROBE(name) DTRACE_PROBE(ltp, name)
+# define TST_PROBE1(name, arg1) DTRACE_PROBE1(ltp, name, arg1)
+# define TST_PROBE2(name, arg1, arg2) DTRACE_PROBE2(ltp, name, arg1, arg2)
+#else
+# define TST_PROBE(name) do { } while (0)
+# define TST_PROBE1(name, arg1) do { } while (0)
+# define TST_PROBE2(name, arg1, arg2) do { } while (0)
+#endif
+
+#endif	/* TST_PROBE_H__ */
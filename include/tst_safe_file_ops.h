@@ -11,6 +11,10 @@
 	safe_file_scanf(__FILE__, __LINE__, NULL, \
 	                (path), (fmt), ## __VA_ARGS__)
 
+#define SAFE_FILE_SCANF_FD(fd, fmt, ...) \
+	safe_file_scanf_fd(__FILE__, __LINE__, NULL, \
+	                   (fd), (fmt), ## __VA_ARGS__)
+
 #define FILE_LINES_SCANF(path, fmt, ...) \
 	file_lines_scanf(__FILE__, __LINE__, NULL, 0,\
 			(path), (fmt), ## __VA_ARGS__)
@@ -33,6 +37,10 @@
 	safe_file_printf(__FILE__, __LINE__, NULL, \
 	                 (path), (fmt), ## __VA_ARGS__)
 
+#define SAFE_FILE_PRINTF_FD(fd, fmt, ...) \
+	safe_file_printf_fd(__FILE__, __LINE__, NULL, \
+	                    (fd), (fmt), ## __VA_ARGS__)
+
 #define SAFE_CP(src, dst) \
 	safe_cp(__FILE__, __LINE__, NULL, (src), (dst))
 
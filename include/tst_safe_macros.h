@@ -17,6 +17,7 @@
 #include <libgen.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <grp.h>
@@ -596,4 +597,32 @@ int safe_sysinfo(const char *file, const int lineno, struct sysinfo *info);
 #define SAFE_SYSINFO(info) \
 	safe_sysinfo(__FILE__, __LINE__, (info))
 
+/*
+ * Raw getdents64() dirent as filled in batches into a caller-supplied
+ * buffer; entries are chained with d_reclen. Directory-heavy tests use
+ * this instead of readdir() to skip the per-entry allocation and
+ * locking inside the stdio dirstream.
+ */
+struct tst_dirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+int safe_getdents64(const char *file, const int lineno, int fd,
+	void *buf, unsigned int size);
+#define SAFE_GETDENTS64(fd, buf, size) \
+	safe_getdents64(__FILE__, __LINE__, (fd), (buf), (size))
+
+/*
+ * Invokes the callback for every entry of the directory at path ("."
+ * and ".." included), reusing one getdents64() buffer for the whole
+ * walk. A non-zero return from the callback stops the walk early and
+ * is passed through as the result.
+ */
+int tst_for_each_dirent(const char *path,
+	int (*fn)(const struct tst_dirent64 *d, void *arg), void *arg);
+
 #endif /* SAFE_MACROS_H__ */
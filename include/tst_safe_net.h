@@ -45,6 +45,15 @@
 #define SAFE_RECVMSG(msg_len, fd, msg, flags)		\
 	safe_recvmsg(__FILE__, __LINE__, msg_len, fd, msg, flags)
 
+#define SAFE_SENDMMSG(fd, msgvec, vlen, flags) \
+	safe_sendmmsg(__FILE__, __LINE__, fd, msgvec, vlen, flags)
+
+#define SAFE_RECVMMSG(fd, msgvec, vlen, flags, timeout) \
+	safe_recvmmsg(__FILE__, __LINE__, fd, msgvec, vlen, flags, timeout)
+
+#define SAFE_SEND_ZEROCOPY(strict, fd, buf, len, flags) \
+	safe_send_zerocopy(__FILE__, __LINE__, strict, fd, buf, len, flags)
+
 #define SAFE_BIND(socket, address, address_len) \
 	safe_bind(__FILE__, __LINE__, NULL, socket, address, \
 		  address_len)
@@ -30,4 +30,37 @@ int safe_pthread_join(const char *file, const int lineno,
 #define SAFE_PTHREAD_JOIN(thread_id, retval) \
 	safe_pthread_join(__FILE__, __LINE__, thread_id, retval)
 
+/*
+ * Pool of pre-spawned worker threads parked on per-worker futexes, for
+ * tests that push thousands of work items and should measure the
+ * kernel rather than pthread_create(). Each worker has its own
+ * cache-line-padded slot, so handing work out does not bounce a shared
+ * queue lock between CPUs.
+ *
+ * Submit and drain must be called from a single thread; submit blocks
+ * when all workers are busy and drain returns once every submitted
+ * item has finished. Destroy drains the pool and joins the workers.
+ */
+struct tst_thread_pool;
+
+struct tst_thread_pool *safe_thread_pool_create(const char *file,
+		const int lineno, unsigned int workers, void (*fn)(void *));
+#define SAFE_THREAD_POOL_CREATE(workers, fn) \
+	safe_thread_pool_create(__FILE__, __LINE__, workers, fn)
+
+void safe_thread_pool_submit(const char *file, const int lineno,
+			     struct tst_thread_pool *pool, void *arg);
+#define SAFE_THREAD_POOL_SUBMIT(pool, arg) \
+	safe_thread_pool_submit(__FILE__, __LINE__, pool, arg)
+
+void safe_thread_pool_drain(const char *file, const int lineno,
+			    struct tst_thread_pool *pool);
+#define SAFE_THREAD_POOL_DRAIN(pool) \
+	safe_thread_pool_drain(__FILE__, __LINE__, pool)
+
+void safe_thread_pool_destroy(const char *file, const int lineno,
+			      struct tst_thread_pool *pool);
+#define SAFE_THREAD_POOL_DESTROY(pool) \
+	safe_thread_pool_destroy(__FILE__, __LINE__, pool)
+
 #endif /* TST_SAFE_PTHREAD_H__ */
@@ -6,7 +6,40 @@
 #define TST_SIG_PROC_H__
 
 #include <sys/types.h>
+#include <stdint.h>
 
 pid_t create_sig_proc(int sig, int count, unsigned int usec);
 
+/*
+ * Per-sender accounting slot, padded to a cache line so that senders
+ * publishing their counters do not contend with each other.
+ */
+struct tst_sig_sender {
+	uint64_t sent;
+	uint64_t failed;
+	pid_t pid;
+} __attribute__((aligned(64)));
+
+struct tst_sig_storm {
+	unsigned int senders;
+	struct tst_sig_sender sender[];
+};
+
+/*
+ * High-rate variant of create_sig_proc(): shards count signals over
+ * senders child processes which deliver them to the caller through
+ * pidfd_send_signal() in tight batches, with no pacing. Accounting
+ * lives in shared memory; compare the sent total against your signal
+ * handler's count to measure coalescing or loss.
+ */
+struct tst_sig_storm *create_sig_storm(int sig, unsigned long long count,
+				       unsigned int senders);
+
+/*
+ * Reaps the senders, sums their counters into sent/failed (either may
+ * be NULL) and frees the accounting block.
+ */
+void wait_sig_storm(struct tst_sig_storm *storm, uint64_t *sent,
+		    uint64_t *failed);
+
 #endif	/* TST_SIG_PROC_H__ */
@@ -138,6 +138,14 @@ struct tst_test {
 
 	int needs_tmpdir:1;
 	int needs_root:1;
+	/*
+	 * If set the temporary directory is backed by a private tmpfs sized
+	 * from dev_min_size (256MB when unset), so that metadata heavy tests
+	 * are not bound by the I/O speed of whatever TMPDIR points to. Can
+	 * be forced on or off for a whole run with LTP_TMPDIR_TMPFS=1/0.
+	 * Falls back to the plain directory when the mount fails.
+	 */
+	int tmpdir_tmpfs:1;
 	int forks_child:1;
 	int needs_device:1;
 	int needs_checkpoints:1;
@@ -148,6 +156,13 @@ struct tst_test {
 	int child_needs_reinit:1;
 	int needs_devfs:1;
 	int restore_wallclock:1;
+	/*
+	 * If set test results are pushed into a lock-free ring buffer in the
+	 * shared memory and written out by a drainer process, which avoids
+	 * serializing concurrent reporters on write(2). Intended for tests
+	 * that produce large amounts of messages from many processes.
+	 */
+	int needs_results_ring:1;
 	/*
 	 * If set the test function will be executed for all available
 	 * filesystems and the current filesytem type would be set in the
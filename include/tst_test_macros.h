@@ -46,6 +46,34 @@ extern void *TST_RET_PTR;
 	tst_res_(__FILE__, __LINE__, RES, \
 		TST_FMT_(TST_2_(dummy, ##__VA_ARGS__, SCALL) FMT, __VA_ARGS__), PAR)
 
+/*
+ * Fast path for the routine TPASS results below. With LTP_QUIET_PASS
+ * set, repeated passes from the same call site skip the formatting and
+ * only bump the pass counter, which removes most of the library CPU
+ * from iterated syscall loops; the first pass from each site is still
+ * printed so the log shows what ran. Failures always format.
+ */
+extern int tst_quiet_pass_;
+void tst_count_pass_(void);
+
+#define TST_MSG_PASS_(RES, FMT, SCALL, ...) \
+	do { \
+		static int tst_printed_; \
+		if (!tst_quiet_pass_ || !tst_printed_++) \
+			TST_MSG_(RES, FMT, SCALL, ##__VA_ARGS__); \
+		else \
+			tst_count_pass_(); \
+	} while (0)
+
+#define TST_MSGP_PASS_(RES, FMT, PAR, SCALL, ...) \
+	do { \
+		static int tst_printed_; \
+		if (!tst_quiet_pass_ || !tst_printed_++) \
+			TST_MSGP_(RES, FMT, PAR, SCALL, ##__VA_ARGS__); \
+		else \
+			tst_count_pass_(); \
+	} while (0)
+
 #define TST_EXP_FD(SCALL, ...)                                                 \
 	do {                                                                   \
 		TEST(SCALL);                                                   \
@@ -64,7 +92,7 @@ extern void *TST_RET_PTR;
 			break;                                                 \
 		}                                                              \
                                                                                \
-		TST_MSGP_(TPASS, " returned fd %ld", TST_RET,                  \
+		TST_MSGP_PASS_(TPASS, " returned fd %ld", TST_RET,            \
 		         #SCALL, ##__VA_ARGS__);                               \
                                                                                \
 		TST_PASS = 1;                                                  \
@@ -89,7 +117,7 @@ extern void *TST_RET_PTR;
 			break;                                                 \
 		}                                                              \
                                                                                \
-		TST_MSG_(TPASS, " passed", #SCALL, ##__VA_ARGS__);             \
+		TST_MSG_PASS_(TPASS, " passed", #SCALL, ##__VA_ARGS__);        \
                                                                                \
 		TST_PASS = 1;                                                  \
                                                                                \
@@ -116,7 +144,7 @@ extern void *TST_RET_PTR;
 		                                                               \
 		if (ERRNO) {                                                   \
 			if (TST_ERR == ERRNO) {                                \
-				TST_MSG_(TPASS | TERRNO, "",                   \
+				TST_MSG_PASS_(TPASS | TERRNO, "",              \
 				         #SCALL, ##__VA_ARGS__);               \
 				TST_PASS = 1;                                  \
 			} else {                                               \
@@ -44,4 +44,46 @@ void setup_mouse_events(int fd);
  */
 void destroy_input_device(int fd);
 
+struct input_event;
+
+/**
+ * Injects a batch of events with a single write().
+ *
+ * One write() per event caps the achievable injection rate well below what
+ * real high-rate devices produce, a whole batch (typically up to and
+ * including an EV_SYN event) is pushed into the device at once instead.
+ *
+ * @fd File descriptor returned by open_uinput().
+ * @events Array of events to inject.
+ * @count Number of events in the array.
+ */
+void send_input_events(int fd, const struct input_event *events,
+		       unsigned int count);
+
+/**
+ * Replays an event stream honoring the event timestamps.
+ *
+ * Events sharing a timestamp are injected as one batch and the gaps
+ * between the timestamps are reproduced by sleeping until the right
+ * offset from the replay start, so a recorded 8kHz event storm arrives
+ * at 8kHz rather than as fast as write() allows.
+ *
+ * @fd File descriptor returned by open_uinput().
+ * @events Array of events to replay, expected in timestamp order.
+ * @count Number of events in the array.
+ */
+void replay_input_events(int fd, const struct input_event *events,
+			 unsigned int count);
+
+/**
+ * Loads a recorded event stream, i.e. raw struct input_event records as
+ * read from an evdev device node.
+ *
+ * @path Path to the recording.
+ * @events Set to a newly allocated array of the loaded events.
+ *
+ * Returns the number of loaded events.
+ */
+unsigned int load_input_events(const char *path, struct input_event **events);
+
 #endif	/* TST_UINPUT_H__ */
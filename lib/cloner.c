@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <sched.h>
 #include <stdarg.h>
+#include <sys/wait.h>
 #include "config.h"
 #include "tst_clone.h"
 
@@ -173,3 +174,101 @@ int ltp_clone_quick(unsigned long clone_flags, int (*fn) (void *arg), void *arg)
 
 	return ltp_clone_alloc(clone_flags, fn, arg, stack_size);
 }
+
+/*
+ * ltp_spawn_batch: spawns 'nspawns' children running fn(arg) with at most
+ * 'max_parallel' alive at a time, reusing a fixed set of preallocated
+ * stacks rather than allocating and freeing one per child. This keeps
+ * spawn-rate stress tests measuring the kernel instead of malloc.
+ *
+ * A stack is handed to the next child only after waitpid() has reaped
+ * its previous user, so reuse is safe. The clone flags must include
+ * SIGCHLD (or another exit signal) and the caller must not have other
+ * unreaped children, since the reaping uses waitpid(-1).
+ *
+ * Returns the number of children spawned (== nspawns) on success.
+ * On error, returns -1 with errno set; already-spawned children are
+ * still reaped.
+ */
+int ltp_spawn_batch(unsigned long clone_flags, int (*fn) (void *arg),
+		    void *arg, unsigned int nspawns, unsigned int max_parallel)
+{
+	size_t stack_size = getpagesize() * 6;
+	void **stacks;
+	pid_t *pids;
+	unsigned int i, slot, inflight = 0, spawned = 0;
+	int saved_errno = 0;
+	pid_t pid;
+
+	if (!max_parallel)
+		max_parallel = 1;
+	if (max_parallel > nspawns)
+		max_parallel = nspawns;
+
+	stacks = calloc(max_parallel, sizeof(*stacks));
+	pids = calloc(max_parallel, sizeof(*pids));
+	if (!stacks || !pids) {
+		saved_errno = ENOMEM;
+		goto free_stacks;
+	}
+
+	for (i = 0; i < max_parallel; i++) {
+		stacks[i] = ltp_alloc_stack(stack_size);
+		if (!stacks[i]) {
+			saved_errno = errno;
+			goto free_stacks;
+		}
+	}
+
+	while (spawned < nspawns || inflight) {
+		if (inflight == max_parallel ||
+		    (spawned == nspawns && inflight)) {
+			pid = waitpid(-1, NULL, 0);
+			if (pid < 0) {
+				if (errno == EINTR)
+					continue;
+				saved_errno = errno;
+				break;
+			}
+
+			for (slot = 0; slot < max_parallel; slot++) {
+				if (pids[slot] == pid) {
+					pids[slot] = 0;
+					inflight--;
+					break;
+				}
+			}
+			continue;
+		}
+
+		for (slot = 0; pids[slot]; slot++);
+
+		pid = ltp_clone(clone_flags, fn, arg, stack_size,
+				stacks[slot]);
+		if (pid < 0) {
+			saved_errno = errno;
+			/* stop spawning, fall through to reap */
+			nspawns = spawned;
+			continue;
+		}
+
+		pids[slot] = pid;
+		inflight++;
+		spawned++;
+	}
+
+free_stacks:
+	if (stacks) {
+		for (i = 0; i < max_parallel; i++)
+			free(stacks[i]);
+	}
+	free(stacks);
+	free(pids);
+
+	if (saved_errno) {
+		errno = saved_errno;
+		return -1;
+	}
+
+	return spawned;
+}
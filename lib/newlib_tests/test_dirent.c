@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Test for SAFE_GETDENTS64() and tst_for_each_dirent().
+ */
+
+#include <stdio.h>
+
+#include "tst_test.h"
+
+#define NFILES 100
+
+struct walk_state {
+	int entries;
+	int stop_after;
+};
+
+static int count_entry(const struct tst_dirent64 *d, void *arg)
+{
+	struct walk_state *st = arg;
+
+	if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
+		return 0;
+
+	st->entries++;
+
+	if (st->stop_after && st->entries >= st->stop_after)
+		return 42;
+
+	return 0;
+}
+
+static void setup(void)
+{
+	char path[32];
+	int i;
+
+	for (i = 0; i < NFILES; i++) {
+		snprintf(path, sizeof(path), "f%03i", i);
+		SAFE_TOUCH(path, 0644, NULL);
+	}
+}
+
+static void run(void)
+{
+	struct walk_state st = {};
+	int ret;
+
+	ret = tst_for_each_dirent(".", count_entry, &st);
+
+	if (ret == 0 && st.entries == NFILES)
+		tst_res(TPASS, "walked all %i entries", st.entries);
+	else
+		tst_res(TFAIL, "ret %i, %i entries, expected %i",
+			ret, st.entries, NFILES);
+
+	st.entries = 0;
+	st.stop_after = NFILES / 2;
+
+	ret = tst_for_each_dirent(".", count_entry, &st);
+
+	if (ret == 42 && st.entries == NFILES / 2)
+		tst_res(TPASS, "early stop after %i entries", st.entries);
+	else
+		tst_res(TFAIL, "ret %i, %i entries, expected stop at %i",
+			ret, st.entries, NFILES / 2);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.needs_tmpdir = 1,
+};
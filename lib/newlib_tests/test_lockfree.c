@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Test for the lock-free toolkit in tst_lockfree.h. A set of producer
+ * processes pushes a known workload through a shared MPMC queue to a
+ * set of consumers which tally what they received in a striped counter,
+ * with a sense-reversing barrier lining everybody up around the run.
+ */
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "tst_test.h"
+#include "tst_lockfree.h"
+
+#define NPRODUCERS 4
+#define NCONSUMERS 4
+#define PER_PRODUCER 100000
+#define QUEUE_CAP 64
+
+static struct tst_striped_cnt *scnt;
+static struct tst_sr_barrier *barrier;
+static struct tst_mpmc_queue *queue;
+
+static void producer(void)
+{
+	int local_sense = 0;
+	int i;
+
+	tst_sr_barrier_wait(barrier, &local_sense);
+
+	for (i = 0; i < PER_PRODUCER; i++)
+		tst_mpmc_queue_push(queue, 1);
+
+	exit(0);
+}
+
+static void consumer(void)
+{
+	int local_sense = 0;
+	int val;
+
+	tst_sr_barrier_wait(barrier, &local_sense);
+
+	for (;;) {
+		val = tst_mpmc_queue_pop(queue);
+
+		if (!val)
+			break;
+
+		tst_striped_cnt_add(scnt, val);
+	}
+
+	exit(0);
+}
+
+static void run(void)
+{
+	int local_sense = 0;
+	long long total;
+	int i;
+
+	tst_sr_barrier_init(barrier, NPRODUCERS + NCONSUMERS + 1);
+	tst_mpmc_queue_init(queue, QUEUE_CAP);
+	memset(scnt, 0, sizeof(*scnt));
+
+	for (i = 0; i < NPRODUCERS; i++) {
+		if (!SAFE_FORK())
+			producer();
+	}
+
+	for (i = 0; i < NCONSUMERS; i++) {
+		if (!SAFE_FORK())
+			consumer();
+	}
+
+	tst_sr_barrier_wait(barrier, &local_sense);
+
+	/* wait for the producers, then feed each consumer a stop mark */
+	for (i = 0; i < NPRODUCERS; i++)
+		SAFE_WAIT(NULL);
+
+	for (i = 0; i < NCONSUMERS; i++)
+		tst_mpmc_queue_push(queue, 0);
+
+	for (i = 0; i < NCONSUMERS; i++)
+		SAFE_WAIT(NULL);
+
+	total = tst_striped_cnt_read(scnt);
+
+	if (total == (long long)NPRODUCERS * PER_PRODUCER)
+		tst_res(TPASS, "Counted %lli messages", total);
+	else
+		tst_res(TFAIL, "Counted %lli messages, expected %lli",
+			total, (long long)NPRODUCERS * PER_PRODUCER);
+}
+
+static void setup(void)
+{
+	scnt = SAFE_MMAP(NULL, sizeof(*scnt), PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	barrier = SAFE_MMAP(NULL, sizeof(*barrier), PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	queue = SAFE_MMAP(NULL, TST_MPMC_QUEUE_SIZE(QUEUE_CAP),
+			  PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+}
+
+static void cleanup(void)
+{
+	if (scnt)
+		SAFE_MUNMAP(scnt, sizeof(*scnt));
+	if (barrier)
+		SAFE_MUNMAP(barrier, sizeof(*barrier));
+	if (queue)
+		SAFE_MUNMAP(queue, TST_MPMC_QUEUE_SIZE(QUEUE_CAP));
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.forks_child = 1,
+};
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Test for the shared memory results ring buffer. Several forked children
+ * report concurrently through the ring, the drained output must contain
+ * one line per message and the summary must account for all of them.
+ */
+
+#include "tst_test.h"
+
+#define CHILDREN 4
+#define MESSAGES 100
+
+static void run(void)
+{
+	int i, j;
+
+	for (i = 0; i < CHILDREN; i++) {
+		if (!SAFE_FORK()) {
+			for (j = 0; j < MESSAGES; j++)
+				tst_res(TPASS, "child %i message %i", i, j);
+			return;
+		}
+	}
+
+	tst_reap_children();
+	tst_res(TPASS, "all children reported");
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.forks_child = 1,
+	.needs_results_ring = 1,
+};
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Test for create_sig_storm(). Points a sharded signal storm at
+ * ourselves and checks the shared-memory accounting: every signal is
+ * either sent or failed, and the handler fired at least once but no
+ * more often than signals were sent (standard signals coalesce).
+ */
+
+#include <signal.h>
+
+#include "tst_test.h"
+#include "tst_sig_proc.h"
+
+#define NSIGS 100000ULL
+#define SENDERS 4
+
+static volatile sig_atomic_t handled;
+
+static void sig_handler(int sig LTP_ATTRIBUTE_UNUSED)
+{
+	handled++;
+}
+
+static void run(void)
+{
+	struct tst_sig_storm *storm;
+	struct sigaction sa = {
+		.sa_handler = sig_handler,
+		.sa_flags = SA_RESTART,
+	};
+	uint64_t sent, failed;
+
+	SAFE_SIGACTION(SIGUSR1, &sa, NULL);
+
+	handled = 0;
+	storm = create_sig_storm(SIGUSR1, NSIGS, SENDERS);
+	wait_sig_storm(storm, &sent, &failed);
+
+	tst_res(TINFO, "sent %llu, failed %llu, handled %i",
+		(unsigned long long)sent, (unsigned long long)failed,
+		(int)handled);
+
+	if (sent + failed != NSIGS) {
+		tst_res(TFAIL, "Accounted %llu signals, expected %llu",
+			(unsigned long long)(sent + failed), NSIGS);
+		return;
+	}
+
+	if (!handled || (uint64_t)handled > sent) {
+		tst_res(TFAIL, "Handler ran %i times for %llu sent signals",
+			(int)handled, (unsigned long long)sent);
+		return;
+	}
+
+	tst_res(TPASS, "Signal storm accounting is consistent");
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.forks_child = 1,
+};
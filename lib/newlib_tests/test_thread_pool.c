@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Test for the SAFE_THREAD_POOL API. Pushes far more work items than
+ * there are workers through the pool and checks that every item ran
+ * exactly once, both before and after a drain.
+ */
+
+#include <pthread.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_atomic.h"
+
+#define WORKERS 16
+#define ITEMS 10000
+
+static int counter;
+static int seen[ITEMS];
+
+static void work_fn(void *arg)
+{
+	int id = (intptr_t)arg;
+
+	tst_atomic_inc(&seen[id]);
+	tst_atomic_inc(&counter);
+}
+
+static void run(void)
+{
+	struct tst_thread_pool *pool;
+	intptr_t i;
+	int ok = 1;
+
+	counter = 0;
+	memset(seen, 0, sizeof(seen));
+
+	pool = SAFE_THREAD_POOL_CREATE(WORKERS, work_fn);
+
+	for (i = 0; i < ITEMS / 2; i++)
+		SAFE_THREAD_POOL_SUBMIT(pool, (void *)i);
+
+	SAFE_THREAD_POOL_DRAIN(pool);
+
+	if (tst_atomic_load(&counter) != ITEMS / 2) {
+		tst_res(TFAIL, "After drain %i of %i items ran",
+			tst_atomic_load(&counter), ITEMS / 2);
+		ok = 0;
+	}
+
+	for (; i < ITEMS; i++)
+		SAFE_THREAD_POOL_SUBMIT(pool, (void *)i);
+
+	SAFE_THREAD_POOL_DESTROY(pool);
+
+	if (counter != ITEMS) {
+		tst_res(TFAIL, "After destroy %i of %i items ran",
+			counter, ITEMS);
+		ok = 0;
+	}
+
+	for (i = 0; i < ITEMS; i++) {
+		if (seen[i] != 1) {
+			tst_res(TFAIL, "Item %li ran %i times", i, seen[i]);
+			ok = 0;
+			break;
+		}
+	}
+
+	if (ok)
+		tst_res(TPASS, "All %i items ran exactly once", ITEMS);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+};
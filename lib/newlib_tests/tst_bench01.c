@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Microbenchmarks for the hot test library primitives. Each benchmark
+ * prints its cost in ns/op; when LTP_BENCH_RESULTS points to a writable
+ * file the previous run is loaded from it and a percentage delta is
+ * printed next to each result, so library setup cost regressions show
+ * up before they multiply across a full run.
+ *
+ * The tst_res() loop runs with stderr redirected to /dev/null so that
+ * message formatting and the write() are measured, not the terminal.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_safe_stdio.h"
+
+#define BENCHMARKS 4
+
+static const char *const bench_names[BENCHMARKS] = {
+	"tst_res",
+	"safe_fork",
+	"fork_exit_wait",
+	"tmpdir_cycle",
+};
+
+static long long prev_ns[BENCHMARKS];
+static int have_prev;
+
+static long long elapsed_ns(void)
+{
+	struct timespec ts = tst_timer_elapsed();
+
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void redirect_fd(int from_fd, int to_fd)
+{
+	if (dup2(from_fd, to_fd) < 0)
+		tst_brk(TBROK | TERRNO, "dup2(%i, %i)", from_fd, to_fd);
+}
+
+static long long bench_tst_res(void)
+{
+	int i, loops = 100000;
+	int saved_fd, null_fd;
+
+	saved_fd = SAFE_DUP(STDERR_FILENO);
+	null_fd = SAFE_OPEN("/dev/null", O_WRONLY);
+	redirect_fd(null_fd, STDERR_FILENO);
+
+	tst_timer_start(CLOCK_MONOTONIC);
+	for (i = 0; i < loops; i++)
+		tst_res(TINFO, "benchmark message %i", i);
+	tst_timer_stop();
+
+	redirect_fd(saved_fd, STDERR_FILENO);
+	SAFE_CLOSE(null_fd);
+	SAFE_CLOSE(saved_fd);
+
+	return elapsed_ns() / loops;
+}
+
+static long long bench_safe_fork(void)
+{
+	int i, loops = 2000;
+	pid_t pid;
+
+	tst_timer_start(CLOCK_MONOTONIC);
+	for (i = 0; i < loops; i++) {
+		pid = SAFE_FORK();
+		if (!pid)
+			_exit(0);
+		SAFE_WAITPID(pid, NULL, 0);
+	}
+	tst_timer_stop();
+
+	return elapsed_ns() / loops;
+}
+
+static long long bench_fork_exit_wait(void)
+{
+	int i, loops = 2000;
+	pid_t pid;
+
+	tst_timer_start(CLOCK_MONOTONIC);
+	for (i = 0; i < loops; i++) {
+		pid = fork();
+		if (pid < 0)
+			tst_brk(TBROK | TERRNO, "fork()");
+		if (!pid)
+			_exit(0);
+		SAFE_WAITPID(pid, NULL, 0);
+	}
+	tst_timer_stop();
+
+	return elapsed_ns() / loops;
+}
+
+static long long bench_tmpdir_cycle(void)
+{
+	int i, loops = 20000;
+
+	tst_timer_start(CLOCK_MONOTONIC);
+	for (i = 0; i < loops; i++) {
+		SAFE_MKDIR("bench.d", 0700);
+		SAFE_RMDIR("bench.d");
+	}
+	tst_timer_stop();
+
+	return elapsed_ns() / loops;
+}
+
+static long long (*const benchmarks[BENCHMARKS])(void) = {
+	bench_tst_res,
+	bench_safe_fork,
+	bench_fork_exit_wait,
+	bench_tmpdir_cycle,
+};
+
+static void load_prev(const char *path)
+{
+	char name[64];
+	long long ns;
+	FILE *f;
+	int i;
+
+	f = fopen(path, "r");
+	if (!f)
+		return;
+
+	while (fscanf(f, "%63s %lli", name, &ns) == 2) {
+		for (i = 0; i < BENCHMARKS; i++) {
+			if (!strcmp(name, bench_names[i]))
+				prev_ns[i] = ns;
+		}
+	}
+	have_prev = 1;
+
+	SAFE_FCLOSE(f);
+}
+
+static void save_results(const char *path, long long *res_ns)
+{
+	FILE *f;
+	int i;
+
+	f = fopen(path, "w");
+	if (!f) {
+		tst_res(TWARN | TERRNO, "Can't write results to '%s'", path);
+		return;
+	}
+
+	for (i = 0; i < BENCHMARKS; i++)
+		fprintf(f, "%s %lli\n", bench_names[i], res_ns[i]);
+
+	SAFE_FCLOSE(f);
+}
+
+static void run(void)
+{
+	long long res_ns[BENCHMARKS];
+	const char *results_path = getenv("LTP_BENCH_RESULTS");
+	int i;
+
+	if (results_path)
+		load_prev(results_path);
+
+	for (i = 0; i < BENCHMARKS; i++) {
+		res_ns[i] = benchmarks[i]();
+
+		if (have_prev && prev_ns[i] > 0) {
+			tst_res(TINFO, "%-16s %8lli ns/op (%+.1f%% vs last run)",
+				bench_names[i], res_ns[i],
+				100.0 * (res_ns[i] - prev_ns[i]) / prev_ns[i]);
+		} else {
+			tst_res(TINFO, "%-16s %8lli ns/op",
+				bench_names[i], res_ns[i]);
+		}
+	}
+
+	if (results_path)
+		save_results(results_path, res_ns);
+
+	tst_res(TPASS, "All benchmarks completed");
+}
+
+static void setup(void)
+{
+	tst_timer_check(CLOCK_MONOTONIC);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.test_all = run,
+	.forks_child = 1,
+	.needs_tmpdir = 1,
+};
@@ -30,11 +30,94 @@
  * http://oss.sgi.com/projects/GenInfo/NoticeExplan/
  */
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <malloc.h>
 #include "random_range.h"
 
+/*
+ * The generator behind random_range() and friends is xoshiro256**. The
+ * state is plain per-process data, so the multi-process I/O generators
+ * (doio, iogen) that call these routines millions of times per run do
+ * not serialize on the lock glibc takes inside random()/lrand48().
+ * Bounded values are drawn with bitmask rejection, which is unbiased
+ * unlike the modulo reduction used before, and a run is reproducible by
+ * reseeding with random_range_seed() from a logged seed.
+ *
+ * Note that the state is duplicated by fork() just as the lrand48 state
+ * was - children that want their own stream have to reseed, which the
+ * I/O generators already do with their pid.
+ */
+
+static uint64_t xoshiro_state[4];
+static int xoshiro_seeded;
+
+static inline uint64_t rotl64(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+/*
+ * splitmix64 expands the single seed word into the full state; it is
+ * the initializer the xoshiro authors recommend and it never produces
+ * the all-zero state xoshiro cannot leave.
+ */
+static void xoshiro_seed(uint64_t seed)
+{
+	uint64_t z;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		seed += 0x9e3779b97f4a7c15ULL;
+		z = seed;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		xoshiro_state[i] = z ^ (z >> 31);
+	}
+
+	xoshiro_seeded = 1;
+}
+
+static uint64_t xoshiro_next(void)
+{
+	uint64_t *s = xoshiro_state;
+	uint64_t result, t;
+
+	if (!xoshiro_seeded)
+		xoshiro_seed(0);
+
+	result = rotl64(s[1] * 5, 7) * 9;
+	t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl64(s[3], 45);
+
+	return result;
+}
+
+/*
+ * Returns an unbiased uniform value in [0, bound). Masking to the width
+ * of the bound and rejecting overshoots retries less than once on
+ * average and needs no 128-bit arithmetic, so it works the same on the
+ * 32bit arches.
+ */
+static uint64_t xoshiro_below(uint64_t bound)
+{
+	uint64_t mask = ~0ULL >> __builtin_clzll(bound | 1);
+	uint64_t x;
+
+	do {
+		x = xoshiro_next() & mask;
+	} while (x >= bound);
+
+	return x;
+}
+
 /*
  * Internal format of the range array set up by parse_range()
  */
@@ -96,7 +179,6 @@ struct range {
  */
 
 static int str_to_int();
-static long long divider(long long, long long, long long, long long);
 
 int parse_ranges(char *str, int defmin, int defmax, int defmult,
 		int (*parse_func)(), char **rangeptr, char **errptr)
@@ -271,14 +353,13 @@ int range_mult(char *rbuf, int r)
  * Note - if mult is 1 (the most common case), there are error conditions
  * possible, and errp need not be used.
  *
- * Note:    Uses lrand48(), assuming that set_random_seed() uses srand48() when
- *          setting the seed.
+ * Note:    Uses the process-local xoshiro generator seeded by
+ *          random_range_seed().
  *****************************************************************************/
 
 long random_range(int min, int max, int mult, char **errp)
 {
 	int r, nmults, orig_min, orig_max, orig_mult, tmp;
-	extern long lrand48();
 	static char errbuf[128];
 
 	/*
@@ -336,27 +417,8 @@ long random_range(int min, int max, int mult, char **errp)
 	}
 
 	nmults = ((max - min) / mult) + 1;
-#if CRAY
-	/*
-	 * If max is less than 2gb, then the value can fit in 32 bits
-	 * and the standard lrand48() routine can be used.
-	 */
-	if (max <= (long)2147483647) {
-		return (long)(min + (((long)lrand48() % nmults) * mult));
-	} else {
-		/*
-		 * max is greater than 2gb - meeds more than 32 bits.
-		 * Since lrand48 only will get a number up to 32bits.
-		 */
-		long randnum;
-		randnum = divider(min, max, 0, -1);
-		return (long)(min + ((randnum % nmults) * mult));
-	}
-
-#else
-	return (min + ((lrand48() % nmults) * mult));
-#endif
 
+	return (min + ((long)xoshiro_below(nmults) * mult));
 }
 
 /*
@@ -365,7 +427,6 @@ long random_range(int min, int max, int mult, char **errp)
 long random_rangel(long min, long max, long mult, char **errp)
 {
 	long r, nmults, orig_min, orig_max, orig_mult, tmp;
-	extern long lrand48();
 	static char errbuf[128];
 
 	/*
@@ -423,26 +484,8 @@ long random_rangel(long min, long max, long mult, char **errp)
 	}
 
 	nmults = ((max - min) / mult) + 1;
-#if CRAY || (_MIPS_SZLONG == 64)
-	/*
-	 * If max is less than 2gb, then the value can fit in 32 bits
-	 * and the standard lrand48() routine can be used.
-	 */
-	if (max <= (long)2147483647) {
-		return (long)(min + (((long)lrand48() % nmults) * mult));
-	} else {
-		/*
-		 * max is greater than 2gb - meeds more than 32 bits.
-		 * Since lrand48 only will get a number up to 32bits.
-		 */
-		long randnum;
-		randnum = divider(min, max, 0, -1);
-		return (long)(min + ((randnum % nmults) * mult));
-	}
 
-#else
-	return (min + ((lrand48() % nmults) * mult));
-#endif
+	return (min + ((long)xoshiro_below(nmults) * mult));
 }
 
 /*
@@ -452,8 +495,6 @@ long long random_rangell(long long min, long long max,
 			long long mult, char **errp)
 {
 	long long r, nmults, orig_min, orig_max, orig_mult, tmp;
-	long long randnum;
-	extern long lrand48();
 	static char errbuf[128];
 
 	/*
@@ -511,109 +552,20 @@ long long random_rangell(long long min, long long max,
 	}
 
 	nmults = ((max - min) / mult) + 1;
-	/*
-	 * If max is less than 2gb, then the value can fit in 32 bits
-	 * and the standard lrand48() routine can be used.
-	 */
-	if (max <= (long)2147483647) {
-		return (long long)(min +
-				   (((long long)lrand48() % nmults) * mult));
-	} else {
-		/*
-		 * max is greater than 2gb - meeds more than 32 bits.
-		 * Since lrand48 only will get a number up to 32bits.
-		 */
-		randnum = divider(min, max, 0, -1);
-		return (long long)(min + ((randnum % nmults) * mult));
-	}
-
-}
-
-/*
- * This functional will recusively call itself to return a random
- * number min and max.   It was designed to work the 64bit numbers
- * even when compiled as 32 bit process.
- * algorithm:  to use the official lrand48() routine - limited to 32 bits.
- *   find the difference between min and max (max-min).
- *   if the difference is 2g or less, use the random number gotton from lrand48().
- *   Determine the midway point between min and max.
- *   if the midway point is less than 2g from min or max,
- *      randomly add the random number gotton from lrand48() to
- *      either min or the midpoint.
- *   Otherwise, call outself with min and max being min and midway value or
- *   midway value and max.  This will reduce the range in half.
- */
-static long long
-divider(long long min, long long max, long long cnt, long long rand)
-{
-	long long med, half, diff;
-
-	/*
-	 * prevent run away code.  We are dividing by two each count.
-	 * if we get to a count of more than 32, we should have gotten
-	 * to 2gb.
-	 */
-	if (cnt > 32)
-		return -1;
-
-	/*
-	 * Only get a random number the first time.
-	 */
-	if (cnt == 0 || rand < -1) {
-		rand = (long long)lrand48();	/* 32 bit random number */
-	}
-
-	diff = max - min;
-
-	if (diff <= 2147483647)
-		return min + rand;
-
-	half = diff / (long long)2;	/* half the distance between min and max */
-	med = min + half;	/* med way point between min and max */
-
-#if DEBUG
-	printf("divider: min=%lld, max=%lld, cnt=%lld, rand=%lld\n", min, max,
-	       cnt, rand);
-	printf("   diff = %lld, half = %lld,   med = %lld\n", diff, half, med);
-#endif
-
-	if (half <= 2147483647) {
-		/*
-		 * If half is smaller than 2gb, we can use the random number
-		 * to pick the number within the min to med or med to max
-		 * if the cnt bit of rand is zero or one, respectively.
-		 */
-		if (rand & (1 << cnt))
-			return med + rand;
-		else
-			return min + rand;
-	} else {
-		/*
-		 * recursively call ourself to reduce the value to the bottom half
-		 * or top half (bit cnt is set).
-		 */
-		if (rand & (1 << cnt)) {
-			return divider(med, max, cnt + 1, rand);
-		} else {
-			return divider(min, med, cnt + 1, rand);
-		}
-
-	}
 
+	return (min + ((long long)xoshiro_below(nmults) * mult));
 }
 
 /*****************************************************************************
  * random_range_seed(s)
  *
- * Sets the random seed to s.  Uses srand48(), assuming that lrand48() will
- * be used in random_range().
+ * Seeds the process-local generator used by random_range() and friends
+ * with s. Runs seeded with the same value draw the same sequence.
  *****************************************************************************/
 
 void random_range_seed(long s)
 {
-	extern void srand48();
-
-	srand48(s);
+	xoshiro_seed((uint64_t)s);
 }
 
 /****************************************************************************
@@ -168,6 +168,70 @@ void safe_file_scanf(const char *file, const int lineno,
 }
 
 
+void safe_file_scanf_fd(const char *file, const int lineno,
+			void (*cleanup_fn)(void),
+			int fd, const char *fmt, ...)
+{
+	char buf[BUFSIZ];
+	va_list va;
+	ssize_t len;
+	int exp_convs, ret;
+
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+
+	if (len < 0) {
+		tst_brkm_(file, lineno, TBROK | TERRNO, cleanup_fn,
+			"Failed to pread() fd %d", fd);
+		return;
+	}
+
+	if (len == 0) {
+		tst_brkm_(file, lineno, TBROK, cleanup_fn,
+			"The fd %d ended prematurely", fd);
+		return;
+	}
+
+	buf[len] = '\0';
+
+	exp_convs = count_scanf_conversions(fmt);
+
+	va_start(va, fmt);
+	ret = vsscanf(buf, fmt, va);
+	va_end(va);
+
+	if (ret != exp_convs) {
+		tst_brkm_(file, lineno, TBROK, cleanup_fn,
+			"Expected %i conversions got %i fd %d",
+			exp_convs, ret, fd);
+		return;
+	}
+}
+
+void safe_file_printf_fd(const char *file, const int lineno,
+			void (*cleanup_fn)(void),
+			int fd, const char *fmt, ...)
+{
+	char buf[BUFSIZ];
+	va_list va;
+	int len;
+
+	va_start(va, fmt);
+	len = vsnprintf(buf, sizeof(buf), fmt, va);
+	va_end(va);
+
+	if (len < 0 || len >= (int)sizeof(buf)) {
+		tst_brkm_(file, lineno, TBROK, cleanup_fn,
+			"Failed to format '%s' for fd %d", fmt, fd);
+		return;
+	}
+
+	if (pwrite(fd, buf, len, 0) != len) {
+		tst_brkm_(file, lineno, TBROK | TERRNO, cleanup_fn,
+			"Failed to pwrite() to fd %d", fd);
+		return;
+	}
+}
+
 /*
  * Try to parse each line from file specified by 'path' according
  * to scanf format 'fmt'. If all fields could be parsed, stop and
@@ -22,6 +22,7 @@
 #include <unistd.h>
 #include <malloc.h>
 #include "test.h"
+#include "tst_mount_table.h"
 #include "safe_macros.h"
 
 char *safe_basename(const char *file, const int lineno,
@@ -847,8 +848,10 @@ int safe_mount(const char *file, const int lineno, void (*cleanup_fn)(void),
 	 */
 	if (!filesystemtype || strcmp(filesystemtype, "ntfs")) {
 		rval = mount(source, target, filesystemtype, mountflags, data);
-		if (!rval)
+		if (!rval) {
+			tst_mount_epoch_bump();
 			return 0;
+		}
 	}
 
 	/*
@@ -866,8 +869,10 @@ int safe_mount(const char *file, const int lineno, void (*cleanup_fn)(void),
 			filesystemtype, source, target);
 
 		rval = tst_system(buf);
-		if (WIFEXITED(rval) && WEXITSTATUS(rval) == 0)
+		if (WIFEXITED(rval) && WEXITSTATUS(rval) == 0) {
+			tst_mount_epoch_bump();
 			return 0;
+		}
 
 		tst_brkm_(file, lineno, TBROK, cleanup_fn,
 			"mount.%s failed with %i", filesystemtype, rval);
@@ -16,10 +16,36 @@
  *
  */
 
+#define _GNU_SOURCE
+
+#include "config.h"
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 #include "test.h"
 #include "safe_macros_fn.h"
 #include "safe_net_fn.h"
+#include "tst_cache.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY		60
+#endif
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY	5
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY		0x4000000
+#endif
 
 char *tst_sock_addr(const struct sockaddr *sa, socklen_t salen, char *res,
 		    size_t len)
@@ -297,6 +323,119 @@ ssize_t safe_recvmsg(const char *file, const int lineno, size_t len,
 
 }
 
+#ifdef HAVE_STRUCT_MMSGHDR
+int safe_sendmmsg(const char *file, const int lineno, int sockfd,
+		  struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+	int rval;
+
+	rval = sendmmsg(sockfd, msgvec, vlen, flags);
+
+	if (rval == -1) {
+		tst_brkm_(file, lineno, TBROK | TERRNO, NULL,
+			"sendmmsg(%d, %p, %u, %d) failed", sockfd, msgvec,
+			vlen, flags);
+	} else if (rval < 0) {
+		tst_brkm_(file, lineno, TBROK | TERRNO, NULL,
+			"Invalid sendmmsg(%d, %p, %u, %d) return value %d",
+			sockfd, msgvec, vlen, flags, rval);
+	}
+
+	return rval;
+}
+
+int safe_recvmmsg(const char *file, const int lineno, int sockfd,
+		  struct mmsghdr *msgvec, unsigned int vlen, int flags,
+		  struct timespec *timeout)
+{
+	int rval;
+
+	rval = recvmmsg(sockfd, msgvec, vlen, flags, timeout);
+
+	if (rval == -1) {
+		tst_brkm_(file, lineno, TBROK | TERRNO, NULL,
+			"recvmmsg(%d, %p, %u, %d, %p) failed", sockfd, msgvec,
+			vlen, flags, timeout);
+	} else if (rval < 0) {
+		tst_brkm_(file, lineno, TBROK | TERRNO, NULL,
+			"Invalid recvmmsg(%d, %p, %u, %d, %p) return value %d",
+			sockfd, msgvec, vlen, flags, timeout, rval);
+	}
+
+	return rval;
+}
+#endif /* HAVE_STRUCT_MMSGHDR */
+
+#ifdef __linux__
+/*
+ * Sends the buffer with MSG_ZEROCOPY and blocks until the completion
+ * notification arrives on the socket's error queue, so the caller is free
+ * to reuse the buffer afterwards. Falls back to a plain copying send()
+ * when the socket or kernel does not support SO_ZEROCOPY. Notifications
+ * are consumed one per send, i.e. the wrapper does not pipeline.
+ */
+ssize_t safe_send_zerocopy(const char *file, const int lineno,
+			   char len_strict, int sockfd, const void *buf,
+			   size_t len, int flags)
+{
+	char control[128];
+	struct sock_extended_err *serr;
+	struct cmsghdr *cm;
+	struct msghdr msg;
+	struct pollfd pfd;
+	ssize_t rval;
+	int one = 1;
+
+	if (setsockopt(sockfd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)))
+		return safe_send(file, lineno, len_strict, sockfd, buf, len,
+				 flags);
+
+	rval = send(sockfd, buf, len, flags | MSG_ZEROCOPY);
+
+	if (rval == -1 || (len_strict && (size_t)rval != len)) {
+		tst_brkm_(file, lineno, TBROK | TERRNO, NULL,
+			"send(%d, %p, %zu, %d | MSG_ZEROCOPY) failed",
+			sockfd, buf, len, flags);
+		return rval;
+	}
+
+	for (;;) {
+		pfd.fd = sockfd;
+		pfd.events = 0;
+		pfd.revents = 0;
+
+		if (poll(&pfd, 1, 30000) != 1 || !(pfd.revents & POLLERR)) {
+			tst_brkm_(file, lineno, TBROK, NULL,
+				"Timeout waiting for MSG_ZEROCOPY completion on fd %d",
+				sockfd);
+			return rval;
+		}
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (recvmsg(sockfd, &msg, MSG_ERRQUEUE) == -1) {
+			if (errno == EAGAIN)
+				continue;
+
+			tst_brkm_(file, lineno, TBROK | TERRNO, NULL,
+				"recvmsg(%d, msg, MSG_ERRQUEUE) failed",
+				sockfd);
+			return rval;
+		}
+
+		for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+			serr = (struct sock_extended_err *)CMSG_DATA(cm);
+
+			if (serr->ee_errno == 0 &&
+			    serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+				return rval;
+		}
+	}
+}
+#endif /* __linux__ */
+
 int safe_bind(const char *file, const int lineno, void (cleanup_fn)(void),
 	      int socket, const struct sockaddr *address,
 	      socklen_t address_len)
@@ -441,12 +580,205 @@ int safe_gethostname(const char *file, const int lineno,
 	return rval;
 }
 
+#define PORT_POOL_BASE 49152
+#define PORT_POOL_RANGE_LEN 16
+#define PORT_POOL_RANGES 512
+#define PORT_POOL_LAST \
+	(PORT_POOL_BASE + PORT_POOL_RANGES * PORT_POOL_RANGE_LEN - 1)
+#define RESERVED_PORTS_PATH "/proc/sys/net/ipv4/ip_local_reserved_ports"
+
+/*
+ * Keeps the kernel from handing the pool out as ephemeral ports, by
+ * appending it to ip_local_reserved_ports. Best effort; without the
+ * reservation the pool still works, it just may collide with ephemeral
+ * connections.
+ */
+static void reserve_port_pool(void)
+{
+	static int done;
+	char buf[256], range[64];
+	ssize_t len;
+	int fd;
+
+	if (done)
+		return;
+	done = 1;
+
+	snprintf(range, sizeof(range), "%i-%i",
+		 PORT_POOL_BASE, PORT_POOL_LAST);
+
+	fd = open(RESERVED_PORTS_PATH, O_RDWR);
+	if (fd < 0)
+		return;
+
+	len = read(fd, buf, sizeof(buf) - 1);
+	if (len < 0) {
+		close(fd);
+		return;
+	}
+	buf[len] = '\0';
+
+	if (len && buf[len - 1] == '\n')
+		buf[--len] = '\0';
+
+	if (!strstr(buf, range)) {
+		if (len) {
+			strncat(buf, ",", sizeof(buf) - strlen(buf) - 1);
+			strncat(buf, range, sizeof(buf) - strlen(buf) - 1);
+		} else {
+			snprintf(buf, sizeof(buf), "%s", range);
+		}
+
+		if (pwrite(fd, buf, strlen(buf), 0) < 0)
+			tst_resm_(__FILE__, __LINE__, TINFO,
+				  "Could not reserve port pool in %s",
+				  RESERVED_PORTS_PATH);
+	}
+
+	close(fd);
+}
+
+/*
+ * Leases the next PORT_POOL_RANGE_LEN-port range from the run-wide
+ * broker file, serialized by flock(). Returns the first port of the
+ * range or -1 when the run cache is not available. Once all ranges
+ * have been handed out the broker wraps around, which can only clash
+ * with a test that is still sitting on a lease several hundred tests
+ * old.
+ */
+static int port_broker_lease(void)
+{
+	char path[PATH_MAX];
+	char buf[32];
+	ssize_t len;
+	int fd, idx = 0;
+
+	if (tst_cache_file_path("ports.lease", path, sizeof(path)))
+		return -1;
+
+	fd = open(path, O_CREAT | O_RDWR, 0666);
+	if (fd < 0)
+		return -1;
+
+	while (flock(fd, LOCK_EX)) {
+		if (errno == EINTR)
+			continue;
+		close(fd);
+		return -1;
+	}
+
+	len = read(fd, buf, sizeof(buf) - 1);
+	if (len > 0) {
+		buf[len] = '\0';
+		idx = atoi(buf);
+	}
+
+	if (idx < 0 || idx >= PORT_POOL_RANGES)
+		idx = 0;
+
+	len = snprintf(buf, sizeof(buf), "%i", idx + 1);
+	if (pwrite(fd, buf, len, 0) != len || ftruncate(fd, len))
+		idx = -1;
+
+	flock(fd, LOCK_UN);
+	close(fd);
+
+	if (idx == -1)
+		return -1;
+
+	reserve_port_pool();
+
+	return PORT_POOL_BASE + idx * PORT_POOL_RANGE_LEN;
+}
+
+/*
+ * Returns non-zero when the port cannot be bound for the given family
+ * and type, which means something unrelated already sits on it and the
+ * lease has to skip it.
+ */
+static int port_in_use(unsigned short family, int type, int port)
+{
+	struct sockaddr_storage _addr;
+	struct sockaddr *addr = (struct sockaddr *)&_addr;
+	struct sockaddr_in *addr4 = (struct sockaddr_in *)addr;
+	struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)addr;
+	socklen_t slen;
+	int sock, ret;
+
+	memset(&_addr, 0, sizeof(_addr));
+
+	if (family == AF_INET) {
+		addr4->sin_family = AF_INET;
+		addr4->sin_port = htons(port);
+		addr4->sin_addr.s_addr = INADDR_ANY;
+		slen = sizeof(*addr4);
+	} else {
+		addr6->sin6_family = AF_INET6;
+		addr6->sin6_port = htons(port);
+		addr6->sin6_addr = in6addr_any;
+		slen = sizeof(*addr6);
+	}
+
+	sock = socket(family, type, 0);
+	if (sock < 0)
+		return 0;
+
+	ret = bind(sock, addr, slen);
+	close(sock);
+
+	return ret != 0;
+}
+
 /*
  * @return port in network byte order.
+ *
+ * When the run cache is available the port comes from a range leased
+ * from the run-wide broker, which is disjoint from the ranges of
+ * concurrently running tests and reserved against ephemeral use.
+ * Each leased port is still probed with bind() before it is handed
+ * out, since an unrelated listener may occupy any port in the pool.
+ * When the broker is not available the code falls back to bind/close
+ * probing of an ephemeral port, which can race with other processes.
  */
 unsigned short tst_get_unused_port(const char *file, const int lineno,
 	      void (cleanup_fn)(void), unsigned short family, int type)
 {
+	static int range_base = -1;
+	static int range_used;
+	static pid_t range_owner;
+
+	if (family == AF_INET || family == AF_INET6) {
+		int port, leases = 0;
+
+		/*
+		 * The statics are duplicated by fork(), so a child must
+		 * take out its own lease or it would hand out the same
+		 * ports as its parent.
+		 */
+		if (range_owner != getpid())
+			range_base = -1;
+
+		for (;;) {
+			if (range_base == -1 ||
+			    range_used >= PORT_POOL_RANGE_LEN) {
+				if (leases++ >= 4)
+					break;
+
+				range_base = port_broker_lease();
+				range_used = 0;
+				range_owner = getpid();
+
+				if (range_base == -1)
+					break;
+			}
+
+			port = range_base + range_used++;
+
+			if (!port_in_use(family, type, port))
+				return htons(port);
+		}
+	}
+
 	int sock, ret;
 	socklen_t slen;
 	struct sockaddr_storage _addr;
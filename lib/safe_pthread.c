@@ -5,9 +5,14 @@
 
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
+#include "lapi/futex.h"
 
 int safe_pthread_create(const char *file, const int lineno,
 			pthread_t *thread_id, const pthread_attr_t *attr,
@@ -41,3 +46,158 @@ int safe_pthread_join(const char *file, const int lineno,
 
 	return rval;
 }
+
+enum slot_state {
+	SLOT_IDLE,
+	SLOT_WORK,
+	SLOT_STOP,
+};
+
+/*
+ * One slot per worker, padded to a cache line so that workers spinning
+ * on their own state do not share lines with their neighbours.
+ */
+struct pool_slot {
+	futex_t state;
+	void *arg;
+	struct tst_thread_pool *pool;
+} __attribute__((aligned(64)));
+
+struct tst_thread_pool {
+	void (*fn)(void *arg);
+	unsigned int workers;
+	unsigned int next;
+	pthread_t *threads;
+	struct pool_slot *slots;
+};
+
+static void pool_futex_wait(futex_t *uaddr, uint32_t val)
+{
+	if (syscall(SYS_futex, uaddr, FUTEX_WAIT | FUTEX_PRIVATE_FLAG,
+		    val, NULL, NULL, 0) == -1) {
+		if (errno != EAGAIN && errno != EINTR)
+			tst_brk(TBROK | TERRNO, "futex(FUTEX_WAIT) failed");
+	}
+}
+
+static void pool_futex_wake(futex_t *uaddr)
+{
+	if (syscall(SYS_futex, uaddr, FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+		    INT_MAX, NULL, NULL, 0) == -1)
+		tst_brk(TBROK | TERRNO, "futex(FUTEX_WAKE) failed");
+}
+
+static void *pool_worker(void *arg)
+{
+	struct pool_slot *slot = arg;
+	uint32_t state;
+
+	for (;;) {
+		while ((state = slot->state) == SLOT_IDLE)
+			pool_futex_wait(&slot->state, SLOT_IDLE);
+
+		if (state == SLOT_STOP)
+			break;
+
+		slot->pool->fn(slot->arg);
+
+		__sync_synchronize();
+		slot->state = SLOT_IDLE;
+		pool_futex_wake(&slot->state);
+	}
+
+	return NULL;
+}
+
+struct tst_thread_pool *safe_thread_pool_create(const char *file,
+		const int lineno, unsigned int workers, void (*fn)(void *))
+{
+	struct tst_thread_pool *pool;
+	unsigned int i;
+	int rval;
+
+	if (!workers)
+		tst_brk_(file, lineno, TBROK, "Empty thread pool requested");
+
+	pool = calloc(1, sizeof(*pool));
+	if (!pool)
+		tst_brk_(file, lineno, TBROK, "calloc() failed");
+
+	pool->fn = fn;
+	pool->workers = workers;
+
+	pool->threads = calloc(workers, sizeof(pthread_t));
+	if (!pool->threads)
+		tst_brk_(file, lineno, TBROK, "calloc() failed");
+
+	rval = posix_memalign((void **)&pool->slots, 64,
+			      workers * sizeof(struct pool_slot));
+	if (rval) {
+		tst_brk_(file, lineno, TBROK, "posix_memalign() failed: %s",
+			 tst_strerrno(rval));
+	}
+
+	for (i = 0; i < workers; i++) {
+		pool->slots[i].state = SLOT_IDLE;
+		pool->slots[i].arg = NULL;
+		pool->slots[i].pool = pool;
+
+		safe_pthread_create(file, lineno, &pool->threads[i], NULL,
+				    pool_worker, &pool->slots[i]);
+	}
+
+	return pool;
+}
+
+void safe_thread_pool_submit(const char *file, const int lineno,
+			     struct tst_thread_pool *pool, void *arg)
+{
+	struct pool_slot *slot;
+	uint32_t state;
+
+	(void)file;
+	(void)lineno;
+
+	slot = &pool->slots[pool->next++ % pool->workers];
+
+	while ((state = slot->state) != SLOT_IDLE)
+		pool_futex_wait(&slot->state, state);
+
+	slot->arg = arg;
+	__sync_synchronize();
+	slot->state = SLOT_WORK;
+	pool_futex_wake(&slot->state);
+}
+
+void safe_thread_pool_drain(const char *file, const int lineno,
+			    struct tst_thread_pool *pool)
+{
+	uint32_t state;
+	unsigned int i;
+
+	(void)file;
+	(void)lineno;
+
+	for (i = 0; i < pool->workers; i++) {
+		while ((state = pool->slots[i].state) == SLOT_WORK)
+			pool_futex_wait(&pool->slots[i].state, state);
+	}
+}
+
+void safe_thread_pool_destroy(const char *file, const int lineno,
+			      struct tst_thread_pool *pool)
+{
+	unsigned int i;
+
+	safe_thread_pool_drain(file, lineno, pool);
+
+	for (i = 0; i < pool->workers; i++) {
+		pool->slots[i].state = SLOT_STOP;
+		pool_futex_wake(&pool->slots[i].state);
+		safe_pthread_join(file, lineno, pool->threads[i], NULL);
+	}
+
+	free(pool->slots);
+	free(pool->threads);
+	free(pool);
+}
@@ -31,14 +31,24 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
 #include "test.h"
 #include "safe_macros.h"
+#include "tst_fs.h"
 
 /* Set from parse_opts.c: */
 char *child_args;		/* Arguments to child when -C is used */
 
 static char *start_cwd;		/* Stores the starting directory for self_exec */
 
+/*
+ * The binary re-execs itself for every child, so the $PATH resolution of
+ * argv0 is done once on the first self_exec() and cached - all children
+ * are the same binary and the repeated lookups only added latency to
+ * tests spawning many children.
+ */
+static char exec_path[PATH_MAX];
+
 int asprintf(char **app, const char *fmt, ...)
 {
 	va_list ptr;
@@ -166,10 +176,16 @@ int self_exec(const char *argv0, const char *fmt, ...)
 	va_list ap;
 	char *p;
 	char *tmp_cwd;
-	char *arg;
+	char *arg, *prev_arg;
 	int ival;
 	char *str;
 
+	if (!exec_path[0] &&
+	    tst_get_path(argv0, exec_path, sizeof(exec_path))) {
+		tst_resm(TBROK, "Could not find %s in $PATH", argv0);
+		return -1;
+	}
+
 	if ((tmp_cwd = getcwd(NULL, 0)) == NULL) {
 		tst_resm(TBROK, "Could not getcwd()");
 		return -1;
@@ -188,20 +204,24 @@ int self_exec(const char *argv0, const char *fmt, ...)
 		case 'd':
 		case 'n':
 			ival = va_arg(ap, int);
-			if (asprintf(&arg, "%s,%d", arg, ival) < 0) {
+			prev_arg = arg;
+			if (asprintf(&arg, "%s,%d", prev_arg, ival) < 0) {
 				tst_resm(TBROK,
 					 "Could not produce self_exec string");
 				return -1;
 			}
+			free(prev_arg);
 			break;
 		case 's':
 		case 'S':
 			str = va_arg(ap, char *);
-			if (asprintf(&arg, "%s,%s", arg, str) < 0) {
+			prev_arg = arg;
+			if (asprintf(&arg, "%s,%s", prev_arg, str) < 0) {
 				tst_resm(TBROK,
 					 "Could not produce self_exec string");
 				return -1;
 			}
+			free(prev_arg);
 			break;
 		default:
 			tst_resm(TBROK,
@@ -219,7 +239,7 @@ int self_exec(const char *argv0, const char *fmt, ...)
 		return -1;
 	}
 
-	return execlp(argv0, argv0, "-C", arg, (char *)NULL);
+	return execl(exec_path, argv0, "-C", arg, (char *)NULL);
 }
 
 #endif /* UCLINUX */
@@ -162,6 +162,9 @@ struct lio_info_type Lio_info1[] = {
 	 "single stride async listio using pause"},
 	{"v", LIO_IO_SYNCV, "single buffer sync readv/writev"},
 	{"P", LIO_IO_SYNCP, "sync pread/pwrite"},
+#if defined(__linux__) && !defined(__UCLIBC__)
+	{"U", LIO_IO_URING, "io_uring submit and completion reap"},
+#endif
 };
 
 /*
@@ -174,6 +177,9 @@ struct lio_info_type Lio_info2[] = {
 	{"alistio", LIO_IO_ALISTIO, "single stride async listio"},
 	{"syncv", LIO_IO_SYNCV, "single buffer sync readv/writev"},
 	{"syncp", LIO_IO_SYNCP, "pread/pwrite"},
+#if defined(__linux__) && !defined(__UCLIBC__)
+	{"iouring", LIO_IO_URING, "io_uring submit and completion reap"},
+#endif
 	{"active", LIO_WAIT_ACTIVE, "spin on status/control values"},
 	{"recall", LIO_WAIT_RECALL,
 	 "use recall(2)/aio_suspend(3) to wait for i/o to complete"},
@@ -490,6 +496,157 @@ static void wait4sync_io(int fd, int read)
 	select(fd + 1, read ? &s : NULL, read ? NULL : &s, NULL, NULL);
 }
 
+#if defined(__linux__) && !defined(__UCLIBC__) && defined(HAVE_LINUX_IO_URING_H)
+#define LIO_HAVE_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup	425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter	426
+#endif
+
+#define LIO_URING_ENTRIES 64
+
+/*
+ * One process-wide ring, mapped lazily on first use so children forked
+ * before doing any i/o (doio/growfiles style) each get their own ring.
+ * Every lio call submits one sqe and reaps its cqe before returning, so
+ * nothing in here needs to survive across calls but the ring itself.
+ */
+static struct uring_state {
+	int fd;			/* ring fd, -1 not set up yet, -2 unsupported */
+	struct io_uring_sqe *sqes;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+} Uring = { .fd = -1 };
+
+static int lio_uring_setup(void)
+{
+	struct io_uring_params p;
+	void *sq_ptr, *cq_ptr;
+
+	if (Uring.fd >= 0)
+		return 0;
+	if (Uring.fd == -2)
+		return -1;
+
+	memset(&p, 0x00, sizeof(p));
+	Uring.fd = syscall(__NR_io_uring_setup, LIO_URING_ENTRIES, &p);
+	if (Uring.fd < 0) {
+		if (Debug_level)
+			printf("DEBUG %s/%d: io_uring_setup failed, errno=%d %s\n",
+			       __FILE__, __LINE__, errno, strerror(errno));
+		Uring.fd = -2;
+		return -1;
+	}
+
+	/*
+	 * Map the submission and completion rings separately, which works
+	 * on every kernel with io_uring (IORING_FEAT_SINGLE_MMAP is just
+	 * an optimization).
+	 */
+	sq_ptr = mmap(NULL, p.sq_off.array + p.sq_entries * sizeof(unsigned int),
+		      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		      Uring.fd, IORING_OFF_SQ_RING);
+	cq_ptr = mmap(NULL, p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe),
+		      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		      Uring.fd, IORING_OFF_CQ_RING);
+	Uring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+			  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			  Uring.fd, IORING_OFF_SQES);
+
+	if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED ||
+	    Uring.sqes == MAP_FAILED) {
+		if (Debug_level)
+			printf("DEBUG %s/%d: io_uring ring mmap failed, errno=%d %s\n",
+			       __FILE__, __LINE__, errno, strerror(errno));
+		close(Uring.fd);
+		Uring.fd = -2;
+		return -1;
+	}
+
+	Uring.sq_tail = (unsigned int *)((char *)sq_ptr + p.sq_off.tail);
+	Uring.sq_mask = (unsigned int *)((char *)sq_ptr + p.sq_off.ring_mask);
+	Uring.sq_array = (unsigned int *)((char *)sq_ptr + p.sq_off.array);
+	Uring.cq_head = (unsigned int *)((char *)cq_ptr + p.cq_off.head);
+	Uring.cq_tail = (unsigned int *)((char *)cq_ptr + p.cq_off.tail);
+	Uring.cq_mask = (unsigned int *)((char *)cq_ptr + p.cq_off.ring_mask);
+	Uring.cqes = (struct io_uring_cqe *)((char *)cq_ptr + p.cq_off.cqes);
+
+	return 0;
+}
+
+/*
+ * Submit a single readv/writev sqe at the given offset and wait for its
+ * completion.  Returns the transfer size or -1 with errno set, ie. the
+ * same contract as pread/pwrite, so the callers' error handling is
+ * shared with the sync i/o types.
+ */
+static int lio_uring_rw(int opcode, int fd, char *buffer, int size,
+			off64_t offset)
+{
+	struct io_uring_sqe *sqe;
+	struct io_uring_cqe *cqe;
+	struct iovec iov;
+	unsigned int tail, head, idx;
+	int ret;
+
+	iov.iov_base = buffer;
+	iov.iov_len = size;
+
+	tail = *Uring.sq_tail;
+	idx = tail & *Uring.sq_mask;
+	sqe = &Uring.sqes[idx];
+	memset(sqe, 0x00, sizeof(*sqe));
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)&iov;
+	sqe->len = 1;
+	sqe->off = offset;
+	Uring.sq_array[idx] = idx;
+	__atomic_store_n(Uring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	do {
+		ret = syscall(__NR_io_uring_enter, Uring.fd, 1, 1,
+			      IORING_ENTER_GETEVENTS, NULL, _NSIG / 8);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0)
+		return -1;
+
+	head = *Uring.cq_head;
+	if (head == __atomic_load_n(Uring.cq_tail, __ATOMIC_ACQUIRE)) {
+		errno = EIO;	/* waited for an event, none arrived */
+		return -1;
+	}
+
+	cqe = &Uring.cqes[head & *Uring.cq_mask];
+	ret = cqe->res;
+	__atomic_store_n(Uring.cq_head, head + 1, __ATOMIC_RELEASE);
+
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return ret;
+}
+#elif defined(__linux__) && !defined(__UCLIBC__)
+static int lio_uring_setup(void)
+{
+	return -1;
+}
+#endif /* linux && HAVE_LINUX_IO_URING_H */
+
 /***********************************************************************
  * Generic write function
  * This function can be used to do a write using write(2), writea(2),
@@ -572,6 +729,18 @@ int lio_write_buffer(int fd,		/* open file descriptor */
 			       __FILE__, __LINE__, method);
 	}
 
+#ifdef LIO_IO_URING
+	/*
+	 * Quietly fall back to sync i/o when the kernel has no io_uring.
+	 */
+	if ((method & LIO_IO_URING) && lio_uring_setup() < 0) {
+		method = (method & ~LIO_IO_URING) | LIO_IO_SYNC;
+		if (Debug_level)
+			printf("DEBUG %s/%d: no io_uring support, method switched to %#o\n",
+			       __FILE__, __LINE__, method);
+	}
+#endif
+
 	if (errmsg != NULL)
 		*errmsg = Errormsg;
 
@@ -1010,6 +1179,40 @@ int lio_write_buffer(int fd,		/* open file descriptor */
 	}			/* LIO_IO_SYNCP */
 #endif
 
+#ifdef LIO_HAVE_URING
+	else if (method & LIO_IO_URING) {
+		io_type = "io_uring write";
+
+		sprintf(Lio_SysCall,
+			"io_uring IORING_OP_WRITEV, fd:%d, nbyte:%d, offset:%lld",
+			fd, size, (long long)poffset);
+
+		if (Debug_level) {
+			printf("DEBUG %s/%d: %s\n", __FILE__, __LINE__,
+			       Lio_SysCall);
+		}
+		if ((ret = lio_uring_rw(IORING_OP_WRITEV, fd, buffer, size,
+					poffset)) == -1) {
+			sprintf(Errormsg,
+				"%s/%d %s ret:-1, errno=%d %s",
+				__FILE__, __LINE__, Lio_SysCall,
+				errno, strerror(errno));
+			return -errno;
+		}
+
+		if (ret != size) {
+			sprintf(Errormsg,
+				"%s/%d %s returned=%d",
+				__FILE__, __LINE__, Lio_SysCall, ret);
+		} else if (Debug_level > 1)
+			printf
+			    ("DEBUG %s/%d: io_uring write completed without error (ret %d)\n",
+			     __FILE__, __LINE__, ret);
+
+		return ret;
+	}			/* LIO_IO_URING */
+#endif
+
 	else {
 		printf("DEBUG %s/%d: No I/O method chosen\n", __FILE__,
 		       __LINE__);
@@ -1143,6 +1346,18 @@ int lio_read_buffer(int fd,	/* open file descriptor */
 			       __FILE__, __LINE__, method);
 	}
 
+#ifdef LIO_IO_URING
+	/*
+	 * Quietly fall back to sync i/o when the kernel has no io_uring.
+	 */
+	if ((method & LIO_IO_URING) && lio_uring_setup() < 0) {
+		method = (method & ~LIO_IO_URING) | LIO_IO_SYNC;
+		if (Debug_level)
+			printf("DEBUG %s/%d: no io_uring support, method switched to %#o\n",
+			       __FILE__, __LINE__, method);
+	}
+#endif
+
 	if (errmsg != NULL)
 		*errmsg = Errormsg;
 
@@ -1583,6 +1798,40 @@ int lio_read_buffer(int fd,	/* open file descriptor */
 	}			/* LIO_IO_SYNCP */
 #endif
 
+#ifdef LIO_HAVE_URING
+	else if (method & LIO_IO_URING) {
+		io_type = "io_uring read";
+
+		sprintf(Lio_SysCall,
+			"io_uring IORING_OP_READV, fd:%d, nbyte:%d, offset:%lld",
+			fd, size, (long long)poffset);
+
+		if (Debug_level) {
+			printf("DEBUG %s/%d: %s\n", __FILE__, __LINE__,
+			       Lio_SysCall);
+		}
+		if ((ret = lio_uring_rw(IORING_OP_READV, fd, buffer, size,
+					poffset)) == -1) {
+			sprintf(Errormsg,
+				"%s/%d %s ret:-1, errno=%d %s",
+				__FILE__, __LINE__, Lio_SysCall,
+				errno, strerror(errno));
+			return -errno;
+		}
+
+		if (ret != size) {
+			sprintf(Errormsg,
+				"%s/%d %s returned=%d",
+				__FILE__, __LINE__, Lio_SysCall, ret);
+		} else if (Debug_level > 1)
+			printf
+			    ("DEBUG %s/%d: io_uring read completed without error (ret %d)\n",
+			     __FILE__, __LINE__, ret);
+
+		return ret;
+	}			/* LIO_IO_URING */
+#endif
+
 	else {
 		printf("DEBUG %s/%d: No I/O method chosen\n", __FILE__,
 		       __LINE__);
@@ -3,8 +3,10 @@
  * Copyright 2019 Google LLC
  */
 
+#define _GNU_SOURCE
 #include <errno.h>
 #include <stdlib.h>
+#include <fcntl.h>
 
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
@@ -147,48 +149,24 @@ int tst_alg_setup_reqfd(const char *algtype, const char *algname,
 	return reqfd;
 }
 
-void tst_alg_sendmsg(int reqfd, const void *data, size_t datalen,
-		     const struct tst_alg_sendmsg_params *params)
+/*
+ * Fills in the control data described by params into msg, which must
+ * already point to a zeroed buffer of at least the size returned by
+ * alg_controllen().
+ */
+static void init_control(struct msghdr *msg,
+			 const struct tst_alg_sendmsg_params *params)
 {
-	struct iovec iov = {
-		.iov_base = (void *)data,
-		.iov_len = datalen,
-	};
-	struct msghdr msg = {
-		.msg_iov = &iov,
-		.msg_iovlen = 1,
-		.msg_flags = params->msg_flags,
-	};
-	size_t controllen;
-	uint8_t *control;
-	struct cmsghdr *cmsg;
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg);
 	struct af_alg_iv *alg_iv;
 
-	if (params->encrypt && params->decrypt)
-		tst_brk(TBROK, "Both encrypt and decrypt are specified");
-
-	controllen = 0;
-	if (params->encrypt || params->decrypt)
-		controllen += CMSG_SPACE(sizeof(uint32_t));
-	if (params->ivlen)
-		controllen += CMSG_SPACE(sizeof(struct af_alg_iv) +
-					 params->ivlen);
-	if (params->assoclen)
-		controllen += CMSG_SPACE(sizeof(uint32_t));
-
-	control = SAFE_MALLOC(controllen);
-	memset(control, 0, controllen);
-	msg.msg_control = control;
-	msg.msg_controllen = controllen;
-	cmsg = CMSG_FIRSTHDR(&msg);
-
 	if (params->encrypt || params->decrypt) {
 		cmsg->cmsg_level = SOL_ALG;
 		cmsg->cmsg_type = ALG_SET_OP;
 		cmsg->cmsg_len = CMSG_LEN(sizeof(uint32_t));
 		*(uint32_t *)CMSG_DATA(cmsg) =
 			params->encrypt ? ALG_OP_ENCRYPT : ALG_OP_DECRYPT;
-		cmsg = CMSG_NXTHDR(&msg, cmsg);
+		cmsg = CMSG_NXTHDR(msg, cmsg);
 	}
 	if (params->ivlen) {
 		cmsg->cmsg_level = SOL_ALG;
@@ -198,15 +176,138 @@ void tst_alg_sendmsg(int reqfd, const void *data, size_t datalen,
 		alg_iv = (struct af_alg_iv *)CMSG_DATA(cmsg);
 		alg_iv->ivlen = params->ivlen;
 		memcpy(alg_iv->iv, params->iv, params->ivlen);
-		cmsg = CMSG_NXTHDR(&msg, cmsg);
+		cmsg = CMSG_NXTHDR(msg, cmsg);
 	}
 	if (params->assoclen) {
 		cmsg->cmsg_level = SOL_ALG;
 		cmsg->cmsg_type = ALG_SET_AEAD_ASSOCLEN;
 		cmsg->cmsg_len = CMSG_LEN(sizeof(uint32_t));
 		*(uint32_t *)CMSG_DATA(cmsg) = params->assoclen;
-		cmsg = CMSG_NXTHDR(&msg, cmsg);
+		cmsg = CMSG_NXTHDR(msg, cmsg);
 	}
+}
+
+static size_t alg_controllen(const struct tst_alg_sendmsg_params *params)
+{
+	size_t controllen = 0;
+
+	if (params->encrypt && params->decrypt)
+		tst_brk(TBROK, "Both encrypt and decrypt are specified");
+
+	if (params->encrypt || params->decrypt)
+		controllen += CMSG_SPACE(sizeof(uint32_t));
+	if (params->ivlen)
+		controllen += CMSG_SPACE(sizeof(struct af_alg_iv) +
+					 params->ivlen);
+	if (params->assoclen)
+		controllen += CMSG_SPACE(sizeof(uint32_t));
+
+	return controllen;
+}
+
+void tst_alg_sendmsg(int reqfd, const void *data, size_t datalen,
+		     const struct tst_alg_sendmsg_params *params)
+{
+	struct iovec iov = {
+		.iov_base = (void *)data,
+		.iov_len = datalen,
+	};
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_flags = params->msg_flags,
+	};
+	size_t controllen = alg_controllen(params);
+	uint8_t *control;
+
+	control = SAFE_MALLOC(controllen);
+	memset(control, 0, controllen);
+	msg.msg_control = control;
+	msg.msg_controllen = controllen;
+
+	init_control(&msg, params);
 
 	SAFE_SENDMSG(datalen, reqfd, &msg, 0);
+
+	free(control);
+}
+
+void tst_alg_sendmsg_splice(int reqfd, const void *data, size_t datalen,
+			    const struct tst_alg_sendmsg_params *params)
+{
+	static int pipefd[2] = {-1, -1};
+	struct msghdr msg = {
+		.msg_flags = params->msg_flags,
+	};
+	size_t controllen = alg_controllen(params);
+	uint8_t *control;
+
+	/*
+	 * Control data cannot travel through a pipe, so it is sent via an
+	 * empty sendmsg() with MSG_MORE and the payload follows through
+	 * vmsplice()+splice() without being copied into the socket.
+	 */
+	control = SAFE_MALLOC(controllen);
+	memset(control, 0, controllen);
+	msg.msg_control = control;
+	msg.msg_controllen = controllen;
+
+	init_control(&msg, params);
+
+	SAFE_SENDMSG(0, reqfd, &msg, MSG_MORE);
+
+	free(control);
+
+	if (pipefd[0] < 0)
+		SAFE_PIPE(pipefd);
+
+	while (datalen) {
+		struct iovec iov = {
+			.iov_base = (void *)data,
+			.iov_len = datalen,
+		};
+		ssize_t chunk, ret;
+
+		chunk = vmsplice(pipefd[1], &iov, 1, 0);
+		if (chunk < 0)
+			tst_brk(TBROK | TERRNO, "vmsplice() failed");
+
+		data += chunk;
+		datalen -= chunk;
+
+		while (chunk) {
+			ret = splice(pipefd[0], NULL, reqfd, NULL, chunk,
+				     datalen ? SPLICE_F_MORE : 0);
+			if (ret < 0)
+				tst_brk(TBROK | TERRNO, "splice() failed");
+			chunk -= ret;
+		}
+	}
+}
+
+void tst_alg_pipeline(int reqfd, const void *data, size_t datalen,
+		      unsigned int nreqs, unsigned int depth, bool zerocopy,
+		      const struct tst_alg_sendmsg_params *params)
+{
+	uint8_t *resbuf = SAFE_MALLOC(datalen);
+	unsigned int sent = 0, done = 0;
+
+	if (!depth)
+		depth = 1;
+
+	while (done < nreqs) {
+		while (sent < nreqs && sent - done < depth) {
+			if (zerocopy)
+				tst_alg_sendmsg_splice(reqfd, data, datalen,
+						       params);
+			else
+				tst_alg_sendmsg(reqfd, data, datalen, params);
+			sent++;
+		}
+
+		SAFE_READ(0, reqfd, resbuf, datalen);
+		done++;
+	}
+
+	free(resbuf);
 }
@@ -12,11 +12,56 @@ struct map {
 	void *addr;
 	size_t size;
 	size_t buf_shift;
+	int in_arena;
 	struct map *next;
 };
 
 static struct map *maps;
 
+/*
+ * Buffers are carved out of one PROT_NONE arena reserved up front. Each
+ * allocation gets its data pages mprotect()ed read-write while the page
+ * after them stays PROT_NONE and acts as the guard page. That way a test
+ * looped with -i does not map and unmap a handful of regions on every
+ * iteration, it just flips page protections back and forth.
+ *
+ * Allocations that do not fit fall back to a private mapping which is
+ * munmap()ed as before.
+ */
+#define ARENA_PAGES 512
+
+static char *arena;
+static size_t arena_used;
+
+static void *arena_alloc(size_t len)
+{
+	size_t page_size = getpagesize();
+	void *ret;
+
+	if (!arena) {
+		arena = mmap(NULL, ARENA_PAGES * page_size, PROT_NONE,
+			     MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE,
+			     -1, 0);
+		if (arena == MAP_FAILED) {
+			arena = NULL;
+			return NULL;
+		}
+	}
+
+	if (arena_used + len > ARENA_PAGES * page_size)
+		return NULL;
+
+	ret = arena + arena_used;
+
+	/* the last page is left PROT_NONE and serves as the guard page */
+	if (mprotect(ret, len - page_size, PROT_READ | PROT_WRITE))
+		return NULL;
+
+	arena_used += len;
+
+	return ret;
+}
+
 static void setup_canary(struct map *map)
 {
 	size_t i;
@@ -56,10 +101,16 @@ void *tst_alloc(size_t size)
 		print_msg = 0;
 	}
 
-	ret = SAFE_MMAP(NULL, page_size * pages, PROT_READ | PROT_WRITE,
-	                MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	ret = arena_alloc(page_size * pages);
+	map->in_arena = !!ret;
+
+	if (!ret) {
+		ret = SAFE_MMAP(NULL, page_size * pages,
+				PROT_READ | PROT_WRITE,
+				MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
 
-	mprotect(ret + (pages-1) * page_size, page_size, PROT_NONE);
+		mprotect(ret + (pages-1) * page_size, page_size, PROT_NONE);
+	}
 
 	map->addr = ret;
 	map->size = pages * page_size;
@@ -134,10 +185,18 @@ void tst_free_all(void)
 	while (i) {
 		struct map *j = i;
 		check_canary(i);
-		SAFE_MUNMAP(i->addr, i->size);
+		if (!i->in_arena)
+			SAFE_MUNMAP(i->addr, i->size);
 		i = i->next;
 		free(j);
 	}
 
 	maps = NULL;
+
+	if (arena_used) {
+		/* drop the pages so the next iteration starts zeroed again */
+		mprotect(arena, arena_used, PROT_NONE);
+		madvise(arena, arena_used, MADV_DONTNEED);
+		arena_used = 0;
+	}
 }
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "tst_cache.h"
+
+#define BOOT_ID_PATH "/proc/sys/kernel/random/boot_id"
+#define BOOT_ID_LEN 37
+
+/*
+ * This code runs with both the old and the new library and also before the
+ * test library is fully set up, hence it must not report errors or exit,
+ * everything that goes wrong is silently treated as a cache miss.
+ */
+
+static const char *get_boot_id(void)
+{
+	static char boot_id[BOOT_ID_LEN];
+	int fd;
+	ssize_t len;
+
+	if (boot_id[0])
+		return boot_id;
+
+	fd = open(BOOT_ID_PATH, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	len = read(fd, boot_id, sizeof(boot_id) - 1);
+	close(fd);
+
+	if (len <= 0) {
+		boot_id[0] = '\0';
+		return NULL;
+	}
+
+	if (boot_id[len - 1] == '\n')
+		len--;
+	boot_id[len] = '\0';
+
+	return boot_id;
+}
+
+static int get_entry_path(const char *key, char *path, size_t path_len)
+{
+	const char *dir = getenv("LTP_CACHE_DIR");
+	const char *boot_id;
+	int ret;
+
+	if (!dir)
+		return -1;
+
+	boot_id = get_boot_id();
+	if (!boot_id)
+		return -1;
+
+	ret = snprintf(path, path_len, "%s/%s-%s", dir, boot_id, key);
+	if (ret < 0 || (size_t)ret >= path_len)
+		return -1;
+
+	return 0;
+}
+
+int tst_cache_file_path(const char *key, char *path, size_t path_len)
+{
+	return get_entry_path(key, path, path_len);
+}
+
+int tst_cache_get(const char *key, char *buf, size_t buf_len)
+{
+	char path[PATH_MAX];
+	int fd;
+	ssize_t len;
+
+	if (get_entry_path(key, path, sizeof(path)))
+		return -1;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	len = read(fd, buf, buf_len - 1);
+	close(fd);
+
+	if (len < 0)
+		return -1;
+
+	buf[len] = '\0';
+
+	return 0;
+}
+
+int tst_cache_put(const char *key, const char *value)
+{
+	char path[PATH_MAX];
+	char tmp_path[PATH_MAX];
+	size_t len = strlen(value);
+	int ret, fd;
+
+	if (get_entry_path(key, path, sizeof(path)))
+		return -1;
+
+	ret = snprintf(tmp_path, sizeof(tmp_path), "%s.%i", path, getpid());
+	if (ret < 0 || (size_t)ret >= sizeof(tmp_path))
+		return -1;
+
+	fd = open(tmp_path, O_CREAT | O_WRONLY | O_TRUNC, 0666);
+	if (fd < 0)
+		return -1;
+
+	if (write(fd, value, len) != (ssize_t)len) {
+		close(fd);
+		unlink(tmp_path);
+		return -1;
+	}
+
+	close(fd);
+
+	/* atomic so that concurrent readers never see a partial value */
+	if (rename(tmp_path, path)) {
+		unlink(tmp_path);
+		return -1;
+	}
+
+	return 0;
+}
+
+int tst_cache_get_int(const char *key, int *val)
+{
+	char buf[32];
+
+	if (tst_cache_get(key, buf, sizeof(buf)))
+		return -1;
+
+	if (sscanf(buf, "%i", val) != 1)
+		return -1;
+
+	return 0;
+}
+
+int tst_cache_put_int(const char *key, int val)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%i", val);
+
+	return tst_cache_put(key, buf);
+}
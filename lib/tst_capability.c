@@ -11,6 +11,16 @@
 
 #include "lapi/syscalls.h"
 
+/*
+ * Cached copy of the current thread's capability sets, so that repeated
+ * tst_cap_action()/tst_cap_setup() calls (iterated tests reapply their
+ * capability changes in every iteration) don't pay a capget() each. The
+ * cache follows changes made through tst_capset() and is keyed by the
+ * thread id so a fork or another thread never sees stale state.
+ */
+static struct tst_cap_user_data state_cache[2];
+static int state_cache_tid = -1;
+
 int tst_capget(struct tst_cap_user_header *hdr,
 	       struct tst_cap_user_data *data)
 {
@@ -20,7 +30,30 @@ int tst_capget(struct tst_cap_user_header *hdr,
 int tst_capset(struct tst_cap_user_header *hdr,
 	       const struct tst_cap_user_data *data)
 {
-	return tst_syscall(__NR_capset, hdr, data);
+	int ret = tst_syscall(__NR_capset, hdr, data);
+	int tid = tst_syscall(__NR_gettid);
+
+	if (!ret && (hdr->pid == tid || !hdr->pid) && state_cache_tid == tid)
+		memcpy(state_cache, data, sizeof(state_cache));
+	else
+		state_cache_tid = -1;
+
+	return ret;
+}
+
+static void cap_state_read(struct tst_cap_user_header *hdr,
+			   struct tst_cap_user_data *data)
+{
+	if (hdr->pid == state_cache_tid) {
+		memcpy(data, state_cache, sizeof(state_cache));
+		return;
+	}
+
+	if (tst_capget(hdr, data))
+		tst_brk(TBROK | TTERRNO, "tst_capget()");
+
+	memcpy(state_cache, data, sizeof(state_cache));
+	state_cache_tid = hdr->pid;
 }
 
 static void do_cap_drop(uint32_t *set, uint32_t mask, const struct tst_cap *cap)
@@ -43,25 +76,14 @@ static void do_cap_req(uint32_t *permitted, uint32_t *effective, uint32_t mask,
 	}
 }
 
-void tst_cap_action(struct tst_cap *cap)
+static void do_cap_apply(struct tst_cap_user_data *new,
+			 const struct tst_cap *cap)
 {
-	struct tst_cap_user_header hdr = {
-		.version = 0x20080522,
-		.pid = tst_syscall(__NR_gettid),
-	};
-	struct tst_cap_user_data cur[2] = { {0} };
-	struct tst_cap_user_data new[2] = { {0} };
-	uint32_t act = cap->action;
 	uint32_t *pE = &new[CAP_TO_INDEX(cap->id)].effective;
 	uint32_t *pP = &new[CAP_TO_INDEX(cap->id)].permitted;
 	uint32_t mask = CAP_TO_MASK(cap->id);
 
-	if (tst_capget(&hdr, cur))
-		tst_brk(TBROK | TTERRNO, "tst_capget()");
-
-	memcpy(new, cur, sizeof(new));
-
-	switch (act) {
+	switch (cap->action) {
 	case TST_CAP_DROP:
 		do_cap_drop(pE, mask, cap);
 		break;
@@ -71,6 +93,22 @@ void tst_cap_action(struct tst_cap *cap)
 	default:
 		tst_brk(TBROK, "Unrecognised action %d", cap->action);
 	}
+}
+
+void tst_cap_action(struct tst_cap *cap)
+{
+	struct tst_cap_user_header hdr = {
+		.version = 0x20080522,
+		.pid = tst_syscall(__NR_gettid),
+	};
+	struct tst_cap_user_data cur[2] = { {0} };
+	struct tst_cap_user_data new[2] = { {0} };
+
+	cap_state_read(&hdr, cur);
+
+	memcpy(new, cur, sizeof(new));
+
+	do_cap_apply(new, cap);
 
 	if (!memcmp(cur, new, sizeof(new)))
 		return;
@@ -81,10 +119,30 @@ void tst_cap_action(struct tst_cap *cap)
 
 void tst_cap_setup(struct tst_cap *caps, unsigned int action_mask)
 {
+	struct tst_cap_user_header hdr = {
+		.version = 0x20080522,
+		.pid = tst_syscall(__NR_gettid),
+	};
+	struct tst_cap_user_data cur[2] = { {0} };
+	struct tst_cap_user_data new[2] = { {0} };
 	struct tst_cap *cap;
 
+	cap_state_read(&hdr, cur);
+
+	memcpy(new, cur, sizeof(new));
+
+	/*
+	 * All the actions are composed into one state so that the whole
+	 * list costs a single capset() no matter how long it is.
+	 */
 	for (cap = caps; cap->action; cap++) {
 		if (cap->action & action_mask)
-			tst_cap_action(cap);
+			do_cap_apply(new, cap);
 	}
+
+	if (!memcmp(cur, new, sizeof(new)))
+		return;
+
+	if (tst_capset(&hdr, new))
+		tst_brk(TBROK | TERRNO, "tst_capset()");
 }
@@ -62,6 +62,56 @@ out:
         return cg_ver;
 }
 
+/*
+ * Looks for an existing mount of the wanted cgroup filesystem in
+ * /proc/mounts, so that a hierarchy set up by the system or by the test
+ * runner (advertised simply by being mounted) can be leased with a
+ * single mkdir instead of a discovery and mount cycle per test. For v1
+ * the controller name has to be present in the mount options.
+ *
+ * Only used with LTP_CGROUP_REUSE=1 since tests inherit whatever
+ * configuration the existing hierarchy has.
+ */
+static int tst_cgroup_find_mount(const char *fstype, const char *option,
+				 char *buf, size_t buf_len)
+{
+	char line[PATH_MAX];
+	char path[PATH_MAX], type[64], opts[256];
+	FILE *file;
+	int found = 0;
+
+	file = SAFE_FOPEN("/proc/mounts", "r");
+
+	while (fgets(line, sizeof(line), file)) {
+		if (sscanf(line, "%*s %s %63s %255s", path, type, opts) != 3)
+			continue;
+
+		if (strcmp(type, fstype))
+			continue;
+
+		if (option) {
+			char *tok, *state;
+
+			for (tok = strtok_r(opts, ",", &state); tok;
+			     tok = strtok_r(NULL, ",", &state)) {
+				if (!strcmp(tok, option))
+					break;
+			}
+
+			if (!tok)
+				continue;
+		}
+
+		snprintf(buf, buf_len, "%s", path);
+		found = 1;
+		break;
+	}
+
+	SAFE_FCLOSE(file);
+
+	return found;
+}
+
 static void tst_cgroup1_mount(const char *name, const char *option,
 			const char *mnt_path, const char *new_path)
 {
@@ -122,7 +172,8 @@ out:
 	tst_res(TINFO, "Cgroup v2 mount at %s success", mnt_path);
 }
 
-static void tst_cgroupN_umount(const char *mnt_path, const char *new_path)
+static void tst_cgroupN_umount(const char *mnt_path, const char *new_path,
+			       int leased)
 {
 	FILE *fp;
 	int fd;
@@ -169,6 +220,11 @@ static void tst_cgroupN_umount(const char *mnt_path, const char *new_path)
 		fclose(fp);
 	if (rmdir(new_path) == -1)
 		tst_res(TWARN | TERRNO, "rmdir %s", new_path);
+
+	/* A leased hierarchy stays mounted for the rest of the run */
+	if (leased)
+		return;
+
 	if (umount(mnt_path) == -1)
 		tst_res(TWARN | TERRNO, "umount %s", mnt_path);
 	if (rmdir(mnt_path) == -1)
@@ -182,26 +238,28 @@ static void tst_cgroupN_umount(const char *mnt_path, const char *new_path)
 
 struct tst_cgroup_path {
 	char *mnt_path;
+	char *real_path;
 	char *new_path;
+	int leased;
 	struct tst_cgroup_path *next;
 };
 
 static struct tst_cgroup_path *tst_cgroup_paths;
 
-static void tst_cgroup_set_path(const char *cgroup_dir)
+static void tst_cgroup_set_path(const char *cgroup_dir, const char *real_dir,
+				int leased)
 {
-	char cgroup_new_dir[PATH_MAX];
 	struct tst_cgroup_path *tst_cgroup_path, *a;
 
 	if (!cgroup_dir)
 		tst_brk(TBROK, "Invalid cgroup dir, plese check cgroup_dir");
 
-	sprintf(cgroup_new_dir, "%s/ltp_%d", cgroup_dir, rand());
-
 	/* To store cgroup path in the 'path' list */
 	tst_cgroup_path = SAFE_MALLOC(sizeof(struct tst_cgroup_path));
 	tst_cgroup_path->mnt_path = SAFE_MALLOC(strlen(cgroup_dir) + 1);
-	tst_cgroup_path->new_path = SAFE_MALLOC(strlen(cgroup_new_dir) + 1);
+	tst_cgroup_path->real_path = SAFE_MALLOC(strlen(real_dir) + 1);
+	tst_cgroup_path->new_path = SAFE_MALLOC(strlen(real_dir) + 32);
+	tst_cgroup_path->leased = leased;
 	tst_cgroup_path->next = NULL;
 
 	if (!tst_cgroup_paths) {
@@ -218,10 +276,11 @@ static void tst_cgroup_set_path(const char *cgroup_dir)
 	}
 
 	sprintf(tst_cgroup_path->mnt_path, "%s", cgroup_dir);
-	sprintf(tst_cgroup_path->new_path, "%s", cgroup_new_dir);
+	sprintf(tst_cgroup_path->real_path, "%s", real_dir);
+	sprintf(tst_cgroup_path->new_path, "%s/ltp_%d", real_dir, rand());
 }
 
-static char *tst_cgroup_get_path(const char *cgroup_dir)
+static struct tst_cgroup_path *tst_cgroup_get_entry(const char *cgroup_dir)
 {
 	struct tst_cgroup_path *a;
 
@@ -238,7 +297,14 @@ static char *tst_cgroup_get_path(const char *cgroup_dir)
 		a = a->next;
 	};
 
-	return a->new_path;
+	return a;
+}
+
+static char *tst_cgroup_get_path(const char *cgroup_dir)
+{
+	struct tst_cgroup_path *a = tst_cgroup_get_entry(cgroup_dir);
+
+	return a ? a->new_path : NULL;
 }
 
 static void tst_cgroup_del_path(const char *cgroup_dir)
@@ -265,6 +331,7 @@ static void tst_cgroup_del_path(const char *cgroup_dir)
 		a->next = b->next;
 
 	free(b->mnt_path);
+	free(b->real_path);
 	free(b->new_path);
 	free(b);
 }
@@ -273,13 +340,57 @@ void tst_cgroup_mount(enum tst_cgroup_ctrl ctrl, const char *cgroup_dir)
 {
 	char *cgroup_new_dir;
 	char knob_path[PATH_MAX];
+	char real_dir[PATH_MAX];
+	const char *option = NULL;
+	const char *env = getenv("LTP_CGROUP_REUSE");
+	int leased = 0;
 
 	tst_cg_ver = tst_cgroup_version();
 
-	tst_cgroup_set_path(cgroup_dir);
+	if (tst_cg_ver & TST_CGROUP_V1) {
+		switch(ctrl) {
+		case TST_CGROUP_MEMCG:
+			option = "memory";
+		break;
+		case TST_CGROUP_CPUSET:
+			option = "cpuset";
+		break;
+		default:
+			tst_brk(TBROK, "Invalid cgroup controller: %d", ctrl);
+		}
+	}
+
+	if (env && atoi(env)) {
+		if (tst_cg_ver & TST_CGROUP_V1)
+			leased = tst_cgroup_find_mount("cgroup", option,
+						       real_dir, sizeof(real_dir));
+		if (tst_cg_ver & TST_CGROUP_V2)
+			leased = tst_cgroup_find_mount("cgroup2", NULL,
+						       real_dir, sizeof(real_dir));
+	}
+
+	if (!leased)
+		snprintf(real_dir, sizeof(real_dir), "%s", cgroup_dir);
+
+	tst_cgroup_set_path(cgroup_dir, real_dir, leased);
 	cgroup_new_dir = tst_cgroup_get_path(cgroup_dir);
 
-	if (tst_cg_ver & TST_CGROUP_V1) {
+	if (leased) {
+		tst_res(TINFO, "Reusing cgroup hierarchy mounted at %s",
+			real_dir);
+
+		if ((tst_cg_ver & TST_CGROUP_V1) &&
+		    ctrl == TST_CGROUP_CPUSET) {
+			sprintf(knob_path, "%s/cgroup.clone_children",
+				real_dir);
+			SAFE_FILE_SCANF(knob_path, "%d", &clone_children);
+			SAFE_FILE_PRINTF(knob_path, "%d", 1);
+		}
+
+		/* a crashed previous test may have left the dir behind */
+		if (mkdir(cgroup_new_dir, 0777) == -1 && errno != EEXIST)
+			tst_brk(TBROK | TERRNO, "mkdir %s", cgroup_new_dir);
+	} else if (tst_cg_ver & TST_CGROUP_V1) {
 		switch(ctrl) {
 		case TST_CGROUP_MEMCG:
 			tst_cgroup1_mount("memcg", "memory", cgroup_dir, cgroup_new_dir);
@@ -293,11 +404,12 @@ void tst_cgroup_mount(enum tst_cgroup_ctrl ctrl, const char *cgroup_dir)
 	}
 
 	if (tst_cg_ver & TST_CGROUP_V2) {
-		tst_cgroup2_mount(cgroup_dir, cgroup_new_dir);
+		if (!leased)
+			tst_cgroup2_mount(cgroup_dir, cgroup_new_dir);
 
 		switch(ctrl) {
 		case TST_CGROUP_MEMCG:
-			sprintf(knob_path, "%s/cgroup.subtree_control", cgroup_dir);
+			sprintf(knob_path, "%s/cgroup.subtree_control", real_dir);
 			SAFE_FILE_PRINTF(knob_path, "%s", "+memory");
 		break;
 		case TST_CGROUP_CPUSET:
@@ -309,12 +421,64 @@ void tst_cgroup_mount(enum tst_cgroup_ctrl ctrl, const char *cgroup_dir)
 	}
 }
 
+/*
+ * Emits the accumulated accounting of the test's cgroup before it goes
+ * away, one machine-parseable line per counter, in the same LTP_RUSAGE
+ * opt-in stream as the per-child rusage records printed by the library.
+ * Only the counters the mounted controller exposes are reported; the
+ * rest is skipped silently.
+ */
+static void tst_cgroup_print_stats(const char *cgroup_dir,
+				   const char *cgroup_new_dir)
+{
+	static const char *const stat_knobs[] = {
+		"memory.max_usage_in_bytes",
+		"memory.memsw.max_usage_in_bytes",
+		"memory.current",
+		"memory.peak",
+		"cpuacct.usage",
+	};
+	char knob_path[PATH_MAX];
+	char buf[64];
+	unsigned int i;
+	int fd;
+	ssize_t len;
+
+	if (!getenv("LTP_RUSAGE"))
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(stat_knobs); i++) {
+		sprintf(knob_path, "%s/%s", cgroup_new_dir, stat_knobs[i]);
+
+		fd = open(knob_path, O_RDONLY);
+		if (fd == -1)
+			continue;
+
+		len = read(fd, buf, sizeof(buf) - 1);
+		close(fd);
+
+		if (len <= 0)
+			continue;
+
+		if (buf[len - 1] == '\n')
+			len--;
+		buf[len] = '\0';
+
+		tst_res(TINFO, "cgroup '%s': %s=%s",
+			cgroup_dir, stat_knobs[i], buf);
+	}
+}
+
 void tst_cgroup_umount(const char *cgroup_dir)
 {
-	char *cgroup_new_dir;
+	struct tst_cgroup_path *path = tst_cgroup_get_entry(cgroup_dir);
 
-	cgroup_new_dir = tst_cgroup_get_path(cgroup_dir);
-	tst_cgroupN_umount(cgroup_dir, cgroup_new_dir);
+	if (!path)
+		return;
+
+	tst_cgroup_print_stats(cgroup_dir, path->new_path);
+
+	tst_cgroupN_umount(path->real_path, path->new_path, path->leased);
 	tst_cgroup_del_path(cgroup_dir);
 }
 
@@ -36,6 +36,26 @@
 futex_t *tst_futexes;
 unsigned int tst_max_futexes;
 
+/*
+ * The futex area is split in half: the first half holds the futex words
+ * and the second half a waiter counter per checkpoint id. The counter
+ * tells the waker whether anybody can actually be woken, so a rendezvous
+ * where all the children arrived first is a single FUTEX_WAKE call
+ * instead of a wake/sleep polling loop.
+ *
+ * The counter is only a hint; a process killed inside the wait leaves it
+ * incremented, which at worst causes a futile wake syscall later on.
+ */
+static inline unsigned int checkpoint_ids(void)
+{
+	return tst_max_futexes / 2;
+}
+
+static inline futex_t *checkpoint_waiters(unsigned int id)
+{
+	return &tst_futexes[checkpoint_ids() + id];
+}
+
 void tst_checkpoint_init(const char *file, const int lineno,
                          void (*cleanup_fn)(void))
 {
@@ -84,9 +104,9 @@ void tst_checkpoint_init(const char *file, const int lineno,
 int tst_checkpoint_wait(unsigned int id, unsigned int msec_timeout)
 {
 	struct timespec timeout;
-	int ret;
+	int ret, err;
 
-	if (id >= tst_max_futexes) {
+	if (id >= checkpoint_ids()) {
 		errno = EOVERFLOW;
 		return -1;
 	}
@@ -94,35 +114,55 @@ int tst_checkpoint_wait(unsigned int id, unsigned int msec_timeout)
 	timeout.tv_sec = msec_timeout/1000;
 	timeout.tv_nsec = (msec_timeout%1000) * 1000000;
 
+	__atomic_add_fetch(checkpoint_waiters(id), 1, __ATOMIC_SEQ_CST);
+
 	do {
 		ret = syscall(SYS_futex, &tst_futexes[id], FUTEX_WAIT,
 			      tst_futexes[id], &timeout);
 	} while (ret == -1 && errno == EINTR);
 
+	err = errno;
+	__atomic_sub_fetch(checkpoint_waiters(id), 1, __ATOMIC_SEQ_CST);
+	errno = err;
+
 	return ret;
 }
 
 int tst_checkpoint_wake(unsigned int id, unsigned int nr_wake,
                         unsigned int msec_timeout)
 {
-	unsigned int msecs = 0, waked = 0;
+	unsigned int waked = 0, sleep_us = 1;
+	unsigned long long slept_us = 0;
 
-	if (id >= tst_max_futexes) {
+	if (id >= checkpoint_ids()) {
 		errno = EOVERFLOW;
 		return -1;
 	}
 
 	for (;;) {
-		waked += syscall(SYS_futex, &tst_futexes[id], FUTEX_WAKE,
-				 INT_MAX, NULL);
+		/*
+		 * Only issue the syscall when the counter shows somebody
+		 * is waiting; when all nr_wake processes arrived before us
+		 * this is a single wake-them-all call.
+		 */
+		if (__atomic_load_n(checkpoint_waiters(id), __ATOMIC_SEQ_CST))
+			waked += syscall(SYS_futex, &tst_futexes[id],
+					 FUTEX_WAKE, INT_MAX, NULL);
 
 		if (waked == nr_wake)
 			break;
 
-		usleep(1000);
-		msecs++;
+		/*
+		 * Back off exponentially while the stragglers arrive, from
+		 * one microsecond up to the old one millisecond polling.
+		 */
+		usleep(sleep_us);
+		slept_us += sleep_us;
+
+		if (sleep_us < 1000)
+			sleep_us *= 2;
 
-		if (msecs >= msec_timeout) {
+		if (slept_us >= 1000ull * msec_timeout) {
 			errno = ETIMEDOUT;
 			return -1;
 		}
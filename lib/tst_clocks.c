@@ -9,11 +9,28 @@
 #include "tst_test.h"
 #include "tst_timer.h"
 #include "tst_clocks.h"
+#include "parse_vdso.h"
 #include "lapi/syscalls.h"
 #include "lapi/posix_clocks.h"
 
 typedef int (*mysyscall)(clockid_t clk_id, void *ts);
 
+/*
+ * Provided by libltpvdso. The reference is weak so that the library does
+ * not force every test to link against it; tst_clock_gettime_fast()
+ * falls back to the syscall when it is absent. Tests wanting the vDSO
+ * path add to their Makefile:
+ *
+ *   LTPLIBS = ltpvdso
+ *   LTPLDLIBS = -Wl,-u,find_clock_gettime_vdso -lltpvdso
+ *
+ * (the -u is needed to pull the object out of the static archive, a
+ * weak reference alone does not).
+ */
+extern void find_clock_gettime_vdso(gettime_t *ptr_vdso_gettime,
+				    gettime_t *ptr_vdso_gettime64)
+	__attribute__((weak));
+
 int syscall_supported_by_kernel(long sysnr)
 {
 	int ret;
@@ -85,6 +102,46 @@ int tst_clock_gettime(clockid_t clk_id, struct timespec *ts)
 	return ret;
 }
 
+int tst_clock_gettime_fast(clockid_t clk_id, struct timespec *ts)
+{
+	static struct tst_ts tts = { 0, };
+	static gettime_t func;
+	static int initialized;
+	int ret;
+
+	if (!initialized) {
+		gettime_t vdso_gettime = NULL, vdso_gettime64 = NULL;
+
+		if (find_clock_gettime_vdso) {
+			find_clock_gettime_vdso(&vdso_gettime,
+						&vdso_gettime64);
+		}
+
+		if (vdso_gettime64) {
+			func = vdso_gettime64;
+			tts.type = TST_KERN_TIMESPEC;
+		} else if (vdso_gettime) {
+			func = vdso_gettime;
+			tts.type = TST_KERN_OLD_TIMESPEC;
+		}
+
+		initialized = 1;
+	}
+
+	if (!func)
+		return tst_clock_gettime(clk_id, ts);
+
+	ret = func(clk_id, tst_ts_get(&tts));
+
+	/* the vDSO does not implement all clock ids */
+	if (ret)
+		return tst_clock_gettime(clk_id, ts);
+
+	ts->tv_sec = tst_ts_get_sec(tts);
+	ts->tv_nsec = tst_ts_get_nsec(tts);
+	return 0;
+}
+
 int tst_clock_settime(clockid_t clk_id, struct timespec *ts)
 {
 	static struct tst_ts tts = { 0, };
@@ -26,9 +26,12 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <signal.h>
+#include <spawn.h>
 #include "test.h"
 #include "tst_cmd.h"
 
+extern char **environ;
+
 #define OPEN_MODE	(S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)
 #define OPEN_FLAGS	(O_WRONLY | O_APPEND | O_CREAT)
 
@@ -66,27 +69,35 @@ int tst_cmd_fds_(void (cleanup_fn)(void),
 			return 255;
 	}
 
-	pid_t pid = vfork();
-	if (pid == -1) {
-		tst_brkm(TBROK | TERRNO, cleanup_fn, "vfork failed at %s:%d",
+	/*
+	 * posix_spawn() avoids duplicating the caller's address space, which
+	 * gets expensive for tests with a large memory footprint even with
+	 * copy-on-write, since the page tables still have to be copied.
+	 *
+	 * The stdout and stderr redirections are expressed as file actions.
+	 */
+	posix_spawn_file_actions_t fa;
+	posix_spawn_file_actions_init(&fa);
+
+	if (stdout_fd != -1)
+		posix_spawn_file_actions_adddup2(&fa, stdout_fd, STDOUT_FILENO);
+
+	if (stderr_fd != -1)
+		posix_spawn_file_actions_adddup2(&fa, stderr_fd, STDERR_FILENO);
+
+	pid_t pid;
+	int err = posix_spawn(&pid, path, &fa, NULL, (char *const *)argv,
+			      environ);
+
+	posix_spawn_file_actions_destroy(&fa);
+
+	if (err) {
+		errno = err;
+		tst_brkm(TBROK | TERRNO, cleanup_fn,
+			"posix_spawn '%s' failed at %s:%d", argv[0],
 			__FILE__, __LINE__);
 		return -1;
 	}
-	if (!pid) {
-		/* redirecting stdout and stderr if needed */
-		if (stdout_fd != -1) {
-			close(STDOUT_FILENO);
-			dup2(stdout_fd, STDOUT_FILENO);
-		}
-
-		if (stderr_fd != -1) {
-			close(STDERR_FILENO);
-			dup2(stderr_fd, STDERR_FILENO);
-		}
-
-		execvp(argv[0], (char *const *)argv);
-		_exit(254);
-	}
 
 	int ret = -1;
 	if (waitpid(pid, &ret, 0) != pid) {
@@ -7,9 +7,25 @@
 
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "tst_test.h"
 #include "tst_coredump.h"
+#include "tst_clocks.h"
+#include "tst_timer.h"
+#include "lapi/syscalls.h"
+
+#ifndef P_PIDFD
+# define P_PIDFD 3
+#endif
+
+#define CORE_PATTERN "/proc/sys/kernel/core_pattern"
+
+static int inotify_fd = -1;
 
 void tst_no_corefile(int verbose)
 {
@@ -33,3 +49,103 @@ void tst_no_corefile(int verbose)
 		}
 	}
 }
+
+void tst_enable_coredumps(void)
+{
+	struct rlimit r = {RLIM_INFINITY, RLIM_INFINITY};
+	char cwd[PATH_MAX - 16];
+
+	SAFE_SETRLIMIT(RLIMIT_CORE, &r);
+
+	SAFE_GETCWD(cwd, sizeof(cwd));
+	SAFE_FILE_PRINTF(CORE_PATTERN, "%s/core-%%p", cwd);
+
+	/*
+	 * The watch exists before any crash can happen, so the close
+	 * event for the dump cannot be missed. IN_MOVED_TO covers core
+	 * helpers that write to a temporary name first.
+	 */
+	if (inotify_fd != -1)
+		SAFE_CLOSE(inotify_fd);
+
+	inotify_fd = inotify_init1(IN_CLOEXEC);
+	if (inotify_fd == -1)
+		tst_brk(TBROK | TERRNO, "inotify_init1() failed");
+
+	if (inotify_add_watch(inotify_fd, cwd,
+			      IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+		tst_brk(TBROK | TERRNO, "inotify_add_watch(%s) failed", cwd);
+}
+
+int tst_wait_coredump(pid_t pid, char *path, size_t path_size,
+		      int timeout_ms)
+{
+	char name[32], buf[4096]
+		__attribute__((aligned(__alignof__(struct inotify_event))));
+	struct inotify_event *ev;
+	struct pollfd pfd = {.fd = inotify_fd, .events = POLLIN};
+	struct timespec start, now;
+	long long elapsed_ms;
+	ssize_t len, i;
+	int ret;
+
+	if (inotify_fd == -1)
+		tst_brk(TBROK, "Call tst_enable_coredumps() first");
+
+	snprintf(name, sizeof(name), "core-%d", (int)pid);
+	tst_clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (;;) {
+		tst_clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed_ms = tst_timespec_diff_ms(now, start);
+		if (elapsed_ms >= timeout_ms) {
+			tst_brk(TBROK, "Timeout waiting for coredump of %d",
+				(int)pid);
+		}
+
+		ret = poll(&pfd, 1, timeout_ms - elapsed_ms);
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			tst_brk(TBROK | TERRNO, "poll() failed");
+		}
+
+		if (!ret) {
+			tst_brk(TBROK, "Timeout waiting for coredump of %d",
+				(int)pid);
+		}
+
+		len = SAFE_READ(0, inotify_fd, buf, sizeof(buf));
+
+		for (i = 0; i < len; i += sizeof(*ev) + ev->len) {
+			ev = (struct inotify_event *)(buf + i);
+
+			if (ev->len && !strcmp(ev->name, name)) {
+				snprintf(path, path_size, "%s", name);
+				return 0;
+			}
+		}
+	}
+}
+
+void tst_reap_crasher(pid_t pid, siginfo_t *info)
+{
+	struct pollfd pfd = {.events = POLLIN};
+
+	pfd.fd = tst_syscall(__NR_pidfd_open, pid, 0);
+
+	/*
+	 * Waiting on the pidfd rather than the PID cannot race with
+	 * PID reuse and keeps the child around until we have looked
+	 * at its exit status.
+	 */
+	while (poll(&pfd, 1, -1) == -1) {
+		if (errno != EINTR)
+			tst_brk(TBROK | TERRNO, "poll() failed");
+	}
+
+	if (waitid(P_PIDFD, pfd.fd, info, WEXITED))
+		tst_brk(TBROK | TERRNO, "waitid(P_PIDFD, %d) failed", pfd.fd);
+
+	SAFE_CLOSE(pfd.fd);
+}
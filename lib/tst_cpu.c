@@ -17,9 +17,13 @@
  *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include "test.h"
+#include "tst_cpu.h"
 #include "safe_macros.h"
 
 long tst_ncpus(void)
@@ -71,3 +75,113 @@ long tst_ncpus_max(void)
 	}
 	return ncpus_max;
 }
+
+static struct tst_cpu_info *cpu_info;
+static int cpu_info_len = -1;
+
+static int read_topology_id(int cpu, const char *what)
+{
+	char path[PATH_MAX];
+	FILE *f;
+	int val;
+
+	snprintf(path, sizeof(path),
+		 "/sys/devices/system/cpu/cpu%i/topology/%s", cpu, what);
+
+	f = fopen(path, "r");
+	if (!f)
+		return -1;
+
+	if (fscanf(f, "%i", &val) != 1)
+		val = -1;
+
+	fclose(f);
+	return val;
+}
+
+int tst_cpu_topology(const struct tst_cpu_info **cpus)
+{
+	long ncpus_max;
+	cpu_set_t *mask;
+	size_t mask_size;
+	int cpu, id;
+
+	if (cpu_info_len >= 0)
+		goto done;
+
+	ncpus_max = tst_ncpus_max();
+
+	mask = CPU_ALLOC(ncpus_max);
+	if (!mask)
+		return -1;
+
+	mask_size = CPU_ALLOC_SIZE(ncpus_max);
+
+	if (sched_getaffinity(0, mask_size, mask)) {
+		CPU_FREE(mask);
+		return -1;
+	}
+
+	cpu_info = malloc(ncpus_max * sizeof(*cpu_info));
+	if (!cpu_info) {
+		CPU_FREE(mask);
+		return -1;
+	}
+
+	cpu_info_len = 0;
+
+	for (cpu = 0; cpu < ncpus_max; cpu++) {
+		if (!CPU_ISSET_S(cpu, mask_size, mask))
+			continue;
+
+		cpu_info[cpu_info_len].id = cpu;
+
+		/*
+		 * Missing topology directory (old kernel or
+		 * CONFIG_SMP=n) degrades to one core per CPU.
+		 */
+		id = read_topology_id(cpu, "core_id");
+		cpu_info[cpu_info_len].core_id = id >= 0 ? id : cpu;
+
+		id = read_topology_id(cpu, "physical_package_id");
+		cpu_info[cpu_info_len].package_id = id >= 0 ? id : 0;
+
+		cpu_info_len++;
+	}
+
+	CPU_FREE(mask);
+
+done:
+	if (cpus)
+		*cpus = cpu_info;
+
+	return cpu_info_len;
+}
+
+static int same_core(const struct tst_cpu_info *a, const struct tst_cpu_info *b)
+{
+	return a->package_id == b->package_id && a->core_id == b->core_id;
+}
+
+int tst_cpu_pick_isolated_pair(int *cpu_a, int *cpu_b)
+{
+	const struct tst_cpu_info *cpus;
+	int ncpus, i, j;
+
+	ncpus = tst_cpu_topology(&cpus);
+	if (ncpus < 0)
+		return -1;
+
+	for (i = 0; i < ncpus; i++) {
+		for (j = i + 1; j < ncpus; j++) {
+			if (same_core(&cpus[i], &cpus[j]))
+				continue;
+
+			*cpu_a = cpus[i].id;
+			*cpu_b = cpus[j].id;
+			return 0;
+		}
+	}
+
+	return -1;
+}
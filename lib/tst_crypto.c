@@ -6,6 +6,7 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
@@ -80,6 +81,140 @@ int tst_crypto_add_alg(struct tst_crypto_session *ses,
 	return tst_crypto_recv_ack(ses);
 }
 
+void tst_crypto_batch_begin(struct tst_crypto_session *ses)
+{
+	if (ses->batch)
+		tst_brk(TBROK, "Crypto batch already in progress");
+
+	ses->batch = TST_NETLINK_BATCH_START(ses->fd);
+}
+
+static void crypto_queue_msg(struct tst_crypto_session *ses, uint16_t type,
+			     const struct crypto_user_alg *alg)
+{
+	struct nlmsghdr nh = {
+		.nlmsg_len = sizeof(struct nlmsghdr) + sizeof(*alg),
+		.nlmsg_type = type,
+		.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK,
+	};
+
+	if (!ses->batch)
+		tst_brk(TBROK, "No crypto batch in progress");
+
+	TST_NETLINK_BATCH_ADD(ses->batch, &nh, alg);
+}
+
+void tst_crypto_add_alg_queued(struct tst_crypto_session *ses,
+			       const struct crypto_user_alg *alg)
+{
+	crypto_queue_msg(ses, CRYPTO_MSG_NEWALG, alg);
+}
+
+void tst_crypto_del_alg_queued(struct tst_crypto_session *ses,
+			       const struct crypto_user_alg *alg)
+{
+	crypto_queue_msg(ses, CRYPTO_MSG_DELALG, alg);
+}
+
+int tst_crypto_batch_commit(struct tst_crypto_session *ses)
+{
+	int ret;
+
+	if (!ses->batch)
+		tst_brk(TBROK, "No crypto batch in progress");
+
+	ret = TST_NETLINK_BATCH_SEND(ses->batch);
+
+	TST_NETLINK_BATCH_FREE(ses->batch);
+	ses->batch = NULL;
+
+	return ret;
+}
+
+static struct crypto_user_alg *alg_snapshot;
+static unsigned int alg_snapshot_count;
+static int alg_snapshot_valid;
+
+static void fetch_alg_snapshot(struct tst_crypto_session *ses)
+{
+	struct crypto_user_alg req;
+	struct nlmsghdr nh = {
+		.nlmsg_len = sizeof(struct nlmsghdr) + sizeof(req),
+		.nlmsg_type = CRYPTO_MSG_GETALG,
+		.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP,
+		.nlmsg_seq = ++(ses->seq_num),
+		.nlmsg_pid = 0,
+	};
+	unsigned int capacity = 64;
+	char buf[BUFSIZ];
+	int done = 0;
+
+	memset(&req, 0, sizeof(req));
+
+	SAFE_NETLINK_SEND(ses->fd, &nh, &req);
+
+	alg_snapshot_count = 0;
+	alg_snapshot = SAFE_MALLOC(capacity * sizeof(*alg_snapshot));
+
+	while (!done) {
+		uint32_t len = SAFE_NETLINK_RECV(ses->fd, buf, sizeof(buf));
+		struct nlmsghdr *ans;
+
+		for (ans = (struct nlmsghdr *)buf;
+		     NLMSG_OK(ans, len);
+		     ans = NLMSG_NEXT(ans, len)) {
+			if (ans->nlmsg_type == NLMSG_DONE) {
+				done = 1;
+				break;
+			}
+
+			if (ans->nlmsg_type == NLMSG_ERROR) {
+				tst_brk(TBROK,
+					"Algorithm dump failed; error=%d",
+					((struct nlmsgerr *)NLMSG_DATA(ans))->error);
+			}
+
+			if (alg_snapshot_count == capacity) {
+				capacity *= 2;
+				alg_snapshot = realloc(alg_snapshot,
+					capacity * sizeof(*alg_snapshot));
+				if (!alg_snapshot)
+					tst_brk(TBROK, "realloc() failed");
+			}
+
+			memcpy(&alg_snapshot[alg_snapshot_count++],
+			       NLMSG_DATA(ans), sizeof(*alg_snapshot));
+		}
+	}
+
+	alg_snapshot_valid = 1;
+}
+
+bool tst_crypto_alg_exists(struct tst_crypto_session *ses,
+			   const char *driver_name)
+{
+	unsigned int i;
+
+	if (!alg_snapshot_valid)
+		fetch_alg_snapshot(ses);
+
+	for (i = 0; i < alg_snapshot_count; i++) {
+		if (!strcmp(alg_snapshot[i].cru_driver_name, driver_name) ||
+		    !strcmp(alg_snapshot[i].cru_name, driver_name))
+			return true;
+	}
+
+	return false;
+}
+
+void tst_crypto_alg_snapshot_drop(void)
+{
+	free(alg_snapshot);
+	alg_snapshot = NULL;
+	alg_snapshot_count = 0;
+	alg_snapshot_valid = 0;
+}
+
 int tst_crypto_del_alg(struct tst_crypto_session *ses,
 		       const struct crypto_user_alg *alg)
 {
@@ -23,9 +23,11 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/file.h>
 #include <sys/ioctl.h>
 #include <sys/mount.h>
 #include <errno.h>
+#include <limits.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <linux/loop.h>
@@ -34,7 +36,9 @@
 #include <sys/sysmacros.h>
 #include "lapi/syscalls.h"
 #include "test.h"
+#include "tst_mount_table.h"
 #include "safe_macros.h"
+#include "tst_cache.h"
 
 #ifndef LOOP_CTL_GET_FREE
 # define LOOP_CTL_GET_FREE 0x4C82
@@ -234,22 +238,69 @@ int tst_dev_sync(int fd)
 	return syscall(__NR_syncfs, fd);
 }
 
+/*
+ * When tests run in parallel LOOP_CTL_GET_FREE hands the same free device to
+ * several of them at once and all but one lose the LOOP_SET_FD race, which
+ * ends in retry storms.  Serialize find+attach on a run-wide lock file when
+ * the run cache is available; outside of runltp this degrades to the old
+ * racy behaviour.
+ */
+static int loopdev_broker_lock(void)
+{
+	char path[PATH_MAX];
+	int fd;
+
+	if (tst_cache_file_path("loopdev.lock", path, sizeof(path)))
+		return -1;
+
+	fd = open(path, O_CREAT | O_RDWR, 0666);
+	if (fd < 0)
+		return -1;
+
+	while (flock(fd, LOCK_EX)) {
+		if (errno == EINTR)
+			continue;
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static void loopdev_broker_unlock(int fd)
+{
+	if (fd < 0)
+		return;
+
+	flock(fd, LOCK_UN);
+	close(fd);
+}
+
 const char *tst_acquire_loop_device(unsigned int size, const char *filename)
 {
 	unsigned int acq_dev_size = MAX(size, DEV_SIZE_MB);
+	int i, lock_fd;
 
 	if (tst_prealloc_file(filename, 1024 * 1024, acq_dev_size)) {
 		tst_resm(TWARN | TERRNO, "Failed to create %s", filename);
 		return NULL;
 	}
 
-	if (tst_find_free_loopdev(dev_path, sizeof(dev_path)) == -1)
-		return NULL;
+	lock_fd = loopdev_broker_lock();
 
-	if (tst_attach_device(dev_path, filename))
-		return NULL;
+	for (i = 0; i < 10; i++) {
+		if (tst_find_free_loopdev(dev_path, sizeof(dev_path)) == -1)
+			break;
 
-	return dev_path;
+		if (!tst_attach_device(dev_path, filename)) {
+			loopdev_broker_unlock(lock_fd);
+			return dev_path;
+		}
+	}
+
+	loopdev_broker_unlock(lock_fd);
+
+	return NULL;
 }
 
 const char *tst_acquire_device__(unsigned int size)
@@ -376,8 +427,10 @@ int tst_umount(const char *path)
 		ret = umount(path);
 		err = errno;
 
-		if (!ret)
+		if (!ret) {
+			tst_mount_epoch_bump();
 			return 0;
+		}
 
 		if (err != EBUSY) {
 			tst_resm(TWARN, "umount('%s') failed with %s",
@@ -402,6 +455,21 @@ int tst_umount(const char *path)
 	return -1;
 }
 
+int tst_umount_detach(const char *path)
+{
+	if (!umount2(path, MNT_DETACH)) {
+		tst_mount_epoch_bump();
+		return 0;
+	}
+
+	if (errno == ENOSYS || errno == EINVAL)
+		return tst_umount(path);
+
+	tst_resm(TWARN, "umount2('%s', MNT_DETACH) failed with %s",
+	         path, tst_strerrno(errno));
+	return -1;
+}
+
 int tst_is_mounted(const char *path)
 {
 	char line[PATH_MAX];
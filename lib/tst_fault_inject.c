@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_fault_inject.h"
+
+#define FAULT_DEBUGFS "/sys/kernel/debug"
+
+static const char *const fault_sites[] = {
+	"failslab",
+	"fail_page_alloc",
+	"fail_make_request",
+	"fail_io_timeout",
+};
+
+struct fault_site {
+	const char *name;
+	int probability_fd;
+};
+
+static struct fault_site sites[ARRAY_SIZE(fault_sites)];
+static unsigned int nr_sites;
+static int fault_loops = 1;
+static int fault_probability;
+
+static void write_str(int dirfd, const char *site, const char *file,
+		      const char *val)
+{
+	char path[128];
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", site, file);
+
+	fd = openat(dirfd, path, O_WRONLY);
+	if (fd < 0)
+		return;
+
+	if (write(fd, val, strlen(val)) < 0) {
+		tst_res(TWARN | TERRNO,
+			"Failed to write '%s' to %s/%s/%s",
+			val, FAULT_DEBUGFS, site, file);
+	}
+
+	close(fd);
+}
+
+static void write_fd(int fd, const char *site, const char *val)
+{
+	if (pwrite(fd, val, strlen(val), 0) < 0) {
+		tst_res(TWARN | TERRNO,
+			"Failed to write '%s' to %s/%s/probability",
+			val, FAULT_DEBUGFS, site);
+	}
+}
+
+unsigned int tst_fault_sweep_init(void)
+{
+	const char *env = getenv("LTP_FAULT_PROBABILITY");
+	char path[128];
+	unsigned int i;
+	int dirfd, fd;
+
+	if (!env)
+		return 0;
+
+	if (tst_parse_int(env, &fault_probability, 1, 100)) {
+		tst_res(TWARN, "Invalid LTP_FAULT_PROBABILITY '%s'", env);
+		return 0;
+	}
+
+	env = getenv("LTP_FAULT_LOOPS");
+	if (env && tst_parse_int(env, &fault_loops, 1, INT_MAX)) {
+		tst_res(TWARN, "Invalid LTP_FAULT_LOOPS '%s'", env);
+		fault_loops = 1;
+	}
+
+	dirfd = open(FAULT_DEBUGFS, O_PATH | O_DIRECTORY);
+	if (dirfd < 0) {
+		tst_res(TWARN | TERRNO, "Failed to open " FAULT_DEBUGFS
+			", fault sweep disabled");
+		return 0;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(fault_sites); i++) {
+		snprintf(path, sizeof(path), "%s/probability",
+			 fault_sites[i]);
+
+		fd = openat(dirfd, path, O_WRONLY);
+		if (fd < 0)
+			continue;
+
+		/*
+		 * Every call hits the site once armed; times=-1 keeps it
+		 * armed for the whole run, matching what the old
+		 * insert_kernel_faults.sh configured.
+		 */
+		write_str(dirfd, fault_sites[i], "interval", "100");
+		write_str(dirfd, fault_sites[i], "times", "-1");
+		write_str(dirfd, fault_sites[i], "space", "0");
+		write_str(dirfd, fault_sites[i], "verbose", "0");
+
+		sites[nr_sites].name = fault_sites[i];
+		sites[nr_sites].probability_fd = fd;
+		nr_sites++;
+	}
+
+	close(dirfd);
+
+	if (!nr_sites) {
+		tst_res(TCONF, "No fault-injection site in " FAULT_DEBUGFS
+			", fault sweep disabled");
+		return 0;
+	}
+
+	tst_res(TINFO,
+		"Fault sweep: %u sites x %i loops at %i%% probability",
+		nr_sites, fault_loops, fault_probability);
+
+	return nr_sites * fault_loops;
+}
+
+void tst_fault_sweep_apply(unsigned int i)
+{
+	static unsigned int cur_site = UINT_MAX;
+	unsigned int site = (i / fault_loops) % nr_sites;
+	char val[16];
+
+	if (site == cur_site)
+		return;
+
+	if (cur_site != UINT_MAX)
+		write_fd(sites[cur_site].probability_fd,
+			 sites[cur_site].name, "0");
+
+	snprintf(val, sizeof(val), "%i", fault_probability);
+	write_fd(sites[site].probability_fd, sites[site].name, val);
+	cur_site = site;
+
+	tst_res(TINFO, "Fault sweep: injecting into %s", sites[site].name);
+}
+
+void tst_fault_sweep_stop(void)
+{
+	unsigned int i;
+	int dirfd;
+
+	if (!nr_sites)
+		return;
+
+	dirfd = open(FAULT_DEBUGFS, O_PATH | O_DIRECTORY);
+
+	for (i = 0; i < nr_sites; i++) {
+		write_fd(sites[i].probability_fd, sites[i].name, "0");
+		close(sites[i].probability_fd);
+
+		if (dirfd >= 0) {
+			write_str(dirfd, sites[i].name, "times", "1");
+			write_str(dirfd, sites[i].name, "interval", "1");
+			write_str(dirfd, sites[i].name, "verbose", "2");
+		}
+	}
+
+	if (dirfd >= 0)
+		close(dirfd);
+
+	nr_sites = 0;
+}
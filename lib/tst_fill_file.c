@@ -25,14 +25,22 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include "lapi/fallocate.h"
 
 #include "test.h"
+#include "tst_minmax.h"
+
+/* how many blocks to hand to the kernel per writev() call */
+#define FILL_IOV_CNT 64
 
 int tst_fill_fd(int fd, char pattern, size_t bs, size_t bcount)
 {
-	size_t i;
+	struct iovec iov[FILL_IOV_CNT];
+	size_t i, left, pos, rest;
+	ssize_t ret;
+	int cnt;
 	char *buf;
 
 	/* Filling a memory buffer with provided pattern */
@@ -43,12 +51,33 @@ int tst_fill_fd(int fd, char pattern, size_t bs, size_t bcount)
 	for (i = 0; i < bs; i++)
 		buf[i] = pattern;
 
-	/* Filling the file */
-	for (i = 0; i < bcount; i++) {
-		if (write(fd, buf, bs) != (ssize_t)bs) {
+	/*
+	 * Filling the file; all iovecs point at the one pattern buffer so a
+	 * single writev() pushes up to FILL_IOV_CNT blocks, which beats one
+	 * write() per block hands down on multi-GB files built from small
+	 * blocks. Short writes just leave the first iovec of the next batch
+	 * pointing into the middle of the buffer.
+	 */
+	left = bs * bcount;
+	while (left > 0) {
+		pos = bs * bcount - left;
+		iov[0].iov_base = buf + pos % bs;
+		iov[0].iov_len = bs - pos % bs;
+		rest = left - iov[0].iov_len;
+
+		for (cnt = 1; cnt < FILL_IOV_CNT && rest > 0; cnt++) {
+			iov[cnt].iov_base = buf;
+			iov[cnt].iov_len = bs;
+			rest -= bs;
+		}
+
+		ret = writev(fd, iov, cnt);
+		if (ret <= 0) {
 			free(buf);
 			return -1;
 		}
+
+		left -= ret;
 	}
 
 	free(buf);
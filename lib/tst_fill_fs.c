@@ -3,43 +3,82 @@
  * Copyright (c) 2017 Cyril Hrubis <chrubis@suse.cz>
  */
 
+#define _GNU_SOURCE
+
+#include "config.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/statvfs.h>
+#include <sys/wait.h>
 
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
 #include "tst_fs.h"
 
-void tst_fill_fs(const char *path, int verbose)
+/*
+ * Fills path with files named by prefix until ENOSPC. The bulk of each
+ * file is reserved with fallocate() where the filesystem supports it and
+ * only the last buffer's worth is actually written; once allocation
+ * fails the remaining space is squeezed out with halving writes so the
+ * filesystem ends up really full either way.
+ */
+static void fill_one(const char *path, int verbose, const char *prefix)
 {
 	int i = 0;
-	char file[PATH_MAX];
+	char name[64];
 	char buf[4096];
-	size_t len;
+	size_t len, bulk;
 	ssize_t ret;
-	int fd;
+	int dirfd, fd;
+	int use_fallocate = 1;
 	struct statvfs fi;
 	statvfs(path, &fi);
 
+	/*
+	 * Creating the files relative to a directory fd saves the kernel a
+	 * full path walk on every open(), which adds up on fast devices.
+	 */
+	dirfd = SAFE_OPEN(path, O_DIRECTORY | O_RDONLY);
+
 	for (;;) {
 		len = random() % (1024 * 102400);
 
-		snprintf(file, sizeof(file), "%s/file%i", path, i++);
+		snprintf(name, sizeof(name), "%s%i", prefix, i++);
 
-		if (verbose)
-			tst_res(TINFO, "Creating file %s size %zu", file, len);
+		if (verbose) {
+			tst_res(TINFO, "Creating file %s/%s size %zu",
+				path, name, len);
+		}
 
-		fd = open(file, O_WRONLY | O_CREAT, 0700);
+		fd = openat(dirfd, name, O_WRONLY | O_CREAT, 0700);
 		if (fd == -1) {
 			if (errno != ENOSPC)
-				tst_brk(TBROK | TERRNO, "open()");
+				tst_brk(TBROK | TERRNO, "openat()");
 
-			tst_res(TINFO | TERRNO, "open()");
+			tst_res(TINFO | TERRNO, "openat()");
+			SAFE_CLOSE(dirfd);
 			return;
 		}
 
+#ifdef HAVE_FALLOCATE
+		bulk = len > sizeof(buf) ? len - sizeof(buf) : 0;
+
+		if (use_fallocate && bulk) {
+			if (!fallocate(fd, 0, 0, bulk)) {
+				SAFE_LSEEK(fd, bulk, SEEK_SET);
+				len -= bulk;
+			} else if (errno == EOPNOTSUPP || errno == EINVAL) {
+				use_fallocate = 0;
+			} else if (errno != ENOSPC) {
+				SAFE_CLOSE(fd);
+				tst_brk(TBROK | TERRNO, "fallocate()");
+			}
+			/* on ENOSPC fall through and squeeze with writes */
+		}
+#endif
+
 		while (len) {
 			ret = write(fd, buf, MIN(len, sizeof(buf)));
 
@@ -57,6 +96,7 @@ void tst_fill_fs(const char *path, int verbose)
 					tst_brk(TBROK | TERRNO, "write()");
 
 				tst_res(TINFO | TERRNO, "write()");
+				SAFE_CLOSE(dirfd);
 				return;
 			}
 
@@ -66,3 +106,48 @@ void tst_fill_fs(const char *path, int verbose)
 		SAFE_CLOSE(fd);
 	}
 }
+
+void tst_fill_fs(const char *path, int verbose)
+{
+	const char *env = getenv("LTP_FILL_FS_WORKERS");
+	char prefix[32];
+	unsigned int w, nworkers = 1;
+	pid_t pid;
+	int status;
+
+	if (env) {
+		nworkers = atoi(env);
+		if (!nworkers)
+			nworkers = 1;
+	}
+
+	if (nworkers == 1) {
+		fill_one(path, verbose, "file");
+		return;
+	}
+
+	/*
+	 * Parallel mode: each worker process fills the same directory
+	 * under its own name prefix, so the layout stays flat and callers
+	 * that unlink files found by readdir() keep working.
+	 */
+	for (w = 0; w < nworkers; w++) {
+		pid = fork();
+		if (pid < 0)
+			tst_brk(TBROK | TERRNO, "fork()");
+
+		if (!pid) {
+			srandom(getpid());
+			snprintf(prefix, sizeof(prefix), "file%u_", w);
+			fill_one(path, verbose, prefix);
+			_exit(0);
+		}
+	}
+
+	for (w = 0; w < nworkers; w++) {
+		SAFE_WAIT(&status);
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			tst_brk(TBROK, "fill worker %s",
+				tst_strstatus(status));
+	}
+}
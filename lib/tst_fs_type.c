@@ -29,10 +29,20 @@
 #include <sys/vfs.h>
 #include "test.h"
 #include "tst_fs.h"
+#include "tst_mount_table.h"
 
 long tst_fs_type_(void (*cleanup)(void), const char *path)
 {
 	struct statfs sbuf;
+	struct tst_mntent *mnt;
+
+	/*
+	 * The magic is cached per mount entry, so repeated queries (as in
+	 * .all_filesystems inner loops) cost one statfs() per mount cycle.
+	 */
+	mnt = tst_mount_table_lookup(path);
+	if (mnt && mnt->f_type != -1)
+		return mnt->f_type;
 
 	if (statfs(path, &sbuf)) {
 		tst_brkm(TBROK | TERRNO, cleanup,
@@ -40,6 +50,9 @@ long tst_fs_type_(void (*cleanup)(void), const char *path)
 		return 0;
 	}
 
+	if (mnt)
+		mnt->f_type = sbuf.f_type;
+
 	return sbuf.f_type;
 }
 
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_hist.h"
+
+void tst_hist_init(struct tst_hist *hist, unsigned int bits)
+{
+	hist->bits = bits;
+	hist->nbuckets = (64 - bits) << bits;
+	hist->buckets = SAFE_MALLOC(hist->nbuckets * sizeof(hist->buckets[0]));
+
+	tst_hist_reset(hist);
+}
+
+void tst_hist_reset(struct tst_hist *hist)
+{
+	memset(hist->buckets, 0, hist->nbuckets * sizeof(hist->buckets[0]));
+	hist->nsamples = 0;
+}
+
+void tst_hist_free(struct tst_hist *hist)
+{
+	free(hist->buckets);
+	hist->buckets = NULL;
+}
+
+static unsigned int hist_idx(struct tst_hist *hist, long long sample)
+{
+	unsigned long long v = sample;
+	unsigned int sub = 1u << hist->bits;
+	unsigned int e = 0;
+
+	while (v >= 2 * sub) {
+		v >>= 1;
+		e++;
+	}
+
+	if (!e)
+		return v;
+
+	return (e + 1) * sub + (v - sub);
+}
+
+void tst_hist_add(struct tst_hist *hist, long long sample)
+{
+	hist->buckets[hist_idx(hist, sample)]++;
+	hist->nsamples++;
+}
+
+void tst_hist_merge(struct tst_hist *dst, const struct tst_hist *src)
+{
+	unsigned int i;
+
+	if (dst->bits != src->bits)
+		tst_brk(TBROK, "merging histograms with %u and %u bits",
+			dst->bits, src->bits);
+
+	for (i = 0; i < dst->nbuckets; i++)
+		dst->buckets[i] += src->buckets[i];
+
+	dst->nsamples += src->nsamples;
+}
+
+long long tst_hist_bucket_low(struct tst_hist *hist, unsigned int idx)
+{
+	unsigned int sub = 1u << hist->bits;
+	unsigned int e;
+
+	if (idx < 2 * sub)
+		return idx;
+
+	e = idx / sub - 1;
+
+	return (long long)(sub + idx % sub) << e;
+}
+
+long long tst_hist_percentile(struct tst_hist *hist, float p)
+{
+	unsigned int i, cnt = 0;
+	float samples = 1.00 * hist->nsamples * p / 100;
+	unsigned int limit = samples;
+
+	if (samples - limit > 0)
+		limit++;
+
+	limit = MAX(1u, limit);
+
+	for (i = 0; i < hist->nbuckets; i++) {
+		cnt += hist->buckets[i];
+		if (cnt >= limit)
+			return tst_hist_bucket_low(hist, i);
+	}
+
+	return 0;
+}
@@ -5,6 +5,7 @@
 
 #define TST_NO_DEFAULT_MAIN
 
+#include <stdlib.h>
 #include "tst_test.h"
 #include "tst_hugepage.h"
 
@@ -34,6 +35,19 @@ unsigned long tst_request_hugepages(unsigned long hpages)
 	else
 		tst_hugepages = hpages;
 
+	/*
+	 * If enough pages are reserved already, e.g. from the run-scoped
+	 * pool set up by "runltp -G", lease them instead of rewriting
+	 * nr_hugepages and making the kernel assemble the pages anew for
+	 * every single test.
+	 */
+	SAFE_FILE_SCANF(PATH_NR_HPAGES, "%lu", &val);
+	if (val >= tst_hugepages) {
+		tst_res(TINFO, "Reusing %lu of %lu reserved hugepage(s)",
+			tst_hugepages, val);
+		goto out;
+	}
+
 	SAFE_FILE_PRINTF("/proc/sys/vm/drop_caches", "3");
 	max_hpages = SAFE_READ_MEMINFO("MemFree:") / SAFE_READ_MEMINFO("Hugepagesize:");
 
@@ -47,7 +61,12 @@ unsigned long tst_request_hugepages(unsigned long hpages)
 			goto out;
 	}
 
-	tst_sys_conf_save("?/proc/sys/vm/nr_hugepages");
+	/*
+	 * With a run-scoped pool the grown reservation is left in place for
+	 * the tests that follow; runltp shrinks it again at run end.
+	 */
+	if (!getenv("LTP_HUGEPAGE_POOL"))
+		tst_sys_conf_save("?/proc/sys/vm/nr_hugepages");
 	SAFE_FILE_PRINTF(PATH_NR_HPAGES, "%lu", tst_hugepages);
 	SAFE_FILE_SCANF(PATH_NR_HPAGES, "%lu", &val);
 	if (val != tst_hugepages)
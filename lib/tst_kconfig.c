@@ -3,6 +3,8 @@
  * Copyright (c) 2018 Cyril Hrubis <chrubis@suse.cz>
  */
 
+#include <limits.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -12,6 +14,7 @@
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
 #include "tst_private.h"
+#include "tst_cache.h"
 #include "tst_kconfig.h"
 #include "tst_bool_expr.h"
 
@@ -51,6 +54,45 @@ static const char *kconfig_path(char *path_buf, size_t path_buf_len)
 
 static char is_gzip;
 
+/*
+ * Decompressing /proc/config.gz costs tens of milliseconds and is paid by
+ * every test that declares .needs_kconfigs. Decompress it into the run
+ * cache exactly once per boot so that later tests scan the plain text copy
+ * instead of forking zcat. See include/tst_cache.h.
+ */
+static FILE *open_cached_kconfig(const char *path)
+{
+	char cache_path[PATH_MAX];
+	char cmd[2 * PATH_MAX + 64];
+	void *old_handler;
+	FILE *fp;
+	int ret;
+
+	if (tst_cache_file_path("kconfig", cache_path, sizeof(cache_path)))
+		return NULL;
+
+	fp = fopen(cache_path, "r");
+	if (fp)
+		return fp;
+
+	ret = snprintf(cmd, sizeof(cmd),
+		       "zcat '%s' > '%s.%i' && mv '%s.%i' '%s'",
+		       path, cache_path, getpid(),
+		       cache_path, getpid(), cache_path);
+	if (ret < 0 || (size_t)ret >= sizeof(cmd))
+		return NULL;
+
+	/* See tst_cmd.c */
+	old_handler = signal(SIGCHLD, SIG_DFL);
+	ret = system(cmd);
+	signal(SIGCHLD, old_handler);
+
+	if (ret)
+		return NULL;
+
+	return fopen(cache_path, "r");
+}
+
 static FILE *open_kconfig(void)
 {
 	FILE *fp;
@@ -66,6 +108,12 @@ static FILE *open_kconfig(void)
 	is_gzip = !!strstr(path, ".gz");
 
 	if (is_gzip) {
+		fp = open_cached_kconfig(path);
+		if (fp) {
+			is_gzip = 0;
+			return fp;
+		}
+
 		snprintf(buf, sizeof(buf), "zcat '%s'", path);
 		fp = popen(buf, "r");
 	} else {
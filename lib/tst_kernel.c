@@ -15,9 +15,12 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
+#include <string.h>
 #include <sys/personality.h>
 #include <sys/utsname.h>
 #include "test.h"
+#include "tst_cache.h"
 #include "tst_kernel.h"
 
 static int get_kernel_bits_from_uname(struct utsname *buf)
@@ -85,11 +88,26 @@ int tst_check_driver(const char *name)
 {
 #ifndef __ANDROID__
 	const char * const argv[] = { "modprobe", "-n", name, NULL };
-	int res = tst_cmd_(NULL, argv, "/dev/null", "/dev/null",
+	char key[128];
+	int ret, res;
+
+	ret = snprintf(key, sizeof(key), "driver_%s", name);
+	if (ret < 0 || (size_t)ret >= sizeof(key) || strchr(name, '/'))
+		key[0] = '\0';
+
+	if (key[0] && !tst_cache_get_int(key, &res))
+		return res;
+
+	res = tst_cmd_(NULL, argv, "/dev/null", "/dev/null",
 			       TST_CMD_PASS_RETVAL);
 
 	/* 255 - it looks like modprobe not available */
-	return (res == 255) ? 0 : res;
+	res = (res == 255) ? 0 : res;
+
+	if (key[0])
+		tst_cache_put_int(key, res);
+
+	return res;
 #else
 	/* Android modprobe may not have '-n', or properly installed
 	 * module.*.bin files to determine built-in drivers. Assume
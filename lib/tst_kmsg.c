@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_kmsg.h"
+
+static int kmsg_fd = -1;
+static FILE *kmsg_log;
+static const char *kmsg_tag;
+
+/*
+ * Substrings that make a kernel record worth a TWARN on top of the log
+ * entry.
+ */
+static const char *const kmsg_warn_patterns[] = {
+	"WARNING:",
+	"BUG:",
+	"kernel BUG at",
+	"Oops",
+	"Call Trace:",
+	NULL
+};
+
+void tst_kmsg_init(const char *test_name)
+{
+	const char *path = getenv("LTP_KMSG_LOG");
+
+	if (!path)
+		return;
+
+	kmsg_fd = open("/dev/kmsg", O_RDONLY | O_NONBLOCK);
+	if (kmsg_fd < 0) {
+		tst_res(TWARN | TERRNO, "Failed to open /dev/kmsg");
+		return;
+	}
+
+	/* skip records from before the test */
+	if (lseek(kmsg_fd, 0, SEEK_END) == (off_t)-1) {
+		tst_res(TWARN | TERRNO, "Failed to seek in /dev/kmsg");
+		close(kmsg_fd);
+		kmsg_fd = -1;
+		return;
+	}
+
+	kmsg_log = fopen(path, "a");
+	if (!kmsg_log) {
+		tst_res(TWARN | TERRNO, "Failed to open '%s'", path);
+		close(kmsg_fd);
+		kmsg_fd = -1;
+		return;
+	}
+
+	kmsg_tag = test_name;
+}
+
+void tst_kmsg_check(void)
+{
+	char buf[8192];
+	char *msg, *nl;
+	ssize_t len;
+	int i;
+
+	if (kmsg_fd < 0)
+		return;
+
+	for (;;) {
+		/* each read returns exactly one record */
+		len = read(kmsg_fd, buf, sizeof(buf) - 1);
+		if (len < 0) {
+			if (errno == EAGAIN)
+				break;
+			/* the record was overwritten under us, skip on */
+			if (errno == EPIPE)
+				continue;
+			tst_res(TWARN | TERRNO, "Failed to read /dev/kmsg");
+			break;
+		}
+		buf[len] = '\0';
+
+		nl = strchr(buf, '\n');
+		if (nl)
+			*nl = '\0';
+
+		fprintf(kmsg_log, "%s: %s\n", kmsg_tag, buf);
+
+		/* the human readable part follows the first semicolon */
+		msg = strchr(buf, ';');
+		msg = msg ? msg + 1 : buf;
+
+		for (i = 0; kmsg_warn_patterns[i]; i++) {
+			if (strstr(msg, kmsg_warn_patterns[i])) {
+				tst_res(TWARN, "kernel: %s", msg);
+				break;
+			}
+		}
+	}
+
+	fflush(kmsg_log);
+}
@@ -10,6 +10,7 @@
 #include "tst_safe_macros.h"
 #include "tst_safe_stdio.h"
 #include "tst_lockdown.h"
+#include "tst_cache.h"
 #include "tst_private.h"
 
 #define EFIVAR_SECUREBOOT "/sys/firmware/efi/efivars/SecureBoot-8be4df61-93ca-11d2-aa0d-00e098032b8c"
@@ -45,6 +46,10 @@ int tst_lockdown_enabled(void)
 {
 	char line[BUFSIZ];
 	FILE *file;
+	int ret;
+
+	if (!tst_cache_get_int("lockdown", &ret))
+		return ret;
 
 	if (access(PATH_LOCKDOWN, F_OK) != 0) {
 		char flag;
@@ -52,8 +57,10 @@ int tst_lockdown_enabled(void)
 		flag = tst_kconfig_get("CONFIG_EFI_SECURE_BOOT_LOCK_DOWN");
 
 		/* SecureBoot enabled could mean integrity lockdown */
-		if (flag == 'y' && tst_secureboot_enabled() > 0)
+		if (flag == 'y' && tst_secureboot_enabled() > 0) {
+			tst_cache_put_int("lockdown", 1);
 			return 1;
+		}
 
 		tst_res(TINFO, "Unable to determine system lockdown state");
 		return 0;
@@ -64,5 +71,8 @@ int tst_lockdown_enabled(void)
 		tst_brk(TBROK | TERRNO, "fgets %s", PATH_LOCKDOWN);
 	SAFE_FCLOSE(file);
 
-	return (strstr(line, "[none]") == NULL);
+	ret = (strstr(line, "[none]") == NULL);
+	tst_cache_put_int("lockdown", ret);
+
+	return ret;
 }
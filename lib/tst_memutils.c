@@ -5,7 +5,10 @@
 
 #include <unistd.h>
 #include <limits.h>
+#include <sys/mman.h>
 #include <sys/sysinfo.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
 #include <stdlib.h>
 
 #define TST_NO_DEFAULT_MAIN
@@ -13,11 +16,109 @@
 
 #define BLOCKSIZE (16 * 1024 * 1024)
 
-void tst_pollute_memory(size_t maxsize, int fillchar)
+/*
+ * Dirty up to maxsize bytes of anonymous memory with fillchar, then free
+ * it again. Returns the amount actually polluted, which may be less when
+ * the address space runs out before maxsize is reached.
+ */
+static size_t pollute_anon(size_t maxsize, int fillchar)
 {
-	size_t i, map_count = 0, safety = 0, blocksize = BLOCKSIZE;
+	size_t i, map_count, blocksize = BLOCKSIZE;
 	void **map_blocks;
+
+	blocksize = MIN(maxsize, blocksize);
+	map_count = maxsize / blocksize;
+	map_blocks = SAFE_MALLOC(map_count * sizeof(void *));
+
+	/*
+	 * Keep allocating until the first failure. The address space may be
+	 * too fragmented or just smaller than maxsize.
+	 */
+	for (i = 0; i < map_count; i++) {
+		map_blocks[i] = mmap(NULL, blocksize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (map_blocks[i] == MAP_FAILED) {
+			map_count = i;
+			break;
+		}
+
+#ifdef MADV_HUGEPAGE
+		/*
+		 * Fault huge pages in where THP is available, which cuts
+		 * the page fault count of the memset() below by orders of
+		 * magnitude on large hosts.
+		 */
+		madvise(map_blocks[i], blocksize, MADV_HUGEPAGE);
+#endif
+
+		memset(map_blocks[i], fillchar, blocksize);
+	}
+
+	for (i = 0; i < map_count; i++)
+		SAFE_MUNMAP(map_blocks[i], blocksize);
+
+	free(map_blocks);
+
+	return map_count * blocksize;
+}
+
+#ifdef __NR_memfd_create
+/*
+ * Balloon up to maxsize bytes of page cache full of fillchar by writing
+ * to an unlinked memfd. No mapping is involved, so this also covers the
+ * physical memory that does not fit into the address space on 32bit.
+ * Closing the fd frees everything. Returns the amount written.
+ */
+static size_t pollute_memfd(size_t maxsize, int fillchar)
+{
+	char *buf;
+	size_t bufsize = MIN(maxsize, (size_t)BLOCKSIZE);
+	size_t left = maxsize;
+	ssize_t ret;
+	int fd;
+
+	fd = syscall(__NR_memfd_create, "ltp_pollute", 0);
+	if (fd < 0)
+		return 0;
+
+	buf = SAFE_MALLOC(bufsize);
+	memset(buf, fillchar, bufsize);
+
+	while (left >= bufsize) {
+		ret = write(fd, buf, bufsize);
+
+		if (ret <= 0)
+			break;
+
+		left -= ret;
+	}
+
+	free(buf);
+	SAFE_CLOSE(fd);
+
+	return maxsize - left;
+}
+#endif
+
+static void pollute_one(size_t maxsize, int fillchar)
+{
+	size_t polluted = pollute_anon(maxsize, fillchar);
+
+#ifdef __NR_memfd_create
+	if (polluted < maxsize)
+		pollute_memfd(maxsize - polluted, fillchar);
+#endif
+}
+
+void tst_pollute_memory(size_t maxsize, int fillchar)
+{
+	const char *env = getenv("LTP_POLLUTE_WORKERS");
+	size_t safety = 0;
+	unsigned int w, nworkers = 1;
 	struct sysinfo info;
+	pid_t pid;
+	int status;
 
 	SAFE_SYSINFO(&info);
 	safety = MAX(4096 * SAFE_SYSCONF(_SC_PAGESIZE), 128 * 1024 * 1024);
@@ -36,28 +137,37 @@ void tst_pollute_memory(size_t maxsize, int fillchar)
 	if (info.freeram - safety < maxsize / info.mem_unit)
 		maxsize = (info.freeram - safety) * info.mem_unit;
 
-	blocksize = MIN(maxsize, blocksize);
-	map_count = maxsize / blocksize;
-	map_blocks = SAFE_MALLOC(map_count * sizeof(void *));
+	if (env) {
+		nworkers = atoi(env);
+		if (!nworkers)
+			nworkers = 1;
+	}
+
+	if (nworkers == 1) {
+		pollute_one(maxsize, fillchar);
+		return;
+	}
 
 	/*
-	 * Keep allocating until the first failure. The address space may be
-	 * too fragmented or just smaller than maxsize.
+	 * Parallel mode: the workers dirty disjoint shares of the target
+	 * amount at once, so filling scales with memory bandwidth instead
+	 * of a single core's memset() speed.
 	 */
-	for (i = 0; i < map_count; i++) {
-		map_blocks[i] = mmap(NULL, blocksize, PROT_READ | PROT_WRITE,
-			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	for (w = 0; w < nworkers; w++) {
+		pid = fork();
+		if (pid < 0)
+			tst_brk(TBROK | TERRNO, "fork()");
 
-		if (map_blocks[i] == MAP_FAILED) {
-			map_count = i;
-			break;
+		if (!pid) {
+			pollute_one(maxsize / nworkers, fillchar);
+			_exit(0);
 		}
-
-		memset(map_blocks[i], fillchar, blocksize);
 	}
 
-	for (i = 0; i < map_count; i++)
-		SAFE_MUNMAP(map_blocks[i], blocksize);
-
-	free(map_blocks);
+	for (w = 0; w < nworkers; w++) {
+		SAFE_WAIT(&status);
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			tst_brk(TBROK, "pollute worker %s",
+				tst_strstatus(status));
+	}
 }
@@ -15,19 +15,234 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <unistd.h>
+
 #include "test.h"
 #include "ltp_priv.h"
 #include "tst_mkfs.h"
 #include "tst_device.h"
+#include "tst_cache.h"
 
 #define OPTS_MAX 32
 
+/*
+ * Formatting a filesystem from scratch for every test is one of the more
+ * expensive parts of the all_filesystems loop, so freshly formatted images
+ * are saved as sparse template files in the run cache keyed by filesystem,
+ * device size and mkfs options, and later requests are satisfied by copying
+ * the data extents of the template back onto the device.
+ *
+ * Filesystems where duplicated UUIDs prevent concurrent mounts (xfs, btrfs)
+ * are left out, they pay for a real mkfs every time.
+ */
+static const char *const image_cache_fs[] = {
+	"ext2", "ext3", "ext4", "vfat", "exfat", NULL
+};
+
+static int image_cache_usable(const char *fs_type)
+{
+	int i;
+
+	for (i = 0; image_cache_fs[i]; i++) {
+		if (!strcmp(image_cache_fs[i], fs_type))
+			return 1;
+	}
+
+	return 0;
+}
+
+static unsigned int opts_hash(const char *fs_opts_str,
+			      const char *extra_opts_str)
+{
+	unsigned int hash = 5381;
+	const char *s;
+
+	for (s = fs_opts_str; *s; s++)
+		hash = hash * 33 + *s;
+
+	for (s = extra_opts_str; *s; s++)
+		hash = hash * 33 + *s;
+
+	return hash;
+}
+
+static int image_cache_key(const char *dev, const char *fs_type,
+			   const char *fs_opts_str, const char *extra_opts_str,
+			   char *key, size_t key_len)
+{
+	uint64_t dev_size;
+	int fd;
+
+	fd = open(dev, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	if (ioctl(fd, BLKGETSIZE64, &dev_size)) {
+		close(fd);
+		return -1;
+	}
+
+	close(fd);
+
+	snprintf(key, key_len, "mkfs_%s_%lluMB_%08x", fs_type,
+		 (unsigned long long)(dev_size / 1024 / 1024),
+		 opts_hash(fs_opts_str, extra_opts_str));
+
+	return 0;
+}
+
+/*
+ * Copies the data extents of src_fd to the same offsets in dst_fd, holes
+ * are skipped which keeps templates sparse and restores cheap.
+ */
+static int sparse_copy(int src_fd, int dst_fd)
+{
+	char buf[64 * 1024];
+	off_t data = 0, hole;
+	ssize_t len, ret;
+
+	for (;;) {
+		data = lseek(src_fd, data, SEEK_DATA);
+		if (data == (off_t)-1) {
+			if (errno == ENXIO)
+				return 0;
+			return -1;
+		}
+
+		hole = lseek(src_fd, data, SEEK_HOLE);
+		if (hole == (off_t)-1)
+			return -1;
+
+		while (data < hole) {
+			len = MIN((off_t)sizeof(buf), hole - data);
+
+			ret = pread(src_fd, buf, len, data);
+			if (ret <= 0)
+				return -1;
+
+			if (pwrite(dst_fd, buf, ret, data) != ret)
+				return -1;
+
+			data += ret;
+		}
+	}
+}
+
+static int loop_backing_file(const char *dev, char *path, size_t path_len)
+{
+	char sys_path[PATH_MAX];
+	ssize_t len;
+	int fd;
+
+	if (strncmp(dev, "/dev/loop", 9) || !isdigit(dev[9]))
+		return -1;
+
+	snprintf(sys_path, sizeof(sys_path),
+		 "/sys/block/%s/loop/backing_file", dev + 5);
+
+	fd = open(sys_path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	len = read(fd, path, path_len - 1);
+	close(fd);
+
+	if (len <= 0)
+		return -1;
+
+	if (path[len - 1] == '\n')
+		len--;
+	path[len] = '\0';
+
+	return 0;
+}
+
+static int image_cache_restore(const char *key, const char *dev)
+{
+	char template[PATH_MAX];
+	int src_fd, dst_fd, ret;
+
+	if (tst_cache_file_path(key, template, sizeof(template)))
+		return -1;
+
+	src_fd = open(template, O_RDONLY);
+	if (src_fd < 0)
+		return -1;
+
+	dst_fd = open(dev, O_WRONLY);
+	if (dst_fd < 0) {
+		close(src_fd);
+		return -1;
+	}
+
+	ret = sparse_copy(src_fd, dst_fd);
+
+	if (!ret && fsync(dst_fd))
+		ret = -1;
+
+	close(src_fd);
+	close(dst_fd);
+
+	return ret;
+}
+
+static void image_cache_save(const char *key, const char *dev)
+{
+	char template[PATH_MAX];
+	char tmp_path[PATH_MAX];
+	char backing[PATH_MAX];
+	struct stat st;
+	int src_fd, dst_fd, ret;
+
+	if (tst_cache_file_path(key, template, sizeof(template)))
+		return;
+
+	/* only a loop backing file gives us a cheap sparse extent map */
+	if (loop_backing_file(dev, backing, sizeof(backing)))
+		return;
+
+	src_fd = open(backing, O_RDONLY);
+	if (src_fd < 0)
+		return;
+
+	ret = snprintf(tmp_path, sizeof(tmp_path), "%s.%i", template,
+		       getpid());
+	if (ret < 0 || (size_t)ret >= sizeof(tmp_path)) {
+		close(src_fd);
+		return;
+	}
+
+	dst_fd = open(tmp_path, O_CREAT | O_WRONLY | O_TRUNC, 0666);
+	if (dst_fd < 0) {
+		close(src_fd);
+		return;
+	}
+
+	ret = fstat(src_fd, &st) || ftruncate(dst_fd, st.st_size) ||
+	      sparse_copy(src_fd, dst_fd);
+
+	close(src_fd);
+	close(dst_fd);
+
+	if (ret || rename(tmp_path, template))
+		unlink(tmp_path);
+}
+
 void tst_mkfs_(const char *file, const int lineno, void (cleanup_fn)(void),
 	       const char *dev, const char *fs_type,
 	       const char *const fs_opts[], const char *const extra_opts[])
 {
 	int i, pos = 1, ret;
 	char mkfs[64];
+	char key[128];
 	const char *argv[OPTS_MAX] = {mkfs};
 	char fs_opts_str[1024] = "";
 	char extra_opts_str[1024] = "";
@@ -87,6 +302,19 @@ void tst_mkfs_(const char *file, const int lineno, void (cleanup_fn)(void),
 			"tst_clear_device() failed");
 	}
 
+	if (image_cache_usable(fs_type) &&
+	    !image_cache_key(dev, fs_type, fs_opts_str, extra_opts_str,
+			     key, sizeof(key))) {
+		if (!image_cache_restore(key, dev)) {
+			tst_resm_(file, lineno, TINFO,
+				"Restored cached %s image on %s opts='%s' extra opts='%s'",
+				fs_type, dev, fs_opts_str, extra_opts_str);
+			return;
+		}
+	} else {
+		key[0] = '\0';
+	}
+
 	tst_resm_(file, lineno, TINFO,
 		"Formatting %s with %s opts='%s' extra opts='%s'",
 		dev, fs_type, fs_opts_str, extra_opts_str);
@@ -104,6 +332,9 @@ void tst_mkfs_(const char *file, const int lineno, void (cleanup_fn)(void),
 		tst_brkm_(file, lineno, TBROK, cleanup_fn,
 			"%s failed with exit code %i", mkfs, ret);
 	}
+
+	if (key[0])
+		image_cache_save(key, dev);
 }
 
 const char *tst_dev_fs_type(void)
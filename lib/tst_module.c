@@ -22,21 +22,102 @@
 #define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <limits.h>
 
 #include "test.h"
 #include "ltp_priv.h"
 #include "old_module.h"
+#include "tst_cache.h"
+
+/*
+ * Builds a cache key from a module name, the cache uses keys as file
+ * names so path separators have to go.
+ */
+static void module_cache_key(const char *prefix, const char *mod_name,
+	char *key, size_t key_len)
+{
+	char *c;
+
+	snprintf(key, key_len, "%s%s", prefix, mod_name);
+
+	for (c = key; *c; c++) {
+		if (*c == '/')
+			*c = '_';
+	}
+}
+
+/*
+ * Extracts the kernel module name as /sys/module and rmmod know it from
+ * a module file name, i.e. strips the directory and the .ko suffix and
+ * maps dashes to underscores.
+ */
+static void module_kernel_name(const char *mod_name, char *buf, size_t len)
+{
+	const char *base = strrchr(mod_name, '/');
+	char *c;
+
+	snprintf(buf, len, "%s", base ? base + 1 : mod_name);
+
+	c = strrchr(buf, '.');
+	if (c && !strcmp(c, ".ko"))
+		*c = '\0';
+
+	for (c = buf; *c; c++) {
+		if (*c == '-')
+			*c = '_';
+	}
+}
+
+static int module_loaded(const char *kernel_name)
+{
+	char path[PATH_MAX + 32];
+
+	snprintf(path, sizeof(path), "/sys/module/%s", kernel_name);
+
+	return access(path, F_OK) == 0;
+}
+
+/*
+ * In the module lease mode, enabled by runltp -L, helper modules stay
+ * resident between consecutive tests that load them instead of being
+ * linked and unlinked over and over; runltp removes the leased modules
+ * once the run is over. The lease refcount lives in the run cache so
+ * that concurrently running tests sharing a module keep the count
+ * balanced.
+ */
+static int module_lease_active(void)
+{
+	return getenv("LTP_MODULE_LEASE") != NULL;
+}
 
 void tst_module_exists_(void (cleanup_fn)(void),
 	const char *mod_name, char **mod_path)
 {
+	char key[PATH_MAX + 32];
+	char cached[PATH_MAX + 32];
+
 	/* check current working directory */
 	if (access(mod_name, F_OK) == 0) {
 		if (mod_path != NULL)
 			*mod_path = strdup(mod_name);
 		return;
 	}
+
+	/*
+	 * The resolved path cannot change within a run, so reuse earlier
+	 * lookups from the run cache; revalidate in case the cached file
+	 * went away.
+	 */
+	module_cache_key("modpath_", mod_name, key, sizeof(key));
+	if (!tst_cache_get(key, cached, sizeof(cached)) &&
+	    access(cached, F_OK) == 0) {
+		if (mod_path != NULL)
+			*mod_path = strdup(cached);
+		return;
+	}
+
 	char *buf = NULL;
 	int err = -1;
 	/* check LTP installation path */
@@ -71,6 +152,8 @@ void tst_module_exists_(void (cleanup_fn)(void),
 		return;
 	}
 
+	tst_cache_put(key, buf);
+
 	if (mod_path != NULL)
 		*mod_path = buf;
 	else
@@ -83,6 +166,46 @@ void tst_module_load_(void (cleanup_fn)(void),
 	char *mod_path = NULL;
 	tst_module_exists_(cleanup_fn, mod_name, &mod_path);
 
+	/*
+	 * Only parameterless loads are shareable, a resident module loaded
+	 * with different parameters is not the module the test asked for.
+	 */
+	if (module_lease_active() && (argv == NULL || argv[0] == NULL)) {
+		char kernel_name[PATH_MAX];
+		char key[PATH_MAX + 32];
+		int refs;
+
+		module_kernel_name(mod_name, kernel_name, sizeof(kernel_name));
+		module_cache_key("modlease_", kernel_name, key, sizeof(key));
+
+		if (!module_loaded(kernel_name)) {
+			const char *const ins_argv[] = {
+				"insmod", mod_path, NULL
+			};
+
+			/*
+			 * A concurrently running lease holder may load the
+			 * module between the check and the insmod, so only
+			 * a failure that leaves the module absent is fatal.
+			 */
+			if (tst_cmd(NULL, ins_argv, NULL, NULL,
+				    TST_CMD_PASS_RETVAL) &&
+			    !module_loaded(kernel_name)) {
+				free(mod_path);
+				tst_brkm(TBROK, cleanup_fn,
+					"failed to load module '%s'", mod_name);
+				return;
+			}
+		}
+
+		if (tst_cache_get_int(key, &refs))
+			refs = 0;
+		tst_cache_put_int(key, refs + 1);
+
+		free(mod_path);
+		return;
+	}
+
 	const int offset = 2; /* command name & module path */
 	int size = 0;
 	while (argv && argv[size])
@@ -107,6 +230,21 @@ void tst_module_unload_(void (cleanup_fn)(void), const char *mod_name)
 
 	const char *const argv[] = { "rmmod", mod_name, NULL };
 
+	if (module_lease_active()) {
+		char kernel_name[PATH_MAX];
+		char key[PATH_MAX + 32];
+		int refs;
+
+		module_kernel_name(mod_name, kernel_name, sizeof(kernel_name));
+		module_cache_key("modlease_", kernel_name, key, sizeof(key));
+
+		/* leased modules stay resident until the run is over */
+		if (!tst_cache_get_int(key, &refs)) {
+			tst_cache_put_int(key, refs > 0 ? refs - 1 : 0);
+			return;
+		}
+	}
+
 	rc = 1;
 	for (i = 0; i < 50; i++) {
 		rc = tst_cmd(NULL, argv, "/dev/null", "/dev/null",
@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Cached snapshot of /proc/self/mountinfo.
+ *
+ * Tests iterating .all_filesystems query the mount table repeatedly in
+ * their inner loops; parsing the multi-kilobyte proc file on each call
+ * adds up. The table is parsed once into an array sorted by descending
+ * mount point length (so the first prefix match is the longest) and
+ * reused until the mount epoch moves, which the mount/umount wrappers
+ * arrange on every successful mount and umount.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tst_mount_table.h"
+
+static struct tst_mntent *table;
+static unsigned int table_len;
+static int table_epoch = -1;
+static int mount_epoch;
+
+void tst_mount_epoch_bump(void)
+{
+	mount_epoch++;
+}
+
+static void table_free(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < table_len; i++) {
+		free(table[i].dir);
+		free(table[i].fs_type);
+		free(table[i].opts);
+	}
+
+	free(table);
+	table = NULL;
+	table_len = 0;
+}
+
+/* Decodes the \ooo escapes mountinfo uses for spaces etc., in place. */
+static void unescape(char *str)
+{
+	char *s = str, *d = str;
+
+	while (*s) {
+		if (s[0] == '\\' && s[1] >= '0' && s[1] <= '7' &&
+		    s[2] >= '0' && s[2] <= '7' && s[3] >= '0' && s[3] <= '7') {
+			*d++ = ((s[1] - '0') << 6) | ((s[2] - '0') << 3) |
+			       (s[3] - '0');
+			s += 4;
+		} else {
+			*d++ = *s++;
+		}
+	}
+
+	*d = '\0';
+}
+
+static int mntent_cmp(const void *a, const void *b)
+{
+	const struct tst_mntent *ma = a, *mb = b;
+
+	if (ma->dir_len != mb->dir_len)
+		return ma->dir_len < mb->dir_len ? 1 : -1;
+
+	return strcmp(ma->dir, mb->dir);
+}
+
+/*
+ * mountinfo fields: id parent major:minor root mountpoint mnt-opts
+ * [optional tags...] - fstype source sb-opts
+ */
+static int parse_line(char *line, struct tst_mntent *mnt)
+{
+	char *tok, *dir = NULL, *mnt_opts = NULL;
+	char *fs_type, *source, *sb_opts;
+	size_t opts_len;
+	int field = 0;
+
+	for (tok = strtok(line, " \n"); tok; tok = strtok(NULL, " \n")) {
+		switch (++field) {
+		case 5:
+			dir = tok;
+			break;
+		case 6:
+			mnt_opts = tok;
+			break;
+		}
+
+		if (field > 6 && !strcmp(tok, "-"))
+			break;
+	}
+
+	fs_type = strtok(NULL, " \n");
+	source = strtok(NULL, " \n");
+	sb_opts = strtok(NULL, " \n");
+
+	if (!dir || !mnt_opts || !fs_type || !source || !sb_opts)
+		return -1;
+
+	/* ignore duplicit record for root fs */
+	if (!strcmp(source, "rootfs"))
+		return -1;
+
+	unescape(dir);
+
+	mnt->dir = strdup(dir);
+	mnt->dir_len = strlen(dir);
+	mnt->fs_type = strdup(fs_type);
+	mnt->f_type = -1;
+
+	opts_len = strlen(mnt_opts) + strlen(sb_opts) + 2;
+	mnt->opts = malloc(opts_len);
+	if (mnt->opts)
+		snprintf(mnt->opts, opts_len, "%s,%s", mnt_opts, sb_opts);
+
+	if (!mnt->dir || !mnt->fs_type || !mnt->opts) {
+		free(mnt->dir);
+		free(mnt->fs_type);
+		free(mnt->opts);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int parse_mountinfo(void)
+{
+	FILE *f;
+	char line[4096];
+	unsigned int cap = 32;
+
+	f = fopen("/proc/self/mountinfo", "r");
+	if (!f)
+		return -1;
+
+	table_free();
+	table = malloc(cap * sizeof(*table));
+	if (!table) {
+		fclose(f);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		if (table_len >= cap) {
+			struct tst_mntent *new;
+
+			cap *= 2;
+			new = realloc(table, cap * sizeof(*table));
+			if (!new)
+				break;
+			table = new;
+		}
+
+		if (!parse_line(line, &table[table_len]))
+			table_len++;
+	}
+
+	fclose(f);
+
+	qsort(table, table_len, sizeof(*table), mntent_cmp);
+	table_epoch = mount_epoch;
+
+	return 0;
+}
+
+struct tst_mntent *tst_mount_table_lookup(const char *path)
+{
+	unsigned int i;
+
+	if (!table || table_epoch != mount_epoch) {
+		if (parse_mountinfo())
+			return NULL;
+	}
+
+	/* sorted longest first, so the first prefix match wins */
+	for (i = 0; i < table_len; i++) {
+		struct tst_mntent *mnt = &table[i];
+
+		if (strncmp(path, mnt->dir, mnt->dir_len))
+			continue;
+
+		if (mnt->dir_len == 1 || path[mnt->dir_len] == '/' ||
+		    path[mnt->dir_len] == '\0')
+			return mnt;
+	}
+
+	return NULL;
+}
+
+int tst_mntent_has_opt(const struct tst_mntent *mnt, const char *opt)
+{
+	const char *tok = mnt->opts;
+	size_t len = strlen(opt);
+
+	while (tok) {
+		if (!strncmp(tok, opt, len) &&
+		    (tok[len] == '\0' || tok[len] == ',' || tok[len] == '='))
+			return 1;
+
+		tok = strchr(tok, ',');
+		if (tok)
+			tok++;
+	}
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_netlink.h"
+
+#define BATCH_BUF_LEN 65536
+
+struct tst_netlink_batch {
+	int fd;
+	uint32_t first_seq;	/* seq of the first queued message */
+	uint32_t next_seq;
+	unsigned int count;	/* queued, not yet acked messages */
+	size_t used;
+	char buf[BATCH_BUF_LEN];
+};
+
+struct tst_netlink_batch *tst_netlink_batch_start(const char *file,
+						  const int lineno, int fd)
+{
+	struct tst_netlink_batch *batch;
+
+	batch = safe_malloc(file, lineno, NULL, sizeof(*batch));
+	memset(batch, 0, sizeof(*batch));
+	batch->fd = fd;
+
+	return batch;
+}
+
+void tst_netlink_batch_add(const char *file, const int lineno,
+			   struct tst_netlink_batch *batch,
+			   struct nlmsghdr *nh, const void *payload)
+{
+	size_t aligned = NLMSG_ALIGN(nh->nlmsg_len);
+
+	if (batch->used + aligned > sizeof(batch->buf)) {
+		tst_brk_(file, lineno, TBROK,
+			"Netlink batch full, flush before adding more (%zu + %zu bytes)",
+			batch->used, aligned);
+		return;
+	}
+
+	if (!batch->count)
+		batch->first_seq = batch->next_seq;
+
+	nh->nlmsg_flags |= NLM_F_ACK;
+	nh->nlmsg_seq = batch->next_seq++;
+
+	memcpy(batch->buf + batch->used, nh, sizeof(*nh));
+	memcpy(batch->buf + batch->used + sizeof(*nh), payload,
+	       nh->nlmsg_len - sizeof(*nh));
+	memset(batch->buf + batch->used + nh->nlmsg_len, 0,
+	       aligned - nh->nlmsg_len);
+
+	batch->used += aligned;
+	batch->count++;
+}
+
+int tst_netlink_batch_send(const char *file, const int lineno,
+			   struct tst_netlink_batch *batch)
+{
+	struct sockaddr_nl sa = { .nl_family = AF_NETLINK };
+	struct iovec iov = { batch->buf, batch->used };
+	struct msghdr msg = {
+		.msg_name = &sa,
+		.msg_namelen = sizeof(sa),
+		.msg_iov = &iov,
+		.msg_iovlen = 1
+	};
+	char recv_buf[BATCH_BUF_LEN];
+	struct nlmsghdr *nh;
+	struct nlmsgerr *err;
+	uint32_t len;
+	int first_error = 0;
+
+	if (!batch->count)
+		return 0;
+
+	safe_sendmsg(file, lineno, batch->used, batch->fd, &msg, 0);
+
+	/*
+	 * Collect one ACK (an NLMSG_ERROR with error zero) or error per
+	 * queued message; the kernel answers in submission order but a
+	 * single recv may return any number of them.
+	 */
+	while (batch->count) {
+		len = safe_netlink_recv(file, lineno, batch->fd, recv_buf,
+					sizeof(recv_buf));
+
+		for (nh = (struct nlmsghdr *)recv_buf;
+		     NLMSG_OK(nh, len);
+		     nh = NLMSG_NEXT(nh, len)) {
+			if (nh->nlmsg_seq < batch->first_seq ||
+			    nh->nlmsg_seq >= batch->next_seq) {
+				tst_brk_(file, lineno, TBROK,
+					"Message out of sequence; type=0x%hx, seq_num=%u",
+					nh->nlmsg_type, nh->nlmsg_seq);
+				return ENODATA;
+			}
+
+			if (nh->nlmsg_type != NLMSG_ERROR) {
+				tst_brk_(file, lineno, TBROK,
+					"Unexpected message type; type=0x%hx, seq_num=%u",
+					nh->nlmsg_type, nh->nlmsg_seq);
+				return ENODATA;
+			}
+
+			err = (struct nlmsgerr *)NLMSG_DATA(nh);
+			if (err->error && !first_error)
+				first_error = err->error;
+
+			batch->count--;
+		}
+	}
+
+	batch->used = 0;
+
+	return first_error;
+}
+
+void tst_netlink_batch_free(struct tst_netlink_batch *batch)
+{
+	free(batch);
+}
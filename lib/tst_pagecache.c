@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_fs.h"
+
+long long tst_pagecache_resident_bytes(int fd, off_t offset, size_t len)
+{
+	size_t pagesize = getpagesize();
+	size_t i, npages, resident = 0;
+	unsigned char *vec;
+	void *addr;
+
+	if (!len)
+		return 0;
+
+	npages = (len + pagesize - 1) / pagesize;
+
+	/*
+	 * The PROT_NONE mapping never faults anything in, it only gives
+	 * mincore() an address range to report on.
+	 */
+	addr = mmap(NULL, len, PROT_NONE, MAP_SHARED, fd, offset);
+	if (addr == MAP_FAILED) {
+		tst_res(TWARN | TERRNO, "mmap() failed");
+		return -1;
+	}
+
+	vec = SAFE_MALLOC(npages);
+
+	if (mincore(addr, len, vec)) {
+		tst_res(TWARN | TERRNO, "mincore() failed");
+		resident = -1;
+		goto out;
+	}
+
+	for (i = 0; i < npages; i++) {
+		if (vec[i] & 1)
+			resident++;
+	}
+
+out:
+	free(vec);
+	SAFE_MUNMAP(addr, len);
+
+	if ((ssize_t)resident < 0)
+		return -1;
+
+	return (long long)resident * pagesize;
+}
+
+long long tst_pagecache_resident_file(const char *path)
+{
+	struct stat st;
+	long long ret;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		tst_res(TWARN | TERRNO, "open(%s) failed", path);
+		return -1;
+	}
+
+	SAFE_FSTAT(fd, &st);
+
+	ret = tst_pagecache_resident_bytes(fd, 0, st.st_size);
+
+	SAFE_CLOSE(fd);
+
+	return ret;
+}
@@ -16,22 +16,21 @@
  */
 
 #include <unistd.h>
-#include <mntent.h>
 #include <stdio.h>
 #include <string.h>
 #include "test.h"
+#include "tst_mount_table.h"
 
 /*
  * Check whether a path is on a filesystem that is mounted with
- * specified flags.
+ * specified flags. The flags come from the cached mount-table
+ * snapshot, so repeated queries do not re-parse proc.
  */
 int tst_path_has_mnt_flags_(void (cleanup_fn)(void),
 		const char *path, const char *flags[])
 {
-	struct mntent *mnt;
-	size_t prefix_max = 0, prefix_len;
+	struct tst_mntent *mnt;
 	int flags_matched = 0;
-	FILE *f;
 	int i;
 	char *tmpdir = NULL;
 
@@ -47,36 +46,18 @@ int tst_path_has_mnt_flags_(void (cleanup_fn)(void),
 		return -1;
 	}
 
-	f = setmntent("/proc/mounts", "r");
-	if (f == NULL) {
+	mnt = tst_mount_table_lookup(path);
+	if (mnt == NULL) {
 		tst_brkm(TBROK | TERRNO, cleanup_fn,
-			"tst_path_has_mnt_flags: failed to open /proc/mounts");
+			"tst_path_has_mnt_flags: no mount entry for %s", path);
 		return -1;
 	}
 
-	while ((mnt = getmntent(f))) {
-		/* ignore duplicit record for root fs */
-		if (!strcmp(mnt->mnt_fsname, "rootfs"))
-			continue;
-
-		prefix_len = strlen(mnt->mnt_dir);
-
-		if (strncmp(path, mnt->mnt_dir, prefix_len) == 0
-				&& prefix_len > prefix_max) {
-			prefix_max = prefix_len;
-			flags_matched = 0;
-			i = 0;
-
-			while (flags[i] != NULL) {
-				if (hasmntopt(mnt, flags[i]) != NULL)
-					flags_matched++;
-				i++;
-			}
-		}
+	for (i = 0; flags[i] != NULL; i++) {
+		if (tst_mntent_has_opt(mnt, flags[i]))
+			flags_matched++;
 	}
 
-	endmntent(f);
-
 	free(tmpdir);
 
 	return flags_matched;
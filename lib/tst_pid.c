@@ -26,39 +26,42 @@
 #include "old_safe_file_ops.h"
 
 #define PID_MAX_PATH "/proc/sys/kernel/pid_max"
+#define LOADAVG_PATH "/proc/loadavg"
 
-pid_t tst_get_unused_pid_(void (*cleanup_fn) (void))
+/* pid_max is fixed for the lifetime of a test unless the test itself
+ * writes the sysctl, in which case tst_flush_pid_max() drops the cache. */
+static int cached_max_pids = -1;
+
+void tst_flush_pid_max(void)
 {
-	pid_t pid;
+	cached_max_pids = -1;
+}
 
-	SAFE_FILE_SCANF(cleanup_fn, PID_MAX_PATH, "%d", &pid);
+static int get_max_pids(void (*cleanup_fn) (void))
+{
+	if (cached_max_pids < 0)
+		SAFE_FILE_SCANF(cleanup_fn, PID_MAX_PATH, "%d",
+				&cached_max_pids);
 
-	return pid;
+	return cached_max_pids;
 }
 
-int tst_get_free_pids_(void (*cleanup_fn) (void))
+pid_t tst_get_unused_pid_(void (*cleanup_fn) (void))
 {
-	FILE *f;
-	int rc, used_pids, max_pids;
-
-	f = popen("ps -eT | wc -l", "r");
-	if (!f) {
-		tst_resm(TBROK, "Could not run 'ps' to calculate used " "pids");
-		return -1;
-	}
-	rc = fscanf(f, "%i", &used_pids);
-	pclose(f);
+	return get_max_pids(cleanup_fn);
+}
 
-	if (rc != 1 || used_pids < 0) {
-		tst_resm(TBROK, "Could not read output of 'ps' to "
-			 "calculate used pids");
-		return -1;
-	}
+int tst_get_free_pids_(void (*cleanup_fn) (void))
+{
+	int used_pids;
 
-	SAFE_FILE_SCANF(cleanup_fn, PID_MAX_PATH, "%d", &max_pids);
+	/* The fourth field of loadavg is running/total tasks; the total
+	 * is the kernel's nr_threads, which is what a full walk of
+	 * /proc (or 'ps -eT') would have counted one entry at a time. */
+	SAFE_FILE_SCANF(cleanup_fn, LOADAVG_PATH, "%*f %*f %*f %*d/%d",
+			&used_pids);
 
-	/* max_pids contains the maximum PID + 1,
-	 * used_pids contains used PIDs + 1,
-	 * so this additional '1' is eliminated by the substraction */
-	return max_pids - used_pids;
+	/* max_pids contains the maximum PID + 1, so the result errs one
+	 * to the safe side */
+	return get_max_pids(cleanup_fn) - used_pids;
 }
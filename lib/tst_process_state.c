@@ -24,41 +24,98 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 
 #include "test.h"
+#include "safe_macros_fn.h"
+#include "safe_file_ops_fn.h"
 #include "tst_process_state.h"
 
+/* pidfd_open() is in the unified syscall number space */
+#ifndef __NR_pidfd_open
+# define __NR_pidfd_open 434
+#endif
+
 int tst_process_state_wait(const char *file, const int lineno,
                             void (*cleanup_fn)(void), pid_t pid,
 			    const char state, unsigned int msec_timeout)
 {
 	char proc_path[128], cur_state;
-	unsigned int msecs = 0;
+	unsigned long long usecs = 0;
+	unsigned int sleep_us = 50;
+	int fd;
+
+	/*
+	 * Zombie is an exit state, so instead of polling for it we can
+	 * sleep on a pidfd until the process dies. On kernels without
+	 * pidfd_open() this falls through to the polling loop below.
+	 */
+	if (state == 'Z') {
+		int pidfd = syscall(__NR_pidfd_open, pid, 0);
+
+		if (pidfd >= 0) {
+			struct pollfd pfd = {.fd = pidfd, .events = POLLIN};
+			int ret;
+
+			do {
+				ret = poll(&pfd, 1,
+					   msec_timeout ? (int)msec_timeout : -1);
+			} while (ret < 0 && errno == EINTR);
+
+			close(pidfd);
+
+			if (ret == 1)
+				return 0;
+
+			if (ret == 0) {
+				errno = ETIMEDOUT;
+				return -1;
+			}
+			/* on poll() failure fall back to polling /proc */
+		}
+	}
 
 	snprintf(proc_path, sizeof(proc_path), "/proc/%i/stat", pid);
+	fd = safe_open(file, lineno, cleanup_fn, proc_path, O_RDONLY);
 
+	/*
+	 * There is no kernel event for a task entering S or T, so these
+	 * have to be polled for, but with an adaptive interval starting
+	 * well below a scheduling tick the common fast transitions are
+	 * caught in tens of microseconds instead of a full millisecond.
+	 */
 	for (;;) {
-		safe_file_scanf(file, lineno, cleanup_fn, proc_path,
-		                "%*i %*s %c", &cur_state);
+		safe_file_scanf_fd(file, lineno, cleanup_fn, fd,
+		                   "%*i %*s %c", &cur_state);
 
 		if (state == cur_state)
 			break;
 
-		usleep(1000);
-		msecs += 1;
+		usleep(sleep_us);
+		usecs += sleep_us;
 
-		if (msec_timeout && msecs >= msec_timeout) {
+		if (sleep_us < 1000)
+			sleep_us *= 2;
+
+		if (msec_timeout && usecs >= 1000ull * msec_timeout) {
+			close(fd);
 			errno = ETIMEDOUT;
 			return -1;
 		}
 	}
 
+	close(fd);
+
 	return 0;
 }
 
 int tst_process_state_wait2(pid_t pid, const char state)
 {
 	char proc_path[128], cur_state;
+	unsigned int sleep_us = 100;
 
 	snprintf(proc_path, sizeof(proc_path), "/proc/%i/stat", pid);
 
@@ -81,6 +138,9 @@ int tst_process_state_wait2(pid_t pid, const char state)
 		if (state == cur_state)
 			return 0;
 
-		usleep(10000);
+		usleep(sleep_us);
+
+		if (sleep_us < 10000)
+			sleep_us *= 2;
 	}
 }
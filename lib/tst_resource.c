@@ -21,7 +21,15 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#define _GNU_SOURCE
 #include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef __linux__
+# include <linux/fs.h>
+#endif
+#include "config.h"
 #include "test.h"
 #include "old_resource.h"
 #include "ltp_priv.h"
@@ -79,12 +87,76 @@ const char *tst_dataroot(void)
 	return dataroot;
 }
 
+/*
+ * Clone a resource file into the tmpdir without reading it through
+ * userspace, with FICLONE (O(1) on reflink filesystems) or in-kernel with
+ * copy_file_range(2). The copy is always a separate inode; sharing one
+ * via link(2) would let a test writing to its "copy" corrupt the
+ * installed fixture for every later run, since tests run as root and
+ * mode bits do not protect the shared inode. Returns 0 on success, on
+ * failure the caller falls back to plain cp.
+ */
+static int fast_copy(const char *src, const char *dst)
+{
+	struct stat st;
+	int src_fd, dst_fd, ret = -1;
+
+	src_fd = open(src, O_RDONLY);
+	if (src_fd < 0)
+		return -1;
+
+	if (fstat(src_fd, &st)) {
+		close(src_fd);
+		return -1;
+	}
+
+	dst_fd = open(dst, O_CREAT | O_WRONLY | O_TRUNC, st.st_mode & 0777);
+	if (dst_fd < 0) {
+		close(src_fd);
+		return -1;
+	}
+
+#ifdef FICLONE
+	if (!ioctl(dst_fd, FICLONE, src_fd))
+		ret = 0;
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+	if (ret) {
+		off_t off = 0;
+		ssize_t len;
+
+		while (off < st.st_size) {
+			len = copy_file_range(src_fd, NULL, dst_fd, NULL,
+					      st.st_size - off, 0);
+			if (len <= 0)
+				break;
+			off += len;
+		}
+
+		if (off == st.st_size)
+			ret = 0;
+	}
+#endif
+
+	close(src_fd);
+	close(dst_fd);
+
+	if (ret)
+		unlink(dst);
+
+	return ret;
+}
+
 static int file_copy(const char *file, const int lineno,
                      void (*cleanup_fn)(void), const char *path,
 		     const char *filename, const char *dest)
 {
 	size_t len = strlen(path) + strlen(filename) + 2;
 	char buf[len];
+	char dst[PATH_MAX];
+	struct stat st;
+	int ret;
 
 	snprintf(buf, sizeof(buf), "%s/%s", path, filename);
 
@@ -92,6 +164,14 @@ static int file_copy(const char *file, const int lineno,
 	if (access(buf, R_OK))
 		return 0;
 
+	if (!stat(dest, &st) && S_ISDIR(st.st_mode))
+		ret = snprintf(dst, sizeof(dst), "%s/%s", dest, filename);
+	else
+		ret = snprintf(dst, sizeof(dst), "%s", dest);
+
+	if (ret > 0 && ret < (int)sizeof(dst) && !fast_copy(buf, dst))
+		return 1;
+
 	safe_cp(file, lineno, cleanup_fn, buf, dest);
 
 	return 1;
@@ -14,6 +14,7 @@
 #endif
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
+#include "lapi/syscalls.h"
 #include "lapi/setns.h"
 #include "tst_safe_macros.h"
 #include "lapi/personality.h"
@@ -444,3 +445,44 @@ void safe_cmd(const char *file, const int lineno, const char *const argv[],
 		tst_brk_(file, lineno, TBROK, "%s failed (%d)", argv[0], rval);
 	}
 }
+
+int safe_getdents64(const char *file, const int lineno, int fd,
+		    void *buf, unsigned int size)
+{
+	int rval;
+
+	rval = tst_syscall(__NR_getdents64, fd, buf, size);
+
+	if (rval == -1) {
+		tst_brk_(file, lineno, TBROK | TERRNO,
+			"getdents64(%i, %p, %u) failed", fd, buf, size);
+	}
+
+	return rval;
+}
+
+int tst_for_each_dirent(const char *path,
+			int (*fn)(const struct tst_dirent64 *d, void *arg),
+			void *arg)
+{
+	char buf[32768];
+	struct tst_dirent64 *d;
+	int fd, nread, pos, ret = 0;
+
+	fd = SAFE_OPEN(path, O_RDONLY | O_DIRECTORY);
+
+	while (!ret) {
+		nread = SAFE_GETDENTS64(fd, buf, sizeof(buf));
+		if (!nread)
+			break;
+
+		for (pos = 0; pos < nread && !ret; pos += d->d_reclen) {
+			d = (struct tst_dirent64 *)(buf + pos);
+			ret = fn(d, arg);
+		}
+	}
+
+	SAFE_CLOSE(fd);
+
+	return ret;
+}
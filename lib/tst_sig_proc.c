@@ -4,12 +4,17 @@
  */
 
 #include <stdlib.h>
+#include <errno.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
 
 #include "tst_sig_proc.h"
 
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
+#include "tst_minmax.h"
+#include "lapi/syscalls.h"
 
 pid_t create_sig_proc(int sig, int count, unsigned int usec)
 {
@@ -29,3 +34,104 @@ pid_t create_sig_proc(int sig, int count, unsigned int usec)
 
 	return cpid;
 }
+
+static void sig_sender(struct tst_sig_sender *slot, int pidfd, int sig,
+		       unsigned long long count)
+{
+	unsigned long long done = 0, batch, i;
+	uint64_t sent = 0, failed = 0;
+
+	while (done < count) {
+		batch = MIN(count - done, 64ULL);
+
+		for (i = 0; i < batch; i++) {
+			if (tst_syscall(__NR_pidfd_send_signal, pidfd, sig,
+					NULL, 0)) {
+				/* The receiver is gone, stop the storm */
+				if (errno == ESRCH)
+					goto out;
+				failed++;
+			} else {
+				sent++;
+			}
+		}
+
+		done += batch;
+		/* Publish the counters once per batch, not per signal */
+		slot->sent = sent;
+		slot->failed = failed;
+	}
+out:
+	slot->sent = sent;
+	slot->failed = failed;
+}
+
+struct tst_sig_storm *create_sig_storm(int sig, unsigned long long count,
+				       unsigned int senders)
+{
+	struct tst_sig_storm *storm;
+	unsigned long long share, extra;
+	pid_t target = getpid();
+	unsigned int i;
+
+	if (!senders)
+		senders = 1;
+
+	storm = SAFE_MMAP(NULL, sizeof(*storm) +
+			  senders * sizeof(struct tst_sig_sender),
+			  PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	storm->senders = senders;
+
+	share = count / senders;
+	extra = count % senders;
+
+	for (i = 0; i < senders; i++) {
+		pid_t cpid = SAFE_FORK();
+
+		if (cpid == 0) {
+			int pidfd;
+
+			pidfd = tst_syscall(__NR_pidfd_open, target, 0);
+			if (pidfd < 0) {
+				tst_brk(TBROK | TERRNO,
+					"pidfd_open(%i) failed", target);
+			}
+
+			sig_sender(&storm->sender[i], pidfd, sig,
+				   share + (i < extra ? 1 : 0));
+			exit(0);
+		}
+
+		storm->sender[i].pid = cpid;
+	}
+
+	return storm;
+}
+
+void wait_sig_storm(struct tst_sig_storm *storm, uint64_t *sent,
+		    uint64_t *failed)
+{
+	uint64_t sent_sum = 0, failed_sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < storm->senders; i++) {
+		/* Storm signals still land here, retry on EINTR */
+		while (waitpid(storm->sender[i].pid, NULL, 0) == -1) {
+			if (errno != EINTR) {
+				tst_brk(TBROK | TERRNO, "waitpid(%i) failed",
+					storm->sender[i].pid);
+			}
+		}
+		sent_sum += storm->sender[i].sent;
+		failed_sum += storm->sender[i].failed;
+	}
+
+	if (sent)
+		*sent = sent_sum;
+	if (failed)
+		*failed = failed_sum;
+
+	SAFE_MUNMAP(storm, sizeof(*storm) +
+		    storm->senders * sizeof(struct tst_sig_sender));
+}
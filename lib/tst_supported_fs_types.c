@@ -11,6 +11,7 @@
 
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
+#include "tst_cache.h"
 #include "tst_fs.h"
 
 static const char *const fs_type_whitelist[] = {
@@ -95,7 +96,24 @@ static int has_kernel_support(const char *fs_type, int flags)
 
 int tst_fs_is_supported(const char *fs_type, int flags)
 {
-	return has_kernel_support(fs_type, flags) && has_mkfs(fs_type);
+	char key[64];
+	int ret;
+
+	/*
+	 * The mkfs and mount.fs probes exec a binary per filesystem, which
+	 * every all_filesystems test would repeat; cache the outcome for the
+	 * rest of the run. The flags are part of the key since they change
+	 * the answer for FUSE filesystems.
+	 */
+	snprintf(key, sizeof(key), "fs_%s_%d", fs_type, flags);
+
+	if (!tst_cache_get_int(key, &ret))
+		return ret;
+
+	ret = has_kernel_support(fs_type, flags) && has_mkfs(fs_type);
+	tst_cache_put_int(key, ret);
+
+	return ret;
 }
 
 const char **tst_get_supported_fs_types(int flags)
@@ -3,6 +3,9 @@
  * Copyright (c) 2018 Jan Stancek <jstancek@redhat.com>
  */
 
+#define _GNU_SOURCE
+
+#include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -14,6 +17,66 @@
 
 static struct tst_sys_conf *save_restore_data;
 
+/*
+ * All the entries live under /proc/sys, so resolve that prefix once and
+ * do the per-entry opens relative to the directory fd. Keeps the lookup
+ * cost of a dozen save_restore entries off every test invocation.
+ */
+static int sys_dirfd(void)
+{
+	static int fd = -2;
+
+	if (fd == -2)
+		fd = open("/proc/sys", O_PATH | O_DIRECTORY | O_CLOEXEC);
+
+	return fd;
+}
+
+static const char *sys_relative(const char *path)
+{
+	if (!strncmp(path, "/proc/sys/", 10))
+		return path + 10;
+
+	return NULL;
+}
+
+static int open_conf(const char *path, int oflag)
+{
+	const char *rel = sys_relative(path);
+	int dirfd = sys_dirfd();
+
+	if (rel && dirfd >= 0)
+		return openat(dirfd, rel, oflag);
+
+	return open(path, oflag);
+}
+
+static int read_conf(const char *path, char *buf, size_t len)
+{
+	char *newline;
+	ssize_t ret;
+	int fd;
+
+	fd = open_conf(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	ret = read(fd, buf, len - 1);
+	close(fd);
+
+	if (ret < 0)
+		return -1;
+
+	buf[ret] = 0;
+
+	/* keep the first line only, as the fgets()-based code did */
+	newline = strchr(buf, '\n');
+	if (newline)
+		newline[1] = 0;
+
+	return 0;
+}
+
 void tst_sys_conf_dump(void)
 {
 	struct tst_sys_conf *i;
@@ -41,8 +104,6 @@ int tst_sys_conf_save_str(const char *path, const char *value)
 int tst_sys_conf_save(const char *path)
 {
 	char line[PATH_MAX];
-	FILE *fp;
-	void *ret;
 	char flag;
 
 	if (!path)
@@ -66,20 +127,7 @@ int tst_sys_conf_save(const char *path)
 		return 1;
 	}
 
-	fp = fopen(path, "r");
-	if (fp == NULL) {
-		if (flag == '?')
-			return 1;
-
-		tst_brk(TBROK | TERRNO, "Failed to open FILE '%s' for reading",
-			path);
-		return 1;
-	}
-
-	ret = fgets(line, sizeof(line), fp);
-	fclose(fp);
-
-	if (ret == NULL) {
+	if (read_conf(path, line, sizeof(line))) {
 		if (flag == '?')
 			return 1;
 
@@ -93,13 +141,37 @@ int tst_sys_conf_save(const char *path)
 void tst_sys_conf_restore(int verbose)
 {
 	struct tst_sys_conf *i;
+	char line[PATH_MAX];
+	int fd;
 
 	for (i = save_restore_data; i; i = i->next) {
+		/* skip values the test did not actually change */
+		if (!read_conf(i->path, line, sizeof(line)) &&
+		    !strcmp(line, i->value)) {
+			if (verbose) {
+				tst_res(TINFO, "Unchanged conf.: %s = %s",
+					i->path, i->value);
+			}
+			continue;
+		}
+
 		if (verbose) {
 			tst_res(TINFO, "Restoring conf.: %s -> %s\n",
 				i->path, i->value);
 		}
-		FILE_PRINTF(i->path, "%s", i->value);
+
+		fd = open_conf(i->path, O_WRONLY);
+		if (fd < 0) {
+			tst_res(TWARN | TERRNO,
+				"Failed to open '%s' for writing", i->path);
+			continue;
+		}
+
+		if (write(fd, i->value, strlen(i->value)) < 0) {
+			tst_res(TWARN | TERRNO, "Failed to write '%s' to '%s'",
+				i->value, i->path);
+		}
+
+		close(fd);
 	}
 }
-
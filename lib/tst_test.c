@@ -3,7 +3,9 @@
  * Copyright (c) 2015-2016 Cyril Hrubis <chrubis@suse.cz>
  */
 
+#define _GNU_SOURCE
 #include <limits.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <unistd.h>
@@ -13,12 +15,16 @@
 #include <sys/mount.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
+#include <linux/futex.h>
 
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
 #include "tst_device.h"
 #include "lapi/futex.h"
 #include "lapi/syscalls.h"
+#include "tst_mount_table.h"
+#include "tst_probe.h"
 #include "tst_ansi_color.h"
 #include "tst_safe_stdio.h"
 #include "tst_timer_test.h"
@@ -27,6 +33,8 @@
 #include "tst_wallclock.h"
 #include "tst_sys_conf.h"
 #include "tst_kconfig.h"
+#include "tst_kmsg.h"
+#include "tst_fault_inject.h"
 
 #include "old_resource.h"
 #include "old_device.h"
@@ -58,10 +66,40 @@ struct results {
 	int warnings;
 	int broken;
 	unsigned int timeout;
+	int ring_enabled;
 };
 
 static struct results *results;
 
+/*
+ * Multi-producer single-consumer ring buffer for test results, lives in the
+ * second page of the shared memory when test.needs_results_ring is set.
+ *
+ * Producers claim a slot by incrementing the head counter, wait until the
+ * slot sequence number matches the claimed position, fill the slot in and
+ * publish it by setting the sequence to position + 1. The drainer process
+ * consumes slots in order and recycles them by advancing the sequence by the
+ * ring size. All waiting is done on futexes so that pushing a message is
+ * async-signal-safe.
+ */
+#define RING_SLOT_MSG_LEN 248
+
+struct ring_slot {
+	int seq;
+	int len;
+	char msg[RING_SLOT_MSG_LEN];
+};
+
+struct results_ring {
+	int head;
+	int stop;
+	struct ring_slot slots[];
+};
+
+static struct results_ring *res_ring;
+static unsigned int res_ring_slots;
+static pid_t res_ring_drainer;
+
 static int ipc_fd;
 
 extern void *tst_futexes;
@@ -81,10 +119,124 @@ long TST_RET;
 static void do_cleanup(void);
 static void do_exit(int ret) __attribute__ ((noreturn));
 
+static void ring_futex_wait(int *uaddr, int val)
+{
+	struct timespec timeout = {0, 100000000};
+
+	syscall(SYS_futex, uaddr, FUTEX_WAIT, val, &timeout);
+}
+
+static void ring_futex_wake(int *uaddr)
+{
+	syscall(SYS_futex, uaddr, FUTEX_WAKE, INT_MAX);
+}
+
+static void results_ring_push(const char *buf, size_t len)
+{
+	unsigned int i, nslots = (len + RING_SLOT_MSG_LEN - 1) / RING_SLOT_MSG_LEN;
+	int pos;
+
+	if (!nslots)
+		nslots = 1;
+
+	/*
+	 * Messages longer than a slot span consecutive slots. The slots
+	 * are claimed with a single head update and published one by one
+	 * as they are filled, so the drainer, which consumes strictly in
+	 * order, glues the fragments back together on output and can
+	 * recycle early fragments while the tail is still being copied.
+	 */
+	pos = tst_atomic_add_return(nslots, &res_ring->head) - nslots;
+
+	for (i = 0; i < nslots; i++) {
+		struct ring_slot *slot =
+			&res_ring->slots[(pos + i) % res_ring_slots];
+		size_t chunk = len - (size_t)i * RING_SLOT_MSG_LEN;
+		int seq;
+
+		if (chunk > RING_SLOT_MSG_LEN)
+			chunk = RING_SLOT_MSG_LEN;
+
+		for (;;) {
+			seq = tst_atomic_load(&slot->seq);
+			if (seq == pos + (int)i)
+				break;
+			/* ring is full, wait for the drainer to recycle the slot */
+			ring_futex_wait(&slot->seq, seq);
+		}
+
+		slot->len = chunk;
+		memcpy(slot->msg, buf + (size_t)i * RING_SLOT_MSG_LEN, chunk);
+		tst_atomic_store(pos + (int)i + 1, &slot->seq);
+		ring_futex_wake(&slot->seq);
+	}
+}
+
+static void results_ring_drainer(void)
+{
+	int tail = 0;
+	int seq;
+
+	for (;;) {
+		struct ring_slot *slot = &res_ring->slots[tail % res_ring_slots];
+
+		seq = tst_atomic_load(&slot->seq);
+
+		if (seq != tail + 1) {
+			if (tst_atomic_load(&res_ring->stop) &&
+			    tst_atomic_load(&res_ring->head) <= tail)
+				break;
+			ring_futex_wait(&slot->seq, seq);
+			continue;
+		}
+
+		if (write(STDERR_FILENO, slot->msg, slot->len) < 0) {
+			/* nothing better to do than to retry */
+		}
+
+		tst_atomic_store(tail + (int)res_ring_slots, &slot->seq);
+		ring_futex_wake(&slot->seq);
+		tail++;
+	}
+}
+
+static void results_ring_start(void)
+{
+	res_ring_drainer = fork();
+
+	if (res_ring_drainer < 0)
+		tst_brk(TBROK | TERRNO, "fork() drainer");
+
+	if (!res_ring_drainer) {
+		results_ring_drainer();
+		_exit(0);
+	}
+}
+
+static void results_ring_stop(void)
+{
+	unsigned int i;
+
+	if (!res_ring_drainer || getpid() != lib_pid)
+		return;
+
+	tst_atomic_store(1, &res_ring->stop);
+	for (i = 0; i < res_ring_slots; i++)
+		ring_futex_wake(&res_ring->slots[i].seq);
+
+	waitpid(res_ring_drainer, NULL, 0);
+	res_ring_drainer = 0;
+	/* late messages from the cleanup go directly to stderr */
+	res_ring = NULL;
+}
+
 static void setup_ipc(void)
 {
 	size_t size = getpagesize();
 
+	if (tst_test->needs_results_ring)
+		size *= 2;
+
 	if (access("/dev/shm", F_OK) == 0) {
 		snprintf(shm_path, sizeof(shm_path), "/dev/shm/ltp_%s_%d",
 		         tid, getpid());
@@ -121,7 +273,23 @@ static void setup_ipc(void)
 
 	if (tst_test->needs_checkpoints) {
 		tst_futexes = (char*)results + sizeof(struct results);
-		tst_max_futexes = (size - sizeof(struct results))/sizeof(futex_t);
+		tst_max_futexes =
+			(getpagesize() - sizeof(struct results))/sizeof(futex_t);
+	}
+
+	if (tst_test->needs_results_ring) {
+		unsigned int i;
+
+		res_ring = (struct results_ring *)
+			   ((char *)results + getpagesize());
+		res_ring_slots = (getpagesize() - sizeof(struct results_ring)) /
+				 sizeof(struct ring_slot);
+
+		for (i = 0; i < res_ring_slots; i++)
+			res_ring->slots[i].seq = i;
+
+		results->ring_enabled = 1;
+		results_ring_start();
 	}
 }
 
@@ -129,6 +297,11 @@ static void cleanup_ipc(void)
 {
 	size_t size = getpagesize();
 
+	results_ring_stop();
+
+	if (results && results->ring_enabled)
+		size *= 2;
+
 	if (ipc_fd > 0 && close(ipc_fd))
 		tst_res(TWARN | TERRNO, "close(ipc_fd) failed");
 
@@ -157,6 +330,16 @@ void tst_reinit(void)
 	fd = SAFE_OPEN(path, O_RDWR);
 
 	results = SAFE_MMAP(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (results->ring_enabled) {
+		SAFE_MUNMAP((void *)results, size);
+		results = SAFE_MMAP(NULL, 2 * size, PROT_READ | PROT_WRITE,
+				    MAP_SHARED, fd, 0);
+		res_ring = (struct results_ring *)((char *)results + size);
+		res_ring_slots = (size - sizeof(struct results_ring)) /
+				 sizeof(struct ring_slot);
+	}
+
 	tst_futexes = (char*)results + sizeof(struct results);
 	tst_max_futexes = (size - sizeof(struct results))/sizeof(futex_t);
 
@@ -187,6 +370,13 @@ static void update_results(int ttype)
 	}
 }
 
+int tst_quiet_pass_;
+
+void tst_count_pass_(void)
+{
+	update_results(TPASS);
+}
+
 static void print_result(const char *file, const int lineno, int ttype,
                          const char *fmt, va_list va)
 {
@@ -266,8 +456,14 @@ static void print_result(const char *file, const int lineno, int ttype,
 
 	snprintf(str, size, "\n");
 
-	/* we might be called from signal handler, so use write() */
 	buflen = str - buf + 1;
+
+	if (res_ring) {
+		results_ring_push(buf, buflen);
+		return;
+	}
+
+	/* we might be called from signal handler, so use write() */
 	str = buf;
 	while (buflen) {
 		ret = write(STDERR_FILENO, str, buflen);
@@ -686,6 +882,9 @@ static void print_failure_hints(void)
 
 static void do_exit(int ret)
 {
+	/* make sure all buffered results are written out before the summary */
+	results_ring_stop();
+
 	if (results) {
 		if (results->passed && ret == TCONF)
 			ret = 0;
@@ -852,6 +1051,74 @@ static void prepare_and_mount_dev_fs(const char *mntpoint)
 	}
 }
 
+/*
+ * Constants for the new mount API; duplicated here with fallback guards
+ * since lapi/fsmount.h defines non-static fallback functions and cannot
+ * be included from the library.
+ */
+#ifndef FSOPEN_CLOEXEC
+# define FSOPEN_CLOEXEC 0x00000001
+#endif
+
+#ifndef FSMOUNT_CLOEXEC
+# define FSMOUNT_CLOEXEC 0x00000001
+#endif
+
+#ifndef MOVE_MOUNT_F_EMPTY_PATH
+# define MOVE_MOUNT_F_EMPTY_PATH 0x00000004
+#endif
+
+#define LTP_FSCONFIG_SET_STRING 1
+#define LTP_FSCONFIG_CMD_CREATE 6
+
+/*
+ * Mounts dev read-write on mntpoint via fsopen()/fsconfig()/fsmount()/
+ * move_mount(). The split sequence avoids the string option parsing and
+ * lets the all_filesystems cycle skip the compatibility paths of
+ * mount(2), which adds up over the per-fs iterations. Returns non-zero
+ * when the new API is unusable so the caller can fall back to mount(2);
+ * an ENOSYS disables further attempts for the rest of the test run.
+ */
+static int new_api_mount(const char *dev, const char *mntpoint,
+			 const char *fs_type)
+{
+	static int have_new_mount_api = 1;
+	int fsfd, mfd, ret = 1;
+
+	if (!have_new_mount_api)
+		return 1;
+
+	fsfd = syscall(__NR_fsopen, fs_type, FSOPEN_CLOEXEC);
+	if (fsfd < 0) {
+		if (errno == ENOSYS)
+			have_new_mount_api = 0;
+		return 1;
+	}
+
+	if (dev && syscall(__NR_fsconfig, fsfd, LTP_FSCONFIG_SET_STRING,
+			   "source", dev, 0))
+		goto out;
+
+	if (syscall(__NR_fsconfig, fsfd, LTP_FSCONFIG_CMD_CREATE,
+		    NULL, NULL, 0))
+		goto out;
+
+	mfd = syscall(__NR_fsmount, fsfd, FSMOUNT_CLOEXEC, 0);
+	if (mfd < 0)
+		goto out;
+
+	if (!syscall(__NR_move_mount, mfd, "", AT_FDCWD, mntpoint,
+		     MOVE_MOUNT_F_EMPTY_PATH)) {
+		tst_mount_epoch_bump();
+		ret = 0;
+	}
+
+	SAFE_CLOSE(mfd);
+out:
+	SAFE_CLOSE(fsfd);
+	return ret;
+}
+
 static void prepare_device(void)
 {
 	if (tst_test->format_device) {
@@ -866,14 +1133,19 @@ static void prepare_device(void)
 	}
 
 	if (tst_test->mount_device) {
-		SAFE_MOUNT(tdev.dev, tst_test->mntpoint, tdev.fs_type,
-			   tst_test->mnt_flags, tst_test->mnt_data);
+		if (tst_test->mnt_flags || tst_test->mnt_data ||
+		    new_api_mount(tdev.dev, tst_test->mntpoint, tdev.fs_type)) {
+			SAFE_MOUNT(tdev.dev, tst_test->mntpoint, tdev.fs_type,
+				   tst_test->mnt_flags, tst_test->mnt_data);
+		}
 		mntpoint_mounted = 1;
 	}
 }
 
 static void do_setup(int argc, char *argv[])
 {
+	TST_PROBE(setup_start);
+
 	if (!tst_test)
 		tst_brk(TBROK, "No tests to run");
 
@@ -936,11 +1208,19 @@ static void do_setup(int argc, char *argv[])
 
 	setup_ipc();
 
+	tst_quiet_pass_ = getenv("LTP_QUIET_PASS") != NULL;
+
 	if (tst_test->bufs)
 		tst_buffers_alloc(tst_test->bufs);
 
-	if (needs_tmpdir() && !tst_tmpdir_created())
+	if (tst_test->tmpdir_tmpfs)
+		tst_tmpdir_use_tmpfs(tst_test->dev_min_size);
+
+	if (needs_tmpdir() && !tst_tmpdir_created()) {
+		TST_PROBE(tmpdir_start);
 		tst_tmpdir();
+		TST_PROBE(tmpdir_end);
+	}
 
 	if (tst_test->save_restore) {
 		const char * const *name = tst_test->save_restore;
@@ -982,7 +1262,9 @@ static void do_setup(int argc, char *argv[])
 	}
 
 	if (tst_test->needs_device && !mntpoint_mounted) {
+		TST_PROBE(device_start);
 		tdev.dev = tst_acquire_device_(NULL, tst_test->dev_min_size);
+		TST_PROBE(device_end);
 
 		if (!tdev.dev)
 			tst_brk(TCONF, "Failed to acquire device");
@@ -1017,6 +1299,10 @@ static void do_setup(int argc, char *argv[])
 
 	if (tst_test->taint_check)
 		tst_taint_init(tst_test->taint_check);
+
+	tst_kmsg_init(tid);
+
+	TST_PROBE(setup_end);
 }
 
 static void do_test_setup(void)
@@ -1068,7 +1354,9 @@ static void run_tests(void)
 
 	if (!tst_test->test) {
 		saved_results = *results;
+		TST_PROBE1(iteration_start, 0);
 		tst_test->test_all();
+		TST_PROBE1(iteration_end, 0);
 
 		if (getpid() != main_pid) {
 			exit(0);
@@ -1083,7 +1371,9 @@ static void run_tests(void)
 
 	for (i = 0; i < tst_test->tcnt; i++) {
 		saved_results = *results;
+		TST_PROBE1(iteration_start, i);
 		tst_test->test(i);
+		TST_PROBE1(iteration_end, i);
 
 		if (getpid() != main_pid) {
 			exit(0);
@@ -1134,13 +1424,24 @@ static void heartbeat(void)
 static void testrun(void)
 {
 	unsigned int i = 0;
+	unsigned int fault_cfgs;
 	unsigned long long stop_time = 0;
+	unsigned long long now, last_heartbeat = 0;
 	int cont = 1;
 
 	heartbeat();
 	add_paths();
 	do_test_setup();
 
+	/*
+	 * A fault sweep multiplies the iterations so that the test runs
+	 * under each fault configuration, all within a single test
+	 * process.
+	 */
+	fault_cfgs = tst_fault_sweep_init();
+	if (fault_cfgs)
+		iterations *= fault_cfgs;
+
 	if (duration > 0)
 		stop_time = get_time_ms() + (unsigned long long)(duration * 1000);
 
@@ -1158,10 +1459,25 @@ static void testrun(void)
 		if (!cont)
 			break;
 
+		if (fault_cfgs)
+			tst_fault_sweep_apply(i - 1);
+
 		run_tests();
-		heartbeat();
+
+		/*
+		 * The timeout has a second granularity so one heartbeat per
+		 * second is enough to hold it off; signalling the library
+		 * process on every iteration adds up with -i 10000 and short
+		 * test functions.
+		 */
+		now = get_time_ms();
+		if (now - last_heartbeat >= 1000) {
+			heartbeat();
+			last_heartbeat = now;
+		}
 	}
 
+	tst_fault_sweep_stop();
 	do_test_cleanup();
 	exit(0);
 }
@@ -1268,9 +1584,35 @@ void tst_set_timeout(int timeout)
 		heartbeat();
 }
 
+/*
+ * Emits one machine-parseable line with the resource usage of the test
+ * child, so a runner parsing the result stream can tell which tests burn
+ * the CPU, memory and I/O of a run. The CPU times come split from the
+ * wall time, so off-CPU tests (sleepers, I/O bound) can be told apart
+ * from compute-bound ones.
+ */
+static void print_rusage(const struct rusage *ru, unsigned long long wall_ms)
+{
+	unsigned long long utime_ms, stime_ms;
+
+	if (!getenv("LTP_RUSAGE"))
+		return;
+
+	utime_ms = ru->ru_utime.tv_sec * 1000ULL + ru->ru_utime.tv_usec / 1000;
+	stime_ms = ru->ru_stime.tv_sec * 1000ULL + ru->ru_stime.tv_usec / 1000;
+
+	tst_res(TINFO,
+		"rusage: wall_ms=%llu utime_ms=%llu stime_ms=%llu maxrss_kb=%li minflt=%li majflt=%li inblock=%li oublock=%li vcsw=%li ivcsw=%li",
+		wall_ms, utime_ms, stime_ms, ru->ru_maxrss,
+		ru->ru_minflt, ru->ru_majflt, ru->ru_inblock, ru->ru_oublock,
+		ru->ru_nvcsw, ru->ru_nivcsw);
+}
+
 static int fork_testrun(void)
 {
-	int status;
+	int status, ret;
+	struct rusage ru;
+	unsigned long long wall_start;
 
 	if (tst_test->timeout)
 		tst_set_timeout(tst_test->timeout);
@@ -1279,6 +1621,10 @@ static int fork_testrun(void)
 
 	SAFE_SIGNAL(SIGINT, sigint_handler);
 
+	wall_start = get_time_ms();
+
+	TST_PROBE(testrun_start);
+
 	test_pid = fork();
 	if (test_pid < 0)
 		tst_brk(TBROK | TERRNO, "fork()");
@@ -1291,10 +1637,23 @@ static int fork_testrun(void)
 		testrun();
 	}
 
-	SAFE_WAITPID(test_pid, &status, 0);
+	/* wait4() so that the child rusage comes with the status */
+	do {
+		ret = wait4(test_pid, &status, 0, &ru);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0)
+		tst_brk(TBROK | TERRNO, "wait4()");
+
 	alarm(0);
 	SAFE_SIGNAL(SIGINT, SIG_DFL);
 
+	TST_PROBE2(testrun_end, status, get_time_ms() - wall_start);
+
+	print_rusage(&ru, get_time_ms() - wall_start);
+
+	tst_kmsg_check();
+
 	if (tst_test->taint_check && tst_taint_check()) {
 		tst_res(TFAIL, "Kernel is now tainted.");
 		return TFAIL;
@@ -1315,6 +1674,100 @@ static int fork_testrun(void)
 	return 0;
 }
 
+/*
+ * Runs the per-filesystem iterations concurrently, one child per
+ * filesystem. Each child becomes the library process for its own
+ * fork_testrun() - so the timeout watchdog and heartbeats work
+ * unchanged - and unshares its mount namespace so that every
+ * filesystem can be mounted on the same mntpoint path, backed by a
+ * loop device of its own. The matrix then takes as long as the
+ * slowest single filesystem.
+ */
+static int run_tcases_per_fs_parallel(const char *const *filesystems)
+{
+	int ret = 0, status;
+	unsigned int i, nfs;
+	pid_t *pids;
+
+	for (nfs = 0; filesystems[nfs]; nfs++);
+
+	pids = malloc(nfs * sizeof(pid_t));
+	if (!pids)
+		tst_brk(TBROK, "malloc() failed");
+
+	tst_res(TINFO, "Testing %u filesystems in parallel", nfs);
+
+	for (i = 0; i < nfs; i++) {
+		pids[i] = fork();
+		if (pids[i] < 0)
+			tst_brk(TBROK | TERRNO, "fork()");
+
+		if (!pids[i]) {
+			char dev_file[64];
+
+			lib_pid = getpid();
+
+			SAFE_UNSHARE(CLONE_NEWNS);
+			SAFE_MOUNT("none", "/", NULL, MS_REC | MS_PRIVATE,
+				   NULL);
+
+			snprintf(dev_file, sizeof(dev_file),
+				 "test_dev_%s.img", filesystems[i]);
+			tdev.dev = tst_acquire_loop_device(
+					tst_test->dev_min_size, dev_file);
+			if (!tdev.dev) {
+				tst_brk(TCONF, "Failed to acquire device for %s",
+					filesystems[i]);
+			}
+			tdev.fs_type = filesystems[i];
+
+			tst_res(TINFO, "Testing on %s", filesystems[i]);
+			prepare_device();
+
+			status = fork_testrun();
+
+			if (mntpoint_mounted) {
+				tst_umount_detach(tst_test->mntpoint);
+				mntpoint_mounted = 0;
+			}
+
+			tst_detach_device(tdev.dev);
+			exit(status);
+		}
+	}
+
+	for (i = 0; i < nfs; i++) {
+		pid_t p;
+
+		do {
+			p = waitpid(pids[i], &status, 0);
+		} while (p < 0 && errno == EINTR);
+
+		if (p < 0)
+			tst_brk(TBROK | TERRNO, "waitpid()");
+
+		if (WIFEXITED(status)) {
+			if (WEXITSTATUS(status) & ~TCONF) {
+				tst_res(TINFO, "%s: child returned %i",
+					filesystems[i], WEXITSTATUS(status));
+			}
+			ret |= WEXITSTATUS(status);
+			continue;
+		}
+
+		if (WIFSIGNALED(status)) {
+			tst_res(TINFO, "%s: child killed by %s",
+				filesystems[i],
+				tst_strsig(WTERMSIG(status)));
+			ret |= TBROK;
+		}
+	}
+
+	free(pids);
+
+	return ret;
+}
+
 static int run_tcases_per_fs(void)
 {
 	int ret = 0;
@@ -1324,6 +1777,9 @@ static int run_tcases_per_fs(void)
 	if (!filesystems[0])
 		tst_brk(TCONF, "There are no supported filesystems");
 
+	if (getenv("LTP_ALL_FILESYSTEMS_PARALLEL"))
+		return run_tcases_per_fs_parallel(filesystems);
+
 	for (i = 0; filesystems[i]; i++) {
 
 		tst_res(TINFO, "Testing on %s", filesystems[i]);
@@ -1333,8 +1789,13 @@ static int run_tcases_per_fs(void)
 
 		ret = fork_testrun();
 
+		/*
+		 * The device is either reformatted by the next iteration or
+		 * discarded, so a detached umount is enough and skips the
+		 * EBUSY retries on transient mntpoint holders.
+		 */
 		if (mntpoint_mounted) {
-			tst_umount(tst_test->mntpoint);
+			tst_umount_detach(tst_test->mntpoint);
 			mntpoint_mounted = 0;
 		}
 
@@ -3,7 +3,10 @@
  * Copyright (c) 2017 Cyril Hrubis <chrubis@suse.cz>
  */
 
+#define _GNU_SOURCE
 #include <sys/prctl.h>
+#include <sys/mman.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
@@ -12,6 +15,7 @@
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
 #include "tst_clocks.h"
+#include "tst_hist.h"
 #include "tst_timer_test.h"
 
 #define MAX_SAMPLES 500
@@ -29,11 +33,22 @@ static unsigned int timerslack;
 static int virt_env;
 
 static char *print_frequency_plot;
+static char *parallel_sampling;
 static char *file_name;
+static char *hist_file_name;
 static char *str_sleep_time;
 static char *str_sample_cnt;
+static char *str_hist_bits;
 static int sleep_time = -1;
 static int sample_cnt;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static struct tst_hist hist;
+
+/* online CPUs sampled concurrently, 0 in single threaded mode */
+static unsigned int nworkers;
+static int *worker_cpus;
+static unsigned int worker_stride;
 
 static void print_line(char c, int len)
 {
@@ -156,6 +171,51 @@ void tst_timer_sample(void)
 	samples[cur_sample++] = tst_timer_elapsed_us();
 }
 
+static void hist_fill(unsigned int nsamples)
+{
+	unsigned int i;
+
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < nsamples; i++)
+		tst_hist_add(&hist, samples[i]);
+}
+
+static void write_hist_file(long long usec, unsigned int nsamples)
+{
+	unsigned int i;
+	FILE *f;
+
+	if (!hist_file_name)
+		return;
+
+	f = fopen(hist_file_name, "w");
+
+	if (!f) {
+		tst_res(TWARN | TERRNO,
+			"Failed to open '%s'", hist_file_name);
+		return;
+	}
+
+	fprintf(f, "# %s sleep %llius samples %u bits %i\n",
+		scall, usec, nsamples, hist_bits);
+	fprintf(f, "# p50 %lli p90 %lli p99 %lli p99.9 %lli\n",
+		tst_hist_percentile(&hist, 50), tst_hist_percentile(&hist, 90),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
+	for (i = 0; i < hist.nbuckets; i++) {
+		if (hist.buckets[i])
+			fprintf(f, "%lli %u\n",
+				tst_hist_bucket_low(&hist, i), hist.buckets[i]);
+	}
+
+	if (fclose(f)) {
+		tst_res(TWARN | TERRNO,
+			"Failed to close file '%s'", hist_file_name);
+	}
+}
+
 static int cmp(const void *a, const void *b)
 {
 	const long long *aa = a, *bb = b;
@@ -231,6 +291,105 @@ static void write_to_file(void)
 }
 
 
+/*
+ * Runs the sampling loop simultaneously on every online CPU, one forked
+ * worker pinned per CPU, each filling its own slice of the shared
+ * samples array. Per-core timer misbehavior that a single migrating
+ * thread would average away stays visible in the per-CPU slices, and
+ * the wall time for a given per-CPU sample count stays that of a single
+ * thread.
+ *
+ * Returns non-zero when a worker's sampling function failed.
+ */
+static int parallel_sample(long long usec, unsigned int nsamples)
+{
+	unsigned int w;
+	int status, failed = 0;
+	pid_t *pids = SAFE_MALLOC(nworkers * sizeof(pid_t));
+
+	for (w = 0; w < nworkers; w++) {
+		pids[w] = SAFE_FORK();
+
+		if (!pids[w]) {
+			cpu_set_t set;
+			unsigned int i;
+
+			CPU_ZERO(&set);
+			CPU_SET(worker_cpus[w], &set);
+
+			if (sched_setaffinity(0, sizeof(set), &set)) {
+				tst_res(TWARN | TERRNO,
+					"Failed to pin worker to CPU %i",
+					worker_cpus[w]);
+			}
+
+			samples += (size_t)w * worker_stride;
+			cur_sample = 0;
+
+			for (i = 0; i < nsamples; i++) {
+				if (sample(CLOCK_MONOTONIC, usec))
+					exit(1);
+			}
+
+			exit(0);
+		}
+	}
+
+	for (w = 0; w < nworkers; w++) {
+		SAFE_WAITPID(pids[w], &status, 0);
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			failed = 1;
+	}
+
+	free(pids);
+
+	if (failed)
+		tst_res(TINFO, "sampling function failed, exitting");
+
+	return failed;
+}
+
+/*
+ * Sorts each per-CPU slice and reports its extremes, so that a single
+ * core sleeping long (TSC sync trouble, deep idle exit) shows up even
+ * when the merged statistics pass. The slices stay sample arrays, the
+ * caller re-sorts the whole buffer afterwards.
+ */
+static void report_per_cpu(long long usec, unsigned int nsamples,
+			   long long per_call_threshold)
+{
+	long long min_median = LLONG_MAX, max_median = 0;
+	unsigned int w;
+
+	for (w = 0; w < nworkers; w++) {
+		long long *slice = samples + (size_t)w * worker_stride;
+		long long median;
+		unsigned int i;
+
+		qsort(slice, nsamples, sizeof(slice[0]), cmp);
+
+		for (i = 0; slice[i] > 10 * usec && i < nsamples; i++) {
+			if (slice[i] <= 3 * monotonic_resolution)
+				break;
+		}
+
+		median = slice[nsamples/2];
+		min_median = MIN(min_median, median);
+		max_median = MAX(max_median, median);
+
+		tst_res(TINFO,
+			"cpu %3i: min %llius, max %llius, median %llius, %u outliners",
+			worker_cpus[w], slice[nsamples-1], slice[0], median, i);
+	}
+
+	if (max_median - min_median > per_call_threshold) {
+		tst_res(TWARN,
+			"Per-CPU medians spread by %llius, exceeds the %llius threshold",
+			max_median - min_median, per_call_threshold);
+	}
+}
+
 /*
  * Timer testing function.
  *
@@ -254,21 +413,45 @@ static void write_to_file(void)
 void do_timer_test(long long usec, unsigned int nsamples)
 {
 	long long trunc_mean, median;
-	unsigned int discard = compute_discard(nsamples);
-	unsigned int keep_samples = nsamples - discard;
+	unsigned int total = nsamples * MAX(nworkers, 1u);
+	unsigned int discard = compute_discard(total);
+	unsigned int keep_samples = total - discard;
 	long long threshold = compute_threshold(usec, keep_samples);
 	int i;
 	int failed = 0;
 
-	tst_res(TINFO,
-		"%s sleeping for %llius %u iterations, threshold %.2fus",
-		scall, usec, nsamples, 1.00 * threshold / (keep_samples));
+	if (nworkers) {
+		tst_res(TINFO,
+			"%s sleeping for %llius %u iterations on each of %u CPUs, threshold %.2fus",
+			scall, usec, nsamples, nworkers,
+			1.00 * threshold / (keep_samples));
+	} else {
+		tst_res(TINFO,
+			"%s sleeping for %llius %u iterations, threshold %.2fus",
+			scall, usec, nsamples, 1.00 * threshold / (keep_samples));
+	}
 
 	cur_sample = 0;
-	for (i = 0; i < (int)nsamples; i++) {
-		if (sample(CLOCK_MONOTONIC, usec)) {
-			tst_res(TINFO, "sampling function failed, exitting");
+	if (nworkers) {
+		if (parallel_sample(usec, nsamples))
 			return;
+
+		report_per_cpu(usec, nsamples, threshold / keep_samples);
+
+		/* compact the slices so the merged analysis sees one array */
+		for (i = 1; i < (int)nworkers; i++) {
+			memmove(samples + (size_t)i * nsamples,
+				samples + (size_t)i * worker_stride,
+				nsamples * sizeof(samples[0]));
+		}
+
+		nsamples = total;
+	} else {
+		for (i = 0; i < (int)nsamples; i++) {
+			if (sample(CLOCK_MONOTONIC, usec)) {
+				tst_res(TINFO, "sampling function failed, exitting");
+				return;
+			}
 		}
 	}
 
@@ -276,6 +459,9 @@ void do_timer_test(long long usec, unsigned int nsamples)
 
 	write_to_file();
 
+	hist_fill(nsamples);
+	write_hist_file(usec, nsamples);
+
 	for (i = 0; samples[i] > 10 * usec && i < (int)nsamples; i++) {
 		if (samples[i] <= 3 * monotonic_resolution)
 			break;
@@ -307,6 +493,11 @@ void do_timer_test(long long usec, unsigned int nsamples)
 		samples[nsamples-1], samples[0], median,
 		1.00 * trunc_mean / keep_samples, discard);
 
+	tst_res(TINFO, "p50 %llius, p90 %llius, p99 %llius, p99.9 %llius",
+		tst_hist_percentile(&hist, 50), tst_hist_percentile(&hist, 90),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
 	if (virt_env) {
 		tst_res(TINFO,
 			"Virtualisation detected, skipping oversleep checks");
@@ -374,14 +565,58 @@ static void timer_setup(void)
 #endif /* PR_GET_TIMERSLACK */
 	parse_timer_opts();
 
-	samples = SAFE_MALLOC(sizeof(long long) * MAX(MAX_SAMPLES, sample_cnt));
+	worker_stride = MAX(MAX_SAMPLES, sample_cnt);
+
+	if (parallel_sampling) {
+		cpu_set_t set;
+		int i;
+
+		CPU_ZERO(&set);
+
+		if (sched_getaffinity(0, sizeof(set), &set))
+			tst_brk(TBROK | TERRNO, "sched_getaffinity()");
+
+		worker_cpus = SAFE_MALLOC(CPU_COUNT(&set) * sizeof(int));
+
+		for (i = 0; i < CPU_SETSIZE; i++) {
+			if (CPU_ISSET(i, &set))
+				worker_cpus[nworkers++] = i;
+		}
+
+		if (nworkers < 2) {
+			tst_res(TINFO,
+				"Only one CPU online, parallel sampling disabled");
+			nworkers = 0;
+			free(worker_cpus);
+			worker_cpus = NULL;
+		}
+	}
+
+	if (nworkers) {
+		samples = SAFE_MMAP(NULL,
+				    sizeof(long long) * nworkers * worker_stride,
+				    PROT_READ | PROT_WRITE,
+				    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	} else {
+		samples = SAFE_MALLOC(sizeof(long long) * worker_stride);
+	}
+
+	tst_hist_init(&hist, hist_bits);
 	if (set_latency() < 0)
 		tst_res(TINFO, "Failed to set zero latency constraint: %m");
 }
 
 static void timer_cleanup(void)
 {
-	free(samples);
+	if (nworkers) {
+		SAFE_MUNMAP(samples,
+			    sizeof(long long) * nworkers * worker_stride);
+	} else {
+		free(samples);
+	}
+
+	free(worker_cpus);
+	tst_hist_free(&hist);
 
 	if (cleanup)
 		cleanup();
@@ -412,9 +647,12 @@ static void single_timer_test(void)
 
 static struct tst_option options[] = {
 	{"p",  &print_frequency_plot, "-p       Print frequency plot"},
+	{"P",  &parallel_sampling, "-P       Sample on all online CPUs in parallel, one pinned worker each"},
 	{"s:", &str_sleep_time, "-s us    Sleep time"},
 	{"n:", &str_sample_cnt, "-n uint  Number of samples to take"},
 	{"f:", &file_name, "-f fname Write measured samples into a file"},
+	{"b:", &str_hist_bits, "-b bits  Histogram sub-bucket bits, sets resolution to 2^-bits (default 7)"},
+	{"x:", &hist_file_name, "-x fname Write histogram and percentiles into a file"},
 	{NULL, NULL, NULL}
 };
 
@@ -434,6 +672,13 @@ static void parse_timer_opts(void)
 		}
 	}
 
+	if (str_hist_bits) {
+		if (tst_parse_int(str_hist_bits, &hist_bits, 1, 16)) {
+			tst_brk(TBROK,
+				"Invalid histogram bits '%s'", str_hist_bits);
+		}
+	}
+
 	if (str_sleep_time || str_sample_cnt) {
 		if (sleep_time < 0)
 			sleep_time = 10000;
@@ -465,6 +710,8 @@ struct tst_test *tst_timer_test_setup(struct tst_test *timer_test)
 	timer_test->tcnt = ARRAY_SIZE(tcases);
 	timer_test->sample = NULL;
 	timer_test->options = options;
+	/* for the workers the parallel sampling mode forks */
+	timer_test->forks_child = 1;
 
 	test = timer_test;
 
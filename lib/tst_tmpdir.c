@@ -58,8 +58,10 @@
  *********************************************************/
 #define _GNU_SOURCE
 #include <sys/mman.h>
+#include <sys/mount.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <assert.h>
 #include <errno.h>
 #include <libgen.h>
@@ -80,6 +82,9 @@
  */
 #define DIR_MODE	(S_IRWXU|S_IRWXG|S_IRWXO)
 
+/* upper bound on the workers forked to purge subtrees in parallel */
+#define PURGE_MAX_WORKERS 4
+
 #ifndef PATH_MAX
 #ifdef MAXPATHLEN
 #define PATH_MAX	MAXPATHLEN
@@ -96,11 +101,51 @@ static char *TESTDIR = NULL;	/* the directory created */
 
 static char test_start_work_dir[PATH_MAX];
 
+/* tmpfs backing requested by tst_tmpdir_use_tmpfs() */
+static int tmpdir_use_tmpfs;
+static unsigned int tmpdir_tmpfs_size_mb;
+static int tmpdir_tmpfs_mounted;
+
 /* lib/tst_checkpoint.c */
 extern futex_t *tst_futexes;
 
 static int rmobj(const char *obj, char **errmsg);
 
+void tst_tmpdir_use_tmpfs(unsigned int size_mb)
+{
+	tmpdir_use_tmpfs = 1;
+	tmpdir_tmpfs_size_mb = size_mb;
+}
+
+static void tmpdir_mount_tmpfs(void)
+{
+	char opts[64];
+	unsigned int size_mb = tmpdir_tmpfs_size_mb;
+	const char *env = getenv("LTP_TMPDIR_TMPFS");
+	int use = tmpdir_use_tmpfs;
+
+	if (env)
+		use = atoi(env);
+
+	if (!use)
+		return;
+
+	if (!size_mb)
+		size_mb = 256;
+
+	snprintf(opts, sizeof(opts), "size=%um,mode=1777", size_mb);
+
+	if (mount("ltp-tmpfs", TESTDIR, "tmpfs", 0, opts)) {
+		tst_resm(TINFO,
+			 "Can't mount tmpfs on %s, staying on TMPDIR: %s",
+			 TESTDIR, strerror(errno));
+		return;
+	}
+
+	tst_resm(TINFO, "Mounted %uMB tmpfs on %s", size_mb, TESTDIR);
+	tmpdir_tmpfs_mounted = 1;
+}
+
 int tst_tmpdir_created(void)
 {
 	return TESTDIR != NULL;
@@ -169,6 +214,154 @@ static int purge_dir(const char *path, char **errptr)
 	return ret_val;
 }
 
+/*
+ * Empties the directory referred to by dirfd with dirfd-relative
+ * unlinkat() batches, recursing into subdirectories. Takes ownership
+ * of dirfd. Best effort - whatever cannot be removed is left behind
+ * for the serial walk to report on.
+ */
+static int purge_dirfd(int dirfd)
+{
+	DIR *dir;
+	struct dirent *ent;
+	int fd, ret = 0;
+
+	dir = fdopendir(dirfd);
+	if (!dir) {
+		close(dirfd);
+		return -1;
+	}
+
+	while ((ent = readdir(dir))) {
+		if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+			continue;
+
+		if (!unlinkat(dirfd, ent->d_name, 0))
+			continue;
+
+		if (errno != EISDIR && errno != EPERM) {
+			ret = -1;
+			continue;
+		}
+
+		fd = openat(dirfd, ent->d_name, O_DIRECTORY | O_NOFOLLOW);
+		if (fd < 0) {
+			ret = -1;
+			continue;
+		}
+
+		if (purge_dirfd(fd)) {
+			ret = -1;
+			continue;
+		}
+
+		if (unlinkat(dirfd, ent->d_name, AT_REMOVEDIR))
+			ret = -1;
+	}
+
+	closedir(dir);
+	return ret;
+}
+
+/*
+ * Removes the top-level subtrees of path with a few forked workers
+ * before the single-threaded walk runs. Teardown of trees with
+ * millions of entries otherwise takes longer than the test that
+ * created them and the time is billed to the next tag's start.
+ *
+ * The top-level names are snapshotted up front so the workers never
+ * race over the partitioning; worker w then removes every
+ * nworkers-th subdirectory starting at w. This is purely an
+ * accelerator: workers silently skip anything they cannot delete and
+ * the serial walk that follows stays the authority on errors.
+ */
+static void purge_dir_parallel(const char *path)
+{
+	DIR *dir;
+	struct dirent *ent;
+	struct stat sb;
+	char **names = NULL;
+	pid_t pids[PURGE_MAX_WORKERS];
+	int i, w, dfd, nnames = 0, avail = 0, nworkers;
+
+	if (!strcmp(path, "/"))
+		return;
+
+	if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+		return;
+
+	dir = opendir(path);
+	if (!dir)
+		return;
+	dfd = dirfd(dir);
+
+	while ((ent = readdir(dir))) {
+		if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+			continue;
+
+		/* only subtrees are worth a worker */
+		if (fstatat(dfd, ent->d_name, &sb, AT_SYMLINK_NOFOLLOW))
+			continue;
+		if (!S_ISDIR(sb.st_mode))
+			continue;
+
+		if (nnames >= avail) {
+			char **tmp;
+
+			avail = avail ? 2 * avail : 64;
+			tmp = realloc(names, avail * sizeof(*names));
+			if (!tmp)
+				goto out;
+			names = tmp;
+		}
+
+		names[nnames] = strdup(ent->d_name);
+		if (!names[nnames])
+			goto out;
+		nnames++;
+	}
+
+	if (nnames < 2)
+		goto out;
+
+	nworkers = nnames < PURGE_MAX_WORKERS ? nnames : PURGE_MAX_WORKERS;
+
+	for (w = 0; w < nworkers; w++) {
+		pids[w] = fork();
+
+		if (pids[w] < 0) {
+			nworkers = w;
+			break;
+		}
+
+		if (!pids[w]) {
+			for (i = w; i < nnames; i += nworkers) {
+				int fd;
+
+				fd = openat(dfd, names[i],
+					    O_DIRECTORY | O_NOFOLLOW);
+				if (fd < 0)
+					continue;
+
+				if (!purge_dirfd(fd))
+					unlinkat(dfd, names[i], AT_REMOVEDIR);
+			}
+			_exit(0);
+		}
+	}
+
+	for (w = 0; w < nworkers; w++) {
+		while (waitpid(pids[w], NULL, 0) < 0 && errno == EINTR)
+			;
+	}
+
+out:
+	for (i = 0; i < nnames; i++)
+		free(names[i]);
+	free(names);
+	closedir(dir);
+}
+
 static int rmobj(const char *obj, char **errmsg)
 {
 	int ret_val = 0;
@@ -278,6 +471,8 @@ void tst_tmpdir(void)
 		return;
 	}
 
+	tmpdir_mount_tmpfs();
+
 	SAFE_CHOWN(NULL, TESTDIR, -1, getgid());
 
 	SAFE_CHMOD(NULL, TESTDIR, DIR_MODE);
@@ -329,9 +524,25 @@ void tst_rmdir(void)
 		munmap((void *)tst_futexes, getpagesize());
 	}
 
+	if (tmpdir_tmpfs_mounted) {
+		/* move out of the mount before taking it down */
+		if (chdir(test_start_work_dir[0] ? test_start_work_dir : "/"))
+			tst_resm(TWARN | TERRNO, "%s: chdir() failed", __func__);
+
+		if (umount(TESTDIR)) {
+			tst_resm(TWARN | TERRNO, "%s: umount(%s) failed",
+				 __func__, TESTDIR);
+		} else {
+			tmpdir_tmpfs_mounted = 0;
+		}
+	}
+
 	/*
-	 * Attempt to remove the "TESTDIR" directory, using rmobj().
+	 * Attempt to remove the "TESTDIR" directory, purging large
+	 * subtrees in parallel first and using rmobj() for the rest.
 	 */
+	purge_dir_parallel(TESTDIR);
+
 	if (rmobj(TESTDIR, &errmsg) == -1) {
 		tst_resm(TWARN, "%s: rmobj(%s) failed: %s",
 			 __func__, TESTDIR, errmsg);
@@ -342,6 +553,8 @@ void tst_purge_dir(const char *path)
 {
 	char *err;
 
+	purge_dir_parallel(path);
+
 	if (purge_dir(path, &err))
 		tst_brkm(TBROK, NULL, "%s: %s", __func__, err);
 }
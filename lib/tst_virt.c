@@ -22,9 +22,11 @@
  * 02110-1301, USA.
  */
 
+#include <stdio.h>
 #include <unistd.h>
 #include "test.h"
 #include "safe_macros.h"
+#include "tst_cache.h"
 
 static int is_kvm(void)
 {
@@ -143,30 +145,49 @@ static int try_systemd_detect_virt(void)
 
 int tst_is_virt(int virt_type)
 {
-	int ret = try_systemd_detect_virt();
+	char key[32];
+	int ret, cached;
+
+	snprintf(key, sizeof(key), "virt_%d", virt_type);
+
+	if (!tst_cache_get_int(key, &cached))
+		return cached;
+
+	ret = try_systemd_detect_virt();
 
 	if (ret > 0) {
 		if (virt_type == VIRT_ANY)
-			return 1;
+			ret = 1;
 		else
-			return ret == virt_type;
+			ret = (ret == virt_type);
+		tst_cache_put_int(key, ret);
+		return ret;
 	}
 
 	switch (virt_type) {
 	case VIRT_ANY:
-		return is_xen() || is_kvm() || is_ibmz(VIRT_IBMZ);
+		ret = is_xen() || is_kvm() || is_ibmz(VIRT_IBMZ);
+		break;
 	case VIRT_XEN:
-		return is_xen();
+		ret = is_xen();
+		break;
 	case VIRT_KVM:
-		return is_kvm();
+		ret = is_kvm();
+		break;
 	case VIRT_IBMZ:
 	case VIRT_IBMZ_LPAR:
 	case VIRT_IBMZ_ZVM:
-		return is_ibmz(virt_type);
+		ret = is_ibmz(virt_type);
+		break;
 	case VIRT_OTHER:
-		return 0;
+		ret = 0;
+		break;
+	default:
+		tst_brkm(TBROK, NULL, "invalid virt_type flag: %d", virt_type);
+		return -1;
 	}
 
-	tst_brkm(TBROK, NULL, "invalid virt_type flag: %d", virt_type);
-	return -1;
+	tst_cache_put_int(key, ret);
+
+	return ret;
 }
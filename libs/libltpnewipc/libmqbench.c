@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Helpers for the POSIX message queue benchmarks. The queues are
+ * created under unique names and unlinked right away, so an aborted
+ * benchmark does not leave stale entries in /dev/mqueue, and the
+ * send/receive wrappers use a generous absolute timeout so that a stuck
+ * partner surfaces as TBROK instead of a test timeout.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define TST_NO_DEFAULT_MAIN
+
+#include "tst_test.h"
+#include "tst_clocks.h"
+#include "libmqbench.h"
+
+#define MQBENCH_TIMEOUT 30
+
+static void mqbench_deadline(struct timespec *ts)
+{
+	if (tst_clock_gettime(CLOCK_REALTIME, ts) < 0)
+		tst_brk(TBROK | TERRNO, "clock_gettime(CLOCK_REALTIME)");
+
+	ts->tv_sec += MQBENCH_TIMEOUT;
+}
+
+mqd_t mqbench_open(const char *file, const int lineno,
+		   long depth, long msgsize)
+{
+	struct mq_attr attr = {
+		.mq_maxmsg = depth,
+		.mq_msgsize = msgsize,
+	};
+	char name[64];
+	static int count;
+	mqd_t fd;
+
+	snprintf(name, sizeof(name), "/ltp_mqbench_%d_%d", getpid(), count++);
+
+	fd = mq_open(name, O_CREAT | O_EXCL | O_RDWR, 0600, &attr);
+	if (fd == (mqd_t)-1) {
+		if (errno == EINVAL || errno == ENOSPC || errno == ENOMEM) {
+			tst_brk_(file, lineno, TCONF | TERRNO,
+				 "mq_open() with queue depth %ld", depth);
+		}
+		tst_brk_(file, lineno, TBROK | TERRNO, "mq_open(%s)", name);
+	}
+
+	if (mq_unlink(name))
+		tst_brk_(file, lineno, TBROK | TERRNO, "mq_unlink(%s)", name);
+
+	return fd;
+}
+
+void mqbench_send(const char *file, const int lineno,
+		  mqd_t fd, const char *buf, size_t len)
+{
+	struct timespec ts;
+
+	mqbench_deadline(&ts);
+
+	if (mq_timedsend(fd, buf, len, 0, &ts))
+		tst_brk_(file, lineno, TBROK | TERRNO, "mq_timedsend()");
+}
+
+ssize_t mqbench_recv(const char *file, const int lineno,
+		     mqd_t fd, char *buf, size_t len)
+{
+	struct timespec ts;
+	ssize_t ret;
+
+	mqbench_deadline(&ts);
+
+	ret = mq_timedreceive(fd, buf, len, NULL, &ts);
+	if (ret < 0)
+		tst_brk_(file, lineno, TBROK | TERRNO, "mq_timedreceive()");
+
+	return ret;
+}
@@ -79,23 +79,38 @@ void tst_nodemap_count_pages(struct tst_nodemap *nodes,
 {
 	size_t page_size = getpagesize();
 	unsigned int i;
-	int node;
 	long ret;
 	unsigned int pages = (size + page_size - 1)/page_size;
+	void **pageptrs;
+	int *status;
 
-	for (i = 0; i < pages; i++) {
-		ret = get_mempolicy(&node, NULL, 0, ptr + i * page_size, MPOL_F_NODE | MPOL_F_ADDR);
-		if (ret < 0)
-			tst_brk(TBROK | TERRNO, "get_mempolicy() failed");
+	/*
+	 * One vectored move_pages() query instead of a get_mempolicy() call
+	 * per page, placement verification on big mappings is dominated by
+	 * the syscall count otherwise.
+	 */
+	pageptrs = SAFE_MALLOC(pages * sizeof(*pageptrs));
+	status = SAFE_MALLOC(pages * sizeof(*status));
+
+	for (i = 0; i < pages; i++)
+		pageptrs[i] = ptr + i * page_size;
+
+	ret = move_pages(0, pages, pageptrs, NULL, status, 0);
+	if (ret < 0)
+		tst_brk(TBROK | TERRNO, "move_pages() failed");
 
-		if (node < 0) {
-			tst_res(TWARN,
-				"get_mempolicy(...) returned invalid node %i\n", node);
+	for (i = 0; i < pages; i++) {
+		if (status[i] < 0) {
+			tst_res(TWARN, "move_pages() status for page %u: %s",
+				i, tst_strerrno(-status[i]));
 			continue;
 		}
 
-		inc_counter(node, nodes);
+		inc_counter(status[i], nodes);
 	}
+
+	free(pageptrs);
+	free(status);
 }
 
 void *tst_numa_map(const char *path, size_t size)
@@ -171,14 +186,21 @@ static int node_has_enough_memory(int node, size_t min_kb)
 
 struct tst_nodemap *tst_get_nodemap(int type, size_t min_mem_kb)
 {
-	struct bitmask *membind;
+	static struct bitmask *membind;
 	struct tst_nodemap *nodes;
 	unsigned int i, cnt;
 
 	if (type & ~(TST_NUMA_MEM))
 		tst_brk(TBROK, "Invalid type %i\n", type);
 
-	membind = numa_get_membind();
+	/*
+	 * The allowed node set cannot change under a running test, cache it
+	 * so that repeated initialization does not redo the libnuma sysfs
+	 * walk. The per-node free memory check below stays uncached since
+	 * that does change as tests allocate.
+	 */
+	if (!membind)
+		membind = numa_get_membind();
 
 	cnt = 0;
 	for (i = 0; i < membind->size; i++) {
@@ -207,8 +229,6 @@ struct tst_nodemap *tst_get_nodemap(int type, size_t min_mem_kb)
 
 	nodes->cnt = cnt;
 
-	numa_bitmask_free(membind);
-
 	return nodes;
 }
 
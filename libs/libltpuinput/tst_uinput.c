@@ -8,6 +8,8 @@
 #include <linux/uinput.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <sys/stat.h>
 
 #define TST_NO_DEFAULT_MAIN
 #include "tst_test.h"
@@ -127,6 +129,94 @@ void destroy_input_device(int fd)
 	SAFE_CLOSE(fd);
 }
 
+void send_input_events(int fd, const struct input_event *events,
+		       unsigned int count)
+{
+	size_t len = count * sizeof(*events);
+
+	SAFE_WRITE(1, fd, events, len);
+}
+
+static long long ev_time_us(const struct input_event *ev)
+{
+	return (long long)ev->time.tv_sec * 1000000 + ev->time.tv_usec;
+}
+
+void replay_input_events(int fd, const struct input_event *events,
+			 unsigned int count)
+{
+	struct timespec base, when;
+	long long start_us, delta_us;
+	unsigned int i, batch;
+
+	if (!count)
+		return;
+
+	start_us = ev_time_us(&events[0]);
+
+	if (clock_gettime(CLOCK_MONOTONIC, &base))
+		tst_brk(TBROK | TERRNO, "clock_gettime()");
+
+	for (i = 0; i < count; i += batch) {
+		/*
+		 * Events sharing a timestamp belong to one batch and go
+		 * out in a single write().
+		 */
+		for (batch = 1; i + batch < count; batch++) {
+			if (ev_time_us(&events[i + batch]) !=
+			    ev_time_us(&events[i]))
+				break;
+		}
+
+		/*
+		 * The sleeps are scheduled against the replay start so
+		 * that pacing errors don't accumulate over the stream.
+		 */
+		delta_us = ev_time_us(&events[i]) - start_us;
+		if (delta_us > 0) {
+			when = base;
+			when.tv_sec += delta_us / 1000000;
+			when.tv_nsec += (delta_us % 1000000) * 1000;
+			if (when.tv_nsec >= 1000000000) {
+				when.tv_sec++;
+				when.tv_nsec -= 1000000000;
+			}
+
+			int ret;
+
+			while ((ret = clock_nanosleep(CLOCK_MONOTONIC,
+						      TIMER_ABSTIME, &when,
+						      NULL))) {
+				if (ret != EINTR) {
+					tst_brk(TBROK, "clock_nanosleep(): %s",
+						tst_strerrno(ret));
+				}
+			}
+		}
+
+		send_input_events(fd, events + i, batch);
+	}
+}
+
+unsigned int load_input_events(const char *path, struct input_event **events)
+{
+	struct stat st;
+	int fd = SAFE_OPEN(path, O_RDONLY);
+
+	SAFE_FSTAT(fd, &st);
+
+	if (!st.st_size || st.st_size % sizeof(struct input_event)) {
+		tst_brk(TBROK, "'%s' size %li is not a multiple of the event size",
+			path, (long)st.st_size);
+	}
+
+	*events = SAFE_MALLOC(st.st_size);
+	SAFE_READ(1, fd, *events, st.st_size);
+	SAFE_CLOSE(fd);
+
+	return st.st_size / sizeof(struct input_event);
+}
+
 void create_input_device(int fd)
 {
 	int nb;
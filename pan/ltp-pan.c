@@ -54,21 +54,34 @@
 #include <sys/param.h>
 #include <sys/stat.h>
 #include <stdarg.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #include <sys/times.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/utsname.h>
+#include <dirent.h>
 #include <errno.h>
 #include <err.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
+#include <unistd.h>
+
+/* pidfd_open() has the same syscall number on every architecture */
+#ifndef SYS_pidfd_open
+# define SYS_pidfd_open 434
+#endif
 
 #include "splitstr.h"
 #include "zoolib.h"
+#include "rlog.h"
 #include "tst_res_flags.h"
 
 /* One entry in the command line collection.  */
@@ -76,6 +89,9 @@ struct coll_entry {
 	char *name;		/* tag name */
 	char *cmdline;		/* command line */
 	char *pcnt_f;		/* location of %f in the command line args, flag */
+	char *class;		/* exclusion class, NULL if tag can always run */
+	int dispatched;		/* tag was already handed to a worker slot */
+	long long runtime_ms;	/* measured wall time, -1 when unknown */
 	struct coll_entry *next;
 };
 
@@ -86,6 +102,7 @@ struct collection {
 
 struct tag_pgrp {
 	int pgrp;
+	int pidfd;		/* pidfd in the epoll set, -1 if unsupervised */
 	int stopping;
 	time_t mystime;
 	struct coll_entry *cmd;
@@ -116,8 +133,21 @@ static char *subst_pcnt_f(struct coll_entry *colle);
 static void mark_orphan(struct orphan_pgrp *orphans, pid_t cpid);
 static void orphans_running(struct orphan_pgrp *orphans);
 static void check_orphans(struct orphan_pgrp *orphans, int sig);
+static int class_running(struct tag_pgrp *running, int keep_active,
+			 struct coll_entry *colle);
+static int next_runnable(struct collection *coll, struct tag_pgrp *running,
+			 int keep_active);
+static int load_runtimes(char *file);
+static void order_longest_first(struct collection *coll);
+static void preload_collection(struct collection *coll);
+static void supervise_init(int run_time);
+static void supervise_child(struct tag_pgrp *active);
+static pid_t supervise_wait(int *stat_loc);
 
 static void copy_buffered_output(struct tag_pgrp *running);
+static void rlog_test_end(struct tag_pgrp *running, const char *init_status,
+			  time_t exit_time, char *term_type, int stat_loc,
+			  int term_id);
 static void write_test_start(struct tag_pgrp *running, int no_kmsg);
 static void write_test_end(struct tag_pgrp *running, const char *init_status,
 			   time_t exit_time, char *term_type, int stat_loc,
@@ -130,6 +160,10 @@ static char *panname = NULL;
 static char *test_out_dir = NULL;	/* dir to buffer output to */
 zoo_t zoofile;
 static char *reporttype = NULL;
+static int rlogfd = -1;		/* structured result log, see rlog.h */
+static int epfd = -1;		/* epoll set for pidfd child supervision */
+static int runtimerfd = -1;	/* timerfd backing the -t run time limit */
+static int nsupervised = 0;	/* children currently in the epoll set */
 
 /* Common format string for ltp-pan results */
 #define ResultFmt	"%-50s %-10.10s"
@@ -156,9 +190,11 @@ int main(int argc, char **argv)
 	char *zooname = NULL;	/* name of the zoo file to use */
 	char *filename = "/dev/null";	/* filename to read test tags from */
 	char *logfilename = NULL;
+	char *rlogfilename = NULL;
 	char *failcmdfilename = NULL;
 	char *tconfcmdfilename = NULL;
 	char *outputfilename = NULL;
+	char *runtimesfilename = NULL;	/* measured runtimes for -j ordering */
 	struct collection *coll = NULL;
 	struct tag_pgrp *running;
 	struct orphan_pgrp *orphans, *orph;
@@ -186,12 +222,14 @@ int main(int argc, char **argv)
 	int fmt_print = 0;	/* enables formatted printing of logfiles. */
 	int quiet_mode = 0;	/* supresses test start and test end tags. */
 	int no_kmsg = 0;	/* don't log into /dev/kmsg */
+	int workqueue = 0;	/* -j: run tags from a work queue in parallel */
+	int preload = 0;	/* -P: readahead test binaries and data files */
 	int c;
 	pid_t cpid;
 	struct sigaction sa;
 
 	while ((c =
-		getopt(argc, argv, "AO:Sa:C:QT:d:ef:hl:n:o:pqr:s:t:x:y"))
+		getopt(argc, argv, "AO:PR:Sa:C:QT:d:ef:hj:l:n:o:pqr:s:t:w:x:y"))
 		       != -1) {
 		switch (c) {
 		case 'A':	/* all-stop flag */
@@ -201,6 +239,12 @@ int main(int argc, char **argv)
 		case 'O':	/* output buffering directory */
 			test_out_dir = strdup(optarg);
 			break;
+		case 'P':	/* preload test binaries into the page cache */
+			preload = 1;
+			break;
+		case 'R':	/* structured result log */
+			rlogfilename = strdup(optarg);
+			break;
 		case 'S':	/* run tests sequentially */
 			sequential = 1;
 			break;
@@ -232,12 +276,45 @@ int main(int argc, char **argv)
 		case 'h':	/* help */
 			fprintf(stdout,
 				"Usage: pan -n name [ -SyAehpqQ ] [ -s starts ]"
-				" [-t time[s|m|h|d] [ -x nactive ] [ -l logfile ]\n\t"
+				" [-t time[s|m|h|d] [ -x nactive ] [ -j nworkers ]"
+				" [ -l logfile ]\n\t[ -R result-log ]"
 				"[ -a active-file ] [ -f command-file ] "
 				"[ -C fail-command-file ] "
 				"[ -d debug-level ]\n\t[-o output-file] "
-				"[-O output-buffer-directory] [cmd]\n");
+				"[-O output-buffer-directory] [cmd]\n\n"
+				"-j runs each tag exactly once, keeping up to "
+				"nworkers tags active at a time\n"
+				"(0 means one per online CPU).  Tags that must "
+				"not run concurrently can share\n"
+				"an exclusion class via 'tag@class cmdline' in "
+				"the command file; pan never\n"
+				"schedules two tags of the same class at once.  "
+				"Use -O to keep the output of\n"
+				"concurrent tags demultiplexed.\n\n"
+				"-w loads measured runtimes ('tag wall_ms' "
+				"per line, distilled from the\n"
+				"LTP_RUSAGE records of earlier runs) and "
+				"makes -j dispatch the longest\n"
+				"tags first, so a straggler cannot prolong "
+				"the tail of a parallel run.\n"
+				"Tags without a record are treated as long "
+				"and dispatched first.\n\n"
+				"-P walks the command file before scheduling "
+				"and asks the kernel to read the\n"
+				"test binaries and their data files into the "
+				"page cache in the background,\n"
+				"so cold-cache (e.g. NFS) reads overlap with "
+				"the execution of earlier tests\n"
+				"instead of stalling each first exec.\n");
 			exit(0);
+		case 'j':	/* parallel work queue, one start per tag */
+			workqueue = 1;
+			keep_active = atoi(optarg);
+			if (keep_active <= 0)
+				keep_active = sysconf(_SC_NPROCESSORS_ONLN);
+			if (keep_active <= 0)
+				keep_active = 1;
+			break;
 		case 'l':	/* log file */
 			logfilename = strdup(optarg);
 			break;
@@ -295,6 +372,9 @@ int main(int argc, char **argv)
 			}
 			timed = 1;	//-t implies run as many starts as possible, by default
 			break;
+		case 'w':	/* measured runtimes for longest-first -j */
+			runtimesfilename = strdup(optarg);
+			break;
 		case 'x':	/* number of tags to keep running */
 			keep_active = atoi(optarg);
 			break;
@@ -362,6 +442,15 @@ int main(int argc, char **argv)
 		fflush(logfile);
 	}
 
+	if (rlogfilename != NULL) {
+		if ((rlogfd = rlog_open(rlogfilename)) < 0) {
+			fprintf(stderr,
+				"pan(%s): Error %s (%d) opening result log '%s'\n",
+				panname, strerror(errno), errno, rlogfilename);
+			exit(1);
+		}
+	}
+
 	coll = get_collection(filename, optind, argc, argv);
 	if (!coll)
 		exit(1);
@@ -372,6 +461,20 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (runtimesfilename) {
+		if (!workqueue)
+			fprintf(stderr,
+				"pan(%s): -w only orders the -j work queue, ignored\n",
+				panname);
+		else if (load_runtimes(runtimesfilename))
+			exit(1);
+		else
+			order_longest_first(coll);
+	}
+
+	if (preload)
+		preload_collection(coll);
+
 	if (Debug & Dsetup)
 		dump_coll(coll);
 
@@ -385,6 +488,8 @@ int main(int argc, char **argv)
 		exit(2);
 	}
 	memset(running, 0, keep_active * sizeof(struct tag_pgrp));
+	for (i = 0; i < keep_active; ++i)
+		running[i].pidfd = -1;
 	running[keep_active].pgrp = -1;	/* end sentinel */
 
 	/* a head to the orphaned pgrp list */
@@ -396,7 +501,9 @@ int main(int argc, char **argv)
 	/* Supply a default for starts.  If we are in sequential mode, use
 	 * the number of commands available; otherwise 1.
 	 */
-	if (timed == 1 && starts == -1) {	/* timed, infinite by default */
+	if (workqueue) {	/* run every tag exactly once */
+		starts = coll->cnt;
+	} else if (timed == 1 && starts == -1) {	/* timed, infinite by default */
 		starts = -1;
 	} else if (starts == -1) {
 		if (sequential) {
@@ -502,9 +609,7 @@ int main(int argc, char **argv)
 	}
 
 	rec_signal = send_signal = 0;
-	if (run_time != -1) {
-		alarm(run_time);
-	}
+	supervise_init(run_time);
 
 	sigemptyset(&sa.sa_mask);
 	sa.sa_flags = 0;
@@ -527,8 +632,19 @@ int main(int argc, char **argv)
 			if (stop || rec_signal || go_idle)
 				break;
 
-			if (!sequential)
+			if (workqueue) {
+				c = next_runnable(coll, running, keep_active);
+				if (c < 0) {
+					/* every queued tag conflicts with an
+					 * active exclusion class; wait for a
+					 * child to finish and retry
+					 */
+					break;
+				}
+				coll->ary[c]->dispatched = 1;
+			} else if (!sequential) {
 				c = lrand48() % coll->cnt;
+			}
 
 			/* find a slot for the child */
 			for (i = 0; i < keep_active; ++i) {
@@ -549,7 +665,7 @@ int main(int argc, char **argv)
 				      &failcnt, fmt_print, logfile, no_kmsg);
 			if (cpid != -1)
 				++num_active;
-			if ((cpid != -1 || sequential) && starts > 0)
+			if ((cpid != -1 || sequential || workqueue) && starts > 0)
 				--starts;
 
 			if (sequential)
@@ -647,7 +763,7 @@ int main(int argc, char **argv)
 		fprintf(stderr, "pan(%s): %s\n", panname, zoo_error);
 		++exit_stat;
 	}
-	fclose(zoofile);
+	zoo_close(zoofile);
 	if (logfile && fmt_print) {
 		if (uname(&unamebuf) == -1)
 			fprintf(stderr, "ERROR: uname(): %s\n",
@@ -670,6 +786,13 @@ int main(int argc, char **argv)
 
 	if (tconfcmdfile)
 		fclose(tconfcmdfile);
+
+	if (rlogfd >= 0) {
+		/* tell followers of the result log that the run is over */
+		const char *kv[] = { RLOG_COMPLETE_KEY };
+
+		rlog_append(rlogfd, kv, 1);
+	}
 	exit(exit_stat);
 }
 
@@ -734,7 +857,7 @@ check_pids(struct tag_pgrp *running, int *num_active, int keep_active,
 		fprintf(stderr, "pan(%s): times(&tms1) failed.  errno:%d  %s\n",
 			panname, errno, strerror(errno));
 	}
-	cpid = wait(&stat_loc);
+	cpid = supervise_wait(&stat_loc);
 	tck = times(&tms2);
 	if (tck == -1) {
 		fprintf(stderr, "pan(%s): times(&tms2) failed.  errno:%d  %s\n",
@@ -864,6 +987,8 @@ check_pids(struct tag_pgrp *running, int *num_active, int keep_active,
 					write_test_end(running + i, "ok", t,
 						       status, stat_loc, w,
 						       &tms1, &tms2);
+				rlog_test_end(running + i, "ok", t, status,
+					      stat_loc, w);
 
 				/* If signaled and we weren't expecting
 				 * this to be stopped then the proc
@@ -873,6 +998,14 @@ check_pids(struct tag_pgrp *running, int *num_active, int keep_active,
 					ret++;
 
 				running[i].pgrp = 0;
+				if (running[i].pidfd >= 0) {
+					/* closing the pidfd also drops it
+					 * from the epoll set
+					 */
+					close(running[i].pidfd);
+					running[i].pidfd = -1;
+					--nsupervised;
+				}
 				if (zoo_clear(zoofile, cpid)) {
 					fprintf(stderr, "pan(%s): %s\n",
 						panname, zoo_error);
@@ -973,7 +1106,7 @@ run_child(struct coll_entry *colle, struct tag_pgrp *active, int quiet_mode,
 	} else if (cpid == 0) {
 		/* child */
 
-		fclose(zoofile);
+		zoo_close(zoofile);
 		close(errpipe[0]);
 		fcntl(errpipe[1], F_SETFD, 1);	/* close the pipe if we succeed */
 		setpgrp();
@@ -1120,6 +1253,8 @@ run_child(struct coll_entry *colle, struct tag_pgrp *active, int quiet_mode,
 			write_test_end(active, errbuf, end_time, termtype,
 				       status, termid, &notime, &notime);
 		}
+		rlog_test_end(active, errbuf, end_time, termtype, status,
+			      termid);
 		if (capturing) {
 			close(c_stdout);
 			unlink(active->output);
@@ -1133,6 +1268,7 @@ run_child(struct coll_entry *colle, struct tag_pgrp *active, int quiet_mode,
 
 	active->pgrp = cpid;
 	active->stopping = 0;
+	supervise_child(active);
 
 	if (zoo_mark_cmdline(zoofile, cpid, colle->name, colle->cmdline)) {
 		fprintf(stderr, "pan(%s): %s\n", panname, zoo_error);
@@ -1156,6 +1292,369 @@ run_child(struct coll_entry *colle, struct tag_pgrp *active, int quiet_mode,
 	return cpid;
 }
 
+/*
+ * Child supervision.  When the kernel provides pidfds the main loop blocks
+ * in epoll_wait() instead of wait(): every started child is registered by
+ * its pidfd, so an exit is observed the moment it happens even with
+ * hundreds of concurrent children, and the -t run time limit is a timerfd
+ * in the same set instead of an alarm().  Kernels without pidfd_open()
+ * (pre 5.3) keep the historic wait()/alarm() behaviour.
+ */
+static void supervise_init(int run_time)
+{
+	struct epoll_event ev;
+	struct itimerspec its;
+	int pidfd;
+
+	pidfd = syscall(SYS_pidfd_open, getpid(), 0);
+	if (pidfd >= 0) {
+		close(pidfd);
+		epfd = epoll_create1(EPOLL_CLOEXEC);
+	}
+
+	if (epfd >= 0 && run_time != -1) {
+		runtimerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+		if (runtimerfd >= 0) {
+			memset(&its, 0, sizeof(its));
+			its.it_value.tv_sec = run_time;
+			ev.events = EPOLLIN;
+			ev.data.ptr = NULL;
+			if (timerfd_settime(runtimerfd, 0, &its, NULL) < 0 ||
+			    epoll_ctl(epfd, EPOLL_CTL_ADD, runtimerfd,
+				      &ev) < 0) {
+				close(runtimerfd);
+				runtimerfd = -1;
+			}
+		}
+	}
+
+	if (run_time != -1 && runtimerfd < 0)
+		alarm(run_time);
+}
+
+/* Drop back to wait()/alarm() driven supervision for the rest of the run. */
+static void supervise_disable(void)
+{
+	struct itimerspec its;
+
+	if (runtimerfd >= 0) {
+		if (timerfd_gettime(runtimerfd, &its) == 0 &&
+		    its.it_value.tv_sec > 0)
+			alarm(its.it_value.tv_sec + 1);
+		close(runtimerfd);
+		runtimerfd = -1;
+	}
+	close(epfd);
+	epfd = -1;
+}
+
+/* Add a just-started child to the epoll supervision set. */
+static void supervise_child(struct tag_pgrp *active)
+{
+	struct epoll_event ev;
+
+	if (epfd < 0)
+		return;
+
+	active->pidfd = syscall(SYS_pidfd_open, active->pgrp, 0);
+	if (active->pidfd >= 0) {
+		ev.events = EPOLLIN;
+		ev.data.ptr = active;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, active->pidfd, &ev) == 0) {
+			++nsupervised;
+			return;
+		}
+		close(active->pidfd);
+		active->pidfd = -1;
+	}
+
+	fprintf(stderr,
+		"pan(%s): can't supervise pid %d over epoll.  errno:%d  %s\n",
+		panname, active->pgrp, errno, strerror(errno));
+	supervise_disable();
+}
+
+/* Wait for the next child to finish.  A pidfd becoming readable means the
+ * child has exited, so the targeted waitpid() below never blocks.  Signals
+ * interrupt epoll_wait() just as they did wait(), keeping the signal
+ * ratchet in main() working unchanged.
+ */
+static pid_t supervise_wait(int *stat_loc)
+{
+	struct epoll_event ev;
+	struct tag_pgrp *active;
+	uint64_t ticks;
+
+	if (epfd < 0)
+		return wait(stat_loc);
+
+	if (nsupervised == 0) {
+		errno = ECHILD;
+		return -1;
+	}
+
+	if (epoll_wait(epfd, &ev, 1, -1) < 0)
+		return -1;	/* EINTR, handled like an interrupted wait() */
+
+	if (ev.data.ptr == NULL) {
+		/* the -t run time limit expired */
+		if (read(runtimerfd, &ticks, sizeof(ticks)) < 0 && Debug)
+			fprintf(stderr, "pan(%s): timerfd read failed\n",
+				panname);
+		wait_handler(SIGALRM);
+		errno = EINTR;
+		return -1;
+	}
+
+	active = ev.data.ptr;
+	return waitpid(active->pgrp, stat_loc, 0);
+}
+
+/* Is a tag of the same exclusion class currently active? */
+static int
+class_running(struct tag_pgrp *running, int keep_active,
+	      struct coll_entry *colle)
+{
+	int i;
+
+	if (colle->class == NULL)
+		return 0;
+
+	for (i = 0; i < keep_active; ++i) {
+		if (running[i].pgrp == 0 || running[i].cmd == NULL)
+			continue;
+		if (running[i].cmd->class &&
+		    !strcmp(running[i].cmd->class, colle->class))
+			return 1;
+	}
+	return 0;
+}
+
+/* Pick the next queued tag that does not conflict with an active
+ * exclusion class.  Returns -1 when no queued tag can run right now.
+ */
+static int
+next_runnable(struct collection *coll, struct tag_pgrp *running,
+	      int keep_active)
+{
+	int c;
+
+	for (c = 0; c < coll->cnt; ++c) {
+		if (coll->ary[c]->dispatched)
+			continue;
+		if (!class_running(running, keep_active, coll->ary[c]))
+			return c;
+	}
+	return -1;
+}
+
+/* Measured runtime records loaded with -w, sorted by tag for bsearch. */
+static struct runtime_rec {
+	char *tag;
+	long long ms;
+} *runtimes;
+static int runtimes_cnt;
+
+static int runtime_rec_cmp(const void *a, const void *b)
+{
+	return strcmp(((const struct runtime_rec *)a)->tag,
+		      ((const struct runtime_rec *)b)->tag);
+}
+
+static int load_runtimes(char *file)
+{
+	FILE *f;
+	char line[512], tag[256];
+	long long ms;
+	int cap = 128;
+
+	f = fopen(file, "r");
+	if (f == NULL) {
+		fprintf(stderr, "pan(%s): open of runtimes file %s failed\n",
+			panname, file);
+		return -1;
+	}
+
+	runtimes = malloc(cap * sizeof(struct runtime_rec));
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%255s %lld", tag, &ms) != 2 ||
+		    tag[0] == '#')
+			continue;
+
+		if (runtimes_cnt >= cap) {
+			cap *= 2;
+			runtimes = realloc(runtimes,
+					   cap * sizeof(struct runtime_rec));
+		}
+
+		runtimes[runtimes_cnt].tag = strdup(tag);
+		runtimes[runtimes_cnt].ms = ms;
+		runtimes_cnt++;
+	}
+
+	fclose(f);
+	qsort(runtimes, runtimes_cnt, sizeof(struct runtime_rec),
+	      runtime_rec_cmp);
+	return 0;
+}
+
+static long long runtime_of(char *tag)
+{
+	struct runtime_rec key = { .tag = tag };
+	struct runtime_rec *rec;
+
+	rec = bsearch(&key, runtimes, runtimes_cnt,
+		      sizeof(struct runtime_rec), runtime_rec_cmp);
+
+	return rec ? rec->ms : -1;
+}
+
+/* Longest runtime first; tags without a record are treated as long and
+ * go to the front, so a newly added (unmeasured) test cannot become the
+ * straggler at the tail of the run.  Ties break on the tag name to keep
+ * the order stable between runs.
+ */
+static int coll_entry_cmp(const void *a, const void *b)
+{
+	const struct coll_entry *ca = *(struct coll_entry * const *)a;
+	const struct coll_entry *cb = *(struct coll_entry * const *)b;
+	long long ma = ca->runtime_ms < 0 ? LLONG_MAX : ca->runtime_ms;
+	long long mb = cb->runtime_ms < 0 ? LLONG_MAX : cb->runtime_ms;
+
+	if (ma != mb)
+		return ma < mb ? 1 : -1;
+	return strcmp(ca->name, cb->name);
+}
+
+static void
+order_longest_first(struct collection *coll)
+{
+	int c;
+
+	for (c = 0; c < coll->cnt; ++c)
+		coll->ary[c]->runtime_ms = runtime_of(coll->ary[c]->name);
+
+	qsort(coll->ary, coll->cnt, sizeof(struct coll_entry *),
+	      coll_entry_cmp);
+}
+
+/* Ask the kernel to start reading a file into the page cache.  */
+static void preload_file(const char *path)
+{
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return;
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	close(fd);
+}
+
+/* Resolve a bare command name the same way execvp() in run_child() will.  */
+static void preload_binary(const char *cmd)
+{
+	char path[PATH_MAX];
+	const char *p, *sep;
+	size_t len;
+
+	if (strchr(cmd, '/')) {
+		preload_file(cmd);
+		return;
+	}
+
+	p = getenv("PATH");
+	if (!p)
+		return;
+
+	while (*p) {
+		sep = strchr(p, ':');
+		len = sep ? (size_t)(sep - p) : strlen(p);
+		if (len && len + strlen(cmd) + 2 <= sizeof(path)) {
+			memcpy(path, p, len);
+			path[len] = '/';
+			strcpy(path + len + 1, cmd);
+			if (access(path, X_OK) == 0) {
+				preload_file(path);
+				return;
+			}
+		}
+		if (!sep)
+			break;
+		p = sep + 1;
+	}
+}
+
+/* The data files a tag may copy from $LTPROOT/testcases/data/<tag>.  */
+static void preload_dataroot(const char *tag)
+{
+	char path[PATH_MAX];
+	const char *ltproot = getenv("LTPROOT");
+	struct dirent *de;
+	DIR *dir;
+
+	if (!ltproot)
+		return;
+
+	snprintf(path, sizeof(path), "%s/testcases/data/%s", ltproot, tag);
+	dir = opendir(path);
+	if (!dir)
+		return;
+
+	while ((de = readdir(dir))) {
+		char fpath[PATH_MAX + NAME_MAX + 1];
+
+		if (de->d_name[0] == '.')
+			continue;
+		snprintf(fpath, sizeof(fpath), "%s/%s", path, de->d_name);
+		preload_file(fpath);
+	}
+
+	closedir(dir);
+}
+
+/*
+ * Walks the collection and issues POSIX_FADV_WILLNEED for each tag's
+ * binary and data files, so that on cold caches (NFS roots in
+ * particular) the reads overlap with the execution of earlier tests
+ * instead of stalling each first exec.  Runs in a detached grandchild
+ * so the advisory I/O never delays scheduling and the exit is not
+ * seen by the wait() bookkeeping; everything is best effort.
+ */
+static void preload_collection(struct collection *coll)
+{
+	pid_t pid;
+	int c;
+
+	pid = fork();
+	if (pid < 0)
+		return;
+	if (pid) {
+		waitpid(pid, NULL, 0);
+		return;
+	}
+
+	if (fork())
+		_exit(0);
+
+	for (c = 0; c < coll->cnt; ++c) {
+		struct coll_entry *colle = coll->ary[c];
+		const char **words;
+
+		/* shell one-liners get no preloading, see run_child() */
+		if (strpbrk(colle->cmdline, "\"';|<>$\\"))
+			continue;
+
+		words = splitstr(colle->cmdline, NULL, NULL);
+		if (words && words[0]) {
+			preload_binary(words[0]);
+			preload_dataroot(colle->name);
+		}
+		splitstr_free(words);
+	}
+
+	_exit(0);
+}
+
 static char *subst_pcnt_f(struct coll_entry *colle)
 {
 	static int counter = 1;
@@ -1201,6 +1700,14 @@ static struct collection *get_collection(char *file, int optind, int argc,
 				n->pcnt_f[1] = 's';
 			}
 			n->name = strdup(strsep(&a, " \t"));
+			/* an optional '@class' suffix on the tag names an
+			 * exclusion class for the -j work queue
+			 */
+			n->class = strchr(n->name, '@');
+			if (n->class)
+				*n->class++ = '\0';
+			n->dispatched = 0;
+			n->runtime_ms = -1;
 			while (a != NULL && isspace(*a))
 				a++;
 			if (a == NULL || a[0] == 0) {
@@ -1244,6 +1751,9 @@ static struct collection *get_collection(char *file, int optind, int argc,
 		}
 		n->cmdline = strdup(workstr);
 		n->name = "cmdln";
+		n->class = NULL;
+		n->dispatched = 0;
+		n->runtime_ms = -1;
 		n->next = NULL;
 		if (p) {
 			p->next = n;
@@ -1404,6 +1914,40 @@ static void write_test_start(struct tag_pgrp *running, int no_kmsg)
 		write_kmsg("LTP: starting %s\n", running->cmd->name);
 }
 
+/*
+ * Append one length-prefixed record for a completed tag to the structured
+ * result log (-R).  The record carries the same keys as the
+ * execution_status block of the driver output, so the reporter can stream
+ * it without re-parsing the interleaved test output.
+ */
+static void
+rlog_test_end(struct tag_pgrp *running, const char *init_status,
+	      time_t exit_time, char *term_type, int stat_loc, int term_id)
+{
+	char tag[PATH_MAX], is[1024], stime[64], duration[64];
+	char tt[128], ti[64], core[32];
+	const char *kv[] = { tag, is, "analysis=exit", stime, duration,
+			     tt, ti, core };
+
+	if (rlogfd < 0)
+		return;
+
+	snprintf(tag, sizeof(tag), "tag=%s", running->cmd->name);
+	snprintf(is, sizeof(is), "initiation_status=%s", init_status);
+	snprintf(stime, sizeof(stime), "stime=%lld",
+		 (long long)running->mystime);
+	snprintf(duration, sizeof(duration), "duration=%ld",
+		 (long)(exit_time - running->mystime));
+	snprintf(tt, sizeof(tt), "termination_type=%s", term_type);
+	snprintf(ti, sizeof(ti), "termination_id=%d", term_id);
+	snprintf(core, sizeof(core), "corefile=%s",
+		 (stat_loc & 0200) ? "yes" : "no");
+
+	if (rlog_append(rlogfd, kv, sizeof(kv) / sizeof(kv[0])))
+		fprintf(stderr, "pan(%s): failed to append result log record\n",
+			panname);
+}
+
 static void
 write_test_end(struct tag_pgrp *running, const char *init_status,
 	       time_t exit_time, char *term_type, int stat_loc,
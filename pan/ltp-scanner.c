@@ -139,7 +139,7 @@ int main(int argc, char *argv[])
 	SYM tags;		/* tag data */
 	int c;
 
-	while ((c = getopt(argc, argv, "D:ehi")) != -1) {
+	while ((c = getopt(argc, argv, "D:eF:hir:")) != -1) {
 		switch (c) {
 		case 'i':
 			set_iscanner();
@@ -150,9 +150,23 @@ int main(int argc, char *argv[])
 		case 'e':
 			extended++;
 			break;
+		case 'F':
+			/*
+			 * Follow a structured result log while pan is still
+			 * running, reporting each tag the moment its record
+			 * is appended; ends at pan's end-of-run record.
+			 */
+			exit(rlog_follow(optarg) ? 1 : 0);
+		case 'r':
+			/*
+			 * Stream a structured result log written by pan -R
+			 * in one sequential pass, no lexing of the driver
+			 * output involved.
+			 */
+			exit(rlog_reporter(optarg) ? 1 : 0);
 		case 'h':
 			fprintf(stderr,
-				"%s [-e] [-i] [ -D area, level ] input-filenames\n",
+				"%s [-e] [-i] [ -r result-log | -F result-log ] [ -D area, level ] input-filenames\n",
 				argv[0]);
 			exit(0);
 		default:
@@ -44,6 +44,7 @@
 #include "symbol.h"
 #include "tag_report.h"
 #include "splitstr.h"
+#include "rlog.h"
 
 /************************************************************************
  *                      Report Generation                               *
@@ -247,6 +248,113 @@ static int iscanner_test_end(SYM alltags, SYM ctag, SYM keys)
 	return tag_report(alltags, ctag, keys);
 }
 
+/*
+ * Streaming report generation from a structured result log.
+ *
+ * Unlike scanner_reporter() there is no global tag table to fill and
+ * re-walk: every record already carries the execution-status keys for one
+ * completed tag, so each one is handed straight to tag_report() and freed.
+ * Memory use and run time are O(1) per tag no matter how large the log is.
+ * Only the pass/fail/conf totals for the final summary are kept.
+ */
+struct rlog_state {
+	int header_done;
+	int complete;		/* saw the driver's end-of-run record */
+	int total;
+	int pass;
+	int fail;
+	int conf;
+};
+
+static int rlog_record(char *const kv[], int nkv, void *arg)
+{
+	struct rlog_state *st = arg;
+	char datebuf[KEYSIZE];
+	char *info, *val;
+	time_t clock;
+	struct tm *tm;
+	SYM hdr, keys;
+	int i;
+
+	if (nkv == 1 && !strcmp(kv[0], RLOG_COMPLETE_KEY)) {
+		st->complete = 1;
+		return 1;
+	}
+
+	keys = sym_open(0, 0, 0);
+
+	for (i = 0; i < nkv; i++) {
+		val = strchr(kv[i], '=');
+		if (!val)
+			continue;
+		*val++ = '\0';
+		sym_put(keys, strdup(kv[i]), strdup(val), 0);
+	}
+
+	if (!st->header_done) {
+		/* use the first record's stime as the date the tests ran */
+		hdr = sym_open(0, 0, 0);
+		if ((info = (char *)sym_get(keys, "stime")) != NULL) {
+			clock = atoi(info);
+			tm = gmtime(&clock);
+			strftime(datebuf, KEYSIZE, "%x", tm);
+			sym_put(hdr, strdup("_RTS,date"), strdup(datebuf), 0);
+		}
+		print_header(hdr);
+		sym_rm(hdr, RM_KEY | RM_DATA);
+		free(hdr);
+		st->header_done = 1;
+	}
+
+	tag_report(NULL, NULL, keys);
+	fflush(stdout);
+
+	st->total++;
+	info = (char *)sym_get(keys, "termination_id");
+	if (info == NULL || atoi(info) == 0)
+		st->pass++;
+	else if (atoi(info) == 32)	/* TCONF */
+		st->conf++;
+	else
+		st->fail++;
+
+	sym_rm(keys, RM_KEY | RM_DATA);
+	free(keys);	/* sym_rm(RM_DATA) leaves the head behind */
+
+	return 0;
+}
+
+static void rlog_summary(struct rlog_state *st)
+{
+	printf("-------------------------------------------------------------------------------\n");
+	printf("total %d  pass %d  fail %d  conf %d%s\n",
+	       st->total, st->pass, st->fail, st->conf,
+	       st->complete ? "" : "  (no end-of-run record, driver still "
+	       "running or crashed)");
+}
+
+int rlog_reporter(const char *path)
+{
+	struct rlog_state st = { 0 };
+	int ret;
+
+	ret = rlog_stream(path, rlog_record, &st);
+	if (!ret)
+		rlog_summary(&st);
+	return ret;
+}
+
+int rlog_follow(const char *path)
+{
+	struct rlog_state st = { 0 };
+	int ret;
+
+	ret = rlog_tail(path, rlog_record, &st);
+	if (!ret)
+		rlog_summary(&st);
+	return ret;
+}
+
 int reporter(SYM s)
 {
 	return reporter_func(s);
@@ -41,6 +41,13 @@ void set_iscanner(void);
 int reporter( SYM );
 int test_end( SYM, SYM, SYM );
 
+/* stream a structured result log (see rlog.h), one pass, no lex */
+int rlog_reporter(const char *path);
+
+/* like rlog_reporter(), but reports each tag live as a still-running
+ * driver appends it, until the end-of-run record arrives */
+int rlog_follow(const char *path);
+
 /*
  * how much TCID space to start with (table)
  */
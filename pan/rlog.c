@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2000 Silicon Graphics, Inc.  All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it would be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Further, this software is distributed without any warranty that it is
+ * free of the rightful claim of any third person regarding infringement
+ * or the like.  Any license provided herein, whether implied or
+ * otherwise, applies only to this software file.  Patent licenses, if
+ * any, provided herein do not apply to combinations of this program with
+ * other software, or any other product whatsoever.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*
+ * Structured result log, see rlog.h for the format description.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "rlog.h"
+
+int rlog_open(const char *path)
+{
+	return open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+}
+
+int rlog_append(int fd, const char *const kv[], int nkv)
+{
+	char *buf;
+	uint32_t len;
+	size_t total, pos;
+	ssize_t ret;
+	int i;
+
+	if (fd < 0)
+		return -1;
+
+	len = 0;
+	for (i = 0; i < nkv; i++)
+		len += strlen(kv[i]) + 1;
+
+	total = sizeof(len) + len;
+
+	buf = malloc(total);
+	if (!buf)
+		return -1;
+
+	memcpy(buf, &len, sizeof(len));
+
+	pos = sizeof(len);
+	for (i = 0; i < nkv; i++) {
+		size_t l = strlen(kv[i]) + 1;
+
+		memcpy(buf + pos, kv[i], l);
+		pos += l;
+	}
+
+	/* one write per record, O_APPEND keeps concurrent writers apart */
+	do {
+		ret = write(fd, buf, total);
+	} while (ret < 0 && errno == EINTR);
+
+	free(buf);
+
+	return (ret == (ssize_t) total) ? 0 : -1;
+}
+
+#define RLOG_POLL_US	250000	/* how often a follower re-checks the log */
+
+static int walk_records(FILE *fp, int follow,
+			int (*record_cb)(char *const kv[], int nkv, void *arg),
+			void *arg)
+{
+	uint32_t len;
+	long start;
+	char *buf, *c;
+	char **kv;
+	int nkv, stop = 0;
+
+	while (!stop) {
+		start = ftell(fp);
+
+		if (fread(&len, sizeof(len), 1, fp) != 1)
+			goto incomplete;
+
+		buf = malloc(len + 1);
+		if (!buf)
+			break;
+
+		if (fread(buf, 1, len, fp) != len) {
+			/* torn tail record: a writer is (or was) mid-append */
+			free(buf);
+			goto incomplete;
+		}
+		buf[len] = '\0';
+
+		nkv = 0;
+		for (c = buf; c < buf + len; c += strlen(c) + 1)
+			nkv++;
+
+		kv = malloc(sizeof(char *) * (nkv > 0 ? nkv : 1));
+		if (!kv) {
+			free(buf);
+			break;
+		}
+
+		nkv = 0;
+		for (c = buf; c < buf + len; c += strlen(c) + 1)
+			kv[nkv++] = c;
+
+		stop = record_cb(kv, nkv, arg);
+
+		free(kv);
+		free(buf);
+		continue;
+
+incomplete:
+		if (!follow)
+			break;
+		clearerr(fp);
+		if (fseek(fp, start, SEEK_SET) < 0)
+			break;
+		usleep(RLOG_POLL_US);
+	}
+
+	return 0;
+}
+
+int rlog_stream(const char *path,
+		int (*record_cb)(char *const kv[], int nkv, void *arg),
+		void *arg)
+{
+	FILE *fp;
+	int ret;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return -1;
+
+	ret = walk_records(fp, 0, record_cb, arg);
+	fclose(fp);
+	return ret;
+}
+
+int rlog_tail(const char *path,
+	      int (*record_cb)(char *const kv[], int nkv, void *arg),
+	      void *arg)
+{
+	FILE *fp;
+	int ret;
+
+	/* the writer may not have created the log yet */
+	while ((fp = fopen(path, "r")) == NULL) {
+		if (errno != ENOENT)
+			return -1;
+		usleep(RLOG_POLL_US);
+	}
+
+	ret = walk_records(fp, 1, record_cb, arg);
+	fclose(fp);
+	return ret;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2000 Silicon Graphics, Inc.  All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it would be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Further, this software is distributed without any warranty that it is
+ * free of the rightful claim of any third person regarding infringement
+ * or the like.  Any license provided herein, whether implied or
+ * otherwise, applies only to this software file.  Patent licenses, if
+ * any, provided herein do not apply to combinations of this program with
+ * other software, or any other product whatsoever.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef RLOG_H
+#define RLOG_H
+
+/*
+ * Structured result log.
+ *
+ * The log is a sequence of length-prefixed records, one appended by the
+ * driver as each test tag completes.  A record is a 4-byte host-order
+ * payload length followed by the payload: a run of NUL-terminated
+ * "key=value" strings carrying the same execution-status keys that appear
+ * in the driver output (tag, stime, duration, termination_type, ...).
+ *
+ * Each record is appended with a single write() on an O_APPEND descriptor,
+ * so records from concurrent drivers never interleave, and a reader only
+ * ever needs one sequential pass -- no re-parse of the interleaved test
+ * output is involved.
+ */
+
+/* rlog_open(): open (create) a result log for appending
+ *	returns fd on success, -1 on error */
+int rlog_open(const char *path);
+
+/* rlog_append(): append one record made of nkv "key=value" strings
+ *	returns 0 on success, -1 on error */
+int rlog_append(int fd, const char *const kv[], int nkv);
+
+/* rlog_stream(): sequentially read a result log, calling record_cb with
+ * the nkv "key=value" strings of every record.  The strings are only valid
+ * for the duration of the call.  A non-zero return from the callback stops
+ * the walk.
+ *	returns 0 on success, -1 on error */
+int rlog_stream(const char *path,
+		int (*record_cb)(char *const kv[], int nkv, void *arg),
+		void *arg);
+
+/* rlog_tail(): like rlog_stream(), but keeps polling the log for records
+ * appended by a still-running driver instead of stopping at the end of
+ * the file.  The walk only ends when the callback returns non-zero, which
+ * the driver's RLOG_COMPLETE_KEY end-of-run record is there to trigger.
+ *	returns 0 on success, -1 on error */
+int rlog_tail(const char *path,
+	      int (*record_cb)(char *const kv[], int nkv, void *arg),
+	      void *arg);
+
+/* single-key record appended by the driver when its run is complete */
+#define RLOG_COMPLETE_KEY "pan_run_complete=1"
+
+#endif /* RLOG_H */
@@ -68,6 +68,9 @@
 
 #define SYM_MAGIC	0xbadc0de
 
+#define SYM_HASH_THRESH	8	/* index tables larger than this */
+#define SYM_HASH_MIN	32	/* initial index size, power of two */
+
 /*
  * Some functions can report an error message by assigning it to this
  * string.
@@ -93,7 +96,11 @@ SYM newsym(void)
 
 	h->magic = SYM_MAGIC;
 	h->sym = NULL;
+	h->tail = NULL;
 	h->cursor = NULL;
+	h->hash = NULL;
+	h->hmask = 0;
+	h->cnt = 0;
 	return (h);
 }
 
@@ -118,16 +125,60 @@ static struct sym *mknode(struct sym *next, char *key, void *data)
 	return (n);
 }
 
+static unsigned int hash_str(const char *s)
+{
+	unsigned int h = 5381;
+
+	while (*s)
+		h = h * 33 + (unsigned char)*s++;
+	return (h);
+}
+
+/*
+ * (Re)build the lookup index over the entry list.  On allocation failure
+ * the table simply keeps (or falls back to) linear scans.
+ */
+static int hash_build(SYM sym, unsigned int size)
+{
+	struct sym **nh, *sn;
+	unsigned int i;
+
+	nh = calloc(size, sizeof(*nh));
+	if (nh == NULL)
+		return (-1);
+
+	free(sym->hash);
+	sym->hash = nh;
+	sym->hmask = size - 1;
+
+	for (sn = sym->sym; sn != NULL; sn = sn->next) {
+		for (i = hash_str(sn->key) & sym->hmask; nh[i] != NULL;
+		     i = (i + 1) & sym->hmask) ;
+		nh[i] = sn;
+	}
+	return (0);
+}
+
 /*
  * Search for a key in a single-level symbol table hierarchy.
  */
-static struct sym *find_key1(struct sym *sym, char *key)
+static struct sym *find_key1(SYM sym, char *key)
 {
-	while (sym != NULL)
-		if (strcmp(sym->key, key) == 0)
-			return (sym);
-		else
-			sym = sym->next;
+	struct sym *sn;
+	unsigned int i;
+
+	if (sym->hash != NULL) {
+		for (i = hash_str(key) & sym->hmask;
+		     (sn = sym->hash[i]) != NULL; i = (i + 1) & sym->hmask) {
+			if (strcmp(sn->key, key) == 0)
+				return (sn);
+		}
+		return (NULL);
+	}
+
+	for (sn = sym->sym; sn != NULL; sn = sn->next)
+		if (strcmp(sn->key, key) == 0)
+			return (sn);
 	return (NULL);
 }
 
@@ -137,19 +188,35 @@ static struct sym *find_key1(struct sym *sym, char *key)
 static int add_key(SYM sym, char *key, void *data)
 {
 	register struct sym *sn;
+	unsigned int i;
+
+	sn = mknode(NULL, key, data);
+	if (sn == NULL)
+		return (-1);
 
-	if (sym->sym == NULL) {
-		sym->sym = mknode(NULL, key, data);
-		if (sym->sym == NULL) {
-			return (-1);
+	if (sym->sym == NULL)
+		sym->sym = sn;
+	else
+		sym->tail->next = sn;
+	sym->tail = sn;
+	sym->cnt++;
+
+	/* keep the lookup index current */
+	if (sym->hash == NULL) {
+		if (sym->cnt > SYM_HASH_THRESH)
+			hash_build(sym, SYM_HASH_MIN);
+	} else if (sym->cnt * 4 >= (sym->hmask + 1) * 3) {
+		/* more than 3/4 full, double it */
+		if (hash_build(sym, (sym->hmask + 1) * 2) &&
+		    sym->cnt > sym->hmask) {
+			/* can't grow and nearly full: go back to scans */
+			free(sym->hash);
+			sym->hash = NULL;
 		}
 	} else {
-		for (sn = sym->sym; sn != NULL && sn->next != NULL;
-		     sn = sn->next) ;
-		sn->next = mknode(NULL, key, data);
-		assert(sn->next != NULL);
-		if (sn->next == NULL)
-			return (-1);
+		for (i = hash_str(sn->key) & sym->hmask;
+		     sym->hash[i] != NULL; i = (i + 1) & sym->hmask) ;
+		sym->hash[i] = sn;
 	}
 	return (0);
 }
@@ -211,7 +278,7 @@ int sym_put(SYM sym, char *key, void *data, int flags)
 	}
 
 	for (kk = (char **)keys, csym = sym;
-	     *kk != NULL && (nsym = find_key1(csym->sym, *kk)) != NULL;
+	     *kk != NULL && (nsym = find_key1(csym, *kk)) != NULL;
 	     csym = nsym->data) {
 
 		if (*++kk == NULL)
@@ -279,7 +346,7 @@ void *sym_get(SYM sym, char *key)
 		return (NULL);
 
 	for (kk = (char **)keys, csym = sym;
-	     *kk != NULL && (nsym = find_key1(csym->sym, *kk)) != NULL;
+	     *kk != NULL && (nsym = find_key1(csym, *kk)) != NULL;
 	     csym = nsym->data) {
 
 		if (*++kk == NULL)
@@ -461,6 +528,11 @@ int sym_rm(SYM sym, int flags)
 		free(se);
 		se = nse;
 	}
+	/* the index is dead regardless of whether the head survives */
+	free(sym->hash);
+	sym->hash = NULL;
+	sym->sym = sym->tail = sym->cursor = NULL;
+	sym->cnt = 0;
 	if (!(flags & RM_DATA))
 		free(sym);
 	return 0;
@@ -49,11 +49,20 @@ struct sym {
 
 /*
  * Symbol Table Header
+ *
+ * Entries are kept on a singly linked list in insertion order, which is
+ * what sym_seq() walks.  Tables past a handful of entries additionally
+ * carry an open-addressing hash index over the same nodes so key lookup
+ * stays O(1) as runs grow to tens of thousands of tags.
  */
 struct symh {
-    int         magic;
-    struct sym *sym;
-    struct sym *cursor;
+    int          magic;
+    struct sym  *sym;
+    struct sym  *tail;		/* last list entry, for O(1) append */
+    struct sym  *cursor;
+    struct sym **hash;		/* lookup index, NULL for small tables */
+    unsigned int hmask;		/* hash size - 1; size is a power of two */
+    unsigned int cnt;		/* number of entries */
 };
 
 /*
@@ -34,39 +34,62 @@
 /*
  * ZooLib
  *
- * A Zoo is a file used to record what test tags are running at the moment.
- * If the system crashes, we should be able to look at the zoo file to find out
- * what was currently running.  This is especially helpful when running multiple
+ * A Zoo records what test tags are running at the moment.  If the system
+ * crashes, we should be able to look at the zoo file to find out what was
+ * currently running.  This is especially helpful when running multiple
  * tests at the same time.
  *
- * The zoo file is meant to be a text file that fits on a standard console.
- * You should be able to watch it with `cat zoofile`
+ * The active table itself lives in a fixed array of slots in a
+ * memory-mapped sidecar file ("<zooname>.shm") shared by every process
+ * that opened the zoo.  Slots are claimed and released with atomic
+ * compare-and-swap on the owning pid, so marking and clearing a test is
+ * O(slots) with no fcntl locking and no read-modify-write of the file.
+ *
+ * The zoo file is kept as a plain-text crash-dump snapshot of the table.
+ * Slot N owns the fixed-width line N of the file and rewrites only that
+ * line with pwrite(), so concurrent writers never interleave.  You should
+ * still be able to watch it with `cat zoofile`.
  *
  * zoo file format:
  * 	80 characters per line, ending with a \n
- * 	available lines start with '#'
- * 	expected line fromat: pid_t,tag,cmdline
+ * 	free lines start with '#'
+ * 	expected line format: pid_t,tag,cmdline
  *
  */
 
 #include <signal.h>
 #include <stdlib.h>		/* for getenv */
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "zoolib.h"
 
 char zoo_error[ZELEN];
 
-#ifdef __linux__
-/* glibc2.2 definition needs -D_XOPEN_SOURCE, which breaks other things. */
-extern int sighold(int __sig);
-extern int sigrelse(int __sig);
-#endif
+#define ZOO_SLOTS	512
+#define ZOO_LINE	80
+#define ZOO_MAGIC	0x5a4f4f31	/* "ZOO1" */
+
+/* pid values with special meaning in a slot */
+#define SLOT_FREE	0
+#define SLOT_CLAIMED	-1
+
+struct zoo_slot {
+	pid_t pid;
+	char entry[ZOO_LINE];
+};
+
+struct zoo_shm {
+	int magic;
+	int nslots;
+	struct zoo_slot slots[ZOO_SLOTS];
+};
+
+struct zoo {
+	struct zoo_shm *shm;
+	int snap_fd;		/* text snapshot, -1 when unavailable */
+};
 
-/* zoo_mark(): private function to make an entry to the zoo
- * 	returns 0 on success, -1 on error */
-static int zoo_mark(zoo_t z, char *entry);
-static int zoo_lock(zoo_t z);
-static int zoo_unlock(zoo_t z);
 /* cat_args(): helper function to make cmdline from argc, argv */
 char *cat_args(int argc, char **argv);
 
@@ -89,98 +112,158 @@ char *zoo_getname(void)
 /* zoo_open(): open a zoo for use */
 zoo_t zoo_open(char *zooname)
 {
-	zoo_t new_zoo;
-
-	new_zoo = (zoo_t) fopen(zooname, "r+");
-	if (!new_zoo) {
-		if (errno == ENOENT) {
-			/* file doesn't exist, try fopen(xxx, "a+") */
-			new_zoo = (zoo_t) fopen(zooname, "a+");
-			if (!new_zoo) {
-				/* total failure */
-				snprintf(zoo_error, ZELEN,
-					 "Could not open zoo as \"%s\", errno:%d %s",
-					 zooname, errno, strerror(errno));
-				return 0;
-			}
-			fclose(new_zoo);
-			new_zoo = fopen(zooname, "r+");
-		} else {
-			snprintf(zoo_error, ZELEN,
-				 "Could not open zoo as \"%s\", errno:%d %s",
-				 zooname, errno, strerror(errno));
-		}
+	char shmname[ZELEN - 64];
+	struct zoo *z;
+	int fd;
+
+	z = malloc(sizeof(*z));
+	if (!z) {
+		snprintf(zoo_error, ZELEN,
+			 "Malloc Error, %s/%d", __FILE__, __LINE__);
+		return NULL;
+	}
+
+	snprintf(shmname, sizeof(shmname), "%s.shm", zooname);
+
+	fd = open(shmname, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		snprintf(zoo_error, ZELEN,
+			 "Could not open zoo table \"%s\", errno:%d %s",
+			 shmname, errno, strerror(errno));
+		free(z);
+		return NULL;
+	}
+
+	if (ftruncate(fd, sizeof(struct zoo_shm))) {
+		snprintf(zoo_error, ZELEN,
+			 "Could not size zoo table \"%s\", errno:%d %s",
+			 shmname, errno, strerror(errno));
+		close(fd);
+		free(z);
+		return NULL;
+	}
+
+	z->shm = mmap(NULL, sizeof(struct zoo_shm), PROT_READ | PROT_WRITE,
+		      MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (z->shm == MAP_FAILED) {
+		snprintf(zoo_error, ZELEN,
+			 "Could not map zoo table \"%s\", errno:%d %s",
+			 shmname, errno, strerror(errno));
+		free(z);
+		return NULL;
+	}
+
+	/*
+	 * First process in initializes the table, ftruncate zeroed it. The
+	 * slot count must be in place before the magic is published, or a
+	 * concurrent opener could pass the magic check and see an empty
+	 * table; racing initializers all store the same constant, so the
+	 * unsynchronized store is benign. The CAS is a full barrier.
+	 */
+	if (z->shm->magic == 0)
+		z->shm->nslots = ZOO_SLOTS;
+
+	__sync_bool_compare_and_swap(&z->shm->magic, 0, ZOO_MAGIC);
+
+	if (z->shm->magic != ZOO_MAGIC) {
+		snprintf(zoo_error, ZELEN,
+			 "Zoo table \"%s\" is corrupted", shmname);
+		munmap(z->shm, sizeof(struct zoo_shm));
+		free(z);
+		return NULL;
 	}
-	return new_zoo;
+
+	/* the snapshot is best effort, run without it if it can't be made */
+	z->snap_fd = open(zooname, O_WRONLY | O_CREAT, 0644);
+
+	return z;
 }
 
 int zoo_close(zoo_t z)
 {
-	int ret;
+	if (!z)
+		return -1;
 
-	ret = fclose(z);
-	if (ret) {
-		snprintf(zoo_error, ZELEN,
-			 "closing zoo caused error, errno:%d %s",
-			 errno, strerror(errno));
+	munmap(z->shm, sizeof(struct zoo_shm));
+
+	if (z->snap_fd >= 0)
+		close(z->snap_fd);
+
+	free(z);
+	return 0;
+}
+
+/* zoo_snapshot(): rewrite the fixed-width snapshot line owned by a slot */
+static void zoo_snapshot(struct zoo *z, int slot, const char *entry)
+{
+	char line[ZOO_LINE + 1];
+	struct stat st;
+	off_t off = (off_t) slot * ZOO_LINE;
+
+	if (z->snap_fd < 0)
+		return;
+
+	/*
+	 * Pad missing lines up to our slot with free markers so the file
+	 * stays line addressable.  Concurrent padders write identical
+	 * bytes, so no locking is needed.
+	 */
+	if (!fstat(z->snap_fd, &st) && st.st_size < off) {
+		snprintf(line, sizeof(line), "%-*s\n", ZOO_LINE - 1, "#");
+		while (st.st_size < off) {
+			if (pwrite(z->snap_fd, line, ZOO_LINE,
+				   st.st_size) != ZOO_LINE)
+				return;
+			st.st_size += ZOO_LINE;
+		}
+	}
+
+	snprintf(line, sizeof(line), "%-*.*s\n", ZOO_LINE - 1, ZOO_LINE - 1,
+		 entry);
+
+	if (pwrite(z->snap_fd, line, ZOO_LINE, off) != ZOO_LINE) {
+		/* snapshot only, the table is still correct */
 	}
-	return ret;
 }
 
-static int zoo_mark(zoo_t z, char *entry)
+/* zoo_mark(): private function to claim a free slot for an entry
+ * 	returns 0 on success, -1 on error */
+static int zoo_mark(zoo_t z, pid_t p, char *entry)
 {
-	FILE *fp = (FILE *) z;
-	int found = 0;
-	long pos;
-	char buf[BUFLEN];
+	struct zoo_slot *s;
+	size_t len;
+	int i;
 
-	if (fp == NULL)
+	if (!z)
 		return -1;
 
-	if (zoo_lock(z))
-		return -1;
+	for (i = 0; i < z->shm->nslots; i++) {
+		s = &z->shm->slots[i];
 
-	/* first fit */
-	rewind(fp);
-
-	do {
-		pos = ftell(fp);
-
-		if (fgets(buf, BUFLEN, fp) == NULL)
-			break;
-
-		if (buf[0] == '#') {
-			rewind(fp);
-			if (fseek(fp, pos, SEEK_SET)) {
-				/* error */
-				snprintf(zoo_error, ZELEN,
-					 "seek error while writing to zoo file, errno:%d %s",
-					 errno, strerror(errno));
-				return -1;
-			}
-			/* write the entry, left justified, and padded/truncated to the
-			 * same size as the previous entry */
-			fprintf(fp, "%-*.*s\n", (int)strlen(buf) - 1,
-				(int)strlen(buf) - 1, entry);
-			found = 1;
-			break;
-		}
-	} while (1);
-
-	if (!found) {
-		if (fseek(fp, 0, SEEK_END)) {
-			snprintf(zoo_error, ZELEN,
-				 "error seeking to end of zoo file, errno:%d %s",
-				 errno, strerror(errno));
-			return -1;
-		}
-		fprintf(fp, "%-*.*s\n", 79, 79, entry);
+		if (s->pid != SLOT_FREE)
+			continue;
+
+		if (!__sync_bool_compare_and_swap(&s->pid, SLOT_FREE,
+						  SLOT_CLAIMED))
+			continue;
+
+		/* the slot is ours, fill it and then publish the pid */
+		len = strlen(entry);
+		if (len >= ZOO_LINE)
+			len = ZOO_LINE - 1;
+		memcpy(s->entry, entry, len);
+		s->entry[len] = '\0';
+		__sync_synchronize();
+		s->pid = p;
+
+		zoo_snapshot(z, i, s->entry);
+		return 0;
 	}
-	fflush(fp);
 
-	if (zoo_unlock(z))
-		return -1;
-	return 0;
+	snprintf(zoo_error, ZELEN, "no free slot in zoo table");
+	return -1;
 }
 
 int zoo_mark_cmdline(zoo_t z, pid_t p, char *tag, char *cmdline)
@@ -188,7 +271,7 @@ int zoo_mark_cmdline(zoo_t z, pid_t p, char *tag, char *cmdline)
 	char new_entry[BUFLEN];
 
 	snprintf(new_entry, 80, "%d,%s,%s", p, tag, cmdline);
-	return zoo_mark(z, new_entry);
+	return zoo_mark(z, p, new_entry);
 }
 
 int zoo_mark_args(zoo_t z, pid_t p, char *tag, int ac, char **av)
@@ -205,166 +288,55 @@ int zoo_mark_args(zoo_t z, pid_t p, char *tag, int ac, char **av)
 
 int zoo_clear(zoo_t z, pid_t p)
 {
-	FILE *fp = (FILE *) z;
-	long pos;
-	char buf[BUFLEN];
-	pid_t that_pid;
-	int found = 0;
-
-	if (fp == NULL)
-		return -1;
+	struct zoo_slot *s;
+	int i;
 
-	if (zoo_lock(z))
+	if (!z)
 		return -1;
-	rewind(fp);
 
-	do {
-		pos = ftell(fp);
+	for (i = 0; i < z->shm->nslots; i++) {
+		s = &z->shm->slots[i];
 
-		if (fgets(buf, BUFLEN, fp) == NULL)
-			break;
-
-		if (buf[0] == '#')
+		if (s->pid != p)
 			continue;
 
-		that_pid = atoi(buf);
-		if (that_pid == p) {
-			if (fseek(fp, pos, SEEK_SET)) {
-				/* error */
-				snprintf(zoo_error, ZELEN,
-					 "seek error while writing to zoo file, errno:%d %s",
-					 errno, strerror(errno));
-				return -1;
-			}
-			if (ftell(fp) != pos) {
-				printf("fseek failed\n");
-			}
-			fputs("#", fp);
-			found = 1;
-			break;
-		}
-	} while (1);
-
-	fflush(fp);
+		s->entry[0] = '\0';
+		__sync_synchronize();
+		s->pid = SLOT_FREE;
 
-	/* FIXME: unlock zoo file */
-	if (zoo_unlock(z))
-		return -1;
-
-	if (!found) {
-		snprintf(zoo_error, ZELEN,
-			 "zoo_clear() did not find pid(%d)", p);
-		return 1;
+		zoo_snapshot(z, i, "#");
+		return 0;
 	}
-	return 0;
 
+	snprintf(zoo_error, ZELEN, "zoo_clear() did not find pid(%d)", p);
+	return 1;
 }
 
 pid_t zoo_getpid(zoo_t z, char *tag)
 {
-	FILE *fp = (FILE *) z;
-	char buf[BUFLEN], *s;
-	pid_t this_pid = -1;
-
-	if (fp == NULL)
-		return -1;
+	struct zoo_slot *s;
+	char *c;
+	int i;
 
-	if (zoo_lock(z))
+	if (!z)
 		return -1;
 
-	rewind(fp);
-	do {
-		if (fgets(buf, BUFLEN, fp) == NULL)
-			break;
+	for (i = 0; i < z->shm->nslots; i++) {
+		s = &z->shm->slots[i];
 
-		if (buf[0] == '#')
-			continue;	/* recycled line */
+		if (s->pid <= 0)
+			continue;	/* free or in flight */
 
-		if ((s = strchr(buf, ',')) == NULL)
-			continue;	/* line was not expected format */
+		if ((c = strchr(s->entry, ',')) == NULL)
+			continue;	/* entry was not expected format */
 
-		if (strncmp(s + 1, tag, strlen(tag)))
+		if (strncmp(c + 1, tag, strlen(tag)))
 			continue;	/* tag does not match */
 
-		this_pid = atoi(buf);
-		break;
-	} while (1);
-
-	if (zoo_unlock(z))
-		return -1;
-	return this_pid;
-}
-
-int zoo_lock(zoo_t z)
-{
-	FILE *fp = (FILE *) z;
-	struct flock zlock;
-	sigset_t block_these;
-	int ret;
-
-	if (fp == NULL)
-		return -1;
-
-	zlock.l_whence = zlock.l_start = zlock.l_len = 0;
-	zlock.l_type = F_WRLCK;
-
-	sigemptyset(&block_these);
-	sigaddset(&block_these, SIGINT);
-	sigaddset(&block_these, SIGTERM);
-	sigaddset(&block_these, SIGHUP);
-	sigaddset(&block_these, SIGUSR1);
-	sigaddset(&block_these, SIGUSR2);
-	sigprocmask(SIG_BLOCK, &block_these, NULL);
-
-	do {
-		ret = fcntl(fileno(fp), F_SETLKW, &zlock);
-	} while (ret == -1 && errno == EINTR);
-
-	sigprocmask(SIG_UNBLOCK, &block_these, NULL);
-	if (ret == -1) {
-		snprintf(zoo_error, ZELEN,
-			 "failed to unlock zoo file, errno:%d %s",
-			 errno, strerror(errno));
-		return -1;
+		return s->pid;
 	}
-	return 0;
-
-}
-
-int zoo_unlock(zoo_t z)
-{
-	FILE *fp = (FILE *) z;
-	struct flock zlock;
-	sigset_t block_these;
-	int ret;
-
-	if (fp == NULL)
-		return -1;
-
-	zlock.l_whence = zlock.l_start = zlock.l_len = 0;
-	zlock.l_type = F_UNLCK;
-
-	sigemptyset(&block_these);
-	sigaddset(&block_these, SIGINT);
-	sigaddset(&block_these, SIGTERM);
-	sigaddset(&block_these, SIGHUP);
-	sigaddset(&block_these, SIGUSR1);
-	sigaddset(&block_these, SIGUSR2);
-	sigprocmask(SIG_BLOCK, &block_these, NULL);
 
-	do {
-		ret = fcntl(fileno(fp), F_SETLKW, &zlock);
-	} while (ret == -1 && errno == EINTR);
-
-	sigprocmask(SIG_UNBLOCK, &block_these, NULL);
-
-	if (ret == -1) {
-		snprintf(zoo_error, ZELEN,
-			 "failed to lock zoo file, errno:%d %s",
-			 errno, strerror(errno));
-		return -1;
-	}
-	return 0;
+	return -1;
 }
 
 char *cat_args(int argc, char **argv)
@@ -41,7 +41,8 @@
 #include <fcntl.h>
 #include <sys/signal.h>
 
-typedef FILE *zoo_t;
+/* opaque handle for the shared active-test table, see zoolib.c */
+typedef struct zoo *zoo_t;
 #define ZELEN 512
 extern char zoo_error[ZELEN];
 #define BUFLEN 81
@@ -14,6 +14,9 @@
 * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 *
 ***************************************************************************/
+#include <fcntl.h>
+#include <sys/wait.h>
+
 #include "libclone.h"
 
 int do_clone_tests(unsigned long clone_flags,
@@ -103,6 +106,237 @@ int do_plain_tests(int (*fn1) (void *arg), void *arg1,
 	return ret;
 }
 
+/*
+ * Zygote namespace pool.
+ *
+ * Creating and tearing down a fresh namespace set for every test and
+ * variant is slow (netns teardown especially is kernel-side slow and
+ * serialized).  Instead a parked "zygote" child is cloned once per
+ * distinct clone_flags combination; its /proc/<pid>/ns files are kept
+ * open and later callers enter the same namespace set with setns()
+ * from a forked worker.  The zygote just sits on a pipe read and exits
+ * when the pool is torn down.
+ */
+
+#define ZYGOTE_POOL_SIZE 8
+
+static const struct {
+	unsigned long flag;
+	const char *name;
+} ns_names[] = {
+	{CLONE_NEWNS, "mnt"},
+	{CLONE_NEWUTS, "uts"},
+	{CLONE_NEWIPC, "ipc"},
+	{CLONE_NEWUSER, "user"},
+	{CLONE_NEWPID, "pid"},
+	{CLONE_NEWNET, "net"},
+};
+
+#define NR_NS_NAMES (sizeof(ns_names) / sizeof(ns_names[0]))
+
+struct zygote {
+	unsigned long flags;
+	int pid;
+	int kick_fd;		/* closing it lets the zygote exit */
+	int ns_fds[NR_NS_NAMES];
+	int nr_ns;
+};
+
+static struct zygote zygote_pool[ZYGOTE_POOL_SIZE];
+static int zygote_count;
+
+static int zygote_main(void *arg)
+{
+	int *pipefd = arg;
+	long fd, maxfd;
+	char c;
+
+	/*
+	 * Close every inherited fd except our pipe read end; otherwise a
+	 * zygote keeps copies of older zygotes' kick fds alive and their
+	 * EOF-based teardown never completes.
+	 */
+	maxfd = sysconf(_SC_OPEN_MAX);
+	if (maxfd < 0 || maxfd > 65536)
+		maxfd = 65536;
+	for (fd = 3; fd < maxfd; fd++) {
+		if (fd != pipefd[0])
+			close(fd);
+	}
+
+	while (read(pipefd[0], &c, 1) < 0 && errno == EINTR)
+		;
+	exit(0);
+}
+
+static void zygote_drop(struct zygote *z)
+{
+	int i;
+
+	for (i = 0; i < z->nr_ns; i++)
+		close(z->ns_fds[i]);
+	close(z->kick_fd);
+	waitpid(z->pid, NULL, 0);
+	z->pid = 0;
+}
+
+static struct zygote *zygote_get(unsigned long clone_flags)
+{
+	struct zygote *z;
+	char path[64];
+	int pipefd[2];
+	unsigned int i;
+
+	for (i = 0; i < (unsigned int)zygote_count; i++) {
+		if (zygote_pool[i].flags == clone_flags)
+			return &zygote_pool[i];
+	}
+
+	if (zygote_count >= ZYGOTE_POOL_SIZE) {
+		printf("%s: zygote pool exhausted\n", __FUNCTION__);
+		return NULL;
+	}
+
+	if (pipe(pipefd) == -1) {
+		perror("pipe");
+		return NULL;
+	}
+
+	z = &zygote_pool[zygote_count];
+	z->flags = clone_flags;
+	z->nr_ns = 0;
+
+	z->pid = ltp_clone_quick(clone_flags | SIGCHLD, zygote_main, pipefd);
+	if (z->pid == -1) {
+		perror("clone");
+		close(pipefd[0]);
+		close(pipefd[1]);
+		return NULL;
+	}
+	close(pipefd[0]);
+	z->kick_fd = pipefd[1];
+
+	for (i = 0; i < NR_NS_NAMES; i++) {
+		if (!(clone_flags & ns_names[i].flag))
+			continue;
+		sprintf(path, "/proc/%d/ns/%s", z->pid, ns_names[i].name);
+		z->ns_fds[z->nr_ns] = open(path, O_RDONLY);
+		if (z->ns_fds[z->nr_ns] == -1) {
+			perror(path);
+			zygote_drop(z);
+			return NULL;
+		}
+		z->nr_ns++;
+	}
+
+	zygote_count++;
+	return z;
+}
+
+/*
+ * Runs in a forked child: enter the pooled namespaces, then fork once
+ * more so that a CLONE_NEWPID target applies to the worker as well
+ * (setns to a pidns only affects subsequently created children).
+ * Returns fn1's exit status.
+ */
+static int zygote_enter_and_run(struct zygote *z,
+				int (*fn1) (void *arg), void *arg1)
+{
+	int i, pid, status;
+
+	for (i = 0; i < z->nr_ns; i++) {
+		if (ltp_syscall(__NR_setns, z->ns_fds[i], 0) == -1) {
+			perror("setns");
+			return -1;
+		}
+	}
+
+	pid = fork();
+	if (pid == -1) {
+		perror("fork");
+		return -1;
+	}
+	if (pid == 0)
+		exit(fn1(arg1));
+
+	if (waitpid(pid, &status, 0) == -1) {
+		perror("waitpid");
+		return -1;
+	}
+
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int do_zygote_tests(unsigned long clone_flags,
+		    int (*fn1) (void *arg), void *arg1,
+		    int (*fn2) (void *arg), void *arg2)
+{
+	struct zygote *z;
+	int pid, ret = 0;
+
+	z = zygote_get(clone_flags);
+	if (!z)
+		return -1;
+
+	pid = fork();
+	if (pid == -1) {
+		perror("fork");
+		return -1;
+	}
+	if (pid == 0)
+		exit(zygote_enter_and_run(z, fn1, arg1));
+
+	if (fn2)
+		ret = fn2(arg2);
+
+	return ret;
+}
+
+/*
+ * Run fn synchronously inside the pooled namespace set for clone_flags,
+ * typically to scrub leftover state (interfaces, mounts, keys) before
+ * the namespaces are handed to the next test.  Returns fn's exit status.
+ */
+int libclone_zygote_reset(unsigned long clone_flags,
+			  int (*fn) (void *arg), void *arg)
+{
+	struct zygote *z;
+	int pid, status;
+
+	z = zygote_get(clone_flags);
+	if (!z)
+		return -1;
+
+	pid = fork();
+	if (pid == -1) {
+		perror("fork");
+		return -1;
+	}
+	if (pid == 0)
+		exit(zygote_enter_and_run(z, fn, arg));
+
+	if (waitpid(pid, &status, 0) == -1) {
+		perror("waitpid");
+		return -1;
+	}
+
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/*
+ * Tear down all pooled namespace sets; the namespaces themselves go
+ * away once the parked zygotes exit and the last ns fd is closed.
+ */
+void libclone_zygote_destroy(void)
+{
+	int i;
+
+	/* newest first, it may hold fd copies of the older entries */
+	for (i = zygote_count - 1; i >= 0; i--)
+		zygote_drop(&zygote_pool[i]);
+	zygote_count = 0;
+}
+
 int do_clone_unshare_test(int use_clone, unsigned long clone_flags,
 			  int (*fn1) (void *arg), void *arg1)
 {
@@ -113,6 +347,8 @@ int do_clone_unshare_test(int use_clone, unsigned long clone_flags,
 		return do_clone_tests(clone_flags, fn1, arg1, NULL, NULL);
 	case T_UNSHARE:
 		return do_unshare_tests(clone_flags, fn1, arg1, NULL, NULL);
+	case T_ZYGOTE:
+		return do_zygote_tests(clone_flags, fn1, arg1, NULL, NULL);
 	default:
 		printf("%s: bad use_clone option: %d\n", __FUNCTION__,
 		       use_clone);
@@ -134,6 +370,8 @@ int do_clone_unshare_tests(int use_clone, unsigned long clone_flags,
 		return do_clone_tests(clone_flags, fn1, arg1, fn2, arg2);
 	case T_UNSHARE:
 		return do_unshare_tests(clone_flags, fn1, arg1, fn2, arg2);
+	case T_ZYGOTE:
+		return do_zygote_tests(clone_flags, fn1, arg1, fn2, arg2);
 	default:
 		printf("%s: bad use_clone option: %d\n", __FUNCTION__,
 		       use_clone);
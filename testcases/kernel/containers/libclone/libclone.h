@@ -33,6 +33,7 @@
 #define T_UNSHARE 0
 #define T_CLONE 1
 #define T_NONE 2
+#define T_ZYGOTE 3
 
 #ifndef SYS_unshare
 #ifdef __NR_unshare
@@ -72,6 +73,23 @@ int do_unshare_tests(unsigned long clone_flags,
 int do_fork_tests(int (*fn1)(void *arg), void *arg1,
 			int (*fn2)(void *arg), void *arg2);
 
+/*
+ * Run fn1 inside a pooled namespace set entered with setns().  The
+ * namespaces are created once per distinct clone_flags combination by
+ * a parked zygote child and reused by all subsequent callers, avoiding
+ * per-test namespace construction and teardown.  Fn2 may be NULL.
+ */
+int do_zygote_tests(unsigned long clone_flags,
+			int (*fn1)(void *arg), void *arg1,
+			int (*fn2)(void *arg), void *arg2);
+
+/* Run fn synchronously in the pooled set, e.g. to reset leftover state */
+int libclone_zygote_reset(unsigned long clone_flags,
+			int (*fn)(void *arg), void *arg);
+
+/* Tear down all pooled namespace sets */
+void libclone_zygote_destroy(void);
+
 int do_clone_unshare_test(int use_clone, unsigned long clone_flags,
 			int (*fn1)(void *arg), void *arg1);
 
@@ -199,16 +199,38 @@ netns_ns_exec_setup()
 	tst_brk TBROK "unable to add device veth1 to the separate network namespace"
 }
 
+# Returns 0 when both pool namespaces exist and hold their end of the
+# veth pair, i.e. a previous test left them behind ready for reuse.
+netns_pair_pristine()
+{
+	ip netns list | grep -q "^$NS_HANDLE0" || return 1
+	ip netns list | grep -q "^$NS_HANDLE1" || return 1
+	$NS_EXEC $NS_HANDLE0 ip link show veth0 >/dev/null 2>&1 || return 1
+	$NS_EXEC $NS_HANDLE1 ip link show veth1 >/dev/null 2>&1 || return 1
+}
+
 # Sets up NS_EXEC to use 'ip netns exec', creates two network namespaces
 # and stores their handles into NS_HANDLE0 and NS_HANDLE1 variables. Virtual
 # ethernet device is then created for each namespace.
+#
+# With LTP_NETNS_REUSE=1 the namespace pair and its veth plumbing are kept
+# across tests instead of being deleted in cleanup: the first test creates
+# them, later tests only check they are pristine and reassign addresses,
+# which turns the ~100ms veth setup into a couple of netlink queries.
+# A parallel runner can maintain a pool of pairs by giving each worker a
+# distinct LTP_NETNS_ID, which is folded into the namespace names.
 netns_ip_setup()
 {
 	tst_check_iproute 111010
 	NS_EXEC="ip netns exec"
 
-	NS_HANDLE0=tst_net_ns0
-	NS_HANDLE1=tst_net_ns1
+	NS_HANDLE0=tst_net_ns${LTP_NETNS_ID}0
+	NS_HANDLE1=tst_net_ns${LTP_NETNS_ID}1
+
+	if [ "$LTP_NETNS_REUSE" = 1 ] && netns_pair_pristine; then
+		tst_res TINFO "reusing netns pair $NS_HANDLE0/$NS_HANDLE1"
+		return
+	fi
 
 	ip netns del $NS_HANDLE0 2>/dev/null
 	ip netns del $NS_HANDLE1 2>/dev/null
@@ -291,6 +313,19 @@ netns_ip_cleanup()
 		return
 	fi
 
+	if [ "$LTP_NETNS_REUSE" = 1 ]; then
+		# Return the pair to the pool pristine: drop the addresses
+		# and take the links down, but keep the namespaces and the
+		# veth plumbing for the next test. The DAD/RA sysctls are
+		# rewritten by every netns_set_ip() call so they need no
+		# restoring here.
+		$NS_EXEC $NS_HANDLE0 ip address flush dev veth0 2>/dev/null
+		$NS_EXEC $NS_HANDLE1 ip address flush dev veth1 2>/dev/null
+		$NS_EXEC $NS_HANDLE0 ip link set veth0 down 2>/dev/null
+		$NS_EXEC $NS_HANDLE1 ip link set veth1 down 2>/dev/null
+		return
+	fi
+
 	# removes veth0 device (which also removes the paired veth1 device)
 	$NS_EXEC $NS_HANDLE0 ip link delete veth0
 
@@ -65,17 +65,29 @@ create_subgroup()
     path="$1"
 
     ROD mkdir "$path"
+    init_subgroup "$path"
+}
+
+# cpuset.cpus and cpuset.mems must be initialized with suitable value
+# before any pids are attached
+init_subgroup()
+{
+    path="$1"
 
-    # cpuset.cpus and cpuset.mems must be initialized with suitable value
-    # before any pids are attached
     if [ "$subsystem" = "cpuset" ]; then
-        if [ -e "$mount_point/cpus" ]; then
-            ROD cat "$mount_point/cpus" \> "$path/cpus"
-            ROD cat "$mount_point/mems" \> "$path/mems"
-        else
-            ROD cat "$mount_point/cpuset.cpus" \> "$path/cpuset.cpus"
-            ROD cat "$mount_point/cpuset.mems" \> "$path/cpuset.mems"
+        # Cache the root values, so that building a big tree does not
+        # fork a pair of cat processes per subgroup
+        if [ -z "$cpuset_cpus" ]; then
+            if [ -e "$mount_point/cpus" ]; then
+                cpuset_prefix=
+            else
+                cpuset_prefix="cpuset."
+            fi
+            read cpuset_cpus < "$mount_point/${cpuset_prefix}cpus"
+            read cpuset_mems < "$mount_point/${cpuset_prefix}mems"
         fi
+        ROD echo "$cpuset_cpus" \> "$path/${cpuset_prefix}cpus"
+        ROD echo "$cpuset_mems" \> "$path/${cpuset_prefix}mems"
     fi
 }
 
@@ -76,21 +76,29 @@ export TMPFILE=./tmp_tasks.$$
 count=0
 collected_pids=
 
+subgroup_list=$(seq 1 $subgroup_num)
+
 build_subgroups()
 {
-    local cur_path="$1"
-    local cur_depth="$2"
-    local i
-
-    if [ "$cur_depth" -gt "$subgroup_depth" ]; then
-        return
-    fi
-
-    create_subgroup "$cur_path"
-    count=$((count+1))
-
-    for i in $(seq 1 $subgroup_num); do
-         build_subgroups "$cur_path/$i" $((cur_depth+1))
+    local cur_paths="$1"
+    local cur_depth=0
+    local next_paths path i
+
+    while [ "$cur_depth" -le "$subgroup_depth" ]; do
+        # a single mkdir call creates the whole level at once
+        ROD mkdir $cur_paths
+
+        next_paths=
+        for path in $cur_paths; do
+            init_subgroup "$path"
+            count=$((count+1))
+            for i in $subgroup_list; do
+                next_paths="$next_paths $path/$i"
+            done
+        done
+
+        cur_paths="$next_paths"
+        cur_depth=$((cur_depth+1))
     done
 }
 
@@ -133,7 +141,7 @@ start_path="$mount_point/ltp"
 
 tst_resm TINFO "Creating subgroups ..."
 
-build_subgroups "$start_path" 0
+build_subgroups "$start_path"
 
 tst_resm TINFO "... mkdired $count times"
 
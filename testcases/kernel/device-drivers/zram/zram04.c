@@ -0,0 +1,306 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * zram04 - zram throughput, latency and compression ratio benchmark
+ *
+ * The zram shell tests configure devices and check correctness but
+ * measure nothing, so compression-path regressions reach swap-on-zram
+ * setups unnoticed. This test hot-adds a private zram device and, for
+ * a set of data patterns covering the compressibility spectrum (zero
+ * pages, repetitive text, incompressible random data and a 50/50
+ * mix), reports
+ *
+ *  - 4K O_DIRECT write latency percentiles from a single thread,
+ *    which is the path a swap-out takes,
+ *
+ *  - aggregate write and read-back throughput with one thread per
+ *    CPU on disjoint ranges of the same device,
+ *
+ *  - the compression ratio achieved, read from mm_stat.
+ *
+ * The device is reset between patterns so each ratio is exact.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+#define HOT_ADD_PATH	"/sys/class/zram-control/hot_add"
+#define HOT_REMOVE_PATH	"/sys/class/zram-control/hot_remove"
+
+#define PAGE 4096
+#define POOL_PAGES 1024
+
+enum pattern {
+	PAT_ZERO,
+	PAT_TEXT,
+	PAT_RANDOM,
+	PAT_MIXED,
+};
+
+static const char *const pattern_names[] = {
+	"zero", "text", "random", "mixed"
+};
+
+static struct tst_hist hist;
+static long size_mb = 256;
+static int nthreads;
+static int lat_iters = 8192;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static int devnum = -1;
+static int dev_fd = -1;
+static char dev_path[64];
+static char sys_path[64];
+static char reset_path[80];
+static char disksize_path[80];
+static char mm_stat_path[80];
+static char *pool;
+static long npages;
+static pthread_barrier_t barrier;
+
+static int cur_op;
+
+static char *str_size;
+static char *str_threads;
+static char *str_lat_iters;
+static char *str_bits;
+
+static void fill_pool(enum pattern pat)
+{
+	static const char text[] =
+		"the quick brown fox jumps over the lazy dog; "
+		"pack my box with five dozen liquor jugs.\n";
+	long i;
+
+	switch (pat) {
+	case PAT_ZERO:
+		memset(pool, 0, POOL_PAGES * PAGE);
+		break;
+	case PAT_TEXT:
+		for (i = 0; i < POOL_PAGES * PAGE; i++)
+			pool[i] = text[i % (sizeof(text) - 1)];
+		break;
+	case PAT_RANDOM:
+		for (i = 0; i < POOL_PAGES * PAGE / 4; i++)
+			((int *)pool)[i] = rand();
+		break;
+	case PAT_MIXED:
+		for (i = 0; i < POOL_PAGES; i++) {
+			char *p = pool + i * PAGE;
+			long j;
+
+			for (j = 0; j < PAGE / 2; j++)
+				p[j] = text[j % (sizeof(text) - 1)];
+			for (j = 0; j < PAGE / 8; j++)
+				((int *)(p + PAGE / 2))[j] = rand();
+		}
+		break;
+	}
+}
+
+static char *pool_page(long page)
+{
+	return pool + (page % POOL_PAGES) * PAGE;
+}
+
+static void *worker(void *arg)
+{
+	long tid = (long)(uintptr_t)arg;
+	long first = tid * (npages / nthreads);
+	long last = tid == nthreads - 1 ?
+		npages : (tid + 1) * (npages / nthreads);
+	char *rbuf = SAFE_MEMALIGN(PAGE, PAGE);
+	long p;
+
+	pthread_barrier_wait(&barrier);
+
+	for (p = first; p < last; p++) {
+		if (cur_op == O_WRONLY) {
+			if (pwrite(dev_fd, pool_page(p), PAGE, p * PAGE) != PAGE)
+				tst_brk(TBROK | TERRNO, "pwrite() page %ld", p);
+		} else {
+			if (pread(dev_fd, rbuf, PAGE, p * PAGE) != PAGE)
+				tst_brk(TBROK | TERRNO, "pread() page %ld", p);
+		}
+	}
+
+	free(rbuf);
+	return NULL;
+}
+
+static double run_threads(int op)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	pthread_t *tids;
+	long i;
+
+	cur_op = op;
+	tids = SAFE_MALLOC(nthreads * sizeof(pthread_t));
+
+	if (pthread_barrier_init(&barrier, NULL, nthreads + 1))
+		tst_brk(TBROK, "pthread_barrier_init()");
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_CREATE(&tids[i], NULL, worker,
+				    (void *)(uintptr_t)i);
+
+	pthread_barrier_wait(&barrier);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_JOIN(tids[i], NULL);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	pthread_barrier_destroy(&barrier);
+	free(tids);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+	return 1000.0 * npages * PAGE / elapsed_ms / (1024 * 1024);
+}
+
+static double compression_ratio(void)
+{
+	long long orig, compr;
+
+	SAFE_FILE_SCANF(mm_stat_path, "%lli %lli", &orig, &compr);
+
+	/* same-filled pages are stored without compressed data */
+	return MIN(orig / (double)MAX(compr, 1LL), 9999.0);
+}
+
+static void bench_pattern(enum pattern pat)
+{
+	struct timespec t1, t2;
+	double wr_mbs, rd_mbs, ratio;
+	int i;
+
+	fill_pool(pat);
+	tst_hist_reset(&hist);
+
+	/* single-thread write latency, the swap-out path */
+	for (i = 0; i < lat_iters; i++) {
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (pwrite(dev_fd, pool_page(i), PAGE,
+			   (i % npages) * (off_t)PAGE) != PAGE)
+			tst_brk(TBROK | TERRNO, "pwrite()");
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		tst_hist_add(&hist, tst_timespec_diff_ns(t2, t1));
+	}
+
+	wr_mbs = run_threads(O_WRONLY);
+	ratio = compression_ratio();
+	rd_mbs = run_threads(O_RDONLY);
+
+	tst_res(TINFO,
+		"%-6s: wr p50 %6lldns, p99 %7lldns, p99.9 %8lldns, wr %7.0f MB/s, rd %7.0f MB/s, ratio %5.1f",
+		pattern_names[pat],
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9),
+		wr_mbs, rd_mbs, ratio);
+
+	SAFE_CLOSE(dev_fd);
+	SAFE_FILE_PRINTF(reset_path, "1");
+	SAFE_FILE_PRINTF(disksize_path, "%lli", size_mb * 1024 * 1024LL);
+	dev_fd = SAFE_OPEN(dev_path, O_RDWR | O_DIRECT);
+}
+
+static void run(void)
+{
+	unsigned int i;
+
+	SAFE_FILE_PRINTF(disksize_path, "%lli", size_mb * 1024 * 1024LL);
+
+	dev_fd = SAFE_OPEN(dev_path, O_RDWR | O_DIRECT);
+
+	for (i = 0; i < ARRAY_SIZE(pattern_names); i++)
+		bench_pattern(i);
+
+	SAFE_CLOSE(dev_fd);
+
+	tst_res(TPASS, "zram rates measured for %zu patterns at %i threads",
+		ARRAY_SIZE(pattern_names), nthreads);
+}
+
+static void setup(void)
+{
+	if (str_size) {
+		if (tst_parse_long(str_size, &size_mb, 16, LONG_MAX))
+			tst_brk(TBROK, "Invalid device size '%s'", str_size);
+	}
+
+	nthreads = tst_ncpus();
+	if (str_threads) {
+		if (tst_parse_int(str_threads, &nthreads, 1, 4096))
+			tst_brk(TBROK, "Invalid thread count '%s'", str_threads);
+	}
+
+	if (str_lat_iters) {
+		if (tst_parse_int(str_lat_iters, &lat_iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid op count '%s'", str_lat_iters);
+	}
+
+	if (str_bits) {
+		if (tst_parse_int(str_bits, &hist_bits, 1, 16))
+			tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+	}
+
+	if (access(HOT_ADD_PATH, F_OK))
+		tst_brk(TCONF, "system has no zram-control interface");
+
+	SAFE_FILE_SCANF(HOT_ADD_PATH, "%d", &devnum);
+	snprintf(dev_path, sizeof(dev_path), "/dev/zram%d", devnum);
+	snprintf(sys_path, sizeof(sys_path), "/sys/block/zram%d", devnum);
+	snprintf(reset_path, sizeof(reset_path), "%s/reset", sys_path);
+	snprintf(disksize_path, sizeof(disksize_path), "%s/disksize", sys_path);
+	snprintf(mm_stat_path, sizeof(mm_stat_path), "%s/mm_stat", sys_path);
+
+	npages = size_mb * 1024 * 1024LL / PAGE;
+	pool = SAFE_MEMALIGN(PAGE, POOL_PAGES * PAGE);
+
+	srand(time(NULL));
+	tst_hist_init(&hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	if (dev_fd != -1)
+		SAFE_CLOSE(dev_fd);
+
+	if (devnum != -1) {
+		SAFE_FILE_PRINTF(reset_path, "1");
+		SAFE_FILE_PRINTF(HOT_REMOVE_PATH, "%d", devnum);
+	}
+
+	free(pool);
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.needs_root = 1,
+	.options = (struct tst_option[]) {
+		{"s:", &str_size, "-s MB    Device size in megabytes (default 256)"},
+		{"t:", &str_threads, "-t N     Concurrent threads (default: one per CPU)"},
+		{"n:", &str_lat_iters, "-n N     Latency sample writes per pattern (default 8192)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
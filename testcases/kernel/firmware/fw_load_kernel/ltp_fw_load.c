@@ -126,6 +126,36 @@ static ssize_t sys_fwnum(struct device *dev,
 }
 static DEVICE_ATTR(fwnum, S_IWUSR, NULL, sys_fwnum);
 
+/*
+ * request a single firmware by the name written to the file,
+ * the write completes only when the request does, so userspace
+ * can time individual loads around it
+ */
+static ssize_t sys_load(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	const struct firmware *fw_entry = NULL;
+	char name[max_name];
+	size_t len;
+	int err;
+
+	snprintf(name, max_name, "%s", buf);
+	len = strlen(name);
+	if (len && name[len - 1] == '\n')
+		name[len - 1] = '\0';
+	if (!name[0])
+		return -EINVAL;
+
+	err = request_firmware(&fw_entry, name, &tdev);
+	if (err) {
+		pr_info(TCID ": Can't request firmware '%s'\n", name);
+		return err;
+	}
+	release_firmware(fw_entry);
+	return count;
+}
+static DEVICE_ATTR(load, S_IWUSR, NULL, sys_load);
+
 static int test_init(void)
 {
 	int err;
@@ -148,6 +178,14 @@ static int test_init(void)
 		pr_err(TCID ": Can't create sysfs file 'fwnum'\n");
 		device_remove_file(&tdev, &dev_attr_result);
 		device_unregister(&tdev);
+		return err;
+	}
+	err = device_create_file(&tdev, &dev_attr_load);
+	if (err) {
+		pr_err(TCID ": Can't create sysfs file 'load'\n");
+		device_remove_file(&tdev, &dev_attr_fwnum);
+		device_remove_file(&tdev, &dev_attr_result);
+		device_unregister(&tdev);
 	}
 	return err;
 }
@@ -155,6 +193,7 @@ module_init(test_init);
 
 static void test_exit(void)
 {
+	device_remove_file(&tdev, &dev_attr_load);
 	device_remove_file(&tdev, &dev_attr_result);
 	device_remove_file(&tdev, &dev_attr_fwnum);
 
@@ -0,0 +1,331 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ *
+ * Measures request_firmware() latency through the ltp_fw_load module's
+ * 'load' sysfs file. A write to that file requests the named firmware
+ * and completes only when the request does, so timing the write from
+ * here times the whole in-kernel load.
+ *
+ * Paths priced:
+ *  - cold and warm loads of blobs of several sizes (cold right after
+ *    dropping the caches, warm with the blob in the page cache),
+ *  - a request for a missing blob, i.e. the lookup-miss path; when the
+ *    user-helper fallback is built in this includes the fallback wait,
+ *    which the test caps via /sys/class/firmware/timeout beforehand,
+ *  - concurrent requests for the same blob from several processes, the
+ *    device-probe-storm case that slows driver initialization.
+ *
+ * Only load failures fail the test, the latencies are informational.
+ */
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "safe_macros.h"
+#include "old_module.h"
+
+/* number of test firmware blob sizes */
+#define FW_SIZES	3
+
+char *TCID = "fw_load_lat";
+int TST_TOTAL = FW_SIZES + 2;
+
+static const char module_name[]	= "ltp_fw_load.ko";
+static const char dev_load[]	= "/sys/devices/ltp_fw_load/load";
+static const char fw_timeout[]	= "/sys/class/firmware/timeout";
+static const char drop_caches[]	= "/proc/sys/vm/drop_caches";
+static const char fw_dir[]	= "/lib/firmware";
+
+static const int fw_sizes[FW_SIZES] = { 0x1000, 0x40000, 0x400000 };
+
+static char fw_names[FW_SIZES][32];
+static char *fw_files[FW_SIZES];
+static int remove_dir;
+static int old_timeout = -1;
+
+static int nloads = 50;
+static int nproc = 4;
+
+/* test options */
+static char *narg, *parg;
+static int nflag, pflag;
+static int skip_cleanup;
+static int verbose;
+static const option_t options[] = {
+	{"n:", &nflag, &narg},
+	{"p:", &pflag, &parg},
+	{"s", &skip_cleanup, NULL},
+	{"v", &verbose, NULL},
+	{NULL, NULL, NULL}
+};
+
+static void help(void);
+static void setup(int argc, char *argv[]);
+static void test_sizes(void);
+static void test_miss(void);
+static void test_concurrent(void);
+static void cleanup(void);
+
+int main(int argc, char *argv[])
+{
+	setup(argc, argv);
+
+	test_sizes();
+	test_miss();
+	test_concurrent();
+
+	cleanup();
+
+	tst_exit();
+}
+
+static void help(void)
+{
+	printf("  -n x    Measured loads per blob size, default is %d\n",
+		nloads);
+	printf("  -p x    Concurrent loader processes, default is %d\n",
+		nproc);
+	printf("  -s      Skip cleanup\n");
+	printf("  -v      Verbose\n");
+}
+
+/*
+ * request firmware 'name' once by writing it to the module's load file,
+ * returns the time the write took in usec or -1 and sets *err when the
+ * load failed
+ */
+static long long load_usec(const char *name, int *err)
+{
+	struct timespec t1, t2;
+	ssize_t ret;
+	int fd;
+
+	*err = 0;
+	fd = open(dev_load, O_WRONLY);
+	if (fd == -1) {
+		*err = errno;
+		return -1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	ret = write(fd, name, strlen(name));
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	if (ret == -1)
+		*err = errno;
+	close(fd);
+
+	if (*err)
+		return -1;
+
+	return (t2.tv_sec - t1.tv_sec) * 1000000LL +
+		(t2.tv_nsec - t1.tv_nsec) / 1000;
+}
+
+static void create_blob(int i)
+{
+	FILE *f = SAFE_FOPEN(cleanup, fw_files[i], "w");
+	int k;
+
+	for (k = 0; k < fw_sizes[i]; ++k)
+		fputc(i, f);
+	SAFE_FCLOSE(cleanup, f);
+}
+
+void setup(int argc, char *argv[])
+{
+	tst_parse_opts(argc, argv, options, help);
+
+	if (nflag) {
+		if (sscanf(narg, "%i", &nloads) != 1 || nloads <= 0)
+			tst_brkm(TBROK, NULL, "-n option arg is not valid");
+	}
+	if (pflag) {
+		if (sscanf(parg, "%i", &nproc) != 1 || nproc <= 0)
+			tst_brkm(TBROK, NULL, "-p option arg is not valid");
+	}
+
+	tst_require_root();
+
+	if (tst_kvercmp(3, 7, 0) < 0) {
+		tst_brkm(TCONF, NULL,
+			"Test must be run with kernel 3.7 or newer");
+	}
+
+	tst_module_load(NULL, module_name, NULL);
+
+	tst_sig(FORK, DEF_HANDLER, cleanup);
+
+	if (access(dev_load, F_OK) == -1) {
+		tst_brkm(TCONF, cleanup,
+			"module has no 'load' file, kernel tree too old?");
+	}
+
+	if (access(fw_dir, X_OK) == -1) {
+		SAFE_MKDIR(cleanup, fw_dir, 0755);
+		remove_dir = 1;
+	}
+
+	int i;
+	for (i = 0; i < FW_SIZES; ++i) {
+		snprintf(fw_names[i], sizeof(fw_names[i]),
+			"ltp_lat%d_load_tst.fw", i);
+		SAFE_ASPRINTF(cleanup, &fw_files[i], "%s/%s",
+			fw_dir, fw_names[i]);
+		create_blob(i);
+	}
+
+	/*
+	 * cap the user-helper fallback wait so a miss doesn't stall the
+	 * test for the default 60 seconds
+	 */
+	if (!access(fw_timeout, W_OK)) {
+		FILE_SCANF(fw_timeout, "%d", &old_timeout);
+		SAFE_FILE_PRINTF(cleanup, fw_timeout, "%d", 2);
+	}
+}
+
+static void test_sizes(void)
+{
+	int i, k, err, fails;
+	long long t, cold, min, max, sum;
+
+	for (i = 0; i < FW_SIZES; ++i) {
+		sync();
+		FILE_PRINTF(drop_caches, "3");
+
+		cold = load_usec(fw_names[i], &err);
+		fails = (cold == -1);
+
+		min = max = sum = 0;
+		for (k = 0; k < nloads; ++k) {
+			t = load_usec(fw_names[i], &err);
+			if (t == -1) {
+				++fails;
+				continue;
+			}
+			if (!k || t < min)
+				min = t;
+			if (t > max)
+				max = t;
+			sum += t;
+		}
+
+		if (fails) {
+			tst_resm(TFAIL, "%d of %d loads of '%s' failed",
+				fails, nloads + 1, fw_names[i]);
+			continue;
+		}
+
+		tst_resm(TPASS,
+			"%7d bytes: cold %6lld us, warm min/avg/max %lld/%lld/%lld us",
+			fw_sizes[i], cold, min, sum / nloads, max);
+	}
+}
+
+static void test_miss(void)
+{
+	int err;
+	long long t;
+	struct timespec t1, t2;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	t = load_usec("ltp_lat_missing_load_tst.fw", &err);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	if (t != -1) {
+		tst_resm(TFAIL, "request for missing firmware succeeded");
+		return;
+	}
+
+	t = (t2.tv_sec - t1.tv_sec) * 1000000LL +
+		(t2.tv_nsec - t1.tv_nsec) / 1000;
+
+	tst_resm(TPASS, "missing firmware refused in %lld us (%s)", t,
+		(old_timeout != -1) ?
+		"includes capped user-helper fallback" : "direct-load miss");
+}
+
+static void test_concurrent(void)
+{
+	struct timespec t1, t2;
+	int i, k, err, fails = 0;
+	long long t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nproc; ++i) {
+		pid_t pid = tst_fork();
+
+		if (pid == -1)
+			tst_brkm(TBROK | TERRNO, cleanup, "fork failed");
+
+		if (!pid) {
+			/* all loaders hammer the same mid-size blob */
+			for (k = 0; k < nloads; ++k) {
+				if (load_usec(fw_names[1], &err) == -1)
+					exit(1);
+			}
+			exit(0);
+		}
+	}
+
+	for (i = 0; i < nproc; ++i) {
+		int status;
+
+		SAFE_WAITPID(cleanup, -1, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			++fails;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	if (fails) {
+		tst_resm(TFAIL, "%d of %d concurrent loaders failed",
+			fails, nproc);
+		return;
+	}
+
+	t = (t2.tv_sec - t1.tv_sec) * 1000000LL +
+		(t2.tv_nsec - t1.tv_nsec) / 1000;
+	t = (t > 0) ? t : 1;
+
+	tst_resm(TPASS,
+		"%d loaders x %d loads of '%s': %lld us, %lld loads/s",
+		nproc, nloads, fw_names[1], t,
+		(long long)nproc * nloads * 1000000 / t);
+}
+
+static void cleanup(void)
+{
+	if (skip_cleanup)
+		return;
+
+	if (old_timeout != -1)
+		FILE_PRINTF(fw_timeout, "%d", old_timeout);
+
+	int i;
+	for (i = 0; i < FW_SIZES; ++i) {
+		if (!fw_files[i])
+			continue;
+		if (remove(fw_files[i]) == -1)
+			tst_resm(TWARN, "Can't remove: %s", fw_files[i]);
+		free(fw_files[i]);
+		fw_files[i] = NULL;
+	}
+
+	if (remove_dir && remove(fw_dir) == -1)
+		tst_resm(TWARN, "Can't remove %s", fw_dir);
+
+	tst_module_unload(NULL, module_name);
+}
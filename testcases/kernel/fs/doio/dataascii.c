@@ -36,6 +36,13 @@
 #define CHARS		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghjiklmnopqrstuvwxyz\n"
 #define CHARS_SIZE	sizeof(CHARS)
 
+/*
+ * Size of the expected-data template built by dataasciichk().  Fill and
+ * check work on template sized blocks through memcpy()/memcmp(), which
+ * the libc implements word or vector wide, rather than byte by byte.
+ */
+#define TEMPLATE_SIZE	1024
+
 #ifdef UNIT_TEST
 #include <stdlib.h>
 #endif
@@ -62,11 +69,23 @@ int dataasciigen(char *listofchars, char *buffer, int bsize, int offset)
 		chars_size = strlen(listofchars);
 	}
 
-	for (cnt = offset; cnt < total; cnt++) {
+	/*
+	 * Write out the first period of the pattern byte by byte, then
+	 * replicate it by doubling the filled prefix with memcpy() until
+	 * the buffer is full.
+	 */
+	for (cnt = offset; cnt < total && cnt - offset < chars_size; cnt++) {
 		ind = cnt % chars_size;
 		*chr++ = charlist[ind];
 	}
 
+	ind = cnt - offset;
+	while (ind < bsize) {
+		cnt = (ind <= bsize - ind) ? ind : bsize - ind;
+		memcpy(buffer + ind, buffer, cnt);
+		ind += cnt;
+	}
+
 	return bsize;
 }
 
@@ -76,9 +95,11 @@ int dataasciichk(char *listofchars, char *buffer, int bsize,
 	int cnt;
 	int total;
 	int ind;
+	int tlen;
 	char *chr;
 	int chars_size;
 	char *charlist;
+	char exp[TEMPLATE_SIZE];
 
 	chr = buffer;
 	total = offset + bsize;
@@ -94,7 +115,27 @@ int dataasciichk(char *listofchars, char *buffer, int bsize,
 	if (errmsg != NULL)
 		*errmsg = Errmsg;
 
-	for (cnt = offset; cnt < total; chr++, cnt++) {
+	/*
+	 * Skip over matching template sized blocks with memcmp() and
+	 * leave the byte loop below to scan only a mismatching block or
+	 * the short tail.  The template holds a whole number of pattern
+	 * periods so every block starts at the same phase; patterns
+	 * longer than the template get the plain byte loop.
+	 */
+	cnt = offset;
+	tlen = TEMPLATE_SIZE / chars_size * chars_size;
+
+	if (tlen > 0) {
+		for (ind = 0; ind < tlen; ind++)
+			exp[ind] = charlist[(offset + ind) % chars_size];
+
+		while (total - cnt >= tlen && memcmp(chr, exp, tlen) == 0) {
+			chr += tlen;
+			cnt += tlen;
+		}
+	}
+
+	for (; cnt < total; chr++, cnt++) {
 		ind = cnt % chars_size;
 		if (*chr != charlist[ind]) {
 			sprintf(Errmsg,
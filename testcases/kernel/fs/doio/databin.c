@@ -41,9 +41,18 @@
 
 static char Errmsg[80];
 
+/*
+ * Size of the expected-data template used by databinchk().  A multiple
+ * of the 8 byte counting pattern period, so that every template sized
+ * block starts at the same phase and can be compared with one memcmp(),
+ * which the libc implements word or vector wide.
+ */
+#define TEMPLATE_SIZE	1024
+
 void databingen(int mode, char *buffer, int bsize, int offset)
 {
 	int ind;
+	int nb;
 
 	switch (mode) {
 	default:
@@ -55,10 +64,20 @@ void databingen(int mode, char *buffer, int bsize, int offset)
 		memset(buffer, 0xf0, bsize);
 		break;
 
-	case 'C':		/* */
-		for (ind = 0; ind < bsize; ind++)
+	case 'C':		/* counting pattern */
+		/*
+		 * Write out the first period byte by byte, then replicate
+		 * it by doubling the filled prefix with memcpy().
+		 */
+		for (ind = 0; ind < bsize && ind < 8; ind++)
 			buffer[ind] = ((offset + ind) % 8 & 0177);
 
+		while (ind < bsize) {
+			nb = (ind <= bsize - ind) ? ind : bsize - ind;
+			memcpy(buffer + ind, buffer, nb);
+			ind += nb;
+		}
+
 		break;
 
 	case 'o':
@@ -83,9 +102,11 @@ void databingen(int mode, char *buffer, int bsize, int offset)
 int databinchk(int mode, char *buffer, int bsize, int offset, char **errmsg)
 {
 	int cnt;
+	int nb;
 	unsigned char *chr;
 	long expbits;
 	long actbits;
+	unsigned char exp[TEMPLATE_SIZE];
 
 	chr = (unsigned char *)buffer;
 
@@ -103,7 +124,20 @@ int databinchk(int mode, char *buffer, int bsize, int offset, char **errmsg)
 		break;
 
 	case 'C':		/* counting pattern */
-		for (cnt = 0; cnt < bsize; cnt++) {
+		for (cnt = 0; cnt < TEMPLATE_SIZE; cnt++)
+			exp[cnt] = ((offset + cnt) % 8 & 0177);
+
+		/*
+		 * Skip over matching template sized blocks with memcmp()
+		 * and leave the byte loop to scan only a mismatching
+		 * block or the short tail.
+		 */
+		nb = 0;
+		while (bsize - nb >= TEMPLATE_SIZE &&
+		       memcmp(chr + nb, exp, TEMPLATE_SIZE) == 0)
+			nb += TEMPLATE_SIZE;
+
+		for (cnt = nb; cnt < bsize; cnt++) {
 			expbits = ((offset + cnt) % 8 & 0177);
 
 			if (buffer[cnt] != expbits) {
@@ -128,7 +162,15 @@ int databinchk(int mode, char *buffer, int bsize, int offset, char **errmsg)
 		return -1;	/* no check can be done for random */
 	}
 
-	for (cnt = 0; cnt < bsize; chr++, cnt++) {
+	/* as above, memcmp() whole blocks and rescan only on mismatch */
+	memset(exp, (int)expbits, TEMPLATE_SIZE);
+
+	nb = 0;
+	while (bsize - nb >= TEMPLATE_SIZE &&
+	       memcmp(chr + nb, exp, TEMPLATE_SIZE) == 0)
+		nb += TEMPLATE_SIZE;
+
+	for (cnt = nb, chr += nb; cnt < bsize; chr++, cnt++) {
 		actbits = (long)*chr;
 
 		if (actbits != expbits) {
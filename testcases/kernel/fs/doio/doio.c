@@ -47,6 +47,7 @@
  *
  */
 
+#include "config.h"
 #include <stdio.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -81,13 +82,23 @@
 #include <sys/panic.h>
 #endif
 #include <sys/time.h>		/* for delays */
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
 
 #include "doio.h"
+#include "tlibio.h"		/* for stride_bounds() */
 #include "write_log.h"
 #include "random_range.h"
 #include "string_to_tokens.h"
 #include "pattern.h"
 
+/* raw syscalls - the lapi wrapper header is tied to the new test harness */
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+#define URING_RW 1
+#endif
+
 #define	NMEMALLOC	32
 #define	MEM_DATA	1	/* data space                           */
 #define	MEM_SHMEM	2	/* System V shared memory               */
@@ -388,6 +399,15 @@ struct status *sy_mmwrite(struct io_req *req, struct syscall_info *sysc,
 struct status *sy_mmrw(struct io_req *req, struct syscall_info *sysc,
 		       int fd, char *addr, int rw);
 char *fmt_mmrw(struct io_req *req, struct syscall_info *sy, int fd, char *addr);
+
+struct status *sy_uringread(struct io_req *req, struct syscall_info *sysc,
+			    int fd, char *addr);
+struct status *sy_uringwrite(struct io_req *req, struct syscall_info *sysc,
+			     int fd, char *addr);
+struct status *sy_urw(struct io_req *req, struct syscall_info *sysc,
+		      int fd, char *addr, int rw);
+int uring_mem(struct io_req *req, int offset, int fmstride, int *min, int *max);
+char *fmt_urw(struct io_req *req, struct syscall_info *sy, int fd, char *addr);
 #endif /* !CRAY */
 
 int do_rw(struct io_req *req);
@@ -1011,6 +1031,10 @@ void doio(void)
 		case LEREADA:
 		case LEWRITE:
 		case LEWRITEA:
+#ifndef CRAY
+		case URINGREAD:
+		case URINGWRITE:
+#endif
 			rval = do_rw(&ioreq);
 			break;
 
@@ -2975,6 +2999,267 @@ char *fmt_mmrw(struct io_req *req, struct syscall_info *sy, int fd, char *addr)
 
 	return (errbuf);
 }
+
+/*
+ * io_uring batched read/write.  Each request submits r_nent readv/writev
+ * sqes covering consecutive r_nbytes chunks of the file and reaps them
+ * all in a single io_uring_enter(), so data integrity is validated with
+ * up to MAX_AIO-1 operations in flight at once.  F_URING_LINKED chains
+ * the sqes so the kernel must complete them in order, and
+ * F_URING_FIXEDBUF registers the data buffer and submits
+ * IORING_OP_READ_FIXED/WRITE_FIXED instead.  On kernels without
+ * io_uring the batch falls back to pread/pwrite so the request is
+ * still exercised.
+ */
+
+#ifdef URING_RW
+
+static struct {
+	int fd;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+} Uring = { .fd = -1 };
+
+static int Uring_broken = 0;	/* no io_uring on this kernel */
+
+static int uring_init(void)
+{
+	struct io_uring_params p;
+	char *sq, *cq;
+
+	memset(&p, 0, sizeof(p));
+	Uring.fd = syscall(__NR_io_uring_setup, MAX_AIO, &p);
+	if (Uring.fd < 0)
+		return -1;
+
+	sq = mmap(NULL, p.sq_off.array + p.sq_entries * sizeof(unsigned int),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  Uring.fd, IORING_OFF_SQ_RING);
+	cq = mmap(NULL, p.cq_off.cqes +
+		  p.cq_entries * sizeof(struct io_uring_cqe),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  Uring.fd, IORING_OFF_CQ_RING);
+	Uring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+			  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			  Uring.fd, IORING_OFF_SQES);
+
+	if (sq == MAP_FAILED || cq == MAP_FAILED || Uring.sqes == MAP_FAILED) {
+		close(Uring.fd);
+		Uring.fd = -1;
+		return -1;
+	}
+
+	Uring.sq_head = (unsigned int *)(sq + p.sq_off.head);
+	Uring.sq_tail = (unsigned int *)(sq + p.sq_off.tail);
+	Uring.sq_mask = (unsigned int *)(sq + p.sq_off.ring_mask);
+	Uring.sq_array = (unsigned int *)(sq + p.sq_off.array);
+	Uring.cq_head = (unsigned int *)(cq + p.cq_off.head);
+	Uring.cq_tail = (unsigned int *)(cq + p.cq_off.tail);
+	Uring.cq_mask = (unsigned int *)(cq + p.cq_off.ring_mask);
+	Uring.cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	return 0;
+}
+#endif /* URING_RW */
+
+struct status *sy_uringread(struct io_req *req, struct syscall_info *sysc,
+			    int fd, char *addr)
+{
+	return sy_urw(req, sysc, fd, addr, 0);
+}
+
+struct status *sy_uringwrite(struct io_req *req, struct syscall_info *sysc,
+			     int fd, char *addr)
+{
+	return sy_urw(req, sysc, fd, addr, 1);
+}
+
+struct status *sy_urw(struct io_req *req, struct syscall_info *sysc, int fd,
+		      char *addr, int rw)
+{
+	int offset, nbytes, nents, uflags;
+	int i, rc, total;
+	struct status *status;
+
+	offset = req->r_data.io.r_offset;
+	nbytes = req->r_data.io.r_nbytes;
+	nents = req->r_data.io.r_nent;
+	uflags = req->r_data.io.r_uflags;
+
+	status = malloc(sizeof(struct status));
+	if (status == NULL) {
+		doio_fprintf(stderr, "malloc failed, %s/%d\n",
+			     __FILE__, __LINE__);
+		return NULL;
+	}
+	status->aioid = NULL;
+
+#ifdef URING_RW
+	if (Uring.fd == -1 && !Uring_broken && uring_init() == -1)
+		Uring_broken = 1;
+
+	if (!Uring_broken) {
+		struct io_uring_sqe *sqe;
+		struct iovec *iov;
+		unsigned int tail, head;
+		int fixed, res, err;
+
+		iov = malloc(nents * sizeof(struct iovec));
+		if (iov == NULL) {
+			doio_fprintf(stderr, "malloc failed, %s/%d\n",
+				     __FILE__, __LINE__);
+			return NULL;
+		}
+
+		/*
+		 * Register the whole transfer buffer; if registration
+		 * fails (resource limits), just do a plain batch.
+		 */
+		fixed = uflags & F_URING_FIXEDBUF;
+		if (fixed) {
+			iov[0].iov_base = addr;
+			iov[0].iov_len = (size_t)nbytes * nents;
+			if (syscall(__NR_io_uring_register, Uring.fd,
+				    IORING_REGISTER_BUFFERS, iov, 1) < 0)
+				fixed = 0;
+		}
+
+		for (i = 0; i < nents; i++) {
+			tail = *Uring.sq_tail;
+			sqe = &Uring.sqes[tail & *Uring.sq_mask];
+			memset(sqe, 0, sizeof(*sqe));
+
+			if (fixed) {
+				sqe->opcode = rw ? IORING_OP_WRITE_FIXED
+						 : IORING_OP_READ_FIXED;
+				sqe->addr = (unsigned long)(addr + i * nbytes);
+				sqe->len = nbytes;
+				sqe->buf_index = 0;
+			} else {
+				iov[i].iov_base = addr + i * nbytes;
+				iov[i].iov_len = nbytes;
+				sqe->opcode = rw ? IORING_OP_WRITEV
+						 : IORING_OP_READV;
+				sqe->addr = (unsigned long)&iov[i];
+				sqe->len = 1;
+			}
+			sqe->fd = fd;
+			sqe->off = offset + i * nbytes;
+			sqe->user_data = i;
+			if ((uflags & F_URING_LINKED) && i < nents - 1)
+				sqe->flags |= IOSQE_IO_LINK;
+
+			Uring.sq_array[tail & *Uring.sq_mask] =
+			    tail & *Uring.sq_mask;
+			__sync_synchronize();
+			*Uring.sq_tail = tail + 1;
+		}
+
+		rc = syscall(__NR_io_uring_enter, Uring.fd, nents, nents,
+			     IORING_ENTER_GETEVENTS, NULL, 0);
+		if (rc != nents) {
+			doio_fprintf(stderr,
+				     "io_uring_enter() submitted %d of %d sqes:  %s (%d)\n",
+				     rc, nents, SYSERR, errno);
+			Uring_broken = 1;	/* ring state now suspect */
+			status->rval = -1;
+			status->err = errno;
+			goto uring_out;
+		}
+
+		total = 0;
+		err = 0;
+		for (i = 0; i < nents; i++) {
+			head = *Uring.cq_head;
+			__sync_synchronize();
+			res = Uring.cqes[head & *Uring.cq_mask].res;
+			__sync_synchronize();
+			*Uring.cq_head = head + 1;
+
+			if (res < 0)
+				err = -res;
+			else
+				total += res;
+		}
+
+		if (err) {
+			errno = err;
+			status->rval = -1;
+			status->err = err;
+		} else {
+			status->rval = total;
+			status->err = 0;
+		}
+
+uring_out:
+		if (fixed)
+			syscall(__NR_io_uring_register, Uring.fd,
+				IORING_UNREGISTER_BUFFERS, NULL, 0);
+		free(iov);
+		return (status);
+	}
+#endif /* URING_RW */
+
+	/*
+	 * No io_uring - do the batch with pread/pwrite so the request
+	 * still runs.
+	 */
+	total = 0;
+	for (i = 0; i < nents; i++) {
+		if (rw)
+			rc = pwrite(fd, addr + i * nbytes, nbytes,
+				    offset + i * nbytes);
+		else
+			rc = pread(fd, addr + i * nbytes, nbytes,
+				   offset + i * nbytes);
+		if (rc == -1) {
+			status->rval = -1;
+			status->err = errno;
+			return (status);
+		}
+		total += rc;
+	}
+
+	status->rval = total;
+	status->err = 0;
+	return (status);
+}
+
+/*
+ * Calculate the size of an io_uring batch - r_nent contiguous chunks of
+ * r_nbytes each.
+ */
+int uring_mem(struct io_req *req, int offset, int fmstride, int *min, int *max)
+{
+	return stride_bounds(offset, fmstride, req->r_data.io.r_nent,
+			     req->r_data.io.r_nbytes, min, max);
+}
+
+char *fmt_urw(struct io_req *req, struct syscall_info *sy, int fd, char *addr)
+{
+	static char errbuf[32768];
+	char *cp;
+
+	cp = errbuf;
+	cp += sprintf(cp, "syscall:  %s(%d, ...) - %d sqes of %d bytes%s%s\n",
+		      sy->sy_name, fd,
+		      req->r_data.io.r_nent, req->r_data.io.r_nbytes,
+		      (req->r_data.io.r_uflags & F_URING_LINKED)
+		      ? ", linked" : "",
+		      (req->r_data.io.r_uflags & F_URING_FIXEDBUF)
+		      ? ", registered buffer" : "");
+	cp += sprintf(cp, "          data buffer at 0x%lx\n",
+		      (unsigned long)addr);
+
+	return (errbuf);
+}
 #endif /* !CRAY */
 
 struct syscall_info syscalls[] = {
@@ -3045,6 +3330,12 @@ struct syscall_info syscalls[] = {
 	{"mmap-write", MMAPW,
 	 sy_mmwrite, NULL, fmt_mmrw,
 	 SY_WRITE},
+	{"uring-read", URINGREAD,
+	 sy_uringread, uring_mem, fmt_urw,
+	 0},
+	{"uring-write", URINGWRITE,
+	 sy_uringwrite, uring_mem, fmt_urw,
+	 SY_WRITE},
 #endif
 
 	{NULL, 0,
@@ -73,6 +73,10 @@
 #define	FDATASYNC 126		/* fdatasync(2) */
 #define	BIOSIZE	127		/* fcntl(F_SETBIOSIZE) */
 
+/* Linux io_uring - r_nent read/write sqes submitted and reaped as a batch */
+#define	URINGREAD 130
+#define	URINGWRITE 131
+
 #ifdef CRAY
 /* used: <<doio>> 1.? <<DOIO>> 1.5 <-DOIO-> 1.7*/
 #define DOIO_MAGIC  '<[DOIO]>'
@@ -86,6 +90,8 @@
  */
 
 #define F_WORD_ALIGNED		0001	/* force request to be word aligned */
+#define F_URING_LINKED		0002	/* io_uring: chain sqes with IOSQE_IO_LINK */
+#define F_URING_FIXEDBUF	0004	/* io_uring: use a registered buffer */
 
 /*
  * define various doio exit status's
@@ -115,6 +115,7 @@ struct strmap {
 
 void startup_info(FILE * stream, int seed);
 int init_output(void);
+void write_requests(int fd, struct io_req *reqs, int nreqs);
 int form_iorequest(struct io_req *req);
 int get_file_info(struct file_info *rec);
 int create_file(char *path, int nbytes);
@@ -129,9 +130,10 @@ int usage(FILE * stream);
  * Declare cmdline option flags/variables initialized in parse_cmdline()
  */
 
-#define OPTS	"a:dhf:i:L:m:op:qr:s:t:T:O:N:"
+#define OPTS	"a:b:dhf:i:L:m:op:qr:s:t:T:O:N:"
 
 int a_opt = 0;			/* async io comp. types supplied            */
+int b_opt = 0;			/* batch requests into fewer pipe writes    */
 int o_opt = 0;			/* form overlapping requests                */
 int f_opt = 0;			/* test flags                               */
 int i_opt = 0;			/* iterations - 0 implies infinite          */
@@ -148,6 +150,7 @@ int T_opt = 0;			/* max transfer size (bytes)                */
 int q_opt = 0;			/* quiet operation on startup               */
 char TagName[40];		/* name of this iogen (see Monster)         */
 struct strmap *Offset_Mode;	/* M_SEQUENTIAL, M_RANDOM, etc.             */
+int Batchsize = 1;		/* # requests buffered per output write     */
 int Iterations;			/* # requests to generate (0 --> infinite)  */
 int Time_Mode = 0;		/* non-zero if Iterations is in seconds     */
 				/* (ie. -i arg was suffixed with 's')       */
@@ -308,6 +311,11 @@ struct strmap Syscall_Map[] = {
 	{"mmwrite", MMAPW, SY_WRITE},
 	{"fsync2", FSYNC2, SY_WRITE},
 	{"fdatasync", FDATASYNC, SY_WRITE},
+#ifdef __linux__
+	/* io_uring sqe batch - # of entries is the queue depth */
+	{"uread", URINGREAD, SY_NENT},
+	{"uwrite", URINGWRITE, SY_WRITE | SY_NENT},
+#endif
 #endif
 
 	{NULL, -1}
@@ -381,7 +389,8 @@ int main(int argc, char **argv)
 {
 	int rseed, outfd, infinite;
 	time_t start_time;
-	struct io_req req;
+	struct io_req *reqs, *req;
+	int nqueued = 0;
 
 	umask(0);
 
@@ -394,6 +403,13 @@ int main(int argc, char **argv)
 	TagName[0] = '\0';
 	parse_cmdline(argc, argv, OPTS);
 
+	if ((reqs = malloc(Batchsize * sizeof(struct io_req))) == NULL) {
+		fprintf(stderr,
+			"iogen%s:  Could not malloc space for %d requests\n",
+			TagName, Batchsize);
+		exit(2);
+	}
+
 	/*
 	 * Initialize output descriptor.
 	 */
@@ -428,22 +444,61 @@ int main(int argc, char **argv)
 	       (!Time_Mode && Iterations--) ||
 	       (Time_Mode && (ts.tv_sec - start_time <= Iterations))) {
 		gettimeofday(&ts, NULL);
-		memset(&req, 0, sizeof(struct io_req));
-		if (form_iorequest(&req) == -1) {
+		req = &reqs[nqueued];
+		memset(req, 0, sizeof(struct io_req));
+		if (form_iorequest(req) == -1) {
 			fprintf(stderr, "iogen%s:  form_iorequest() failed\n",
 				TagName);
 			continue;
 		}
 
-		req.r_magic = DOIO_MAGIC;
-		if (write(outfd, (char *)&req, sizeof(req)) == -1)
-			perror("Warning: Could not write");
+		req->r_magic = DOIO_MAGIC;
+		if (++nqueued == Batchsize) {
+			write_requests(outfd, reqs, nqueued);
+			nqueued = 0;
+		}
 	}
 
+	if (nqueued)
+		write_requests(outfd, reqs, nqueued);
+
 	exit(0);
 
 }				/* main */
 
+/*
+ * Write nreqs io requests to the output descriptor with as few write()
+ * calls as possible.  Each write is capped at the largest whole number
+ * of requests that fits into PIPE_BUF, so that it stays atomic and the
+ * doio children sharing the pipe always read complete io_req
+ * structures, even when several requests go out in one call.
+ */
+void write_requests(int fd, struct io_req *reqs, int nreqs)
+{
+	char *cp = (char *)reqs;
+	int nbytes, nw, max_write;
+
+	max_write = PIPE_BUF / sizeof(struct io_req) * sizeof(struct io_req);
+	if (max_write == 0)
+		max_write = sizeof(struct io_req);
+
+	nbytes = nreqs * sizeof(struct io_req);
+
+	while (nbytes > 0) {
+		nw = (nbytes < max_write) ? nbytes : max_write;
+
+		if ((nw = write(fd, cp, nw)) == -1) {
+			if (errno == EINTR)
+				continue;
+			perror("Warning: Could not write");
+			return;
+		}
+
+		cp += nw;
+		nbytes -= nw;
+	}
+}
+
 void startup_info(FILE * stream, int seed)
 {
 	char *value_to_string(), *type;
@@ -468,6 +523,10 @@ void startup_info(FILE * stream, int seed)
 
 	fprintf(stream, "Seed:                  %d\n", seed);
 
+	if (b_opt)
+		fprintf(stream, "Request batching:      %d requests per write\n",
+			Batchsize);
+
 	fprintf(stream, "Offset-Mode:           %s\n", Offset_Mode->m_string);
 
 	fprintf(stream, "Overlap Flag:          %s\n", o_opt ? "on" : "off");
@@ -848,6 +907,9 @@ int form_iorequest(struct io_req *req)
 	case LSWRITEA:
 	case LEWRITE:
 	case LEWRITEA:
+
+	case URINGREAD:
+	case URINGWRITE:
 		/* multi-strided */
 		strcpy(req->r_data.io.r_file, fptr->f_path);
 		req->r_data.io.r_oflags =
@@ -904,6 +966,17 @@ int form_iorequest(struct io_req *req)
 			req->r_data.io.r_nstrides = nstrides;
 			req->r_data.io.r_nent = 1;
 		}
+
+		/*
+		 * 1 in 4 io_uring batches chain their sqes, and 1 in 4
+		 * use a registered buffer.
+		 */
+		if (sc->m_value == URINGREAD || sc->m_value == URINGWRITE) {
+			if (random_range(0, 3, 1, NULL) == 0)
+				req->r_data.io.r_uflags |= F_URING_LINKED;
+			if (random_range(0, 3, 1, NULL) == 0)
+				req->r_data.io.r_uflags |= F_URING_FIXEDBUF;
+		}
 		break;
 
 	case LISTIO:
@@ -1385,9 +1458,9 @@ int parse_cmdline(int argc, char **argv, char *opts)
 	char *openargs[5];	/* Flags, cbits, cblks */
 	char *errmsg;
 	int str_to_int();
+	char *ranges;
 	opterr = 0;
 #ifndef linux
-	char *ranges;
 	struct strmap *type;
 #endif
 
@@ -1418,6 +1491,18 @@ int parse_cmdline(int argc, char **argv, char *opts)
 #endif
 			break;
 
+		case 'b':
+			if (sscanf(optarg, "%i%c", &Batchsize, &ch) != 1 ||
+			    Batchsize < 1 || Batchsize > 4096) {
+				fprintf(stderr,
+					"iogen%s:  Illegal -b arg (%s):  Must be an integer from 1 to 4096\n",
+					TagName, optarg);
+				exit(1);
+			}
+
+			b_opt++;
+			break;
+
 		case 'f':
 			cp = strtok(optarg, ",");
 			while (cp != NULL) {
@@ -1484,12 +1569,11 @@ int parse_cmdline(int argc, char **argv, char *opts)
 			break;
 
 		case 'L':
-#ifdef linux
-			fprintf(stderr,
-				"iogen%s:  Unrecognized option -L on this platform\n",
-				TagName);
-			exit(2);
-#else
+			/*
+			 * On Linux the stride count doubles as the
+			 * io_uring queue depth, so -L sets the sweep
+			 * range for uread/uwrite batches.
+			 */
 			if (parse_ranges(optarg, 1, 255, 1, NULL, &ranges,
 					 &errmsg) == -1) {
 				fprintf(stderr,
@@ -1503,7 +1587,6 @@ int parse_cmdline(int argc, char **argv, char *opts)
 
 			free(ranges);
 			L_opt++;
-#endif
 			break;
 
 		case 'm':
@@ -1955,6 +2038,10 @@ int help(FILE * stream)
 #else /* !linux */
 	fprintf(stream, "\t-a               (Not used on Linux).\n");
 #endif /* !linux */
+	fprintf(stream,
+		"\t-b batchsize     # of requests to buffer before writing them to\n");
+	fprintf(stream,
+		"\t                 the output pipe in a single call.  Default is 1.\n");
 	fprintf(stream,
 		"\t-f flag,...      Flags to use for file IO.  Supported flags are\n");
 #ifdef CRAY
@@ -2093,7 +2180,7 @@ int help(FILE * stream)
 int usage(FILE * stream)
 {
 	fprintf(stream,
-		"usage%s:  iogen [-hoq] [-a aio_type,...] [-f flag[,flag...]] [-i iterations] [-p outpipe] [-m offset-mode] [-s syscall[,syscall...]] [-t mintrans] [-T maxtrans] [ -O file-create-flags ] [[len:]file ...]\n",
+		"usage%s:  iogen [-hoq] [-a aio_type,...] [-b batchsize] [-f flag[,flag...]] [-i iterations] [-p outpipe] [-m offset-mode] [-s syscall[,syscall...]] [-t mintrans] [-T maxtrans] [ -O file-create-flags ] [[len:]file ...]\n",
 		TagName);
 	return 0;
 }
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Filesystem small-file benchmark.
+ *
+ * Reimplementation of the old fs-bench workload on top of the test
+ * library timers. The benchmark spreads files with gaussian-distributed
+ * sizes over a set of subdirectories and runs through four phases:
+ *
+ *  - create all files
+ *  - read randomly picked files back
+ *  - randomly delete or recreate files
+ *  - unlink whatever is left
+ *
+ * Each operation is timed with CLOCK_MONOTONIC and accumulated into a
+ * high-dynamic-range histogram, and each phase reports its throughput
+ * in operations and bytes per second along with latency percentiles.
+ * With -o the per-phase numbers are also appended to a file as one
+ * key=value record per phase, in the same spirit as the structured
+ * result log written by ltp-pan, so that successive runs can be
+ * compared by simple scripts.
+ *
+ * The benchmark always passes unless an operation fails, the value is
+ * in the reported numbers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+#define NSUBDIRS 64
+#define MAX_FSIZE (192 * 1024)
+
+int box_muler(int min, int max);
+
+static char *str_nfiles;
+static char *str_hist_bits;
+static char *result_file_name;
+static int nfiles = 4096;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static int *fsizes;
+static char *iobuf;
+static struct tst_hist hist;
+
+static void fname(char *buf, int idx)
+{
+	sprintf(buf, "%02x/f%06x", idx % NSUBDIRS, idx);
+}
+
+static long long create_file(int idx)
+{
+	char path[PATH_MAX];
+	int fd, size = box_muler(0, MAX_FSIZE);
+
+	if (size < 0)
+		size = MAX_FSIZE / 2;
+
+	fname(path, idx);
+
+	fd = SAFE_OPEN(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (size)
+		SAFE_WRITE(1, fd, iobuf, size);
+	SAFE_CLOSE(fd);
+
+	fsizes[idx] = size;
+
+	return size;
+}
+
+static long long read_file(int idx LTP_ATTRIBUTE_UNUSED)
+{
+	char path[PATH_MAX];
+	long long bytes = 0;
+	int fd, ret;
+
+	fname(path, random() % nfiles);
+
+	fd = SAFE_OPEN(path, O_RDONLY);
+	while ((ret = SAFE_READ(0, fd, iobuf, MAX_FSIZE)) > 0)
+		bytes += ret;
+	SAFE_CLOSE(fd);
+
+	return bytes;
+}
+
+static long long delcreate_file(int idx LTP_ATTRIBUTE_UNUSED)
+{
+	char path[PATH_MAX];
+
+	idx = random() % nfiles;
+
+	if (fsizes[idx] < 0)
+		return create_file(idx);
+
+	fname(path, idx);
+	SAFE_UNLINK(path);
+	fsizes[idx] = -1;
+
+	return 0;
+}
+
+static long long unlink_file(int idx)
+{
+	char path[PATH_MAX];
+
+	if (fsizes[idx] < 0)
+		return -1;
+
+	fname(path, idx);
+	SAFE_UNLINK(path);
+	fsizes[idx] = -1;
+
+	return 0;
+}
+
+/*
+ * One "key=value ..." record per phase, using the key style of the
+ * ltp-pan structured result log, so that runs on different kernels or
+ * filesystems can be collected and diffed with simple scripts.
+ */
+static void write_result(const char *phase, unsigned int ops,
+			 long long bytes, long long duration)
+{
+	FILE *f;
+
+	if (!result_file_name)
+		return;
+
+	f = fopen(result_file_name, "a");
+
+	if (!f) {
+		tst_res(TWARN | TERRNO,
+			"Failed to open '%s'", result_file_name);
+		return;
+	}
+
+	fprintf(f, "tag=fs_bench.%s ops=%u bytes=%lli duration=%lli "
+		"p50=%lli p90=%lli p99=%lli p99.9=%lli\n",
+		phase, ops, bytes, duration,
+		tst_hist_percentile(&hist, 50), tst_hist_percentile(&hist, 90),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
+	if (fclose(f)) {
+		tst_res(TWARN | TERRNO,
+			"Failed to close '%s'", result_file_name);
+	}
+}
+
+/*
+ * Runs the per-file operation nfiles times, timing each call. Negative
+ * return values mean the operation was skipped, otherwise they count
+ * the bytes transferred.
+ */
+static void run_phase(const char *name, long long (*op)(int idx))
+{
+	struct timespec start, end;
+	long long elapsed, bytes = 0, ret;
+	unsigned int ops = 0;
+	double secs;
+	int i;
+
+	tst_hist_reset(&hist);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < nfiles; i++) {
+		tst_timer_start(CLOCK_MONOTONIC);
+		ret = op(i);
+		tst_timer_stop();
+
+		if (ret < 0)
+			continue;
+
+		ops++;
+		bytes += ret;
+		tst_hist_add(&hist, tst_timer_elapsed_us());
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &end);
+	elapsed = tst_timespec_diff_us(end, start);
+	secs = 1.00 * elapsed / 1000000;
+
+	tst_res(TINFO, "%s: %u ops in %.2fs, %.0f ops/s, %.2f MB/s",
+		name, ops, secs, ops / secs,
+		1.00 * bytes / secs / (1024 * 1024));
+	tst_res(TINFO, "%s: p50 %llius, p90 %llius, p99 %llius, p99.9 %llius",
+		name,
+		tst_hist_percentile(&hist, 50), tst_hist_percentile(&hist, 90),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
+	write_result(name, ops, bytes, elapsed);
+}
+
+static void run(void)
+{
+	run_phase("create", create_file);
+	run_phase("read", read_file);
+	run_phase("delcreate", delcreate_file);
+	run_phase("unlink", unlink_file);
+
+	tst_res(TPASS, "Benchmark completed");
+}
+
+static void setup(void)
+{
+	char path[PATH_MAX];
+	int i;
+
+	if (str_nfiles && tst_parse_int(str_nfiles, &nfiles, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid number of files '%s'", str_nfiles);
+
+	if (str_hist_bits && tst_parse_int(str_hist_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid histogram bits '%s'", str_hist_bits);
+
+	tst_hist_init(&hist, hist_bits);
+
+	iobuf = SAFE_MALLOC(MAX_FSIZE);
+	memset(iobuf, 'b', MAX_FSIZE);
+
+	fsizes = SAFE_MALLOC(nfiles * sizeof(fsizes[0]));
+
+	for (i = 0; i < nfiles; i++)
+		fsizes[i] = -1;
+
+	for (i = 0; i < NSUBDIRS; i++) {
+		sprintf(path, "%02x", i);
+		SAFE_MKDIR(path, 0755);
+	}
+}
+
+static void cleanup(void)
+{
+	free(iobuf);
+	free(fsizes);
+	tst_hist_free(&hist);
+}
+
+static struct tst_option options[] = {
+	{"n:", &str_nfiles, "-n files Number of files to spread the operations over (default 4096)"},
+	{"b:", &str_hist_bits, "-b bits  Histogram sub-bucket bits, sets resolution to 2^-bits (default 7)"},
+	{"o:", &result_file_name, "-o fname Append machine-readable per-phase results to a file"},
+	{NULL, NULL, NULL}
+};
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.options = options,
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
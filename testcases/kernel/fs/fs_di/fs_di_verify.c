@@ -0,0 +1,195 @@
+/*
+ *   Copyright (c) 2021 Linux Test Project
+ *
+ *   This program is free software;  you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY;  without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ *   the GNU General Public License for more details.
+ */
+
+/*
+ *  FILE        : fs_di_verify.c
+ *  PURPOSE     : Verifies that files carry the create_datafile pattern,
+ *                replacing the cmp calls in the fs_di script. The files
+ *                are sharded across forked workers and checked with the
+ *                (hardware accelerated) CRC32c from the LTP library
+ *                instead of byte comparison, with the next read window
+ *                prefetched while the current one is checksummed, so
+ *                verification runs at storage bandwidth.
+ *
+ *                usage: fs_di_verify [-j workers] <# of Mb> file...
+ *
+ *                Exits 0 when every file matches the pattern, 1 on any
+ *                mismatch or read error.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tst_checksum.h"
+
+/* must match BSIZE in create_datafile.c */
+#define BSIZE 1048576L
+
+#define MAX_WORKERS 8
+
+static uint32_t want_crc;
+static off_t want_size;
+
+static int verify_file(const char *path, char *buf)
+{
+	off_t off = 0;
+	ssize_t n;
+	struct stat st;
+	uint32_t crc = TST_CRC32C_INIT;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		fprintf(stderr, "fs_di_verify: open(%s): %s\n",
+			path, strerror(errno));
+		return 1;
+	}
+
+	if (fstat(fd, &st) == -1) {
+		fprintf(stderr, "fs_di_verify: fstat(%s): %s\n",
+			path, strerror(errno));
+		close(fd);
+		return 1;
+	}
+
+	if (st.st_size != want_size) {
+		fprintf(stderr, "fs_di_verify: %s is %lld bytes, expected %lld\n",
+			path, (long long)st.st_size, (long long)want_size);
+		close(fd);
+		return 1;
+	}
+
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	while ((n = read(fd, buf, BSIZE)) > 0) {
+		/* overlap the next window's I/O with this one's checksum */
+		posix_fadvise(fd, off + n, BSIZE, POSIX_FADV_WILLNEED);
+		crc = tst_crc32c_update(crc, (uint8_t *)buf, n);
+		off += n;
+	}
+
+	if (n == -1) {
+		fprintf(stderr, "fs_di_verify: read(%s): %s\n",
+			path, strerror(errno));
+		close(fd);
+		return 1;
+	}
+
+	close(fd);
+
+	if (tst_crc32c_final(crc) != want_crc) {
+		fprintf(stderr, "fs_di_verify: %s does not match the pattern\n",
+			path);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	char *buf;
+	long i, mb, nfiles, nworkers = 0;
+	long w, failed = 0;
+	uint32_t crc;
+	int opt, status;
+	pid_t pid;
+
+	while ((opt = getopt(argc, argv, "j:")) != -1) {
+		switch (opt) {
+		case 'j':
+			nworkers = atol(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+
+	if (argc - optind < 2)
+		goto usage;
+
+	mb = atol(argv[optind]);
+	if (mb < 1)
+		goto usage;
+	optind++;
+
+	nfiles = argc - optind;
+
+	if (nworkers < 1) {
+		nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+		if (nworkers < 1)
+			nworkers = 1;
+	}
+	if (nworkers > nfiles)
+		nworkers = nfiles;
+	if (nworkers > MAX_WORKERS)
+		nworkers = MAX_WORKERS;
+
+	buf = malloc(BSIZE);
+	if (!buf) {
+		fprintf(stderr, "fs_di_verify: out of memory\n");
+		return 2;
+	}
+
+	/* the pattern buffer create_datafile writes, repeated mb times */
+	buf[0] = 'A';
+	for (i = 1; i < BSIZE; i++)
+		buf[i] = buf[i - 1] + 1;
+	buf[BSIZE - 1] = 'Z';
+
+	crc = TST_CRC32C_INIT;
+	for (i = 0; i < mb; i++)
+		crc = tst_crc32c_update(crc, (uint8_t *)buf, BSIZE);
+	want_crc = tst_crc32c_final(crc);
+	want_size = (off_t)mb * BSIZE;
+
+	for (w = 0; w < nworkers; w++) {
+		pid = fork();
+		if (pid == -1) {
+			fprintf(stderr, "fs_di_verify: fork: %s\n",
+				strerror(errno));
+			return 2;
+		}
+
+		if (!pid) {
+			int ret = 0;
+
+			for (i = w; i < nfiles; i += nworkers)
+				ret |= verify_file(argv[optind + i], buf);
+			exit(ret);
+		}
+	}
+
+	for (w = 0; w < nworkers; w++) {
+		if (wait(&status) == -1)
+			return 2;
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			failed = 1;
+	}
+
+	free(buf);
+	return failed;
+
+usage:
+	fprintf(stderr,
+		"usage:\n\tfs_di_verify [-j workers] <# of Mb> <file>...\n");
+	return 2;
+}
@@ -37,6 +37,21 @@
 # include <sys/prctl.h>
 #endif
 #include <limits.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+# include <sys/syscall.h>
+# include <sys/uio.h>
+#endif
+
+/*
+ * the lapi io_uring wrappers are tied to the tst_test harness, so this
+ * standalone program drives the raw syscalls itself
+ */
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+# define URING_OPS 1
+#endif
 
 #define XFS_ERRTAG_MAX		17
 
@@ -75,6 +90,11 @@ typedef enum {
 	OP_UNLINK,
 #ifndef NO_XFS
 	OP_UNRESVSP,
+#endif
+#ifdef URING_OPS
+	OP_URING_FSYNC,
+	OP_URING_READ,
+	OP_URING_WRITE,
 #endif
 	OP_WRITE,
 	OP_LAST
@@ -125,10 +145,22 @@ typedef struct pathname {
 
 #define	FLIST_SLOT_INCR	16
 #define	NDCACHE	64
+#define	SHMODE_BATCH	8
 
 #define	MAXFSIZE	((1ULL << 63) - 1ULL)
 #define	MAXFSIZE32	((1ULL << 40) - 1ULL)
 
+/*
+ * State shared by all workers in -M mode, mapped MAP_SHARED before
+ * forking so the file table and its locks are visible to everyone.
+ * The fent arrays follow the struct in the same mapping.
+ */
+typedef struct shdata {
+	pthread_rwlock_t locks[FT_nft];
+	int nameseq;
+	flist_t flist[FT_nft];
+} shdata_t;
+
 void allocsp_f(int, long);
 void attr_remove_f(int, long);
 void attr_set_f(int, long);
@@ -156,6 +188,9 @@ void sync_f(int, long);
 void truncate_f(int, long);
 void unlink_f(int, long);
 void unresvsp_f(int, long);
+void uring_fsync_f(int, long);
+void uring_read_f(int, long);
+void uring_write_f(int, long);
 void write_f(int, long);
 
 opdesc_t ops[] = {
@@ -193,11 +228,16 @@ opdesc_t ops[] = {
 	{OP_UNLINK, "unlink", unlink_f, 1, 1, 0},
 #ifndef NO_XFS
 	{OP_UNRESVSP, "unresvsp", unresvsp_f, 1, 1, 1},
+#endif
+#ifdef URING_OPS
+	{OP_URING_FSYNC, "uring_fsync", uring_fsync_f, 1, 1, 0},
+	{OP_URING_READ, "uring_read", uring_read_f, 1, 0, 0},
+	{OP_URING_WRITE, "uring_write", uring_write_f, 2, 1, 0},
 #endif
 	{OP_WRITE, "write", write_f, 4, 1, 0},
 }, *ops_end;
 
-flist_t flist[FT_nft] = {
+flist_t flist_init[FT_nft] = {
 	{0, 0, 'd', NULL},
 	{0, 0, 'f', NULL},
 	{0, 0, 'l', NULL},
@@ -205,6 +245,9 @@ flist_t flist[FT_nft] = {
 	{0, 0, 'r', NULL},
 };
 
+/* points into the shared mapping in -M mode */
+flist_t *flist = flist_init;
+
 int dcache[NDCACHE];
 int errrange;
 int errtag;
@@ -226,6 +269,8 @@ int operations = 1;
 int procid;
 int rtpct;
 unsigned long seed = 0;
+int shared_mode;
+shdata_t *shdata;
 ino_t top_ino;
 int verbose = 0;
 #ifndef NO_XFS
@@ -253,6 +298,8 @@ int dirid_to_name(char *, int);
 void doproc(void);
 void fent_to_name(pathname_t *, flist_t *, fent_t *);
 void fix_parent(int, int);
+void flist_lock(int);
+void flist_unlock(void);
 void free_pathname(pathname_t *);
 int generate_fname(fent_t *, int, pathname_t *, int *, int *);
 int get_fname(int, long, pathname_t *, flist_t **, fent_t **, int *);
@@ -264,6 +311,7 @@ void make_freq_table(void);
 int mkdir_path(pathname_t *, mode_t);
 int mknod_path(pathname_t *, mode_t, dev_t);
 void namerandpad(int, char *, int);
+int new_nameseq(void);
 int open_path(pathname_t *, int);
 DIR *opendir_path(pathname_t *);
 void process_freq(char *);
@@ -271,6 +319,8 @@ int readlink_path(pathname_t *, char *, size_t);
 int rename_path(pathname_t *, pathname_t *);
 int rmdir_path(pathname_t *);
 void separate_pathname(pathname_t *, char *, pathname_t *);
+void shmode_init(void);
+int shmode_verify(void);
 void show_ops(int, char *);
 int stat64_path(pathname_t *, struct stat64 *);
 int symlink_path(const char *, pathname_t *);
@@ -295,6 +345,7 @@ int main(int argc, char **argv)
 	int cleanup = 0;
 	int loops = 1;
 	int loopcntr = 1;
+	int verify_errors = 0;
 	char cmd[256];
 #ifndef NO_XFS
 	int j;
@@ -316,7 +367,7 @@ int main(int argc, char **argv)
 	nops = ARRAY_SIZE(ops);
 	ops_end = &ops[nops];
 	myprog = argv[0];
-	while ((c = getopt(argc, argv, "cd:e:f:i:l:n:p:rs:vwzHSX")) != -1) {
+	while ((c = getopt(argc, argv, "cd:e:f:i:l:n:p:rs:vwzHMSX")) != -1) {
 		switch (c) {
 		case 'c':
 			/*Don't cleanup */
@@ -370,6 +421,9 @@ int main(int argc, char **argv)
 		case 'z':
 			zero_freq();
 			break;
+		case 'M':
+			shared_mode = 1;
+			break;
 		case 'S':
 			show_ops(0, NULL);
 			printf("\n");
@@ -480,9 +534,14 @@ int main(int argc, char **argv)
 		unlink(buf);
 
 
+		if (shared_mode && shdata == NULL)
+			shmode_init();
+
 		if (nproc == 1) {
 			procid = 0;
 			doproc();
+			if (shared_mode)
+				chdir("..");
 		} else {
 			setpgid(0, 0);
 			action.sa_handler = sg_handler;
@@ -539,19 +598,23 @@ int main(int argc, char **argv)
 			close(fd);
 		}
 #endif
+		if (shared_mode)
+			verify_errors += shmode_verify();
 		if (cleanup == 0) {
 			sprintf(cmd, "rm -rf %s/*", dirname);
 			system(cmd);
 			for (i = 0; i < FT_nft; i++) {
-				flist[i].nslots = 0;
 				flist[i].nfiles = 0;
+				if (shared_mode)
+					continue;
+				flist[i].nslots = 0;
 				free(flist[i].fents);
 				flist[i].fents = NULL;
 			}
 		}
 		loopcntr++;
 	}
-	return 0;
+	return verify_errors ? 1 : 0;
 }
 
 void add_to_flist(int ft, int id, int parent)
@@ -561,6 +624,12 @@ void add_to_flist(int ft, int id, int parent)
 
 	ftp = &flist[ft];
 	if (ftp->nfiles == ftp->nslots) {
+		/*
+		 * the shared table has a fixed capacity; drop tracking of
+		 * the new entry rather than move the fent arrays
+		 */
+		if (shared_mode)
+			return;
 		ftp->nslots += FLIST_SLOT_INCR;
 		ftp->fents = realloc(ftp->fents, ftp->nslots * sizeof(fent_t));
 	}
@@ -751,11 +820,16 @@ void doproc(void)
 {
 	struct stat64 statbuf;
 	char buf[10];
+	int batch;
+	opdesc_t *np;
 	int opno;
 	int rval;
 	opdesc_t *p;
 
-	sprintf(buf, "p%x", procid);
+	if (shared_mode)
+		strcpy(buf, "shared");
+	else
+		sprintf(buf, "p%x", procid);
 	(void)mkdir(buf, 0777);
 	if (chdir(buf) < 0 || stat64(".", &statbuf) < 0) {
 		perror(buf);
@@ -767,12 +841,28 @@ void doproc(void)
 	srandom(seed);
 	if (namerand)
 		namerand = random();
+	batch = 0;
+	p = &ops[freq_table[random() % freq_table_size]];
 	for (opno = 0; opno < operations; opno++) {
-		p = &ops[freq_table[random() % freq_table_size]];
 		if ((unsigned long)p->func < 4096)
 			abort();
 
+		if (shared_mode && batch == 0)
+			flist_lock(p->iswrite);
 		p->func(opno, random());
+		np = opno + 1 < operations ?
+		    &ops[freq_table[random() % freq_table_size]] : NULL;
+		/*
+		 * amortize the file table locks over short batches of
+		 * ops of the same read/write class
+		 */
+		if (shared_mode &&
+		    (++batch >= SHMODE_BATCH || np == NULL ||
+		     np->iswrite != p->iswrite)) {
+			flist_unlock();
+			batch = 0;
+		}
+		p = np;
 		/*
 		 * test for forced shutdown by stat'ing the test
 		 * directory.  If this stat returns EIO, assume
@@ -782,6 +872,8 @@ void doproc(void)
 			rval = stat64(".", &statbuf);
 			if (rval == EIO) {
 				fprintf(stderr, "Detected EIO\n");
+				if (shared_mode && batch)
+					flist_unlock();
 				return;
 			}
 		}
@@ -821,6 +913,30 @@ void fix_parent(int oldid, int newid)
 	}
 }
 
+void flist_lock(int iswrite)
+{
+	int i;
+
+	if (!shared_mode)
+		return;
+	for (i = 0; i < FT_nft; i++) {
+		if (iswrite)
+			pthread_rwlock_wrlock(&shdata->locks[i]);
+		else
+			pthread_rwlock_rdlock(&shdata->locks[i]);
+	}
+}
+
+void flist_unlock(void)
+{
+	int i;
+
+	if (!shared_mode)
+		return;
+	for (i = 0; i < FT_nft; i++)
+		pthread_rwlock_unlock(&shdata->locks[i]);
+}
+
 void free_pathname(pathname_t * name)
 {
 	if (name->path) {
@@ -839,7 +955,7 @@ int generate_fname(fent_t * fep, int ft, pathname_t * name, int *idp, int *v)
 	int len;
 
 	flp = &flist[ft];
-	len = sprintf(buf, "%c%x", flp->tag, id = nameseq++);
+	len = sprintf(buf, "%c%x", flp->tag, id = new_nameseq());
 	namerandpad(id, buf, len);
 	if (fep) {
 		fent_to_name(name, &flist[FT_DIR], fep);
@@ -1079,6 +1195,13 @@ void namerandpad(int id, char *buf, int i)
 	}
 }
 
+int new_nameseq(void)
+{
+	if (shared_mode)
+		return __sync_fetch_and_add(&shdata->nameseq, 1);
+	return nameseq++;
+}
+
 int open_path(pathname_t * name, int oflag)
 {
 	char buf[MAXNAMELEN];
@@ -1244,6 +1367,94 @@ void separate_pathname(pathname_t * name, char *buf, pathname_t * newname)
 	append_pathname(newname, slash + 1);
 }
 
+void shmode_init(void)
+{
+	pthread_rwlockattr_t attr;
+	int i;
+	char *mem;
+	size_t size;
+	int slots;
+
+	slots = nproc * operations + FLIST_SLOT_INCR;
+	size = sizeof(shdata_t) +
+	    (size_t)FT_nft * slots * sizeof(fent_t);
+	mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		perror("fsstress - mmap shared state");
+		exit(1);
+	}
+	shdata = (shdata_t *) mem;
+	memcpy(shdata->flist, flist, FT_nft * sizeof(flist_t));
+	mem += sizeof(shdata_t);
+	for (i = 0; i < FT_nft; i++) {
+		shdata->flist[i].nfiles = 0;
+		shdata->flist[i].nslots = slots;
+		shdata->flist[i].fents = (fent_t *) mem + (size_t)i * slots;
+	}
+	pthread_rwlockattr_init(&attr);
+	pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	for (i = 0; i < FT_nft; i++)
+		pthread_rwlock_init(&shdata->locks[i], &attr);
+	pthread_rwlockattr_destroy(&attr);
+	/*
+	 * the mapping is inherited at the same address across fork, so
+	 * the fent pointers stay valid in every worker
+	 */
+	flist = shdata->flist;
+}
+
+/*
+ * Walk the shared file table after all workers exited and check that
+ * every tracked entry exists on disk with the recorded type.  The table
+ * only records successful namespace ops, so any mismatch means two
+ * workers saw inconsistent state.
+ */
+int shmode_verify(void)
+{
+	static int ftypes[FT_nft] = {
+		S_IFDIR, S_IFREG, S_IFLNK, S_IFCHR, S_IFREG
+	};
+	int errors;
+	fent_t *fep;
+	flist_t *flp;
+	int i;
+	int j;
+	pathname_t name;
+	struct stat64 stb;
+	int total;
+
+	if (chdir("shared") < 0) {
+		perror("fsstress - chdir shared");
+		return 1;
+	}
+	errors = 0;
+	total = 0;
+	for (i = 0, flp = flist; i < FT_nft; i++, flp++) {
+		for (j = 0, fep = flp->fents; j < flp->nfiles; j++, fep++) {
+			init_pathname(&name);
+			fent_to_name(&name, flp, fep);
+			total++;
+			if (lstat64_path(&name, &stb) < 0) {
+				fprintf(stderr, "verify: %s missing (%s)\n",
+					name.path, strerror(errno));
+				errors++;
+			} else if ((stb.st_mode & S_IFMT) != ftypes[i]) {
+				fprintf(stderr,
+					"verify: %s has type %#o, expected %#o\n",
+					name.path,
+					(int)(stb.st_mode & S_IFMT),
+					ftypes[i]);
+				errors++;
+			}
+			free_pathname(&name);
+		}
+	}
+	chdir("..");
+	printf("shared mode: verified %d entries, %d errors\n", total, errors);
+	return errors;
+}
+
 #define WIDTH 80
 
 void show_ops(int flag, char *lead_str)
@@ -1365,7 +1576,7 @@ void usage(void)
 	printf
 	    ("       %s [-c][-d dir][-e errtg][-f op_name=freq][-l loops][-n nops]\n",
 	     myprog);
-	printf("          [-p nproc][-r len][-s seed][-v][-w][-z][-S]\n");
+	printf("          [-p nproc][-r len][-s seed][-v][-w][-z][-M][-S]\n");
 	printf("where\n");
 	printf
 	    ("   -c               specifies not to remove files(cleanup) after execution\n");
@@ -1384,6 +1595,10 @@ void usage(void)
 	printf
 	    ("   -p nproc         specifies the no. of processes (default 1)\n");
 	printf("   -r               specifies random name padding\n");
+	printf
+	    ("   -M               runs all processes against one shared directory with a\n");
+	printf
+	    ("                    shared file table and verifies it afterwards\n");
 	printf
 	    ("   -s seed          specifies the seed for the random generator (default random)\n");
 	printf("   -v               specifies verbose mode\n");
@@ -1551,7 +1766,7 @@ void attr_set_f(int opno, long r)
 	init_pathname(&f);
 	if (!get_fname(FT_ANYm, r, &f, NULL, NULL, &v))
 		append_pathname(&f, ".");
-	sprintf(aname, "a%x", nameseq++);
+	sprintf(aname, "a%x", new_nameseq());
 	li = (int)(random() % ARRAY_SIZE(lengths));
 	len = (int)(random() % lengths[li]);
 	if (len == 0)
@@ -2622,6 +2837,373 @@ void unresvsp_f(int opno, long r)
 }
 #endif
 
+#ifdef URING_OPS
+
+#define URING_ENTRIES	8
+#define URING_BATCH	4
+
+/* one submission/completion ring per worker, set up on first use */
+struct uring_ring {
+	int fd;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+};
+
+struct uring_ring uring = { .fd = -1 };
+int uring_failed;
+
+int uring_init(void)
+{
+	struct io_uring_params p;
+	char *cq;
+	char *sq;
+
+	if (uring.fd >= 0)
+		return 1;
+	if (uring_failed)
+		return 0;
+	memset(&p, 0, sizeof(p));
+	uring.fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+	if (uring.fd < 0) {
+		uring_failed = 1;
+		return 0;
+	}
+	sq = mmap(NULL, p.sq_off.array + p.sq_entries * sizeof(unsigned int),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  uring.fd, IORING_OFF_SQ_RING);
+	cq = mmap(NULL, p.cq_off.cqes +
+		  p.cq_entries * sizeof(struct io_uring_cqe),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  uring.fd, IORING_OFF_CQ_RING);
+	uring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+			  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			  uring.fd, IORING_OFF_SQES);
+	if (sq == MAP_FAILED || cq == MAP_FAILED ||
+	    uring.sqes == MAP_FAILED) {
+		close(uring.fd);
+		uring.fd = -1;
+		uring_failed = 1;
+		return 0;
+	}
+	uring.sq_head = (unsigned int *)(sq + p.sq_off.head);
+	uring.sq_tail = (unsigned int *)(sq + p.sq_off.tail);
+	uring.sq_mask = (unsigned int *)(sq + p.sq_off.ring_mask);
+	uring.sq_array = (unsigned int *)(sq + p.sq_off.array);
+	uring.cq_head = (unsigned int *)(cq + p.cq_off.head);
+	uring.cq_tail = (unsigned int *)(cq + p.cq_off.tail);
+	uring.cq_mask = (unsigned int *)(cq + p.cq_off.ring_mask);
+	uring.cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+	return 1;
+}
+
+struct io_uring_sqe *uring_get_sqe(void)
+{
+	struct io_uring_sqe *sqe;
+	unsigned int tail;
+
+	tail = *uring.sq_tail;
+	sqe = &uring.sqes[tail & *uring.sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	uring.sq_array[tail & *uring.sq_mask] = tail & *uring.sq_mask;
+	__sync_synchronize();
+	*uring.sq_tail = tail + 1;
+	return sqe;
+}
+
+int uring_submit(int nr)
+{
+	return syscall(__NR_io_uring_enter, uring.fd, nr, 0, 0, NULL, 0);
+}
+
+/*
+ * Reap want completions and check each one against the set of queued
+ * user_data tags: every queued request must complete exactly once.
+ * Returns the number of bad (unknown or duplicate) completions plus
+ * any requests left uncompleted on error.
+ */
+int uring_reap(unsigned int pending, int want)
+{
+	struct io_uring_cqe *cqe;
+	int errors;
+	unsigned int head;
+
+	errors = 0;
+	while (want > 0) {
+		head = *uring.cq_head;
+		if (head == *uring.cq_tail) {
+			if (syscall(__NR_io_uring_enter, uring.fd, 0, 1,
+				    IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+			    errno != EINTR)
+				return errors + want;
+			continue;
+		}
+		__sync_synchronize();
+		cqe = &uring.cqes[head & *uring.cq_mask];
+		if (cqe->user_data >= 8 * sizeof(pending) ||
+		    !(pending & (1U << cqe->user_data)))
+			errors++;
+		else
+			pending &= ~(1U << cqe->user_data);
+		__sync_synchronize();
+		*uring.cq_head = head + 1;
+		want--;
+	}
+	return errors;
+}
+
+void uring_fsync_f(int opno, long r)
+{
+	int e;
+	int errors;
+	pathname_t f;
+	int fd;
+	struct io_uring_sqe *sqe;
+	int v;
+
+	init_pathname(&f);
+	if (!get_fname(FT_REGFILE, r, &f, NULL, NULL, &v)) {
+		if (v)
+			printf("%d/%d: uring_fsync - no filename\n",
+			       procid, opno);
+		free_pathname(&f);
+		return;
+	}
+	if (!uring_init()) {
+		if (v)
+			printf("%d/%d: uring_fsync - no io_uring\n",
+			       procid, opno);
+		free_pathname(&f);
+		return;
+	}
+	fd = open_path(&f, O_WRONLY);
+	e = fd < 0 ? errno : 0;
+	check_cwd();
+	if (fd < 0) {
+		if (v)
+			printf("%d/%d: uring_fsync - open %s failed %d\n",
+			       procid, opno, f.path, e);
+		free_pathname(&f);
+		return;
+	}
+	sqe = uring_get_sqe();
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = fd;
+	if (r & 1)
+		sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+	sqe->user_data = 0;
+	e = uring_submit(1) < 0 ? errno : 0;
+	errors = e ? 1 : uring_reap(1, 1);
+	if (errors)
+		fprintf(stderr, "%d/%d: uring_fsync %s bad completions %d\n",
+			procid, opno, f.path, errors);
+	if (v)
+		printf("%d/%d: uring_fsync %s %d\n", procid, opno, f.path, e);
+	free_pathname(&f);
+	close(fd);
+}
+
+void uring_read_f(int opno, long r)
+{
+	char *bufs[URING_BATCH];
+	int e;
+	int errors;
+	pathname_t f;
+	int fd;
+	int i;
+	struct iovec iov[URING_BATCH];
+	size_t len;
+	int64_t lr;
+	off64_t off;
+	int registered;
+	struct io_uring_sqe *sqe;
+	struct stat64 stb;
+	int v;
+
+	init_pathname(&f);
+	if (!get_fname(FT_REGFILE, r, &f, NULL, NULL, &v)) {
+		if (v)
+			printf("%d/%d: uring_read - no filename\n",
+			       procid, opno);
+		free_pathname(&f);
+		return;
+	}
+	if (!uring_init()) {
+		if (v)
+			printf("%d/%d: uring_read - no io_uring\n",
+			       procid, opno);
+		free_pathname(&f);
+		return;
+	}
+	fd = open_path(&f, O_RDONLY);
+	e = fd < 0 ? errno : 0;
+	check_cwd();
+	if (fd < 0) {
+		if (v)
+			printf("%d/%d: uring_read - open %s failed %d\n",
+			       procid, opno, f.path, e);
+		free_pathname(&f);
+		return;
+	}
+	if (fstat64(fd, &stb) < 0) {
+		if (v)
+			printf("%d/%d: uring_read - fstat64 %s failed %d\n",
+			       procid, opno, f.path, errno);
+		free_pathname(&f);
+		close(fd);
+		return;
+	}
+	if (stb.st_size == 0) {
+		if (v)
+			printf("%d/%d: uring_read - %s zero size\n",
+			       procid, opno, f.path);
+		free_pathname(&f);
+		close(fd);
+		return;
+	}
+	registered = syscall(__NR_io_uring_register, uring.fd,
+			     IORING_REGISTER_FILES, &fd, 1) == 0;
+	for (i = 0; i < URING_BATCH; i++) {
+		lr = ((int64_t) random() << 32) + random();
+		off = (off64_t) (lr % stb.st_size);
+		len = (random() % getpagesize()) + 1;
+		bufs[i] = malloc(len);
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = len;
+		sqe = uring_get_sqe();
+		sqe->opcode = IORING_OP_READV;
+		sqe->fd = registered ? 0 : fd;
+		if (registered)
+			sqe->flags = IOSQE_FIXED_FILE;
+		sqe->addr = (unsigned long)&iov[i];
+		sqe->len = 1;
+		sqe->off = off;
+		sqe->user_data = i;
+	}
+	e = uring_submit(URING_BATCH) < 0 ? errno : 0;
+	errors = e ? URING_BATCH :
+	    uring_reap((1U << URING_BATCH) - 1, URING_BATCH);
+	if (registered)
+		syscall(__NR_io_uring_register, uring.fd,
+			IORING_UNREGISTER_FILES, NULL, 0);
+	for (i = 0; i < URING_BATCH; i++)
+		free(bufs[i]);
+	if (errors)
+		fprintf(stderr, "%d/%d: uring_read %s bad completions %d\n",
+			procid, opno, f.path, errors);
+	if (v)
+		printf("%d/%d: uring_read %s %d reads r:%d %d\n",
+		       procid, opno, f.path, URING_BATCH, registered, e);
+	free_pathname(&f);
+	close(fd);
+}
+
+void uring_write_f(int opno, long r)
+{
+	char *bufs[URING_BATCH];
+	int e;
+	int errors;
+	pathname_t f;
+	int fd;
+	int i;
+	struct iovec iov[URING_BATCH];
+	size_t len;
+	int64_t lr;
+	off64_t off;
+	int registered;
+	struct io_uring_sqe *sqe;
+	struct stat64 stb;
+	int v;
+
+	init_pathname(&f);
+	if (!get_fname(FT_REGm, r, &f, NULL, NULL, &v)) {
+		if (v)
+			printf("%d/%d: uring_write - no filename\n",
+			       procid, opno);
+		free_pathname(&f);
+		return;
+	}
+	if (!uring_init()) {
+		if (v)
+			printf("%d/%d: uring_write - no io_uring\n",
+			       procid, opno);
+		free_pathname(&f);
+		return;
+	}
+	fd = open_path(&f, O_WRONLY);
+	e = fd < 0 ? errno : 0;
+	check_cwd();
+	if (fd < 0) {
+		if (v)
+			printf("%d/%d: uring_write - open %s failed %d\n",
+			       procid, opno, f.path, e);
+		free_pathname(&f);
+		return;
+	}
+	if (fstat64(fd, &stb) < 0) {
+		if (v)
+			printf("%d/%d: uring_write - fstat64 %s failed %d\n",
+			       procid, opno, f.path, errno);
+		free_pathname(&f);
+		close(fd);
+		return;
+	}
+	registered = syscall(__NR_io_uring_register, uring.fd,
+			     IORING_REGISTER_FILES, &fd, 1) == 0;
+	for (i = 0; i < URING_BATCH; i++) {
+		lr = ((int64_t) random() << 32) + random();
+		off = (off64_t) (lr % MIN(stb.st_size + (1024 * 1024),
+					  MAXFSIZE));
+		off %= maxfsize;
+		len = (random() % getpagesize()) + 1;
+		bufs[i] = malloc(len);
+		memset(bufs[i], nameseq & 0xff, len);
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = len;
+		sqe = uring_get_sqe();
+		sqe->opcode = IORING_OP_WRITEV;
+		sqe->fd = registered ? 0 : fd;
+		if (registered)
+			sqe->flags = IOSQE_FIXED_FILE;
+		sqe->addr = (unsigned long)&iov[i];
+		sqe->len = 1;
+		sqe->off = off;
+		sqe->user_data = i;
+	}
+	/* chain an fsync behind the last queued write */
+	sqe->flags |= IOSQE_IO_LINK;
+	sqe = uring_get_sqe();
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = registered ? 0 : fd;
+	if (registered)
+		sqe->flags = IOSQE_FIXED_FILE;
+	sqe->user_data = URING_BATCH;
+	e = uring_submit(URING_BATCH + 1) < 0 ? errno : 0;
+	errors = e ? URING_BATCH + 1 :
+	    uring_reap((1U << (URING_BATCH + 1)) - 1, URING_BATCH + 1);
+	if (registered)
+		syscall(__NR_io_uring_register, uring.fd,
+			IORING_UNREGISTER_FILES, NULL, 0);
+	for (i = 0; i < URING_BATCH; i++)
+		free(bufs[i]);
+	if (errors)
+		fprintf(stderr, "%d/%d: uring_write %s bad completions %d\n",
+			procid, opno, f.path, errors);
+	if (v)
+		printf("%d/%d: uring_write %s %d writes+fsync r:%d %d\n",
+		       procid, opno, f.path, URING_BATCH, registered, e);
+	free_pathname(&f);
+	close(fd);
+}
+
+#endif
+
 void write_f(int opno, long r)
 {
 	char *buf;
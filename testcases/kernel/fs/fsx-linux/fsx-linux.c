@@ -37,6 +37,7 @@
  *	Add multi-file testing feature -- Zach Brown <zab@clusterfs.com>
  */
 
+#include "config.h"
 #include <sys/types.h>
 #include <sys/stat.h>
 #if defined(_UWIN) || defined(__linux__)
@@ -59,6 +60,16 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <errno.h>
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+# include <sys/syscall.h>
+# include <sys/uio.h>
+#endif
+
+/* the raw syscalls are used as fsx does not link the test harness */
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+# define URING_ASYNC 1
+#endif
 
 /*
  *	A log entry is an operation and a bunch of arguments.
@@ -124,6 +135,8 @@ int randomoplen = 1;		/* -O flag disables it */
 int seed = 1;			/* -S flag */
 int mapped_writes = 1;		/* -W flag disables */
 int mapped_reads = 1;		/* -R flag disables it */
+int async_depth = 0;		/* -A flag */
+int aio_pending = 0;		/* ops queued but not yet verified */
 int fsxgoodfd = 0;
 FILE *fsxlogf = NULL;
 int badoff = -1;
@@ -581,6 +594,206 @@ output_line(struct test_file *tf, int op, unsigned offset,
 	    offset + size - 1, size);
 }
 
+#ifdef URING_ASYNC
+
+/*
+ * Async mode (-A depth): reads and writes are queued on an io_uring and
+ * only verified when the batch is flushed. Overlap with the dirty range
+ * of any queued op forces a flush first, so good_buf always matches what
+ * each queued op must see and only touched ranges are ever compared.
+ */
+struct aio_op {
+	int op;
+	unsigned offset;
+	unsigned size;
+	unsigned dirty_from;	/* writes: includes the zero-filled gap */
+	char *buf;		/* reads land here until verification */
+	struct iovec iov;
+};
+
+struct aio_op *aio_ops;
+
+struct {
+	int fd;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+} aio_ring = { .fd = -1 };
+
+int aio_init(void)
+{
+	struct io_uring_params p;
+	char *cq;
+	int i;
+	char *sq;
+
+	memset(&p, 0, sizeof(p));
+	aio_ring.fd = syscall(__NR_io_uring_setup, async_depth, &p);
+	if (aio_ring.fd < 0)
+		return 0;
+	sq = mmap(NULL, p.sq_off.array + p.sq_entries * sizeof(unsigned int),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  aio_ring.fd, IORING_OFF_SQ_RING);
+	cq = mmap(NULL, p.cq_off.cqes +
+		  p.cq_entries * sizeof(struct io_uring_cqe),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  aio_ring.fd, IORING_OFF_CQ_RING);
+	aio_ring.sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+			     PROT_READ | PROT_WRITE,
+			     MAP_SHARED | MAP_POPULATE,
+			     aio_ring.fd, IORING_OFF_SQES);
+	if (sq == MAP_FAILED || cq == MAP_FAILED ||
+	    aio_ring.sqes == MAP_FAILED) {
+		close(aio_ring.fd);
+		aio_ring.fd = -1;
+		return 0;
+	}
+	aio_ring.sq_head = (unsigned int *)(sq + p.sq_off.head);
+	aio_ring.sq_tail = (unsigned int *)(sq + p.sq_off.tail);
+	aio_ring.sq_mask = (unsigned int *)(sq + p.sq_off.ring_mask);
+	aio_ring.sq_array = (unsigned int *)(sq + p.sq_off.array);
+	aio_ring.cq_head = (unsigned int *)(cq + p.cq_off.head);
+	aio_ring.cq_tail = (unsigned int *)(cq + p.cq_off.tail);
+	aio_ring.cq_mask = (unsigned int *)(cq + p.cq_off.ring_mask);
+	aio_ring.cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	aio_ops = malloc(async_depth * sizeof(*aio_ops));
+	if (aio_ops == NULL)
+		exit(96);
+	for (i = 0; i < async_depth; i++) {
+		aio_ops[i].buf = malloc(maxoplen);
+		if (aio_ops[i].buf == NULL)
+			exit(96);
+	}
+	return 1;
+}
+
+struct io_uring_sqe *aio_sqe(void)
+{
+	struct io_uring_sqe *sqe;
+	unsigned int tail;
+
+	tail = *aio_ring.sq_tail;
+	sqe = &aio_ring.sqes[tail & *aio_ring.sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	aio_ring.sq_array[tail & *aio_ring.sq_mask] =
+	    tail & *aio_ring.sq_mask;
+	__sync_synchronize();
+	*aio_ring.sq_tail = tail + 1;
+
+	return sqe;
+}
+
+void aio_flush(void)
+{
+	struct io_uring_cqe cqe;
+	unsigned int head;
+	int i;
+	int n;
+	struct aio_op *op;
+
+	if (!aio_pending)
+		return;
+
+	n = aio_pending;
+	if (syscall(__NR_io_uring_enter, aio_ring.fd, n, n,
+		    IORING_ENTER_GETEVENTS, NULL, 0) != n) {
+		prterr("aio_flush: io_uring_enter");
+		report_failure(210);
+	}
+
+	while (n--) {
+		head = *aio_ring.cq_head;
+		__sync_synchronize();
+		cqe = aio_ring.cqes[head & *aio_ring.cq_mask];
+		__sync_synchronize();
+		*aio_ring.cq_head = head + 1;
+
+		op = &aio_ops[cqe.user_data];
+		if ((unsigned)cqe.res != op->size) {
+			prt("async %s: 0x%x bytes instead of 0x%x "
+			    "(res %d)\n",
+			    op->op == OP_READ ? "read" : "write",
+			    cqe.res < 0 ? 0 : cqe.res, op->size, cqe.res);
+			report_failure(op->op == OP_READ ? 141 : 151);
+		}
+	}
+
+	/* verify the read data only over the ranges that were touched */
+	for (i = 0; i < aio_pending; i++) {
+		op = &aio_ops[i];
+		if (op->op != OP_READ)
+			continue;
+		memcpy(temp_buf, op->buf, op->size);
+		check_buffers(op->offset, op->size);
+	}
+	aio_pending = 0;
+
+	if (sizechecks && testcalls > simulatedopcount)
+		check_size();
+}
+
+int aio_overlaps(unsigned offset, unsigned size, int writing)
+{
+	unsigned from;
+	int i;
+	struct aio_op *op;
+
+	for (i = 0; i < aio_pending; i++) {
+		op = &aio_ops[i];
+		if (!writing && op->op != OP_WRITE)
+			continue;
+		from = op->op == OP_WRITE ? op->dirty_from : op->offset;
+		if (offset < op->offset + op->size && from < offset + size)
+			return 1;
+	}
+	return 0;
+}
+
+void aio_prepare(unsigned offset, unsigned size, int writing)
+{
+	if (aio_pending == async_depth || aio_overlaps(offset, size, writing))
+		aio_flush();
+}
+
+void aio_queue(int op, int fd, unsigned offset, unsigned size,
+	       unsigned dirty_from)
+{
+	struct aio_op *aop = &aio_ops[aio_pending];
+	struct io_uring_sqe *sqe;
+
+	aop->op = op;
+	aop->offset = offset;
+	aop->size = size;
+	aop->dirty_from = dirty_from;
+	aop->iov.iov_base = op == OP_READ ? aop->buf : good_buf + offset;
+	aop->iov.iov_len = size;
+
+	sqe = aio_sqe();
+	sqe->opcode = op == OP_READ ? IORING_OP_READV : IORING_OP_WRITEV;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long)&aop->iov;
+	sqe->len = 1;
+	sqe->off = offset;
+	sqe->user_data = aio_pending++;
+}
+
+#else /* !URING_ASYNC */
+
+# define aio_prepare(offset, size, writing) do {} while (0)
+# define aio_queue(op, fd, offset, size, dirty_from) \
+		do { (void)(dirty_from); } while (0)
+# define aio_flush() do {} while (0)
+# define aio_init() 0
+
+#endif /* URING_ASYNC */
+
 void doread(unsigned offset, unsigned size)
 {
 	struct timeval t;
@@ -611,6 +824,12 @@ void doread(unsigned offset, unsigned size)
 
 	output_line(tf, OP_READ, offset, size, &t);
 
+	if (async_depth) {
+		aio_prepare(offset, size, 0);
+		aio_queue(OP_READ, fd, offset, size, offset);
+		return;
+	}
+
 	ret = lseek(fd, (off_t) offset, SEEK_SET);
 	if (ret == (off_t) - 1) {
 		prterr("doread: lseek");
@@ -664,6 +883,8 @@ void domapread(unsigned offset, unsigned size)
 	if (testcalls <= simulatedopcount)
 		return;
 
+	aio_flush();
+
 	output_line(tf, OP_MAPREAD, offset, size, &t);
 
 	pg_offset = offset & page_mask;
@@ -719,6 +940,7 @@ void dowrite(unsigned offset, unsigned size)
 	struct timeval t;
 	off_t ret;
 	unsigned iret;
+	off_t cur_filesize;
 	struct test_file *tf = get_tf();
 	int fd = tf->fd;
 
@@ -733,6 +955,11 @@ void dowrite(unsigned offset, unsigned size)
 
 	log4(OP_WRITE, offset, size, file_size, &t);
 
+	/* queued reads verify against good_buf, so flush before changing it */
+	if (async_depth)
+		aio_prepare(offset, size, 1);
+	cur_filesize = file_size;
+
 	gendata(original_buf, good_buf, offset, size);
 	if (file_size < offset + size) {
 		if (file_size < offset)
@@ -749,6 +976,13 @@ void dowrite(unsigned offset, unsigned size)
 
 	output_line(tf, OP_WRITE, offset, size, &t);
 
+	if (async_depth) {
+		aio_queue(OP_WRITE, fd, offset, size,
+			  offset < cur_filesize ? offset
+						: (unsigned)cur_filesize);
+		return;
+	}
+
 	ret = lseek(fd, (off_t) offset, SEEK_SET);
 	if (ret == (off_t) - 1) {
 		prterr("dowrite: lseek");
@@ -794,6 +1028,8 @@ void domapwrite(unsigned offset, unsigned size)
 
 	log4(OP_MAPWRITE, offset, size, 0, &t);
 
+	aio_flush();
+
 	gendata(original_buf, good_buf, offset, size);
 	if (file_size < offset + size) {
 		if (file_size < offset)
@@ -890,6 +1126,8 @@ void dotruncate(unsigned size)
 
 	log4(OP_TRUNCATE, size, (unsigned)file_size, 0, &t);
 
+	aio_flush();
+
 	if (size > file_size)
 		memset(good_buf + file_size, '\0', size - file_size);
 	file_size = size;
@@ -915,6 +1153,8 @@ void writefileimage(void)
 	ssize_t iret;
 	int fd = get_fd();
 
+	aio_flush();
+
 	if (lseek(fd, (off_t) 0, SEEK_SET) == (off_t) - 1) {
 		prterr("writefileimage: lseek");
 		report_failure(171);
@@ -943,6 +1183,8 @@ void docloseopen(void)
 	if (testcalls <= simulatedopcount)
 		return;
 
+	aio_flush();
+
 	gettimeofday(&t, NULL);
 	log4(OP_CLOSEOPEN, file_size, (unsigned)file_size, 0, &t);
 
@@ -1029,7 +1271,7 @@ void test(void)
 			}
 		}
 	}
-	if (sizechecks && testcalls > simulatedopcount)
+	if (sizechecks && testcalls > simulatedopcount && !aio_pending)
 		check_size();
 	if (closeprob && (rv >> 3) < (1 << 28) / closeprob)
 		docloseopen();
@@ -1048,8 +1290,8 @@ void usage(void)
 	fprintf(stdout, "usage: %s",
 		"fsx [-dnqLOW] [-b opnum] [-c Prob] [-l flen] [-m "
 		"start:end] [-o oplen] [-p progressinterval] [-r readbdy] [-s style] [-t "
-		"truncbdy] [-w writebdy] [-D startingop] [-N numops] [-P dirpath] [-S seed] "
-		"[ -I random|rotate ] fname [additional paths to fname..]\n"
+		"truncbdy] [-w writebdy] [-A depth] [-D startingop] [-N numops] [-P dirpath] "
+		"[-S seed] [ -I random|rotate ] fname [additional paths to fname..]\n"
 		"	-b opnum: beginning operation number (default 1)\n"
 		"	-c P: 1 in P chance of file close+open at each op (default infinity)\n"
 		"	-d: debug output for all operations [-d -d = more debugging]\n"
@@ -1063,6 +1305,7 @@ void usage(void)
 		"	-s style: 1 gives smaller truncates (default 0)\n"
 		"	-t truncbdy: 4096 would make truncates page aligned (default 1)\n"
 		"	-w writebdy: 4096 would make writes page aligned (default 1)\n"
+		"	-A depth: queue up to depth reads/writes on io_uring before verifying\n"
 		"	-D startingop: debug output starting at specified operation\n"
 		"	-L: fsxLite - no file creations & no file size changes\n"
 		"	-N numops: total # operations to do (default infinity)\n"
@@ -1125,7 +1368,7 @@ int main(int argc, char **argv)
 	setvbuf(stdout, NULL, _IOLBF, 0);	/* line buffered stdout */
 
 	while ((ch = getopt(argc, argv,
-			    "b:c:dl:m:no:p:qr:s:t:w:D:I:LN:OP:RS:W"))
+			    "b:c:dl:m:no:p:qr:s:t:w:A:D:I:LN:OP:RS:W"))
 	       != EOF)
 		switch (ch) {
 		case 'b':
@@ -1202,6 +1445,11 @@ int main(int argc, char **argv)
 			if (writebdy <= 0)
 				usage();
 			break;
+		case 'A':
+			async_depth = getnum(optarg, &endp);
+			if (async_depth <= 0)
+				usage();
+			break;
 		case 'D':
 			debugstart = getnum(optarg, &endp);
 			if (debugstart < 1)
@@ -1336,9 +1584,15 @@ int main(int argc, char **argv)
 	} else
 		check_trunc_hack();
 
+	if (async_depth && !aio_init()) {
+		warn("main: io_uring setup failed, running synchronously");
+		async_depth = 0;
+	}
+
 	while (numops == -1 || numops--)
 		test();
 
+	aio_flush();
 	close_test_files();
 	prt("All operations completed A-OK!\n");
 
@@ -0,0 +1,397 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * ftest09 - overlapped rework of the ftest I/O core
+ *
+ * ftest01-08 run the classic bitmap algorithm - pick a random chunk,
+ * expect zeroes if it has not been written this pass, expect the pass
+ * pattern if it has, write the pattern, occasionally inject
+ * fsync/truncate/fstat - but with one synchronous operation in flight
+ * per child, so on modern storage the children sit in submit latency
+ * and the test finishes having barely stressed the device.
+ *
+ * This test keeps the operation mix and the hole-checking semantics
+ * but drives each worker's chunks through batches of overlapped
+ * native AIO: a batch of distinct random chunks is read in one
+ * io_submit(), every completion is verified against the bitmap
+ * (zeroes for unseen chunks below the written high-water mark, the
+ * pass pattern for seen ones), then the same chunks are rewritten in
+ * a second batch. The misc operations run between batches, when
+ * nothing is in flight, with the same truncate bookkeeping as
+ * ftest03. Termination is by work count - a pass ends once every
+ * chunk has been visited, like the originals, and the number of
+ * passes is a parameter - so the test does the same amount of work
+ * on slow and fast storage instead of idling on the latter.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <linux/aio_abi.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/syscalls.h"
+
+#define MAX_DEPTH 128
+
+static int csize = 4096;
+static long max_size = 64 * 1024 * 1024;
+static int nworkers = 4;
+static int depth = 32;
+static int passes = 2;
+static int misc_intvl = 10;
+
+static long nchunks;
+static unsigned long long *shared_bytes;
+
+static char *str_csize;
+static char *str_size;
+static char *str_workers;
+static char *str_depth;
+static char *str_passes;
+
+enum m_type { m_fsync, m_trunc, m_fstat, m_last };
+
+struct worker_state {
+	int fd;
+	int me;
+	char name[16];
+	char *bits;
+	char *chunkbuf[MAX_DEPTH];
+	long batch[MAX_DEPTH];
+	struct iocb iocbs[MAX_DEPTH];
+	struct iocb *iocbps[MAX_DEPTH];
+	struct io_event events[MAX_DEPTH];
+	aio_context_t ctx;
+	long file_max;
+	long last_trunc;
+	enum m_type mtype;
+	int tr_flag;
+	unsigned long long bytes;
+};
+
+static inline int test_bit(const char *bits, long chunk)
+{
+	return bits[chunk / 8] & (1 << (chunk % 8));
+}
+
+static inline void set_bit(char *bits, long chunk)
+{
+	bits[chunk / 8] |= (1 << (chunk % 8));
+}
+
+static void submit_batch(struct worker_state *w, int n, int write, char val)
+{
+	struct timespec timeout = { .tv_sec = 30 };
+	int i, done = 0, ret;
+
+	for (i = 0; i < n; i++) {
+		struct iocb *cb = &w->iocbs[i];
+
+		memset(cb, 0, sizeof(*cb));
+		cb->aio_fildes = w->fd;
+		cb->aio_lio_opcode = write ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+		cb->aio_buf = (unsigned long)w->chunkbuf[i];
+		cb->aio_nbytes = csize;
+		cb->aio_offset = w->batch[i] * (long long)csize;
+		cb->aio_data = i;
+		w->iocbps[i] = cb;
+
+		if (write)
+			memset(w->chunkbuf[i], val, csize);
+	}
+
+	ret = tst_syscall(__NR_io_submit, w->ctx, n, w->iocbps);
+	if (ret != n)
+		tst_brk(TBROK | TERRNO, "Test[%d]: io_submit()", w->me);
+
+	while (done < n) {
+		ret = tst_syscall(__NR_io_getevents, w->ctx, 1, n - done,
+				  w->events, &timeout);
+		if (ret <= 0)
+			tst_brk(TBROK | TERRNO, "Test[%d]: io_getevents()",
+				w->me);
+
+		for (i = 0; i < ret; i++) {
+			struct io_event *ev = &w->events[i];
+			long res = ev->res;
+			long chunk = w->batch[ev->data];
+
+			/* short reads are valid beyond the high-water mark */
+			if (res < 0 || (res != csize &&
+					(write || chunk * csize < w->file_max))) {
+				tst_brk(TFAIL, "Test[%d]: %s of chunk %ld returned %ld, expected %d",
+					w->me, write ? "write" : "read",
+					chunk, res, csize);
+			}
+
+			w->bytes += res > 0 ? res : 0;
+		}
+
+		done += ret;
+	}
+}
+
+static void verify_chunk(struct worker_state *w, long chunk, const char *buf,
+			 char val)
+{
+	char expected = test_bit(w->bits, chunk) ? val : 0;
+	int i;
+
+	for (i = 0; i < csize; i++) {
+		if (buf[i] != expected) {
+			tst_res(TINFO, "Test[%d]: last_trunc = 0x%lx",
+				w->me, w->last_trunc);
+			tst_brk(TFAIL, "Test[%d]: bad verify, chunk %ld off %d: got %d, expected %d (val %d)",
+				w->me, chunk, i, buf[i], expected, val);
+		}
+	}
+}
+
+/*
+ * The misc injection from the originals, run only between batches so
+ * truncation never races in-flight I/O.
+ */
+static void domisc(struct worker_state *w)
+{
+	struct stat sb;
+	long chunk;
+
+	switch (w->mtype) {
+	case m_fsync:
+		if (fsync(w->fd) < 0)
+			tst_brk(TFAIL | TERRNO, "Test[%d]: fsync()", w->me);
+		break;
+	case m_trunc:
+		if (!w->file_max)
+			break;
+		chunk = rand() % (w->file_max / csize);
+		w->file_max = chunk * (long)csize;
+		w->last_trunc = w->file_max;
+		if (w->tr_flag) {
+			if (ftruncate(w->fd, w->file_max) < 0)
+				tst_brk(TFAIL | TERRNO,
+					"Test[%d]: ftruncate() @ 0x%lx",
+					w->me, w->file_max);
+		} else {
+			if (truncate(w->name, w->file_max) < 0)
+				tst_brk(TFAIL | TERRNO,
+					"Test[%d]: truncate() @ 0x%lx",
+					w->me, w->file_max);
+		}
+		w->tr_flag = !w->tr_flag;
+		for (; chunk % 8 != 0; chunk++)
+			w->bits[chunk / 8] &= ~(1 << (chunk % 8));
+		for (; chunk < nchunks; chunk += 8)
+			w->bits[chunk / 8] = 0;
+		break;
+	default:
+		if (fstat(w->fd, &sb) < 0)
+			tst_brk(TFAIL | TERRNO, "Test[%d]: fstat()", w->me);
+		if (sb.st_size != w->file_max)
+			tst_brk(TFAIL, "Test[%d]: fstat() mismatch; st_size=%lld, file_max=0x%lx",
+				w->me, (long long)sb.st_size, w->file_max);
+		break;
+	}
+
+	if (++w->mtype >= m_last)
+		w->mtype = m_fsync;
+}
+
+static void dopass(struct worker_state *w, char val)
+{
+	long count = 0, collide = 0;
+	int whenmisc = (rand() % misc_intvl) + 5;
+
+	SAFE_FTRUNCATE(w->fd, 0);
+	w->file_max = 0;
+	memset(w->bits, 0, (nchunks + 7) / 8);
+
+	while (count < nchunks) {
+		int i, j, n = 0;
+
+		/* distinct random chunks, so batch order cannot matter */
+		while (n < depth && n < nchunks) {
+			long chunk = rand() % nchunks;
+
+			for (j = 0; j < n; j++) {
+				if (w->batch[j] == chunk)
+					break;
+			}
+			if (j < n)
+				continue;
+			w->batch[n++] = chunk;
+		}
+
+		submit_batch(w, n, 0, val);
+
+		for (i = 0; i < n; i++) {
+			long chunk = w->batch[i];
+
+			if (chunk * csize >= w->file_max) {
+				if (!test_bit(w->bits, chunk)) {
+					set_bit(w->bits, chunk);
+					count++;
+				}
+				continue;
+			}
+
+			verify_chunk(w, chunk, w->chunkbuf[i], val);
+
+			if (test_bit(w->bits, chunk)) {
+				collide++;
+			} else {
+				set_bit(w->bits, chunk);
+				count++;
+			}
+		}
+
+		submit_batch(w, n, 1, val);
+
+		for (i = 0; i < n; i++) {
+			long end = (w->batch[i] + 1) * (long)csize;
+
+			if (end > w->file_max)
+				w->file_max = end;
+		}
+
+		if (misc_intvl && --whenmisc <= 0) {
+			domisc(w);
+			whenmisc = (rand() % misc_intvl) + 5;
+		}
+
+		if (count + collide > 2 * nchunks)
+			break;
+	}
+
+	if (fsync(w->fd) < 0)
+		tst_brk(TFAIL | TERRNO, "Test[%d]: fsync()", w->me);
+}
+
+static void worker(int me)
+{
+	struct worker_state *w = SAFE_MALLOC(sizeof(*w));
+	char val;
+	int i, pass;
+
+	memset(w, 0, sizeof(*w));
+	w->me = me;
+	snprintf(w->name, sizeof(w->name), "%c", 'a' + me);
+	w->fd = SAFE_OPEN(w->name, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	w->bits = SAFE_MALLOC((nchunks + 7) / 8);
+
+	for (i = 0; i < depth; i++)
+		w->chunkbuf[i] = SAFE_MEMALIGN(getpagesize(), csize);
+
+	if (tst_syscall(__NR_io_setup, depth, &w->ctx))
+		tst_brk(TBROK | TERRNO, "Test[%d]: io_setup()", me);
+
+	srand(getpid());
+	val = (64 / nworkers) * me + 1;
+
+	for (pass = 0; pass < passes; pass++, val++)
+		dopass(w, val);
+
+	__sync_fetch_and_add(shared_bytes, w->bytes);
+
+	tst_syscall(__NR_io_destroy, w->ctx);
+	SAFE_CLOSE(w->fd);
+	SAFE_UNLINK(w->name);
+
+	for (i = 0; i < depth; i++)
+		free(w->chunkbuf[i]);
+	free(w->bits);
+	free(w);
+}
+
+static void run(void)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	int i;
+
+	*shared_bytes = 0;
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nworkers; i++) {
+		if (!SAFE_FORK()) {
+			worker(i);
+			exit(0);
+		}
+	}
+
+	tst_reap_children();
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO, "%d workers, %d passes over %ld chunks each: %7.1f MB/s",
+		nworkers, passes, nchunks,
+		1000.0 * *shared_bytes / elapsed_ms / (1024 * 1024));
+
+	tst_res(TPASS, "Overlapped read/verify/write passes completed");
+}
+
+static void setup(void)
+{
+	if (str_csize) {
+		if (tst_parse_int(str_csize, &csize, 512, 1024 * 1024))
+			tst_brk(TBROK, "Invalid chunk size '%s'", str_csize);
+	}
+
+	if (str_size) {
+		if (tst_parse_long(str_size, &max_size, csize, LONG_MAX))
+			tst_brk(TBROK, "Invalid file size '%s'", str_size);
+	}
+
+	if (str_workers) {
+		if (tst_parse_int(str_workers, &nworkers, 1, 26))
+			tst_brk(TBROK, "Invalid worker count '%s'", str_workers);
+	}
+
+	if (str_depth) {
+		if (tst_parse_int(str_depth, &depth, 1, MAX_DEPTH))
+			tst_brk(TBROK, "Invalid batch depth '%s'", str_depth);
+	}
+
+	if (str_passes) {
+		if (tst_parse_int(str_passes, &passes, 1, 62))
+			tst_brk(TBROK, "Invalid pass count '%s'", str_passes);
+	}
+
+	nchunks = max_size / csize;
+
+	shared_bytes = SAFE_MMAP(NULL, sizeof(*shared_bytes),
+				 PROT_READ | PROT_WRITE,
+				 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+}
+
+static void cleanup(void)
+{
+	if (shared_bytes)
+		SAFE_MUNMAP(shared_bytes, sizeof(*shared_bytes));
+}
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.forks_child = 1,
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+	.options = (struct tst_option[]) {
+		{"c:", &str_csize, "-c N     Chunk size in bytes (default 4096)"},
+		{"s:", &str_size, "-s N     File size in bytes (default 64MB)"},
+		{"w:", &str_workers, "-w N     Worker processes (default 4)"},
+		{"d:", &str_depth, "-d N     Overlapped operations per batch (default 32)"},
+		{"p:", &str_passes, "-p N     Full passes over each file (default 2)"},
+		{}
+	},
+};
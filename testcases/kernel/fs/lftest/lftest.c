@@ -7,21 +7,38 @@
  * of a filesystem. It writes one buffer at a time and lseeks from
  * the beginning of the file to the end of the last write position.
  * The intent is to test lseek64.
+ *
+ * With -F the file is extended with fallocate() and only the first and
+ * last buffers are actually written, so size-boundary checks do not
+ * have to write the whole file. With -d the data is written with
+ * O_DIRECT vectored writes, which skips the page cache and batches
+ * several buffers per syscall.
  */
 
+#define _GNU_SOURCE
+
+#include "config.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <time.h>
 
 #include "tst_test.h"
 
+#define NVECS 8
+
 static char *str_bufnum;
+static char *opt_falloc;
+static char *opt_direct;
 static int bufnum = 100;
 static char buf[TST_MB];
+static struct iovec iovecs[NVECS];
 
 static void setup(void)
 {
@@ -37,27 +54,118 @@ static void setup(void)
 	for (i = 1; i < ARRAY_SIZE(buf) - 1; i++)
 		buf[i] = '0';
 	buf[ARRAY_SIZE(buf) - 1] = 'Z';
+
+#ifndef HAVE_FALLOCATE
+	if (opt_falloc)
+		tst_brk(TCONF, "fallocate() not available");
+#endif
+
+	if (opt_direct) {
+		void *p = NULL;
+
+		for (i = 0; i < NVECS; i++) {
+			if (posix_memalign(&p, getpagesize(), sizeof(buf)))
+				tst_brk(TBROK, "posix_memalign() failed");
+
+			memcpy(p, buf, sizeof(buf));
+			iovecs[i].iov_base = p;
+			iovecs[i].iov_len = sizeof(buf);
+		}
+	}
 }
 
-static void run(void)
+/*
+ * Reserves the whole file with fallocate() and writes out only the
+ * first and the last buffer, so the offsets around the size boundary
+ * see real data without the test writing gigabytes to get there.
+ */
+static void build_sparse(int fd)
 {
-	time_t time1, time2;
-	int i, fd, diff;
+#ifdef HAVE_FALLOCATE
+	off_t size = (off_t)bufnum * sizeof(buf);
+	char *data = opt_direct ? iovecs[0].iov_base : buf;
 
-	time1 = time(NULL);
-	tst_res(TINFO, "started building a %d megabyte file", bufnum);
+	if (fallocate(fd, 0, 0, size)) {
+		if (errno == EOPNOTSUPP)
+			tst_brk(TCONF, "fallocate() not supported");
+
+		tst_brk(TFAIL | TERRNO, "fallocate() failed");
+	}
+
+	if (write(fd, data, sizeof(buf)) == -1)
+		tst_brk(TFAIL | TERRNO, "write() failed");
+
+	if (bufnum > 1) {
+		if (lseek(fd, size - sizeof(buf), 0) == -1)
+			tst_brk(TFAIL | TERRNO, "lseek failed");
+
+		if (write(fd, data, sizeof(buf)) == -1)
+			tst_brk(TFAIL | TERRNO, "write() failed");
+	}
+
+	if (lseek(fd, 0, SEEK_END) != size)
+		tst_brk(TFAIL, "file did not end up %lli bytes long",
+			(long long)size);
+#else
+	(void)fd;
+#endif
+}
 
-	if ((fd = creat("large_file", 0755)) == -1)
-		tst_brk(TBROK | TERRNO, "creat() failed");
+static void build_direct(int fd)
+{
+	int i, n;
+
+	for (i = 0; i < bufnum; i += n) {
+		n = MIN(NVECS, bufnum - i);
+
+		if (writev(fd, iovecs, n) != (ssize_t)(n * sizeof(buf)))
+			tst_brk(TFAIL | TERRNO, "writev() failed");
+
+		if (lseek(fd, (off_t)(i + n) * sizeof(buf), 0) == -1)
+			tst_brk(TFAIL | TERRNO, "lseek failed");
+	}
+}
+
+static void build_buffered(int fd)
+{
+	int i;
 
 	for (i = 0; i < bufnum; i++) {
-		if (write(fd, buf, sizeof(buf)) == -1) {
+		if (write(fd, buf, sizeof(buf)) == -1)
 			tst_brk(TFAIL | TERRNO, "write() failed");
-		}
+
 		fsync(fd);
-		if (lseek(fd, (i + 1) * sizeof(buf), 0) == -1)
+		if (lseek(fd, (off_t)(i + 1) * sizeof(buf), 0) == -1)
 			tst_brk(TFAIL | TERRNO, "lseek failed");
 	}
+}
+
+static void run(void)
+{
+	time_t time1, time2;
+	int fd, diff;
+	int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+
+	time1 = time(NULL);
+	tst_res(TINFO, "started building a %d megabyte file", bufnum);
+
+	if (opt_direct)
+		oflags |= O_DIRECT;
+
+	if ((fd = open("large_file", oflags, 0755)) == -1) {
+		if (opt_direct && errno == EINVAL)
+			tst_brk(TCONF, "O_DIRECT not supported here");
+
+		tst_brk(TBROK | TERRNO, "open() failed");
+	}
+
+	if (opt_falloc)
+		build_sparse(fd);
+	else if (opt_direct)
+		build_direct(fd);
+	else
+		build_buffered(fd);
+
 	close(fd);
 	time2 = time(NULL);
 	tst_res(TINFO, "finished building a %d megabyte file", bufnum);
@@ -71,6 +179,8 @@ static void run(void)
 static struct tst_test test = {
 	.options = (struct tst_option[]) {
 		{"n:", &str_bufnum, "-n COUNT Number of megabytes to write (default 100)"},
+		{"F", &opt_falloc, "-F       Extend the file with fallocate(), write boundary buffers only"},
+		{"d", &opt_direct, "-d       Write the data with O_DIRECT vectored writes"},
 		{}
 	},
 	.needs_tmpdir = 1,
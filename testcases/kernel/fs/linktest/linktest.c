@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) International Business Machines Corp., 2000
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Regression test for max links per file.
+ *
+ * C rewrite of the old linktest.sh, which forked one ln(1) per link.
+ * The requested numbers of hard and symbolic links are created with
+ * linkat()/symlinkat() relative to a pre-opened directory fd, so the
+ * time goes into the link operation itself instead of process startup
+ * and path resolution, and the work is sharded over a configurable
+ * number of worker processes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <sys/mman.h>
+
+#include "tst_test.h"
+#include "tst_cpu.h"
+#include "tst_device.h"
+
+static char *str_hard_links;
+static char *str_soft_links;
+static char *str_workers;
+static int hard_links = 1000;
+static int soft_links = 1000;
+static int nworkers;
+
+static int *errors;
+
+static void do_links(int dirfd, const char *target, int symbolic,
+		     int lo, int hi)
+{
+	char name[32];
+	int i, ret, errs = 0;
+
+	for (i = lo; i < hi; i++) {
+		snprintf(name, sizeof(name), "%cfile%i",
+			 symbolic ? 's' : 'h', i);
+
+		if (symbolic)
+			ret = symlinkat(target, dirfd, name);
+		else
+			ret = linkat(dirfd, target, dirfd, name, 0);
+
+		if (ret) {
+			if (!errs)
+				tst_res(TINFO | TERRNO, "linking %s failed",
+					name);
+			errs++;
+		}
+	}
+
+	if (errs)
+		tst_atomic_add_return(errs, errors);
+}
+
+static void test_links(const char *dir, const char *target, int symbolic,
+		       int limit, const char *msg)
+{
+	char path[PATH_MAX];
+	int dirfd, w;
+	int per = (limit + nworkers - 1) / nworkers;
+
+	tst_res(TINFO, "test %s link, limit: %i", msg, limit);
+
+	SAFE_MKDIR(dir, 0755);
+	snprintf(path, sizeof(path), "%s/%s", dir, target);
+	SAFE_TOUCH(path, 0644, NULL);
+
+	dirfd = SAFE_OPEN(dir, O_DIRECTORY | O_RDONLY);
+
+	*errors = 0;
+
+	for (w = 0; w < nworkers; w++) {
+		int lo = w * per;
+		int hi = MIN(limit, lo + per);
+
+		if (lo >= hi)
+			break;
+
+		if (!SAFE_FORK()) {
+			do_links(dirfd, target, symbolic, lo, hi);
+			exit(0);
+		}
+	}
+
+	tst_reap_children();
+	SAFE_CLOSE(dirfd);
+
+	if (*errors)
+		tst_res(TFAIL, "%s link errors: %i", msg, *errors);
+	else
+		tst_res(TPASS, "created %i %s links", limit, msg);
+
+	tst_purge_dir(dir);
+	SAFE_RMDIR(dir);
+}
+
+static void run(void)
+{
+	test_links("slink", "sfile", 1, soft_links, "symbolic");
+	test_links("hlink", "hfile", 0, hard_links, "hard");
+}
+
+static void setup(void)
+{
+	nworkers = MIN(8L, tst_ncpus_conf());
+
+	if (str_hard_links &&
+	    tst_parse_int(str_hard_links, &hard_links, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid hard link count '%s'", str_hard_links);
+
+	if (str_soft_links &&
+	    tst_parse_int(str_soft_links, &soft_links, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid soft link count '%s'", str_soft_links);
+
+	if (str_workers && tst_parse_int(str_workers, &nworkers, 1, 512))
+		tst_brk(TBROK, "Invalid worker count '%s'", str_workers);
+
+	errors = SAFE_MMAP(NULL, sizeof(*errors), PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+}
+
+static void cleanup(void)
+{
+	if (errors)
+		SAFE_MUNMAP(errors, sizeof(*errors));
+}
+
+static struct tst_option options[] = {
+	{"a:", &str_hard_links, "-a n     Hard link count (default 1000)"},
+	{"s:", &str_soft_links, "-s n     Soft link count (default 1000)"},
+	{"w:", &str_workers, "-w n     Number of worker processes (default ncpus, max 8)"},
+	{NULL, NULL, NULL}
+};
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.forks_child = 1,
+	.options = options,
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
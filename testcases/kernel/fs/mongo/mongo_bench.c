@@ -0,0 +1,415 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Measured mode for the mongo filesystem benchmark.
+ *
+ * mongo.pl times its phases with time(1) and writes free-text logs
+ * nothing can trend. This test keeps the shape of the mongo workload -
+ * a randomly branching directory tree filled with files around a
+ * median size, then pushed through the Create, Copy, Slinks, Read,
+ * Stats, Rename and Delete phases - but builds the tree from a seeded
+ * generator so the workload is identical from run to run, and times
+ * every operation with the test library timers.
+ *
+ * Each phase reports ops/s, MB/s and latency percentiles, and with -o
+ * appends one key=value record per phase to a file in the same format
+ * as fs_bench, so the two can serve as filesystem performance
+ * regression gates side by side.
+ *
+ * The benchmark always passes unless an operation fails, the value is
+ * in the reported numbers.
+ */
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+#define TREE_DIR "tree"
+#define COPY_DIR "copy"
+#define MAX_DEPTH 30
+
+static char *str_nfiles;
+static char *str_ndirs;
+static char *str_median_size;
+static char *str_seed;
+static char *str_hist_bits;
+static char *result_file_name;
+
+static int nfiles = 4096;
+static int ndirs = 64;
+static int median_size = 1000;
+static int seed = 42;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static int *dir_parent;
+static int *dir_depth;
+static int *file_dir;
+static int *file_size;
+static char *iobuf;
+static int max_size;
+static struct tst_hist hist;
+
+/*
+ * Small deterministic generator so the tree shape and file sizes do
+ * not depend on the libc random(), only on the seed.
+ */
+static unsigned int prng_state;
+
+static unsigned int prng(void)
+{
+	prng_state = prng_state * 1103515245 + 12345;
+	return (prng_state >> 16) & 0x7fff;
+}
+
+static void dir_path(int d, char *buf)
+{
+	if (dir_parent[d] == -1) {
+		sprintf(buf, "d%03x", d);
+		return;
+	}
+
+	dir_path(dir_parent[d], buf);
+	sprintf(buf + strlen(buf), "/d%03x", d);
+}
+
+static void file_path(int i, const char *top, const char *suffix, char *buf)
+{
+	/* MAX_DEPTH levels of "d%03x/" fit comfortably */
+	char dbuf[(MAX_DEPTH + 1) * 6];
+
+	dir_path(file_dir[i], dbuf);
+	snprintf(buf, PATH_MAX, "%s/%s/f%06x%s", top, dbuf, i, suffix);
+}
+
+static long long op_create(int i)
+{
+	char path[PATH_MAX];
+	int fd;
+
+	if (i < ndirs) {
+		dir_path(i, path + sprintf(path, TREE_DIR "/"));
+		SAFE_MKDIR(path, 0755);
+		return 0;
+	}
+
+	i -= ndirs;
+	file_path(i, TREE_DIR, "", path);
+
+	fd = SAFE_OPEN(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (file_size[i])
+		SAFE_WRITE(1, fd, iobuf, file_size[i]);
+	SAFE_CLOSE(fd);
+
+	return file_size[i];
+}
+
+static long long op_copy(int i)
+{
+	char src[PATH_MAX], dst[PATH_MAX];
+	int sfd, dfd, ret;
+	long long bytes = 0;
+
+	if (i < ndirs) {
+		dir_path(i, src + sprintf(src, COPY_DIR "/"));
+		SAFE_MKDIR(src, 0755);
+		return 0;
+	}
+
+	i -= ndirs;
+	file_path(i, TREE_DIR, "", src);
+	file_path(i, COPY_DIR, "", dst);
+
+	sfd = SAFE_OPEN(src, O_RDONLY);
+	dfd = SAFE_OPEN(dst, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	while ((ret = SAFE_READ(0, sfd, iobuf, max_size)) > 0) {
+		SAFE_WRITE(1, dfd, iobuf, ret);
+		bytes += ret;
+	}
+
+	SAFE_CLOSE(dfd);
+	SAFE_CLOSE(sfd);
+
+	return bytes;
+}
+
+static long long op_slinks(int i)
+{
+	char path[PATH_MAX], lnk[PATH_MAX];
+
+	file_path(i, TREE_DIR, "", path);
+	file_path(i, TREE_DIR, ".lnk", lnk);
+
+	SAFE_SYMLINK(path, lnk);
+
+	return 0;
+}
+
+static long long read_one(const char *path)
+{
+	long long bytes = 0;
+	int fd, ret;
+
+	fd = SAFE_OPEN(path, O_RDONLY);
+	while ((ret = SAFE_READ(0, fd, iobuf, max_size)) > 0)
+		bytes += ret;
+	SAFE_CLOSE(fd);
+
+	return bytes;
+}
+
+static long long op_read(int i)
+{
+	char path[PATH_MAX];
+
+	if (i < nfiles)
+		file_path(i, TREE_DIR, "", path);
+	else
+		file_path(i - nfiles, COPY_DIR, "", path);
+
+	return read_one(path);
+}
+
+static long long op_stats(int i)
+{
+	char path[PATH_MAX];
+	struct stat sb;
+
+	if (i < nfiles)
+		file_path(i, TREE_DIR, "", path);
+	else
+		file_path(i - nfiles, COPY_DIR, "", path);
+
+	SAFE_LSTAT(path, &sb);
+
+	return 0;
+}
+
+static long long op_rename(int i)
+{
+	char path[PATH_MAX], newpath[PATH_MAX];
+
+	file_path(i, TREE_DIR, "", path);
+	file_path(i, TREE_DIR, ".r", newpath);
+
+	SAFE_RENAME(path, newpath);
+
+	return 0;
+}
+
+static long long op_delete(int i)
+{
+	char path[PATH_MAX];
+
+	if (i < nfiles) {
+		file_path(i, TREE_DIR, ".r", path);
+		SAFE_UNLINK(path);
+		return 0;
+	}
+	i -= nfiles;
+
+	if (i < nfiles) {
+		file_path(i, TREE_DIR, ".lnk", path);
+		SAFE_UNLINK(path);
+		return 0;
+	}
+	i -= nfiles;
+
+	if (i < nfiles) {
+		file_path(i, COPY_DIR, "", path);
+		SAFE_UNLINK(path);
+		return 0;
+	}
+	i -= nfiles;
+
+	/* subdirectories in reverse creation order, children first */
+	if (i < ndirs)
+		dir_path(ndirs - 1 - i, path + sprintf(path, TREE_DIR "/"));
+	else
+		dir_path(2 * ndirs - 1 - i,
+			 path + sprintf(path, COPY_DIR "/"));
+	SAFE_RMDIR(path);
+
+	return 0;
+}
+
+/*
+ * One "key=value ..." record per phase, same keys as fs_bench writes,
+ * so results from both benchmarks can be collected by the same
+ * scripts.
+ */
+static void write_result(const char *phase, unsigned int ops,
+			 long long bytes, long long duration)
+{
+	FILE *f;
+
+	if (!result_file_name)
+		return;
+
+	f = fopen(result_file_name, "a");
+
+	if (!f) {
+		tst_res(TWARN | TERRNO,
+			"Failed to open '%s'", result_file_name);
+		return;
+	}
+
+	fprintf(f, "tag=mongo_bench.%s ops=%u bytes=%lli duration=%lli "
+		"p50=%lli p90=%lli p99=%lli p99.9=%lli\n",
+		phase, ops, bytes, duration,
+		tst_hist_percentile(&hist, 50), tst_hist_percentile(&hist, 90),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
+	if (fclose(f)) {
+		tst_res(TWARN | TERRNO,
+			"Failed to close '%s'", result_file_name);
+	}
+}
+
+static void run_phase(const char *name, long long (*op)(int i), int count)
+{
+	struct timespec start, end;
+	long long elapsed, bytes = 0;
+	double secs;
+	int i;
+
+	tst_hist_reset(&hist);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < count; i++) {
+		tst_timer_start(CLOCK_MONOTONIC);
+		bytes += op(i);
+		tst_timer_stop();
+
+		tst_hist_add(&hist, tst_timer_elapsed_us());
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &end);
+	elapsed = tst_timespec_diff_us(end, start);
+	secs = 1.00 * elapsed / 1000000;
+
+	tst_res(TINFO, "%s: %u ops in %.2fs, %.0f ops/s, %.2f MB/s",
+		name, count, secs, count / secs,
+		1.00 * bytes / secs / (1024 * 1024));
+	tst_res(TINFO, "%s: p50 %llius, p90 %llius, p99 %llius, p99.9 %llius",
+		name,
+		tst_hist_percentile(&hist, 50), tst_hist_percentile(&hist, 90),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
+	write_result(name, count, bytes, elapsed);
+}
+
+static void run(void)
+{
+	run_phase("create", op_create, ndirs + nfiles);
+	run_phase("copy", op_copy, ndirs + nfiles);
+	run_phase("slinks", op_slinks, nfiles);
+	run_phase("read", op_read, 2 * nfiles);
+	run_phase("stats", op_stats, 2 * nfiles);
+	run_phase("rename", op_rename, nfiles);
+	run_phase("delete", op_delete, 3 * nfiles + 2 * ndirs);
+
+	SAFE_RMDIR(TREE_DIR);
+	SAFE_RMDIR(COPY_DIR);
+
+	tst_res(TPASS, "Benchmark completed");
+}
+
+static void setup(void)
+{
+	int i, p;
+
+	if (str_nfiles && tst_parse_int(str_nfiles, &nfiles, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid number of files '%s'", str_nfiles);
+
+	if (str_ndirs && tst_parse_int(str_ndirs, &ndirs, 1, 0xfff))
+		tst_brk(TBROK, "Invalid number of dirs '%s'", str_ndirs);
+
+	if (str_median_size && tst_parse_int(str_median_size, &median_size,
+					     1, INT_MAX / 2))
+		tst_brk(TBROK, "Invalid median file size '%s'",
+			str_median_size);
+
+	if (str_seed && tst_parse_int(str_seed, &seed, 0, INT_MAX))
+		tst_brk(TBROK, "Invalid seed '%s'", str_seed);
+
+	if (str_hist_bits && tst_parse_int(str_hist_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid histogram bits '%s'", str_hist_bits);
+
+	tst_hist_init(&hist, hist_bits);
+
+	prng_state = seed;
+	max_size = 2 * median_size;
+
+	dir_parent = SAFE_MALLOC(ndirs * sizeof(int));
+	dir_depth = SAFE_MALLOC(ndirs * sizeof(int));
+	file_dir = SAFE_MALLOC(nfiles * sizeof(int));
+	file_size = SAFE_MALLOC(nfiles * sizeof(int));
+
+	/*
+	 * Random branching with a depth cap; uniform sizes in
+	 * [0, 2 * median) keep the requested median. Everything is a
+	 * pure function of the seed.
+	 */
+	dir_parent[0] = -1;
+	dir_depth[0] = 0;
+	for (i = 1; i < ndirs; i++) {
+		p = prng() % i;
+		if (dir_depth[p] >= MAX_DEPTH)
+			p = 0;
+		dir_parent[i] = p;
+		dir_depth[i] = dir_depth[p] + 1;
+	}
+
+	for (i = 0; i < nfiles; i++) {
+		file_dir[i] = prng() % ndirs;
+		file_size[i] = (prng() << 15 | prng()) % max_size;
+	}
+
+	iobuf = SAFE_MALLOC(max_size);
+	memset(iobuf, 'm', max_size);
+
+	SAFE_MKDIR(TREE_DIR, 0755);
+	SAFE_MKDIR(COPY_DIR, 0755);
+}
+
+static void cleanup(void)
+{
+	free(dir_parent);
+	free(dir_depth);
+	free(file_dir);
+	free(file_size);
+	free(iobuf);
+	tst_hist_free(&hist);
+}
+
+static struct tst_option options[] = {
+	{"n:", &str_nfiles, "-n files Number of files in the tree (default 4096)"},
+	{"d:", &str_ndirs, "-d dirs  Number of directories in the tree (default 64)"},
+	{"s:", &str_median_size, "-s bytes Median file size (default 1000)"},
+	{"S:", &str_seed, "-S seed  Workload generator seed (default 42)"},
+	{"b:", &str_hist_bits, "-b bits  Histogram sub-bucket bits, sets resolution to 2^-bits (default 7)"},
+	{"o:", &result_file_name, "-o fname Append machine-readable per-phase results to a file"},
+	{NULL, NULL, NULL}
+};
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.options = options,
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -29,6 +29,7 @@
  *
  */
 
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -41,7 +42,7 @@ char *TCID = "openfile01";	/* Test program identifier.    */
 int TST_TOTAL = 1;
 
 #define MAXFILES        32768
-#define MAXTHREADS      10
+#define MAXTHREADS      512
 
 /* Control Structure */
 struct cb {
@@ -55,6 +56,7 @@ struct cb {
 int numthreads = 10, numfiles = 10;
 int debug = 0;
 char *filename = "FILETOOPEN";
+int dirfd;			/* all opens are relative to this */
 
 void setup(void)
 {
@@ -130,6 +132,15 @@ int main(int argc, char *argv[])
 		cleanup();
 	}
 
+	/* Open the test directory once, so that the reading threads can
+	 * open the file relative to it and skip the path walk */
+	if ((dirfd = open(".", O_DIRECTORY | O_RDONLY)) < 0) {
+		tst_resm(TFAIL, "Could not open test directory");
+		fclose(fd);
+		unlink(filename);
+		cleanup();
+	}
+
 	/* Initialize thread control variables, lock & condition */
 	pthread_mutex_init(&c.m, NULL);
 	pthread_cond_init(&c.init_cv, NULL);
@@ -194,11 +205,11 @@ int main(int argc, char *argv[])
  *				OTHER PROCEDURES			    *
  ************************************************************************** */
 
-void close_files(FILE * fd_list[], int len)
+void close_files(int fd_list[], int len)
 {
 	int i;
 	for (i = 0; i < len; i++) {
-		fclose(fd_list[i]);
+		close(fd_list[i]);
 	}
 }
 
@@ -207,15 +218,21 @@ void *threads(void *thread_id_)
 {
 	int thread_id = (uintptr_t) thread_id_;
 	char errmsg[80];
-	FILE *fd_list[MAXFILES];
+	int *fd_list;
 	int i;
 
+	if ((fd_list = malloc(numfiles * sizeof(int))) == NULL) {
+		perror("FAIL - Couldn't allocate fd list");
+		unlink(filename);
+		pthread_exit((void *)1);
+	}
+
 	/* Open files */
 	for (i = 0; i < numfiles; i++) {
 		if (debug)
 			printf("Thread  %d : Opening file number %d \n",
 			       thread_id, i);
-		if ((fd_list[i] = fopen(filename, "rw")) == NULL) {
+		if ((fd_list[i] = openat(dirfd, filename, O_RDWR)) < 0) {
 			sprintf(errmsg, "FAIL - Couldn't open file #%d", i);
 			perror(errmsg);
 			if (i > 0) {
@@ -261,6 +278,7 @@ void *threads(void *thread_id_)
 
 	/* Close file handles and exit */
 	close_files(fd_list, numfiles);
+	free(fd_list);
 	unlink(filename);
 	pthread_exit(NULL);
 }
@@ -34,20 +34,28 @@
 #include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <fnmatch.h>
+#include <semaphore.h>
 
 #ifdef HAVE_LIBSELINUX_DEVEL
 #include <selinux/selinux.h>
 #endif
 
 #include "test.h"
+#include "tst_cpu.h"
 
 #define MAX_BUFF_SIZE 65536
 #define MAX_FUNC_NAME 256
 
+#define QUEUE_SIZE 16384
+#define MAX_WORKERS 64
+#define DEFAULT_MAX_WORKERS 15
+
 char *TCID = "proc01";
 int TST_TOTAL = 1;
 
@@ -59,6 +67,8 @@ static int opt_readirq;
 static char *opt_buffsizestr;
 static int opt_maxmbytes;
 static char *opt_maxmbytesstr;
+static int opt_workers;
+static char *opt_workersstr;
 
 static char *procpath = "/proc";
 static const char selfpath[] = "/proc/self";
@@ -68,6 +78,29 @@ static unsigned long long maxbytes;
 unsigned long long total_read;
 unsigned int total_obj;
 
+/*
+ * The directory walk runs in the parent while the open/read syscalls,
+ * which dominate the wall time of a full sweep, are sharded over
+ * worker processes. File paths travel through small per-worker queues
+ * in shared memory, the same scheme read_all.c uses for sysfs.
+ */
+struct queue {
+	sem_t sem;
+	int front;
+	int back;
+	char data[QUEUE_SIZE];
+};
+
+struct worker {
+	pid_t pid;
+	struct queue *q;
+};
+
+static struct worker workers[MAX_WORKERS];
+static int nworkers;
+static int next_worker;
+static unsigned long long *shared_read;	/* bytes read, all workers */
+
 struct mapping {
 	char func[MAX_FUNC_NAME];
 	char file[PATH_MAX];
@@ -188,6 +221,252 @@ static int found_errno(const char *syscall, const char *obj, int tmperr)
 	return 0;
 }
 
+static int queue_pop(struct queue *q, char *buf)
+{
+	int i = q->front, j = 0;
+
+	sem_wait(&q->sem);
+
+	if (!q->data[i])
+		return 0;
+
+	while (q->data[i]) {
+		buf[j++] = q->data[i];
+		i = (i + 1) % QUEUE_SIZE;
+	}
+
+	buf[j] = '\0';
+	q->front = (i + 1) % QUEUE_SIZE;
+
+	return 1;
+}
+
+static int queue_push(struct queue *q, const char *buf)
+{
+	int i = q->back, j = 0;
+
+	do {
+		q->data[i] = buf[j];
+
+		i = (i + 1) % QUEUE_SIZE;
+
+		if (i == q->front)
+			return 0;
+
+	} while (buf[j++]);
+
+	q->back = i;
+	sem_post(&q->sem);
+
+	return 1;
+}
+
+static struct queue *queue_init(void)
+{
+	struct queue *q = mmap(NULL, sizeof(*q), PROT_READ | PROT_WRITE,
+			       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if (q == MAP_FAILED)
+		tst_brkm(TBROK | TERRNO, NULL, "mmap worker queue");
+
+	sem_init(&q->sem, 1, 0);
+	q->front = 0;
+	q->back = 0;
+
+	return q;
+}
+
+/*
+ * Opens and reads one file; the file-type half of what used to be
+ * readproc(). Runs in the workers, so each one has its own buffer.
+ * Returns the number of errors found.
+ */
+static long read_file(const char *obj)
+{
+	struct stat statbuf;
+	int fd, tmperr, i;
+	ssize_t nread;
+	static char buf[MAX_BUFF_SIZE];
+	unsigned long long file_total_read = 0;
+
+	/* the walk and the read race against exiting processes */
+	if (lstat(obj, &statbuf) < 0) {
+		if (errno != EACCES && errno != ENOENT && errno != ESRCH) {
+			tst_resm(TFAIL | TERRNO, "%s: lstat", obj);
+			return 1;
+		}
+		return 0;
+	}
+
+	/* is O_NONBLOCK enough to escape from FIFO's ? */
+	fd = open(obj, O_RDONLY | O_NONBLOCK);
+	if (fd < 0) {
+		tmperr = errno;
+
+		if (tmperr == ENOENT || tmperr == ESRCH)
+			return 0;
+
+		if (!found_errno("open", obj, tmperr)) {
+
+			errno = tmperr;
+
+			if (errno != EACCES) {
+				tst_resm(TFAIL | TERRNO,
+					 "%s: open failed", obj);
+				return 1;
+			}
+
+		}
+		return 0;
+
+	}
+
+	/* Skip write-only files. */
+	if ((statbuf.st_mode & S_IRUSR) == 0 &&
+	    (statbuf.st_mode & S_IWUSR) != 0) {
+		tst_resm(TINFO, "%s: is write-only.", obj);
+		(void)close(fd);
+		return 0;
+	}
+
+	/* Skip files does not honor O_NONBLOCK. */
+	for (i = 0; error_nonblock[i][0] != '\0'; i++) {
+		if (!strcmp(obj, error_nonblock[i])) {
+			tst_resm(TINFO, "%s: does not honor "
+				 "O_NONBLOCK", obj);
+			(void)close(fd);
+			return 0;
+		}
+	}
+
+	do {
+
+		nread = read(fd, buf, buffsize);
+
+		if (nread < 0) {
+
+			tmperr = errno;
+			(void)close(fd);
+
+			/* ignore no perm (not root) and no
+			 * process (terminated) errors */
+			if (!found_errno("read", obj, tmperr)) {
+
+				errno = tmperr;
+
+				if (errno != EACCES && errno != ESRCH) {
+					tst_resm(TFAIL | TERRNO,
+						 "read failed: "
+						 "%s", obj);
+					return 1;
+				}
+				return 0;
+
+			}
+
+		} else
+			file_total_read += nread;
+
+		if (opt_verbose) {
+#ifdef DEBUG
+			fprintf(stderr, "%ld", nread);
+#endif
+			fprintf(stderr, ".");
+		}
+
+		if ((maxbytes > 0) && (file_total_read > maxbytes)) {
+			tst_resm(TINFO, "%s: reached maxmbytes (-m)", obj);
+			break;
+		}
+	} while (0 < nread);
+
+	__sync_fetch_and_add(shared_read, file_total_read);
+
+	if (opt_verbose)
+		fprintf(stderr, "\n");
+
+	if (0 <= fd)
+		(void)close(fd);
+
+	return 0;
+}
+
+static void worker_run(struct worker *self)
+{
+	char path[PATH_MAX];
+	long errs = 0;
+
+	while (queue_pop(self->q, path))
+		errs += read_file(path);
+
+	exit(errs > 100 ? 100 : errs);
+}
+
+static void spawn_workers(void)
+{
+	int i;
+
+	for (i = 0; i < nworkers; i++) {
+		workers[i].q = queue_init();
+		workers[i].pid = fork();
+		if (workers[i].pid < 0)
+			tst_brkm(TBROK | TERRNO, NULL, "fork worker");
+		if (!workers[i].pid)
+			worker_run(&workers[i]);
+	}
+
+	next_worker = 0;
+}
+
+static void push_work(const char *path)
+{
+	int usleep_time = 100;
+
+	/* round robin; on a full queue try the others, then back off */
+	for (;;) {
+		if (queue_push(workers[next_worker].q, path)) {
+			next_worker = (next_worker + 1) % nworkers;
+			return;
+		}
+
+		if (++next_worker >= nworkers) {
+			next_worker = 0;
+			usleep(usleep_time);
+			if (usleep_time < 100000)
+				usleep_time *= 2;
+		}
+	}
+}
+
+/* returns the number of file errors the workers saw */
+static long stop_workers(void)
+{
+	const char stop_code[1] = { '\0' };
+	long errs = 0;
+	int i, status;
+
+	for (i = 0; i < nworkers; i++) {
+		while (!queue_push(workers[i].q, stop_code))
+			usleep(100);
+	}
+
+	for (i = 0; i < nworkers; i++) {
+		if (waitpid(workers[i].pid, &status, 0) < 0)
+			tst_brkm(TBROK | TERRNO, NULL, "waitpid worker");
+
+		if (WIFEXITED(status))
+			errs += WEXITSTATUS(status);
+		else
+			errs++;
+
+		sem_destroy(&workers[i].q->sem);
+		munmap(workers[i].q, sizeof(*workers[i].q));
+		workers[i].q = NULL;
+	}
+
+	return errs;
+}
+
 static void cleanup(void)
 {
 	tst_rmdir();
@@ -207,6 +486,8 @@ void help(void)
 	printf("  -q      read .../irq/... entries\n");
 	printf("  -r x    proc pathname\n");
 	printf("  -v      verbose mode\n");
+	printf("  -w x    number of reader processes (default: one per CPU, max %d)\n",
+	       DEFAULT_MAX_WORKERS);
 }
 
 /*
@@ -219,6 +500,7 @@ static option_t options[] = {
 	{"q", &opt_readirq, NULL},
 	{"r:", &opt_procpath, &opt_procpathstr},
 	{"v", &opt_verbose, NULL},
+	{"w:", &opt_workers, &opt_workersstr},
 	{NULL, NULL, NULL}
 };
 
@@ -248,10 +530,6 @@ static long readproc(const char *obj)
 	struct dirent *dir_ent;	/* pointer to directory entries */
 	char dirobj[PATH_MAX];	/* object inside directory to modify */
 	struct stat statbuf;	/* used to hold stat information */
-	int fd, tmperr, i;
-	ssize_t nread;
-	static char buf[MAX_BUFF_SIZE];	/* static kills reentrancy, but we don't care about the contents */
-	unsigned long long file_total_read = 0;
 
 	/* Determine the file type */
 	if (lstat(obj, &statbuf) < 0) {
@@ -335,7 +613,7 @@ static long readproc(const char *obj)
 
 		}
 
-	} else {		/* if it's not a dir, read it! */
+	} else {		/* if it's not a dir, queue it for a reader */
 
 		if (!S_ISREG(statbuf.st_mode))
 			return 0;
@@ -344,92 +622,7 @@ static long readproc(const char *obj)
 		fprintf(stderr, "%s", obj);
 #endif
 
-		/* is O_NONBLOCK enough to escape from FIFO's ? */
-		fd = open(obj, O_RDONLY | O_NONBLOCK);
-		if (fd < 0) {
-			tmperr = errno;
-
-			if (!found_errno("open", obj, tmperr)) {
-
-				errno = tmperr;
-
-				if (errno != EACCES) {
-					tst_resm(TFAIL | TERRNO,
-						 "%s: open failed", obj);
-					return 1;
-				}
-
-			}
-			return 0;
-
-		}
-
-		/* Skip write-only files. */
-		if ((statbuf.st_mode & S_IRUSR) == 0 &&
-		    (statbuf.st_mode & S_IWUSR) != 0) {
-			tst_resm(TINFO, "%s: is write-only.", obj);
-			return 0;
-		}
-
-		/* Skip files does not honor O_NONBLOCK. */
-		for (i = 0; error_nonblock[i][0] != '\0'; i++) {
-			if (!strcmp(obj, error_nonblock[i])) {
-				tst_resm(TINFO, "%s: does not honor "
-					 "O_NONBLOCK", obj);
-				return 0;
-			}
-		}
-
-		file_total_read = 0;
-		do {
-
-			nread = read(fd, buf, buffsize);
-
-			if (nread < 0) {
-
-				tmperr = errno;
-				(void)close(fd);
-
-				/* ignore no perm (not root) and no
-				 * process (terminated) errors */
-				if (!found_errno("read", obj, tmperr)) {
-
-					errno = tmperr;
-
-					if (errno != EACCES && errno != ESRCH) {
-						tst_resm(TFAIL | TERRNO,
-							 "read failed: "
-							 "%s", obj);
-						return 1;
-					}
-					return 0;
-
-				}
-
-			} else
-				file_total_read += nread;
-
-			if (opt_verbose) {
-#ifdef DEBUG
-				fprintf(stderr, "%ld", nread);
-#endif
-				fprintf(stderr, ".");
-			}
-
-			if ((maxbytes > 0) && (file_total_read > maxbytes)) {
-				tst_resm(TINFO, "%s: reached maxmbytes (-m)",
-					 obj);
-				break;
-			}
-		} while (0 < nread);
-		total_read += file_total_read;
-
-		if (opt_verbose)
-			fprintf(stderr, "\n");
-
-		if (0 <= fd)
-			(void)close(fd);
-
+		push_work(obj);
 	}
 
 	/* It's better to assume success by default rather than failure. */
@@ -459,20 +652,45 @@ int main(int argc, char *argv[])
 	if (opt_procpath)
 		procpath = opt_procpathstr;
 
+	if (opt_workers) {
+		nworkers = atoi(opt_workersstr);
+		if (nworkers < 1 || nworkers > MAX_WORKERS)
+			tst_brkm(TBROK, NULL,
+				 "Invalid arg for -w (max: %u): %s",
+				 MAX_WORKERS, opt_workersstr);
+	} else {
+		nworkers = tst_ncpus();
+		if (nworkers > DEFAULT_MAX_WORKERS)
+			nworkers = DEFAULT_MAX_WORKERS;
+	}
+
+	shared_read = mmap(NULL, sizeof(*shared_read),
+			   PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared_read == MAP_FAILED)
+		tst_brkm(TBROK | TERRNO, NULL, "mmap shared counter");
+
 	setup();
 
 	for (lc = 0; TEST_LOOPING(lc); lc++) {
+		long errs;
+
 		tst_count = 0;
+		*shared_read = 0;
 
+		spawn_workers();
 		TEST(readproc(procpath));
+		errs = TEST_RETURN + stop_workers();
+		total_read = *shared_read;
 
-		if (TEST_RETURN != 0) {
+		if (errs != 0) {
 			tst_resm(TFAIL, "readproc() failed with %ld errors.",
-				 TEST_RETURN);
+				 errs);
 		} else {
 			tst_resm(TPASS, "readproc() completed successfully, "
-				 "total read: %llu bytes, %u objs", total_read,
-				 total_obj);
+				 "total read: %llu bytes, %u objs "
+				 "(%d readers)", total_read, total_obj,
+				 nworkers);
 		}
 	}
 
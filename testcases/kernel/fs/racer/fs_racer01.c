@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * C based companion to the fs_racer.sh suite.
+ *
+ * The shell racers rely on scheduling luck to make their create, rename,
+ * link and unlink loops collide, which on fast machines means a race
+ * window is hit only after hours of runtime. Here each racing pair of
+ * operations runs in its own pair of threads aligned with fuzzy sync, so
+ * the two syscalls are steered into overlapping each other on every
+ * iteration.
+ *
+ * A configurable number of worker pairs is forked, each pinned to its
+ * own pair of cpus and cycling one race scenario over a file name pool
+ * that is shared between all pairs, so on top of the aligned races the
+ * scenarios also collide with each other the way the shell version
+ * intended. The test passes when the kernel survives untainted.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/stat.h>
+
+#include "tst_test.h"
+#include "tst_cpu.h"
+#include "tst_fuzzy_sync.h"
+
+#define MAX_FILES 20
+
+static char *str_pairs;
+static int npairs;
+static long ncpus;
+
+static struct tst_fzsync_pair fzsync_pair;
+static int scenario;
+static int cpu_b;
+static volatile int race_idx;
+
+static void fname(char *buf, int i)
+{
+	sprintf(buf, "race/%i", i);
+}
+
+static void op_create(const char *f1, const char *f2 LTP_ATTRIBUTE_UNUSED)
+{
+	int fd = open(f1, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	if (fd >= 0) {
+		if (write(fd, "data", 4) < 0) {
+			/* losing a race is fine */
+		}
+		close(fd);
+	}
+}
+
+static void op_unlink(const char *f1, const char *f2 LTP_ATTRIBUTE_UNUSED)
+{
+	unlink(f1);
+}
+
+static void op_rename(const char *f1, const char *f2)
+{
+	rename(f1, f2);
+}
+
+static void op_rename_back(const char *f1, const char *f2)
+{
+	rename(f2, f1);
+}
+
+static void op_link(const char *f1, const char *f2)
+{
+	if (link(f1, f2)) {
+		/* losing a race is fine */
+	}
+}
+
+static void op_unlink2(const char *f1 LTP_ATTRIBUTE_UNUSED, const char *f2)
+{
+	unlink(f2);
+}
+
+static void op_symlink(const char *f1, const char *f2)
+{
+	if (symlink(f1, f2)) {
+		/* losing a race is fine */
+	}
+}
+
+static void op_mkdir(const char *f1, const char *f2 LTP_ATTRIBUTE_UNUSED)
+{
+	mkdir(f1, 0755);
+}
+
+static void op_rmdir(const char *f1, const char *f2 LTP_ATTRIBUTE_UNUSED)
+{
+	rmdir(f1);
+}
+
+static void op_read(const char *f1, const char *f2 LTP_ATTRIBUTE_UNUSED)
+{
+	char buf[64];
+	int fd = open(f1, O_RDONLY);
+
+	if (fd >= 0) {
+		while (read(fd, buf, sizeof(buf)) > 0);
+		close(fd);
+	}
+}
+
+static void op_trunc(const char *f1, const char *f2 LTP_ATTRIBUTE_UNUSED)
+{
+	if (truncate(f1, 0)) {
+		/* losing a race is fine */
+	}
+}
+
+static struct racer_scenario {
+	const char *name;
+	void (*op_a)(const char *f1, const char *f2);
+	void (*op_b)(const char *f1, const char *f2);
+} scenarios[] = {
+	{"create vs unlink", op_create, op_unlink},
+	{"rename vs rename", op_rename, op_rename_back},
+	{"link vs unlink", op_link, op_unlink2},
+	{"symlink vs unlink", op_symlink, op_unlink2},
+	{"mkdir vs rmdir", op_mkdir, op_rmdir},
+	{"read vs truncate", op_read, op_trunc},
+};
+
+static void pin_to_cpu(int cpu)
+{
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu % ncpus, &set);
+
+	if (sched_setaffinity(0, sizeof(set), &set))
+		tst_res(TWARN | TERRNO, "sched_setaffinity(%i)", cpu);
+}
+
+static void *thread_b(void *arg)
+{
+	char f1[PATH_MAX], f2[PATH_MAX];
+	const struct racer_scenario *sc = &scenarios[scenario];
+
+	pin_to_cpu(cpu_b);
+
+	while (tst_fzsync_run_b(&fzsync_pair)) {
+		int i = race_idx;
+
+		fname(f1, i);
+		fname(f2, (i + 1) % MAX_FILES);
+
+		tst_fzsync_start_race_b(&fzsync_pair);
+		sc->op_b(f1, f2);
+		tst_fzsync_end_race_b(&fzsync_pair);
+	}
+
+	return arg;
+}
+
+static void child_run(int idx)
+{
+	char f1[PATH_MAX], f2[PATH_MAX];
+	const struct racer_scenario *sc;
+
+	scenario = idx % (int)ARRAY_SIZE(scenarios);
+	sc = &scenarios[scenario];
+	cpu_b = 2 * idx + 1;
+
+	pin_to_cpu(2 * idx);
+	srandom(getpid());
+
+	tst_res(TINFO, "pair %i racing %s", idx, sc->name);
+
+	fzsync_pair.exec_loops = 100000;
+	tst_fzsync_pair_init(&fzsync_pair);
+	tst_fzsync_pair_reset(&fzsync_pair, thread_b);
+
+	while (tst_fzsync_run_a(&fzsync_pair)) {
+		race_idx = random() % MAX_FILES;
+
+		fname(f1, race_idx);
+		fname(f2, (race_idx + 1) % MAX_FILES);
+
+		tst_fzsync_start_race_a(&fzsync_pair);
+		sc->op_a(f1, f2);
+		tst_fzsync_end_race_a(&fzsync_pair);
+	}
+
+	tst_fzsync_pair_cleanup(&fzsync_pair);
+}
+
+static void run(void)
+{
+	int i;
+
+	for (i = 0; i < npairs; i++) {
+		if (!SAFE_FORK()) {
+			child_run(i);
+			exit(0);
+		}
+	}
+
+	tst_reap_children();
+
+	if (tst_taint_check()) {
+		tst_res(TFAIL, "Kernel tainted by the races");
+		return;
+	}
+
+	tst_res(TPASS, "Kernel survived the races");
+}
+
+static void setup(void)
+{
+	ncpus = tst_ncpus_conf();
+	npairs = MAX(1, (int)(ncpus / 2));
+
+	if (str_pairs && tst_parse_int(str_pairs, &npairs, 1, 512))
+		tst_brk(TBROK, "Invalid number of pairs '%s'", str_pairs);
+
+	tst_res(TINFO, "Running %i racing pairs over %li cpus",
+		npairs, ncpus);
+
+	SAFE_MKDIR("race", 0755);
+}
+
+static struct tst_option options[] = {
+	{"p:", &str_pairs, "-p pairs Number of racing worker pairs (default ncpus/2)"},
+	{NULL, NULL, NULL}
+};
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.forks_child = 1,
+	.options = options,
+	.setup = setup,
+	.test_all = run,
+	.taint_check = TST_TAINT_W | TST_TAINT_D,
+};
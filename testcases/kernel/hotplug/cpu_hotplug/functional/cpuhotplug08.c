@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Batched CPU hotplug stress driver.
+ *
+ * The cpuhotplug shell scripts offline/online one CPU per sysfs write with
+ * fixed sleeps in between, which makes a full soak on large boxes take
+ * hours, mostly sleeping. This driver pre-opens every hotpluggable CPU's
+ * online file once, then each cycle picks a rotating batch of CPUs and
+ * offlines/onlines them concurrently from one worker thread per CPU.
+ * Completion is detected by re-reading the online file with an adaptive
+ * poll interval (50us doubling up to 10ms) instead of fixed sleeps.
+ *
+ * Per-cycle wall times are collected and min/avg/max reported, so hotplug
+ * latency regressions show up directly in the test output.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_clocks.h"
+#include "tst_timer.h"
+
+#define SYSFS_CPU_DIR "/sys/devices/system/cpu"
+#define MAX_CPUS 4096
+
+struct hp_cpu {
+	int num;
+	int fd;
+	char orig_state;
+};
+
+struct hp_work {
+	struct hp_cpu *cpu;
+	char state;
+	int failed;
+};
+
+static char *str_loops;
+static char *str_batch;
+static int loops = 5;
+static int batch_size;
+
+static struct hp_cpu *cpus;
+static int ncpus;
+
+/*
+ * Wait until the CPU's online file reads back the wanted state. Polling
+ * starts at 50us and backs off exponentially to 10ms, so fast transitions
+ * are caught quickly without busy-spinning through slow ones.
+ */
+static int wait_cpu_state(struct hp_cpu *cpu, char state)
+{
+	useconds_t slp = 50;
+	char cur;
+	int i;
+
+	for (i = 0; i < 1000; i++) {
+		if (pread(cpu->fd, &cur, 1, 0) != 1)
+			return -1;
+		if (cur == state)
+			return 0;
+		usleep(slp);
+		if (slp < 10000)
+			slp *= 2;
+	}
+
+	return -1;
+}
+
+static void *hp_worker(void *arg)
+{
+	struct hp_work *work = arg;
+	struct hp_cpu *cpu = work->cpu;
+	int i;
+
+	for (i = 0; i < 100; i++) {
+		if (pwrite(cpu->fd, &work->state, 1, 0) == 1)
+			break;
+		/* another CPU's transition may hold the hotplug lock */
+		if (errno != EBUSY && errno != EAGAIN) {
+			tst_res(TWARN | TERRNO, "cpu%d: write '%c' failed",
+				cpu->num, work->state);
+			work->failed = 1;
+			return NULL;
+		}
+		usleep(1000);
+	}
+
+	if (wait_cpu_state(cpu, work->state)) {
+		tst_res(TWARN, "cpu%d did not reach state '%c'",
+			cpu->num, work->state);
+		work->failed = 1;
+	}
+
+	return NULL;
+}
+
+/* Drive all CPUs of the batch to the given state concurrently */
+static int set_batch_state(struct hp_cpu **batch, int n, char state)
+{
+	pthread_t threads[n];
+	struct hp_work work[n];
+	int i, failed = 0;
+
+	for (i = 0; i < n; i++) {
+		work[i].cpu = batch[i];
+		work[i].state = state;
+		work[i].failed = 0;
+		SAFE_PTHREAD_CREATE(&threads[i], NULL, hp_worker, &work[i]);
+	}
+
+	for (i = 0; i < n; i++) {
+		SAFE_PTHREAD_JOIN(threads[i], NULL);
+		failed += work[i].failed;
+	}
+
+	return failed;
+}
+
+static void do_test(void)
+{
+	struct hp_cpu *batch[batch_size];
+	struct timespec ts_start, ts_end;
+	unsigned long long cycle_us, min_us = -1ULL, max_us = 0, sum_us = 0;
+	int cycle, i, failed = 0;
+
+	for (cycle = 0; cycle < loops; cycle++) {
+		/* rotate through the CPU list so all CPUs get exercised */
+		for (i = 0; i < batch_size; i++)
+			batch[i] = &cpus[(cycle * batch_size + i) % ncpus];
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+		failed += set_batch_state(batch, batch_size, '0');
+		failed += set_batch_state(batch, batch_size, '1');
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+		cycle_us = tst_timespec_diff_us(ts_end, ts_start);
+		min_us = MIN(min_us, cycle_us);
+		max_us = MAX(max_us, cycle_us);
+		sum_us += cycle_us;
+	}
+
+	tst_res(TINFO,
+		"%i cycles of %i CPUs: min %.1fms avg %.1fms max %.1fms",
+		loops, batch_size, min_us / 1000.0,
+		sum_us / 1000.0 / loops, max_us / 1000.0);
+
+	if (failed)
+		tst_res(TFAIL, "%i hotplug transitions failed", failed);
+	else
+		tst_res(TPASS, "%i offline/online cycles completed", loops);
+}
+
+static void setup(void)
+{
+	char path[PATH_MAX];
+	int i, fd;
+
+	if (tst_parse_int(str_loops, &loops, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid loop count '%s'", str_loops);
+
+	if (tst_parse_int(str_batch, &batch_size, 1, MAX_CPUS))
+		tst_brk(TBROK, "Invalid batch size '%s'", str_batch);
+
+	cpus = SAFE_MALLOC(MAX_CPUS * sizeof(*cpus));
+
+	/*
+	 * Collect the hotpluggable CPUs; CPUs without an online file
+	 * (usually cpu0) cannot be offlined and anchor the system while
+	 * the batches cycle.
+	 */
+	for (i = 0; i < MAX_CPUS; i++) {
+		snprintf(path, sizeof(path), SYSFS_CPU_DIR "/cpu%d", i);
+		if (access(path, F_OK))
+			break;
+
+		snprintf(path, sizeof(path),
+			 SYSFS_CPU_DIR "/cpu%d/online", i);
+		fd = open(path, O_RDWR);
+		if (fd < 0)
+			continue;
+
+		cpus[ncpus].num = i;
+		cpus[ncpus].fd = fd;
+		if (pread(fd, &cpus[ncpus].orig_state, 1, 0) != 1) {
+			tst_brk(TBROK | TERRNO, "read(%s)", path);
+		}
+		ncpus++;
+	}
+
+	if (!ncpus)
+		tst_brk(TCONF, "No hotpluggable CPUs found");
+
+	if (!batch_size)
+		batch_size = MAX(1, ncpus / 2);
+	batch_size = MIN(batch_size, ncpus);
+
+	tst_res(TINFO, "%i hotpluggable CPUs, batches of %i",
+		ncpus, batch_size);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < ncpus; i++) {
+		if (pwrite(cpus[i].fd, &cpus[i].orig_state, 1, 0) != 1) {
+			tst_res(TWARN, "Failed to restore cpu%d state",
+				cpus[i].num);
+		}
+		SAFE_CLOSE(cpus[i].fd);
+	}
+
+	free(cpus);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = do_test,
+	.needs_root = 1,
+	.timeout = 900,
+	.options = (struct tst_option[]) {
+		{"l:", &str_loops, "Number of offline/online cycles (default 5)"},
+		{"b:", &str_batch, "CPUs per batch (default half of hotpluggable)"},
+		{NULL, NULL, NULL}
+	},
+};
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#ifndef COUNTER_HELPER_H
+#define COUNTER_HELPER_H
+
+/*
+ * Waits for the first number in the given /proc or /sys file to reach at
+ * least target. The file is kept open and re-read with pread() on an
+ * adaptive interval starting at 1ms and backing off to 100ms, so short
+ * waits return almost immediately while long ones do not hammer the
+ * kernel. Gives up with a TWARN when less than margin_sec of the test
+ * runtime remains. Returns the last value read.
+ */
+long tst_wait_counter_at_least(const char *path, long target,
+			       unsigned int margin_sec);
+
+#endif /* COUNTER_HELPER_H */
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Flood the evdev queue with a high-rate event storm and check the
+ * kernel's behaviour under it. A virtual mouse is driven through the
+ * paced replay engine at a configurable rate (the default 8kHz matches
+ * what high-end gaming mice produce) while the event device is read
+ * concurrently. Every injected batch must either be delivered or be
+ * accounted for by a SYN_DROPPED event; events lost without the drop
+ * being signalled mean the client can't resynchronize and is a bug.
+ */
+
+#include <linux/input.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <poll.h>
+
+#include "tst_test.h"
+#include "tst_uinput.h"
+
+static char *str_rate;
+static char *str_batches;
+static int rate = 8000;
+static int batches = 4000;
+
+static int uinput_fd = -1;
+static int evdev_fd = -1;
+static struct input_event *storm;
+
+static void build_storm(void)
+{
+	long long us;
+	int i;
+
+	storm = SAFE_MALLOC(3 * batches * sizeof(*storm));
+
+	for (i = 0; i < batches; i++) {
+		us = (long long)i * 1000000 / rate;
+
+		storm[3 * i] = (struct input_event) {
+			.time = {.tv_sec = us / 1000000,
+				 .tv_usec = us % 1000000},
+			.type = EV_REL, .code = REL_X, .value = 1,
+		};
+		storm[3 * i + 1] = storm[3 * i];
+		storm[3 * i + 1].code = REL_Y;
+		storm[3 * i + 2] = storm[3 * i];
+		storm[3 * i + 2].type = EV_SYN;
+		storm[3 * i + 2].code = SYN_REPORT;
+		storm[3 * i + 2].value = 0;
+	}
+}
+
+static void run(void)
+{
+	struct input_event ev;
+	struct pollfd pfd = {.fd = evdev_fd, .events = POLLIN};
+	int received = 0, dropped = 0;
+
+	if (!SAFE_FORK()) {
+		replay_input_events(uinput_fd, storm, 3 * batches);
+		exit(0);
+	}
+
+	while (poll(&pfd, 1, 1000) > 0) {
+		SAFE_READ(1, evdev_fd, &ev, sizeof(ev));
+
+		if (ev.type != EV_SYN)
+			continue;
+
+		if (ev.code == SYN_REPORT)
+			received++;
+		else if (ev.code == SYN_DROPPED)
+			dropped++;
+	}
+
+	tst_reap_children();
+
+	tst_res(TINFO, "%i batches injected at %iHz: %i received, %i drops signalled",
+		batches, rate, received, dropped);
+
+	if (received == batches)
+		tst_res(TPASS, "all batches delivered");
+	else if (dropped)
+		tst_res(TPASS, "queue overflow was signalled with SYN_DROPPED");
+	else
+		tst_res(TFAIL, "%i batches lost without SYN_DROPPED",
+			batches - received);
+}
+
+static void setup(void)
+{
+	char *handlers, *event;
+	char path[64];
+
+	if (tst_parse_int(str_rate, &rate, 1, 1000000))
+		tst_brk(TBROK, "Invalid event rate '%s'", str_rate);
+	if (tst_parse_int(str_batches, &batches, 1, INT_MAX / 3))
+		tst_brk(TBROK, "Invalid batch count '%s'", str_batches);
+
+	uinput_fd = open_uinput();
+	if (uinput_fd == -1)
+		tst_brk(TCONF, "uinput device driver not available");
+
+	setup_mouse_events(uinput_fd);
+	create_input_device(uinput_fd);
+
+	handlers = get_input_field_value('H');
+	if (!handlers)
+		tst_brk(TBROK, "Failed to get handlers of the virtual device");
+
+	event = strstr(handlers, "event");
+	if (!event)
+		tst_brk(TBROK, "No event device in handlers '%s'", handlers);
+
+	snprintf(path, sizeof(path), "/dev/input/event%i", atoi(event + 5));
+	free(handlers);
+
+	evdev_fd = SAFE_OPEN(path, O_RDONLY | O_NONBLOCK);
+
+	build_storm();
+}
+
+static void cleanup(void)
+{
+	free(storm);
+
+	if (evdev_fd != -1)
+		SAFE_CLOSE(evdev_fd);
+
+	if (uinput_fd != -1)
+		destroy_input_device(uinput_fd);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.needs_root = 1,
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"r:", &str_rate, "Injection rate in batches/s (default 8000)"},
+		{"c:", &str_batches, "Number of event batches (default 4000)"},
+		{NULL, NULL, NULL}
+	},
+};
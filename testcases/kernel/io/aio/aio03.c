@@ -0,0 +1,317 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * aio03 - deep-queue multi-file AIO stress
+ *
+ * aio01 and aio02 submit a handful of requests against a single file
+ * and wait for each batch synchronously, so the completion-ring paths
+ * that matter at real queue depths never see any pressure. This test
+ * keeps a configurable number of requests (default 512) in flight
+ * across many files (default 16), first writing every block and then
+ * reading everything back, verifying the sequence stamp written into
+ * each block like aio01 does for its single buffer.
+ *
+ * Completions are reaped either with batched io_getevents() or, with
+ * -e, via an eventfd attached to every iocb (IOCB_FLAG_RESFD), which
+ * is the strategy event-loop applications use. Both phases report
+ * submission/completion rates and the average io_submit() and reap
+ * batch sizes.
+ *
+ * The test uses the native io_setup()/io_submit()/io_getevents()
+ * syscalls directly so it does not depend on libaio.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <linux/aio_abi.h>
+#include <sys/eventfd.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/syscalls.h"
+
+#define BLOCK_MAGIC 0x61696f3033ULL	/* "aio03" */
+
+struct block_stamp {
+	uint64_t magic;
+	uint64_t fileno;
+	uint64_t offset;
+};
+
+struct req {
+	struct iocb iocb;
+	char *buf;
+	int fileno;
+	long long off;
+};
+
+static aio_context_t ctx;
+static struct req *reqs;
+static struct iocb **pending;
+static struct io_event *events;
+static int *free_slots;
+static int free_top;
+
+static int depth = 512;
+static int nfiles = 16;
+static int blksize = 8192;
+static long total_reqs = 20000;
+static int use_eventfd;
+static char *str_eventfd;
+static int *fds;
+static int evfd = -1;
+
+static long long submit_calls, reap_calls, events_reaped;
+
+static char *str_depth;
+static char *str_nfiles;
+static char *str_blksize;
+static char *str_total;
+
+static void stamp_block(char *buf, int fileno, long long off)
+{
+	struct block_stamp *s = (struct block_stamp *)buf;
+
+	memset(buf, 'a' + (fileno + off / blksize) % 26, blksize);
+	s->magic = BLOCK_MAGIC;
+	s->fileno = fileno;
+	s->offset = off;
+}
+
+static void verify_block(char *buf, int fileno, long long off)
+{
+	struct block_stamp *s = (struct block_stamp *)buf;
+	char fill = 'a' + (fileno + off / blksize) % 26;
+	int i;
+
+	if (s->magic != BLOCK_MAGIC || (int)s->fileno != fileno ||
+	    (long long)s->offset != off)
+		tst_brk(TFAIL, "Bad stamp in file %i at %lli", fileno, off);
+
+	for (i = sizeof(*s); i < blksize; i++) {
+		if (buf[i] != fill)
+			tst_brk(TFAIL, "Corrupt byte %i in file %i at %lli",
+				i, fileno, off);
+	}
+}
+
+static void prep_req(int slot, int opcode, long long seq)
+{
+	struct req *r = &reqs[slot];
+	int fileno = seq % nfiles;
+	long long off = (seq / nfiles) * blksize;
+
+	r->fileno = fileno;
+	r->off = off;
+
+	memset(&r->iocb, 0, sizeof(r->iocb));
+	r->iocb.aio_data = slot;
+	r->iocb.aio_lio_opcode = opcode;
+	r->iocb.aio_fildes = fds[fileno];
+	r->iocb.aio_buf = (uintptr_t)r->buf;
+	r->iocb.aio_nbytes = blksize;
+	r->iocb.aio_offset = off;
+
+	if (use_eventfd) {
+		r->iocb.aio_flags = IOCB_FLAG_RESFD;
+		r->iocb.aio_resfd = evfd;
+	}
+
+	if (opcode == IOCB_CMD_PWRITE)
+		stamp_block(r->buf, fileno, off);
+}
+
+static int reap(int min)
+{
+	struct timespec ts = { .tv_sec = 30, .tv_nsec = 0 };
+	int i, ret;
+
+	if (use_eventfd) {
+		uint64_t nready;
+
+		SAFE_READ(1, evfd, &nready, sizeof(nready));
+		min = MIN(nready, (uint64_t)depth);
+		ts.tv_sec = 0;
+	}
+
+	ret = tst_syscall(__NR_io_getevents, ctx, min, depth, events, &ts);
+	if (ret < min)
+		tst_brk(TBROK, "io_getevents() returned %i, expected %i",
+			ret, min);
+
+	reap_calls++;
+	events_reaped += ret;
+
+	for (i = 0; i < ret; i++) {
+		struct req *r = &reqs[events[i].data];
+
+		if (events[i].res != (long long)r->iocb.aio_nbytes) {
+			tst_brk(TFAIL, "Request finished with %lli, expected %i",
+				(long long)events[i].res, blksize);
+		}
+
+		if (r->iocb.aio_lio_opcode == IOCB_CMD_PREAD)
+			verify_block(r->buf, r->fileno, r->off);
+
+		free_slots[free_top++] = events[i].data;
+	}
+
+	return ret;
+}
+
+static void run_phase(int opcode, const char *name)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	long long cursor = 0, done = 0;
+
+	submit_calls = reap_calls = events_reaped = 0;
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	while (done < total_reqs) {
+		int nsub = 0, off = 0, ret;
+
+		while (free_top && cursor < total_reqs) {
+			int slot = free_slots[--free_top];
+
+			prep_req(slot, opcode, cursor++);
+			pending[nsub++] = &reqs[slot].iocb;
+		}
+
+		while (off < nsub) {
+			ret = tst_syscall(__NR_io_submit, ctx, nsub - off,
+					  pending + off);
+			if (ret < 0 && errno == EAGAIN) {
+				done += reap(1);
+				continue;
+			}
+			if (ret < 0)
+				tst_brk(TBROK | TERRNO, "io_submit()");
+			submit_calls++;
+			off += ret;
+		}
+
+		done += reap(1);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO,
+		"%s: %9.0f reqs/s, %7.1f MB/s, %4.1f reqs/submit, %5.1f events/reap",
+		name, 1000.0 * total_reqs / elapsed_ms,
+		1000.0 * total_reqs * blksize / elapsed_ms / (1024 * 1024),
+		(double)total_reqs / MAX(submit_calls, 1LL),
+		(double)events_reaped / MAX(reap_calls, 1LL));
+}
+
+static void run(void)
+{
+	run_phase(IOCB_CMD_PWRITE, "write");
+	run_phase(IOCB_CMD_PREAD, "read ");
+
+	tst_res(TPASS, "%li requests at depth %i over %i files verified",
+		total_reqs, depth, nfiles);
+}
+
+static void setup(void)
+{
+	int i, flags = O_RDWR | O_CREAT | O_DIRECT;
+	char fname[32];
+
+	if (str_depth) {
+		if (tst_parse_int(str_depth, &depth, 1, 65536))
+			tst_brk(TBROK, "Invalid queue depth '%s'", str_depth);
+	}
+
+	if (str_nfiles) {
+		if (tst_parse_int(str_nfiles, &nfiles, 1, 1024))
+			tst_brk(TBROK, "Invalid file count '%s'", str_nfiles);
+	}
+
+	if (str_blksize) {
+		if (tst_parse_int(str_blksize, &blksize, 512, 1024 * 1024))
+			tst_brk(TBROK, "Invalid block size '%s'", str_blksize);
+	}
+
+	if (str_total) {
+		if (tst_parse_long(str_total, &total_reqs, 1, LONG_MAX))
+			tst_brk(TBROK, "Invalid request count '%s'", str_total);
+	}
+
+	if (total_reqs % nfiles)
+		total_reqs += nfiles - total_reqs % nfiles;
+
+	ctx = 0;
+	if (tst_syscall(__NR_io_setup, depth, &ctx))
+		tst_brk(TBROK | TERRNO, "io_setup()");
+
+	use_eventfd = !!str_eventfd;
+	if (use_eventfd) {
+		evfd = eventfd(0, 0);
+		if (evfd == -1)
+			tst_brk(TBROK | TERRNO, "eventfd()");
+	}
+
+	fds = SAFE_MALLOC(nfiles * sizeof(int));
+	for (i = 0; i < nfiles; i++) {
+		snprintf(fname, sizeof(fname), "aiofile_%i", i);
+
+		if (i == 0 && (tst_fs_type(".") == TST_TMPFS_MAGIC)) {
+			tst_res(TINFO, "Drop O_DIRECT flag for tmpfs");
+			flags &= ~O_DIRECT;
+		}
+
+		fds[i] = SAFE_OPEN(fname, flags, 0600);
+	}
+
+	reqs = SAFE_MALLOC(depth * sizeof(struct req));
+	pending = SAFE_MALLOC(depth * sizeof(struct iocb *));
+	events = SAFE_MALLOC(depth * sizeof(struct io_event));
+	free_slots = SAFE_MALLOC(depth * sizeof(int));
+
+	for (i = 0; i < depth; i++) {
+		if (posix_memalign((void **)&reqs[i].buf, 4096, blksize))
+			tst_brk(TBROK, "posix_memalign()");
+		free_slots[i] = i;
+	}
+	free_top = depth;
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	if (ctx)
+		tst_syscall(__NR_io_destroy, ctx);
+
+	if (evfd != -1)
+		SAFE_CLOSE(evfd);
+
+	for (i = 0; fds && i < nfiles; i++) {
+		if (fds[i] > 0)
+			SAFE_CLOSE(fds[i]);
+	}
+}
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.options = (struct tst_option[]) {
+		{"d:", &str_depth, "-d N     Queue depth (default 512)"},
+		{"f:", &str_nfiles, "-f N     Number of files (default 16)"},
+		{"s:", &str_blksize, "-s N     Block size in bytes (default 8192)"},
+		{"n:", &str_total, "-n N     Total requests per phase (default 20000)"},
+		{"e", &str_eventfd, "-e       Reap completions via eventfd instead of blocking io_getevents()"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
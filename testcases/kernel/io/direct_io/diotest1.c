@@ -23,7 +23,7 @@
  *	test with raw devices as files.
  *
  * USAGE
- *	diotest1 [-b bufsize] [-n numblks] [-i infile] [-o outfile]
+ *	diotest1 [-b bufsize] [-n numblks] [-i infile] [-o outfile] [-m]
  *
  * History
  *	04/22/2002	Narasimha Sharoff nsharoff@us.ibm.com
@@ -54,6 +54,7 @@ int TST_TOTAL = 1;		/* Total number of test conditions */
 
 static char infile[LEN];	/* Input file. Default "infile" */
 static char outfile[LEN];	/* Output file. Default "outfile" */
+static int mmap_verify;		/* Verify through mmap instead of read */
 static int fd1, fd2;
 
 /*
@@ -62,7 +63,7 @@ static int fd1, fd2;
 void prg_usage(void)
 {
 	fprintf(stderr,
-		"Usage: diotest1 [-b bufsize] [-n numblks] [-i infile] [-o outfile]\n");
+		"Usage: diotest1 [-b bufsize] [-n numblks] [-i infile] [-o outfile] [-m]\n");
 	tst_brkm(TBROK, NULL, "usage");
 }
 
@@ -86,7 +87,7 @@ int main(int argc, char *argv[])
 	/* Options */
 	strcpy(infile, "infile");	/* Default input file */
 	strcpy(outfile, "outfile");	/* Default outfile file */
-	while ((i = getopt(argc, argv, "b:n:i:o:")) != -1) {
+	while ((i = getopt(argc, argv, "b:n:i:o:m")) != -1) {
 		switch (i) {
 		case 'b':
 			if ((bufsize = atoi(optarg)) <= 0) {
@@ -111,6 +112,9 @@ int main(int argc, char *argv[])
 		case 'o':
 			strcpy(outfile, optarg);
 			break;
+		case 'm':
+			mmap_verify = TRUE;
+			break;
 		default:
 			prg_usage();
 		}
@@ -153,8 +157,8 @@ int main(int argc, char *argv[])
 		SAFE_LSEEK(cleanup, fd1, offset, SEEK_SET);
 	}
 
-	/* Verify */
-	if (filecmp(infile, outfile) != 0) {
+	/* Verify, either through buffered read or through mmap */
+	if ((mmap_verify ? filecmp_mmap : filecmp) (infile, outfile) != 0) {
 		tst_brkm(TFAIL, cleanup, "file compare failed for %s and %s",
 			 infile, outfile);
 	}
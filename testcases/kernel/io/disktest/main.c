@@ -488,6 +488,7 @@ test_ll_t *run()
 		char *filespec = cleanArgs.device;
 		char *aFilespec = NULL;
 		FILE *file = NULL;
+		unsigned int target_idx = 0;
 
 		if ((aFilespec = (char *)ALLOC(80)) == NULL) {
 			pMsg(ERR, &cleanArgs,
@@ -517,6 +518,18 @@ test_ll_t *run()
 					       DEV_NAME_LEN);
 					strncpy(newTest->args->device,
 						aFilespec, strlen(aFilespec));
+					/*
+					 * With a global seed (-a) every
+					 * target gets a distinct but
+					 * deterministic seed, so any one
+					 * device of a fleet run can be
+					 * reproduced alone by passing
+					 * seed+index with a single target.
+					 */
+					if (cleanArgs.seed)
+						newTest->args->seed =
+						    cleanArgs.seed + target_idx;
+					target_idx++;
 					createChild(threadedMain, newTest);
 				} else {
 					newTest = lastTest;
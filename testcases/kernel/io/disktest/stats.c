@@ -374,6 +374,33 @@ void print_stats(child_args_t * args, test_env_t * env, statop_t operation)
 	}
 }
 
+/*
+ * Prints the aggregate of the per-target totals once all the worker
+ * groups of a multi-target (-F) run have finished, so a fleet burn-in
+ * gets one combined bandwidth/IO line on top of the per-device totals.
+ * The throughput is normalized over the overall runtime since the
+ * targets ran concurrently.
+ */
+void print_fleet_stats(stats_t * total, int ntargets)
+{
+	extern child_args_t cleanArgs;
+	extern time_t global_start_time;
+
+	time_t runtime = time(NULL) - global_start_time;
+
+	if (runtime == 0)
+		runtime++;
+
+	pMsg(STAT, &cleanArgs,
+	     "Fleet Total (%d targets): Read %lld IOs, %lld bytes, %0.1fMB/s\n",
+	     ntargets, (long long)total->rcount, (long long)total->rbytes,
+	     ((double)total->rbytes / (double)runtime) / 1048576.0);
+	pMsg(STAT, &cleanArgs,
+	     "Fleet Total (%d targets): Write %lld IOs, %lld bytes, %0.1fMB/s\n",
+	     ntargets, (long long)total->wcount, (long long)total->wbytes,
+	     ((double)total->wbytes / (double)runtime) / 1048576.0);
+}
+
 void update_gbl_stats(test_env_t * env)
 {
 	env->global_stats.wcount += env->cycle_stats.wcount;
@@ -89,6 +89,7 @@ typedef enum statop {
 
 
 void print_stats(child_args_t *, test_env_t *, statop_t);
+void print_fleet_stats(stats_t *, int);
 void update_gbl_stats(test_env_t *);
 void update_cyc_stats(test_env_t *);
 
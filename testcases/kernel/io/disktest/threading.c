@@ -120,6 +120,7 @@
 #include "main.h"
 #include "childmain.h"
 #include "threading.h"
+#include "stats.h"
 
 /*
  * This routine will sit waiting for all threads to exit.  In
@@ -198,15 +199,32 @@ void cleanUp(test_ll_t * test)
 {
 	test_ll_t *pTmpTest = test;
 	test_ll_t *pLastTest;
+	stats_t fleet_total;
+	int ntargets = 0;
+
+	memset(&fleet_total, 0, sizeof(fleet_total));
+
 	while (pTmpTest != NULL) {
 		pLastTest = pTmpTest;
 		pTmpTest = pTmpTest->next;
 		closeThread(pLastTest->hThread);
+
+		fleet_total.wcount += pLastTest->env->global_stats.wcount;
+		fleet_total.rcount += pLastTest->env->global_stats.rcount;
+		fleet_total.wbytes += pLastTest->env->global_stats.wbytes;
+		fleet_total.rbytes += pLastTest->env->global_stats.rbytes;
+		fleet_total.wtime += pLastTest->env->global_stats.wtime;
+		fleet_total.rtime += pLastTest->env->global_stats.rtime;
+		ntargets++;
+
 		FREE(pLastTest->env->action_list);
 		FREE(pLastTest->args);
 		FREE(pLastTest->env);
 		FREE(pLastTest);
 	}
+
+	if (ntargets > 1)
+		print_fleet_stats(&fleet_total, ntargets);
 }
 
 hThread_t spawnThread(void *function, void *param)
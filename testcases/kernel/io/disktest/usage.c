@@ -44,7 +44,9 @@ void usage(void)
 	printf
 	    ("\t-E cmp_len\tTurn on error checking comparing <cmp_len> bytes.\n");
 	printf("\t-f byte\t\tUse a fixed data pattern up to 8 bytes.\n");
-	printf("\t-F \t\tfilespec is a file describing a list of targets\n");
+	printf("\t-F \t\tfilespec is a file describing a list of targets,\n");
+	printf("\t\t\ttested concurrently; totals are aggregated over all\n");
+	printf("\t\t\ttargets and with -a each target seeds with seed+index\n");
 	printf
 	    ("\t-h hbeat\tDisplays performance statistic every <hbeat> seconds.\n");
 	printf("\t-I IO_type\tSet the data transfer type to IO_type.\n");
@@ -0,0 +1,464 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Sweeps O_DIRECT async writes over a list of queue depths and verifies
+ * the written data after each sweep point. The suite historically pinned
+ * libaio at shallow fixed depths; corruption tends to show up at deep
+ * queues, so the depth is a parameter here and the same write-and-verify
+ * logic runs on two submission backends:
+ *
+ *  - variant 0: libaio (io_submit/io_getevents)
+ *  - variant 1: io_uring (IORING_OP_WRITEV)
+ *
+ * Every block is stamped with its file offset in each 64bit word, so a
+ * block written to the wrong place or filled from the wrong buffer fails
+ * verification. The achieved IOPS and bandwidth are reported per depth,
+ * which maps a device's behaviour over its async operating points.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <limits.h>
+
+#include "config.h"
+#include "tst_test.h"
+#include "tst_clocks.h"
+#include "tst_timer.h"
+
+#ifdef HAVE_LIBAIO
+#include <libaio.h>
+#endif
+
+#include "lapi/io_uring.h"
+
+#define TEST_FILE "aiodio_depth_file"
+#define MAX_DEPTH 1024
+
+static char *str_depths;
+static char *str_writesize;
+static char *str_filesize;
+
+static int writesize = 64 * 1024;
+static int filesize = 16 * 1024 * 1024;
+static int depths[32] = {1, 4, 16, 64};
+static unsigned int ndepths = 4;
+
+static int fd = -1;
+static char **bufs;
+static int nbufs;
+
+static void stamp_block(char *buf, long long off)
+{
+	long long *p = (long long *)buf;
+	int i;
+
+	for (i = 0; i < (int)(writesize / sizeof(long long)); i++)
+		p[i] = off + (long long)i * sizeof(long long);
+}
+
+static int check_block(const char *buf, long long off)
+{
+	const long long *p = (const long long *)buf;
+	int i;
+
+	for (i = 0; i < (int)(writesize / sizeof(long long)); i++) {
+		if (p[i] != off + (long long)(i * sizeof(long long))) {
+			tst_res(TFAIL,
+				"Wrong data at offset %lld word %i: %llx",
+				off, i, (unsigned long long)p[i]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int verify_file(void)
+{
+	long long off;
+	int broken = 0;
+
+	for (off = 0; off < filesize; off += writesize) {
+		if (pread(fd, bufs[0], writesize, off) != writesize)
+			tst_brk(TBROK | TERRNO, "pread() at %lld", off);
+
+		broken += check_block(bufs[0], off);
+	}
+
+	return broken;
+}
+
+static void report_depth(int depth, unsigned long long usec)
+{
+	unsigned long long blocks = filesize / writesize;
+
+	if (!usec)
+		usec = 1;
+
+	tst_res(TINFO, "depth %4i: %8llu IOPS, %6llu MB/s",
+		depth, blocks * 1000000 / usec,
+		(unsigned long long)filesize / usec);
+}
+
+#ifdef HAVE_LIBAIO
+/*
+ * Writes the whole file keeping 'depth' requests in flight and returns
+ * the elapsed time of the write phase in microseconds.
+ */
+static unsigned long long write_libaio(int depth)
+{
+	struct iocb *iocbs[MAX_DEPTH];
+	struct io_event event;
+	struct timespec start, end;
+	io_context_t ctx;
+	long long off = 0;
+	int i, ret, inflight;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ret = io_queue_init(depth, &ctx);
+	if (ret)
+		tst_brk(TBROK, "io_queue_init(%i): %s", depth,
+			tst_strerrno(-ret));
+
+	for (i = 0; i < depth && off < filesize; i++) {
+		iocbs[i] = SAFE_MALLOC(sizeof(struct iocb));
+		stamp_block(bufs[i], off);
+		io_prep_pwrite(iocbs[i], fd, bufs[i], writesize, off);
+		off += writesize;
+	}
+	inflight = i;
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &start);
+
+	ret = io_submit(ctx, inflight, iocbs);
+	if (ret != inflight)
+		tst_brk(TBROK, "io_submit(): %s", tst_strerrno(-ret));
+
+	while (inflight) {
+		struct iocb *iocbp;
+
+		ret = io_getevents(ctx, 1, 1, &event, NULL);
+		if (ret != 1) {
+			if (-ret == EINTR)
+				continue;
+			tst_brk(TBROK, "io_getevents(): %s",
+				tst_strerrno(-ret));
+		}
+
+		iocbp = (struct iocb *)event.obj;
+
+		if (event.res2 || event.res != (unsigned long)writesize) {
+			tst_brk(TBROK, "AIO write at %lld returned %li/%li",
+				(long long)iocbp->u.c.offset,
+				(long)event.res, (long)event.res2);
+		}
+
+		inflight--;
+
+		if (off < filesize) {
+			stamp_block(iocbp->u.c.buf, off);
+			io_prep_pwrite(iocbp, fd, iocbp->u.c.buf,
+				       writesize, off);
+			off += writesize;
+
+			ret = io_submit(ctx, 1, &iocbp);
+			if (ret != 1)
+				tst_brk(TBROK, "io_submit(): %s",
+					tst_strerrno(-ret));
+			inflight++;
+		}
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &end);
+
+	io_queue_release(ctx);
+
+	return tst_timespec_diff_us(end, start);
+}
+#endif /* HAVE_LIBAIO */
+
+struct uring_ring {
+	int fd;
+	void *sq_ptr, *cq_ptr;
+	size_t sq_len, cq_len;
+	struct io_uring_sqe *sqes;
+	unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned int *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_cqe *cqes;
+};
+
+static void uring_init(struct uring_ring *r, int depth)
+{
+	struct io_uring_params p;
+
+	memset(&p, 0, sizeof(p));
+	memset(r, 0, sizeof(*r));
+
+	r->fd = io_uring_setup(depth, &p);
+	if (r->fd == -1)
+		tst_brk(TBROK | TERRNO, "io_uring_setup(%i)", depth);
+
+	r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	r->sq_ptr = SAFE_MMAP(0, r->sq_len, PROT_READ | PROT_WRITE,
+			      MAP_SHARED | MAP_POPULATE, r->fd,
+			      IORING_OFF_SQ_RING);
+	r->sq_head = r->sq_ptr + p.sq_off.head;
+	r->sq_tail = r->sq_ptr + p.sq_off.tail;
+	r->sq_mask = r->sq_ptr + p.sq_off.ring_mask;
+	r->sq_array = r->sq_ptr + p.sq_off.array;
+
+	r->sqes = SAFE_MMAP(0, p.sq_entries * sizeof(struct io_uring_sqe),
+			    PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, r->fd,
+			    IORING_OFF_SQES);
+
+	r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	r->cq_ptr = SAFE_MMAP(0, r->cq_len, PROT_READ | PROT_WRITE,
+			      MAP_SHARED | MAP_POPULATE, r->fd,
+			      IORING_OFF_CQ_RING);
+	r->cq_head = r->cq_ptr + p.cq_off.head;
+	r->cq_tail = r->cq_ptr + p.cq_off.tail;
+	r->cq_mask = r->cq_ptr + p.cq_off.ring_mask;
+	r->cqes = r->cq_ptr + p.cq_off.cqes;
+}
+
+static void uring_exit(struct uring_ring *r)
+{
+	SAFE_MUNMAP(r->sqes, (*r->sq_mask + 1) * sizeof(struct io_uring_sqe));
+	SAFE_MUNMAP(r->cq_ptr, r->cq_len);
+	SAFE_MUNMAP(r->sq_ptr, r->sq_len);
+	SAFE_CLOSE(r->fd);
+}
+
+static void uring_queue_write(struct uring_ring *r, struct iovec *iov,
+			      int slot, long long off)
+{
+	unsigned int tail = *r->sq_tail;
+	unsigned int index = tail & *r->sq_mask;
+	struct io_uring_sqe *sqe = &r->sqes[index];
+
+	stamp_block(iov->iov_base, off);
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_WRITEV;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long)iov;
+	sqe->len = 1;
+	sqe->off = off;
+	sqe->user_data = slot;
+
+	r->sq_array[index] = index;
+	*r->sq_tail = tail + 1;
+}
+
+static unsigned long long write_uring(int depth)
+{
+	struct uring_ring ring;
+	struct iovec iovs[MAX_DEPTH];
+	struct timespec start, end;
+	long long off = 0;
+	int i, ret, inflight = 0, to_submit = 0;
+
+	uring_init(&ring, depth);
+
+	for (i = 0; i < depth; i++) {
+		iovs[i].iov_base = bufs[i];
+		iovs[i].iov_len = writesize;
+	}
+
+	for (i = 0; i < depth && off < filesize; i++) {
+		uring_queue_write(&ring, &iovs[i], i, off);
+		off += writesize;
+		to_submit++;
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (to_submit || inflight) {
+		ret = io_uring_enter(ring.fd, to_submit, inflight ? 1 : 0,
+				     inflight ? IORING_ENTER_GETEVENTS : 0,
+				     NULL);
+		if (ret < 0)
+			tst_brk(TBROK | TERRNO, "io_uring_enter()");
+
+		inflight += ret;
+		to_submit -= ret;
+
+		while (*ring.cq_head != *ring.cq_tail) {
+			unsigned int index = *ring.cq_head & *ring.cq_mask;
+			struct io_uring_cqe *cqe = &ring.cqes[index];
+			int slot = cqe->user_data;
+
+			if (cqe->res != writesize) {
+				tst_brk(TBROK, "io_uring write returned %i: %s",
+					cqe->res,
+					cqe->res < 0 ?
+					tst_strerrno(-cqe->res) : "short write");
+			}
+
+			(*ring.cq_head)++;
+			inflight--;
+
+			if (off < filesize) {
+				uring_queue_write(&ring, &iovs[slot], slot, off);
+				off += writesize;
+				to_submit++;
+			}
+		}
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &end);
+
+	uring_exit(&ring);
+
+	return tst_timespec_diff_us(end, start);
+}
+
+static void run(void)
+{
+	unsigned long long usec = 0;
+	unsigned int i;
+	int depth;
+
+	for (i = 0; i < ndepths; i++) {
+		depth = depths[i];
+
+		if ((long long)depth * writesize > filesize)
+			depth = filesize / writesize;
+
+		switch (tst_variant) {
+#ifdef HAVE_LIBAIO
+		case 0:
+			usec = write_libaio(depth);
+		break;
+#endif
+		case 1:
+			usec = write_uring(depth);
+		break;
+		default:
+			tst_brk(TBROK, "Invalid variant %i", tst_variant);
+		}
+
+		report_depth(depth, usec);
+
+		if (verify_file()) {
+			tst_res(TFAIL, "Data corrupted at depth %i", depth);
+			return;
+		}
+	}
+
+	tst_res(TPASS, "Data verified after each of %u depths", ndepths);
+}
+
+static void parse_depths(void)
+{
+	char *str, *tok;
+	int val;
+
+	if (!str_depths)
+		return;
+
+	ndepths = 0;
+	str = SAFE_MALLOC(strlen(str_depths) + 1);
+	strcpy(str, str_depths);
+
+	for (tok = strtok(str, ","); tok; tok = strtok(NULL, ",")) {
+		if (ndepths >= ARRAY_SIZE(depths))
+			tst_brk(TBROK, "Too many queue depths");
+
+		if (tst_parse_int(tok, &val, 1, MAX_DEPTH))
+			tst_brk(TBROK, "Invalid queue depth '%s'", tok);
+
+		depths[ndepths++] = val;
+	}
+
+	free(str);
+
+	if (!ndepths)
+		tst_brk(TBROK, "Empty queue depth list");
+}
+
+static void setup(void)
+{
+	unsigned int i;
+	int maxdepth = 1;
+
+	if (tst_parse_int(str_writesize, &writesize, 512, INT_MAX))
+		tst_brk(TBROK, "Invalid write size '%s'", str_writesize);
+
+	if (writesize % 512 || writesize % sizeof(long long))
+		tst_brk(TBROK, "Write size must be sector aligned");
+
+	if (tst_parse_int(str_filesize, &filesize, writesize, INT_MAX))
+		tst_brk(TBROK, "Invalid file size '%s'", str_filesize);
+
+	filesize -= filesize % writesize;
+
+	parse_depths();
+
+	switch (tst_variant) {
+	case 0:
+#ifndef HAVE_LIBAIO
+		tst_brk(TCONF, "test requires libaio and its development packages");
+#else
+		tst_res(TINFO, "Testing libaio backend");
+#endif
+	break;
+	case 1:
+		io_uring_setup_supported_by_kernel();
+		tst_res(TINFO, "Testing io_uring backend");
+	break;
+	}
+
+	fd = open(TEST_FILE, O_RDWR | O_CREAT | O_DIRECT, 0600);
+	if (fd == -1) {
+		if (errno == EINVAL)
+			tst_brk(TCONF,
+				"O_DIRECT not supported on the tmpdir filesystem");
+		tst_brk(TBROK | TERRNO, "open(" TEST_FILE ")");
+	}
+
+	for (i = 0; i < ndepths; i++) {
+		if (depths[i] > maxdepth)
+			maxdepth = depths[i];
+	}
+
+	nbufs = MIN(maxdepth, filesize / writesize);
+	bufs = SAFE_MALLOC(nbufs * sizeof(char *));
+	for (i = 0; i < (unsigned int)nbufs; i++)
+		bufs[i] = SAFE_MEMALIGN(4096, writesize);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	if (bufs) {
+		for (i = 0; i < nbufs; i++)
+			free(bufs[i]);
+		free(bufs);
+	}
+
+	if (fd != -1)
+		SAFE_CLOSE(fd);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+	.test_variants = 2,
+	.needs_tmpdir = 1,
+	.options = (struct tst_option[]) {
+		{"q:", &str_depths, "Comma-separated queue depth list (default 1,4,16,64)"},
+		{"w:", &str_writesize, "Write (block) size in bytes (default 64k)"},
+		{"s:", &str_filesize, "File size in bytes (default 16M)"},
+		{NULL, NULL, NULL}
+	},
+};
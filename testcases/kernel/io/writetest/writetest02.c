@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * writetest02 - O_DIRECT vectored write integrity test
+ *
+ * writetest verifies sequential write integrity with single buffered
+ * 1MB write() calls and a separate read-back pass, which is far too
+ * slow to cover a modern device. This test keeps the idea - every
+ * byte on disk is regenerable from a seed and its position - but runs
+ * at device bandwidth:
+ *
+ *  - blocks are written with O_DIRECT pwritev() batches, so there is
+ *    no page-cache copy and one syscall covers many blocks,
+ *
+ *  - each block carries its sequence number; the payload is generated
+ *    from (seed, block number), so any block can be verified on its
+ *    own and misplaced writes show up as stamp mismatches rather than
+ *    silent data rotation,
+ *
+ *  - verification is overlapped: while the writer fills batch N+1,
+ *    worker threads read back and verify batch N through their own
+ *    O_DIRECT descriptors, so the verify pass costs no extra wall
+ *    time on devices with read bandwidth to spare.
+ *
+ * Both the write and verify rates are reported.
+ */
+
+#define _GNU_SOURCE
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+
+#define FILE_OUT "fileout"
+#define BLOCKSIZE (1024 * 1024)
+#define BLOCK_MAGIC 0x77743032ULL	/* "wt02" */
+
+struct block_stamp {
+	uint64_t magic;
+	uint64_t blockno;
+	uint64_t seed;
+};
+
+static long num_blocks = 64;
+static int batch_blocks = 8;
+static int nthreads = 2;
+static long seed;
+static int open_flags = O_RDWR | O_CREAT | O_TRUNC | O_DIRECT;
+
+static struct tst_thread_pool *pool;
+static char **wbufs;
+static long long verify_ms;
+
+static char *str_blocks;
+static char *str_batch;
+static char *str_threads;
+static char *str_seed;
+
+/*
+ * Cheap per-word generator; every word depends on the seed, the block
+ * number and its offset, so no two blocks ever hold the same payload.
+ */
+static inline uint64_t pattern_word(uint64_t blockno, uint64_t word)
+{
+	uint64_t x = seed ^ (blockno << 24) ^ word;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return x;
+}
+
+static void fill_block(char *buf, long blockno)
+{
+	struct block_stamp *s = (struct block_stamp *)buf;
+	uint64_t *p = (uint64_t *)buf;
+	size_t w;
+
+	for (w = sizeof(*s) / 8; w < BLOCKSIZE / 8; w++)
+		p[w] = pattern_word(blockno, w);
+
+	s->magic = BLOCK_MAGIC;
+	s->blockno = blockno;
+	s->seed = seed;
+}
+
+static void check_block(char *buf, long blockno)
+{
+	struct block_stamp *s = (struct block_stamp *)buf;
+	uint64_t *p = (uint64_t *)buf;
+	size_t w;
+
+	if (s->magic != BLOCK_MAGIC || (long)s->blockno != blockno ||
+	    (long)s->seed != seed) {
+		tst_brk(TFAIL, "Bad stamp in block %ld: got block %llu seed %llu",
+			blockno, (unsigned long long)s->blockno,
+			(unsigned long long)s->seed);
+	}
+
+	for (w = sizeof(*s) / 8; w < BLOCKSIZE / 8; w++) {
+		if (p[w] != pattern_word(blockno, w)) {
+			tst_brk(TFAIL, "Mismatch in block %ld at +%zu bytes",
+				blockno, w * 8);
+		}
+	}
+}
+
+/*
+ * Reads back and verifies one batch of blocks; runs on the pool
+ * threads concurrently with the writer. Each thread keeps its own
+ * O_DIRECT descriptor and read buffer.
+ */
+static void verify_batch(void *arg)
+{
+	static __thread int fd = -1;
+	static __thread char *buf;
+	long batch = (long)(uintptr_t)arg;
+	long first = batch * batch_blocks;
+	long cnt = MIN((long)batch_blocks, num_blocks - first);
+	struct timespec t1, t2;
+	long b;
+
+	if (fd == -1) {
+		fd = SAFE_OPEN(FILE_OUT, open_flags & O_DIRECT ?
+			       O_RDONLY | O_DIRECT : O_RDONLY);
+		buf = SAFE_MEMALIGN(getpagesize(), BLOCKSIZE);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (b = first; b < first + cnt; b++) {
+		if (pread(fd, buf, BLOCKSIZE, b * (off_t)BLOCKSIZE) != BLOCKSIZE)
+			tst_brk(TBROK | TERRNO, "pread() block %ld", b);
+		check_block(buf, b);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	__sync_fetch_and_add(&verify_ms, tst_timespec_diff_ms(t2, t1));
+}
+
+static void run(void)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	struct iovec *iov;
+	long batch, nbatches;
+	int fd, i;
+
+	fd = SAFE_OPEN(FILE_OUT, open_flags, 0644);
+	iov = SAFE_MALLOC(batch_blocks * sizeof(struct iovec));
+	verify_ms = 0;
+
+	pool = SAFE_THREAD_POOL_CREATE(nthreads, verify_batch);
+	nbatches = (num_blocks + batch_blocks - 1) / batch_blocks;
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (batch = 0; batch < nbatches; batch++) {
+		long first = batch * batch_blocks;
+		long cnt = MIN((long)batch_blocks, num_blocks - first);
+		ssize_t written;
+
+		for (i = 0; i < cnt; i++) {
+			fill_block(wbufs[i], first + i);
+			iov[i].iov_base = wbufs[i];
+			iov[i].iov_len = BLOCKSIZE;
+		}
+
+		written = pwritev(fd, iov, cnt, first * (off_t)BLOCKSIZE);
+		if (written != cnt * (ssize_t)BLOCKSIZE)
+			tst_brk(TBROK | TERRNO, "pwritev() batch %ld", batch);
+
+		SAFE_THREAD_POOL_SUBMIT(pool, (void *)(uintptr_t)batch);
+	}
+
+	SAFE_THREAD_POOL_DRAIN(pool);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	SAFE_THREAD_POOL_DESTROY(pool);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO,
+		"wrote and verified %ld MB in %llims (%7.1f MB/s), verify readback %7.1f MB/s",
+		num_blocks, elapsed_ms, 1000.0 * num_blocks / elapsed_ms,
+		1000.0 * num_blocks / MAX(verify_ms, 1LL));
+
+	tst_res(TPASS, "%ld blocks written and verified", num_blocks);
+
+	SAFE_CLOSE(fd);
+	free(iov);
+	SAFE_UNLINK(FILE_OUT);
+}
+
+static void setup(void)
+{
+	int i;
+
+	seed = time(NULL);
+
+	if (str_blocks) {
+		if (tst_parse_long(str_blocks, &num_blocks, 1, LONG_MAX))
+			tst_brk(TBROK, "Invalid block count '%s'", str_blocks);
+	}
+
+	if (str_batch) {
+		if (tst_parse_int(str_batch, &batch_blocks, 1, IOV_MAX))
+			tst_brk(TBROK, "Invalid batch size '%s'", str_batch);
+	}
+
+	if (str_threads) {
+		if (tst_parse_int(str_threads, &nthreads, 1, 512))
+			tst_brk(TBROK, "Invalid thread count '%s'", str_threads);
+	}
+
+	if (str_seed) {
+		if (tst_parse_long(str_seed, &seed, 0, LONG_MAX))
+			tst_brk(TBROK, "Invalid seed '%s'", str_seed);
+	}
+
+	tst_res(TINFO, "Seed: %ld", seed);
+
+	if (tst_fs_type(".") == TST_TMPFS_MAGIC) {
+		tst_res(TINFO, "Drop O_DIRECT flag for tmpfs");
+		open_flags &= ~O_DIRECT;
+	}
+
+	wbufs = SAFE_MALLOC(batch_blocks * sizeof(char *));
+	for (i = 0; i < batch_blocks; i++)
+		wbufs[i] = SAFE_MEMALIGN(getpagesize(), BLOCKSIZE);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	for (i = 0; wbufs && i < batch_blocks; i++)
+		free(wbufs[i]);
+	free(wbufs);
+}
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.options = (struct tst_option[]) {
+		{"b:", &str_blocks, "-b N     Number of 1MB blocks to write (default 64)"},
+		{"c:", &str_batch, "-c N     Blocks per pwritev() batch (default 8)"},
+		{"t:", &str_threads, "-t N     Concurrent verifier threads (default 2)"},
+		{"s:", &str_seed, "-s seed  Pattern seed (default: timestamp)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * mq_perf01 - POSIX message queue latency and throughput benchmark
+ *
+ * The mq_* syscall tests are strictly pass/fail, so a slower but still
+ * correct mqueue wakeup path goes unnoticed. This benchmark forks a
+ * partner process and, for a series of queue depths, measures
+ *
+ *  - the mq_timedsend()/mq_timedreceive() ping-pong round-trip latency
+ *    as percentiles from the histogram framework, which is dominated by
+ *    the sleeping-receiver wakeup path, and
+ *
+ *  - the saturation throughput with the sender running far enough ahead
+ *    to keep the queue full, which exercises the non-blocking fast
+ *    path.
+ *
+ * The depth sweep matters because the two paths trade places as the
+ * queue gets deeper: with depth one every message takes the wakeup
+ * path.
+ */
+
+#include <mqueue.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+#include "libmqbench.h"
+
+#define MSG_MAX_PATH "/proc/sys/fs/mqueue/msg_max"
+
+static const long depths[] = { 1, 8, 64, 512 };
+
+static struct tst_hist hist;
+static long msgsize = 64;
+static int lat_iters = 5000;
+static int tp_iters = 50000;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+static char *sndbuf;
+static char *rcvbuf;
+
+static char *str_msgsize;
+static char *str_lat_iters;
+static char *str_tp_iters;
+static char *str_bits;
+
+static void partner(mqd_t req, mqd_t resp)
+{
+	int i;
+
+	for (i = 0; i < lat_iters; i++) {
+		MQBENCH_RECV(req, rcvbuf, msgsize);
+		MQBENCH_SEND(resp, sndbuf, msgsize);
+	}
+
+	for (i = 0; i < tp_iters; i++)
+		MQBENCH_RECV(req, rcvbuf, msgsize);
+
+	MQBENCH_SEND(resp, sndbuf, msgsize);
+}
+
+static void bench_depth(long depth)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	mqd_t req, resp;
+	int i;
+
+	req = MQBENCH_OPEN(depth, msgsize);
+	resp = MQBENCH_OPEN(depth, msgsize);
+
+	if (!SAFE_FORK()) {
+		partner(req, resp);
+		exit(0);
+	}
+
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < lat_iters; i++) {
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		MQBENCH_SEND(req, sndbuf, msgsize);
+		MQBENCH_RECV(resp, rcvbuf, msgsize);
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		tst_hist_add(&hist, tst_timespec_diff_ns(t2, t1));
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (i = 0; i < tp_iters; i++)
+		MQBENCH_SEND(req, sndbuf, msgsize);
+	MQBENCH_RECV(resp, rcvbuf, msgsize);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	tst_reap_children();
+
+	if (mq_close(req) || mq_close(resp))
+		tst_brk(TBROK | TERRNO, "mq_close()");
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO,
+		"depth %4ld: rtt p50 %7lldns, p99 %7lldns, p99.9 %7lldns, %8.0f msgs/s",
+		depth,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9),
+		1000.0 * tp_iters / elapsed_ms);
+}
+
+static void run(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(depths); i++)
+		bench_depth(depths[i]);
+
+	tst_res(TPASS, "mqueue latency and throughput measured across %zu queue depths",
+		ARRAY_SIZE(depths));
+}
+
+static void setup(void)
+{
+	long msg_max;
+
+	if (str_msgsize) {
+		if (tst_parse_long(str_msgsize, &msgsize, 1, 8192))
+			tst_brk(TBROK, "Invalid message size '%s'",
+				str_msgsize);
+	}
+
+	if (str_lat_iters) {
+		if (tst_parse_int(str_lat_iters, &lat_iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid round-trip count '%s'",
+				str_lat_iters);
+	}
+
+	if (str_tp_iters) {
+		if (tst_parse_int(str_tp_iters, &tp_iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid throughput message count '%s'",
+				str_tp_iters);
+	}
+
+	if (str_bits) {
+		if (tst_parse_int(str_bits, &hist_bits, 1, 16))
+			tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+	}
+
+	/* raise fs.mqueue.msg_max to cover the deepest queue */
+	SAFE_FILE_SCANF(MSG_MAX_PATH, "%ld", &msg_max);
+	if (msg_max < depths[ARRAY_SIZE(depths) - 1])
+		SAFE_FILE_PRINTF(MSG_MAX_PATH, "%ld",
+				 depths[ARRAY_SIZE(depths) - 1]);
+
+	sndbuf = SAFE_MALLOC(msgsize);
+	rcvbuf = SAFE_MALLOC(msgsize);
+	memset(sndbuf, 'm', msgsize);
+
+	tst_hist_init(&hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	free(sndbuf);
+	free(rcvbuf);
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.needs_root = 1,
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"s:", &str_msgsize, "-s N     Message size in bytes (default 64)"},
+		{"r:", &str_lat_iters, "-r N     Round trips per queue depth (default 5000)"},
+		{"m:", &str_tp_iters, "-m N     Throughput messages per queue depth (default 50000)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+	.save_restore = (const char * const[]) {
+		"?" MSG_MAX_PATH,
+		NULL,
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -35,12 +35,14 @@
  *  This tool can be used to beat on system or named pipes.
  *  See the help() function below for user information.
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/param.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <errno.h>
@@ -52,6 +54,7 @@
 
 #include "test.h"
 #include "safe_macros.h"
+#include "lapi/fcntl.h"
 #include "lapi/sem.h"
 
 char *TCID = "pipeio";
@@ -85,6 +88,9 @@ static void cleanup(void);
 
 static void do_child(void);
 static void do_parent(void);
+static void do_parent_splice(void);
+static int vmsplice_write(int fd, const char *buf, int nbytes);
+static void set_pipe_size(int fd);
 
 static void help(void), usage(void), prt_examples(void);
 static void prt_buf(char **addr, char *buf, int length, int format);
@@ -114,6 +120,9 @@ static char *pipe_type;		/* type of pipe under test */
 static int format = HEX;
 static int format_size = -1;
 static int iotype;		/* sync io */
+static int pipe_size;		/* F_SETPIPE_SZ target, zero means default */
+static int zero_copy_write;	/* children write via vmsplice() */
+static int zero_copy_read;	/* parent drains via splice() to /dev/null */
 
 /* variables will be modified in running */
 static int error;
@@ -122,6 +131,7 @@ static int read_fd;
 static int write_fd;
 static int empty_read;
 static int sem_id;
+static long long total_bytes;	/* bytes the parent consumed from the pipe */
 
 static union semun u;
 
@@ -187,7 +197,7 @@ static int parse_options(int argc, char *argv[])
 	int ret = 0;
 	static double d;
 
-	while ((c = getopt(argc, argv, "T:bc:D:he:Ef:i:I:ln:p:qs:uvW:w:"))
+	while ((c = getopt(argc, argv, "T:bc:D:he:Ef:i:I:ln:p:qS:s:uvW:w:zZ"))
 	       != -1) {
 		switch (c) {
 		case 'T':
@@ -337,6 +347,18 @@ static int parse_options(int argc, char *argv[])
 				ret = 1;
 			}
 			break;
+		case 'S':	/* pipe size */
+			if (sscanf(optarg, "%d", &pipe_size) != 1) {
+				fprintf(stderr,
+					"%s: --S option invalid arg '%s'.\n",
+					TCID, optarg);
+				ret = 1;
+			} else if (pipe_size <= 0) {
+				fprintf(stderr, "%s: --S option must be greater"
+					" than zero.\n", TCID);
+				ret = 1;
+			}
+			break;
 		case 'u':
 			unpipe = 1;	/* un-named pipe */
 			break;
@@ -371,6 +393,12 @@ static int parse_options(int argc, char *argv[])
 			}
 			chld_wait = (int)(d * 1000000.0);
 			break;
+		case 'z':	/* zero-copy writes */
+			zero_copy_write = 1;
+			break;
+		case 'Z':	/* zero-copy reads */
+			zero_copy_read = 1;
+			break;
 		case '?':
 			ret = 1;
 			break;
@@ -476,10 +504,35 @@ static void setup(int argc, char *argv[])
 		write_fd = fds[1];
 		pipe_type = PIPE_UNNAMED;
 		blk_type = UNNAMED_IO;
+		set_pipe_size(write_fd);
 	} else {
 		SAFE_MKFIFO(cleanup, pname, 0777);
 		pipe_type = PIPE_NAMED;
 	}
+
+	if (zero_copy_read)
+		tst_resm(TINFO, "splice consumer mode, data verification "
+			 "is disabled");
+}
+
+/*
+ * Grow (or shrink) the pipe buffer with F_SETPIPE_SZ.  The kernel
+ * rounds the request up to a power-of-two number of pages; the value
+ * reported is what it actually granted.
+ */
+static void set_pipe_size(int fd)
+{
+	int sz;
+
+	if (!pipe_size)
+		return;
+
+	sz = fcntl(fd, F_SETPIPE_SZ, pipe_size);
+	if (sz < 0) {
+		tst_brkm(TBROK | TERRNO, cleanup,
+			 "fcntl(F_SETPIPE_SZ, %d) failed", pipe_size);
+	}
+	tst_resm(TINFO, "pipe buffer size set to %d bytes", sz);
 }
 
 static void cleanup(void)
@@ -550,8 +603,20 @@ static void do_child(void)
 		*count_word = j;
 		*pid_word = self_pid;
 
-		nb = lio_write_buffer(write_fd, iotype, writebuf, size,
-				      SIGUSR1, &cp, 0);
+		/*
+		 * vmsplice() maps the writebuf pages into the pipe without
+		 * copying them.  Only the count/pid words are rewritten
+		 * between passes and check_rw_buf() skips them, so mutating
+		 * the buffer while previous pages are still in flight
+		 * cannot produce false miscompares.
+		 */
+		if (zero_copy_write) {
+			cp = "vmsplice";
+			nb = vmsplice_write(write_fd, writebuf, size);
+		} else {
+			nb = lio_write_buffer(write_fd, iotype, writebuf, size,
+					      SIGUSR1, &cp, 0);
+		}
 		if (nb < 0) {
 			/*
 			 * If lio_write_buffer returns a negative number,
@@ -590,6 +655,34 @@ static void do_child(void)
 	exit(0);
 }
 
+/*
+ * Map the buffer pages into the pipe with vmsplice().  Mirrors the
+ * lio_write_buffer() contract: the full write size on success, -errno
+ * on failure.  Partial transfers are resumed until the whole buffer
+ * has been spliced.
+ */
+static int vmsplice_write(int fd, const char *buf, int nbytes)
+{
+	struct iovec iov;
+	long nb;
+	int off = 0;
+
+	while (off < nbytes) {
+		iov.iov_base = (char *)buf + off;
+		iov.iov_len = nbytes - off;
+
+		nb = vmsplice(fd, &iov, 1, 0);
+		if (nb < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			return -errno;
+		}
+		off += nb;
+	}
+
+	return off;
+}
+
 static int check_rw_buf(void)
 {
 	int i;
@@ -618,6 +711,8 @@ static void do_parent(void)
 	time_t start_time, current_time, diff_time;
 	char *cp;
 	long int n;
+	double elapsed;
+	struct timespec ts_start, ts_end;
 	struct sembuf sem_op;
 
 	start_time = time(0);
@@ -627,6 +722,7 @@ static void do_parent(void)
 			tst_brkm(TBROK | TERRNO, cleanup,
 				 "Failed setting the pipe to nonblocking mode");
 		}
+		set_pipe_size(read_fd);
 	} else {
 		SAFE_CLOSE(cleanup, write_fd);
 	}
@@ -650,6 +746,13 @@ static void do_parent(void)
 			 "Couldn't wait on semaphore 0");
 	}
 
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+	if (zero_copy_read) {
+		do_parent_splice();
+		goto report;
+	}
+
 	/* parent start to read pipe */
 	for (i = num_writers * num_writes; i > 0 || loop; --i) {
 		if (error >= MAX_ERRS || empty_read >= MAX_EMPTY)
@@ -685,7 +788,9 @@ static void do_parent(void)
 				++i;
 				count--;
 				continue;
-			} else if (nb < size && size <= PIPE_BUF) {
+			}
+			total_bytes += nb;
+			if (nb < size && size <= PIPE_BUF) {
 				tst_resm(TFAIL, "pass %d: partial read from the"
 					" pipe: read %d bytes, expected %d, "
 					"read count %d", i, nb, size, count);
@@ -710,14 +815,69 @@ static void do_parent(void)
 		}
 	}
 
+report:
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	elapsed = (ts_end.tv_sec - ts_start.tv_sec) +
+		  (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9;
+	if (total_bytes && elapsed > 0) {
+		tst_resm(TINFO, "consumed %lld bytes in %.3f s: %.3f MB/s",
+			 total_bytes, elapsed,
+			 total_bytes / elapsed / (1024.0 * 1024.0));
+	}
+
 	SAFE_CLOSE(cleanup, read_fd);
 }
 
+/*
+ * Drain the pipe with splice() to /dev/null, moving pages out of the
+ * pipe without copying them through a user buffer.  Data cannot be
+ * verified in this mode; the loop only accounts the bytes consumed.
+ */
+static void do_parent_splice(void)
+{
+	int nulldev_fd, nb;
+	long long left = (long long)num_writers * num_writes * size;
+
+	nulldev_fd = SAFE_OPEN(cleanup, "/dev/null", O_WRONLY);
+
+	while (left > 0 || loop) {
+		if (empty_read >= MAX_EMPTY)
+			break;
+
+		nb = splice(read_fd, NULL, nulldev_fd, NULL, size,
+			    SPLICE_F_MOVE);
+		if (nb < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN) {
+				empty_read++;
+				continue;
+			}
+			tst_resm(TFAIL, "splice() from pipe failed: %s",
+				 strerror(errno));
+			++error;
+			break;
+		}
+		if (nb == 0) {
+			if (nchildcompleted >= num_writers && !loop)
+				break;	/* All children have died */
+			empty_read++;
+			continue;
+		}
+		total_bytes += nb;
+		left -= nb;
+		++count;
+	}
+
+	SAFE_CLOSE(cleanup, nulldev_fd);
+}
+
 static void usage(void)
 {
-	fprintf(stderr, "Usage: %s [-bEv][-c #writers][-D pname][-h]"
+	fprintf(stderr, "Usage: %s [-bEvzZ][-c #writers][-D pname][-h]"
 		"[-e exit_num][-f fmt][-l][-i #writes][-n #writes][-p num_rpt]"
-		"\n\t[-s size][-W max_wait][-w max_wait][-u]\n", TCID);
+		"\n\t[-S pipe_size][-s size][-W max_wait][-w max_wait][-u]\n",
+		TCID);
 	fflush(stderr);
 }
 
@@ -741,6 +901,7 @@ static void help(void)
   -n #writes   - same as -i (for compatability).\n\
   -p num_rpt   - number of reads before a report\n\
   -q           - quiet mode, no PASS results are printed\n\
+  -S pipe_size - set pipe buffer size with fcntl(F_SETPIPE_SZ)\n\
   -s size      - size of read and write (def 327)\n\
                  if size >= 4096, i/o will be in 4096 chuncks\n\
   -w max_wait  - max time (seconds) for sleep between writes.\n\
@@ -748,7 +909,10 @@ static void help(void)
   -W max_wait  - max time (seconds) for sleep between reads\n\
                  max_wait is interpreted as a double with ms accuracy.\n\
   -u           - un-named pipe instead of named pipe\n\
-  -v           - verbose mode, all writes/reads resutlts printed\n");
+  -v           - verbose mode, all writes/reads resutlts printed\n\
+  -z           - children write with vmsplice() (zero-copy)\n\
+  -Z           - parent drains with splice() to /dev/null (zero-copy),\n\
+                 data verification is disabled in this mode\n");
 
 	fflush(stdout);
 }
@@ -847,6 +1011,7 @@ static void prt_examples(void)
 	printf("%s -c 5 -i 0 -s 4090 -b\n", TCID);
 	printf("%s -c 5 -i 0 -s 4090 -b -u \n", TCID);
 	printf("%s -c 5 -i 0 -s 4090 -b -W 3 -w 3 \n", TCID);
+	printf("%s -c 1 -i 10000 -s 65536 -S 1048576 -b -u -z -Z\n", TCID);
 }
 
 static void sig_child(int sig)
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * sem_perf01 - SysV semaphore batching and contention benchmark
+ *
+ * sem01 and sem02 only issue single-sembuf semop() calls, so neither
+ * the multi-operation path nor the per-set locking under contention
+ * produces any signal here.  This benchmark creates one semaphore set
+ * and measures
+ *
+ *  - single-process semop() call and sembuf-operation rates for batch
+ *    sizes from 1 to 64 sembufs per call, with and without SEM_UNDO;
+ *    the undo columns price the per-process undo list maintenance,
+ *
+ *  - aggregate operation throughput with one worker per CPU hammering
+ *    the same set, with and without SEM_UNDO; comparing against the
+ *    single-process line exposes sem_lock() contention,
+ *
+ *  - fork/exit cycles through SEM_UNDO operations while the workers
+ *    keep the set busy; exit_sem() walks and frees the undo list under
+ *    the semaphore lock, which is invisible to any existing test.
+ *
+ * All semaphores start at half range and every call flips the sign of
+ * its operations, so nothing ever blocks and values cannot drift out
+ * of [0, SEMVMX].
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ipc.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/sem.h"
+
+#define NSEMS 64
+#define MAX_BATCH 64
+
+static const int batches[] = { 1, 4, 16, 64 };
+
+static int semid = -1;
+static int iters = 20000;
+static int churn_iters = 2000;
+static int nprocs;
+
+static struct shared {
+	volatile int start;
+	volatile int stop;
+} *shared;
+
+static char *str_iters;
+static char *str_churn_iters;
+static char *str_procs;
+
+static void do_semop(int nsops, short flg, int dir)
+{
+	struct sembuf ops[MAX_BATCH];
+	int i;
+
+	for (i = 0; i < nsops; i++) {
+		ops[i].sem_num = i;
+		ops[i].sem_op = dir;
+		ops[i].sem_flg = flg;
+	}
+
+	if (semop(semid, ops, nsops))
+		tst_brk(TBROK | TERRNO, "semop(%i sembufs)", nsops);
+}
+
+static void bench_batch(short flg)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	unsigned int b;
+	int i, dir;
+
+	for (b = 0; b < ARRAY_SIZE(batches); b++) {
+		dir = 1;
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		for (i = 0; i < iters; i++) {
+			do_semop(batches[b], flg, dir);
+			dir = -dir;
+		}
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+		tst_res(TINFO,
+			"batch %2i%s: %9.0f calls/s, %10.0f ops/s",
+			batches[b], flg & SEM_UNDO ? " undo" : "     ",
+			1000.0 * iters / elapsed_ms,
+			1000.0 * iters * batches[b] / elapsed_ms);
+	}
+}
+
+static void worker(short flg)
+{
+	int dir = 1;
+	int i;
+
+	while (!shared->start)
+		sched_yield();
+
+	for (i = 0; i < iters; i++) {
+		do_semop(16, flg, dir);
+		dir = -dir;
+	}
+
+	exit(0);
+}
+
+static void bench_contention(short flg)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	int i;
+
+	shared->start = 0;
+
+	for (i = 0; i < nprocs; i++) {
+		if (!SAFE_FORK())
+			worker(flg);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	shared->start = 1;
+	tst_reap_children();
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO,
+		"%2i procs%s: %10.0f ops/s aggregate",
+		nprocs, flg & SEM_UNDO ? " undo" : "     ",
+		1000.0 * nprocs * iters * 16 / elapsed_ms);
+}
+
+static void churn_worker(void)
+{
+	int dir = 1;
+
+	while (!shared->stop) {
+		do_semop(16, SEM_UNDO, dir);
+		dir = -dir;
+	}
+
+	exit(0);
+}
+
+static void bench_undo_churn(void)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	int i;
+
+	shared->stop = 0;
+
+	for (i = 0; i < nprocs; i++) {
+		if (!SAFE_FORK())
+			churn_worker();
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (i = 0; i < churn_iters; i++) {
+		pid_t pid = SAFE_FORK();
+
+		if (!pid) {
+			do_semop(MAX_BATCH, SEM_UNDO, 1);
+			exit(0);
+		}
+		SAFE_WAITPID(pid, NULL, 0);
+	}
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	shared->stop = 1;
+	tst_reap_children();
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO,
+		"undo churn, %i busy procs: %9.0f exits/s",
+		nprocs, 1000.0 * churn_iters / elapsed_ms);
+}
+
+static void run(void)
+{
+	bench_batch(0);
+	bench_batch(SEM_UNDO);
+
+	bench_contention(0);
+	bench_contention(SEM_UNDO);
+
+	bench_undo_churn();
+
+	tst_res(TPASS, "semop batching, contention and undo paths measured");
+}
+
+static void setup(void)
+{
+	unsigned short vals[NSEMS];
+	union semun arg;
+	int i;
+
+	if (str_iters) {
+		if (tst_parse_int(str_iters, &iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid call count '%s'", str_iters);
+	}
+
+	if (str_churn_iters) {
+		if (tst_parse_int(str_churn_iters, &churn_iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid churn count '%s'",
+				str_churn_iters);
+	}
+
+	nprocs = tst_ncpus();
+	if (str_procs) {
+		if (tst_parse_int(str_procs, &nprocs, 1, 4096))
+			tst_brk(TBROK, "Invalid process count '%s'", str_procs);
+	}
+
+	semid = semget(IPC_PRIVATE, NSEMS, IPC_CREAT | 0600);
+	if (semid == -1)
+		tst_brk(TBROK | TERRNO, "semget()");
+
+	for (i = 0; i < NSEMS; i++)
+		vals[i] = 16384;
+	arg.array = vals;
+	if (semctl(semid, 0, SETALL, arg))
+		tst_brk(TBROK | TERRNO, "semctl(SETALL)");
+
+	shared = SAFE_MMAP(NULL, sizeof(*shared), PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+}
+
+static void cleanup(void)
+{
+	if (shared)
+		SAFE_MUNMAP(shared, sizeof(*shared));
+
+	if (semid != -1)
+		semctl(semid, 0, IPC_RMID);
+}
+
+static struct tst_test test = {
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"n:", &str_iters, "-n N     semop() calls per measurement (default 20000)"},
+		{"c:", &str_churn_iters, "-c N     fork/exit cycles in the undo churn (default 2000)"},
+		{"p:", &str_procs, "-p N     Contending processes (default: one per CPU)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
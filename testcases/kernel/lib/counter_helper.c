@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+#define TST_NO_DEFAULT_MAIN
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "tst_test.h"
+#include "tst_safe_prw.h"
+#include "counter_helper.h"
+
+long tst_wait_counter_at_least(const char *path, long target,
+			       unsigned int margin_sec)
+{
+	char buf[32];
+	ssize_t len;
+	long val;
+	useconds_t interval = 1000;
+	int fd;
+
+	fd = SAFE_OPEN(path, O_RDONLY);
+
+	for (;;) {
+		len = SAFE_PREAD(0, fd, buf, sizeof(buf) - 1, 0);
+		buf[len] = '\0';
+
+		if (sscanf(buf, "%ld", &val) != 1)
+			tst_brk(TBROK, "invalid counter in '%s': '%s'",
+				path, buf);
+
+		if (val >= target)
+			break;
+
+		if (tst_timeout_remaining() < margin_sec) {
+			tst_res(TWARN, "timed out waiting for %s to reach "
+				"%ld, stuck at %ld", path, target, val);
+			break;
+		}
+
+		usleep(interval);
+		if (interval < 100000)
+			interval *= 2;
+	}
+
+	SAFE_CLOSE(fd);
+
+	return val;
+}
@@ -8,14 +8,19 @@
 
 #include <unistd.h>
 #include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
 #include "ksm_helper.h"
+#include "counter_helper.h"
 
 void wait_ksmd_full_scan(void)
 {
-	unsigned long full_scans, at_least_one_full_scan;
-	int count = 0;
+	unsigned long full_scans;
+	struct timespec ts_start, ts_stop;
 
 	SAFE_FILE_SCANF(PATH_KSM "full_scans", "%lu", &full_scans);
+	tst_clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
 	/*
 	 * The current scan is already in progress so we can't guarantee that
 	 * the get_user_pages() is called on every existing rmap_item if we
@@ -26,12 +31,9 @@ void wait_ksmd_full_scan(void)
 	 * wait full_scans to increment by 3 so that at least two full scans
 	 * will run.
 	 */
-	at_least_one_full_scan = full_scans + 3;
-	while (full_scans < at_least_one_full_scan) {
-		sleep(1);
-		count++;
-		SAFE_FILE_SCANF(PATH_KSM "full_scans", "%lu", &full_scans);
-	}
+	tst_wait_counter_at_least(PATH_KSM "full_scans", full_scans + 3, 5);
 
-	tst_res(TINFO, "ksm daemon takes %ds to run two full scans", count);
+	tst_clock_gettime(CLOCK_MONOTONIC, &ts_stop);
+	tst_res(TINFO, "ksm daemon takes %llims to run two full scans",
+		tst_timespec_diff_ms(ts_stop, ts_start));
 }
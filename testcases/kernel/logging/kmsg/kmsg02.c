@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * kmsg02 - /dev/kmsg burst throughput and drop detection
+ *
+ * kmsg01 validates the record format but reads one record at trickle
+ * rates, so printk ringbuffer performance regressions are invisible.
+ * This test floods the log from several injector processes writing to
+ * /dev/kmsg while the parent reads continuously from SEEK_END,
+ * measuring the sustained read rate and accounting every record the
+ * reader lost: the kernel sequence number in each record makes gaps
+ * explicit, and -EPIPE marks the reader being overrun outright.
+ *
+ * Messages are injected at KERN_DEBUG level and the console loglevel
+ * is lowered like in kmsg01, so the flood never reaches a (possibly
+ * slow serial) console and measures only the ringbuffer paths.
+ *
+ * Drops are reported but do not fail the test; with a small
+ * log_buf_len and a fast producer they are expected. The numbers are
+ * for comparing kernels.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+
+#define MSG_PREFIX "LTP kmsg02 "
+#define MAX_MSGSIZE 4096
+#define PRINTK "/proc/sys/kernel/printk"
+#define DEVKMSG "/proc/sys/kernel/printk_devkmsg"
+#define CONSOLE_LOGLEVEL_QUIET 4
+
+static int nwriters = 4;
+static int msgs_per_writer = 20000;
+static int console_loglevel = -1;
+
+static char *str_writers;
+static char *str_msgs;
+
+static void injector(int id)
+{
+	char msg[128];
+	int fd, i;
+
+	fd = SAFE_OPEN("/dev/kmsg", O_WRONLY);
+
+	for (i = 0; i < msgs_per_writer; i++) {
+		int len = snprintf(msg, sizeof(msg),
+				   "<7>" MSG_PREFIX "%i %i 0123456789abcdef0123456789abcdef\n",
+				   id, i);
+
+		if (write(fd, msg, len) < 0) {
+			/* ratelimit off, but be robust against EINTR */
+			if (errno == EINTR) {
+				i--;
+				continue;
+			}
+			tst_brk(TBROK | TERRNO, "write(/dev/kmsg)");
+		}
+	}
+
+	SAFE_CLOSE(fd);
+	exit(0);
+}
+
+static void run(void)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	char msg[MAX_MSGSIZE + 1];
+	unsigned long seq, prev_seq = 0;
+	long long records = 0, own = 0, gap_drops = 0, overruns = 0;
+	int fd, i, writers_alive = nwriters;
+
+	fd = SAFE_OPEN("/dev/kmsg", O_RDONLY | O_NONBLOCK);
+	SAFE_LSEEK(fd, 0, SEEK_END);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nwriters; i++) {
+		if (!SAFE_FORK())
+			injector(i);
+	}
+
+	while (1) {
+		TEST(read(fd, msg, MAX_MSGSIZE));
+
+		if (TST_RET < 0) {
+			if (TST_ERR == EPIPE) {
+				/* reader overrun, next read skips ahead */
+				overruns++;
+				continue;
+			}
+
+			if (TST_ERR != EAGAIN)
+				tst_brk(TBROK | TTERRNO, "read(/dev/kmsg)");
+
+			/* drained; stop once all injectors have finished */
+			if (!writers_alive)
+				break;
+
+			while (writers_alive &&
+			       waitpid(-1, NULL, WNOHANG) > 0)
+				writers_alive--;
+
+			if (!writers_alive)
+				continue;
+
+			usleep(100);
+			continue;
+		}
+
+		msg[TST_RET] = '\0';
+		records++;
+
+		if (sscanf(msg, "%*u,%lu,", &seq) == 1) {
+			if (prev_seq && seq > prev_seq + 1)
+				gap_drops += seq - prev_seq - 1;
+			prev_seq = seq;
+		}
+
+		if (strstr(msg, MSG_PREFIX))
+			own++;
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	SAFE_CLOSE(fd);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO,
+		"%lli records read in %llims (%8.0f records/s), %lli of ours",
+		records, elapsed_ms, 1000.0 * records / elapsed_ms, own);
+	tst_res(TINFO,
+		"injected %8.0f msgs/s, lost %lli records to seqno gaps, %lli reader overruns",
+		1000.0 * nwriters * msgs_per_writer / elapsed_ms,
+		gap_drops, overruns);
+
+	if (own + gap_drops < (long long)nwriters * msgs_per_writer) {
+		tst_res(TINFO, "%lli own messages unaccounted for",
+			nwriters * (long long)msgs_per_writer - own - gap_drops);
+	}
+
+	tst_res(TPASS, "kmsg sustained read rate measured under %i-writer flood",
+		nwriters);
+}
+
+static void setup(void)
+{
+	if (str_writers) {
+		if (tst_parse_int(str_writers, &nwriters, 1, 512))
+			tst_brk(TBROK, "Invalid writer count '%s'", str_writers);
+	}
+
+	if (str_msgs) {
+		if (tst_parse_int(str_msgs, &msgs_per_writer, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid message count '%s'", str_msgs);
+	}
+
+	if (access(PRINTK, F_OK) == 0) {
+		SAFE_FILE_SCANF(PRINTK, "%d", &console_loglevel);
+		SAFE_FILE_PRINTF(PRINTK, "%d", CONSOLE_LOGLEVEL_QUIET);
+	}
+
+	/* the default ratelimit would swallow the flood at the source */
+	if (access(DEVKMSG, F_OK) == 0)
+		SAFE_FILE_PRINTF(DEVKMSG, "on\n");
+}
+
+static void cleanup(void)
+{
+	if (console_loglevel != -1)
+		SAFE_FILE_PRINTF(PRINTK, "%d", console_loglevel);
+}
+
+static struct tst_test test = {
+	.needs_root = 1,
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"w:", &str_writers, "-w N     Injector processes (default 4)"},
+		{"n:", &str_msgs, "-n N     Messages per injector (default 20000)"},
+		{}
+	},
+	.save_restore = (const char * const[]) {
+		"?" DEVKMSG,
+		NULL,
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+	.min_kver = "3.5.0",
+};
@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * memhotplug01 - concurrent memory block offline/online driver
+ *
+ * Offlining a memory block has to migrate every movable page out of it,
+ * so its latency tracks the page migration path, which memory hotplug
+ * keeps regressing into. Cycling blocks one synchronous sysfs write at
+ * a time also makes a full sweep of a large machine take hours, long
+ * enough that nobody runs it.
+ *
+ * This driver picks a bounded set of removable online blocks, opens
+ * their state files once up front and hands disjoint subsets to a pool
+ * of worker threads. Each worker offlines and re-onlines its blocks in
+ * a loop; the state write returns when the operation is complete, so a
+ * thread per subset keeps several migrations in flight at once without
+ * any polling. Per-block offline and online latencies are collected in
+ * histograms and reported as percentiles.
+ *
+ * Blocks the kernel refuses to offline (unmovable pages, EBUSY) are
+ * counted and skipped; the test only fails when a block that was
+ * offlined cannot be brought back online.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <limits.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+#define MEMORY_PATH "/sys/devices/system/memory"
+#define MAX_WORKERS 16
+
+struct block {
+	int id;
+	int fd;
+};
+
+struct worker {
+	pthread_t thread;
+	int first;		/* first block index, stride is nworkers */
+	struct tst_hist off_hist;
+	struct tst_hist on_hist;
+	long long offlined;
+	long long busy;
+	long long online_failed;
+};
+
+static struct block *blocks;
+static int nblocks;
+static struct worker workers[MAX_WORKERS];
+
+static int max_blocks = 32;
+static int nworkers = 4;
+static int loops = 2;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static char *str_max_blocks;
+static char *str_nworkers;
+static char *str_loops;
+static char *str_bits;
+
+static long long block_bytes;
+
+static int set_state(struct block *blk, const char *state)
+{
+	if (pwrite(blk->fd, state, strlen(state), 0) < 0)
+		return -1;
+	return 0;
+}
+
+static void read_state(struct block *blk, char *buf, size_t len)
+{
+	ssize_t ret;
+
+	ret = pread(blk->fd, buf, len - 1, 0);
+	if (ret < 0) {
+		tst_brk(TBROK | TERRNO, "read state of memory%i", blk->id);
+		return;
+	}
+	buf[ret] = '\0';
+	if (ret > 0 && buf[ret - 1] == '\n')
+		buf[ret - 1] = '\0';
+}
+
+static void *worker_run(void *arg)
+{
+	struct worker *w = arg;
+	struct timespec t1, t2;
+	struct block *blk;
+	int i, loop;
+
+	for (loop = 0; loop < loops; loop++) {
+		for (i = w->first; i < nblocks; i += nworkers) {
+			blk = &blocks[i];
+
+			tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+			if (set_state(blk, "offline")) {
+				w->busy++;
+				continue;
+			}
+			tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+			tst_hist_add(&w->off_hist,
+				     tst_timespec_diff_us(t2, t1));
+			w->offlined++;
+
+			tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+			if (set_state(blk, "online")) {
+				w->online_failed++;
+				continue;
+			}
+			tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+			tst_hist_add(&w->on_hist,
+				     tst_timespec_diff_us(t2, t1));
+		}
+	}
+
+	return NULL;
+}
+
+static void run(void)
+{
+	struct tst_hist off_hist, on_hist;
+	long long offlined = 0, busy = 0, online_failed = 0;
+	int i;
+
+	for (i = 0; i < nworkers; i++) {
+		tst_hist_reset(&workers[i].off_hist);
+		tst_hist_reset(&workers[i].on_hist);
+		workers[i].offlined = 0;
+		workers[i].busy = 0;
+		workers[i].online_failed = 0;
+		workers[i].first = i;
+		SAFE_PTHREAD_CREATE(&workers[i].thread, NULL, worker_run,
+				    &workers[i]);
+	}
+
+	tst_hist_init(&off_hist, hist_bits);
+	tst_hist_init(&on_hist, hist_bits);
+
+	for (i = 0; i < nworkers; i++) {
+		SAFE_PTHREAD_JOIN(workers[i].thread, NULL);
+		tst_hist_merge(&off_hist, &workers[i].off_hist);
+		tst_hist_merge(&on_hist, &workers[i].on_hist);
+		offlined += workers[i].offlined;
+		busy += workers[i].busy;
+		online_failed += workers[i].online_failed;
+	}
+
+	if (busy)
+		tst_res(TINFO, "%lli offline attempts denied by the kernel",
+			busy);
+
+	if (!offlined) {
+		tst_hist_free(&off_hist);
+		tst_hist_free(&on_hist);
+		tst_brk(TCONF, "no block could be offlined (unmovable pages?)");
+	}
+
+	tst_res(TINFO,
+		"offline p50 %7lldus, p99 %7lldus, max %7lldus (%lli ops)",
+		tst_hist_percentile(&off_hist, 50),
+		tst_hist_percentile(&off_hist, 99),
+		tst_hist_percentile(&off_hist, 100), offlined);
+	tst_res(TINFO,
+		"online  p50 %7lldus, p99 %7lldus, max %7lldus",
+		tst_hist_percentile(&on_hist, 50),
+		tst_hist_percentile(&on_hist, 99),
+		tst_hist_percentile(&on_hist, 100));
+
+	tst_hist_free(&off_hist);
+	tst_hist_free(&on_hist);
+
+	if (online_failed) {
+		tst_res(TFAIL, "%lli block(s) could not be re-onlined",
+			online_failed);
+		return;
+	}
+
+	tst_res(TPASS, "cycled %i memory blocks of %llimb with %i workers",
+		nblocks, block_bytes / (1024 * 1024), nworkers);
+}
+
+static int block_file_matches(struct block *blk, const char *file,
+			      const char *want)
+{
+	char path[PATH_MAX], val[64];
+
+	snprintf(path, sizeof(path), MEMORY_PATH "/memory%i/%s",
+		 blk->id, file);
+	if (access(path, F_OK))
+		return 0;
+	SAFE_FILE_SCANF(path, "%63s", val);
+	return !strcmp(val, want);
+}
+
+static void collect_blocks(void)
+{
+	struct dirent *ent;
+	struct block blk;
+	char path[PATH_MAX];
+	DIR *dir;
+
+	blocks = SAFE_MALLOC(max_blocks * sizeof(*blocks));
+
+	dir = SAFE_OPENDIR(MEMORY_PATH);
+	while (nblocks < max_blocks && (ent = SAFE_READDIR(dir))) {
+		if (sscanf(ent->d_name, "memory%i", &blk.id) != 1)
+			continue;
+
+		/* only blocks the kernel itself calls removable */
+		if (!block_file_matches(&blk, "removable", "1"))
+			continue;
+		if (!block_file_matches(&blk, "state", "online"))
+			continue;
+
+		snprintf(path, sizeof(path), MEMORY_PATH "/memory%i/state",
+			 blk.id);
+		blk.fd = SAFE_OPEN(path, O_RDWR);
+		blocks[nblocks++] = blk;
+	}
+	SAFE_CLOSEDIR(dir);
+
+	if (!nblocks)
+		tst_brk(TCONF, "no removable online memory block found");
+}
+
+static void setup(void)
+{
+	int i;
+
+	if (str_max_blocks && tst_parse_int(str_max_blocks, &max_blocks, 1,
+					    INT_MAX))
+		tst_brk(TBROK, "Invalid block count '%s'", str_max_blocks);
+
+	if (str_nworkers && tst_parse_int(str_nworkers, &nworkers, 1,
+					  MAX_WORKERS))
+		tst_brk(TBROK, "Invalid worker count '%s'", str_nworkers);
+
+	if (str_loops && tst_parse_int(str_loops, &loops, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid loop count '%s'", str_loops);
+
+	if (str_bits && tst_parse_int(str_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+
+	if (access(MEMORY_PATH, F_OK))
+		tst_brk(TCONF, "memory hotplug sysfs interface not present");
+
+	SAFE_FILE_SCANF(MEMORY_PATH "/block_size_bytes", "%llx",
+			&block_bytes);
+
+	collect_blocks();
+
+	if (nworkers > nblocks)
+		nworkers = nblocks;
+
+	tst_res(TINFO, "%i removable blocks of %llimb, %i workers, %i loops",
+		nblocks, block_bytes / (1024 * 1024), nworkers, loops);
+
+	for (i = 0; i < nworkers; i++) {
+		tst_hist_init(&workers[i].off_hist, hist_bits);
+		tst_hist_init(&workers[i].on_hist, hist_bits);
+	}
+}
+
+static void cleanup(void)
+{
+	char state[64];
+	int i;
+
+	/* whatever happened, leave no block offline behind */
+	for (i = 0; i < nblocks; i++) {
+		read_state(&blocks[i], state, sizeof(state));
+		if (strcmp(state, "online") &&
+		    set_state(&blocks[i], "online")) {
+			tst_res(TWARN, "memory%i left %s: %s",
+				blocks[i].id, state, tst_strerrno(errno));
+		}
+		SAFE_CLOSE(blocks[i].fd);
+	}
+
+	for (i = 0; i < nworkers; i++) {
+		if (workers[i].off_hist.buckets)
+			tst_hist_free(&workers[i].off_hist);
+		if (workers[i].on_hist.buckets)
+			tst_hist_free(&workers[i].on_hist);
+	}
+
+	free(blocks);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.needs_root = 1,
+	/* offlining a fragmented block can retry for quite a while */
+	.timeout = 900,
+	.options = (struct tst_option[]) {
+		{"n:", &str_max_blocks, "-n N     Max memory blocks to cycle (default 32)"},
+		{"w:", &str_nworkers, "-w N     Concurrent workers (default 4)"},
+		{"l:", &str_loops, "-l N     Offline/online cycles per block (default 2)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+};
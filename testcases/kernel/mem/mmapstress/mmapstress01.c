@@ -25,6 +25,8 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -34,6 +36,7 @@
 #include <limits.h>
 /*****  LTP Port        *****/
 #include "test.h"
+#include "lapi/mmap.h"
 #define FAILED 0
 #define PASSED 1
 
@@ -84,6 +87,14 @@ void ok_exit();
  *	-l		- if set, the output file is not removed on
  *			  program exit.
  *	-d		- enable debug output
+ *	-H		- advise transparent hugepages for the maps.
+ *			  Even children advise their whole map, odd ones
+ *			  only the first half, so huge and small mappings
+ *			  mix and both the collapse and split paths run.
+ *			  MADV_COLLAPSE is attempted as well (best effort,
+ *			  older kernels do not have it).
+ *	-F		- each child reports its page fault counts and
+ *			  fault rate on exit.
  *
  *  Compile with -DLARGE_FILE to enable file sizes > 2 GB.
  */
@@ -107,7 +118,7 @@ extern int rand(void);
 extern int atoi(const char *);
 
 char *usage =
-    "-p nprocs [-t minutes -f filesize -S sparseoffset -r -o -m -l -d]";
+    "-p nprocs [-t minutes -f filesize -S sparseoffset -r -o -m -l -d -H -F]";
 
 typedef unsigned char uchar_t;
 #define SIZE_MAX UINT_MAX
@@ -130,6 +141,8 @@ off_t sparseoffset = 0;
 unsigned randloops = 0;
 unsigned dosync = 0;
 unsigned do_offset = 0;
+unsigned dohuge = 0;
+unsigned fltstats = 0;
 unsigned pattern = 0;
 
 int main(int argc, char *argv[])
@@ -166,11 +179,17 @@ int main(int argc, char *argv[])
 		tst_brkm(TBROK, NULL, "usage: %s %s\n", progname, usage);
 	}
 
-	while ((c = getopt(argc, argv, "S:omdlrf:p:t:")) != -1) {
+	while ((c = getopt(argc, argv, "S:omdlrf:p:t:HF")) != -1) {
 		switch (c) {
 		case 'd':
 			debug = 1;
 			break;
+		case 'H':
+			dohuge = 1;
+			break;
+		case 'F':
+			fltstats = 1;
+			break;
 		case 't':
 			alarmtime = atof(optarg) * 60;
 			break;
@@ -477,9 +496,17 @@ void child_mapper(char *file, unsigned procno, unsigned nprocs)
 	unsigned nloops;
 	unsigned mappages;
 	unsigned i;
+	struct rusage ru_start, ru_end;
+	struct timeval tv_start, tv_end;
+	double elapsed;
 
 	seed = initrand();	/* initialize random seed */
 
+	if (fltstats) {
+		(void)getrusage(RUSAGE_SELF, &ru_start);
+		(void)gettimeofday(&tv_start, NULL);
+	}
+
 #ifdef LARGE_FILE
 	if (stat64(file, &statbuf) == -1) {
 #else /* LARGE_FILE */
@@ -541,6 +568,23 @@ void child_mapper(char *file, unsigned procno, unsigned nprocs)
 
 	(void)close(fd);
 
+	if (dohuge) {
+		/*
+		 *  Even children advise the whole map, odd children only
+		 *  the first half, so the file ends up mapped with a mix
+		 *  of huge and small pages and khugepaged gets to both
+		 *  collapse and split as children come and go.
+		 */
+		size_t hlen = (procno % 2) ?
+		    roundup(mapsize / 2, pagesize) : mapsize;
+
+		if (hlen && madvise(maddr, hlen, MADV_HUGEPAGE) == -1
+		    && errno != EINVAL) {
+			perror("madvise MADV_HUGEPAGE error");
+			anyfail();
+		}
+	}
+
 	/*
 	 *  Now loop read/writing random pages.
 	 */
@@ -582,6 +626,26 @@ void child_mapper(char *file, unsigned procno, unsigned nprocs)
 			anyfail();
 		}
 	}
+	if (dohuge) {
+		/* best effort, older kernels do not have MADV_COLLAPSE */
+		(void)madvise(maddr, mapsize, MADV_COLLAPSE);
+	}
+
+	if (fltstats) {
+		(void)getrusage(RUSAGE_SELF, &ru_end);
+		(void)gettimeofday(&tv_end, NULL);
+		elapsed = (tv_end.tv_sec - tv_start.tv_sec) +
+		    (tv_end.tv_usec - tv_start.tv_usec) / 1e6;
+		if (elapsed < 1e-6)
+			elapsed = 1e-6;
+		(void)printf("child %d: %ld minor %ld major faults "
+			     "(%.0f faults/s)\n", procno,
+			     ru_end.ru_minflt - ru_start.ru_minflt,
+			     ru_end.ru_majflt - ru_start.ru_majflt,
+			     (ru_end.ru_minflt - ru_start.ru_minflt +
+			      ru_end.ru_majflt - ru_start.ru_majflt) / elapsed);
+	}
+
 	if (munmap(maddr, mapsize) == -1) {
 		perror("munmap failed");
 		local_flag = FAILED;
@@ -23,12 +23,15 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
 /*****  LTP Port        *****/
 #include "test.h"
+#include "lapi/mmap.h"
 #define FAILED 0
 #define PASSED 1
 
@@ -70,6 +73,11 @@ void ok_exit();
  *			  (random % MAXLOOPS).  If not specified, each
  *			  child checks MAXLOOPS pages.
  *	-d		- enable debug outputd
+ *	-H		- back the map with hugetlb pages (MAP_HUGETLB).
+ *			  The mapsize is rounded up to a hugepage multiple
+ *			  and hugepages must be reserved beforehand.
+ *	-F		- each child reports its page fault counts and
+ *			  fault rate on exit.
  */
 
 #define MAXLOOPS	500	/* max pages for map children to write */
@@ -92,7 +100,7 @@ extern int atoi(const char *);
 
 typedef unsigned char uchar_t;
 
-char *usage = "-p nprocs [-t minutes -s mapsize -m -r -d]";
+char *usage = "-p nprocs [-t minutes -s mapsize -m -r -d -H -F]";
 
 unsigned int initrand(void);
 void finish(int sig);
@@ -106,9 +114,29 @@ unsigned mappages;
 int pagesize;
 unsigned randloops = 0;
 unsigned dosync = 0;
+unsigned dohuge = 0;
+unsigned fltstats = 0;
 unsigned pattern = 0;
 caddr_t mapaddr;
 
+/*
+ *  Returns the default hugetlb page size in bytes.
+ */
+long hugepagesize(void)
+{
+	FILE *f;
+	char line[128];
+	long sz = 2048;
+
+	if ((f = fopen("/proc/meminfo", "r")) != NULL) {
+		while (fgets(line, sizeof(line), f) != NULL)
+			if (sscanf(line, "Hugepagesize: %ld", &sz) == 1)
+				break;
+		(void)fclose(f);
+	}
+	return sz * 1024;
+}
+
 int main(int argc, char *argv[])
 {
 	char *progname;
@@ -136,11 +164,17 @@ int main(int argc, char *argv[])
 		anyfail();
 	}
 
-	while ((c = getopt(argc, argv, "mdrp:t:s:")) != -1) {
+	while ((c = getopt(argc, argv, "mdrp:t:s:HF")) != -1) {
 		switch (c) {
 		case 'd':
 			debug = 1;
 			break;
+		case 'H':
+			dohuge = 1;
+			break;
+		case 'F':
+			fltstats = 1;
+			break;
 		case 't':
 			alarmtime = atof(optarg) * 60;
 			break;
@@ -190,7 +224,22 @@ int main(int argc, char *argv[])
 			(void)printf("running with no time limit\n");
 	}
 
-	if ((mapaddr = mmap(0, mapsize, PROT_READ | PROT_WRITE,
+	if (dohuge) {
+		long hpagesize = hugepagesize();
+
+		mapsize = roundup(mapsize, hpagesize);
+		if ((mapaddr = mmap(0, mapsize, PROT_READ | PROT_WRITE,
+				    MAP_ANONYMOUS | MAP_SHARED | MAP_HUGETLB,
+				    -1, 0)) == (caddr_t) - 1) {
+			perror("mmap MAP_HUGETLB error");
+			tst_brkm(TCONF, NULL,
+				 "no hugetlb pages available, reserve them via "
+				 "/proc/sys/vm/nr_hugepages");
+		}
+		if (debug)
+			(void)printf("hugetlb map, %ld byte pages, mapsize "
+				     "%d\n", hpagesize, mapsize);
+	} else if ((mapaddr = mmap(0, mapsize, PROT_READ | PROT_WRITE,
 			    MAP_ANONYMOUS | MAP_SHARED, 0, 0))
 	    == (caddr_t) - 1) {
 		perror("mmap error");
@@ -379,9 +428,17 @@ void child_mapper(unsigned procno, unsigned nprocs)
 	unsigned loopcnt;
 	unsigned nloops;
 	unsigned i;
+	struct rusage ru_start, ru_end;
+	struct timeval tv_start, tv_end;
+	double elapsed;
 
 	seed = initrand();	/* initialize random seed */
 
+	if (fltstats) {
+		(void)getrusage(RUSAGE_SELF, &ru_start);
+		(void)gettimeofday(&tv_start, NULL);
+	}
+
 	nloops = (randloops) ? (lrand48() % MAXLOOPS) : MAXLOOPS;
 
 	if (debug)
@@ -428,6 +485,21 @@ void child_mapper(unsigned procno, unsigned nprocs)
 		}
 	}
 
+	if (fltstats) {
+		(void)getrusage(RUSAGE_SELF, &ru_end);
+		(void)gettimeofday(&tv_end, NULL);
+		elapsed = (tv_end.tv_sec - tv_start.tv_sec)
+		    + (tv_end.tv_usec - tv_start.tv_usec) / 1e6;
+		if (elapsed < 1e-6)
+			elapsed = 1e-6;
+		(void)printf("child %d: %ld minor %ld major faults "
+			     "(%.0f faults/s)\n", procno,
+			     ru_end.ru_minflt - ru_start.ru_minflt,
+			     ru_end.ru_majflt - ru_start.ru_majflt,
+			     (ru_end.ru_minflt - ru_start.ru_minflt +
+			      ru_end.ru_majflt - ru_start.ru_majflt) / elapsed);
+	}
+
 	exit(0);
 }
 
@@ -19,6 +19,7 @@
  *  to continue and exit.
  */
 
+#include "config.h"
 #include <sys/types.h>
 #include <sys/sysinfo.h>
 #include <sys/wait.h>
@@ -26,10 +27,22 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
+#if HAVE_NUMA_H
+#include <numa.h>
+#endif
+#if HAVE_NUMAIF_H
+#include <numaif.h>
+#endif
 
 #include "lapi/abisize.h"
 #include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "mem.h"
+#include "numa_helper.h"
 
 #define FIVE_HUNDRED_MB         (500ULL*1024*1024)
 
@@ -91,11 +104,27 @@ static void handler(int sig LTP_ATTRIBUTE_UNUSED)
 
 static void do_write_mem(char *mem, int chunksize)
 {
-	int i, pagesz = getpagesize();
+	/*
+	 * Large memset()s are carried out with streaming stores by the
+	 * common libc implementations, so the chunk is populated at memory
+	 * bandwidth instead of one write fault plus cache miss per page.
+	 */
+	memset(mem, 'a', chunksize);
+}
 
-	for (i = 0; i < chunksize; i += pagesz)
-		*(mem + i) = 'a';
+#ifdef HAVE_NUMA_V2
+static int num_nodes;
+static int *nodes;
+
+static void bind_to_node(int node)
+{
+	unsigned long nmask[MAXNODES / BITS_PER_LONG] = { 0 };
+
+	set_node(nmask, node);
+	if (set_mempolicy(MPOL_BIND, nmask, MAXNODES) == -1)
+		tst_brk(TBROK | TERRNO, "set_mempolicy");
 }
+#endif
 
 static void setup(void)
 {
@@ -125,6 +154,14 @@ static void setup(void)
 		tst_res(TINFO, "Filling up %d%% of free ram which is %llu kbytes",
 			 maxpercent, alloc_maxbytes / 1024);
 	}
+
+#ifdef HAVE_NUMA_V2
+	if (get_allowed_nodes_arr(NH_MEMS, &num_nodes, &nodes) < 0)
+		tst_brk(TBROK | TERRNO, "get_allowed_nodes_arr");
+	if (num_nodes > 1)
+		tst_res(TINFO, "Spreading children across %d NUMA nodes",
+			num_nodes);
+#endif
 }
 
 static void cleanup(void)
@@ -133,12 +170,24 @@ static void cleanup(void)
 		free(pid_list);
 }
 
-static void child_loop_alloc(unsigned long long alloc_bytes)
+static void child_loop_alloc(unsigned long long alloc_bytes, int node)
 {
 	unsigned long bytecount = 0;
+	long long elapsed_ms;
+	struct timespec ts_start, ts_stop;
 	char *mem;
 
-	tst_res(TINFO, "... child %d starting", getpid());
+	if (node >= 0) {
+#ifdef HAVE_NUMA_V2
+		bind_to_node(node);
+#endif
+		tst_res(TINFO, "... child %d starting on node %d",
+			getpid(), node);
+	} else {
+		tst_res(TINFO, "... child %d starting", getpid());
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &ts_start);
 
 	while (1) {
 		mem = SAFE_MALLOC(chunksize);
@@ -153,9 +202,14 @@ static void child_loop_alloc(unsigned long long alloc_bytes)
 		if (bytecount >= alloc_bytes)
 			break;
 	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &ts_stop);
+	elapsed_ms = MAX(tst_timespec_diff_ms(ts_stop, ts_start), 1LL);
+
 	if (dowrite)
-		tst_res(TINFO, "... [t=%d] %lu bytes allocated and used in child %d",
-				tst_timeout_remaining(), bytecount, getpid());
+		tst_res(TINFO, "... [t=%d] %lu bytes allocated and used in child %d (%.0f MB/s)",
+				tst_timeout_remaining(), bytecount, getpid(),
+				bytecount / 1048576.0 * 1000 / elapsed_ms);
 	else
 		tst_res(TINFO, "... [t=%d] %lu bytes allocated only in child %d",
 				tst_timeout_remaining(), bytecount, getpid());
@@ -181,8 +235,15 @@ static void mem_test(void)
 	do {
 		pid = SAFE_FORK();
 		if (pid == 0) {
+			int node = -1;
+
+#ifdef HAVE_NUMA_V2
+			/* place the children round robin over the nodes */
+			if (num_nodes > 1)
+				node = nodes[pid_cntr % num_nodes];
+#endif
 			alloc_bytes = MIN(ALLOC_THRESHOLD, alloc_bytes);
-			child_loop_alloc(alloc_bytes);
+			child_loop_alloc(alloc_bytes, node);
 		}
 
 		pid_list[pid_cntr++] = pid;
@@ -0,0 +1,410 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * mmap4 - mremap stress engine over mixed THP and 4k regions
+ *
+ * The older mmap1-3 loops map/touch/unmap small fixed regions in one
+ * thread, which exercises nothing interesting on current kernels. This
+ * engine targets the paths heap resizing actually hits: mremap() of
+ * transparent-hugepage and base-page regions, growing, shrinking and
+ * moving them, alone and while other threads are faulting the same
+ * regions in.
+ *
+ * Half of the regions are madvised MADV_HUGEPAGE and sized in 2MB
+ * multiples, the other half MADV_NOHUGEPAGE with 4k granularity.
+ * Four phases run in turn:
+ *
+ *  - grow:   double every region with mremap() and touch the new half
+ *  - shrink: halve every region back
+ *  - move:   relocate every region with MREMAP_FIXED to fresh space
+ *  - mixed:  remapper threads cycle in-place grow/shrink on their
+ *            share of the regions while reader threads continuously
+ *            read the stable floor of all regions, the concurrent
+ *            resize-under-load case where THP mremap regressions
+ *            surface
+ *
+ * Every phase reports its operation rate plus the minor/major fault
+ * and TLB-shootdown deltas it produced (shootdowns from the TLB line
+ * of /proc/interrupts where the architecture exposes one). The test
+ * only fails when a remap or touch fails, the value is in the numbers.
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/mmap.h"
+
+#define HPAGE_SZ (2 * 1024 * 1024)
+#define SMALL_SZ (256 * 1024)
+#define MAX_THREADS 8
+
+static int nregions = 32;
+static int loops = 20;
+static int nremappers = 2;
+static int nreaders = 2;
+
+static char *str_nregions;
+static char *str_loops;
+static char *str_nremappers;
+static char *str_nreaders;
+
+static struct region {
+	char *addr;
+	size_t size;
+	/* floor size the readers may always touch */
+	size_t min_size;
+	size_t max_size;
+	int thp;
+} *regions;
+
+static volatile int stop;
+static long long remap_ops[MAX_THREADS];
+
+struct counters {
+	long minflt;
+	long majflt;
+	long long tlb;
+};
+
+static long long tlb_shootdowns(void)
+{
+	char line[4096];
+	long long sum = 0, val;
+	char *p;
+	FILE *f;
+	int found = 0;
+
+	f = fopen("/proc/interrupts", "r");
+	if (!f)
+		return -1;
+
+	while (fgets(line, sizeof(line), f)) {
+		p = strstr(line, "TLB");
+		if (!p || !strstr(p, "shootdowns"))
+			continue;
+
+		found = 1;
+		for (p = line; *p; p++) {
+			if (*p >= '0' && *p <= '9') {
+				val = strtoll(p, &p, 10);
+				sum += val;
+			}
+			if (*p >= 'a' && *p <= 'z')
+				break;
+		}
+	}
+
+	fclose(f);
+	return found ? sum : -1;
+}
+
+static void read_counters(struct counters *c)
+{
+	struct rusage ru;
+
+	SAFE_GETRUSAGE(RUSAGE_SELF, &ru);
+	c->minflt = ru.ru_minflt;
+	c->majflt = ru.ru_majflt;
+	c->tlb = tlb_shootdowns();
+}
+
+static void touch(char *addr, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i += getpagesize())
+		addr[i] = i;
+}
+
+static void create_regions(void)
+{
+	struct region *r;
+	int i;
+
+	for (i = 0; i < nregions; i++) {
+		r = &regions[i];
+		r->thp = i % 2;
+		r->min_size = r->thp ? 2 * HPAGE_SZ : SMALL_SZ;
+		r->max_size = 2 * r->min_size;
+		r->size = r->min_size;
+
+		r->addr = SAFE_MMAP(NULL, r->max_size,
+				    PROT_READ | PROT_WRITE,
+				    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		SAFE_MUNMAP(r->addr + r->size, r->max_size - r->size);
+
+		if (madvise(r->addr, r->size,
+			    r->thp ? MADV_HUGEPAGE : MADV_NOHUGEPAGE))
+			tst_brk(TBROK | TERRNO, "madvise()");
+
+		touch(r->addr, r->size);
+	}
+}
+
+static void destroy_regions(void)
+{
+	int i;
+
+	for (i = 0; i < nregions; i++) {
+		if (regions[i].addr)
+			SAFE_MUNMAP(regions[i].addr, regions[i].size);
+		regions[i].addr = NULL;
+	}
+}
+
+static long long phase_grow(void)
+{
+	struct region *r;
+	char *new;
+	int i;
+
+	for (i = 0; i < nregions; i++) {
+		r = &regions[i];
+
+		new = mremap(r->addr, r->size, 2 * r->size, MREMAP_MAYMOVE);
+		if (new == MAP_FAILED)
+			tst_brk(TBROK | TERRNO, "mremap() grow");
+
+		touch(new + r->size, r->size);
+		r->addr = new;
+		r->size *= 2;
+	}
+
+	return nregions;
+}
+
+static long long phase_shrink(void)
+{
+	struct region *r;
+	char *new;
+	int i;
+
+	for (i = 0; i < nregions; i++) {
+		r = &regions[i];
+
+		new = mremap(r->addr, r->size, r->size / 2, MREMAP_MAYMOVE);
+		if (new == MAP_FAILED)
+			tst_brk(TBROK | TERRNO, "mremap() shrink");
+
+		r->addr = new;
+		r->size /= 2;
+	}
+
+	return nregions;
+}
+
+static long long phase_move(void)
+{
+	struct region *r;
+	char *target, *new;
+	int i;
+
+	for (i = 0; i < nregions; i++) {
+		r = &regions[i];
+
+		/*
+		 * Reserve max_size so the region lands with free space
+		 * behind it again, which the mixed phase needs for its
+		 * in-place growing.
+		 */
+		target = SAFE_MMAP(NULL, r->max_size, PROT_NONE,
+				   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		SAFE_MUNMAP(target + r->size, r->max_size - r->size);
+
+		new = mremap(r->addr, r->size, r->size,
+			     MREMAP_MAYMOVE | MREMAP_FIXED, target);
+		if (new == MAP_FAILED)
+			tst_brk(TBROK | TERRNO, "mremap() move");
+
+		r->addr = new;
+		touch(r->addr, r->size);
+	}
+
+	return nregions;
+}
+
+/*
+ * In-place grow/shrink between min_size and max_size; the region base
+ * never changes, so the readers can keep touching the min_size floor
+ * without any locking, like application threads using a heap while it
+ * is resized. A grow that cannot extend in place just counts as busy.
+ */
+static void *remapper(void *arg)
+{
+	long id = (long)arg;
+	struct region *r;
+	int i, l;
+
+	for (l = 0; l < loops; l++) {
+		for (i = id; i < nregions; i += nremappers) {
+			r = &regions[i];
+
+			if (mremap(r->addr, r->min_size, r->max_size, 0)
+			    == MAP_FAILED)
+				continue;
+
+			touch(r->addr + r->min_size,
+			      r->max_size - r->min_size);
+
+			if (mremap(r->addr, r->max_size, r->min_size, 0)
+			    == MAP_FAILED) {
+				tst_brk(TBROK | TERRNO,
+					"mremap() in-place shrink");
+			}
+
+			remap_ops[id] += 2;
+		}
+	}
+
+	return NULL;
+}
+
+static void *reader(void *arg LTP_ATTRIBUTE_UNUSED)
+{
+	volatile char *p;
+	size_t j;
+	long sum = 0;
+	int i;
+
+	while (!stop) {
+		for (i = 0; i < nregions; i++) {
+			p = regions[i].addr;
+
+			for (j = 0; j < regions[i].min_size;
+			     j += getpagesize())
+				sum += p[j];
+		}
+	}
+
+	return (void *)sum;
+}
+
+static long long phase_mixed(void)
+{
+	pthread_t remappers[MAX_THREADS], readers[MAX_THREADS];
+	long long ops = 0;
+	long i;
+
+	memset(remap_ops, 0, sizeof(remap_ops));
+	stop = 0;
+
+	for (i = 0; i < nreaders; i++)
+		SAFE_PTHREAD_CREATE(&readers[i], NULL, reader, NULL);
+	for (i = 0; i < nremappers; i++) {
+		SAFE_PTHREAD_CREATE(&remappers[i], NULL, remapper,
+				    (void *)i);
+	}
+
+	for (i = 0; i < nremappers; i++) {
+		SAFE_PTHREAD_JOIN(remappers[i], NULL);
+		ops += remap_ops[i];
+	}
+
+	stop = 1;
+	for (i = 0; i < nreaders; i++)
+		SAFE_PTHREAD_JOIN(readers[i], NULL);
+
+	return ops;
+}
+
+static void run_phase(const char *name, long long (*phase)(void), int reps)
+{
+	struct counters before, after;
+	struct timespec t1, t2;
+	long long ops = 0, us;
+	int i;
+
+	read_counters(&before);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < reps; i++)
+		ops += phase();
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	read_counters(&after);
+
+	us = MAX(tst_timespec_diff_us(t2, t1), 1LL);
+
+	if (before.tlb >= 0 && after.tlb >= 0) {
+		tst_res(TINFO,
+			"%-6s: %6.0f remaps/s, minflt %7ld, majflt %3ld, tlb-shootdowns %lld",
+			name, 1000000.0 * ops / us,
+			after.minflt - before.minflt,
+			after.majflt - before.majflt,
+			after.tlb - before.tlb);
+	} else {
+		tst_res(TINFO,
+			"%-6s: %6.0f remaps/s, minflt %7ld, majflt %3ld, tlb-shootdowns n/a",
+			name, 1000000.0 * ops / us,
+			after.minflt - before.minflt,
+			after.majflt - before.majflt);
+	}
+}
+
+static void run(void)
+{
+	create_regions();
+
+	run_phase("grow", phase_grow, 1);
+	run_phase("shrink", phase_shrink, 1);
+	run_phase("move", phase_move, 1);
+
+	/* back to the floor sizes the mixed phase cycles from */
+	run_phase("mixed", phase_mixed, 1);
+
+	destroy_regions();
+
+	tst_res(TPASS, "%i THP and %i 4k regions survived the remap cycles",
+		nregions / 2, nregions - nregions / 2);
+}
+
+static void setup(void)
+{
+	if (str_nregions && tst_parse_int(str_nregions, &nregions, 2, 1024))
+		tst_brk(TBROK, "Invalid region count '%s'", str_nregions);
+
+	if (str_loops && tst_parse_int(str_loops, &loops, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid loop count '%s'", str_loops);
+
+	if (str_nremappers && tst_parse_int(str_nremappers, &nremappers,
+					    1, MAX_THREADS))
+		tst_brk(TBROK, "Invalid remapper count '%s'", str_nremappers);
+
+	if (str_nreaders && tst_parse_int(str_nreaders, &nreaders,
+					  1, MAX_THREADS))
+		tst_brk(TBROK, "Invalid reader count '%s'", str_nreaders);
+
+	regions = SAFE_MALLOC(nregions * sizeof(*regions));
+	memset(regions, 0, nregions * sizeof(*regions));
+}
+
+static void cleanup(void)
+{
+	free(regions);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.options = (struct tst_option[]) {
+		{"n:", &str_nregions, "-n N     Regions, half THP half 4k (default 32)"},
+		{"l:", &str_loops, "-l N     Grow/shrink cycles per remapper (default 20)"},
+		{"r:", &str_nremappers, "-r N     Remapper threads in the mixed phase (default 2)"},
+		{"d:", &str_nreaders, "-d N     Reader threads in the mixed phase (default 2)"},
+		{}
+	},
+};
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * page03 - parallel page fault scaling benchmark
+ *
+ * page01 and page02 exercise allocation in a single process, which says
+ * nothing about how the fault path scales on many-core machines. This
+ * test measures anonymous and file-backed minor fault throughput with N
+ * threads pinned one per CPU, each faulting in a disjoint region over
+ * and over, and prints a scaling curve for 1, 2, 4, ... up to all CPUs
+ * together with per-fault latency percentiles from the histogram
+ * framework.
+ *
+ * The file-backed pass maps disjoint ranges of one pre-written file, so
+ * the pages come from the page cache and the numbers measure the fault
+ * path rather than the storage.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+#define REGION_SIZE	(4 * 1024 * 1024)
+
+struct worker {
+	pthread_t tid;
+	int cpu;
+	off_t off;
+	struct tst_hist hist;
+	unsigned long faults;
+};
+
+static struct worker *workers;
+static pthread_barrier_t barrier;
+static struct tst_hist hist;
+static int max_workers;
+static long ncpus;
+static int loops = 4;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+static int file_fd = -1;
+static long pagesz;
+
+static char *str_workers;
+static char *str_loops;
+static char *str_bits;
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	struct timespec t1, t2;
+	cpu_set_t cpus;
+	char *addr;
+	long i;
+	int pass;
+
+	CPU_ZERO(&cpus);
+	CPU_SET(w->cpu, &cpus);
+	if (sched_setaffinity(0, sizeof(cpus), &cpus))
+		tst_res(TWARN | TERRNO, "sched_setaffinity(%d)", w->cpu);
+
+	pthread_barrier_wait(&barrier);
+
+	for (pass = 0; pass < loops; pass++) {
+		if (w->off >= 0) {
+			addr = SAFE_MMAP(NULL, REGION_SIZE, PROT_READ,
+					 MAP_PRIVATE, file_fd, w->off);
+		} else {
+			addr = SAFE_MMAP(NULL, REGION_SIZE,
+					 PROT_READ | PROT_WRITE,
+					 MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+		}
+
+		for (i = 0; i < REGION_SIZE; i += pagesz) {
+			tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+			if (w->off >= 0)
+				(void)*(volatile char *)(addr + i);
+			else
+				addr[i] = 1;
+			tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+			tst_hist_add(&w->hist, tst_timespec_diff_ns(t2, t1));
+			w->faults++;
+		}
+
+		SAFE_MUNMAP(addr, REGION_SIZE);
+	}
+
+	return NULL;
+}
+
+/*
+ * Returns the total fault rate in faults per second.
+ */
+static double run_workers(int nthreads, int file_backed)
+{
+	struct timespec t_start, t_stop;
+	unsigned long faults = 0;
+	long long elapsed_us;
+	int i;
+
+	pthread_barrier_init(&barrier, NULL, nthreads + 1);
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < nthreads; i++) {
+		workers[i].cpu = i % ncpus;
+		workers[i].off = file_backed ? (off_t)i * REGION_SIZE : -1;
+		workers[i].faults = 0;
+		tst_hist_reset(&workers[i].hist);
+
+		SAFE_PTHREAD_CREATE(&workers[i].tid, NULL, worker_fn,
+				    &workers[i]);
+	}
+
+	pthread_barrier_wait(&barrier);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_JOIN(workers[i].tid, NULL);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t_stop);
+	pthread_barrier_destroy(&barrier);
+
+	elapsed_us = MAX(tst_timespec_diff_us(t_stop, t_start), 1LL);
+
+	for (i = 0; i < nthreads; i++) {
+		faults += workers[i].faults;
+		tst_hist_merge(&hist, &workers[i].hist);
+	}
+
+	return 1000000.0 * faults / elapsed_us;
+}
+
+static void run_scaling_curve(int file_backed)
+{
+	double rate, base_rate = 0;
+	int n = 1;
+
+	tst_res(TINFO, "%s faults, %d..%d worker(s):",
+		file_backed ? "file-backed" : "anonymous", 1, max_workers);
+
+	while (n <= max_workers) {
+		rate = run_workers(n, file_backed);
+		if (n == 1)
+			base_rate = rate;
+
+		tst_res(TINFO,
+			"%3d worker(s): %8.0f kfaults/s (x%5.2f), p50 %lldns, p99 %lldns",
+			n, rate / 1000, rate / base_rate,
+			tst_hist_percentile(&hist, 50),
+			tst_hist_percentile(&hist, 99));
+
+		if (n == max_workers)
+			break;
+
+		n = MIN(2 * n, max_workers);
+	}
+}
+
+static void run(void)
+{
+	run_scaling_curve(0);
+	run_scaling_curve(1);
+
+	tst_res(TPASS, "fault scaling measured up to %d workers", max_workers);
+}
+
+static void setup(void)
+{
+	char buf[128 * 1024];
+	off_t left;
+	int i;
+
+	pagesz = getpagesize();
+	ncpus = tst_ncpus();
+	max_workers = ncpus;
+
+	if (str_workers) {
+		if (tst_parse_int(str_workers, &max_workers, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid worker count '%s'",
+				str_workers);
+	}
+
+	if (str_loops) {
+		if (tst_parse_int(str_loops, &loops, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid loop count '%s'", str_loops);
+	}
+
+	if (str_bits) {
+		if (tst_parse_int(str_bits, &hist_bits, 1, 16))
+			tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+	}
+
+	workers = SAFE_MALLOC(max_workers * sizeof(*workers));
+	for (i = 0; i < max_workers; i++)
+		tst_hist_init(&workers[i].hist, hist_bits);
+	tst_hist_init(&hist, hist_bits);
+
+	/* one shared file, each worker faults its own disjoint range */
+	file_fd = SAFE_OPEN("page03_file", O_RDWR | O_CREAT, 0600);
+	memset(buf, 'p', sizeof(buf));
+	left = (off_t)max_workers * REGION_SIZE;
+	while (left > 0) {
+		SAFE_WRITE(1, file_fd, buf, sizeof(buf));
+		left -= sizeof(buf);
+	}
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	if (file_fd >= 0)
+		SAFE_CLOSE(file_fd);
+
+	if (workers) {
+		for (i = 0; i < max_workers; i++)
+			tst_hist_free(&workers[i].hist);
+		free(workers);
+	}
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.options = (struct tst_option[]) {
+		{"p:", &str_workers, "-p N     Maximum number of worker threads (default: all CPUs)"},
+		{"l:", &str_loops, "-l N     Passes over the region per worker (default 4)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * shmt11 - cross-process shared memory copy bandwidth
+ *
+ * The other shmt tests verify shmat() semantics, this one measures them.
+ * The parent streams a buffer into a System V shared memory segment and
+ * a forked reader copies it back out, the two handshaking over a pipe
+ * pair, so every byte crosses the segment in both directions. The copy
+ * bandwidth is reported per size class and, with -H, additionally for
+ * SHM_HUGETLB backed segments, which turns regressions in the
+ * cross-process copy path (e.g. after THP changes) into a visible
+ * throughput drop instead of a silent slowdown.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_safe_sysv_ipc.h"
+#include "tst_timer.h"
+#include "tst_hugepage.h"
+
+/* how much data to move through each segment size class */
+#define TARGET_BYTES	(256UL * 1024 * 1024)
+
+static const size_t size_classes[] = {
+	64 * 1024,
+	1024 * 1024,
+	16 * 1024 * 1024,
+};
+
+static char *opt_huge;
+static char *str_target;
+static long target_bytes = TARGET_BYTES;
+static char *src, *dst;
+
+static void reader(int shmid, size_t size, unsigned int iters,
+		   int rfd, int wfd)
+{
+	char *seg, c;
+	unsigned int i;
+
+	seg = SAFE_SHMAT(shmid, NULL, SHM_RDONLY);
+
+	for (i = 0; i < iters; i++) {
+		SAFE_READ(1, rfd, &c, 1);
+		memcpy(dst, seg, size);
+		SAFE_WRITE(1, wfd, &c, 1);
+	}
+
+	SAFE_SHMDT(seg);
+}
+
+static void stream_segment(size_t size, int huge)
+{
+	int shmid, shmflg = IPC_CREAT | IPC_EXCL | 0600;
+	int to_child[2], to_parent[2];
+	unsigned int i, iters = MAX(1ul, target_bytes / size);
+	long long us;
+	char *seg, c = 0;
+	pid_t pid;
+
+	if (huge)
+		shmflg |= SHM_HUGETLB;
+
+	shmid = shmget(IPC_PRIVATE, size, shmflg);
+	if (shmid == -1) {
+		if (huge) {
+			tst_res(TCONF | TERRNO,
+				"no SHM_HUGETLB segment of %zu bytes", size);
+			return;
+		}
+		tst_brk(TBROK | TERRNO, "shmget(%zu)", size);
+	}
+
+	seg = SAFE_SHMAT(shmid, NULL, 0);
+
+	SAFE_PIPE(to_child);
+	SAFE_PIPE(to_parent);
+
+	pid = SAFE_FORK();
+	if (!pid) {
+		SAFE_CLOSE(to_child[1]);
+		SAFE_CLOSE(to_parent[0]);
+		reader(shmid, size, iters, to_child[0], to_parent[1]);
+		exit(0);
+	}
+
+	SAFE_CLOSE(to_child[0]);
+	SAFE_CLOSE(to_parent[1]);
+
+	tst_timer_start(CLOCK_MONOTONIC);
+
+	for (i = 0; i < iters; i++) {
+		memcpy(seg, src, size);
+		SAFE_WRITE(1, to_child[1], &c, 1);
+		SAFE_READ(1, to_parent[0], &c, 1);
+	}
+
+	tst_timer_stop();
+	us = tst_timer_elapsed_us();
+	if (!us)
+		us = 1;
+
+	tst_reap_children();
+
+	SAFE_CLOSE(to_child[1]);
+	SAFE_CLOSE(to_parent[0]);
+	SAFE_SHMDT(seg);
+	SAFE_SHMCTL(shmid, IPC_RMID, NULL);
+
+	/* each iteration copies the segment in and back out again */
+	tst_res(TINFO, "%8zu KB%s: %u iterations in %llius, %.2f GB/s",
+		size / 1024, huge ? " (hugetlb)" : "          ", iters, us,
+		2.0 * iters * size * 1000000 / us / (1024 * 1024 * 1024));
+}
+
+static void run(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(size_classes); i++)
+		stream_segment(size_classes[i], 0);
+
+	if (opt_huge) {
+		size_t hpage_size = tst_get_hugepage_size();
+
+		if (!hpage_size) {
+			tst_res(TCONF, "no hugepage support");
+		} else {
+			size_t size, prev = 0;
+
+			for (i = 0; i < ARRAY_SIZE(size_classes); i++) {
+				size = size_classes[i];
+
+				if (size % hpage_size)
+					size = (size / hpage_size + 1)
+						* hpage_size;
+
+				/* small classes can round to the same size */
+				if (size == prev)
+					continue;
+
+				stream_segment(size, 1);
+				prev = size;
+			}
+		}
+	}
+
+	tst_res(TPASS, "shared memory bandwidth measured");
+}
+
+static void setup(void)
+{
+	size_t max_size = size_classes[ARRAY_SIZE(size_classes) - 1];
+
+	if (str_target) {
+		if (tst_parse_long(str_target, &target_bytes, 1, LONG_MAX))
+			tst_brk(TBROK, "Invalid target size '%s'", str_target);
+	}
+
+	if (opt_huge) {
+		size_t hpage_size = tst_get_hugepage_size();
+
+		if (hpage_size) {
+			if (max_size % hpage_size)
+				max_size = (max_size / hpage_size + 1)
+					* hpage_size;
+			tst_request_hugepages(max_size / hpage_size);
+		}
+	}
+
+	src = SAFE_MALLOC(max_size);
+	dst = SAFE_MALLOC(max_size);
+	memset(src, 'x', max_size);
+	memset(dst, 0, max_size);
+}
+
+static void cleanup(void)
+{
+	free(dst);
+	free(src);
+}
+
+static struct tst_test test = {
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"n:", &str_target, "-n BYTES Data to stream per size class (default 256MB)"},
+		{"H", &opt_huge, "-H       Also measure SHM_HUGETLB backed segments"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
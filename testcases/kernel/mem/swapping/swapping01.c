@@ -36,6 +36,12 @@
  * available memory. After allocation done, continue loop for a while
  * and calculate the used swap size. The used swap size should be small
  * enough, else it indicates that heavy swapping is occured unexpectedly.
+ *
+ * The allocating child is clamped by a memcg limit set to the available
+ * memory, so the overshoot is swapped out by targeted cgroup reclaim as
+ * the allocation proceeds instead of waiting for global reclaim to find
+ * the pages, which keeps the swap pressure deterministic and quick even
+ * on zram-backed swap.
  */
 
 #include <sys/types.h>
@@ -103,6 +109,9 @@ static void do_alloc(void)
 	long mem_count;
 	void *s;
 
+	tst_cgroup_move_current(PATH_TMP_CG_MEM);
+	tst_cgroup_mem_set_maxbytes(PATH_TMP_CG_MEM, mem_available_init * KB);
+
 	tst_res(TINFO, "available physical memory: %ld MB",
 		mem_available_init / 1024);
 	mem_count = mem_available_init + mem_over;
@@ -125,11 +134,15 @@ static void check_swapping(void)
 	if (!WIFSTOPPED(status))
 		tst_brk(TBROK, "child was not stopped.");
 
-	/* Still occupying memory, loop for a while */
+	/*
+	 * Still occupying memory, poll until the swap usage settles; the
+	 * fine interval spots the end of the swap-out burst right away
+	 * instead of rounding the wait up to whole seconds.
+	 */
 	i = 0;
-	while (i < 10) {
+	while (i < 100) {
 		swap_free_now = SAFE_READ_MEMINFO("SwapFree:");
-		sleep(1);
+		usleep(100000);
 		if (labs(swap_free_now - SAFE_READ_MEMINFO("SwapFree:")) < 512)
 			break;
 
@@ -151,8 +164,20 @@ static void check_swapping(void)
 	SAFE_WAITPID(pid, &status, 0);
 }
 
+static void setup(void)
+{
+	tst_cgroup_mount(TST_CGROUP_MEMCG, PATH_TMP_CG_MEM);
+}
+
+static void cleanup(void)
+{
+	tst_cgroup_umount(PATH_TMP_CG_MEM);
+}
+
 static struct tst_test test = {
 	.needs_root = 1,
 	.forks_child = 1,
+	.setup = setup,
+	.cleanup = cleanup,
 	.test_all = test_swapping,
 };
@@ -0,0 +1,303 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * pm_cpuidle_latency - cpuidle wake-up latency benchmark
+ *
+ * The power_management scripts check the cpuidle sysfs plumbing but
+ * never measure what an idle state costs to leave. This benchmark pins
+ * a waker and a sleeper to two different CPUs and, for every idle state
+ * of the sleeper's CPU, caps the allowed exit latency at that state's
+ * latency through /dev/cpu_dma_latency, lets the sleeper block on a
+ * futex long enough for its CPU to go idle, and measures the time from
+ * the waker's FUTEX_WAKE (which sends a rescheduling IPI to the idle
+ * CPU) until the sleeper is running again. The per-state percentiles
+ * expose firmware or driver regressions in the idle exit path that
+ * functional tests cannot see.
+ *
+ * The QoS cap only bounds how deep the sleeper's CPU may sleep, the
+ * governor still picks the state, so the state usage counters are
+ * sampled around each run to show where the time was really spent.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+#include "lapi/futex.h"
+
+#define CPU_DMA_LATENCY "/dev/cpu_dma_latency"
+#define CPUIDLE_PATH "/sys/devices/system/cpu/cpu%d/cpuidle/state%d/%s"
+
+#define MAX_STATES 16
+
+struct cstate {
+	char name[64];
+	int latency;		/* worst case exit latency, us */
+	int residency;		/* target residency, us */
+};
+
+static struct cstate states[MAX_STATES];
+static int nstates;
+
+static int waker_cpu = -1;
+static int sleeper_cpu = -1;
+static int nwakes = 500;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static char *str_waker_cpu;
+static char *str_sleeper_cpu;
+static char *str_nwakes;
+static char *str_bits;
+
+static struct tst_hist hist;
+static int qos_fd = -1;
+static pthread_t sleeper;
+
+static futex_t wake_seq;
+static volatile uint32_t ack_seq;
+static volatile int stop;
+static struct timespec wake_ts;
+
+static void pin_to_cpu(int cpu)
+{
+	cpu_set_t mask;
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+
+	if (sched_setaffinity(0, sizeof(mask), &mask))
+		tst_brk(TBROK | TERRNO, "sched_setaffinity(CPU %i)", cpu);
+}
+
+static void *sleeper_thread(void *arg LTP_ATTRIBUTE_UNUSED)
+{
+	struct timespec now;
+	uint32_t seen = 0;
+
+	pin_to_cpu(sleeper_cpu);
+
+	for (;;) {
+		/* EAGAIN and EINTR just mean another look at the sequence */
+		while (wake_seq == seen) {
+			syscall(SYS_futex, &wake_seq,
+				FUTEX_WAIT | FUTEX_PRIVATE_FLAG,
+				seen, NULL, NULL, 0);
+		}
+		tst_clock_gettime(CLOCK_MONOTONIC, &now);
+		seen = wake_seq;
+
+		if (stop)
+			break;
+
+		tst_hist_add(&hist, MAX(tst_timespec_diff_ns(now, wake_ts),
+					0LL));
+		__sync_synchronize();
+		ack_seq++;
+	}
+
+	return NULL;
+}
+
+static void wake_sleeper(void)
+{
+	tst_clock_gettime(CLOCK_MONOTONIC, &wake_ts);
+	__sync_synchronize();
+	wake_seq++;
+	syscall(SYS_futex, &wake_seq, FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+		1, NULL, NULL, 0);
+}
+
+static long long state_file(int state, const char *file)
+{
+	char path[PATH_MAX];
+	long long val;
+
+	snprintf(path, sizeof(path), CPUIDLE_PATH, sleeper_cpu, state, file);
+	SAFE_FILE_SCANF(path, "%lld", &val);
+	return val;
+}
+
+static void bench_state(int state)
+{
+	long long usage, entered;
+	char qos_val[32];
+	uint32_t acked;
+	int i, settle_us;
+
+	/*
+	 * Allow idle states up to and including this one; the write
+	 * updates the request the open fd holds.
+	 */
+	snprintf(qos_val, sizeof(qos_val), "%d", states[state].latency);
+	SAFE_WRITE(1, qos_fd, qos_val, strlen(qos_val));
+
+	/*
+	 * Give the governor a reason to pick the deepest allowed state,
+	 * but keep shallow states from stretching the run.
+	 */
+	settle_us = MAX(2 * states[state].residency, 200);
+	settle_us = MIN(settle_us, 10000);
+
+	usage = state_file(state, "usage");
+
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < nwakes; i++) {
+		usleep(settle_us);
+		acked = ack_seq;
+		wake_sleeper();
+		while (ack_seq == acked)
+			sched_yield();
+	}
+
+	entered = state_file(state, "usage") - usage;
+
+	tst_res(TINFO,
+		"%-12s (exit lat %5ius): wake p50 %7lldns, p99 %7lldns, max %7lldns, entered %lld times",
+		states[state].name, states[state].latency,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 100),
+		entered);
+}
+
+static void run(void)
+{
+	int i;
+
+	for (i = 0; i < nstates; i++)
+		bench_state(i);
+
+	tst_res(TPASS, "measured %i wakeups of CPU %i per idle state",
+		nwakes, sleeper_cpu);
+}
+
+static void pick_cpu_pair(void)
+{
+	cpu_set_t mask;
+	int cpu;
+
+	if (sched_getaffinity(0, sizeof(mask), &mask))
+		tst_brk(TBROK | TERRNO, "sched_getaffinity()");
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &mask))
+			continue;
+		if (waker_cpu < 0) {
+			waker_cpu = cpu;
+			continue;
+		}
+		if (sleeper_cpu < 0 && cpu != waker_cpu) {
+			sleeper_cpu = cpu;
+			break;
+		}
+	}
+
+	if (waker_cpu < 0 || sleeper_cpu < 0 || waker_cpu == sleeper_cpu)
+		tst_brk(TCONF, "at least two online CPUs are needed");
+}
+
+static void read_states(void)
+{
+	char path[PATH_MAX];
+	int i;
+
+	snprintf(path, sizeof(path), CPUIDLE_PATH, sleeper_cpu, 0, "name");
+	if (access(path, F_OK))
+		tst_brk(TCONF, "no cpuidle states for CPU %i (no idle driver?)",
+			sleeper_cpu);
+
+	for (i = 0; i < MAX_STATES; i++) {
+		snprintf(path, sizeof(path), CPUIDLE_PATH, sleeper_cpu, i,
+			 "name");
+		if (access(path, F_OK))
+			break;
+
+		SAFE_FILE_SCANF(path, "%63s", states[i].name);
+		states[i].latency = state_file(i, "latency");
+		states[i].residency = state_file(i, "residency");
+	}
+	nstates = i;
+
+	tst_res(TINFO, "CPU %i wakes CPU %i through %i idle states",
+		waker_cpu, sleeper_cpu, nstates);
+}
+
+static void setup(void)
+{
+	if (str_waker_cpu && tst_parse_int(str_waker_cpu, &waker_cpu, 0,
+					   CPU_SETSIZE - 1))
+		tst_brk(TBROK, "Invalid waker CPU '%s'", str_waker_cpu);
+
+	if (str_sleeper_cpu && tst_parse_int(str_sleeper_cpu, &sleeper_cpu, 0,
+					     CPU_SETSIZE - 1))
+		tst_brk(TBROK, "Invalid sleeper CPU '%s'", str_sleeper_cpu);
+
+	if (str_nwakes && tst_parse_int(str_nwakes, &nwakes, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid wakeup count '%s'", str_nwakes);
+
+	if (str_bits && tst_parse_int(str_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+
+	if (waker_cpu < 0 || sleeper_cpu < 0)
+		pick_cpu_pair();
+
+	if (waker_cpu == sleeper_cpu)
+		tst_brk(TBROK, "waker and sleeper CPU have to differ");
+
+	read_states();
+
+	qos_fd = open(CPU_DMA_LATENCY, O_WRONLY);
+	if (qos_fd == -1) {
+		if (errno == ENOENT)
+			tst_brk(TCONF, CPU_DMA_LATENCY " is not available");
+		tst_brk(TBROK | TERRNO, "open(" CPU_DMA_LATENCY ")");
+	}
+
+	tst_hist_init(&hist, hist_bits);
+
+	pin_to_cpu(waker_cpu);
+	SAFE_PTHREAD_CREATE(&sleeper, NULL, sleeper_thread, NULL);
+}
+
+static void cleanup(void)
+{
+	if (sleeper) {
+		stop = 1;
+		wake_sleeper();
+		SAFE_PTHREAD_JOIN(sleeper, NULL);
+	}
+
+	/* closing the fd drops the QoS request */
+	if (qos_fd != -1)
+		SAFE_CLOSE(qos_fd);
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.needs_root = 1,
+	.options = (struct tst_option[]) {
+		{"w:", &str_waker_cpu, "-w CPU   Waker CPU (default: first usable)"},
+		{"c:", &str_sleeper_cpu, "-c CPU   Sleeper CPU (default: second usable)"},
+		{"n:", &str_nwakes, "-n N     Wakeups per idle state (default 500)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+};
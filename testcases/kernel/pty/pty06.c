@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * PTY throughput flood test.
+ *
+ * pty01 checks master/slave semantics with small writes; this test streams
+ * bulk data through the n_tty line discipline instead, so slowdowns on the
+ * tty receive path show up as a throughput drop. A child floods the master
+ * with large vectored writes while the parent drains the slave, once in raw
+ * mode and once in canonical mode with newline-terminated lines. For each
+ * mode the achieved MB/s and the average bytes delivered per reader wakeup
+ * (read() return) are reported.
+ *
+ * Echo is disabled so the flood does not feed back into the master read
+ * queue and deadlock the writer.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+
+#include "tst_test.h"
+#include "tst_clocks.h"
+#include "tst_timer.h"
+
+#define MASTERCLONE "/dev/ptmx"
+
+#define NVEC 16
+#define LINE_LEN 256
+#define READBUF_SIZE 65536
+
+static char *str_megabytes;
+static char *str_wsize;
+static int megabytes = 16;
+static int wsize = 65536;
+
+static char *writebuf;
+static char *readbuf;
+
+static void flood_master(int masterfd, long long left)
+{
+	struct iovec iov[NVEC];
+	size_t chunk, piece;
+	ssize_t ret;
+	int i;
+
+	while (left > 0) {
+		chunk = MIN((long long)wsize, left);
+		piece = (chunk + NVEC - 1) / NVEC;
+
+		for (i = 0; i < NVEC && chunk > 0; i++) {
+			iov[i].iov_base = writebuf + i * piece;
+			iov[i].iov_len = MIN(piece, chunk);
+			chunk -= iov[i].iov_len;
+		}
+
+		ret = writev(masterfd, iov, i);
+		if (ret < 0)
+			tst_brk(TBROK | TERRNO, "writev(masterfd)");
+
+		left -= ret;
+	}
+}
+
+static void drain_slave(int slavefd, const char *mode, long long goal)
+{
+	struct timespec ts_start, ts_end;
+	long long total = 0;
+	unsigned long long wakeups = 0, usec;
+	ssize_t ret;
+
+	tst_clock_gettime_fast(CLOCK_MONOTONIC, &ts_start);
+
+	while (total < goal) {
+		ret = SAFE_READ(0, slavefd, readbuf, READBUF_SIZE);
+		if (ret == 0)
+			tst_brk(TBROK, "EOF on slave after %lli bytes", total);
+		total += ret;
+		wakeups++;
+	}
+
+	tst_clock_gettime_fast(CLOCK_MONOTONIC, &ts_end);
+	usec = tst_timespec_diff_us(ts_end, ts_start);
+	if (!usec)
+		usec = 1;
+
+	tst_res(TINFO,
+		"%s mode: %lli bytes in %llu us: %.1f MB/s, %.1f bytes/wakeup (%llu wakeups)",
+		mode, total, usec,
+		(double)total / usec * 1000000 / (1024 * 1024),
+		(double)total / wakeups, wakeups);
+
+	if (total == goal)
+		tst_res(TPASS, "%s mode: all %lli bytes received", mode, goal);
+	else
+		tst_res(TFAIL, "%s mode: received %lli bytes, expected %lli",
+			mode, total, goal);
+}
+
+static void do_test(unsigned int n)
+{
+	struct termios io;
+	const char *mode = n ? "canonical" : "raw";
+	long long goal = (long long)megabytes * 1024 * 1024;
+	int masterfd, slavefd;
+	int pid;
+
+	masterfd = SAFE_OPEN(MASTERCLONE, O_RDWR);
+
+	if (grantpt(masterfd) != 0)
+		tst_brk(TBROK | TERRNO, "grantpt() failed");
+	if (unlockpt(masterfd) != 0)
+		tst_brk(TBROK | TERRNO, "unlockpt() failed");
+
+	slavefd = SAFE_OPEN(ptsname(masterfd), O_RDWR);
+
+	if (tcgetattr(slavefd, &io) != 0)
+		tst_brk(TBROK | TERRNO, "tcgetattr() failed");
+
+	if (n) {
+		/* canonical reads, no echo back to the master */
+		io.c_lflag = ICANON;
+	} else {
+		cfmakeraw(&io);
+	}
+
+	if (tcsetattr(slavefd, TCSANOW, &io) != 0)
+		tst_brk(TBROK | TERRNO, "tcsetattr() failed");
+
+	pid = SAFE_FORK();
+	if (!pid) {
+		SAFE_CLOSE(slavefd);
+		flood_master(masterfd, goal);
+		exit(0);
+	}
+
+	drain_slave(slavefd, mode, goal);
+
+	tst_reap_children();
+	SAFE_CLOSE(slavefd);
+	SAFE_CLOSE(masterfd);
+}
+
+static void setup(void)
+{
+	int i;
+
+	if (tst_parse_int(str_megabytes, &megabytes, 1, 16384))
+		tst_brk(TBROK, "Invalid stream size '%s'", str_megabytes);
+
+	if (tst_parse_int(str_wsize, &wsize, LINE_LEN, 16 * 1024 * 1024))
+		tst_brk(TBROK, "Invalid write size '%s'", str_wsize);
+
+	wsize -= wsize % LINE_LEN;
+
+	writebuf = SAFE_MALLOC(wsize);
+	readbuf = SAFE_MALLOC(READBUF_SIZE);
+
+	/*
+	 * Printable filler with a newline every LINE_LEN bytes, so the
+	 * same stream works for both raw and canonical mode. Control
+	 * characters are avoided since canonical input processing would
+	 * consume them.
+	 */
+	memset(writebuf, 'x', wsize);
+	for (i = LINE_LEN - 1; i < wsize; i += LINE_LEN)
+		writebuf[i] = '\n';
+}
+
+static void cleanup(void)
+{
+	free(writebuf);
+	free(readbuf);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test = do_test,
+	.tcnt = 2,
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"m:", &str_megabytes, "Megabytes to stream per mode (default 16)"},
+		{"s:", &str_wsize, "writev() size in bytes (default 64k)"},
+		{NULL, NULL, NULL}
+	},
+};
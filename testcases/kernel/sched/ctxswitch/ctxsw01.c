@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * ctxsw01 - pinned context-switch ping-pong benchmark
+ *
+ * Two processes bounce a token back and forth, either through a pair of
+ * futex words in a shared page or through a pair of pipes, and the
+ * round-trip time of every bounce goes into a histogram. One round trip
+ * is two context switches, so the switch rate and the latency
+ * percentiles fall straight out of the measurement.
+ *
+ * The pair is pinned on the same CPU (pure switch cost, no IPI), on SMT
+ * siblings and on two different cores, read from the sysfs topology
+ * files, since the three placements regress independently. Placements
+ * the machine does not have are skipped.
+ */
+
+#define _GNU_SOURCE
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+#include "lapi/futex.h"
+
+#define TOPOLOGY_PATH "/sys/devices/system/cpu/cpu%d/topology/"
+
+enum bounce_mode {
+	MODE_FUTEX,
+	MODE_PIPE,
+};
+
+struct bounce {
+	futex_t ping;
+	futex_t pong;
+};
+
+static struct bounce *bnc;
+static struct tst_hist hist;
+static int pipe_ping[2];
+static int pipe_pong[2];
+static int iters = 20000;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+static int cpu_base = -1, cpu_smt = -1, cpu_cross = -1;
+
+static char *str_iters;
+static char *str_bits;
+
+static void futex_wait(futex_t *addr, uint32_t val)
+{
+	syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+static void futex_wake(futex_t *addr, int nr)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE, nr, NULL, NULL, 0);
+}
+
+static void pin_to_cpu(int cpu)
+{
+	cpu_set_t cpus;
+
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	if (sched_setaffinity(0, sizeof(cpus), &cpus))
+		tst_brk(TBROK | TERRNO, "sched_setaffinity(%d)", cpu);
+}
+
+static void bounce_child(enum bounce_mode mode, int cpu)
+{
+	char c;
+	uint32_t i;
+
+	pin_to_cpu(cpu);
+
+	for (i = 1; i <= (uint32_t)iters; i++) {
+		if (mode == MODE_FUTEX) {
+			while (bnc->ping != i)
+				futex_wait(&bnc->ping, i - 1);
+			bnc->pong = i;
+			futex_wake(&bnc->pong, 1);
+		} else {
+			SAFE_READ(1, pipe_ping[0], &c, 1);
+			SAFE_WRITE(1, pipe_pong[1], &c, 1);
+		}
+	}
+}
+
+static void bounce_parent(enum bounce_mode mode)
+{
+	struct timespec t1, t2;
+	char c = 'x';
+	uint32_t i;
+
+	for (i = 1; i <= (uint32_t)iters; i++) {
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		if (mode == MODE_FUTEX) {
+			bnc->ping = i;
+			futex_wake(&bnc->ping, 1);
+			while (bnc->pong != i)
+				futex_wait(&bnc->pong, i - 1);
+		} else {
+			SAFE_WRITE(1, pipe_ping[1], &c, 1);
+			SAFE_READ(1, pipe_pong[0], &c, 1);
+		}
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+		tst_hist_add(&hist, tst_timespec_diff_ns(t2, t1));
+	}
+}
+
+static void run_pair(enum bounce_mode mode, const char *placement,
+		     int cpu_a, int cpu_b)
+{
+	struct timespec t1, t2;
+	long long elapsed_us;
+	cpu_set_t saved;
+
+	if (sched_getaffinity(0, sizeof(saved), &saved))
+		tst_brk(TBROK | TERRNO, "sched_getaffinity()");
+
+	bnc->ping = 0;
+	bnc->pong = 0;
+	tst_hist_reset(&hist);
+
+	if (mode == MODE_PIPE) {
+		SAFE_PIPE(pipe_ping);
+		SAFE_PIPE(pipe_pong);
+	}
+
+	if (!SAFE_FORK()) {
+		bounce_child(mode, cpu_b);
+		exit(0);
+	}
+
+	pin_to_cpu(cpu_a);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	bounce_parent(mode);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	tst_reap_children();
+
+	if (mode == MODE_PIPE) {
+		SAFE_CLOSE(pipe_ping[0]);
+		SAFE_CLOSE(pipe_ping[1]);
+		SAFE_CLOSE(pipe_pong[0]);
+		SAFE_CLOSE(pipe_pong[1]);
+	}
+
+	if (sched_setaffinity(0, sizeof(saved), &saved))
+		tst_brk(TBROK | TERRNO, "sched_setaffinity() restore");
+
+	elapsed_us = MAX(tst_timespec_diff_us(t2, t1), 1LL);
+
+	tst_res(TINFO,
+		"%-5s %-11s: %8.0f switches/s, rtt p50 %6lldns, p99 %6lldns",
+		mode == MODE_FUTEX ? "futex" : "pipe", placement,
+		2000000.0 * iters / elapsed_us,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99));
+}
+
+static void run(void)
+{
+	enum bounce_mode mode;
+
+	for (mode = MODE_FUTEX; mode <= MODE_PIPE; mode++) {
+		run_pair(mode, "same-cpu", cpu_base, cpu_base);
+
+		if (cpu_smt >= 0)
+			run_pair(mode, "smt-sibling", cpu_base, cpu_smt);
+
+		if (cpu_cross >= 0)
+			run_pair(mode, "cross-core", cpu_base, cpu_cross);
+	}
+
+	if (cpu_smt < 0)
+		tst_res(TINFO, "No SMT sibling of CPU%d, placement skipped",
+			cpu_base);
+	if (cpu_cross < 0)
+		tst_res(TINFO, "No second core, cross-core placement skipped");
+
+	tst_res(TPASS, "context switch cost measured over %d round trips",
+		iters);
+}
+
+/*
+ * Picks the first usable CPU as the base, its SMT sibling and the first
+ * CPU on a different core. CPUs sharing package and core id are
+ * siblings; without topology files every other CPU counts as a
+ * different core.
+ */
+static void pick_cpus(void)
+{
+	char path[PATH_MAX];
+	int base_core = -1, base_pkg = -1;
+	int core, pkg, cpu;
+	int have_topology;
+	cpu_set_t cpus;
+
+	if (sched_getaffinity(0, sizeof(cpus), &cpus))
+		tst_brk(TBROK | TERRNO, "sched_getaffinity()");
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &cpus))
+			continue;
+
+		snprintf(path, sizeof(path),
+			 TOPOLOGY_PATH "core_id", cpu);
+		have_topology = !access(path, R_OK);
+
+		core = pkg = -1;
+		if (have_topology) {
+			SAFE_FILE_SCANF(path, "%d", &core);
+			snprintf(path, sizeof(path),
+				 TOPOLOGY_PATH "physical_package_id", cpu);
+			SAFE_FILE_SCANF(path, "%d", &pkg);
+		}
+
+		if (cpu_base < 0) {
+			cpu_base = cpu;
+			base_core = core;
+			base_pkg = pkg;
+			continue;
+		}
+
+		if (have_topology && core == base_core && pkg == base_pkg) {
+			if (cpu_smt < 0)
+				cpu_smt = cpu;
+		} else {
+			if (cpu_cross < 0)
+				cpu_cross = cpu;
+		}
+
+		if (cpu_smt >= 0 && cpu_cross >= 0)
+			break;
+	}
+}
+
+static void setup(void)
+{
+	if (str_iters) {
+		if (tst_parse_int(str_iters, &iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid round trip count '%s'",
+				str_iters);
+	}
+
+	if (str_bits) {
+		if (tst_parse_int(str_bits, &hist_bits, 1, 16))
+			tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+	}
+
+	pick_cpus();
+	if (cpu_base < 0)
+		tst_brk(TBROK, "No usable CPU found");
+
+	bnc = SAFE_MMAP(NULL, getpagesize(), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	tst_hist_init(&hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	if (bnc)
+		SAFE_MUNMAP(bnc, getpagesize());
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"r:", &str_iters, "-r N     Round trips per mode and placement (default 20000)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * process_scale - parallel process tree creation and wakeup benchmark
+ *
+ * process.c builds its tree one process at a time and coordinates over
+ * SysV messages and signals, so the setup cost dominates well before
+ * the scheduler becomes the bottleneck. Here every node forks its
+ * children concurrently, so whole subtrees are created in parallel, and
+ * the tree synchronizes on futex-based generation barriers in a shared
+ * page instead of signals.
+ *
+ * Two numbers are reported: the creation rate of the tree, and the
+ * wakeup propagation time of each generation, measured from the single
+ * FUTEX_WAKE in the root until the last process has checked in at the
+ * barrier again. The propagation time is what grows when scheduler
+ * wakeup changes regress at high process counts.
+ */
+
+#define _GNU_SOURCE
+#include <linux/futex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_atomic.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+#include "lapi/futex.h"
+
+struct shared {
+	futex_t gen;		/* generation counter, bumped by the root */
+	futex_t done;		/* root waits here for the last arrival */
+	int arrived;		/* processes checked in this generation */
+};
+
+static struct shared *shp;
+static struct tst_hist hist;
+static int fanout = 10;
+static int depth = 3;
+static int gens = 50;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+static long nprocs;
+
+static char *str_fanout;
+static char *str_depth;
+static char *str_gens;
+static char *str_bits;
+
+static void futex_wait(futex_t *addr, uint32_t val)
+{
+	syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+static void futex_wake(futex_t *addr, int nr)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE, nr, NULL, NULL, 0);
+}
+
+/*
+ * The last process to arrive hands control back to the root.
+ */
+static void arrive(void)
+{
+	if (tst_atomic_add_return(1, &shp->arrived) == nprocs) {
+		shp->done = 1;
+		futex_wake(&shp->done, 1);
+	}
+}
+
+static void wait_all_arrived(void)
+{
+	while (!shp->done)
+		futex_wait(&shp->done, 0);
+}
+
+static void spawn_children(int level)
+{
+	int i;
+
+	for (i = 0; i < fanout; i++) {
+		if (!SAFE_FORK()) {
+			uint32_t mygen = 0;
+
+			if (level > 1)
+				spawn_children(level - 1);
+
+			arrive();
+
+			for (;;) {
+				while (shp->gen == mygen)
+					futex_wait(&shp->gen, mygen);
+				mygen = shp->gen;
+
+				if (mygen > (uint32_t)gens)
+					break;
+
+				arrive();
+			}
+
+			tst_reap_children();
+			exit(0);
+		}
+	}
+}
+
+static void run(void)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	int g;
+
+	shp->gen = 0;
+	shp->done = 0;
+	shp->arrived = 0;
+	tst_hist_reset(&hist);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	spawn_children(depth);
+	wait_all_arrived();
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+	tst_res(TINFO,
+		"spawned %ld processes (fanout %d, depth %d) in %llims (%.0f procs/s)",
+		nprocs, fanout, depth, elapsed_ms,
+		1000.0 * nprocs / elapsed_ms);
+
+	for (g = 1; g <= gens + 1; g++) {
+		shp->done = 0;
+		shp->arrived = 0;
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		shp->gen = g;
+		futex_wake(&shp->gen, INT_MAX);
+
+		if (g > gens)
+			break;
+
+		wait_all_arrived();
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		tst_hist_add(&hist, tst_timespec_diff_us(t2, t1));
+	}
+
+	tst_reap_children();
+
+	tst_res(TINFO,
+		"%d wakeup generations: propagation p50 %lldus, p99 %lldus",
+		gens,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99));
+
+	tst_res(TPASS, "%ld processes survived %d wakeup generations",
+		nprocs, gens);
+}
+
+static void setup(void)
+{
+	long l;
+	int i;
+
+	if (str_fanout) {
+		if (tst_parse_int(str_fanout, &fanout, 1, 100))
+			tst_brk(TBROK, "Invalid fanout '%s'", str_fanout);
+	}
+
+	if (str_depth) {
+		if (tst_parse_int(str_depth, &depth, 1, 10))
+			tst_brk(TBROK, "Invalid tree depth '%s'", str_depth);
+	}
+
+	if (str_gens) {
+		if (tst_parse_int(str_gens, &gens, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid generation count '%s'",
+				str_gens);
+	}
+
+	if (str_bits) {
+		if (tst_parse_int(str_bits, &hist_bits, 1, 16))
+			tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+	}
+
+	nprocs = 0;
+	l = 1;
+	for (i = 1; i <= depth; i++) {
+		l *= fanout;
+		nprocs += l;
+		if (nprocs > 1024 * 1024) {
+			tst_brk(TBROK,
+				"Fanout %d and depth %d give more than 1Mi processes",
+				fanout, depth);
+		}
+	}
+
+	shp = SAFE_MMAP(NULL, getpagesize(), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	tst_hist_init(&hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	if (shp)
+		SAFE_MUNMAP(shp, getpagesize());
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"b:", &str_fanout, "-b N     Children per process (default 10)"},
+		{"d:", &str_depth, "-d N     Depth of the process tree (default 3)"},
+		{"g:", &str_gens, "-g N     Wakeup generations to measure (default 50)"},
+		{"o:", &str_bits, "-o bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
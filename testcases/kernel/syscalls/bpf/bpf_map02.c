@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * BPF map operation throughput benchmark.
+ *
+ * bpf_map01 sanity checks single element operations, so hash-map
+ * update throughput under contention - the hot path of tracing and
+ * observability agents - has no signal in LTP. For hash, array and
+ * LRU hash maps this test measures update, lookup and (where the map
+ * type supports it) delete rates with one thread per CPU hammering a
+ * shared map over disjoint key ranges, and the single-threaded rates
+ * of the BPF_MAP_*_BATCH commands that move many elements per
+ * syscall. Everything is reported as ops/sec per map type.
+ *
+ * Kernels without the batch commands (added in v5.6) only skip those
+ * columns.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "config.h"
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/bpf.h"
+#include "bpf_common.h"
+
+#define KEY_SZ 4
+#define VAL_SZ 8
+#define BATCH_SZ 256
+
+enum bench_op {
+	OP_UPDATE,
+	OP_LOOKUP,
+	OP_DELETE,
+};
+
+static const char *const op_names[] = { "update", "lookup", "delete" };
+
+struct map_type {
+	uint32_t id;
+	char *name;
+	int has_delete;
+};
+
+static const struct map_type map_types[] = {
+	{BPF_MAP_TYPE_HASH, "hash", 1},
+	{BPF_MAP_TYPE_ARRAY, "array", 0},
+	{BPF_MAP_TYPE_LRU_HASH, "lru_hash", 1},
+};
+
+static uint32_t nentries = 8192;
+static int nthreads;
+static int iters = 50000;
+
+static int map_fd;
+static enum bench_op cur_op;
+static pthread_barrier_t barrier;
+
+static char *str_entries;
+static char *str_threads;
+static char *str_iters;
+
+static void map_op(enum bench_op op, uint32_t key)
+{
+	union bpf_attr attr;
+	uint64_t val = key;
+	int ret;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = map_fd;
+	attr.key = ptr_to_u64(&key);
+
+	switch (op) {
+	case OP_UPDATE:
+		attr.value = ptr_to_u64(&val);
+		attr.flags = BPF_ANY;
+		ret = bpf(BPF_MAP_UPDATE_ELEM, &attr, sizeof(attr));
+		break;
+	case OP_LOOKUP:
+		attr.value = ptr_to_u64(&val);
+		ret = bpf(BPF_MAP_LOOKUP_ELEM, &attr, sizeof(attr));
+		break;
+	default:
+		ret = bpf(BPF_MAP_DELETE_ELEM, &attr, sizeof(attr));
+		break;
+	}
+
+	if (ret == -1 && !(op == OP_LOOKUP && errno == ENOENT) &&
+	    !(op == OP_DELETE && errno == ENOENT))
+		tst_brk(TBROK | TERRNO, "bpf(%s)", op_names[op]);
+}
+
+static void *worker(void *arg)
+{
+	long tid = (long)(uintptr_t)arg;
+	uint32_t base = tid * (nentries / nthreads);
+	int i;
+
+	pthread_barrier_wait(&barrier);
+
+	for (i = 0; i < iters; i++)
+		map_op(cur_op, base + i % (nentries / nthreads));
+
+	return NULL;
+}
+
+static double bench_threads(enum bench_op op)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	pthread_t *tids;
+	long i;
+
+	cur_op = op;
+	tids = SAFE_MALLOC(nthreads * sizeof(pthread_t));
+
+	if (pthread_barrier_init(&barrier, NULL, nthreads + 1))
+		tst_brk(TBROK, "pthread_barrier_init()");
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_CREATE(&tids[i], NULL, worker,
+				    (void *)(uintptr_t)i);
+
+	pthread_barrier_wait(&barrier);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_JOIN(tids[i], NULL);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	pthread_barrier_destroy(&barrier);
+	free(tids);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+	return 1000.0 * nthreads * iters / elapsed_ms;
+}
+
+/*
+ * One BPF_MAP_*_BATCH pass over the whole map, returning ops/sec or
+ * 0 when the kernel does not know the command.
+ */
+static double bench_batch(int cmd)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	union bpf_attr attr;
+	uint32_t *keys;
+	uint64_t *vals, in_batch = 0, out_batch = 0;
+	uint32_t i, done = 0;
+	int ret, first = 1;
+
+	keys = SAFE_MALLOC(BATCH_SZ * sizeof(*keys));
+	vals = SAFE_MALLOC(BATCH_SZ * sizeof(*vals));
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	while (done < nentries) {
+		uint32_t count = MIN((uint32_t)BATCH_SZ, nentries - done);
+
+		memset(&attr, 0, sizeof(attr));
+		attr.batch.map_fd = map_fd;
+		attr.batch.keys = ptr_to_u64(keys);
+		attr.batch.count = count;
+
+		if (cmd == BPF_MAP_UPDATE_BATCH) {
+			for (i = 0; i < count; i++) {
+				keys[i] = done + i;
+				vals[i] = done + i;
+			}
+			attr.batch.values = ptr_to_u64(vals);
+			attr.batch.elem_flags = BPF_ANY;
+		} else {
+			attr.batch.in_batch = first ? 0 : ptr_to_u64(&in_batch);
+			attr.batch.out_batch = ptr_to_u64(&out_batch);
+			if (cmd == BPF_MAP_LOOKUP_BATCH)
+				attr.batch.values = ptr_to_u64(vals);
+		}
+
+		ret = bpf(cmd, &attr, sizeof(attr));
+		if (ret == -1 && errno == EINVAL && first) {
+			free(keys);
+			free(vals);
+			return 0;
+		}
+		if (ret == -1 && errno != ENOENT)
+			tst_brk(TBROK | TERRNO, "bpf() batch command %i", cmd);
+
+		done += attr.batch.count;
+		in_batch = out_batch;
+		first = 0;
+
+		/* ENOENT means the iteration reached the last batch */
+		if (ret == -1)
+			break;
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	free(keys);
+	free(vals);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+	return 1000.0 * done / elapsed_ms;
+}
+
+static void run(unsigned int n)
+{
+	const struct map_type *mt = &map_types[n];
+	union bpf_attr attr;
+	double upd, lkp, del = 0, bupd, blkp, bdel = 0;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = mt->id;
+	attr.key_size = KEY_SZ;
+	attr.value_size = VAL_SZ;
+	attr.max_entries = nentries;
+
+	map_fd = bpf_map_create(&attr);
+
+	upd = bench_threads(OP_UPDATE);
+	lkp = bench_threads(OP_LOOKUP);
+	if (mt->has_delete)
+		del = bench_threads(OP_DELETE);
+
+	bupd = bench_batch(BPF_MAP_UPDATE_BATCH);
+	blkp = bench_batch(BPF_MAP_LOOKUP_BATCH);
+	if (mt->has_delete)
+		bdel = bench_batch(BPF_MAP_DELETE_BATCH);
+
+	tst_res(TINFO,
+		"%-8s %2i threads: update %9.0f, lookup %9.0f, delete %9.0f ops/s",
+		mt->name, nthreads, upd, lkp, del);
+
+	if (bupd) {
+		tst_res(TINFO,
+			"%-8s   batched: update %9.0f, lookup %9.0f, delete %9.0f ops/s",
+			mt->name, bupd, blkp, bdel);
+	} else {
+		tst_res(TINFO, "%-8s   batched: not supported by this kernel",
+			mt->name);
+	}
+
+	tst_res(TPASS, "%s map rates measured", mt->name);
+
+	SAFE_CLOSE(map_fd);
+}
+
+static void setup(void)
+{
+	rlimit_bump_memlock();
+
+	if (str_entries) {
+		if (tst_parse_int(str_entries, (int *)&nentries, 64, INT_MAX))
+			tst_brk(TBROK, "Invalid entry count '%s'", str_entries);
+	}
+
+	nthreads = tst_ncpus();
+	if (str_threads) {
+		if (tst_parse_int(str_threads, &nthreads, 1, 4096))
+			tst_brk(TBROK, "Invalid thread count '%s'", str_threads);
+	}
+
+	if (str_iters) {
+		if (tst_parse_int(str_iters, &iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid op count '%s'", str_iters);
+	}
+
+	if ((uint32_t)nthreads > nentries)
+		nthreads = nentries;
+}
+
+static struct tst_test test = {
+	.tcnt = ARRAY_SIZE(map_types),
+	.test = run,
+	.setup = setup,
+	.min_kver = "4.10",
+	.options = (struct tst_option[]) {
+		{"e:", &str_entries, "-e N     Map entries (default 8192)"},
+		{"t:", &str_threads, "-t N     Concurrent threads (default: one per CPU)"},
+		{"n:", &str_iters, "-n N     Operations per thread (default 50000)"},
+		{}
+	},
+};
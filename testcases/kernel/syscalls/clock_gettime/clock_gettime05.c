@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * clock_gettime05 - vDSO clock dispatch benchmark
+ *
+ * Measures the per-call cost of every common clock ID through three
+ * dispatch paths: the libc wrapper (which should end up in the vDSO),
+ * the vDSO entry point called directly, and the forced syscall.
+ *
+ * Besides printing ns/call for each combination, the test asserts that
+ * the vDSO path of the always-eligible clocks (CLOCK_REALTIME,
+ * CLOCK_MONOTONIC and their coarse variants) is clearly cheaper than
+ * the syscall path. When the clocksource is flagged unstable the vDSO
+ * code silently falls back to the syscall internally; the calls still
+ * succeed and nothing functional fails, but every clock_gettime() in
+ * the fleet gets an order of magnitude slower. That is exactly the
+ * shape this assertion catches.
+ *
+ * CLOCK_MONOTONIC_RAW and CLOCK_BOOTTIME only became vDSO-eligible
+ * with the unified vDSO (v5.3), so they are reported but not asserted.
+ */
+
+#include "config.h"
+#include "parse_vdso.h"
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_safe_clocks.h"
+#include "lapi/syscalls.h"
+
+static struct tcase {
+	clockid_t clk_id;
+	/* vDSO dispatch is load-bearing for this clock on every arch */
+	int assert_vdso;
+} tcases[] = {
+	{ CLOCK_REALTIME, 1 },
+	{ CLOCK_REALTIME_COARSE, 1 },
+	{ CLOCK_MONOTONIC, 1 },
+	{ CLOCK_MONOTONIC_COARSE, 1 },
+	{ CLOCK_MONOTONIC_RAW, 0 },
+	{ CLOCK_BOOTTIME, 0 },
+};
+
+static int iters = 200000;
+static char *str_iters;
+
+static gettime_t ptr_vdso_gettime, ptr_vdso_gettime64;
+
+static int vdso_gettime(clockid_t clk_id, void *ts)
+{
+	if (ptr_vdso_gettime)
+		return ptr_vdso_gettime(clk_id, ts);
+	if (ptr_vdso_gettime64)
+		return ptr_vdso_gettime64(clk_id, ts);
+
+	errno = ENOSYS;
+	return -1;
+}
+
+static int syscall_gettime(clockid_t clk_id, void *ts)
+{
+	return tst_syscall(__NR_clock_gettime, clk_id, ts);
+}
+
+/*
+ * Returns the average cost of one call in ns, or -1 when the path is
+ * not usable for this clock. The kernel timespec of a time64 vDSO is
+ * no larger than tst_ts, so one buffer serves all paths.
+ */
+static long long bench_path(int (*gettime)(clockid_t clk_id, void *ts),
+			    clockid_t clk_id)
+{
+	struct tst_ts ts = { .type = TST_KERN_TIMESPEC };
+	long long elapsed_ns;
+	int i;
+
+	errno = 0;
+	if (gettime(clk_id, tst_ts_get(&ts)))
+		return -1;
+
+	tst_timer_start(CLOCK_MONOTONIC);
+
+	for (i = 0; i < iters; i++)
+		gettime(clk_id, tst_ts_get(&ts));
+
+	tst_timer_stop();
+
+	elapsed_ns = tst_ts_to_ns(tst_ts_from_timespec(tst_timer_elapsed()));
+	return MAX(elapsed_ns / iters, 1LL);
+}
+
+static void run(unsigned int n)
+{
+	struct tcase *tc = &tcases[n];
+	long long libc_ns, vdso_ns, sys_ns;
+	const char *name = tst_clock_name(tc->clk_id);
+
+	libc_ns = bench_path(libc_clock_gettime, tc->clk_id);
+	vdso_ns = bench_path(vdso_gettime, tc->clk_id);
+	sys_ns = bench_path(syscall_gettime, tc->clk_id);
+
+	if (libc_ns < 0 || sys_ns < 0) {
+		tst_res(TCONF, "%s not supported", name);
+		return;
+	}
+
+	if (vdso_ns < 0) {
+		tst_res(TINFO, "%-22s: libc %4lldns, vdso n/a, syscall %4lldns",
+			name, libc_ns, sys_ns);
+	} else {
+		tst_res(TINFO,
+			"%-22s: libc %4lldns, vdso %4lldns, syscall %4lldns",
+			name, libc_ns, vdso_ns, sys_ns);
+	}
+
+	if (!tc->assert_vdso) {
+		tst_res(TPASS, "%s measured", name);
+		return;
+	}
+
+	if (vdso_ns < 0) {
+		tst_res(TCONF, "%s: no usable vDSO entry point", name);
+		return;
+	}
+
+	/*
+	 * A real vDSO read is a few ns, a syscall two orders of
+	 * magnitude more; half the syscall cost still separates the
+	 * two cleanly even on noisy virtualized hosts.
+	 */
+	if (2 * vdso_ns < sys_ns && 2 * libc_ns < sys_ns) {
+		tst_res(TPASS, "%s stays on the vDSO path", name);
+	} else {
+		tst_res(TFAIL,
+			"%s appears to take the syscall path (unstable clocksource fallback?)",
+			name);
+	}
+}
+
+static void setup(void)
+{
+	if (str_iters && tst_parse_int(str_iters, &iters, 1000, INT_MAX))
+		tst_brk(TBROK, "Invalid iteration count '%s'", str_iters);
+
+	find_clock_gettime_vdso(&ptr_vdso_gettime, &ptr_vdso_gettime64);
+
+	if (!ptr_vdso_gettime && !ptr_vdso_gettime64)
+		tst_res(TINFO, "no clock_gettime in the vDSO");
+}
+
+static struct tst_test test = {
+	.test = run,
+	.tcnt = ARRAY_SIZE(tcases),
+	.setup = setup,
+	.options = (struct tst_option[]) {
+		{"c:", &str_iters, "-c N     Calls per path (default 200000)"},
+		{}
+	},
+};
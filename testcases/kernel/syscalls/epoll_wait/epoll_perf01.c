@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * epoll_perf01 - epoll scalability benchmark
+ *
+ * The epoll_ctl/epoll_wait tests verify semantics with a handful of
+ * fds, so a slowdown that only shows up with very large interest sets
+ * goes unnoticed. This benchmark watches nfds descriptors made from a
+ * few pipes whose read ends are dup()ed many times over - each dup is
+ * a separate epitem to the kernel, but one write makes a whole shard
+ * of the interest set ready - and measures
+ *
+ *  - the epoll_ctl(EPOLL_CTL_ADD) rate while building the interest
+ *    set,
+ *
+ *  - the wakeup latency from a partner process's write() to the
+ *    epoll_wait() return, as percentiles from the histogram framework;
+ *    the sleeping waiter has the full interest set attached, and
+ *
+ *  - the event delivery rate of non-blocking epoll_wait() calls with
+ *    1%, 25% and 100% of the pipes ready, which exercises the ready
+ *    list scan and event copy-out at different ready ratios.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+#define NR_OPEN_PATH "/proc/sys/fs/nr_open"
+#define NPIPES 64
+#define MAX_EVENTS 4096
+
+static const int ratios[] = { 1, 25, 100 };
+
+static struct tst_hist hist;
+static int nfds = 100000;
+static int lat_iters = 2000;
+static int tp_iters = 200;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static int epfd = -1;
+static int pipes[NPIPES][2];
+static int ctl_pipe[2];
+static int *dup_fds;
+static struct epoll_event *events;
+static struct timespec *wakeup_ts;
+
+static char *str_nfds;
+static char *str_lat_iters;
+static char *str_tp_iters;
+static char *str_bits;
+
+static void build_interest_set(void)
+{
+	struct timespec t1, t2;
+	struct epoll_event ev = { .events = EPOLLIN };
+	long long elapsed_ms;
+	int i;
+
+	epfd = epoll_create1(0);
+	if (epfd == -1)
+		tst_brk(TBROK | TERRNO, "epoll_create1()");
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nfds; i++) {
+		dup_fds[i] = SAFE_DUP(pipes[i % NPIPES][0]);
+		ev.data.u32 = i;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, dup_fds[i], &ev))
+			tst_brk(TBROK | TERRNO, "epoll_ctl(ADD, fd %i)", i);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+	tst_res(TINFO, "built %i-fd interest set: %8.0f adds/s",
+		nfds, 1000.0 * nfds / elapsed_ms);
+}
+
+static void waker(void)
+{
+	char c;
+	int i;
+
+	for (i = 0; i < lat_iters; i++) {
+		SAFE_READ(1, ctl_pipe[0], &c, 1);
+		/* give the parent time to block in epoll_wait() */
+		usleep(100);
+		tst_clock_gettime(CLOCK_MONOTONIC, wakeup_ts);
+		SAFE_WRITE(1, pipes[0][1], "w", 1);
+	}
+}
+
+static void bench_latency(void)
+{
+	struct timespec t2;
+	char c;
+	int i, ret;
+
+	if (!SAFE_FORK()) {
+		waker();
+		exit(0);
+	}
+
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < lat_iters; i++) {
+		SAFE_WRITE(1, ctl_pipe[1], "r", 1);
+
+		ret = epoll_wait(epfd, events, MAX_EVENTS, -1);
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+		if (ret == -1)
+			tst_brk(TBROK | TERRNO, "epoll_wait()");
+
+		tst_hist_add(&hist, MAX(tst_timespec_diff_ns(t2, *wakeup_ts),
+					0LL));
+
+		/* all dups share the pipe, one read drains it */
+		SAFE_READ(1, pipes[0][0], &c, 1);
+	}
+
+	tst_reap_children();
+
+	tst_res(TINFO,
+		"%7i fds: wakeup p50 %7lldns, p99 %7lldns, p99.9 %7lldns",
+		nfds,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+}
+
+static void bench_ready_ratio(int ratio)
+{
+	struct timespec t1, t2;
+	long long nevents = 0, elapsed_ms;
+	int i, ret, ready_pipes = MAX(NPIPES * ratio / 100, 1);
+	char c;
+
+	for (i = 0; i < ready_pipes; i++)
+		SAFE_WRITE(1, pipes[i][1], "r", 1);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < tp_iters; i++) {
+		ret = epoll_wait(epfd, events, MAX_EVENTS, 0);
+		if (ret == -1)
+			tst_brk(TBROK | TERRNO, "epoll_wait()");
+		nevents += ret;
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	for (i = 0; i < ready_pipes; i++)
+		SAFE_READ(1, pipes[i][0], &c, 1);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+	tst_res(TINFO, "%7i fds, %3i%% pipes ready: %10.0f events/s",
+		nfds, ratio, 1000.0 * nevents / elapsed_ms);
+}
+
+static void run(void)
+{
+	unsigned int i;
+
+	build_interest_set();
+	bench_latency();
+
+	for (i = 0; i < ARRAY_SIZE(ratios); i++)
+		bench_ready_ratio(ratios[i]);
+
+	for (i = 0; i < (unsigned int)nfds; i++)
+		SAFE_CLOSE(dup_fds[i]);
+	SAFE_CLOSE(epfd);
+
+	tst_res(TPASS, "epoll measured with a %i-fd interest set", nfds);
+}
+
+static void setup(void)
+{
+	struct rlimit limit;
+	long nr_open;
+	int i;
+
+	if (str_nfds) {
+		if (tst_parse_int(str_nfds, &nfds, NPIPES, 1000000))
+			tst_brk(TBROK, "Invalid fd count '%s'", str_nfds);
+	}
+
+	if (str_lat_iters) {
+		if (tst_parse_int(str_lat_iters, &lat_iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid wakeup count '%s'",
+				str_lat_iters);
+	}
+
+	if (str_tp_iters) {
+		if (tst_parse_int(str_tp_iters, &tp_iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid epoll_wait call count '%s'",
+				str_tp_iters);
+	}
+
+	if (str_bits) {
+		if (tst_parse_int(str_bits, &hist_bits, 1, 16))
+			tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+	}
+
+	limit.rlim_cur = limit.rlim_max = nfds + 2 * NPIPES + 64;
+
+	SAFE_FILE_SCANF(NR_OPEN_PATH, "%ld", &nr_open);
+	if (nr_open < (long)limit.rlim_max)
+		SAFE_FILE_PRINTF(NR_OPEN_PATH, "%ld", (long)limit.rlim_max);
+
+	SAFE_SETRLIMIT(RLIMIT_NOFILE, &limit);
+
+	for (i = 0; i < NPIPES; i++)
+		SAFE_PIPE(pipes[i]);
+	SAFE_PIPE(ctl_pipe);
+
+	dup_fds = SAFE_MALLOC(nfds * sizeof(int));
+	events = SAFE_MALLOC(MAX_EVENTS * sizeof(struct epoll_event));
+
+	wakeup_ts = SAFE_MMAP(NULL, sizeof(*wakeup_ts),
+			      PROT_READ | PROT_WRITE,
+			      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	tst_hist_init(&hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	free(dup_fds);
+	free(events);
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.needs_root = 1,
+	.forks_child = 1,
+	.options = (struct tst_option[]) {
+		{"n:", &str_nfds, "-n N     Watched fds in the interest set (default 100000)"},
+		{"r:", &str_lat_iters, "-r N     Measured wakeups (default 2000)"},
+		{"m:", &str_tp_iters, "-m N     Non-blocking epoll_wait calls per ratio (default 200)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+	.save_restore = (const char * const[]) {
+		"?" NR_OPEN_PATH,
+		NULL,
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * execve06 - process spawn-rate benchmark
+ *
+ * The other execve tests check semantics only, so exec-path
+ * regressions (credential locking, mm setup, ELF loading) have no
+ * signal in LTP. This test measures complete spawn round-trips -
+ * fork+execve+exit+wait, and the same via posix_spawn() - against a
+ * minimal dynamically linked binary and its statically linked twin,
+ * at 1..N concurrent spawner threads doubling up to one per CPU.
+ *
+ * Each round-trip is timed into a per-thread histogram; after the
+ * threads join the histograms are merged and latency percentiles are
+ * reported next to the aggregate spawn rate per concurrency level.
+ * The static/dynamic pair splits loader cost from kernel exec cost,
+ * and the thread scaling exposes serialization on exec-path locks.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+enum spawn_mode {
+	MODE_FORK_EXECVE,
+	MODE_POSIX_SPAWN,
+};
+
+static struct tcase {
+	const char *name;
+	enum spawn_mode mode;
+	const char *binary;
+} tcases[] = {
+	{"fork+execve dynamic", MODE_FORK_EXECVE, "execve06_child"},
+	{"fork+execve static", MODE_FORK_EXECVE, "execve06_child_static"},
+	{"posix_spawn dynamic", MODE_POSIX_SPAWN, "execve06_child"},
+	{"posix_spawn static", MODE_POSIX_SPAWN, "execve06_child_static"},
+};
+
+static int iters = 2000;
+static int max_spawners;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static char path[512];
+static enum spawn_mode cur_mode;
+static struct tst_hist *hists;
+static pthread_barrier_t barrier;
+
+static char *str_iters;
+static char *str_spawners;
+static char *str_bits;
+
+static void spawn_round_trip(void)
+{
+	char *const args[] = {path, NULL};
+	char *const envp[] = {NULL};
+	int status;
+	pid_t pid;
+
+	if (cur_mode == MODE_FORK_EXECVE) {
+		pid = fork();
+		if (pid == -1)
+			tst_brk(TBROK | TERRNO, "fork()");
+
+		if (!pid) {
+			execve(path, args, envp);
+			_exit(127);
+		}
+	} else {
+		int ret = posix_spawn(&pid, path, NULL, NULL, args, envp);
+
+		if (ret)
+			tst_brk(TBROK, "posix_spawn(): %s", tst_strerrno(ret));
+	}
+
+	if (waitpid(pid, &status, 0) != pid)
+		tst_brk(TBROK | TERRNO, "waitpid()");
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status))
+		tst_brk(TBROK, "Child %s", tst_strstatus(status));
+}
+
+static void *spawner(void *arg)
+{
+	struct tst_hist *hist = arg;
+	struct timespec t1, t2;
+	int i;
+
+	pthread_barrier_wait(&barrier);
+
+	for (i = 0; i < iters; i++) {
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		spawn_round_trip();
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		tst_hist_add(hist, tst_timespec_diff_us(t2, t1));
+	}
+
+	return NULL;
+}
+
+static void bench_level(struct tcase *tc, int nspawners)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	struct tst_hist total;
+	pthread_t *tids;
+	int i;
+
+	tids = SAFE_MALLOC(nspawners * sizeof(pthread_t));
+	tst_hist_init(&total, hist_bits);
+
+	for (i = 0; i < nspawners; i++)
+		tst_hist_reset(&hists[i]);
+
+	if (pthread_barrier_init(&barrier, NULL, nspawners + 1))
+		tst_brk(TBROK, "pthread_barrier_init()");
+
+	for (i = 0; i < nspawners; i++)
+		SAFE_PTHREAD_CREATE(&tids[i], NULL, spawner, &hists[i]);
+
+	pthread_barrier_wait(&barrier);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nspawners; i++)
+		SAFE_PTHREAD_JOIN(tids[i], NULL);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	pthread_barrier_destroy(&barrier);
+
+	for (i = 0; i < nspawners; i++)
+		tst_hist_merge(&total, &hists[i]);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO,
+		"%-19s x%2i: %7.0f spawns/s, p50 %5lldus, p99 %5lldus, p99.9 %6lldus",
+		tc->name, nspawners,
+		1000.0 * nspawners * iters / elapsed_ms,
+		tst_hist_percentile(&total, 50),
+		tst_hist_percentile(&total, 99),
+		tst_hist_percentile(&total, 99.9));
+
+	tst_hist_free(&total);
+	free(tids);
+}
+
+static void run(unsigned int n)
+{
+	struct tcase *tc = &tcases[n];
+	int nspawners;
+
+	if (tst_get_path(tc->binary, path, sizeof(path)))
+		tst_brk(TCONF, "Couldn't find %s in $PATH", tc->binary);
+
+	cur_mode = tc->mode;
+
+	for (nspawners = 1; nspawners < max_spawners; nspawners *= 2)
+		bench_level(tc, nspawners);
+	bench_level(tc, max_spawners);
+
+	tst_res(TPASS, "%s spawn rates measured", tc->name);
+}
+
+static void setup(void)
+{
+	int i;
+
+	if (str_iters) {
+		if (tst_parse_int(str_iters, &iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid spawn count '%s'", str_iters);
+	}
+
+	max_spawners = tst_ncpus();
+	if (str_spawners) {
+		if (tst_parse_int(str_spawners, &max_spawners, 1, 512))
+			tst_brk(TBROK, "Invalid spawner count '%s'", str_spawners);
+	}
+
+	if (str_bits) {
+		if (tst_parse_int(str_bits, &hist_bits, 1, 16))
+			tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+	}
+
+	hists = SAFE_MALLOC(max_spawners * sizeof(*hists));
+	for (i = 0; i < max_spawners; i++)
+		tst_hist_init(&hists[i], hist_bits);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	for (i = 0; hists && i < max_spawners; i++)
+		tst_hist_free(&hists[i]);
+	free(hists);
+}
+
+static struct tst_test test = {
+	.forks_child = 1,
+	.test = run,
+	.tcnt = ARRAY_SIZE(tcases),
+	.setup = setup,
+	.cleanup = cleanup,
+	.options = (struct tst_option[]) {
+		{"n:", &str_iters, "-n N     Spawns per thread and level (default 2000)"},
+		{"t:", &str_spawners, "-t N     Max concurrent spawners (default: one per CPU)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+};
@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Minimal exec target for the execve06 spawn-rate benchmark; it must
+ * not link against the test library so a round-trip prices only the
+ * exec path and the dynamic loader.
+ */
+
+int main(void)
+{
+	return 0;
+}
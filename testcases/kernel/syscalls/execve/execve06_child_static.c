@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Statically linked exec target for the execve06 spawn-rate
+ * benchmark; comparing against execve06_child isolates the dynamic
+ * loader's share of a spawn round-trip.
+ */
+
+int main(void)
+{
+	return 0;
+}
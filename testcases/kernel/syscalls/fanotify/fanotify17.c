@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * fanotify17 - fanotify event throughput and mark setup benchmark
+ *
+ * The other tests in this directory verify event semantics at trivial
+ * event rates, which leaves fsnotify performance changes invisible to
+ * LTP. This test measures the two costs an AV-style scanner built on
+ * fanotify actually pays:
+ *
+ *  - sustained permission event throughput: generator processes open a
+ *    marked file in a loop while the parent reads the FAN_OPEN_PERM
+ *    events and writes FAN_ALLOW responses, reported as events per
+ *    second for 1, 2, 4, ... generators up to -p
+ *
+ *  - mass marking: FAN_MARK_ADD on -d directories one by one with
+ *    per-mark latency percentiles, then one timed FAN_MARK_FLUSH
+ *
+ * The numbers are reported with tst_res(TINFO), the test only fails
+ * when fanotify itself misbehaves.
+ */
+
+#define _GNU_SOURCE
+#include "config.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/fcntl.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <string.h>
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+#ifdef HAVE_SYS_FANOTIFY_H
+#include "fanotify.h"
+
+#define MARK_DIR "marks"
+#define EVENT_FILE "evfile"
+
+#define EVENT_BUF_LEN (256 * (int)sizeof(struct fanotify_event_metadata))
+
+static int ndirs = 2000;
+static int nevents = 2000;
+static int max_gens = 4;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static char *str_ndirs;
+static char *str_nevents;
+static char *str_max_gens;
+static char *str_hist_bits;
+
+static struct tst_hist hist;
+
+static long long elapsed_us(struct timespec t1, struct timespec t2)
+{
+	return MAX(tst_timespec_diff_us(t2, t1), 1LL);
+}
+
+static void bench_marks(void)
+{
+	struct timespec t1, t2;
+	char path[PATH_MAX];
+	long long us;
+	int fd, i;
+
+	fd = SAFE_FANOTIFY_INIT(FAN_CLASS_NOTIF, O_RDONLY);
+
+	tst_hist_reset(&hist);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < ndirs; i++) {
+		snprintf(path, sizeof(path), MARK_DIR "/d%05i", i);
+		tst_timer_start(CLOCK_MONOTONIC);
+		SAFE_FANOTIFY_MARK(fd, FAN_MARK_ADD, FAN_OPEN, AT_FDCWD, path);
+		tst_timer_stop();
+		tst_hist_add(&hist, tst_timer_elapsed_us());
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	us = elapsed_us(t1, t2);
+
+	tst_res(TINFO,
+		"marked %i dirs in %llius, %.0f marks/s, p50 %llius, p99 %llius, p99.9 %llius",
+		ndirs, us, 1000000.0 * ndirs / us,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	SAFE_FANOTIFY_MARK(fd, FAN_MARK_FLUSH, 0, AT_FDCWD, ".");
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	tst_res(TINFO, "flushed %i marks in %llius",
+		ndirs, elapsed_us(t1, t2));
+
+	SAFE_CLOSE(fd);
+}
+
+static void generate_events(void)
+{
+	int i, fd;
+
+	for (i = 0; i < nevents; i++) {
+		fd = SAFE_OPEN(EVENT_FILE, O_RDONLY);
+		SAFE_CLOSE(fd);
+	}
+}
+
+static long long respond_events(int fd, long long expected)
+{
+	char buf[EVENT_BUF_LEN];
+	struct fanotify_event_metadata *event;
+	struct fanotify_response resp;
+	long long handled = 0;
+	ssize_t len;
+
+	while (handled < expected) {
+		len = SAFE_READ(0, fd, buf, sizeof(buf));
+
+		event = (struct fanotify_event_metadata *)buf;
+
+		while (FAN_EVENT_OK(event, len)) {
+			if (event->mask != FAN_OPEN_PERM) {
+				tst_res(TFAIL,
+					"got event: mask=%llx (expected %llx)",
+					(unsigned long long)event->mask,
+					(unsigned long long)FAN_OPEN_PERM);
+			}
+
+			resp.fd = event->fd;
+			resp.response = FAN_ALLOW;
+			SAFE_WRITE(1, fd, &resp, sizeof(resp));
+
+			SAFE_CLOSE(event->fd);
+			handled++;
+			event = FAN_EVENT_NEXT(event, len);
+		}
+	}
+
+	return handled;
+}
+
+static void bench_events(int ngens)
+{
+	struct timespec t1, t2;
+	long long expected = (long long)ngens * nevents;
+	long long handled, us;
+	pid_t pids[ngens];
+	int fd, i;
+
+	fd = SAFE_FANOTIFY_INIT(FAN_CLASS_CONTENT, O_RDONLY);
+	SAFE_FANOTIFY_MARK(fd, FAN_MARK_ADD, FAN_OPEN_PERM, AT_FDCWD,
+			   EVENT_FILE);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < ngens; i++) {
+		pids[i] = SAFE_FORK();
+		if (!pids[i]) {
+			SAFE_CLOSE(fd);
+			generate_events();
+			exit(0);
+		}
+	}
+
+	handled = respond_events(fd, expected);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	us = elapsed_us(t1, t2);
+
+	for (i = 0; i < ngens; i++)
+		SAFE_WAITPID(pids[i], NULL, 0);
+
+	tst_res(TINFO,
+		"%i generators: %.0f events/s (%lli permission events in %llius)",
+		ngens, 1000000.0 * handled / us, handled, us);
+
+	SAFE_CLOSE(fd);
+}
+
+static void test_fanotify(void)
+{
+	int c;
+
+	bench_marks();
+
+	for (c = 1; c <= max_gens; c *= 2)
+		bench_events(c);
+
+	tst_res(TPASS, "fanotify survived the mark and event load");
+}
+
+static void setup(void)
+{
+	char path[PATH_MAX];
+	int i;
+
+	if (str_ndirs && tst_parse_int(str_ndirs, &ndirs, 1, 100000))
+		tst_brk(TBROK, "Invalid directory count '%s'", str_ndirs);
+
+	if (str_nevents && tst_parse_int(str_nevents, &nevents, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid event count '%s'", str_nevents);
+
+	if (str_max_gens && tst_parse_int(str_max_gens, &max_gens, 1, 64))
+		tst_brk(TBROK, "Invalid generator count '%s'", str_max_gens);
+
+	if (str_hist_bits && tst_parse_int(str_hist_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid histogram bits '%s'", str_hist_bits);
+
+	require_fanotify_access_permissions_supported_by_kernel();
+
+	tst_hist_init(&hist, hist_bits);
+
+	SAFE_MKDIR(MARK_DIR, 0755);
+
+	for (i = 0; i < ndirs; i++) {
+		snprintf(path, sizeof(path), MARK_DIR "/d%05i", i);
+		SAFE_MKDIR(path, 0755);
+	}
+
+	SAFE_FILE_PRINTF(EVENT_FILE, "1");
+}
+
+static void cleanup(void)
+{
+	tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.test_all = test_fanotify,
+	.setup = setup,
+	.cleanup = cleanup,
+	.options = (struct tst_option[]) {
+		{"d:", &str_ndirs, "-d N     Directories to mark (default 2000)"},
+		{"n:", &str_nevents, "-n N     Events per generator (default 2000)"},
+		{"p:", &str_max_gens, "-p N     Max concurrent generators (default 4)"},
+		{"b:", &str_hist_bits, "-b bits  Histogram sub-bucket bits, sets resolution to 2^-bits (default 7)"},
+		{}
+	},
+	.needs_tmpdir = 1,
+	.forks_child = 1,
+	.needs_root = 1,
+};
+
+#else
+	TST_TEST_TCONF("system doesn't have required fanotify support");
+#endif
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * fsync05 - fsync/fdatasync latency percentile benchmark
+ *
+ * The other fsync tests verify durability semantics; this one measures
+ * what a commit costs while the filesystem is busy, which is the
+ * number write-ahead-logging workloads care about. A few dirtier
+ * processes keep rewriting their own files on the same filesystem
+ * while the parent appends small records to a log file and fsyncs (or
+ * fdatasyncs) after each one, collecting the per-call latency in a
+ * histogram.
+ *
+ * The p50/p99/p99.9/max percentiles are reported for both calls; with
+ * .all_filesystems the numbers come out once per supported filesystem,
+ * so a commit-latency regression is visible per filesystem per kernel.
+ * The test only fails when a sync call fails.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "tst_test.h"
+#include "tst_safe_prw.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+
+#define MNTPOINT "mnt_point"
+#define DIRTY_FILE_SZ (32 * TST_MB)
+#define DIRTY_CHUNK_SZ (64 * 1024)
+#define LOG_FILE_SZ (32 * TST_MB)
+
+static int ndirtiers = 2;
+static int nsyncs = 500;
+static int record_size = 4096;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static char *str_ndirtiers;
+static char *str_nsyncs;
+static char *str_record_size;
+static char *str_bits;
+
+static struct tst_hist hist;
+static char *record;
+static volatile int *stop;
+
+static void dirtier(int id)
+{
+	char fname[64];
+	char *buf;
+	off_t off;
+	int fd;
+
+	snprintf(fname, sizeof(fname), MNTPOINT "/dirty_%i", id);
+	fd = SAFE_OPEN(fname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	buf = SAFE_MALLOC(DIRTY_CHUNK_SZ);
+	memset(buf, 'd', DIRTY_CHUNK_SZ);
+
+	while (!*stop) {
+		off = (random() % (DIRTY_FILE_SZ / DIRTY_CHUNK_SZ))
+			* DIRTY_CHUNK_SZ;
+		SAFE_PWRITE(1, fd, buf, DIRTY_CHUNK_SZ, off);
+	}
+
+	SAFE_CLOSE(fd);
+	free(buf);
+	exit(0);
+}
+
+static void bench_sync(const char *name, int (*sync_fn)(int fd))
+{
+	struct timespec t1, t2;
+	off_t off = 0;
+	int fd, i;
+
+	fd = SAFE_OPEN(MNTPOINT "/logfile", O_WRONLY | O_CREAT | O_TRUNC,
+		       0644);
+
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < nsyncs; i++) {
+		SAFE_PWRITE(1, fd, record, record_size, off);
+		off = (off + record_size) % LOG_FILE_SZ;
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		TEST(sync_fn(fd));
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		if (TST_RET) {
+			tst_res(TFAIL | TTERRNO, "%s() failed on %s",
+				name, tst_device->fs_type);
+			SAFE_CLOSE(fd);
+			return;
+		}
+
+		tst_hist_add(&hist, tst_timespec_diff_us(t2, t1));
+	}
+
+	SAFE_CLOSE(fd);
+
+	tst_res(TINFO,
+		"%-9s on %-8s: p50 %6lldus, p99 %6lldus, p99.9 %6lldus, max %6lldus",
+		name, tst_device->fs_type,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9),
+		tst_hist_percentile(&hist, 100));
+}
+
+static void run(void)
+{
+	int i;
+
+	*stop = 0;
+
+	for (i = 0; i < ndirtiers; i++) {
+		if (!SAFE_FORK())
+			dirtier(i);
+	}
+
+	bench_sync("fsync", fsync);
+	bench_sync("fdatasync", fdatasync);
+
+	*stop = 1;
+	tst_reap_children();
+
+	for (i = 0; i < ndirtiers; i++) {
+		char fname[64];
+
+		snprintf(fname, sizeof(fname), MNTPOINT "/dirty_%i", i);
+		SAFE_UNLINK(fname);
+	}
+	SAFE_UNLINK(MNTPOINT "/logfile");
+
+	tst_res(TPASS, "%i syncs measured on %s with %i dirtiers",
+		nsyncs, tst_device->fs_type, ndirtiers);
+}
+
+static void setup(void)
+{
+	if (str_ndirtiers && tst_parse_int(str_ndirtiers, &ndirtiers, 0, 64))
+		tst_brk(TBROK, "Invalid dirtier count '%s'", str_ndirtiers);
+
+	if (str_nsyncs && tst_parse_int(str_nsyncs, &nsyncs, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid sync count '%s'", str_nsyncs);
+
+	if (str_record_size && tst_parse_int(str_record_size, &record_size,
+					     1, TST_MB))
+		tst_brk(TBROK, "Invalid record size '%s'", str_record_size);
+
+	if (str_bits && tst_parse_int(str_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+
+	record = SAFE_MALLOC(record_size);
+	memset(record, 'r', record_size);
+
+	stop = SAFE_MMAP(NULL, sizeof(*stop), PROT_READ | PROT_WRITE,
+			 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	tst_hist_init(&hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	if (stop) {
+		*stop = 1;
+		SAFE_MUNMAP((void *)stop, sizeof(*stop));
+	}
+
+	free(record);
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.needs_root = 1,
+	.mount_device = 1,
+	.all_filesystems = 1,
+	.mntpoint = MNTPOINT,
+	.forks_child = 1,
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+	.options = (struct tst_option[]) {
+		{"d:", &str_ndirtiers, "-d N     Concurrent dirtier processes (default 2)"},
+		{"n:", &str_nsyncs, "-n N     Measured sync calls per variant (default 500)"},
+		{"s:", &str_record_size, "-s N     Bytes written before each sync (default 4096)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+};
@@ -0,0 +1,337 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * futex_perf01 - futex wake and requeue throughput benchmark
+ *
+ * The futex tests in this directory are pass/fail only, so wake and
+ * requeue slowdowns under contention - where glibc condvar performance
+ * lives - go unnoticed. This benchmark parks waiter threads on a set
+ * of private futexes, pinned round-robin over the CPUs reported by the
+ * topology helpers, and drives three patterns from the main thread:
+ *
+ *  - wake-one: FUTEX_WAKE of a single waiter, round-trip paced by an
+ *    ack futex, like a condvar signal,
+ *
+ *  - wake-all: FUTEX_WAKE of every waiter of a futex, waiting for all
+ *    of them to ack, like a condvar broadcast,
+ *
+ *  - requeue: FUTEX_CMP_REQUEUE waking one waiter and moving the rest
+ *    to a second futex and back, which exercises the hash-bucket lock
+ *    work without waking anyone.
+ *
+ * Each pattern reports ops/sec and the wake-to-return latency
+ * percentiles from the histogram framework; the waiters fill private
+ * histograms that are merged after the run. A waker retry with a
+ * short timeout keeps the benchmark live when a wake races with a
+ * waiter that has not parked yet.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_cpu.h"
+#include "tst_hist.h"
+#include "futextest.h"
+
+enum pattern {
+	WAKE_ONE,
+	WAKE_ALL,
+	REQUEUE,
+};
+
+static const char *const pattern_names[] = { "wake-one", "wake-all", "requeue" };
+
+struct shard {
+	futex_t word;
+	futex_t word2;
+	futex_t acks;
+	int nwaiters;
+	struct timespec wake_ts;
+} __attribute__((aligned(64)));
+
+struct waiter {
+	pthread_t tid;
+	struct shard *shard;
+	struct tst_hist hist;
+	int cpu;
+};
+
+static struct tst_hist hist;
+static struct shard *shards;
+static struct waiter *waiters;
+static int nwaiters = 64;
+static int nfutexes = 4;
+static int iters = 20000;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+static volatile int stop_flag;
+static enum pattern cur_pattern;
+
+static char *str_nwaiters;
+static char *str_nfutexes;
+static char *str_iters;
+static char *str_bits;
+
+static void *waiter_fn(void *arg)
+{
+	struct waiter *w = arg;
+	struct shard *s = w->shard;
+	struct timespec now;
+	futex_t v;
+	int acks;
+
+	if (w->cpu != -1) {
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+		CPU_SET(w->cpu, &set);
+		if (sched_setaffinity(0, sizeof(set), &set))
+			tst_brk(TBROK | TERRNO, "sched_setaffinity(%i)",
+				w->cpu);
+	}
+
+	while (!stop_flag) {
+		v = s->word;
+		if (stop_flag)
+			break;
+
+		futex_wait(FUTEX_FN_FUTEX, &s->word, v, NULL,
+			   FUTEX_PRIVATE_FLAG);
+		if (stop_flag)
+			break;
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &now);
+		tst_hist_add(&w->hist,
+			     MAX(tst_timespec_diff_ns(now, s->wake_ts), 0LL));
+
+		acks = tst_atomic_inc((int *)&s->acks);
+		if (cur_pattern != WAKE_ALL || acks >= s->nwaiters) {
+			futex_wake(FUTEX_FN_FUTEX, &s->acks, 1,
+				   FUTEX_PRIVATE_FLAG);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Waits until need waiters acked the current round. On timeout the
+ * wake is repeated, which unsticks waiters that were caught between
+ * reading the futex word and parking on it.
+ */
+static void wait_acks(struct shard *s, int need, int nr_wake)
+{
+	struct timespec to = { .tv_nsec = 10000000 };
+	int a;
+
+	while ((a = tst_atomic_load((int *)&s->acks)) < need) {
+		if (futex_syscall(FUTEX_FN_FUTEX, &s->acks, FUTEX_WAIT, a,
+				  &to, NULL, 0, FUTEX_PRIVATE_FLAG) == -1 &&
+		    errno == ETIMEDOUT) {
+			futex_wake(FUTEX_FN_FUTEX, &s->word, nr_wake,
+				   FUTEX_PRIVATE_FLAG);
+		}
+	}
+}
+
+static void bench_pattern(enum pattern pat)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms, moved = 0;
+	struct shard *s;
+	int i, ret;
+
+	cur_pattern = pat;
+	stop_flag = 0;
+
+	for (i = 0; i < nfutexes; i++) {
+		shards[i].word = 0;
+		shards[i].word2 = 0;
+		shards[i].acks = 0;
+		shards[i].nwaiters = 0;
+	}
+
+	for (i = 0; i < nwaiters; i++) {
+		waiters[i].shard = &shards[i % nfutexes];
+		waiters[i].shard->nwaiters++;
+		tst_hist_reset(&waiters[i].hist);
+		SAFE_PTHREAD_CREATE(&waiters[i].tid, NULL, waiter_fn,
+				    &waiters[i]);
+	}
+
+	/* let the waiters park before the clock starts */
+	usleep(10000);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < iters; i++) {
+		s = &shards[i % nfutexes];
+		s->acks = 0;
+		tst_clock_gettime(CLOCK_MONOTONIC, &s->wake_ts);
+
+		switch (pat) {
+		case WAKE_ONE:
+			tst_atomic_inc((int *)&s->word);
+			futex_wake(FUTEX_FN_FUTEX, &s->word, 1,
+				   FUTEX_PRIVATE_FLAG);
+			wait_acks(s, 1, 1);
+			break;
+		case WAKE_ALL:
+			tst_atomic_inc((int *)&s->word);
+			futex_wake(FUTEX_FN_FUTEX, &s->word, INT_MAX,
+				   FUTEX_PRIVATE_FLAG);
+			wait_acks(s, s->nwaiters, INT_MAX);
+			break;
+		case REQUEUE:
+			ret = futex_cmp_requeue(FUTEX_FN_FUTEX, &s->word,
+						s->word, &s->word2, 1,
+						INT_MAX, FUTEX_PRIVATE_FLAG);
+			if (ret == -1)
+				tst_brk(TBROK | TERRNO, "futex_cmp_requeue()");
+			moved += ret;
+			wait_acks(s, 1, 1);
+
+			ret = futex_cmp_requeue(FUTEX_FN_FUTEX, &s->word2,
+						s->word2, &s->word, 0,
+						INT_MAX, FUTEX_PRIVATE_FLAG);
+			if (ret == -1)
+				tst_brk(TBROK | TERRNO, "futex_cmp_requeue()");
+			moved += ret;
+			break;
+		}
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	stop_flag = 1;
+	for (i = 0; i < nfutexes; i++) {
+		tst_atomic_inc((int *)&shards[i].word);
+		futex_wake(FUTEX_FN_FUTEX, &shards[i].word, INT_MAX,
+			   FUTEX_PRIVATE_FLAG);
+		futex_wake(FUTEX_FN_FUTEX, &shards[i].word2, INT_MAX,
+			   FUTEX_PRIVATE_FLAG);
+	}
+
+	tst_hist_reset(&hist);
+	for (i = 0; i < nwaiters; i++) {
+		SAFE_PTHREAD_JOIN(waiters[i].tid, NULL);
+		tst_hist_merge(&hist, &waiters[i].hist);
+	}
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	if (pat == REQUEUE) {
+		tst_res(TINFO,
+			"%-8s: %8.0f ops/s, %9.0f waiters moved/s, wakeup p50 %7lldns, p99 %7lldns",
+			pattern_names[pat],
+			1000.0 * iters / elapsed_ms,
+			1000.0 * moved / elapsed_ms,
+			tst_hist_percentile(&hist, 50),
+			tst_hist_percentile(&hist, 99));
+	} else {
+		tst_res(TINFO,
+			"%-8s: %8.0f ops/s, wakeup p50 %7lldns, p99 %7lldns, p99.9 %7lldns",
+			pattern_names[pat],
+			1000.0 * iters / elapsed_ms,
+			tst_hist_percentile(&hist, 50),
+			tst_hist_percentile(&hist, 99),
+			tst_hist_percentile(&hist, 99.9));
+	}
+}
+
+static void run(void)
+{
+	bench_pattern(WAKE_ONE);
+	bench_pattern(WAKE_ALL);
+	bench_pattern(REQUEUE);
+
+	tst_res(TPASS, "futex patterns measured with %i waiters on %i futexes",
+		nwaiters, nfutexes);
+}
+
+static void setup(void)
+{
+	const struct tst_cpu_info *cpus;
+	int i, ncpus;
+
+	if (str_nwaiters) {
+		if (tst_parse_int(str_nwaiters, &nwaiters, 1, 65536))
+			tst_brk(TBROK, "Invalid waiter count '%s'",
+				str_nwaiters);
+	}
+
+	if (str_nfutexes) {
+		if (tst_parse_int(str_nfutexes, &nfutexes, 1, 65536))
+			tst_brk(TBROK, "Invalid futex count '%s'",
+				str_nfutexes);
+	}
+
+	if (str_iters) {
+		if (tst_parse_int(str_iters, &iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid iteration count '%s'",
+				str_iters);
+	}
+
+	if (str_bits) {
+		if (tst_parse_int(str_bits, &hist_bits, 1, 16))
+			tst_brk(TBROK, "Invalid bucket bits '%s'", str_bits);
+	}
+
+	if (nfutexes > nwaiters)
+		nfutexes = nwaiters;
+
+	shards = SAFE_MALLOC(nfutexes * sizeof(struct shard));
+	waiters = SAFE_MALLOC(nwaiters * sizeof(struct waiter));
+
+	ncpus = tst_cpu_topology(&cpus);
+	if (ncpus < 1)
+		tst_res(TINFO, "No CPU topology, running unpinned");
+
+	for (i = 0; i < nwaiters; i++) {
+		waiters[i].cpu = ncpus < 1 ? -1 : cpus[i % ncpus].id;
+		tst_hist_init(&waiters[i].hist, hist_bits);
+	}
+
+	tst_hist_init(&hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	if (waiters) {
+		for (i = 0; i < nwaiters; i++) {
+			if (waiters[i].hist.buckets)
+				tst_hist_free(&waiters[i].hist);
+		}
+	}
+
+	free(shards);
+	free(waiters);
+
+	if (hist.buckets)
+		tst_hist_free(&hist);
+}
+
+static struct tst_test test = {
+	.options = (struct tst_option[]) {
+		{"t:", &str_nwaiters, "-t N     Waiter threads (default 64)"},
+		{"f:", &str_nfutexes, "-f N     Futexes the waiters shard over (default 4)"},
+		{"r:", &str_iters, "-r N     Iterations per pattern (default 20000)"},
+		{"b:", &str_bits, "-b bits  Histogram bucket bits (default 7)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * getdents03 - getdents64 bulk-iteration benchmark
+ *
+ * getdents01/02 validate record contents on a handful of entries, so
+ * directory-listing throughput on huge (maildir-style) directories
+ * has no coverage. This test populates a directory with a
+ * parameterized number of entries and measures how fast getdents64
+ * iterates it across a range of user buffer sizes, reporting
+ * entries/sec for a cold pass (dentries and inodes dropped via
+ * /proc/sys/vm/drop_caches first, so the filesystem is walked) and a
+ * warm pass (everything served from the dcache).
+ *
+ * The buffer-size sweep shows the per-syscall overhead amortizing;
+ * the cold/warm split separates filldir cost from lookup cost. When
+ * drop_caches is not available only warm numbers are reported.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tst_test.h"
+#include "getdents.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+
+#define DIR_NAME "bigdir"
+#define DROP_CACHES "/proc/sys/vm/drop_caches"
+
+static const unsigned int buf_sizes[] = {
+	4096, 32768, 262144, 1048576
+};
+
+static int nfiles = 100000;
+static int can_drop_caches;
+
+static char *str_files;
+
+static long scan_dir(unsigned int buf_size, long long *elapsed_ms)
+{
+	struct timespec t1, t2;
+	char *buf = SAFE_MALLOC(buf_size);
+	long entries = 0;
+	int fd, nread;
+
+	fd = SAFE_OPEN(DIR_NAME, O_RDONLY | O_DIRECTORY);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (;;) {
+		long off = 0;
+
+		nread = linux_getdents64(fd, (struct linux_dirent64 *)buf,
+					 buf_size);
+		if (nread == -1)
+			tst_brk(TBROK | TERRNO, "getdents64()");
+		if (!nread)
+			break;
+
+		while (off < nread) {
+			struct linux_dirent64 *d =
+				(struct linux_dirent64 *)(buf + off);
+
+			entries++;
+			off += d->d_reclen;
+		}
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	SAFE_CLOSE(fd);
+	free(buf);
+
+	*elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+	return entries;
+}
+
+static void drop_caches(void)
+{
+	SAFE_FILE_PRINTF(DROP_CACHES, "2");
+}
+
+static void run(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(buf_sizes); i++) {
+		long long cold_ms = 0, warm_ms;
+		long entries;
+
+		if (can_drop_caches) {
+			drop_caches();
+			entries = scan_dir(buf_sizes[i], &cold_ms);
+			if (entries != nfiles + 2)
+				tst_brk(TFAIL, "Cold pass saw %ld entries, expected %i",
+					entries, nfiles + 2);
+		}
+
+		entries = scan_dir(buf_sizes[i], &warm_ms);
+		if (entries != nfiles + 2)
+			tst_brk(TFAIL, "Warm pass saw %ld entries, expected %i",
+				entries, nfiles + 2);
+
+		if (can_drop_caches) {
+			tst_res(TINFO,
+				"bufsize %7u: cold %8.0f entries/s, warm %8.0f entries/s",
+				buf_sizes[i], 1000.0 * entries / cold_ms,
+				1000.0 * entries / warm_ms);
+		} else {
+			tst_res(TINFO, "bufsize %7u: warm %8.0f entries/s",
+				buf_sizes[i], 1000.0 * entries / warm_ms);
+		}
+	}
+
+	tst_res(TPASS, "%i entries iterated at %zu buffer sizes",
+		nfiles, ARRAY_SIZE(buf_sizes));
+}
+
+static void setup(void)
+{
+	char name[64];
+	int i, fd;
+
+	if (str_files) {
+		if (tst_parse_int(str_files, &nfiles, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid file count '%s'", str_files);
+	}
+
+	can_drop_caches = !access(DROP_CACHES, W_OK);
+	if (!can_drop_caches)
+		tst_res(TINFO, "Cannot drop caches, cold-pass numbers skipped");
+
+	SAFE_MKDIR(DIR_NAME, 0755);
+
+	tst_res(TINFO, "Creating %i directory entries", nfiles);
+
+	for (i = 0; i < nfiles; i++) {
+		snprintf(name, sizeof(name), DIR_NAME "/f%07i", i);
+		fd = SAFE_CREAT(name, 0644);
+		SAFE_CLOSE(fd);
+	}
+}
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.setup = setup,
+	.test_all = run,
+	.options = (struct tst_option[]) {
+		{"f:", &str_files, "-f N     Directory entries to create (default 100000)"},
+		{}
+	},
+};
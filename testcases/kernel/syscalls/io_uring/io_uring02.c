@@ -0,0 +1,325 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * io_uring02 - io_uring feature-combination throughput test
+ *
+ * io_uring01 validates each raw API in isolation, but io_uring
+ * regressions tend to appear where features intersect: SQPOLL with a
+ * fixed fileset, registered buffers combined with linked SQEs, and so
+ * on. This test drives the same file-backed read/write workload
+ * through a matrix of feature combinations - plain vectored I/O,
+ * registered buffers, a registered fileset, linked write+read pairs,
+ * forced-async execution and an SQPOLL kernel thread - keeping a full
+ * submission queue throughout, and reports per-combination throughput
+ * so the intersections are trended individually.
+ *
+ * Every completion is checked for the expected transfer size, so a
+ * combination that silently corrupts results fails rather than just
+ * running slow. Combinations the running kernel refuses to set up
+ * (e.g. unprivileged SQPOLL before v5.11) are reported and skipped.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/io_uring.h"
+
+#define TEST_FILE "test_file"
+#define QUEUE_DEPTH 32
+#define BLOCK_SZ 4096
+
+struct io_sq_ring {
+	unsigned int *head;
+	unsigned int *tail;
+	unsigned int *ring_mask;
+	unsigned int *ring_entries;
+	unsigned int *flags;
+	unsigned int *array;
+};
+
+struct io_cq_ring {
+	unsigned int *head;
+	unsigned int *tail;
+	unsigned int *ring_mask;
+	unsigned int *ring_entries;
+	struct io_uring_cqe *cqes;
+};
+
+struct ring {
+	int fd;
+	struct io_sq_ring sq;
+	struct io_uring_sqe *sqes;
+	struct io_cq_ring cq;
+	void *sptr;
+	size_t sptr_size;
+	void *cptr;
+	size_t cptr_size;
+};
+
+static struct tcase {
+	const char *name;
+	unsigned int setup_flags;
+	int fixed_bufs;
+	int fixed_files;
+	int linked;
+	unsigned int sqe_flags;
+} tcases[] = {
+	{"readv", 0, 0, 0, 0, 0},
+	{"fixed buffers", 0, 1, 0, 0, 0},
+	{"fixed files", 0, 0, 1, 0, IOSQE_FIXED_FILE},
+	{"fixed buffers+files", 0, 1, 1, 0, IOSQE_FIXED_FILE},
+	{"linked write+read", 0, 0, 0, 1, 0},
+	{"forced async", 0, 0, 0, 0, IOSQE_ASYNC},
+	{"sqpoll, fixed files", IORING_SETUP_SQPOLL, 0, 1, 0, IOSQE_FIXED_FILE},
+	{"sqpoll, fixed buffers+files", IORING_SETUP_SQPOLL, 1, 1, 0,
+	 IOSQE_FIXED_FILE},
+};
+
+static long total_ops = 20000;
+static int file_fd = -1;
+static struct iovec iov[QUEUE_DEPTH];
+static sigset_t sig;
+
+static char *str_ops;
+
+static int ring_init(struct ring *r, unsigned int flags)
+{
+	struct io_uring_params p;
+
+	memset(r, 0, sizeof(*r));
+	memset(&p, 0, sizeof(p));
+	p.flags = flags;
+	if (flags & IORING_SETUP_SQPOLL)
+		p.sq_thread_idle = 2000;
+
+	r->fd = io_uring_setup(QUEUE_DEPTH, &p);
+	if (r->fd == -1)
+		return -1;
+
+	r->sptr_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	r->sptr = SAFE_MMAP(0, r->sptr_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, r->fd,
+			    IORING_OFF_SQ_RING);
+
+	r->sq.head = r->sptr + p.sq_off.head;
+	r->sq.tail = r->sptr + p.sq_off.tail;
+	r->sq.ring_mask = r->sptr + p.sq_off.ring_mask;
+	r->sq.ring_entries = r->sptr + p.sq_off.ring_entries;
+	r->sq.flags = r->sptr + p.sq_off.flags;
+	r->sq.array = r->sptr + p.sq_off.array;
+
+	r->sqes = SAFE_MMAP(0, p.sq_entries * sizeof(struct io_uring_sqe),
+			    PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+
+	r->cptr_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	r->cptr = SAFE_MMAP(0, r->cptr_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, r->fd,
+			    IORING_OFF_CQ_RING);
+
+	r->cq.head = r->cptr + p.cq_off.head;
+	r->cq.tail = r->cptr + p.cq_off.tail;
+	r->cq.ring_mask = r->cptr + p.cq_off.ring_mask;
+	r->cq.ring_entries = r->cptr + p.cq_off.ring_entries;
+	r->cq.cqes = r->cptr + p.cq_off.cqes;
+
+	return 0;
+}
+
+static void ring_exit(struct ring *r)
+{
+	SAFE_MUNMAP(r->sqes, *r->sq.ring_entries * sizeof(struct io_uring_sqe));
+	SAFE_MUNMAP(r->cptr, r->cptr_size);
+	SAFE_MUNMAP(r->sptr, r->sptr_size);
+	SAFE_CLOSE(r->fd);
+}
+
+/*
+ * Queues one SQE; the caller has made sure a slot is free. Slots and
+ * buffers are tied together: SQE at ring index i always uses iov[i],
+ * which is also registered buffer i.
+ */
+static void prep_sqe(struct ring *r, struct tcase *tc, int write, long opno,
+		     unsigned int sqe_flags)
+{
+	unsigned int tail = *r->sq.tail;
+	unsigned int index = tail & *r->sq.ring_mask;
+	struct io_uring_sqe *sqe = &r->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->fd = tc->fixed_files ? 0 : file_fd;
+	sqe->flags = tc->sqe_flags | sqe_flags;
+	sqe->off = (opno % QUEUE_DEPTH) * BLOCK_SZ;
+	sqe->len = tc->fixed_bufs ? BLOCK_SZ : 1;
+	sqe->user_data = index;
+
+	if (tc->fixed_bufs) {
+		sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+		sqe->addr = (unsigned long)iov[index].iov_base;
+		sqe->buf_index = index;
+	} else {
+		sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+		sqe->addr = (unsigned long)&iov[index];
+	}
+
+	r->sq.array[index] = index;
+	*r->sq.tail = tail + 1;
+}
+
+static unsigned int reap_cq(struct ring *r)
+{
+	unsigned int head = *r->cq.head;
+	unsigned int events = 0;
+
+	for (; head != *r->cq.tail; head++) {
+		struct io_uring_cqe *cqe = &r->cq.cqes[head & *r->cq.ring_mask];
+
+		if (cqe->res != BLOCK_SZ) {
+			tst_brk(TFAIL, "CQE %llu result %i expected %i",
+				(unsigned long long)cqe->user_data,
+				cqe->res, BLOCK_SZ);
+		}
+		events++;
+	}
+
+	*r->cq.head = head;
+	return events;
+}
+
+static void enter_ring(struct ring *r, struct tcase *tc, unsigned int to_submit,
+		       unsigned int min_complete)
+{
+	unsigned int flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+	int ret;
+
+	if (tc->setup_flags & IORING_SETUP_SQPOLL) {
+		/* the poll thread picks the tail up itself */
+		to_submit = 0;
+		if (*r->sq.flags & IORING_SQ_NEED_WAKEUP)
+			flags |= IORING_ENTER_SQ_WAKEUP;
+		if (!flags)
+			return;
+	}
+
+	ret = io_uring_enter(r->fd, to_submit, min_complete, flags, &sig);
+	if (ret == -1)
+		tst_brk(TBROK | TERRNO, "io_uring_enter()");
+}
+
+static void run(unsigned int n)
+{
+	struct tcase *tc = &tcases[n];
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	struct ring ring;
+	long submitted = 0, completed = 0;
+	int ret;
+
+	if (ring_init(&ring, tc->setup_flags)) {
+		if (errno == EPERM || errno == EINVAL) {
+			tst_res(TCONF, "%-27s: not supported by this kernel",
+				tc->name);
+			return;
+		}
+		tst_brk(TBROK | TERRNO, "io_uring_setup()");
+	}
+
+	if (tc->fixed_bufs) {
+		ret = io_uring_register(ring.fd, IORING_REGISTER_BUFFERS,
+					iov, QUEUE_DEPTH);
+		if (ret == -1)
+			tst_brk(TBROK | TERRNO, "IORING_REGISTER_BUFFERS");
+	}
+
+	if (tc->fixed_files) {
+		ret = io_uring_register(ring.fd, IORING_REGISTER_FILES,
+					&file_fd, 1);
+		if (ret == -1)
+			tst_brk(TBROK | TERRNO, "IORING_REGISTER_FILES");
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	while (completed < total_ops) {
+		unsigned int batch = 0;
+
+		while (submitted < total_ops &&
+		       submitted - completed + batch + tc->linked < QUEUE_DEPTH) {
+			if (tc->linked) {
+				prep_sqe(&ring, tc, 1, submitted, IOSQE_IO_LINK);
+				prep_sqe(&ring, tc, 0, submitted + 1, 0);
+				submitted += 2;
+				batch += 2;
+			} else {
+				prep_sqe(&ring, tc, 0, submitted, 0);
+				submitted++;
+				batch++;
+			}
+		}
+
+		enter_ring(&ring, tc, batch, 1);
+		completed += reap_cq(&ring);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+
+	tst_res(TINFO, "%-27s: %8.0f ops/s, %6.0f MB/s",
+		tc->name, 1000.0 * completed / elapsed_ms,
+		1000.0 * completed * BLOCK_SZ / elapsed_ms / (1024 * 1024));
+
+	tst_res(TPASS, "%ld ops completed with %s", completed, tc->name);
+
+	ring_exit(&ring);
+}
+
+static void setup(void)
+{
+	int i;
+
+	io_uring_setup_supported_by_kernel();
+
+	if (str_ops) {
+		if (tst_parse_long(str_ops, &total_ops, QUEUE_DEPTH, LONG_MAX))
+			tst_brk(TBROK, "Invalid op count '%s'", str_ops);
+	}
+
+	tst_fill_file(TEST_FILE, 'a', BLOCK_SZ, QUEUE_DEPTH);
+	file_fd = SAFE_OPEN(TEST_FILE, O_RDWR);
+
+	for (i = 0; i < QUEUE_DEPTH; i++) {
+		iov[i].iov_base = SAFE_MEMALIGN(getpagesize(), BLOCK_SZ);
+		iov[i].iov_len = BLOCK_SZ;
+		memset(iov[i].iov_base, 'a', BLOCK_SZ);
+	}
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	if (file_fd != -1)
+		SAFE_CLOSE(file_fd);
+
+	for (i = 0; i < QUEUE_DEPTH; i++)
+		free(iov[i].iov_base);
+}
+
+static struct tst_test test = {
+	.setup = setup,
+	.cleanup = cleanup,
+	.test = run,
+	.tcnt = ARRAY_SIZE(tcases),
+	.needs_tmpdir = 1,
+	.options = (struct tst_option[]) {
+		{"n:", &str_ops, "-n N     Operations per combination (default 20000)"},
+		{}
+	},
+};
@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * msgstress05 - thread-based high-rate message queue stress
+ *
+ * msgstress01-04 fork hundreds of sender/receiver process pairs, so at
+ * high concurrency most of the CPU time goes to fork() and scheduling
+ * rather than msgsnd()/msgrcv(). This variant runs pthread sender and
+ * receiver pools that share the queue ids directly, keeps per-thread
+ * message counters, and reports the measured rate in msgs/s, so queue
+ * scaling regressions show up as numbers instead of timeouts.
+ *
+ * Every message on a queue is filled with the same byte value, which
+ * lets the receivers verify the payload even though the senders on a
+ * shared queue interleave.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_safe_sysv_ipc.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "libmsgctl.h"
+
+#define MAX_QUEUES 64
+
+struct stress_worker {
+	pthread_t tid;
+	int qidx;
+	int nreps;
+	unsigned long msgs;
+};
+
+static struct stress_worker *writers;
+static struct stress_worker *readers;
+static pthread_barrier_t barrier;
+static int *queues;
+static int nqueues = 4;
+static int npairs;
+static int nreps = 10000;
+static volatile int test_failed;
+
+static char *str_nqueues;
+static char *str_npairs;
+static char *str_nreps;
+
+static void *writer_fn(void *arg)
+{
+	struct stress_worker *w = arg;
+	struct mbuffer buffer;
+	unsigned int seed = w->qidx + 1;
+	int id = queues[w->qidx];
+	char val = (w->qidx + 1) % 255;
+	int i, size;
+
+	pthread_barrier_wait(&barrier);
+
+	for (i = 0; i < w->nreps; i++) {
+		memset(&buffer, 0, sizeof(buffer));
+
+		do {
+			size = rand_r(&seed) % 99;
+		} while (size == 0);
+		fill_buffer(buffer.data.pbytes, val, size);
+		buffer.data.len = size;
+		buffer.type = 1;
+
+		if (msgsnd(id, &buffer, size + 1, 0) < 0) {
+			tst_res(TFAIL | TERRNO, "msgsnd() on queue %d, write %d",
+				w->qidx, i + 1);
+			test_failed = 1;
+			break;
+		}
+		w->msgs++;
+	}
+
+	return NULL;
+}
+
+static void *reader_fn(void *arg)
+{
+	struct stress_worker *w = arg;
+	struct mbuffer buffer;
+	int id = queues[w->qidx];
+	char val = (w->qidx + 1) % 255;
+	int i, size;
+
+	pthread_barrier_wait(&barrier);
+
+	for (i = 0; i < w->nreps; i++) {
+		memset(&buffer, 0, sizeof(buffer));
+
+		size = msgrcv(id, &buffer, 100, 1, 0);
+		if (size < 0) {
+			tst_res(TFAIL | TERRNO, "msgrcv() on queue %d, read %d",
+				w->qidx, i + 1);
+			test_failed = 1;
+			break;
+		}
+		if (buffer.data.len + 1 != size) {
+			tst_res(TFAIL,
+				"Size mismatch on queue %d, read %d: got %d, expected %d",
+				w->qidx, i + 1, buffer.data.len + 1, size);
+			test_failed = 1;
+			break;
+		}
+		if (verify(buffer.data.pbytes, val, size - 1, w->qidx)) {
+			tst_res(TFAIL, "Verify failed on queue %d, read %d",
+				w->qidx, i + 1);
+			test_failed = 1;
+			break;
+		}
+		w->msgs++;
+	}
+
+	return NULL;
+}
+
+static void run(void)
+{
+	struct timespec t_start, t_stop;
+	unsigned long sent = 0, received = 0;
+	long long elapsed_ms;
+	int i;
+
+	test_failed = 0;
+	pthread_barrier_init(&barrier, NULL, 2 * npairs + 1);
+
+	for (i = 0; i < nqueues; i++)
+		queues[i] = SAFE_MSGGET(IPC_PRIVATE,
+					IPC_CREAT | IPC_EXCL | 0600);
+
+	for (i = 0; i < npairs; i++) {
+		writers[i].qidx = readers[i].qidx = i % nqueues;
+		writers[i].nreps = readers[i].nreps = nreps;
+		writers[i].msgs = readers[i].msgs = 0;
+
+		SAFE_PTHREAD_CREATE(&writers[i].tid, NULL, writer_fn,
+				    &writers[i]);
+		SAFE_PTHREAD_CREATE(&readers[i].tid, NULL, reader_fn,
+				    &readers[i]);
+	}
+
+	pthread_barrier_wait(&barrier);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+	for (i = 0; i < npairs; i++) {
+		SAFE_PTHREAD_JOIN(writers[i].tid, NULL);
+		SAFE_PTHREAD_JOIN(readers[i].tid, NULL);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t_stop);
+	pthread_barrier_destroy(&barrier);
+
+	for (i = 0; i < nqueues; i++) {
+		SAFE_MSGCTL(queues[i], IPC_RMID, NULL);
+		queues[i] = -1;
+	}
+
+	for (i = 0; i < npairs; i++) {
+		sent += writers[i].msgs;
+		received += readers[i].msgs;
+	}
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t_stop, t_start), 1LL);
+
+	tst_res(TINFO,
+		"%d queue(s), %d pair(s): %lu msgs in %llims (%.0f msgs/s)",
+		nqueues, npairs, sent, elapsed_ms,
+		1000.0 * sent / elapsed_ms);
+
+	if (test_failed)
+		tst_brk(TFAIL, "Errors detected in worker threads");
+
+	if (sent != received) {
+		tst_res(TFAIL, "Sent %lu messages, received %lu",
+			sent, received);
+		return;
+	}
+
+	tst_res(TPASS, "All %lu messages passed through intact", sent);
+}
+
+static void setup(void)
+{
+	int i;
+
+	npairs = MAX(tst_ncpus(), 2L);
+
+	if (str_nqueues) {
+		if (tst_parse_int(str_nqueues, &nqueues, 1, MAX_QUEUES))
+			tst_brk(TBROK, "Invalid queue count '%s'", str_nqueues);
+	}
+
+	if (str_npairs) {
+		if (tst_parse_int(str_npairs, &npairs, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid pair count '%s'", str_npairs);
+	}
+
+	if (str_nreps) {
+		if (tst_parse_int(str_nreps, &nreps, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid iteration count '%s'",
+				str_nreps);
+	}
+
+	if (nqueues > npairs) {
+		tst_res(TINFO, "Capping queues to the %d thread pair(s)",
+			npairs);
+		nqueues = npairs;
+	}
+
+	writers = SAFE_MALLOC(npairs * sizeof(*writers));
+	readers = SAFE_MALLOC(npairs * sizeof(*readers));
+	queues = SAFE_MALLOC(nqueues * sizeof(*queues));
+	for (i = 0; i < nqueues; i++)
+		queues[i] = -1;
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	if (queues) {
+		for (i = 0; i < nqueues; i++) {
+			if (queues[i] >= 0)
+				SAFE_MSGCTL(queues[i], IPC_RMID, NULL);
+		}
+		free(queues);
+	}
+
+	free(writers);
+	free(readers);
+}
+
+static struct tst_test test = {
+	.options = (struct tst_option[]) {
+		{"q:", &str_nqueues, "-q N     Number of message queues (default 4)"},
+		{"n:", &str_npairs, "-n N     Number of sender/receiver thread pairs (default: all CPUs)"},
+		{"l:", &str_nreps, "-l N     Messages per sender thread (default 10000)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -0,0 +1,351 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * keyctl09 - key management operation throughput benchmark
+ *
+ * The other add_key/keyctl tests verify API correctness with a handful
+ * of keys, which leaves keyring scalability regressions (thousands of
+ * keys, contended searches from many threads) without any LTP signal.
+ *
+ * This test populates a process keyring with -k user keys and reports:
+ *
+ *  - add_key() rate while populating, with per-call latency percentiles
+ *  - KEYCTL_SEARCH rate over random descriptions from -t concurrent
+ *    threads, where description comparison and keyring locking costs
+ *    show up
+ *  - request_key() rate from the same threads, which adds the full
+ *    process-keyring walk per lookup
+ *  - add_key() and KEYCTL_READ rates for -B big_key keys, whose
+ *    payloads take the separate big-key storage path (skipped when the
+ *    kernel lacks CONFIG_BIG_KEYS)
+ *
+ * The numbers are reported with tst_res(TINFO), the test only fails
+ * when an operation itself fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_clocks.h"
+#include "tst_timer.h"
+#include "tst_hist.h"
+#include "lapi/keyctl.h"
+
+#define PAYLOAD_SZ 64
+#define BIG_PAYLOAD_SZ 8192
+#define MAX_THREADS 64
+
+static int nkeys = 2000;
+static int nbig = 100;
+static int nthreads = 4;
+static int nlookups = 5000;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static char *str_nkeys;
+static char *str_nbig;
+static char *str_nthreads;
+static char *str_nlookups;
+static char *str_hist_bits;
+
+static key_serial_t keyring;
+static struct tst_hist hist;
+
+struct worker {
+	pthread_t tid;
+	unsigned int prng;
+	long long ops;
+	long long failed;
+	struct tst_hist hist;
+};
+
+static struct worker workers[MAX_THREADS];
+
+/* local PRNG so the lookup sequence does not depend on libc */
+static unsigned int prng_next(unsigned int *state)
+{
+	*state = *state * 1103515245 + 12345;
+	return (*state >> 16) & 0x7fff;
+}
+
+static void key_desc(char *buf, size_t len, int i)
+{
+	snprintf(buf, len, "kbench:%06i", i);
+}
+
+static long long elapsed_us(struct timespec t1, struct timespec t2)
+{
+	return MAX(tst_timespec_diff_us(t2, t1), 1LL);
+}
+
+static void report(const char *op, long long ops, long long us,
+		   struct tst_hist *h)
+{
+	tst_res(TINFO,
+		"%-14s %8.0f ops/s (%lli calls in %llius), p50 %llius, p99 %llius, p99.9 %llius",
+		op, 1000000.0 * ops / us, ops, us,
+		tst_hist_percentile(h, 50),
+		tst_hist_percentile(h, 99),
+		tst_hist_percentile(h, 99.9));
+}
+
+static void bench_add(void)
+{
+	char payload[PAYLOAD_SZ] = "keyring benchmark payload";
+	struct timespec t1, t2;
+	char desc[32];
+	int i;
+
+	tst_hist_reset(&hist);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nkeys; i++) {
+		key_desc(desc, sizeof(desc), i);
+
+		tst_timer_start(CLOCK_MONOTONIC);
+		if (add_key("user", desc, payload, sizeof(payload),
+			    keyring) == -1)
+			tst_brk(TBROK | TERRNO, "add_key(%s)", desc);
+		tst_timer_stop();
+
+		tst_hist_add(&hist, tst_timer_elapsed_us());
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	report("add_key", nkeys, elapsed_us(t1, t2), &hist);
+}
+
+static void *search_worker(void *arg)
+{
+	struct worker *w = arg;
+	struct timespec t1, t2;
+	char desc[32];
+	int i;
+
+	for (i = 0; i < nlookups; i++) {
+		key_desc(desc, sizeof(desc), prng_next(&w->prng) % nkeys);
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (keyctl(KEYCTL_SEARCH, keyring, "user", desc, 0) == -1) {
+			w->failed++;
+			continue;
+		}
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		tst_hist_add(&w->hist, elapsed_us(t1, t2));
+		w->ops++;
+	}
+
+	return NULL;
+}
+
+static void *request_worker(void *arg)
+{
+	struct worker *w = arg;
+	struct timespec t1, t2;
+	char desc[32];
+	int i;
+
+	for (i = 0; i < nlookups; i++) {
+		key_desc(desc, sizeof(desc), prng_next(&w->prng) % nkeys);
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (request_key("user", desc, NULL, 0) == -1) {
+			w->failed++;
+			continue;
+		}
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		tst_hist_add(&w->hist, elapsed_us(t1, t2));
+		w->ops++;
+	}
+
+	return NULL;
+}
+
+static void bench_threaded(const char *op, void *(*fn)(void *))
+{
+	struct timespec t1, t2;
+	long long ops = 0, failed = 0;
+	int i;
+
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < nthreads; i++) {
+		workers[i].prng = i + 1;
+		workers[i].ops = 0;
+		workers[i].failed = 0;
+		tst_hist_reset(&workers[i].hist);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_CREATE(&workers[i].tid, NULL, fn, &workers[i]);
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_JOIN(workers[i].tid, NULL);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	for (i = 0; i < nthreads; i++) {
+		ops += workers[i].ops;
+		failed += workers[i].failed;
+		tst_hist_merge(&hist, &workers[i].hist);
+	}
+
+	if (failed) {
+		tst_res(TFAIL, "%s: %lli of %lli lookups failed",
+			op, failed, failed + ops);
+		return;
+	}
+
+	report(op, ops, elapsed_us(t1, t2), &hist);
+}
+
+static void bench_big_keys(void)
+{
+	struct timespec t1, t2;
+	char *payload = SAFE_MALLOC(BIG_PAYLOAD_SZ);
+	char desc[32];
+	long long us;
+	int i;
+
+	memset(payload, 'b', BIG_PAYLOAD_SZ);
+
+	snprintf(desc, sizeof(desc), "kbench-big:%06i", 0);
+	if (add_key("big_key", desc, payload, BIG_PAYLOAD_SZ,
+		    keyring) == -1) {
+		tst_res(TINFO,
+			"big_key keys not supported, skipping the big-key phase");
+		free(payload);
+		return;
+	}
+
+	tst_hist_reset(&hist);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 1; i < nbig; i++) {
+		snprintf(desc, sizeof(desc), "kbench-big:%06i", i);
+
+		tst_timer_start(CLOCK_MONOTONIC);
+		if (add_key("big_key", desc, payload, BIG_PAYLOAD_SZ,
+			    keyring) == -1)
+			tst_brk(TBROK | TERRNO, "add_key(%s)", desc);
+		tst_timer_stop();
+
+		tst_hist_add(&hist, tst_timer_elapsed_us());
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	report("add_key big", nbig - 1, elapsed_us(t1, t2), &hist);
+
+	tst_hist_reset(&hist);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nbig; i++) {
+		key_serial_t key;
+
+		snprintf(desc, sizeof(desc), "kbench-big:%06i", i);
+
+		key = keyctl(KEYCTL_SEARCH, keyring, "big_key", desc, 0);
+		if (key == -1)
+			tst_brk(TBROK | TERRNO, "KEYCTL_SEARCH(%s)", desc);
+
+		tst_timer_start(CLOCK_MONOTONIC);
+		if (keyctl(KEYCTL_READ, key, payload, BIG_PAYLOAD_SZ) == -1)
+			tst_brk(TBROK | TERRNO, "KEYCTL_READ(%s)", desc);
+		tst_timer_stop();
+
+		tst_hist_add(&hist, tst_timer_elapsed_us());
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	us = elapsed_us(t1, t2);
+
+	report("read big", nbig, us, &hist);
+	tst_res(TINFO, "big-key read bandwidth %.1f MB/s",
+		(double)nbig * BIG_PAYLOAD_SZ / us);
+
+	free(payload);
+}
+
+static void run(void)
+{
+	keyring = add_key("keyring", "kbench_ring", NULL, 0,
+			  KEY_SPEC_PROCESS_KEYRING);
+	if (keyring == -1)
+		tst_brk(TBROK | TERRNO, "add_key(keyring)");
+
+	bench_add();
+	bench_threaded("keyctl_search", search_worker);
+	bench_threaded("request_key", request_worker);
+	bench_big_keys();
+
+	if (keyctl(KEYCTL_CLEAR, keyring) == -1)
+		tst_res(TWARN | TERRNO, "KEYCTL_CLEAR failed");
+
+	if (keyctl(KEYCTL_UNLINK, keyring, KEY_SPEC_PROCESS_KEYRING) == -1)
+		tst_res(TWARN | TERRNO, "KEYCTL_UNLINK failed");
+
+	tst_res(TPASS, "keyring survived %i keys and %i search threads",
+		nkeys, nthreads);
+}
+
+static void setup(void)
+{
+	int i;
+
+	if (str_nkeys && tst_parse_int(str_nkeys, &nkeys, 1, 1000000))
+		tst_brk(TBROK, "Invalid key count '%s'", str_nkeys);
+
+	if (str_nbig && tst_parse_int(str_nbig, &nbig, 1, 100000))
+		tst_brk(TBROK, "Invalid big key count '%s'", str_nbig);
+
+	if (str_nthreads && tst_parse_int(str_nthreads, &nthreads,
+					  1, MAX_THREADS))
+		tst_brk(TBROK, "Invalid thread count '%s'", str_nthreads);
+
+	if (str_nlookups && tst_parse_int(str_nlookups, &nlookups, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid lookup count '%s'", str_nlookups);
+
+	if (str_hist_bits && tst_parse_int(str_hist_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid histogram bits '%s'", str_hist_bits);
+
+	tst_hist_init(&hist, hist_bits);
+
+	for (i = 0; i < nthreads; i++)
+		tst_hist_init(&workers[i].hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	tst_hist_free(&hist);
+
+	for (i = 0; i < nthreads; i++)
+		tst_hist_free(&workers[i].hist);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.options = (struct tst_option[]) {
+		{"k:", &str_nkeys, "-k N     User keys to add (default 2000)"},
+		{"B:", &str_nbig, "-B N     big_key keys to add (default 100)"},
+		{"t:", &str_nthreads, "-t N     Concurrent lookup threads (default 4)"},
+		{"n:", &str_nlookups, "-n N     Lookups per thread (default 5000)"},
+		{"b:", &str_hist_bits, "-b bits  Histogram sub-bucket bits, sets resolution to 2^-bits (default 7)"},
+		{}
+	},
+	.needs_root = 1,
+};
@@ -44,16 +44,9 @@ static void *fmem;
 
 static void setup(void)
 {
-	char cwd[1024];
-	char tmpcpattern[1048];
 	char *fmemc;
 	int i;
 	unsigned int filter;
-	struct rlimit limit;
-
-	limit.rlim_max = RLIM_INFINITY;
-	limit.rlim_cur = limit.rlim_max;
-	SAFE_SETRLIMIT(RLIMIT_CORE, &limit);
 
 	switch (prctl(PR_GET_DUMPABLE)) {
 	case 0:
@@ -68,10 +61,7 @@ static void setup(void)
 	if (!(0x1 & filter))
 		tst_brk(TCONF, "Anonymous private memory is not dumpable.");
 
-	SAFE_GETCWD(cwd, sizeof(cwd));
-	snprintf(tmpcpattern, sizeof(tmpcpattern), "%s/dump-%%p", cwd);
-	tst_res(TINFO, "Temporary core pattern is '%s'", tmpcpattern);
-	SAFE_FILE_PRINTF(CORE_PATTERN, "%s", tmpcpattern);
+	tst_enable_coredumps();
 
 	fmem = SAFE_MMAP(NULL,
 			 FMEMSIZE,
@@ -100,18 +90,12 @@ static void cleanup(void)
 		SAFE_CLOSE(dfd);
 }
 
-static int find_sequence(int pid)
+static int find_sequence(const char *dumpname)
 {
 	char expectc = 'x';
 	ssize_t read, pos = 0;
 	char rbuf[1024];
 	int ycount = 0;
-	char dumpname[256];
-
-	snprintf(dumpname, 256, "dump-%d", pid);
-	tst_res(TINFO, "Dump file should be %s", dumpname);
-	if (access(dumpname, F_OK))
-		tst_brk(TBROK | TERRNO, "Dump file was not found.");
 
 	dfd = SAFE_OPEN(dumpname, O_RDONLY);
 
@@ -153,7 +137,7 @@ static int find_sequence(int pid)
 
 static pid_t run_child(int advice)
 {
-	int status;
+	siginfo_t info;
 	pid_t pid;
 	char *advstr =
 		advice == MADV_DONTDUMP ? "MADV_DONTDUMP" : "MADV_DODUMP";
@@ -171,34 +155,41 @@ static pid_t run_child(int advice)
 		abort();
 	}
 
-	SAFE_WAITPID(pid, &status, 0);
-	if (WIFSIGNALED(status) && WCOREDUMP(status))
+	tst_reap_crasher(pid, &info);
+	if (info.si_code == CLD_DUMPED)
 		return pid;
-	if (WIFEXITED(status))
+	if (info.si_code == CLD_EXITED)
 		return 0;
 
 	tst_res(TCONF, "No coredump produced after signal (%d)",
-		WTERMSIG(status));
+		info.si_status);
 
 	return 0;
 }
 
 static void run(unsigned int test_nr)
 {
+	char dumpname[256];
 	pid_t pid;
 
 	if (!test_nr) {
 		pid = run_child(MADV_DONTDUMP);
-		if (pid && find_sequence(pid))
+		if (!pid)
+			return;
+		tst_wait_coredump(pid, dumpname, sizeof(dumpname), 10000);
+		if (find_sequence(dumpname))
 			tst_res(TFAIL,
 				"Found sequence in dump when MADV_DONTDUMP set");
-		else if (pid)
+		else
 			tst_res(TPASS, "madvise(..., MADV_DONTDUMP)");
 	} else {
 		pid = run_child(MADV_DODUMP);
-		if (pid && find_sequence(pid))
+		if (!pid)
+			return;
+		tst_wait_coredump(pid, dumpname, sizeof(dumpname), 10000);
+		if (find_sequence(dumpname))
 			tst_res(TPASS, "madvise(..., MADV_DODUMP)");
-		else if (pid)
+		else
 			tst_res(TFAIL,
 				"No sequence in dump after MADV_DODUMP.");
 	}
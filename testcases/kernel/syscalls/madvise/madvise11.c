@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * madvise11 - process_madvise() batching benchmark
+ *
+ * Memory-manager daemons that used to loop madvise(MADV_COLD/PAGEOUT)
+ * over many regions now hand the kernel one process_madvise() call with
+ * a large iovec, and the win of that move rests entirely on the batched
+ * path staying cheap. Nothing here checks advice semantics - the other
+ * madvise tests do - this prices the dispatch.
+ *
+ * For MADV_COLD and MADV_PAGEOUT, across several region counts, the
+ * same set of touched regions is advised twice: once with one madvise()
+ * call per region and once with a single process_madvise() on a pidfd
+ * of the caller, regions re-touched before each pass so both act on
+ * resident pages. Throughput is reported as pages/s for both paths.
+ *
+ * At the largest region count the batched call must not be slower than
+ * the loop by more than half - if a single syscall over N ranges loses
+ * clearly to N syscalls, the batching is broken and every consumer of
+ * process_madvise() regressed.
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/mmap.h"
+#include "lapi/pidfd_open.h"
+#include "lapi/syscalls.h"
+
+#define REGION_PAGES 16
+
+static const int region_counts[] = { 64, 256, 1024 };
+
+static const struct advice {
+	const char *name;
+	int advice;
+} advices[] = {
+	{ "MADV_COLD", MADV_COLD },
+	{ "MADV_PAGEOUT", MADV_PAGEOUT },
+};
+
+static char *set;
+static long page_size;
+static long region_size;
+static long max_regions;
+static int pidfd = -1;
+static struct iovec *vec;
+
+static void touch_regions(int nregions)
+{
+	long i;
+
+	for (i = 0; i < nregions * region_size; i += page_size)
+		set[i] = i;
+}
+
+static long long bench_loop(int nregions, int advice)
+{
+	struct timespec t1, t2;
+	int i;
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nregions; i++) {
+		if (madvise(set + i * region_size, region_size, advice))
+			tst_brk(TBROK | TERRNO, "madvise() loop");
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	return MAX(tst_timespec_diff_us(t2, t1), 1LL);
+}
+
+static long long bench_batched(int nregions, int advice)
+{
+	struct timespec t1, t2;
+	long ret;
+	int i;
+
+	for (i = 0; i < nregions; i++) {
+		vec[i].iov_base = set + i * region_size;
+		vec[i].iov_len = region_size;
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	ret = tst_syscall(__NR_process_madvise, pidfd, vec, nregions,
+			  advice, 0);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	if (ret != nregions * region_size) {
+		tst_res(TWARN, "process_madvise() advised %li of %li bytes",
+			ret, nregions * region_size);
+	}
+
+	return MAX(tst_timespec_diff_us(t2, t1), 1LL);
+}
+
+static void run(unsigned int n)
+{
+	const struct advice *adv = &advices[n];
+	long long loop_us = 0, batched_us = 0;
+	long npages;
+	unsigned int i;
+
+	if (madvise(set, region_size, adv->advice)) {
+		tst_res(TCONF, "%s not supported", adv->name);
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(region_counts); i++) {
+		int nregions = region_counts[i];
+
+		npages = (long)nregions * REGION_PAGES;
+
+		touch_regions(nregions);
+		loop_us = bench_loop(nregions, adv->advice);
+
+		touch_regions(nregions);
+		batched_us = bench_batched(nregions, adv->advice);
+
+		tst_res(TINFO,
+			"%-12s %4i regions: loop %8.0f pages/s, batched %8.0f pages/s",
+			adv->name, nregions,
+			1000000.0 * npages / loop_us,
+			1000000.0 * npages / batched_us);
+	}
+
+	/* numbers from the largest region count decide */
+	if (2 * batched_us <= 3 * loop_us) {
+		tst_res(TPASS, "%s: batched advice keeps up with the loop",
+			adv->name);
+	} else {
+		tst_res(TFAIL,
+			"%s: one process_madvise() call took %llius, %i madvise() calls %llius",
+			adv->name, batched_us, region_counts[i - 1], loop_us);
+	}
+}
+
+static void setup(void)
+{
+	unsigned int i;
+
+	page_size = getpagesize();
+	region_size = REGION_PAGES * page_size;
+
+	max_regions = 0;
+	for (i = 0; i < ARRAY_SIZE(region_counts); i++)
+		max_regions = MAX(max_regions, (long)region_counts[i]);
+
+	if (max_regions > IOV_MAX)
+		tst_brk(TBROK, "region count exceeds IOV_MAX");
+
+	set = SAFE_MMAP(NULL, max_regions * region_size,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	vec = SAFE_MALLOC(max_regions * sizeof(*vec));
+
+	pidfd = pidfd_open(getpid(), 0);
+	if (pidfd == -1)
+		tst_brk(TBROK | TERRNO, "pidfd_open()");
+
+	/* probe, brks with TCONF on ENOSYS */
+	vec[0].iov_base = set;
+	vec[0].iov_len = region_size;
+	if (tst_syscall(__NR_process_madvise, pidfd, vec, 1, MADV_COLD, 0) < 0)
+		tst_brk(TCONF | TERRNO, "process_madvise()");
+}
+
+static void cleanup(void)
+{
+	if (pidfd != -1)
+		SAFE_CLOSE(pidfd);
+
+	free(vec);
+
+	if (set)
+		SAFE_MUNMAP(set, max_regions * region_size);
+}
+
+static struct tst_test test = {
+	.test = run,
+	.tcnt = ARRAY_SIZE(advices),
+	.setup = setup,
+	.cleanup = cleanup,
+	.min_kver = "5.10",
+};
@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * migrate_pages04 - NUMA page migration bandwidth benchmark
+ *
+ * The migrate_pages and move_pages tests verify placement policy
+ * correctness but never measure migration speed, so a batching change
+ * in the migration path can halve cross-node rebalance rates without
+ * failing anything.
+ *
+ * This benchmark binds a working set to one node and bounces it
+ * between every allowed node pair, through both interfaces a
+ * rebalancer would use:
+ *
+ *  - move_pages() with one entry per base page, which prices the
+ *    per-page isolate/copy/remap path, and
+ *
+ *  - migrate_pages() with whole nodemasks, which prices the batched
+ *    mempolicy walk.
+ *
+ * Both are run against base pages and, where transparent hugepages are
+ * available, against a MADV_HUGEPAGE working set, since THP migration
+ * takes a different path and regresses independently. Throughput is
+ * reported per node pair in MB/s and pages/s, and the final page
+ * placement is verified after every pass.
+ */
+
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/syscalls.h"
+#include "lapi/mmap.h"
+#include "numa_helper.h"
+#include "migrate_pages_common.h"
+
+#ifdef HAVE_NUMA_V2
+
+#define THP_PATH "/sys/kernel/mm/transparent_hugepage/enabled"
+
+static int *nodes;
+static int num_nodes;
+static long page_size;
+
+static long long set_bytes = 64 * 1024 * 1024;
+static int loops = 3;
+
+static char *str_set_size;
+static char *str_loops;
+
+static unsigned long max_node;
+static unsigned long nodemask_size;
+static int have_thp;
+
+static void **page_ptrs;
+static int *target_nodes;
+static int *move_status;
+static long npages;
+
+static void *alloc_working_set(int node, int thp)
+{
+	unsigned long *nodemask;
+	char *set;
+	long i;
+
+	set = SAFE_MMAP(NULL, set_bytes, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (madvise(set, set_bytes, thp ? MADV_HUGEPAGE : MADV_NOHUGEPAGE))
+		tst_brk(TBROK | TERRNO, "madvise()");
+
+	nodemask = SAFE_MALLOC(nodemask_size);
+	memset(nodemask, 0, nodemask_size);
+	set_bit(nodemask, node, 1);
+
+	if (tst_syscall(__NR_mbind, set, set_bytes, MPOL_BIND, nodemask,
+			max_node, 0))
+		tst_brk(TBROK | TERRNO, "mbind(MPOL_BIND, node %i)", node);
+	free(nodemask);
+
+	for (i = 0; i < set_bytes; i += page_size)
+		set[i] = i;
+
+	return set;
+}
+
+static long count_misplaced(char *set, int node)
+{
+	long i, misplaced = 0;
+
+	for (i = 0; i < npages; i++) {
+		page_ptrs[i] = set + i * page_size;
+		move_status[i] = -1;
+	}
+
+	if (tst_syscall(__NR_move_pages, 0, npages, page_ptrs, NULL,
+			move_status, 0))
+		tst_brk(TBROK | TERRNO, "move_pages() status query");
+
+	for (i = 0; i < npages; i++) {
+		if (move_status[i] != node)
+			misplaced++;
+	}
+
+	return misplaced;
+}
+
+static void report(const char *what, int from, int to, int thp,
+		   long long elapsed_us, long misplaced)
+{
+	long long us = MAX(elapsed_us, 1LL);
+
+	tst_res(TINFO,
+		"%-13s node%i->node%i %-4s: %7.0f MB/s, %9.0f pages/s",
+		what, from, to, thp ? "thp" : "base",
+		(double)set_bytes / us,
+		1000000.0 * npages / us);
+
+	if (misplaced) {
+		tst_res(TFAIL, "%s left %li of %li pages off node%i",
+			what, misplaced, npages, to);
+	}
+}
+
+static void bench_move_pages(int from, int to, int thp)
+{
+	struct timespec t1, t2;
+	long long elapsed = 0;
+	char *set;
+	long i, ret;
+	int loop, src, dst;
+
+	set = alloc_working_set(from, thp);
+
+	src = from;
+	dst = to;
+
+	for (loop = 0; loop < loops; loop++) {
+		for (i = 0; i < npages; i++) {
+			page_ptrs[i] = set + i * page_size;
+			target_nodes[i] = dst;
+			move_status[i] = -1;
+		}
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		ret = tst_syscall(__NR_move_pages, 0, npages, page_ptrs,
+				  target_nodes, move_status, MPOL_MF_MOVE);
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		if (ret > 0)
+			tst_res(TINFO, "move_pages() skipped %li pages", ret);
+
+		/* only the forward direction is reported */
+		if (dst == to)
+			elapsed += tst_timespec_diff_us(t2, t1);
+
+		src = dst;
+		dst = (src == to) ? from : to;
+	}
+
+	report("move_pages", from, to, thp, elapsed / ((loops + 1) / 2),
+	       count_misplaced(set, src));
+
+	SAFE_MUNMAP(set, set_bytes);
+}
+
+static void bench_migrate_pages(int from, int to, int thp)
+{
+	struct timespec t1, t2;
+	unsigned long *src_mask, *dst_mask;
+	long long elapsed = 0, ret;
+	char *set;
+	int loop, src, dst;
+
+	set = alloc_working_set(from, thp);
+
+	src_mask = SAFE_MALLOC(nodemask_size);
+	dst_mask = SAFE_MALLOC(nodemask_size);
+
+	src = from;
+	dst = to;
+
+	for (loop = 0; loop < loops; loop++) {
+		memset(src_mask, 0, nodemask_size);
+		memset(dst_mask, 0, nodemask_size);
+		set_bit(src_mask, src, 1);
+		set_bit(dst_mask, dst, 1);
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		ret = tst_syscall(__NR_migrate_pages, 0, max_node, src_mask,
+				  dst_mask);
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		if (ret > 0) {
+			tst_res(TINFO,
+				"migrate_pages() left %lli pages behind", ret);
+		}
+
+		if (dst == to)
+			elapsed += tst_timespec_diff_us(t2, t1);
+
+		src = dst;
+		dst = (src == to) ? from : to;
+	}
+
+	report("migrate_pages", from, to, thp, elapsed / ((loops + 1) / 2),
+	       count_misplaced(set, src));
+
+	free(src_mask);
+	free(dst_mask);
+	SAFE_MUNMAP(set, set_bytes);
+}
+
+static void run(void)
+{
+	int i, j, thp;
+
+	for (i = 0; i < num_nodes; i++) {
+		for (j = 0; j < num_nodes; j++) {
+			if (i == j)
+				continue;
+
+			for (thp = 0; thp <= have_thp; thp++) {
+				bench_move_pages(nodes[i], nodes[j], thp);
+				bench_migrate_pages(nodes[i], nodes[j], thp);
+			}
+		}
+	}
+
+	tst_res(TPASS, "migrated %llimb sets across %i node pair(s)",
+		set_bytes / (1024 * 1024), num_nodes * (num_nodes - 1));
+}
+
+static void setup(void)
+{
+	char thp_setting[128];
+	int ret;
+
+	if (str_set_size) {
+		int set_mb;
+
+		if (tst_parse_int(str_set_size, &set_mb, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid working set size '%s'",
+				str_set_size);
+		set_bytes = (long long)set_mb * 1024 * 1024;
+	}
+
+	if (str_loops && tst_parse_int(str_loops, &loops, 1, INT_MAX))
+		tst_brk(TBROK, "Invalid loop count '%s'", str_loops);
+
+	ret = get_allowed_nodes_arr(NH_MEMS, &num_nodes, &nodes);
+	if (ret < 0)
+		tst_brk(TBROK | TERRNO, "get_allowed_nodes_arr");
+	if (num_nodes < 2)
+		tst_brk(TCONF, "at least 2 allowed NUMA nodes are needed");
+
+	page_size = getpagesize();
+	set_bytes = LTP_ALIGN(set_bytes, page_size);
+	npages = set_bytes / page_size;
+
+	max_node = LTP_ALIGN(get_max_node(), sizeof(unsigned long) * 8);
+	nodemask_size = max_node / 8;
+
+	if (!access(THP_PATH, F_OK)) {
+		SAFE_FILE_SCANF(THP_PATH, "%127[^\n]", thp_setting);
+		have_thp = !strstr(thp_setting, "[never]");
+	}
+	if (!have_thp)
+		tst_res(TINFO, "THP disabled, base pages only");
+
+	page_ptrs = SAFE_MALLOC(npages * sizeof(*page_ptrs));
+	target_nodes = SAFE_MALLOC(npages * sizeof(*target_nodes));
+	move_status = SAFE_MALLOC(npages * sizeof(*move_status));
+}
+
+static void cleanup(void)
+{
+	free(page_ptrs);
+	free(target_nodes);
+	free(move_status);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.options = (struct tst_option[]) {
+		{"s:", &str_set_size, "-s MB    Working set size per pass (default 64)"},
+		{"l:", &str_loops, "-l N     Bounce passes per node pair (default 3)"},
+		{}
+	},
+};
+#else
+TST_TEST_TCONF(NUMA_ERROR_MSG);
+#endif
@@ -0,0 +1,379 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * mlock05 - bulk mlock/munlock scaling benchmark
+ *
+ * mlock01-04 check limits and semantics on a few pages, which says
+ * nothing about the cost of locking the tens of GB a low-latency
+ * service pins at startup, where page-walk changes have regressed
+ * mlock time unnoticed.
+ *
+ * For every combination of region size (-s total split /16, /4, /1)
+ * and thread count (1 doubling up to -t) the threads carve the region
+ * into per-thread chunks and lock them in 4MB stripes, one timed call
+ * per stripe:
+ *
+ *  - lock:    mlock() of untouched anonymous memory, page population
+ *             included, the startup path
+ *  - unlock:  munlock() of the same stripes
+ *  - onfault: mlock2(MLOCK_ONFAULT) of fresh memory, then touching it,
+ *             splitting lock setup from population
+ *
+ * plus a single threaded mlockall(MCL_CURRENT)/munlockall() pass over
+ * the touched region. Every phase reports GB/s and per-stripe latency
+ * percentiles, and -o appends the records in the structured
+ * 'tag=... ops=... duration=...' format the other benchmarks emit for
+ * trending.
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "tst_hist.h"
+#include "lapi/syscalls.h"
+#include "lapi/mlock2.h"
+
+#define STRIPE_SZ (4 * 1024 * 1024)
+#define MAX_THREADS 32
+
+static int total_mb = 256;
+static int max_threads = 4;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static char *str_total_mb;
+static char *str_max_threads;
+static char *str_hist_bits;
+static char *result_file;
+
+static int have_mlock2 = 1;
+static struct tst_hist hist;
+
+enum phase {
+	PHASE_LOCK,
+	PHASE_UNLOCK,
+	PHASE_ONFAULT,
+};
+
+struct worker {
+	pthread_t tid;
+	char *addr;
+	size_t bytes;
+	enum phase phase;
+	int failed;
+	struct tst_hist hist;
+};
+
+static struct worker workers[MAX_THREADS];
+
+static long long elapsed_us(struct timespec t1, struct timespec t2)
+{
+	return MAX(tst_timespec_diff_us(t2, t1), 1LL);
+}
+
+static void touch(char *addr, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i += getpagesize())
+		addr[i] = i;
+}
+
+static int stripe_op(struct worker *w, char *addr, size_t len)
+{
+	switch (w->phase) {
+	case PHASE_LOCK:
+		return mlock(addr, len);
+	case PHASE_UNLOCK:
+		return munlock(addr, len);
+	case PHASE_ONFAULT:
+		if (tst_syscall(__NR_mlock2, addr, len, MLOCK_ONFAULT))
+			return -1;
+		touch(addr, len);
+		return 0;
+	}
+
+	return -1;
+}
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	struct timespec t1, t2;
+	size_t off, len;
+
+	for (off = 0; off < w->bytes; off += STRIPE_SZ) {
+		len = MIN((size_t)STRIPE_SZ, w->bytes - off);
+
+		tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+		if (stripe_op(w, w->addr + off, len)) {
+			w->failed = 1;
+			return NULL;
+		}
+		tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+		tst_hist_add(&w->hist, elapsed_us(t1, t2));
+	}
+
+	return NULL;
+}
+
+static void write_result(const char *tag, long long ops, long long bytes,
+			 long long us)
+{
+	FILE *f;
+
+	if (!result_file)
+		return;
+
+	f = fopen(result_file, "a");
+	if (!f) {
+		tst_res(TWARN | TERRNO, "Failed to open '%s'", result_file);
+		return;
+	}
+
+	fprintf(f, "tag=mlock05.%s ops=%lli bytes=%lli duration=%lli "
+		"p50=%lli p90=%lli p99=%lli p99.9=%lli\n",
+		tag, ops, bytes, us,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 90),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
+	if (fclose(f))
+		tst_res(TWARN | TERRNO, "Failed to close '%s'", result_file);
+}
+
+/* Returns 0 on success, aggregates per-stripe latencies into hist */
+static int run_phase(const char *name, enum phase phase, size_t bytes,
+		     int nthreads, long long *us)
+{
+	struct timespec t1, t2;
+	size_t chunk = bytes / nthreads;
+	long long ops = 0;
+	char tag[64];
+	int i, failed = 0;
+
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < nthreads; i++) {
+		workers[i].bytes = chunk;
+		workers[i].phase = phase;
+		workers[i].failed = 0;
+		tst_hist_reset(&workers[i].hist);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_CREATE(&workers[i].tid, NULL, worker_fn,
+				    &workers[i]);
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_JOIN(workers[i].tid, NULL);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	*us = elapsed_us(t1, t2);
+
+	for (i = 0; i < nthreads; i++) {
+		failed |= workers[i].failed;
+		ops += (chunk + STRIPE_SZ - 1) / STRIPE_SZ;
+		tst_hist_merge(&hist, &workers[i].hist);
+	}
+
+	if (failed) {
+		tst_res(TFAIL | TERRNO, "%s failed", name);
+		return -1;
+	}
+
+	snprintf(tag, sizeof(tag), "%s_%zum_t%i", name, bytes >> 20, nthreads);
+	write_result(tag, ops, bytes, *us);
+
+	return 0;
+}
+
+static int bench_combo(size_t bytes, int nthreads)
+{
+	size_t chunk = bytes / nthreads;
+	long long lock_us, unlock_us, onfault_us = 0;
+	int i, ret = -1;
+
+	for (i = 0; i < nthreads; i++) {
+		workers[i].addr = SAFE_MMAP(NULL, chunk,
+					    PROT_READ | PROT_WRITE,
+					    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+
+	if (run_phase("lock", PHASE_LOCK, bytes, nthreads, &lock_us))
+		goto out;
+
+	if (run_phase("unlock", PHASE_UNLOCK, bytes, nthreads, &unlock_us))
+		goto out;
+
+	if (have_mlock2) {
+		/* fresh memory again, so the lock itself populates nothing */
+		for (i = 0; i < nthreads; i++) {
+			SAFE_MUNMAP(workers[i].addr, chunk);
+			workers[i].addr = SAFE_MMAP(NULL, chunk,
+					PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		}
+
+		if (run_phase("onfault", PHASE_ONFAULT, bytes, nthreads,
+			      &onfault_us))
+			goto out;
+	}
+
+	if (have_mlock2) {
+		tst_res(TINFO,
+			"%4zuMB %2i threads: lock %6.2f GB/s, munlock %6.2f GB/s, onfault+touch %6.2f GB/s",
+			bytes >> 20, nthreads,
+			bytes / 1073.742 / lock_us,
+			bytes / 1073.742 / unlock_us,
+			bytes / 1073.742 / onfault_us);
+	} else {
+		tst_res(TINFO,
+			"%4zuMB %2i threads: lock %6.2f GB/s, munlock %6.2f GB/s",
+			bytes >> 20, nthreads,
+			bytes / 1073.742 / lock_us,
+			bytes / 1073.742 / unlock_us);
+	}
+
+	ret = 0;
+out:
+	for (i = 0; i < nthreads; i++) {
+		if (workers[i].addr)
+			SAFE_MUNMAP(workers[i].addr, chunk);
+		workers[i].addr = NULL;
+	}
+
+	return ret;
+}
+
+static int bench_mlockall(size_t bytes)
+{
+	struct timespec t1, t2;
+	long long us;
+	char *addr;
+
+	addr = SAFE_MMAP(NULL, bytes, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	touch(addr, bytes);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	if (mlockall(MCL_CURRENT)) {
+		tst_res(TFAIL | TERRNO, "mlockall(MCL_CURRENT) failed");
+		SAFE_MUNMAP(addr, bytes);
+		return -1;
+	}
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	us = elapsed_us(t1, t2);
+
+	if (munlockall()) {
+		tst_res(TFAIL | TERRNO, "munlockall() failed");
+		SAFE_MUNMAP(addr, bytes);
+		return -1;
+	}
+
+	tst_res(TINFO, "%4zuMB mlockall(MCL_CURRENT): %6.2f GB/s",
+		bytes >> 20, bytes / 1073.742 / us);
+
+	tst_hist_reset(&hist);
+	tst_hist_add(&hist, us);
+	write_result("mlockall", 1, bytes, us);
+
+	SAFE_MUNMAP(addr, bytes);
+
+	return 0;
+}
+
+static void run(void)
+{
+	size_t total = (size_t)total_mb << 20;
+	size_t sizes[] = {total / 16, total / 4, total};
+	unsigned int i;
+	int t, failed = 0;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		for (t = 1; t <= max_threads; t *= 2) {
+			if (sizes[i] / t < (size_t)STRIPE_SZ)
+				continue;
+
+			if (bench_combo(sizes[i], t))
+				failed = 1;
+		}
+
+		if (bench_mlockall(sizes[i]))
+			failed = 1;
+	}
+
+	if (!failed)
+		tst_res(TPASS, "lock/unlock cycles survived up to %iMB and %i threads",
+			total_mb, max_threads);
+}
+
+static void setup(void)
+{
+	int i;
+
+	if (str_total_mb && tst_parse_int(str_total_mb, &total_mb, 16, INT_MAX))
+		tst_brk(TBROK, "Invalid total size '%s'", str_total_mb);
+
+	if (str_max_threads && tst_parse_int(str_max_threads, &max_threads,
+					     1, MAX_THREADS))
+		tst_brk(TBROK, "Invalid thread count '%s'", str_max_threads);
+
+	if (str_hist_bits && tst_parse_int(str_hist_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid histogram bits '%s'", str_hist_bits);
+
+	if (SAFE_READ_MEMINFO("MemAvailable:") / 1024 < total_mb + 128) {
+		tst_brk(TCONF, "Not enough memory for a %iMB working set",
+			total_mb);
+	}
+
+	/* raw syscall, tst_syscall() would TCONF the whole test */
+	if (syscall(__NR_mlock2, NULL, 0, 0) && errno == ENOSYS) {
+		tst_res(TINFO, "mlock2() not supported, skipping the onfault phases");
+		have_mlock2 = 0;
+	}
+
+	tst_hist_init(&hist, hist_bits);
+
+	for (i = 0; i < max_threads; i++)
+		tst_hist_init(&workers[i].hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	tst_hist_free(&hist);
+
+	for (i = 0; i < max_threads; i++)
+		tst_hist_free(&workers[i].hist);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.options = (struct tst_option[]) {
+		{"s:", &str_total_mb, "-s MB    Largest region size (default 256)"},
+		{"t:", &str_max_threads, "-t N     Max concurrent locking threads (default 4)"},
+		{"b:", &str_hist_bits, "-b bits  Histogram sub-bucket bits, sets resolution to 2^-bits (default 7)"},
+		{"o:", &result_file, "-o file  Append structured results to a file"},
+		{}
+	},
+	.needs_root = 1,
+};
@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * mmap_perf01 - mmap/munmap scaling benchmark
+ *
+ * The mmap test directories validate semantics only, so mmap_lock
+ * contention - the usual many-core scalability complaint - produces no
+ * signal here. This benchmark runs map/fault/unmap cycles in parallel
+ * threads sharing one mm and reports cycles per second for a matrix
+ * of patterns:
+ *
+ *  - touch: mmap, write one byte per page, munmap; faults with the
+ *    mmap_lock taken for reading between two writers,
+ *
+ *  - populate: mmap with MAP_POPULATE then munmap; the faults happen
+ *    under the map's own write lock section,
+ *
+ *  - recycle: one long-lived mapping per thread, touch all pages then
+ *    MADV_DONTNEED; fault and zap traffic with no map/unmap at all,
+ *
+ * each for anonymous and file-backed private mappings, two mapping
+ * sizes, and single-threaded versus one thread per CPU. Comparing the
+ * single and multi-thread lines exposes lock contention rather than
+ * raw fault cost.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+
+#define TEST_FILE "mmap_perf_file"
+
+enum mode {
+	MODE_TOUCH,
+	MODE_POPULATE,
+	MODE_RECYCLE,
+};
+
+static const char *const mode_names[] = { "touch", "populate", "recycle" };
+static const size_t sizes[] = { 16 * 4096, 256 * 4096 };
+
+static int iters = 1000;
+static int max_threads;
+static int file_fd = -1;
+static long page_size;
+
+static size_t cur_size;
+static enum mode cur_mode;
+static int cur_file_backed;
+static pthread_barrier_t barrier;
+
+static char *str_iters;
+static char *str_threads;
+
+static void touch_pages(char *p, size_t size)
+{
+	size_t off;
+
+	for (off = 0; off < size; off += page_size)
+		p[off] = 1;
+}
+
+static void *worker(void *arg LTP_ATTRIBUTE_UNUSED)
+{
+	int flags = MAP_PRIVATE | (cur_file_backed ? 0 : MAP_ANONYMOUS);
+	int fd = cur_file_backed ? file_fd : -1;
+	size_t size = cur_size;
+	char *p = NULL;
+	int i;
+
+	if (cur_mode == MODE_RECYCLE) {
+		p = SAFE_MMAP(NULL, size, PROT_READ | PROT_WRITE, flags,
+			      fd, 0);
+	}
+
+	pthread_barrier_wait(&barrier);
+
+	for (i = 0; i < iters; i++) {
+		switch (cur_mode) {
+		case MODE_TOUCH:
+			p = SAFE_MMAP(NULL, size, PROT_READ | PROT_WRITE,
+				      flags, fd, 0);
+			touch_pages(p, size);
+			SAFE_MUNMAP(p, size);
+			break;
+		case MODE_POPULATE:
+			p = SAFE_MMAP(NULL, size, PROT_READ | PROT_WRITE,
+				      flags | MAP_POPULATE, fd, 0);
+			SAFE_MUNMAP(p, size);
+			break;
+		case MODE_RECYCLE:
+			touch_pages(p, size);
+			if (madvise(p, size, MADV_DONTNEED))
+				tst_brk(TBROK | TERRNO, "madvise(DONTNEED)");
+			break;
+		}
+	}
+
+	if (cur_mode == MODE_RECYCLE)
+		SAFE_MUNMAP(p, size);
+
+	return NULL;
+}
+
+static void bench(int file_backed, enum mode mode, size_t size, int nthreads)
+{
+	struct timespec t1, t2;
+	long long elapsed_ms;
+	pthread_t *tids;
+	int i;
+
+	cur_file_backed = file_backed;
+	cur_mode = mode;
+	cur_size = size;
+
+	tids = SAFE_MALLOC(nthreads * sizeof(pthread_t));
+
+	if (pthread_barrier_init(&barrier, NULL, nthreads + 1))
+		tst_brk(TBROK, "pthread_barrier_init()");
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_CREATE(&tids[i], NULL, worker, NULL);
+
+	pthread_barrier_wait(&barrier);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nthreads; i++)
+		SAFE_PTHREAD_JOIN(tids[i], NULL);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	pthread_barrier_destroy(&barrier);
+	free(tids);
+
+	elapsed_ms = MAX(tst_timespec_diff_ms(t2, t1), 1LL);
+	tst_res(TINFO,
+		"%-4s %-8s %4zuK, %2i threads: %9.0f cycles/s",
+		file_backed ? "file" : "anon", mode_names[mode], size / 1024,
+		nthreads, 1000.0 * nthreads * iters / elapsed_ms);
+}
+
+static void bench_threads(int nthreads)
+{
+	unsigned int s;
+	int file_backed;
+	enum mode mode;
+
+	for (file_backed = 0; file_backed <= 1; file_backed++) {
+		for (mode = MODE_TOUCH; mode <= MODE_RECYCLE; mode++) {
+			for (s = 0; s < ARRAY_SIZE(sizes); s++)
+				bench(file_backed, mode, sizes[s], nthreads);
+		}
+	}
+}
+
+static void run(void)
+{
+	bench_threads(1);
+	if (max_threads > 1)
+		bench_threads(max_threads);
+
+	tst_res(TPASS, "map/fault/unmap cycles measured up to %i threads",
+		max_threads);
+}
+
+static void setup(void)
+{
+	char *buf;
+	size_t max_size = sizes[ARRAY_SIZE(sizes) - 1];
+
+	page_size = getpagesize();
+
+	if (str_iters) {
+		if (tst_parse_int(str_iters, &iters, 1, INT_MAX))
+			tst_brk(TBROK, "Invalid cycle count '%s'", str_iters);
+	}
+
+	max_threads = tst_ncpus();
+	if (str_threads) {
+		if (tst_parse_int(str_threads, &max_threads, 1, 4096))
+			tst_brk(TBROK, "Invalid thread count '%s'",
+				str_threads);
+	}
+
+	buf = SAFE_MALLOC(max_size);
+	memset(buf, 'm', max_size);
+
+	file_fd = SAFE_OPEN(TEST_FILE, O_RDWR | O_CREAT, 0644);
+	SAFE_WRITE(1, file_fd, buf, max_size);
+	free(buf);
+}
+
+static void cleanup(void)
+{
+	if (file_fd != -1)
+		SAFE_CLOSE(file_fd);
+}
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.options = (struct tst_option[]) {
+		{"r:", &str_iters, "-r N     Cycles per thread (default 1000)"},
+		{"t:", &str_threads, "-t N     Max threads (default: one per CPU)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
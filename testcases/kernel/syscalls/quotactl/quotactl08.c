@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * quotactl08 - quota accounting overhead benchmark
+ *
+ * The other quotactl tests validate the API but say nothing about what
+ * quota accounting costs on the write path, where regressions have
+ * slipped through (e.g. ext4 quota journaling changes). This test runs
+ * the same two workloads in three quota states and reports the
+ * relative slowdown:
+ *
+ *  - metadata-heavy: create, write 4KB and unlink -n files
+ *  - data-heavy: write a -s MB file in 1MB chunks and fsync
+ *
+ * measured with quota off, with quota accounting turned on, and with
+ * limits set just above what the workload needs, so every block
+ * allocation is checked against a nearby limit.
+ *
+ * The numbers are reported with tst_res(TINFO), the test only fails
+ * when a workload or quotactl call itself fails.
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include "lapi/quotactl.h"
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+
+#ifndef QFMT_VFS_V0
+# define QFMT_VFS_V0	2
+#endif
+#define FMTID	QFMT_VFS_V0
+#define MNTPOINT	"mntpoint"
+#define USRPATH MNTPOINT "/aquota.user"
+#define GRPPATH MNTPOINT "/aquota.group"
+#define METADIR MNTPOINT "/meta"
+#define DATAFILE MNTPOINT "/datafile"
+
+#define CHUNK_SZ (1024 * 1024)
+#define META_FILE_SZ 4096
+
+enum {
+	STATE_OFF,
+	STATE_ON,
+	STATE_LIMIT,
+	NSTATES,
+};
+
+static const char *state_names[] = {"quota off", "quota on", "near limit"};
+
+static int nfiles = 1000;
+static int data_mb = 32;
+
+static char *str_nfiles;
+static char *str_data_mb;
+
+static int test_id;
+static char chunk[CHUNK_SZ];
+
+static long long meta_us[NSTATES];
+static long long data_us[NSTATES];
+
+static long long elapsed_us(struct timespec t1, struct timespec t2)
+{
+	return MAX(tst_timespec_diff_us(t2, t1), 1LL);
+}
+
+static void workload_meta(void)
+{
+	char path[PATH_MAX];
+	int i, fd;
+
+	for (i = 0; i < nfiles; i++) {
+		snprintf(path, sizeof(path), METADIR "/f%06i", i);
+		fd = SAFE_OPEN(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+		SAFE_WRITE(1, fd, chunk, META_FILE_SZ);
+		SAFE_CLOSE(fd);
+	}
+
+	for (i = 0; i < nfiles; i++) {
+		snprintf(path, sizeof(path), METADIR "/f%06i", i);
+		SAFE_UNLINK(path);
+	}
+}
+
+static void workload_data(void)
+{
+	int i, fd;
+
+	fd = SAFE_OPEN(DATAFILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	for (i = 0; i < data_mb; i++)
+		SAFE_WRITE(1, fd, chunk, CHUNK_SZ);
+
+	SAFE_FSYNC(fd);
+	SAFE_CLOSE(fd);
+	SAFE_UNLINK(DATAFILE);
+}
+
+static void run_state(int state)
+{
+	struct timespec t1, t2;
+
+	sync();
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	workload_meta();
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	meta_us[state] = elapsed_us(t1, t2);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	workload_data();
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	data_us[state] = elapsed_us(t1, t2);
+
+	tst_res(TINFO,
+		"%-10s: %7.0f meta ops/s, %6.1f MB/s data",
+		state_names[state],
+		1000000.0 * 2 * nfiles / meta_us[state],
+		1000000.0 * data_mb / data_us[state]);
+}
+
+static void set_limits(void)
+{
+	struct dqblk set_dq;
+
+	memset(&set_dq, 0, sizeof(set_dq));
+
+	/*
+	 * Twice the data workload on top of the current usage: close
+	 * enough that every allocation is checked against it, far
+	 * enough that nothing hits EDQUOT.
+	 */
+	if (quotactl(QCMD(Q_GETQUOTA, USRQUOTA), tst_device->dev,
+		     test_id, (void *)&set_dq) == -1)
+		tst_brk(TBROK | TERRNO, "Q_GETQUOTA failed");
+
+	set_dq.dqb_bhardlimit = set_dq.dqb_curspace / 1024 +
+		2 * (data_mb * 1024 + nfiles * META_FILE_SZ / 1024);
+	set_dq.dqb_bsoftlimit = set_dq.dqb_bhardlimit;
+	set_dq.dqb_valid = QIF_BLIMITS;
+
+	if (quotactl(QCMD(Q_SETQUOTA, USRQUOTA), tst_device->dev,
+		     test_id, (void *)&set_dq) == -1)
+		tst_brk(TBROK | TERRNO, "Q_SETQUOTA failed");
+}
+
+static void report_slowdown(const char *wl, long long *us)
+{
+	tst_res(TINFO,
+		"%s: quota on %+.1f%%, near limit %+.1f%% vs quota off",
+		wl,
+		100.0 * (us[STATE_ON] - us[STATE_OFF]) / us[STATE_OFF],
+		100.0 * (us[STATE_LIMIT] - us[STATE_OFF]) / us[STATE_OFF]);
+}
+
+static void verify_quota_overhead(void)
+{
+	const char *const cmd[] = {"quotacheck", "-ugF", "vfsv0", MNTPOINT,
+				   NULL};
+
+	SAFE_MKDIR(METADIR, 0755);
+
+	run_state(STATE_OFF);
+
+	SAFE_CMD(cmd, NULL, NULL);
+
+	if (access(USRPATH, F_OK) == -1)
+		tst_brk(TBROK | TERRNO, "user quotafile didn't exist");
+
+	if (quotactl(QCMD(Q_QUOTAON, USRQUOTA), tst_device->dev,
+		     FMTID, USRPATH) == -1)
+		tst_brk(TBROK | TERRNO, "Q_QUOTAON failed");
+
+	run_state(STATE_ON);
+
+	set_limits();
+	run_state(STATE_LIMIT);
+
+	if (quotactl(QCMD(Q_QUOTAOFF, USRQUOTA), tst_device->dev,
+		     0, NULL) == -1)
+		tst_brk(TBROK | TERRNO, "Q_QUOTAOFF failed");
+
+	report_slowdown("metadata", meta_us);
+	report_slowdown("data", data_us);
+
+	SAFE_RMDIR(METADIR);
+	SAFE_UNLINK(USRPATH);
+	SAFE_UNLINK(GRPPATH);
+
+	tst_res(TPASS, "workloads completed in all quota states");
+}
+
+static void setup(void)
+{
+	if (str_nfiles && tst_parse_int(str_nfiles, &nfiles, 1, 1000000))
+		tst_brk(TBROK, "Invalid file count '%s'", str_nfiles);
+
+	if (str_data_mb && tst_parse_int(str_data_mb, &data_mb, 1, 100000))
+		tst_brk(TBROK, "Invalid data size '%s'", str_data_mb);
+
+	test_id = geteuid();
+	memset(chunk, 'q', sizeof(chunk));
+}
+
+static struct tst_test test = {
+	.needs_root = 1,
+	.needs_kconfigs = (const char *[]) {
+		"CONFIG_QFMT_V2",
+		NULL
+	},
+	.test_all = verify_quota_overhead,
+	.mount_device = 1,
+	.dev_fs_type = "ext4",
+	.mntpoint = MNTPOINT,
+	.mnt_data = "usrquota,grpquota",
+	.needs_cmds = (const char *const []) {
+		"quotacheck",
+		NULL
+	},
+	.options = (struct tst_option[]) {
+		{"n:", &str_nfiles, "-n N     Files in the metadata workload (default 1000)"},
+		{"s:", &str_data_mb, "-s MB    Size of the data workload (default 32)"},
+		{}
+	},
+	.setup = setup,
+};
@@ -156,6 +156,7 @@ static int read_testfile(struct tcase *tc, int do_readahead,
 	int fd;
 	size_t i = 0;
 	long read_bytes_start;
+	long long resident;
 	unsigned char *p, tmp;
 	off_t offset = 0;
 
@@ -175,6 +176,12 @@ static int read_testfile(struct tcase *tc, int do_readahead,
 		tst_res(TINFO, "readahead calls made: %zu", i);
 		*cached = get_cached_size();
 
+		resident = tst_pagecache_resident_bytes(fd, 0, fsize);
+		if (resident >= 0) {
+			tst_res(TINFO, "testfile resident in cache: %lli kB",
+				resident / 1024);
+		}
+
 		/* offset of file shouldn't change after readahead */
 		offset = SAFE_LSEEK(fd, 0, SEEK_CUR);
 		if (offset == 0)
@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * readahead03 - readahead effectiveness sweep benchmark
+ *
+ * readahead02 checks that one explicit readahead of one file layout
+ * saves I/O; this test sweeps the space a heuristic change actually
+ * moves in. For every combination of
+ *
+ *  - file size (small enough to sit in one readahead window vs many),
+ *  - layout (contiguously vs fragmented, the latter produced by
+ *    interleaving the writes with a filler file and fsyncing each
+ *    chunk so the allocator splits the extents), and
+ *  - hint (none, i.e. the kernel's natural readahead on a sequential
+ *    reader, readahead(2), or POSIX_FADV_WILLNEED)
+ *
+ * it drops the caches and reads the file sequentially, reporting the
+ * time to the first byte, the full read time and the cache hit ratio
+ * computed from the read_bytes delta in /proc/self/io during the read
+ * phase - bytes that did not hit the disk were prefetched. Hints are
+ * issued before the timed read so a hint that blocks shows up in the
+ * time to first byte.
+ *
+ * The sweep only fails when a read fails; the value is in the numbers.
+ */
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/syscalls.h"
+
+#define DROP_CACHES_FNAME "/proc/sys/vm/drop_caches"
+#define PROC_IO_FNAME "/proc/self/io"
+#define MNTPOINT "mntpoint"
+
+#define CHUNK_SZ (256 * 1024)
+#define HINT_SZ (2 * 1024 * 1024)
+#define READ_BUF_SZ (1024 * 1024)
+
+static const size_t file_sizes[] = {
+	8 * 1024 * 1024,
+	64 * 1024 * 1024,
+};
+
+static int hint_none(int fd LTP_ATTRIBUTE_UNUSED,
+		     off_t offset LTP_ATTRIBUTE_UNUSED,
+		     size_t len LTP_ATTRIBUTE_UNUSED)
+{
+	return 0;
+}
+
+static int hint_readahead(int fd, off_t offset, size_t len)
+{
+	return readahead(fd, offset, len);
+}
+
+static int hint_willneed(int fd, off_t offset, size_t len)
+{
+	/* posix_fadvise returns the error number instead of setting errno */
+	errno = posix_fadvise(fd, offset, len, POSIX_FADV_WILLNEED);
+	return errno ? -1 : 0;
+}
+
+static const struct hint {
+	const char *name;
+	int (*issue)(int fd, off_t offset, size_t len);
+} hints[] = {
+	{ "natural", hint_none },
+	{ "readahead", hint_readahead },
+	{ "willneed", hint_willneed },
+};
+
+static char *read_buf;
+static int hint_supported[ARRAY_SIZE(hints)];
+
+static void write_chunks(int fd, char *buf, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i += CHUNK_SZ) {
+		SAFE_WRITE(1, fd, buf, CHUNK_SZ);
+		SAFE_FSYNC(fd);
+	}
+}
+
+static void create_file(const char *name, size_t size, int fragmented)
+{
+	char filler[PATH_MAX + 8];
+	int fd, filler_fd = -1;
+	char *buf;
+	size_t i;
+
+	buf = SAFE_MALLOC(CHUNK_SZ);
+	memset(buf, 'a', CHUNK_SZ);
+
+	fd = SAFE_OPEN(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (!fragmented) {
+		write_chunks(fd, buf, size);
+		SAFE_CLOSE(fd);
+		free(buf);
+		return;
+	}
+
+	/*
+	 * Interleave with a filler file, fsyncing each chunk so delayed
+	 * allocation cannot merge our extents behind our back. Best
+	 * effort - the allocator decides, but it usually obliges.
+	 */
+	snprintf(filler, sizeof(filler), "%s.filler", name);
+	filler_fd = SAFE_OPEN(filler, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	for (i = 0; i < size; i += CHUNK_SZ) {
+		SAFE_WRITE(1, fd, buf, CHUNK_SZ);
+		SAFE_FSYNC(fd);
+		SAFE_WRITE(1, filler_fd, buf, CHUNK_SZ);
+		SAFE_FSYNC(filler_fd);
+	}
+
+	SAFE_CLOSE(filler_fd);
+	SAFE_CLOSE(fd);
+	SAFE_UNLINK(filler);
+	free(buf);
+}
+
+static unsigned long get_bytes_read(void)
+{
+	unsigned long ret;
+
+	SAFE_FILE_LINES_SCANF(PROC_IO_FNAME, "read_bytes: %lu", &ret);
+
+	return ret;
+}
+
+static void bench_config(const char *fname, size_t fsize, int fragmented,
+			 unsigned int hint)
+{
+	struct timespec t1, t2, t3;
+	unsigned long read_start, read_bytes;
+	long long ttfb_us, read_us;
+	double hit_ratio;
+	off_t offset;
+	ssize_t ret;
+	size_t done;
+	int fd;
+
+	sync();
+	SAFE_FILE_PRINTF(DROP_CACHES_FNAME, "3");
+
+	fd = SAFE_OPEN(fname, O_RDONLY);
+
+	for (offset = 0; (size_t)offset < fsize; offset += HINT_SZ) {
+		TEST(hints[hint].issue(fd, offset,
+				       MIN((size_t)HINT_SZ, fsize - offset)));
+		if (TST_RET) {
+			if (TST_ERR == EINVAL && hint_supported[hint]) {
+				hint_supported[hint] = 0;
+				tst_res(TCONF, "%s not supported on %s",
+					hints[hint].name,
+					tst_device->fs_type);
+			}
+			SAFE_CLOSE(fd);
+			return;
+		}
+	}
+
+	read_start = get_bytes_read();
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	ret = read(fd, read_buf, READ_BUF_SZ);
+	if (ret < 0)
+		tst_brk(TBROK | TERRNO, "read(%s)", fname);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	for (done = ret; done < fsize; done += ret) {
+		ret = read(fd, read_buf, READ_BUF_SZ);
+		if (ret < 0)
+			tst_brk(TBROK | TERRNO, "read(%s)", fname);
+		if (!ret)
+			tst_brk(TBROK, "short file: %zu of %zu", done, fsize);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t3);
+
+	read_bytes = get_bytes_read() - read_start;
+	SAFE_CLOSE(fd);
+
+	ttfb_us = tst_timespec_diff_us(t2, t1);
+	read_us = MAX(tst_timespec_diff_us(t3, t1), 1LL);
+	if (read_bytes < fsize)
+		hit_ratio = 100.0 * (fsize - read_bytes) / fsize;
+	else
+		hit_ratio = 0;
+
+	tst_res(TINFO,
+		"%3zumb %-10s %-9s: ttfb %6lldus, read %7.1fms (%5.0f MB/s), cache-hit %3.0f%%",
+		fsize / (1024 * 1024),
+		fragmented ? "fragmented" : "contiguous",
+		hints[hint].name, ttfb_us,
+		read_us / 1000.0,
+		(double)fsize / read_us,
+		hit_ratio);
+}
+
+static void run(void)
+{
+	char fname[PATH_MAX];
+	unsigned int size, frag, hint;
+
+	for (size = 0; size < ARRAY_SIZE(file_sizes); size++) {
+		for (frag = 0; frag < 2; frag++) {
+			snprintf(fname, sizeof(fname), MNTPOINT "/tf_%u_%u",
+				 size, frag);
+			create_file(fname, file_sizes[size], frag);
+
+			for (hint = 0; hint < ARRAY_SIZE(hints); hint++) {
+				if (!hint_supported[hint])
+					continue;
+				bench_config(fname, file_sizes[size], frag,
+					     hint);
+			}
+
+			SAFE_UNLINK(fname);
+		}
+	}
+
+	tst_res(TPASS, "readahead sweep completed");
+}
+
+static void setup(void)
+{
+	unsigned int i;
+
+	if (access(PROC_IO_FNAME, F_OK))
+		tst_brk(TCONF, "Requires " PROC_IO_FNAME);
+	if (access(DROP_CACHES_FNAME, W_OK))
+		tst_brk(TCONF, "Requires " DROP_CACHES_FNAME);
+
+	/* readahead() on a bad fd, just to detect ENOSYS early */
+	tst_syscall(__NR_readahead, 0, 0, 0);
+
+	read_buf = SAFE_MALLOC(READ_BUF_SZ);
+
+	for (i = 0; i < ARRAY_SIZE(hints); i++)
+		hint_supported[i] = 1;
+}
+
+static void cleanup(void)
+{
+	free(read_buf);
+}
+
+static struct tst_test test = {
+	.needs_root = 1,
+	.mount_device = 1,
+	.mntpoint = MNTPOINT,
+	.dev_min_size = 300,
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+	.timeout = 600,
+};
@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * splice_perf01 - zero-copy transfer syscall comparison
+ *
+ * The sendfile, splice, tee and copy_file_range tests each verify
+ * semantics in isolation, so a regression confined to one transfer
+ * path never shows up. This benchmark pushes the same dataset through
+ * every mechanism that fits a topology and reports GB/s and
+ * syscalls/GB for each:
+ *
+ *  - file to file: read/write baseline, sendfile, splice through an
+ *    intermediate pipe, copy_file_range,
+ *
+ *  - file to socket: read/write baseline, sendfile, splice through a
+ *    pipe, with a child draining the socket,
+ *
+ *  - pipe to pipe: read/write baseline, splice, and tee followed by a
+ *    splice to /dev/null to consume the teed source, with children
+ *    producing and draining the pipes.
+ *
+ * The dataset is written once in setup and stays cache-hot, so the
+ * numbers compare syscall paths rather than storage.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "tst_test.h"
+#include "tst_safe_net.h"
+#include "tst_timer.h"
+#include "tst_clocks.h"
+#include "lapi/syscalls.h"
+
+#define CHUNK (1 << 20)
+#define SRC_FILE "splice_perf_src"
+#define DST_FILE "splice_perf_dst"
+
+static long data_mb = 64;
+static long long nbytes;
+static char *buf;
+static int devnull_fd = -1;
+
+static char *str_data_mb;
+
+/*
+ * Each xfer_* moves nbytes from in_fd to out_fd and returns the number
+ * of syscalls it took.
+ */
+static long long xfer_rw(int in_fd, int out_fd)
+{
+	long long left = nbytes, nsys = 0;
+	ssize_t ret;
+
+	while (left > 0) {
+		ret = SAFE_READ(0, in_fd, buf, MIN(left, (long long)CHUNK));
+		SAFE_WRITE(1, out_fd, buf, ret);
+		nsys += 2;
+		left -= ret;
+	}
+
+	return nsys;
+}
+
+static long long xfer_sendfile(int in_fd, int out_fd)
+{
+	long long left = nbytes, nsys = 0;
+	off_t off = 0;
+	ssize_t ret;
+
+	while (left > 0) {
+		ret = sendfile(out_fd, in_fd, &off, MIN(left, (long long)CHUNK));
+		if (ret == -1)
+			tst_brk(TBROK | TERRNO, "sendfile()");
+		nsys++;
+		left -= ret;
+	}
+
+	return nsys;
+}
+
+static long long xfer_splice(int in_fd, int out_fd)
+{
+	long long left = nbytes, nsys = 0;
+	loff_t off = 0, *offp = &off;
+	ssize_t ret, moved;
+	int pfd[2];
+
+	/* pipes have no offsets */
+	if (lseek(in_fd, 0, SEEK_CUR) == -1)
+		offp = NULL;
+
+	SAFE_PIPE(pfd);
+
+	while (left > 0) {
+		ret = splice(in_fd, offp, pfd[1], NULL,
+			     MIN(left, (long long)CHUNK), 0);
+		if (ret == -1)
+			tst_brk(TBROK | TERRNO, "splice() to pipe");
+		nsys++;
+
+		while (ret > 0) {
+			moved = splice(pfd[0], NULL, out_fd, NULL, ret, 0);
+			if (moved == -1)
+				tst_brk(TBROK | TERRNO, "splice() from pipe");
+			nsys++;
+			ret -= moved;
+			left -= moved;
+		}
+	}
+
+	SAFE_CLOSE(pfd[0]);
+	SAFE_CLOSE(pfd[1]);
+
+	return nsys;
+}
+
+static long long xfer_cfr(int in_fd, int out_fd)
+{
+	long long left = nbytes, nsys = 0;
+	loff_t off_in = 0, off_out = 0;
+	ssize_t ret;
+
+	while (left > 0) {
+		ret = tst_syscall(__NR_copy_file_range, in_fd, &off_in,
+				  out_fd, &off_out,
+				  (size_t)MIN(left, (long long)CHUNK), 0U);
+		if (ret == -1)
+			tst_brk(TBROK | TERRNO, "copy_file_range()");
+		nsys++;
+		left -= ret;
+	}
+
+	return nsys;
+}
+
+static long long xfer_tee(int in_fd, int out_fd)
+{
+	long long left = nbytes, nsys = 0;
+	ssize_t ret, moved;
+
+	while (left > 0) {
+		ret = tee(in_fd, out_fd, MIN(left, (long long)CHUNK), 0);
+		if (ret == -1)
+			tst_brk(TBROK | TERRNO, "tee()");
+		nsys++;
+
+		/* consume the teed data left in the source pipe */
+		while (ret > 0) {
+			moved = splice(in_fd, NULL, devnull_fd, NULL, ret, 0);
+			if (moved == -1)
+				tst_brk(TBROK | TERRNO, "splice() to /dev/null");
+			nsys++;
+			ret -= moved;
+			left -= moved;
+		}
+	}
+
+	return nsys;
+}
+
+static void drain_child(int fd)
+{
+	long long left = nbytes;
+	char *dbuf = SAFE_MALLOC(CHUNK);
+	ssize_t ret;
+
+	while (left > 0) {
+		ret = SAFE_READ(0, fd, dbuf, MIN(left, (long long)CHUNK));
+		if (!ret)
+			break;
+		left -= ret;
+	}
+
+	free(dbuf);
+	exit(0);
+}
+
+static void produce_child(int fd)
+{
+	long long left = nbytes;
+	ssize_t ret;
+
+	while (left > 0) {
+		ret = SAFE_WRITE(0, fd, buf, MIN(left, (long long)CHUNK));
+		left -= ret;
+	}
+
+	SAFE_CLOSE(fd);
+	exit(0);
+}
+
+static void report(const char *topo, const char *mech, long long nsys,
+		   long long elapsed_us)
+{
+	double gb = nbytes / 1e9;
+
+	tst_res(TINFO, "%-14s %-15s: %6.2f GB/s, %7.0f syscalls/GB",
+		topo, mech, gb * 1e6 / MAX(elapsed_us, 1LL),
+		nsys / gb);
+}
+
+static void bench_file_file(const char *mech,
+			    long long (*xfer)(int in_fd, int out_fd))
+{
+	struct timespec t1, t2;
+	long long nsys;
+	int in_fd, out_fd;
+
+	in_fd = SAFE_OPEN(SRC_FILE, O_RDONLY);
+	out_fd = SAFE_OPEN(DST_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	nsys = xfer(in_fd, out_fd);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	SAFE_CLOSE(in_fd);
+	SAFE_CLOSE(out_fd);
+
+	report("file->file", mech, nsys, tst_timespec_diff_us(t2, t1));
+}
+
+static void bench_file_socket(const char *mech,
+			      long long (*xfer)(int in_fd, int out_fd))
+{
+	struct timespec t1, t2;
+	long long nsys;
+	int in_fd, sv[2];
+
+	in_fd = SAFE_OPEN(SRC_FILE, O_RDONLY);
+	SAFE_SOCKETPAIR(AF_UNIX, SOCK_STREAM, 0, sv);
+
+	if (!SAFE_FORK()) {
+		SAFE_CLOSE(sv[0]);
+		drain_child(sv[1]);
+	}
+	SAFE_CLOSE(sv[1]);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	nsys = xfer(in_fd, sv[0]);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	tst_reap_children();
+	SAFE_CLOSE(in_fd);
+	SAFE_CLOSE(sv[0]);
+
+	report("file->socket", mech, nsys, tst_timespec_diff_us(t2, t1));
+}
+
+static void bench_pipe_pipe(const char *mech,
+			    long long (*xfer)(int in_fd, int out_fd))
+{
+	struct timespec t1, t2;
+	long long nsys;
+	int src[2], dst[2];
+
+	SAFE_PIPE(src);
+	SAFE_PIPE(dst);
+
+	if (!SAFE_FORK()) {
+		SAFE_CLOSE(src[0]);
+		produce_child(src[1]);
+	}
+	SAFE_CLOSE(src[1]);
+
+	if (!SAFE_FORK()) {
+		SAFE_CLOSE(dst[1]);
+		drain_child(dst[0]);
+	}
+	SAFE_CLOSE(dst[0]);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+	nsys = xfer(src[0], dst[1]);
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	SAFE_CLOSE(dst[1]);
+	tst_reap_children();
+	SAFE_CLOSE(src[0]);
+
+	report("pipe->pipe", mech, nsys, tst_timespec_diff_us(t2, t1));
+}
+
+static void run(void)
+{
+	bench_file_file("read/write", xfer_rw);
+	bench_file_file("sendfile", xfer_sendfile);
+	bench_file_file("splice", xfer_splice);
+	bench_file_file("copy_file_range", xfer_cfr);
+
+	bench_file_socket("read/write", xfer_rw);
+	bench_file_socket("sendfile", xfer_sendfile);
+	bench_file_socket("splice", xfer_splice);
+
+	bench_pipe_pipe("read/write", xfer_rw);
+	bench_pipe_pipe("splice", xfer_splice);
+	bench_pipe_pipe("tee", xfer_tee);
+
+	tst_res(TPASS, "Transfer mechanisms compared over %li MB", data_mb);
+}
+
+static void setup(void)
+{
+	long long left;
+	int fd;
+
+	if (str_data_mb) {
+		if (tst_parse_long(str_data_mb, &data_mb, 1, 65536))
+			tst_brk(TBROK, "Invalid dataset size '%s'",
+				str_data_mb);
+	}
+
+	nbytes = data_mb * 1024 * 1024;
+
+	buf = SAFE_MALLOC(CHUNK);
+	memset(buf, 's', CHUNK);
+
+	fd = SAFE_OPEN(SRC_FILE, O_WRONLY | O_CREAT, 0644);
+	for (left = nbytes; left > 0; left -= CHUNK)
+		SAFE_WRITE(1, fd, buf, MIN(left, (long long)CHUNK));
+	SAFE_CLOSE(fd);
+
+	devnull_fd = SAFE_OPEN("/dev/null", O_WRONLY);
+}
+
+static void cleanup(void)
+{
+	free(buf);
+
+	if (devnull_fd != -1)
+		SAFE_CLOSE(devnull_fd);
+}
+
+static struct tst_test test = {
+	.needs_tmpdir = 1,
+	.forks_child = 1,
+	.min_kver = "4.5",
+	.options = (struct tst_option[]) {
+		{"s:", &str_data_mb, "-s MB    Dataset size in megabytes (default 64)"},
+		{}
+	},
+	.setup = setup,
+	.cleanup = cleanup,
+	.test_all = run,
+};
@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * statx08 - metadata read throughput benchmark
+ *
+ * statx01-07 verify field correctness on a handful of files, while
+ * backup and scanning workloads are bound by stat throughput over
+ * millions of inodes. This test builds a tree of -d directories with
+ * -f files each and measures statx() calls per second:
+ *
+ *  - with a minimal mask (STATX_MODE|STATX_SIZE), the basic mask and
+ *    STATX_ALL, since the mask decides how much of the inode the
+ *    kernel has to assemble
+ *  - cold (right after dropping dentry/inode caches) and warm
+ *  - with 1 doubling up to -w parallel walkers, each statx()ing its
+ *    share of directories through a dirfd-relative path, the way
+ *    fleet scanners batch per-directory lookups
+ *
+ * Per-call latency percentiles come from the shared histogram helpers
+ * and -o appends the records in the structured 'tag=... ops=...'
+ * format for trending. The test only fails when statx() itself fails.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <pthread.h>
+#include "tst_test.h"
+#include "tst_safe_pthread.h"
+#include "tst_clocks.h"
+#include "tst_timer.h"
+#include "tst_hist.h"
+#include "lapi/stat.h"
+
+#define MAX_WALKERS 32
+
+static int ndirs = 100;
+static int nfiles = 100;
+static int max_walkers = 4;
+static int hist_bits = TST_HIST_DEFAULT_BITS;
+
+static char *str_ndirs;
+static char *str_nfiles;
+static char *str_max_walkers;
+static char *str_hist_bits;
+static char *result_file;
+
+static struct tst_hist hist;
+
+struct mask_tcase {
+	const char *name;
+	unsigned int mask;
+};
+
+static struct mask_tcase masks[] = {
+	{"minimal", STATX_MODE | STATX_SIZE},
+	{"basic", STATX_BASIC_STATS},
+	{"all", STATX_ALL},
+};
+
+struct walker {
+	pthread_t tid;
+	int first_dir;
+	int num_dirs;
+	unsigned int mask;
+	int failed;
+	struct tst_hist hist;
+};
+
+static struct walker walkers[MAX_WALKERS];
+
+static long long elapsed_us(struct timespec t1, struct timespec t2)
+{
+	return MAX(tst_timespec_diff_us(t2, t1), 1LL);
+}
+
+static void *walker_fn(void *arg)
+{
+	struct walker *w = arg;
+	struct timespec t1, t2;
+	struct statx buf;
+	char name[32];
+	int d, f, dirfd;
+
+	for (d = w->first_dir; d < w->first_dir + w->num_dirs; d++) {
+		snprintf(name, sizeof(name), "dir%06i", d);
+		dirfd = SAFE_OPEN(name, O_RDONLY | O_DIRECTORY);
+
+		for (f = 0; f < nfiles; f++) {
+			snprintf(name, sizeof(name), "f%06i", f);
+
+			tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+			if (statx(dirfd, name, 0, w->mask, &buf)) {
+				w->failed = 1;
+				SAFE_CLOSE(dirfd);
+				return NULL;
+			}
+			tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+
+			tst_hist_add(&w->hist, elapsed_us(t1, t2));
+		}
+
+		SAFE_CLOSE(dirfd);
+	}
+
+	return NULL;
+}
+
+static void write_result(const char *tag, long long ops, long long us)
+{
+	FILE *f;
+
+	if (!result_file)
+		return;
+
+	f = fopen(result_file, "a");
+	if (!f) {
+		tst_res(TWARN | TERRNO, "Failed to open '%s'", result_file);
+		return;
+	}
+
+	fprintf(f, "tag=statx08.%s ops=%lli bytes=0 duration=%lli "
+		"p50=%lli p90=%lli p99=%lli p99.9=%lli\n",
+		tag, ops, us,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 90),
+		tst_hist_percentile(&hist, 99),
+		tst_hist_percentile(&hist, 99.9));
+
+	if (fclose(f))
+		tst_res(TWARN | TERRNO, "Failed to close '%s'", result_file);
+}
+
+static int bench_walk(struct mask_tcase *mc, const char *temp, int nwalkers)
+{
+	struct timespec t1, t2;
+	long long ops, us;
+	char tag[64];
+	int i, failed = 0;
+	int per_walker = ndirs / nwalkers;
+
+	tst_hist_reset(&hist);
+
+	for (i = 0; i < nwalkers; i++) {
+		walkers[i].first_dir = i * per_walker;
+		walkers[i].num_dirs = per_walker;
+		walkers[i].mask = mc->mask;
+		walkers[i].failed = 0;
+		tst_hist_reset(&walkers[i].hist);
+	}
+	/* leftover directories go to the last walker */
+	walkers[nwalkers - 1].num_dirs += ndirs % nwalkers;
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (i = 0; i < nwalkers; i++)
+		SAFE_PTHREAD_CREATE(&walkers[i].tid, NULL, walker_fn,
+				    &walkers[i]);
+
+	for (i = 0; i < nwalkers; i++)
+		SAFE_PTHREAD_JOIN(walkers[i].tid, NULL);
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &t2);
+	us = elapsed_us(t1, t2);
+
+	for (i = 0; i < nwalkers; i++) {
+		failed |= walkers[i].failed;
+		tst_hist_merge(&hist, &walkers[i].hist);
+	}
+
+	if (failed) {
+		tst_res(TFAIL | TERRNO, "statx() failed in a %s %s walk",
+			mc->name, temp);
+		return -1;
+	}
+
+	ops = (long long)ndirs * nfiles;
+
+	tst_res(TINFO,
+		"%-7s mask, %s, %2i walkers: %8.0f calls/s, p50 %llius, p99 %llius",
+		mc->name, temp, nwalkers, 1000000.0 * ops / us,
+		tst_hist_percentile(&hist, 50),
+		tst_hist_percentile(&hist, 99));
+
+	snprintf(tag, sizeof(tag), "%s_%s_w%i", mc->name, temp, nwalkers);
+	write_result(tag, ops, us);
+
+	return 0;
+}
+
+static void drop_caches(void)
+{
+	sync();
+	SAFE_FILE_PRINTF("/proc/sys/vm/drop_caches", "3");
+}
+
+static void run(void)
+{
+	unsigned int i;
+	int w, failed = 0;
+
+	for (i = 0; i < ARRAY_SIZE(masks); i++) {
+		drop_caches();
+
+		if (bench_walk(&masks[i], "cold", 1))
+			failed = 1;
+
+		for (w = 1; w <= max_walkers; w *= 2) {
+			if (w > ndirs)
+				break;
+
+			if (bench_walk(&masks[i], "warm", w))
+				failed = 1;
+		}
+	}
+
+	if (!failed)
+		tst_res(TPASS, "scanned %i files per walk in all variants",
+			ndirs * nfiles);
+}
+
+static void setup(void)
+{
+	char path[64];
+	int d, f, fd, i;
+
+	if (str_ndirs && tst_parse_int(str_ndirs, &ndirs, 1, 1000000))
+		tst_brk(TBROK, "Invalid directory count '%s'", str_ndirs);
+
+	if (str_nfiles && tst_parse_int(str_nfiles, &nfiles, 1, 1000000))
+		tst_brk(TBROK, "Invalid file count '%s'", str_nfiles);
+
+	if (str_max_walkers && tst_parse_int(str_max_walkers, &max_walkers,
+					     1, MAX_WALKERS))
+		tst_brk(TBROK, "Invalid walker count '%s'", str_max_walkers);
+
+	if (str_hist_bits && tst_parse_int(str_hist_bits, &hist_bits, 1, 16))
+		tst_brk(TBROK, "Invalid histogram bits '%s'", str_hist_bits);
+
+	tst_res(TINFO, "Creating %i directories with %i files each",
+		ndirs, nfiles);
+
+	for (d = 0; d < ndirs; d++) {
+		snprintf(path, sizeof(path), "dir%06i", d);
+		SAFE_MKDIR(path, 0755);
+
+		for (f = 0; f < nfiles; f++) {
+			snprintf(path, sizeof(path), "dir%06i/f%06i", d, f);
+			fd = SAFE_OPEN(path, O_WRONLY | O_CREAT | O_EXCL,
+				       0644);
+			SAFE_CLOSE(fd);
+		}
+	}
+
+	tst_hist_init(&hist, hist_bits);
+
+	for (i = 0; i < max_walkers; i++)
+		tst_hist_init(&walkers[i].hist, hist_bits);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	tst_hist_free(&hist);
+
+	for (i = 0; i < max_walkers; i++)
+		tst_hist_free(&walkers[i].hist);
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.options = (struct tst_option[]) {
+		{"d:", &str_ndirs, "-d N     Number of directories (default 100)"},
+		{"f:", &str_nfiles, "-f N     Files per directory (default 100)"},
+		{"w:", &str_max_walkers, "-w N     Max parallel walkers (default 4)"},
+		{"b:", &str_hist_bits, "-b bits  Histogram sub-bucket bits, sets resolution to 2^-bits (default 7)"},
+		{"o:", &result_file, "-o file  Append structured results to a file"},
+		{}
+	},
+	.min_kver = "4.11",
+	.needs_tmpdir = 1,
+	.needs_root = 1,
+};
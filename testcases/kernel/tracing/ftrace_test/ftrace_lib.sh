@@ -51,9 +51,49 @@ ftrace_test_init()
 		tst_brkm TCONF "Tracing is not supported. Skip the test..."
 	fi
 
+	snapshot_tracing_lists
+
 	save_old_setting
 }
 
+# The stress scripts re-read the available tracers/events/options lists in
+# tight loops and every read is a full scan on the kernel side. The lists
+# cannot change while the test runs, so they are snapshotted once and the
+# scripts read the snapshots instead. When runltp provides the run-scoped
+# cache directory the snapshots are shared between tests of the run.
+snapshot_tracing_lists()
+{
+	local dir
+
+	if [ -n "$LTP_CACHE_DIR" ] && [ -d "$LTP_CACHE_DIR" ]; then
+		dir="$LTP_CACHE_DIR"
+	else
+		dir=$(mktemp -d) || tst_brkm TBROK "mktemp failed"
+		snapshot_dir="$dir"
+	fi
+
+	export FTRACE_AVAILABLE_TRACERS="$dir/ftrace_available_tracers"
+	export FTRACE_AVAILABLE_EVENTS="$dir/ftrace_available_events"
+	export FTRACE_TRACE_OPTIONS="$dir/ftrace_trace_options"
+
+	[ -s "$FTRACE_AVAILABLE_TRACERS" ] || \
+		cat "$TRACING_PATH/available_tracers" \
+			> "$FTRACE_AVAILABLE_TRACERS" 2> /dev/null
+	[ -s "$FTRACE_AVAILABLE_EVENTS" ] || \
+		cat "$TRACING_PATH/available_events" \
+			> "$FTRACE_AVAILABLE_EVENTS" 2> /dev/null
+	[ -s "$FTRACE_TRACE_OPTIONS" ] || \
+		ls "$TRACING_PATH/options/" \
+			> "$FTRACE_TRACE_OPTIONS" 2> /dev/null
+}
+
+clean_up_snapshots()
+{
+	if [ -n "$snapshot_dir" ]; then
+		rm -rf "$snapshot_dir"
+	fi
+}
+
 test_interval=$1
 
 save_old_setting()
@@ -157,12 +197,14 @@ clean_up_mount()
 clean_up()
 {
 	restore_old_setting
+	clean_up_snapshots
 	clean_up_mount
 }
 
 clean_up_exit()
 {
 	restore_old_setting
+	clean_up_snapshots
 	clean_up_mount
 	exit 1
 }
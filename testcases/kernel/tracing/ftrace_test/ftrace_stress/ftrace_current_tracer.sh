@@ -15,10 +15,17 @@
 
 LOOP=200
 
+# The tracer list cannot change while the test runs, so read the snapshot
+# taken by ftrace_lib.sh instead of re-scanning the tracefs file in every
+# iteration. Keep a fallback for direct invocation.
+: ${FTRACE_AVAILABLE_TRACERS:="$TRACING_PATH"/available_tracers}
+
+tracers=`cat "$FTRACE_AVAILABLE_TRACERS"`
+
 while true; do
 	i=0
 	while [ $i -lt $LOOP ]; do
-		for tracer in `cat "$TRACING_PATH"/available_tracers`
+		for tracer in $tracers
 		do
 			if [ "$tracer" = mmiotrace ]; then
 				continue
@@ -13,6 +13,16 @@
 #                                                                             #
 ###############################################################################
 
+# The event list cannot change while the test runs, so read the snapshot
+# taken by ftrace_lib.sh instead of re-scanning the tracefs file in every
+# iteration. Keep a fallback for direct invocation.
+: ${FTRACE_AVAILABLE_EVENTS:="$TRACING_PATH"/available_events}
+
+# The ftrace event sys is special, skip it. Collapsing the list into a
+# single space separated line lets it be enabled with one write below -
+# set_event accepts a whitespace separated event list.
+events=$(grep -v "^ftrace:" "$FTRACE_AVAILABLE_EVENTS")
+
 while true; do
 	i=0
 	while [ $i -lt 100 ]; do
@@ -34,13 +44,7 @@ while true; do
 		done
 	done
 
-	for event in `cat $TRACING_PATH/available_events`; do
-		# ftrace event sys is special, skip it
-		if echo "$event" | grep "ftrace:*"; then
-			continue
-		fi
-		echo $event >> "$TRACING_PATH"/set_event
-	done
+	echo $events >> "$TRACING_PATH"/set_event
 
 	sleep 1
 done
@@ -17,15 +17,22 @@
 
 LOOP=200
 
+# The option list cannot change while the test runs, so read the snapshot
+# taken by ftrace_lib.sh instead of re-listing the options directory in
+# every iteration. Keep a fallback for direct invocation.
+if [ -n "$FTRACE_TRACE_OPTIONS" ] && [ -s "$FTRACE_TRACE_OPTIONS" ]; then
+	trace_options="$(cat $FTRACE_TRACE_OPTIONS)"
+else
+	trace_options="$(ls $TRACING_PATH/options/)"
+fi
+# enable the nop_test_refuse can cause an
+# 'write error: Invalid argument'. So don't test it.
+trace_options="$(echo $trace_options | sed 's/test_nop_refuse//')"
+nr_trace_options=$(echo "${trace_options}" | wc -w)
+
 while true; do
 	j=0
 	while [ $j -lt $LOOP ]; do
-		trace_options="$(ls $TRACING_PATH/options/)"
-		# enable the nop_test_refuse can cause an
-		# 'write error: Invalid argument'. So don't test it.
-		trace_options="$(echo $trace_options | sed 's/test_nop_refuse//')"
-		nr_trace_options=$(echo "${trace_options}" | wc -w)
-
 		option_index=$(tst_random 1 $nr_trace_options)
 		option=$(echo "$trace_options" | awk "{print \$$option_index}")
 		i=0
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Drains trace_pipe until killed. The ring buffer implements splice_read,
+ * so the records are moved page-by-page into /dev/null without copying
+ * them through userspace, which keeps up with the buffer under the stress
+ * load better than cat does. When splice() is not available the helper
+ * falls back to a plain read() loop.
+ *
+ * Usage: trace_pipe_drain /path/to/trace_pipe
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[])
+{
+	char buf[4096];
+	int trace_fd, null_fd;
+	int pipefd[2];
+	int use_splice = 1;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s /path/to/trace_pipe\n", argv[0]);
+		return 1;
+	}
+
+	trace_fd = open(argv[1], O_RDONLY);
+	if (trace_fd < 0) {
+		perror("open trace_pipe");
+		return 1;
+	}
+
+	null_fd = open("/dev/null", O_WRONLY);
+	if (null_fd < 0) {
+		perror("open /dev/null");
+		return 1;
+	}
+
+	if (pipe(pipefd)) {
+		perror("pipe");
+		return 1;
+	}
+
+	for (;;) {
+		ssize_t ret;
+
+		if (use_splice) {
+			ret = splice(trace_fd, NULL, pipefd[1], NULL,
+				     65536, SPLICE_F_MOVE);
+			if (ret < 0 && (errno == EINVAL || errno == ENOSYS)) {
+				use_splice = 0;
+				continue;
+			}
+			if (ret > 0) {
+				ret = splice(pipefd[0], NULL, null_fd, NULL,
+					     ret, SPLICE_F_MOVE);
+			}
+		} else {
+			ret = read(trace_fd, buf, sizeof(buf));
+		}
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("trace_pipe_drain");
+			return 1;
+		}
+	}
+}
@@ -7,6 +7,17 @@
 #define UEVENT_H__
 
 #include "tst_netlink.h"
+#include "tst_safe_net.h"
+
+/*
+ * Mass device churn generates thousands of uevents per second and with the
+ * default socket buffer the queue overflows before the test gets to read
+ * them, so the receive buffer is bumped and the socket is drained a batch
+ * of messages at a time.
+ */
+#define UEVENT_RCVBUF (8 * 1024 * 1024)
+#define UEVENT_BATCH 64
+#define UEVENT_MSG_LEN 4096
 
 /*
  * There are two broadcast groups defined for the NETLINK_KOBJECT_UEVENT. The
@@ -102,9 +113,81 @@ static inline int uevent_match(const char *event, int len,
 	return val_matches == uevent->value_cnt;
 }
 
+static inline unsigned int uevent_hash(const char *str)
+{
+	unsigned int hash = 5381;
+
+	while (*str)
+		hash = hash * 33 + (unsigned char)*str++;
+
+	return hash;
+}
+
+/*
+ * A compiled form of uevent_desc; the message length and the hashes of the
+ * key=value pairs are computed once, so matching a received event against
+ * it hashes each received pair and only falls back to a string compare on
+ * a hash hit instead of comparing every pair with every expected value.
+ */
+struct uevent_matcher {
+	const struct uevent_desc *desc;
+	size_t msg_len;
+	unsigned int hashes[];
+};
+
+static inline struct uevent_matcher *uevent_compile(const struct uevent_desc *uevent)
+{
+	struct uevent_matcher *m;
+	int i;
+
+	m = SAFE_MALLOC(sizeof(*m) + uevent->value_cnt * sizeof(m->hashes[0]));
+	m->desc = uevent;
+	m->msg_len = strlen(uevent->msg);
+
+	for (i = 0; i < uevent->value_cnt; i++)
+		m->hashes[i] = uevent_hash(uevent->values[i]);
+
+	return m;
+}
+
+static inline int uevent_matcher_match(const char *event, int len,
+                                       const struct uevent_matcher *m)
+{
+	int consumed = 0;
+	int val_matches = 0;
+
+	if (memcmp(event, m->desc->msg, m->msg_len))
+		return 0;
+
+	int l = strlen(event) + 1;
+
+	consumed += l;
+	event += l;
+
+	while (consumed < len) {
+		unsigned int hash = uevent_hash(event);
+		int i;
+
+		for (i = 0; i < m->desc->value_cnt; i++) {
+			if (hash == m->hashes[i] &&
+			    !strcmp(event, m->desc->values[i])) {
+				val_matches++;
+				break;
+			}
+		}
+
+		l = strlen(event) + 1;
+		consumed += l;
+		event += l;
+	}
+
+	return val_matches == m->desc->value_cnt;
+}
+
 static inline int open_uevent_netlink(void)
 {
 	int fd;
+	int rcvbuf = UEVENT_RCVBUF;
 	struct sockaddr_nl nl_addr = {
 		.nl_family = AF_NETLINK,
 		.nl_groups = MONITOR_GROUP_KERNEL,
@@ -114,31 +197,71 @@ static inline int open_uevent_netlink(void)
 
 	SAFE_BIND(fd, (struct sockaddr *)&nl_addr, sizeof(nl_addr));
 
+	/* SO_RCVBUFFORCE ignores rmem_max but needs CAP_NET_ADMIN */
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)))
+		SAFE_SETSOCKOPT_INT(fd, SOL_SOCKET, SO_RCVBUF, rcvbuf);
+
 	return fd;
 }
 
 /*
  * Reads events from uevent netlink socket until all expected events passed in
- * the uevent array are matched.
+ * the uevent array are matched. The socket is drained a batch of messages at
+ * a time with recvmmsg() and the expected events are matched in their
+ * compiled form, so the loop keeps up with storm-rate uevents.
  */
 static inline void wait_for_uevents(int fd, const struct uevent_desc *const uevents[])
 {
-	int i = 0;
+	unsigned int cnt = 0, i = 0;
+	unsigned int j;
+	struct uevent_matcher **matchers;
+	struct mmsghdr msgs[UEVENT_BATCH];
+	struct iovec iovs[UEVENT_BATCH];
+	char *bufs;
+
+	while (uevents[cnt])
+		cnt++;
+
+	matchers = SAFE_MALLOC(cnt * sizeof(*matchers));
+	for (j = 0; j < cnt; j++)
+		matchers[j] = uevent_compile(uevents[j]);
+
+	bufs = SAFE_MALLOC(UEVENT_BATCH * UEVENT_MSG_LEN);
+	memset(msgs, 0, sizeof(msgs));
+	for (j = 0; j < UEVENT_BATCH; j++) {
+		iovs[j].iov_base = bufs + j * UEVENT_MSG_LEN;
+		iovs[j].iov_len = UEVENT_MSG_LEN;
+		msgs[j].msg_hdr.msg_iov = &iovs[j];
+		msgs[j].msg_hdr.msg_iovlen = 1;
+	}
 
 	while (1) {
-		int len;
-		char buf[4096];
+		/*
+		 * Blocks for the first message only and then drains
+		 * whatever else is already queued, up to the batch size.
+		 */
+		int n = SAFE_RECVMMSG(fd, msgs, UEVENT_BATCH, MSG_WAITFORONE,
+				      NULL);
+
+		for (j = 0; j < (unsigned int)n; j++) {
+			char *event = bufs + j * UEVENT_MSG_LEN;
+			int len = msgs[j].msg_len;
 
-		len = recv(fd, &buf, sizeof(buf), 0);
+			if (!len)
+				continue;
 
-		if (len == 0)
-			continue;
+			print_uevent(event, len);
 
-		print_uevent(buf, len);
+			if (!uevent_matcher_match(event, len, matchers[i]))
+				continue;
 
-		if (uevent_match(buf, len, uevents[i])) {
 			tst_res(TPASS, "Got expected UEVENT");
-			if (!uevents[++i]) {
+
+			if (++i == cnt) {
+				for (j = 0; j < cnt; j++)
+					free(matchers[j]);
+				free(matchers);
+				free(bufs);
 				close(fd);
 				return;
 			}
@@ -520,6 +520,34 @@ tst_init_iface()
 	tst_rhost_run -c "ip link set $iface up"
 }
 
+# tst_rtnl [-s] OPERATION...
+# Apply link/addr/route operations on lhost over a single netlink socket
+# via the tst_rtnl_batch helper instead of one ip(8) exec per operation.
+# Each argument is one operation, e.g.:
+#	tst_rtnl "link set $iface up" "addr add 10.0.0.1/24 dev $iface"
+# With no arguments the operations are read from stdin, one per line
+# (see tst_rtnl_batch -h for the grammar).
+# -s: safe option, if something goes wrong, will exit with TBROK
+tst_rtnl()
+{
+	local safe=
+
+	if [ "$1" = "-s" ]; then
+		safe=1
+		shift
+	fi
+
+	if [ $# -gt 0 ]; then
+		printf '%s\n' "$@" | tst_rtnl_batch
+	else
+		tst_rtnl_batch
+	fi
+
+	local ret=$?
+	[ $ret -ne 0 -a "$safe" ] && tst_brk_ TBROK "tst_rtnl_batch failed"
+	return $ret
+}
+
 # tst_add_ipaddr [TYPE] [LINK] [-a IP] [-d] [-q] [-s]
 # Options:
 # TYPE: { lhost | rhost }, default value is 'lhost'
@@ -657,7 +685,7 @@ tst_netload()
 	fi
 
 	OPTIND=0
-	while getopts :a:H:d:n:N:r:R:S:b:t:T:fFe:m:A:D: opt; do
+	while getopts :a:H:d:n:N:r:R:S:b:t:T:fFe:m:A:D:L opt; do
 		case "$opt" in
 		a) c_num="$OPTARG" ;;
 		H) c_opts="${c_opts}-H $OPTARG "
@@ -667,6 +695,7 @@ tst_netload()
 		N) c_opts="${c_opts}-N $OPTARG " ;;
 		r) c_requests="$OPTARG" ;;
 		A) c_opts="${c_opts}-A $OPTARG " ;;
+		L) c_opts="${c_opts}-L " ;;
 		R) s_replies="$OPTARG" ;;
 		S) c_opts="${c_opts}-S $OPTARG "
 		   setup_srchost=1 ;;
@@ -0,0 +1,334 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Applies a batch of link/addr/route operations read from stdin over a
+ * single NETLINK_ROUTE socket. The shell network tests configure their
+ * topology by exec'ing ip(8) once per operation, which dominates setup
+ * time on small targets; this helper collapses any number of operations
+ * into one process and (at most a few) netlink round trips.
+ *
+ * One operation per line, '#' starts a comment:
+ *
+ *	link set DEV [up] [down] [mtu BYTES]
+ *	addr {add|del} ADDR[/PREFIX] dev DEV
+ *	route {add|del} DST/PREFIX [via GW] [dev DEV]
+ *
+ * A parse error aborts before anything is sent; a kernel-side error is
+ * reported with the failing operation's line number.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/rtnetlink.h>
+
+#define TST_NO_DEFAULT_MAIN
+#include "tst_test.h"
+#include "tst_netlink.h"
+
+extern struct tst_test *tst_test;
+
+static struct tst_test test = {
+};
+
+#define MAX_TOKENS 16
+#define MAX_PAYLOAD 512
+/* leave headroom in the 64k batch buffer, flush well before it fills */
+#define FLUSH_THRESHOLD 200
+
+static struct tst_netlink_batch *batch;
+static unsigned int queued;
+static unsigned int batch_first_line;
+
+static char payload[MAX_PAYLOAD];
+static size_t payload_len;
+
+static void add_attr(unsigned short type, const void *data,
+		     unsigned short dlen)
+{
+	struct rtattr *rta = (struct rtattr *)(payload + payload_len);
+
+	if (payload_len + RTA_ALIGN(RTA_LENGTH(dlen)) > sizeof(payload)) {
+		fprintf(stderr, "ERROR: Message payload overflow\n");
+		exit(1);
+	}
+
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(dlen);
+	memcpy(RTA_DATA(rta), data, dlen);
+	payload_len += RTA_ALIGN(rta->rta_len);
+}
+
+static void flush_batch(void)
+{
+	int ret;
+
+	if (!queued)
+		return;
+
+	ret = TST_NETLINK_BATCH_SEND(batch);
+	if (ret) {
+		fprintf(stderr,
+			"ERROR: netlink rejected an operation from lines %u on: %s\n",
+			batch_first_line, strerror(-ret));
+		exit(1);
+	}
+
+	queued = 0;
+}
+
+static void queue_msg(int fd, unsigned short type, unsigned short flags,
+		      unsigned int lineno)
+{
+	struct nlmsghdr nh = {
+		.nlmsg_len = NLMSG_LENGTH(payload_len),
+		.nlmsg_type = type,
+		.nlmsg_flags = NLM_F_REQUEST | flags,
+	};
+
+	(void)fd;
+
+	if (!queued)
+		batch_first_line = lineno;
+
+	TST_NETLINK_BATCH_ADD(batch, &nh, payload);
+
+	if (++queued >= FLUSH_THRESHOLD)
+		flush_batch();
+}
+
+static unsigned int get_ifindex(const char *dev, unsigned int lineno)
+{
+	unsigned int idx = if_nametoindex(dev);
+
+	if (!idx) {
+		fprintf(stderr, "ERROR: line %u: no such device '%s'\n",
+			lineno, dev);
+		exit(1);
+	}
+
+	return idx;
+}
+
+/*
+ * Parse ADDR[/PREFIX], filling the binary address and returning the
+ * prefix length (defaulting to the full address width).
+ */
+static int parse_addr(char *arg, int *family, unsigned char *buf,
+		      unsigned int lineno)
+{
+	char *slash = strchr(arg, '/');
+	int prefix = -1;
+
+	if (slash) {
+		*slash = '\0';
+		prefix = atoi(slash + 1);
+	}
+
+	*family = strchr(arg, ':') ? AF_INET6 : AF_INET;
+
+	if (inet_pton(*family, arg, buf) != 1) {
+		fprintf(stderr, "ERROR: line %u: bad address '%s'\n",
+			lineno, arg);
+		exit(1);
+	}
+
+	if (prefix < 0)
+		prefix = (*family == AF_INET6) ? 128 : 32;
+
+	return prefix;
+}
+
+static void parse_error(unsigned int lineno, const char *op)
+{
+	fprintf(stderr, "ERROR: line %u: malformed '%s' operation\n",
+		lineno, op);
+	exit(1);
+}
+
+static void do_link(int fd, char **tok, int ntok, unsigned int lineno)
+{
+	struct ifinfomsg ifi = { .ifi_family = AF_UNSPEC };
+	int i;
+
+	if (ntok < 4 || strcmp(tok[1], "set"))
+		parse_error(lineno, "link");
+
+	ifi.ifi_index = get_ifindex(tok[2], lineno);
+
+	payload_len = NLMSG_ALIGN(sizeof(ifi));
+
+	for (i = 3; i < ntok; i++) {
+		if (!strcmp(tok[i], "up")) {
+			ifi.ifi_flags |= IFF_UP;
+			ifi.ifi_change |= IFF_UP;
+		} else if (!strcmp(tok[i], "down")) {
+			ifi.ifi_flags &= ~IFF_UP;
+			ifi.ifi_change |= IFF_UP;
+		} else if (!strcmp(tok[i], "mtu") && i + 1 < ntok) {
+			uint32_t mtu = atoi(tok[++i]);
+
+			add_attr(IFLA_MTU, &mtu, sizeof(mtu));
+		} else {
+			parse_error(lineno, "link");
+		}
+	}
+
+	memcpy(payload, &ifi, sizeof(ifi));
+	queue_msg(fd, RTM_NEWLINK, 0, lineno);
+}
+
+static void do_addr(int fd, char **tok, int ntok, unsigned int lineno)
+{
+	struct ifaddrmsg ifa = {};
+	unsigned char addr[16];
+	unsigned short type, flags = 0;
+	int family, addr_len;
+
+	if (ntok != 5 || strcmp(tok[3], "dev"))
+		parse_error(lineno, "addr");
+
+	if (!strcmp(tok[1], "add")) {
+		type = RTM_NEWADDR;
+		flags = NLM_F_CREATE | NLM_F_EXCL;
+	} else if (!strcmp(tok[1], "del")) {
+		type = RTM_DELADDR;
+	} else {
+		parse_error(lineno, "addr");
+		return;
+	}
+
+	ifa.ifa_prefixlen = parse_addr(tok[2], &family, addr, lineno);
+	ifa.ifa_family = family;
+	ifa.ifa_index = get_ifindex(tok[4], lineno);
+	addr_len = (family == AF_INET6) ? 16 : 4;
+
+	payload_len = NLMSG_ALIGN(sizeof(ifa));
+	add_attr(IFA_LOCAL, addr, addr_len);
+	add_attr(IFA_ADDRESS, addr, addr_len);
+
+	memcpy(payload, &ifa, sizeof(ifa));
+	queue_msg(fd, type, flags, lineno);
+}
+
+static void do_route(int fd, char **tok, int ntok, unsigned int lineno)
+{
+	struct rtmsg rtm = { .rtm_table = RT_TABLE_MAIN };
+	unsigned char addr[16];
+	unsigned short type, flags = 0;
+	int i, family, addr_len;
+
+	if (ntok < 3)
+		parse_error(lineno, "route");
+
+	if (!strcmp(tok[1], "add")) {
+		type = RTM_NEWROUTE;
+		flags = NLM_F_CREATE | NLM_F_EXCL;
+		rtm.rtm_protocol = RTPROT_BOOT;
+		rtm.rtm_scope = RT_SCOPE_UNIVERSE;
+		rtm.rtm_type = RTN_UNICAST;
+	} else if (!strcmp(tok[1], "del")) {
+		type = RTM_DELROUTE;
+		rtm.rtm_scope = RT_SCOPE_NOWHERE;
+	} else {
+		parse_error(lineno, "route");
+		return;
+	}
+
+	rtm.rtm_dst_len = parse_addr(tok[2], &family, addr, lineno);
+	rtm.rtm_family = family;
+	addr_len = (family == AF_INET6) ? 16 : 4;
+
+	payload_len = NLMSG_ALIGN(sizeof(rtm));
+	add_attr(RTA_DST, addr, addr_len);
+
+	for (i = 3; i < ntok; i++) {
+		if (!strcmp(tok[i], "via") && i + 1 < ntok) {
+			unsigned char gw[16];
+			int gw_family;
+
+			parse_addr(tok[++i], &gw_family, gw, lineno);
+			if (gw_family != family)
+				parse_error(lineno, "route");
+			add_attr(RTA_GATEWAY, gw, addr_len);
+		} else if (!strcmp(tok[i], "dev") && i + 1 < ntok) {
+			uint32_t oif = get_ifindex(tok[++i], lineno);
+
+			add_attr(RTA_OIF, &oif, sizeof(oif));
+		} else {
+			parse_error(lineno, "route");
+		}
+	}
+
+	memcpy(payload, &rtm, sizeof(rtm));
+	queue_msg(fd, type, flags, lineno);
+}
+
+static void print_help(void)
+{
+	fprintf(stderr, "\nUsage: tst_rtnl_batch < operations\n\n");
+	fprintf(stderr, "One operation per line, '#' starts a comment:\n");
+	fprintf(stderr, "  link set DEV [up] [down] [mtu BYTES]\n");
+	fprintf(stderr, "  addr {add|del} ADDR[/PREFIX] dev DEV\n");
+	fprintf(stderr, "  route {add|del} DST/PREFIX [via GW] [dev DEV]\n\n");
+	fprintf(stderr,
+		"All operations are applied over one netlink socket.\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+	char line[512];
+	char *tok[MAX_TOKENS];
+	unsigned int lineno = 0;
+	int fd, ntok;
+
+	/* messages from the new library go to stderr */
+	tst_test = &test;
+
+	if (argc > 1) {
+		print_help();
+		return strcmp(argv[1], "-h") ? 1 : 0;
+	}
+
+	fd = SAFE_SOCKET(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+	batch = TST_NETLINK_BATCH_START(fd);
+
+	while (fgets(line, sizeof(line), stdin)) {
+		char *cp = strchr(line, '#');
+
+		lineno++;
+		if (cp)
+			*cp = '\0';
+
+		ntok = 0;
+		cp = strtok(line, " \t\n");
+		while (cp && ntok < MAX_TOKENS) {
+			tok[ntok++] = cp;
+			cp = strtok(NULL, " \t\n");
+		}
+
+		if (!ntok)
+			continue;
+
+		if (!strcmp(tok[0], "link"))
+			do_link(fd, tok, ntok, lineno);
+		else if (!strcmp(tok[0], "addr"))
+			do_addr(fd, tok, ntok, lineno);
+		else if (!strcmp(tok[0], "route"))
+			do_route(fd, tok, ntok, lineno);
+		else
+			parse_error(lineno, tok[0]);
+	}
+
+	flush_batch();
+	TST_NETLINK_BATCH_FREE(batch);
+	SAFE_CLOSE(fd);
+
+	return 0;
+}
@@ -48,6 +48,13 @@ _tst_do_exit()
 		[ "$TST_TMPDIR_RHOST" = 1 ] && tst_cleanup_rhost
 	fi
 
+	# Remove the IPC file only if we created it in tst_run(); it may
+	# also be inherited from a C test driving this script, which still
+	# needs it for its other children.
+	if [ "$TST_NEEDS_CHECKPOINTS" = 1 -a -f "$LTP_IPC_PATH" ]; then
+		rm -f "$LTP_IPC_PATH"
+	fi
+
 	if [ -n "$_tst_setup_timer_pid" ]; then
 		kill $_tst_setup_timer_pid 2>/dev/null
 		wait $_tst_setup_timer_pid 2>/dev/null
@@ -492,6 +499,21 @@ tst_require_module()
 	tst_res TINFO "Found module at '$TST_MODPATH'"
 }
 
+TST_CHECKPOINT_WAIT()
+{
+	ROD tst_checkpoint wait 10000 "$1"
+}
+
+TST_CHECKPOINT_WAKE()
+{
+	ROD tst_checkpoint wake 10000 "$1" 1
+}
+
+TST_CHECKPOINT_WAKE2()
+{
+	ROD tst_checkpoint wake 10000 "$1" "$2"
+}
+
 tst_run()
 {
 	local _tst_i
@@ -507,6 +529,7 @@ tst_run()
 			OPTS|USAGE|PARSE_ARGS|POS_ARGS);;
 			NEEDS_ROOT|NEEDS_TMPDIR|TMPDIR|NEEDS_DEVICE|DEVICE);;
 			NEEDS_CMDS|NEEDS_MODULE|MODPATH|DATAROOT);;
+			NEEDS_CHECKPOINTS);;
 			NEEDS_DRIVERS|FS_TYPE|MNTPOINT|MNT_PARAMS);;
 			IPV6|IPVER|TEST_DATA|TEST_DATA_IFS);;
 			RETRY_FUNC|RETRY_FN_EXP_BACKOFF|TIMEOUT);;
@@ -585,6 +608,19 @@ tst_run()
 
 	[ -n "$TST_NEEDS_MODULE" ] && tst_require_module "$TST_NEEDS_MODULE"
 
+	if [ "$TST_NEEDS_CHECKPOINTS" = 1 ]; then
+		LTP_IPC_PATH="/dev/shm/ltp_${TST_ID}_$$"
+
+		LTP_IPC_SIZE=$(tst_getconf PAGESIZE)
+		if [ $? -ne 0 ]; then
+			tst_brk TBROK "tst_getconf PAGESIZE failed"
+		fi
+
+		ROD_SILENT dd if=/dev/zero of="$LTP_IPC_PATH" bs="$LTP_IPC_SIZE" count=1
+		ROD_SILENT chmod 600 "$LTP_IPC_PATH"
+		export LTP_IPC_PATH
+	fi
+
 	if [ -n "$TST_SETUP" ]; then
 		if type $TST_SETUP >/dev/null 2>/dev/null; then
 			TST_DO_CLEANUP=1
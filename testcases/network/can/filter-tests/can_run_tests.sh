@@ -88,7 +88,7 @@ cleanup()
 }
 
 if [ $# -ne 1 ]; then
-	tst_brkm TBROK "Usage: $0 [can_filter | can_rcv_own_msgs]"
+	tst_brkm TBROK "Usage: $0 [can_filter | can_rcv_own_msgs | can_bulk]"
 fi
 
 setup
@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Bulk multicast group membership test.
+ *
+ * Joins a configurable number of IPv4 multicast groups spread over many
+ * sockets, verifies the kernel's per-interface group count through
+ * /proc/net/igmp, then leaves all groups and verifies the count drops
+ * back to the baseline. The join/leave rate can be capped with -r to
+ * model a gradual IGMP ramp instead of a burst.
+ *
+ * The existing mc_member.sh joins one group per setsockopt with sleeps
+ * in between, which cannot reach the thousands-of-groups scale where
+ * IGMP processing has historically misbehaved; this test makes group
+ * count and ramp rate measurable axes.
+ */
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tst_test.h"
+#include "tst_safe_net.h"
+#include "tst_clocks.h"
+#include "tst_timer.h"
+
+/* 239.16.0.1 upwards, inside the organization-local scope */
+#define GROUP_BASE 0xef100001
+#define MAX_GROUPS (1 << 20)
+
+#define IGMP_PROC "/proc/net/igmp"
+#define MAX_MEMBERSHIPS_SYSCTL "/proc/sys/net/ipv4/igmp_max_memberships"
+
+static char *str_groups;
+static char *str_sockets;
+static char *str_rate;
+static char *dev = "lo";
+
+static int groups = 2000;
+static int sockets;
+static int rate;
+
+static unsigned int ifindex;
+static int *socks;
+static int proc_fd = -1;
+static int baseline;
+
+/*
+ * Returns the kernel's group count for our interface, parsed from the
+ * device line of /proc/net/igmp ("IDX\tNAME : COUNT QUERIER"). The fd
+ * is opened once in setup; each call just rewinds and rereads it.
+ */
+static int count_igmp_groups(void)
+{
+	static char *buf;
+	static size_t buf_size = 16384;
+	size_t used = 0;
+	ssize_t ret;
+	char *line, *colon;
+	int idx, cnt;
+
+	if (!buf)
+		buf = SAFE_MALLOC(buf_size);
+
+	SAFE_LSEEK(proc_fd, 0, SEEK_SET);
+
+	for (;;) {
+		if (used + 4096 > buf_size) {
+			buf_size *= 2;
+			buf = realloc(buf, buf_size);
+			if (!buf)
+				tst_brk(TBROK, "realloc(%zu) failed", buf_size);
+		}
+
+		ret = SAFE_READ(0, proc_fd, buf + used, buf_size - used - 1);
+		if (!ret)
+			break;
+		used += ret;
+	}
+	buf[used] = '\0';
+
+	for (line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+		/* group lines are indented, device lines start with the index */
+		if (sscanf(line, "%d", &idx) != 1 || idx != (int)ifindex)
+			continue;
+
+		colon = strchr(line, ':');
+		if (colon && sscanf(colon + 1, "%d", &cnt) == 1)
+			return cnt;
+	}
+
+	return -1;
+}
+
+static void ramp_wait(struct timespec *start, int done)
+{
+	struct timespec now;
+	long long target_us, elapsed_us;
+
+	if (!rate)
+		return;
+
+	target_us = (long long)done * 1000000 / rate;
+	tst_clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed_us = tst_timespec_diff_us(now, *start);
+
+	if (target_us > elapsed_us)
+		usleep(target_us - elapsed_us);
+}
+
+static void do_memberships(int op)
+{
+	struct ip_mreqn mr = { .imr_ifindex = ifindex };
+	struct timespec start, now;
+	double elapsed;
+	int i;
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < groups; i++) {
+		mr.imr_multiaddr.s_addr = htonl(GROUP_BASE + i);
+		SAFE_SETSOCKOPT(socks[i % sockets], IPPROTO_IP, op,
+				&mr, sizeof(mr));
+		ramp_wait(&start, i + 1);
+	}
+
+	tst_clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = tst_timespec_diff_us(now, start) / 1000000.0;
+
+	tst_res(TINFO, "%s %d groups across %d sockets in %.3fs (%.0f ops/s)",
+		op == IP_ADD_MEMBERSHIP ? "joined" : "left",
+		groups, sockets, elapsed,
+		elapsed > 0 ? groups / elapsed : 0);
+}
+
+static void verify_count(const char *what, int expected)
+{
+	int cnt = count_igmp_groups();
+
+	if (cnt < 0)
+		tst_brk(TBROK, "'%s' disappeared from " IGMP_PROC, dev);
+
+	if (cnt - baseline == expected)
+		tst_res(TPASS, "%s: %s has %d extra groups", what, dev,
+			cnt - baseline);
+	else
+		tst_res(TFAIL, "%s: %s has %d extra groups, expected %d",
+			what, dev, cnt - baseline, expected);
+}
+
+static void run(void)
+{
+	do_memberships(IP_ADD_MEMBERSHIP);
+	verify_count("after bulk join", groups);
+
+	do_memberships(IP_DROP_MEMBERSHIP);
+	verify_count("after bulk leave", 0);
+}
+
+static void setup(void)
+{
+	int i, per_socket, max_memberships;
+
+	if (tst_parse_int(str_groups, &groups, 1, MAX_GROUPS))
+		tst_brk(TBROK, "Invalid group count '%s'", str_groups);
+
+	if (tst_parse_int(str_sockets, &sockets, 1, groups))
+		tst_brk(TBROK, "Invalid socket count '%s'", str_sockets);
+
+	if (tst_parse_int(str_rate, &rate, 0, INT_MAX))
+		tst_brk(TBROK, "Invalid ramp rate '%s'", str_rate);
+
+	ifindex = if_nametoindex(dev);
+	if (!ifindex)
+		tst_brk(TCONF, "Interface '%s' not found", dev);
+
+	SAFE_FILE_SCANF(MAX_MEMBERSHIPS_SYSCTL, "%d", &max_memberships);
+
+	if (!sockets)
+		sockets = (groups + max_memberships - 1) / max_memberships;
+
+	/*
+	 * The per-socket membership limit applies on join; raise it when
+	 * the requested distribution would exceed it (restored by the
+	 * library on exit).
+	 */
+	per_socket = (groups + sockets - 1) / sockets;
+	if (per_socket > max_memberships) {
+		tst_res(TINFO, "raising igmp_max_memberships %d -> %d",
+			max_memberships, per_socket);
+		SAFE_FILE_PRINTF(MAX_MEMBERSHIPS_SYSCTL, "%d", per_socket);
+	}
+
+	socks = SAFE_MALLOC(sockets * sizeof(int));
+	for (i = 0; i < sockets; i++)
+		socks[i] = SAFE_SOCKET(AF_INET, SOCK_DGRAM, 0);
+
+	proc_fd = SAFE_OPEN(IGMP_PROC, O_RDONLY);
+	baseline = count_igmp_groups();
+	if (baseline < 0)
+		tst_brk(TCONF, "'%s' has no IGMP state in " IGMP_PROC, dev);
+
+	tst_res(TINFO, "%d groups over %d sockets on %s, baseline %d groups",
+		groups, sockets, dev, baseline);
+}
+
+static void cleanup(void)
+{
+	int i;
+
+	if (proc_fd >= 0)
+		SAFE_CLOSE(proc_fd);
+
+	if (socks) {
+		for (i = 0; i < sockets; i++) {
+			if (socks[i] > 0)
+				SAFE_CLOSE(socks[i]);
+		}
+		free(socks);
+	}
+}
+
+static struct tst_test test = {
+	.test_all = run,
+	.setup = setup,
+	.cleanup = cleanup,
+	.needs_root = 1,
+	.options = (struct tst_option[]) {
+		{"n:", &str_groups, "Number of multicast groups (default 2000)"},
+		{"c:", &str_sockets, "Number of sockets to spread groups over"},
+		{"r:", &str_rate, "Join/leave rate limit per second (default unlimited)"},
+		{"d:", &dev, "Interface to join on (default lo)"},
+		{NULL, NULL, NULL},
+	},
+	.save_restore = (const char * const[]) {
+		MAX_MEMBERSHIPS_SYSCTL,
+		NULL,
+	},
+};
@@ -14,7 +14,9 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <poll.h>
+#include <sys/epoll.h>
 #include <time.h>
 #include <string.h>
 #include <unistd.h>
@@ -22,14 +24,17 @@
 
 #include "lapi/udp.h"
 #include "lapi/dccp.h"
+#include "lapi/sctp.h"
 #include "lapi/netinet_in.h"
 #include "lapi/posix_clocks.h"
 #include "lapi/socket.h"
 #include "lapi/tcp.h"
 #include "tst_safe_stdio.h"
 #include "tst_safe_pthread.h"
+#include "tst_clocks.h"
 #include "tst_test.h"
 #include "tst_safe_net.h"
+#include "lapi/io_uring.h"
 
 #if !defined(HAVE_RAND_R)
 static int rand_r(LTP_ATTRIBUTE_UNUSED unsigned int *seed)
@@ -115,7 +120,30 @@ static char *port_path = "netstress_port";
 static char *log_path = "netstress.log";
 
 static char *narg, *Narg, *qarg, *rarg, *Rarg, *aarg, *Targ, *barg, *targ,
-	    *Aarg;
+	    *Aarg, *earg, *sarg;
+
+/* number of epoll workers for the server, 0 keeps thread-per-connection */
+static int epoll_workers;
+
+/*
+ * SCTP stream spraying (-s): each association is opened with the given
+ * number of output streams and the client requests are sprayed across
+ * them round-robin via a SCTP_SNDRCV cmsg, so many-stream load gets
+ * generated instead of everything going down stream 0. Per-stream
+ * message counts are reported when the clients are done.
+ */
+static int sctp_streams;
+static unsigned int *sctp_stream_txcnt;
+static __thread unsigned int sctp_stream_next;
+
+/*
+ * Latency mode (-L): each steady-state request/response round trip is
+ * timestamped and the percentiles are reported when the clients finish,
+ * so busy-poll and co. can be compared on latency instead of total run
+ * time. With -d the p99 (in usec) is stored instead of the total time.
+ */
+static char *lat_mode;
+static long long *lat_samples;
 
 /* common structure for TCP/UDP server and TCP/UDP client */
 struct net_func {
@@ -145,6 +173,207 @@ struct sock_info {
 static char *zcopy;
 static int send_flags = MSG_NOSIGNAL;
 static char *reuse_port;
+static char *uring_mode;
+
+/*
+ * io_uring transport for the TCP client (-U): the request send and the
+ * reply recv are queued as linked SQEs and submitted with a single
+ * io_uring_enter() that also waits for the completions, so one
+ * request/reply round trip costs one syscall instead of the
+ * send+poll+recv triple. Each client thread owns a private ring.
+ *
+ * Plain IORING_OP_SEND is used; the fixed (registered) buffer variants
+ * in this kernel API only exist for file reads/writes, not sockets,
+ * and zero-copy socket sends are already covered by -z (SO_ZEROCOPY).
+ */
+#define URING_ENTRIES 4
+#define URING_DATA_SEND 1
+#define URING_DATA_RECV 2
+
+struct netstress_uring {
+	int fd;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	struct io_uring_sqe *sqes;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+	unsigned int to_submit;
+};
+
+static __thread struct netstress_uring uring;
+
+static void uring_init(void)
+{
+	struct io_uring_params p;
+	void *sq, *cq;
+
+	memset(&p, 0, sizeof(p));
+
+	uring.fd = io_uring_setup(URING_ENTRIES, &p);
+	if (uring.fd == -1)
+		tst_brk(TBROK | TERRNO, "io_uring_setup() failed");
+
+	sq = SAFE_MMAP(0, p.sq_off.array + p.sq_entries * sizeof(unsigned int),
+		       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		       uring.fd, IORING_OFF_SQ_RING);
+
+	uring.sq_tail = sq + p.sq_off.tail;
+	uring.sq_mask = sq + p.sq_off.ring_mask;
+	uring.sq_array = sq + p.sq_off.array;
+
+	uring.sqes = SAFE_MMAP(0, p.sq_entries * sizeof(struct io_uring_sqe),
+			       PROT_READ | PROT_WRITE,
+			       MAP_SHARED | MAP_POPULATE,
+			       uring.fd, IORING_OFF_SQES);
+
+	cq = SAFE_MMAP(0, p.cq_off.cqes + p.cq_entries *
+		       sizeof(struct io_uring_cqe),
+		       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		       uring.fd, IORING_OFF_CQ_RING);
+
+	uring.cq_head = cq + p.cq_off.head;
+	uring.cq_tail = cq + p.cq_off.tail;
+	uring.cq_mask = cq + p.cq_off.ring_mask;
+	uring.cqes = cq + p.cq_off.cqes;
+}
+
+static struct io_uring_sqe *uring_get_sqe(void)
+{
+	unsigned int tail = *uring.sq_tail;
+	unsigned int idx = tail & *uring.sq_mask;
+	struct io_uring_sqe *sqe = &uring.sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	uring.sq_array[idx] = idx;
+	__atomic_store_n(uring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+	uring.to_submit++;
+
+	return sqe;
+}
+
+static void uring_queue_send(int fd, const char *buf, int len)
+{
+	struct io_uring_sqe *sqe = uring_get_sqe();
+
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)buf;
+	sqe->len = len;
+	sqe->msg_flags = send_flags;
+	/* completes before the queued recv is started */
+	sqe->flags = IOSQE_IO_LINK;
+	sqe->user_data = URING_DATA_SEND;
+}
+
+static int uring_recv_wait(char *buf, int size, int fd)
+{
+	struct io_uring_sqe *sqe = uring_get_sqe();
+	struct io_uring_cqe *cqe;
+	unsigned int head;
+	int ret, len = -1, got_recv = 0;
+
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)buf;
+	sqe->len = size;
+	sqe->user_data = URING_DATA_RECV;
+
+	while (!got_recv) {
+		head = *uring.cq_head;
+
+		if (head == __atomic_load_n(uring.cq_tail,
+					    __ATOMIC_ACQUIRE)) {
+			ret = io_uring_enter(uring.fd, uring.to_submit, 1,
+					     IORING_ENTER_GETEVENTS, NULL);
+			if (ret == -1) {
+				if (errno == EINTR)
+					continue;
+				tst_brk(TBROK | TERRNO,
+					"io_uring_enter() failed");
+			}
+			uring.to_submit -= ret;
+			continue;
+		}
+
+		cqe = &uring.cqes[head & *uring.cq_mask];
+
+		switch (cqe->user_data) {
+		case URING_DATA_SEND:
+			if (cqe->res < 0) {
+				tst_brk(TBROK, "io_uring send failed: %s",
+					tst_strerrno(-cqe->res));
+			}
+			break;
+		case URING_DATA_RECV:
+			got_recv = 1;
+			if (cqe->res < 0) {
+				errno = -cqe->res;
+			} else {
+				len = cqe->res;
+				if (!len)
+					errno = ESHUTDOWN;
+			}
+			break;
+		}
+
+		__atomic_store_n(uring.cq_head, head + 1, __ATOMIC_RELEASE);
+	}
+
+	return len;
+}
+
+static long long lat_now(void)
+{
+	struct timespec ts;
+
+	tst_clock_gettime_fast(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int lat_cmp(const void *a, const void *b)
+{
+	long long va = *(const long long *)a, vb = *(const long long *)b;
+
+	return (va > vb) - (va < vb);
+}
+
+static void sctp_send_stream(int fd, const char *buf, int len)
+{
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	struct sctp_sndrcvinfo *sinfo;
+	union {
+		char buf[CMSG_SPACE(sizeof(struct sctp_sndrcvinfo))];
+		struct cmsghdr align;
+	} cbuf;
+	unsigned int stream = sctp_stream_next++ % sctp_streams;
+
+	iov.iov_base = (void *)buf;
+	iov.iov_len = len;
+
+	memset(&mh, 0, sizeof(mh));
+	memset(&cbuf, 0, sizeof(cbuf));
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	mh.msg_control = cbuf.buf;
+	mh.msg_controllen = sizeof(cbuf.buf);
+
+	cmsg = CMSG_FIRSTHDR(&mh);
+	cmsg->cmsg_level = IPPROTO_SCTP;
+	cmsg->cmsg_type = SCTP_SNDRCV;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(*sinfo));
+	sinfo = (struct sctp_sndrcvinfo *)CMSG_DATA(cmsg);
+	sinfo->sinfo_stream = stream;
+
+	SAFE_SENDMSG(len, fd, &mh, send_flags);
+
+	__atomic_fetch_add(&sctp_stream_txcnt[stream], 1, __ATOMIC_RELAXED);
+}
 
 static void init_socket_opts(int sd)
 {
@@ -178,6 +407,17 @@ static void init_socket_opts(int sd)
 		SAFE_SETSOCKOPT_INT(sd, SOL_UDPLITE, UDPLITE_SEND_CSCOV, cscov);
 		SAFE_SETSOCKOPT_INT(sd, SOL_UDPLITE, UDPLITE_RECV_CSCOV, 8);
 	} break;
+	case TYPE_SCTP:
+		if (sctp_streams) {
+			struct sctp_initmsg im;
+
+			memset(&im, 0, sizeof(im));
+			im.sinit_num_ostreams = sctp_streams;
+			im.sinit_max_instreams = sctp_streams;
+			SAFE_SETSOCKOPT(sd, IPPROTO_SCTP, SCTP_INITMSG,
+					&im, sizeof(im));
+		}
+	break;
 	}
 }
 
@@ -202,6 +442,10 @@ TST_DECLARE_ONCE_FN(cleanup, do_cleanup)
 static int sock_recv_poll(char *buf, int size, struct sock_info *i)
 {
 	struct pollfd pfd;
+
+	if (uring_mode && client_mode)
+		return uring_recv_wait(buf, size, i->fd);
+
 	pfd.fd = i->fd;
 	pfd.events = POLLIN;
 	int len = -1;
@@ -342,7 +586,16 @@ static int client_connect_send(const char *msg, int size)
 		/* old TCP API */
 		SAFE_CONNECT(cfd, remote_addrinfo->ai_addr,
 			     remote_addrinfo->ai_addrlen);
-		SAFE_SEND(1, cfd, msg, size, send_flags);
+		/*
+		 * The final server termination message is sent by the main
+		 * thread which has no ring, it takes the send() path.
+		 */
+		if (sctp_streams)
+			sctp_send_stream(cfd, msg, size);
+		else if (uring_mode && uring.sqes)
+			uring_queue_send(cfd, msg, size);
+		else
+			SAFE_SEND(1, cfd, msg, size, send_flags);
 	}
 	return cfd;
 }
@@ -380,6 +633,7 @@ void *client_fn(void *id)
 	char client_msg[max_msg_len];
 	int i = 0;
 	intptr_t err = 0;
+	long long t0 = 0;
 	unsigned int seed = init_seed ^ (intptr_t)id;
 
 	inf.raddr_len = sizeof(inf.raddr);
@@ -387,6 +641,9 @@ void *client_fn(void *id)
 	inf.timeout = wait_timeout;
 	inf.pmtu_err_cnt = 0;
 
+	if (uring_mode)
+		uring_init();
+
 	make_client_request(client_msg, &cln_len, &srv_len, &seed);
 
 	/* connect & send requests */
@@ -419,12 +676,25 @@ void *client_fn(void *id)
 		if (max_rand_msg_len)
 			make_client_request(client_msg, &cln_len, &srv_len, &seed);
 
-		SAFE_SEND(1, inf.fd, client_msg, cln_len, send_flags);
+		if (lat_mode)
+			t0 = lat_now();
+
+		if (sctp_streams)
+			sctp_send_stream(inf.fd, client_msg, cln_len);
+		else if (uring_mode)
+			uring_queue_send(inf.fd, client_msg, cln_len);
+		else
+			SAFE_SEND(1, inf.fd, client_msg, cln_len, send_flags);
 
 		if (client_recv(buf, srv_len, &inf)) {
 			err = errno;
 			break;
 		}
+
+		if (lat_mode) {
+			lat_samples[(intptr_t)id * client_max_requests + i] =
+				lat_now() - t0;
+		}
 	}
 
 	if (inf.fd != -1)
@@ -461,6 +731,14 @@ static void client_init(void)
 
 	thread_ids = SAFE_MALLOC(sizeof(pthread_t) * clients_num);
 
+	if (lat_mode) {
+		size_t lat_len = (size_t)clients_num * client_max_requests;
+
+		lat_samples = SAFE_MALLOC(lat_len * sizeof(*lat_samples));
+		/* sets every sample to -1, skipped requests stay invalid */
+		memset(lat_samples, 0xff, lat_len * sizeof(*lat_samples));
+	}
+
 	struct addrinfo hints;
 	memset(&hints, 0, sizeof(struct addrinfo));
 	hints.ai_family = AF_UNSPEC;
@@ -487,6 +765,7 @@ static void client_run(void)
 {
 	void *res = NULL;
 	long clnt_time = 0;
+	long long lat_p99 = 0;
 	int i;
 	for (i = 0; i < clients_num; ++i) {
 		pthread_join(thread_ids[i], &res);
@@ -502,6 +781,42 @@ static void client_run(void)
 
 	tst_res(TINFO, "total time '%ld' ms", clnt_time);
 
+	if (lat_mode) {
+		size_t lat_len = (size_t)clients_num * client_max_requests;
+		size_t n = 0, s;
+		long long sum = 0;
+
+		for (s = 0; s < lat_len; s++) {
+			if (lat_samples[s] < 0)
+				continue;
+			lat_samples[n++] = lat_samples[s];
+			sum += lat_samples[s];
+		}
+
+		if (!n)
+			tst_brk(TBROK, "no latency samples collected");
+
+		qsort(lat_samples, n, sizeof(*lat_samples), lat_cmp);
+		lat_p99 = lat_samples[n * 99 / 100] / 1000;
+
+		tst_res(TINFO,
+			"latency over %zu samples (usec): min %lli avg %lli p50 %lli p90 %lli p99 %lli max %lli",
+			n, lat_samples[0] / 1000, sum / n / 1000,
+			lat_samples[n / 2] / 1000,
+			lat_samples[n * 90 / 100] / 1000, lat_p99,
+			lat_samples[n - 1] / 1000);
+	}
+
+	if (sctp_streams) {
+		unsigned int s;
+
+		for (s = 0; s < (unsigned int)sctp_streams; s++) {
+			tst_res(TINFO, "stream %u: %u msgs (%.1f msg/sec)", s,
+				sctp_stream_txcnt[s], clnt_time ?
+				1000.0 * sctp_stream_txcnt[s] / clnt_time : 0);
+		}
+	}
+
 	char client_msg[min_msg_len];
 	int msg_len = min_msg_len;
 
@@ -515,8 +830,12 @@ static void client_run(void)
 		SAFE_CLOSE(cfd);
 	}
 	/* the script tcp_fastopen_run.sh will remove it */
-	if (rpath)
-		SAFE_FILE_PRINTF(rpath, "%ld", clnt_time);
+	if (rpath) {
+		if (lat_mode)
+			SAFE_FILE_PRINTF(rpath, "%lli", lat_p99);
+		else
+			SAFE_FILE_PRINTF(rpath, "%ld", clnt_time);
+	}
 
 	tst_res(TPASS, "test completed");
 }
@@ -765,6 +1084,200 @@ static void server_run(void)
 	}
 }
 
+/*
+ * Epoll engine for the stream server (-e): instead of one thread per
+ * accepted connection a small pool of workers multiplexes them, each
+ * worker owning a private edge-triggered epoll set so there is no
+ * shared wait queue to contend on. Connections are sharded round-robin
+ * over the workers by the accepting thread. This is what makes
+ * connection-scaling scenarios measure the network stack rather than
+ * the scheduler.
+ */
+struct epoll_conn {
+	int fd;
+	int offset;
+	int num_requests;
+	char *recv_msg;
+};
+
+static void epoll_send_full(int fd, const char *buf, int size)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+	int sent = 0, len;
+
+	while (sent < size) {
+		len = send(fd, buf + sent, size - sent,
+			   send_flags | MSG_DONTWAIT);
+
+		if (len == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				poll(&pfd, 1, wait_timeout);
+				continue;
+			}
+			tst_brk(TBROK | TERRNO, "send() failed");
+		}
+
+		sent += len;
+	}
+}
+
+static void epoll_conn_close(int epfd, struct epoll_conn *conn)
+{
+	epoll_ctl(epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+	SAFE_CLOSE(conn->fd);
+	free(conn->recv_msg);
+	free(conn);
+}
+
+static void server_epoll_handle(int epfd, struct epoll_conn *conn,
+				char *send_msg)
+{
+	int recv_len, send_msg_len;
+
+	/* edge-triggered, drain until EAGAIN */
+	while (1) {
+		recv_len = recv(conn->fd, conn->recv_msg + conn->offset,
+				max_msg_len - conn->offset, MSG_DONTWAIT);
+
+		if (recv_len == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return;
+		}
+
+		if (recv_len == 0) {
+			epoll_conn_close(epfd, conn);
+			return;
+		}
+
+		if (recv_len < 0 || (conn->offset + recv_len) > max_msg_len ||
+		   (conn->recv_msg[0] != start_byte &&
+		    conn->recv_msg[0] != start_fin_byte)) {
+			tst_res(TFAIL, "recv failed, sock '%d'", conn->fd);
+			goto out;
+		}
+
+		conn->offset += recv_len;
+
+		if (conn->recv_msg[conn->offset - 1] != end_byte)
+			continue;
+
+		/* client asks to terminate */
+		if (conn->recv_msg[0] == start_fin_byte)
+			goto out;
+
+		send_msg_len = parse_client_request(conn->recv_msg);
+		if (send_msg_len < 0) {
+			tst_res(TFAIL, "wrong msg size '%d'", send_msg_len);
+			goto out;
+		}
+		make_server_reply(send_msg, send_msg_len);
+
+		conn->offset = 0;
+
+		/*
+		 * It will tell client that server is going
+		 * to close this connection.
+		 */
+		if (++conn->num_requests >= server_max_requests)
+			send_msg[0] = start_fin_byte;
+
+		epoll_send_full(conn->fd, send_msg, send_msg_len);
+
+		if (conn->num_requests >= server_max_requests) {
+			shutdown(conn->fd, SHUT_WR);
+			epoll_conn_close(epfd, conn);
+			return;
+		}
+	}
+
+out:
+	SAFE_CLOSE(conn->fd);
+	tst_brk(TBROK, "Server closed");
+}
+
+#define EPOLL_BATCH 64
+
+static void *server_epoll_worker(void *arg)
+{
+	int epfd = (intptr_t)arg;
+	struct epoll_event events[EPOLL_BATCH];
+	char send_msg[max_msg_len];
+	int i, nfds;
+
+	while (1) {
+		nfds = epoll_wait(epfd, events, EPOLL_BATCH, -1);
+
+		if (nfds == -1) {
+			if (errno == EINTR)
+				continue;
+			tst_brk(TBROK | TERRNO, "epoll_wait() failed");
+		}
+
+		for (i = 0; i < nfds; ++i)
+			server_epoll_handle(epfd, events[i].data.ptr, send_msg);
+	}
+
+	return NULL;
+}
+
+static void server_run_epoll(void)
+{
+	struct sockaddr_in6 addr6;
+	socklen_t addr_size = sizeof(addr6);
+	int *epfds;
+	pthread_t id;
+	intptr_t i;
+	int next_worker = 0;
+
+	if (server_bg)
+		move_to_background();
+
+	epfds = SAFE_MALLOC(sizeof(int) * epoll_workers);
+
+	for (i = 0; i < epoll_workers; ++i) {
+		epfds[i] = epoll_create1(0);
+		if (epfds[i] == -1)
+			tst_brk(TBROK | TERRNO, "epoll_create1() failed");
+
+		SAFE_PTHREAD_CREATE(&id, &attr, server_epoll_worker,
+				    (void *)(intptr_t)epfds[i]);
+	}
+
+	tst_res(TINFO, "epoll engine with %d workers", epoll_workers);
+
+	while (1) {
+		struct epoll_conn *conn;
+		struct epoll_event ev;
+		int client_fd = accept(sfd, (struct sockaddr *)&addr6,
+			&addr_size);
+
+		if (client_fd == -1)
+			tst_brk(TBROK, "Can't create client socket");
+
+		init_socket_opts(client_fd);
+		SAFE_FCNTL(client_fd, F_SETFL, O_NONBLOCK);
+
+		conn = SAFE_MALLOC(sizeof(*conn));
+		conn->fd = client_fd;
+		conn->offset = 0;
+		conn->num_requests = 0;
+		conn->recv_msg = SAFE_MALLOC(max_msg_len);
+
+		ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+		ev.data.ptr = conn;
+
+		if (epoll_ctl(epfds[next_worker], EPOLL_CTL_ADD,
+			      client_fd, &ev))
+			tst_brk(TBROK | TERRNO, "epoll_ctl(EPOLL_CTL_ADD) failed");
+
+		next_worker = (next_worker + 1) % epoll_workers;
+	}
+}
+
 static void require_root(const char *file)
 {
 	if (!geteuid())
@@ -863,6 +1376,10 @@ static void setup(void)
 		tst_brk(TBROK, "Invalid net.ipv4.tcp_fastopen '%s'", targ);
 	if (tst_parse_int(Aarg, &max_rand_msg_len, 10, max_msg_len))
 		tst_brk(TBROK, "Invalid max random payload size '%s'", Aarg);
+	if (tst_parse_int(earg, &epoll_workers, 1, 512))
+		tst_brk(TBROK, "Invalid number of epoll workers '%s'", earg);
+	if (tst_parse_int(sarg, &sctp_streams, 1, UINT16_MAX))
+		tst_brk(TBROK, "Invalid number of SCTP streams '%s'", sarg);
 
 	if (!server_addr)
 		server_addr = "localhost";
@@ -926,17 +1443,46 @@ static void setup(void)
 		case TYPE_TCP:
 		case TYPE_DCCP:
 		case TYPE_SCTP:
-			net.run		= server_run;
+			net.run		= epoll_workers ?
+					  server_run_epoll : server_run;
 			net.cleanup	= server_cleanup;
 		break;
 		case TYPE_UDP:
 		case TYPE_UDP_LITE:
+			if (epoll_workers)
+				tst_brk(TCONF, "-e applies to stream server only");
 			net.run		= server_run_udp;
 			net.cleanup	= NULL;
 		break;
 		}
 	}
 
+	if (epoll_workers && client_mode)
+		tst_brk(TCONF, "-e applies to stream server only");
+
+	if (uring_mode) {
+		if (!client_mode || proto_type != TYPE_TCP)
+			tst_brk(TCONF, "-U supports TCP client mode only");
+		if (fastopen_api || fastopen_sapi || zcopy)
+			tst_brk(TCONF, "-U cannot be combined with -f/-F/-z");
+		tst_res(TINFO, "io_uring transport");
+	}
+
+	if (lat_mode && !client_mode)
+		tst_brk(TCONF, "-L applies to client mode only");
+
+	if (sctp_streams) {
+		if (proto_type != TYPE_SCTP)
+			tst_brk(TCONF, "-s applies to SCTP only");
+		if (client_mode) {
+			sctp_stream_txcnt = SAFE_MALLOC(sctp_streams *
+					sizeof(*sctp_stream_txcnt));
+			memset(sctp_stream_txcnt, 0, sctp_streams *
+			       sizeof(*sctp_stream_txcnt));
+		}
+		tst_res(TINFO, "spraying over %d SCTP streams", sctp_streams);
+	}
+
 	if (zcopy)
 		send_flags |= MSG_ZEROCOPY;
 
@@ -1005,6 +1551,7 @@ static struct tst_test test = {
 		{"g:", &tcp_port, "-g x     x - server port"},
 		{"b:", &barg, "-b x     x - low latency busy poll timeout"},
 		{"T:", &type, "-T x     tcp (default), udp, udp_lite, dccp, sctp"},
+		{"s:", &sarg, "-s x     x - SCTP output streams, spray requests across them"},
 		{"z", &zcopy, "-z       enable SO_ZEROCOPY"},
 		{"P:", &reuse_port, "-P       enable SO_REUSEPORT"},
 		{"D:", &dev, "-D x     bind to device x\n"},
@@ -1017,9 +1564,12 @@ static struct tst_test test = {
 		{"N:", &Narg, "-N x     Server message size"},
 		{"m:", &Targ, "-m x     Receive timeout in milliseconds (not used by UDP/DCCP client)"},
 		{"d:", &rpath, "-d x     x is a path to file where result is saved"},
+		{"U", &uring_mode, "-U       Use io_uring transport (TCP client)"},
+		{"L", &lat_mode, "-L       Report request/response latency percentiles, -d file gets p99 (usec)"},
 		{"A:", &Aarg, "-A x     x max payload length (generated randomly)\n"},
 
 		{"R:", &Rarg, "Server:\n-R x     x requests after which conn.closed"},
+		{"e:", &earg, "-e x     x - epoll workers num, multiplex connections instead of thread per connection"},
 		{"q:", &qarg, "-q x     x - TFO queue"},
 		{"B:", &server_bg, "-B x     run in background, x - process directory"},
 		{}
@@ -7,11 +7,13 @@ VERSION=${VERSION:=3}
 NFILES=${NFILES:=1000}
 SOCKET_TYPE="${SOCKET_TYPE:-udp}"
 NFS_TYPE=${NFS_TYPE:=nfs}
+NFS_WORKERS=${NFS_WORKERS:=1}
 
 nfs_usage()
 {
 	echo "-t x    Socket type, tcp or udp, default is udp"
 	echo "-v x    NFS version, default is '3'"
+	echo "-w x    Number of parallel client workers, default is 1"
 }
 
 nfs_parse_args()
@@ -19,10 +21,12 @@ nfs_parse_args()
 	case "$1" in
 	v) VERSION="$(echo $2 | tr ',' ' ')";;
 	t) SOCKET_TYPE="$(echo $2 | tr ',' ' ')";;
+	w) NFS_WORKERS="$2";;
 	esac
 }
 
-TST_OPTS="v:t:"
+TST_OPTS="v:t:w:"
+TST_NEEDS_CHECKPOINTS=1
 TST_PARSE_ARGS=nfs_parse_args
 TST_USAGE=nfs_usage
 TST_NEEDS_TMPDIR=1
@@ -140,6 +144,44 @@ nfs_setup()
 	fi
 }
 
+# Runs "$@" in NFS_WORKERS concurrent client processes, each in its own
+# subdirectory of the NFS mount. The workers block on a checkpoint until all
+# of them are spawned, so the file operations hit the server at the same
+# time, which is what reproduces metadata contention seen with real
+# multi-client load. With NFS_WORKERS=1 (the default) the command runs
+# directly as before.
+nfs_run_workers()
+{
+	local i pid pids ret=0
+
+	if [ "$NFS_WORKERS" -le 1 ]; then
+		ROD "$@"
+		return
+	fi
+
+	tst_res TINFO "running '$*' in $NFS_WORKERS parallel workers"
+
+	for i in $(seq $NFS_WORKERS); do
+		(
+			mkdir -p worker$i
+			cd worker$i
+			tst_checkpoint wait 10000 0 || exit 1
+			"$@"
+		) &
+		pids="$pids $!"
+	done
+
+	ROD tst_checkpoint wake 10000 0 $NFS_WORKERS
+
+	for pid in $pids; do
+		wait $pid || ret=1
+	done
+
+	if [ $ret -ne 0 ]; then
+		tst_brk TFAIL "one or more workers failed"
+	fi
+}
+
 nfs_cleanup()
 {
 	tst_res TINFO "Cleaning up testcase"
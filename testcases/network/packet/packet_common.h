@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright (c) 2021 Linux Test Project
+ */
+
+/*
+ * Shared TPACKET_V3 mmap ring helpers for the AF_PACKET tests.
+ *
+ * The classic one-frame-per-syscall send/recv path cannot generate
+ * enough packet rate to exercise the ring reaping paths in the kernel,
+ * so the high-rate tests move frames through mmaped rings instead: the
+ * receive side reaps whole blocks, the transmit side fills frame slots
+ * and flushes them with a single send() kick.
+ */
+
+#ifndef PACKET_COMMON_H__
+#define PACKET_COMMON_H__
+
+#include <net/if.h>
+#include <net/ethernet.h>
+#include <linux/if_packet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#include "tst_test.h"
+
+struct packet_ring {
+	int fd;
+	char *map;
+	struct tpacket_req3 req;
+	/* rx: next block to reap, tx: next frame slot to fill */
+	unsigned int next;
+};
+
+/*
+ * Creates an AF_PACKET socket with a TPACKET_V3 ring of the given
+ * geometry attached and binds it to the interface. The type is either
+ * PACKET_RX_RING or PACKET_TX_RING; tx rings need kernel 4.11+.
+ */
+static inline void packet_ring_create(struct packet_ring *ring, int type,
+				      int ifindex, unsigned int block_size,
+				      unsigned int block_nr,
+				      unsigned int frame_size)
+{
+	struct sockaddr_ll addr = { 0 };
+
+	ring->fd = SAFE_SOCKET(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+
+	SAFE_SETSOCKOPT_INT(ring->fd, SOL_PACKET, PACKET_VERSION, TPACKET_V3);
+
+	memset(&ring->req, 0, sizeof(ring->req));
+	ring->req.tp_block_size = block_size;
+	ring->req.tp_block_nr = block_nr;
+	ring->req.tp_frame_size = frame_size;
+	ring->req.tp_frame_nr = block_size / frame_size * block_nr;
+	/* tx rings reject the rx-only fields with EINVAL */
+	if (type == PACKET_RX_RING) {
+		/* retire unfilled blocks after 10ms */
+		ring->req.tp_retire_blk_tov = 10;
+	}
+
+	SAFE_SETSOCKOPT(ring->fd, SOL_PACKET, type, &ring->req,
+			sizeof(ring->req));
+
+	ring->map = SAFE_MMAP(NULL, (size_t)block_size * block_nr,
+			      PROT_READ | PROT_WRITE, MAP_SHARED,
+			      ring->fd, 0);
+
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons(ETH_P_ALL);
+	addr.sll_ifindex = ifindex;
+	SAFE_BIND(ring->fd, (struct sockaddr *)&addr, sizeof(addr));
+
+	ring->next = 0;
+}
+
+static inline void packet_ring_destroy(struct packet_ring *ring)
+{
+	SAFE_MUNMAP(ring->map,
+		    (size_t)ring->req.tp_block_size * ring->req.tp_block_nr);
+	SAFE_CLOSE(ring->fd);
+}
+
+typedef void (*packet_frame_fn)(struct tpacket3_hdr *frame);
+
+/*
+ * Reaps one rx block if the kernel has retired it: calls fn for each
+ * frame in the block, hands the block back and returns the number of
+ * frames processed. Returns 0 when no block is ready.
+ */
+static inline unsigned int packet_ring_rx_reap(struct packet_ring *ring,
+					       packet_frame_fn fn)
+{
+	struct tpacket_block_desc *desc = (struct tpacket_block_desc *)
+		(ring->map + (size_t)ring->next * ring->req.tp_block_size);
+	struct tpacket3_hdr *frame;
+	unsigned int i, num_pkts;
+
+	if (!(__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE)
+	      & TP_STATUS_USER))
+		return 0;
+
+	num_pkts = desc->hdr.bh1.num_pkts;
+	frame = (struct tpacket3_hdr *)
+		((char *)desc + desc->hdr.bh1.offset_to_first_pkt);
+
+	for (i = 0; i < num_pkts; i++) {
+		fn(frame);
+		frame = (struct tpacket3_hdr *)
+			((char *)frame + frame->tp_next_offset);
+	}
+
+	__atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL,
+			 __ATOMIC_RELEASE);
+
+	ring->next = (ring->next + 1) % ring->req.tp_block_nr;
+
+	return num_pkts;
+}
+
+/*
+ * Returns the sockaddr_ll the kernel stored behind the frame header,
+ * e.g. to filter PACKET_OUTGOING duplicates on looped interfaces.
+ */
+static inline struct sockaddr_ll *packet_frame_sll(struct tpacket3_hdr *frame)
+{
+	return (struct sockaddr_ll *)
+		((char *)frame + TPACKET_ALIGN(sizeof(*frame)));
+}
+
+/*
+ * Fills the next free tx frame slot with the given frame and marks it
+ * for sending. Returns 0 on success and -1 when the ring is full,
+ * in which case the caller should kick the ring and retry.
+ */
+static inline int packet_ring_tx_frame(struct packet_ring *ring,
+				       const void *data, unsigned int len)
+{
+	struct tpacket3_hdr *hdr = (struct tpacket3_hdr *)
+		(ring->map + (size_t)ring->next * ring->req.tp_frame_size);
+
+	if (__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE)
+	    & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING))
+		return -1;
+
+	memcpy((char *)hdr + TPACKET3_HDRLEN - sizeof(struct sockaddr_ll),
+	       data, len);
+	hdr->tp_len = len;
+
+	__atomic_store_n(&hdr->tp_status, TP_STATUS_SEND_REQUEST,
+			 __ATOMIC_RELEASE);
+
+	ring->next = (ring->next + 1) % ring->req.tp_frame_nr;
+
+	return 0;
+}
+
+/*
+ * Flushes all frames marked TP_STATUS_SEND_REQUEST with one syscall.
+ */
+static inline void packet_ring_tx_kick(struct packet_ring *ring)
+{
+	while (send(ring->fd, NULL, 0, 0) == -1) {
+		if (errno == EINTR)
+			continue;
+		if (errno == ENOBUFS) {
+			usleep(100);
+			continue;
+		}
+		tst_brk(TBROK | TERRNO, "tx ring send() failed");
+	}
+}
+
+#endif /* PACKET_COMMON_H__ */
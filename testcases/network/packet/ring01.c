@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2021 Linux Test Project
+ *
+ * High-rate AF_PACKET test built on the TPACKET_V3 mmap rings.
+ *
+ * Blasts a burst of raw UDP frames over loopback from a PACKET_TX_RING
+ * and reaps them block-wise from a PACKET_RX_RING, then checks that no
+ * frame was lost on the way. The per-syscall send/recv tests cannot
+ * reach packet rates where the ring reaping paths matter, this one
+ * moves a whole ring worth of frames per syscall.
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <linux/if_ether.h>
+
+#include "tst_test.h"
+#include "tst_timer.h"
+#include "lapi/namespaces_constants.h"
+#include "packet_common.h"
+
+#define BLOCK_SIZE (1 << 16)
+#define BLOCK_NR 64
+#define FRAME_SIZE 2048
+#define NFRAMES 100000
+#define FRAME_LEN 64
+
+static struct packet_ring rx_ring;
+static struct packet_ring tx_ring;
+static int lo_index;
+static unsigned int received;
+
+static void setup(void)
+{
+	int real_uid = getuid();
+	int real_gid = getgid();
+	struct ifreq ifr;
+	int sock;
+
+	TEST(unshare(CLONE_NEWUSER));
+	if (TST_RET)
+		tst_brk(TBROK | TTERRNO, "Can't create new user namespace");
+
+	TEST(unshare(CLONE_NEWNET));
+	if (TST_RET)
+		tst_brk(TBROK | TTERRNO, "Can't create new net namespace");
+
+	FILE_PRINTF("/proc/self/setgroups", "deny");
+	FILE_PRINTF("/proc/self/uid_map", "0 %d 1\n", real_uid);
+	FILE_PRINTF("/proc/self/gid_map", "0 %d 1\n", real_gid);
+
+	sock = SAFE_SOCKET(AF_PACKET, SOCK_RAW, PF_PACKET);
+
+	memset(&ifr, 0, sizeof(ifr));
+	strcpy(ifr.ifr_name, "lo");
+	SAFE_IOCTL(sock, SIOCGIFINDEX, &ifr);
+	lo_index = ifr.ifr_ifindex;
+
+	SAFE_IOCTL(sock, SIOCGIFFLAGS, &ifr);
+	ifr.ifr_flags |= (short)IFF_UP;
+	SAFE_IOCTL(sock, SIOCSIFFLAGS, &ifr);
+
+	SAFE_CLOSE(sock);
+
+	tst_timer_check(CLOCK_MONOTONIC);
+}
+
+static void count_frame(struct tpacket3_hdr *frame)
+{
+	/* each looped frame is also captured as PACKET_OUTGOING, skip those */
+	if (packet_frame_sll(frame)->sll_pkttype != PACKET_OUTGOING)
+		received++;
+}
+
+static void build_frame(char *frame)
+{
+	struct ethhdr *eth = (struct ethhdr *)frame;
+	struct iphdr *ip = (struct iphdr *)(eth + 1);
+	struct udphdr *udp = (struct udphdr *)(ip + 1);
+
+	memset(frame, 0, FRAME_LEN);
+
+	eth->h_proto = htons(ETH_P_IP);
+
+	ip->version = 4;
+	ip->ihl = 5;
+	ip->tot_len = htons(FRAME_LEN - sizeof(*eth));
+	ip->ttl = 64;
+	ip->protocol = IPPROTO_UDP;
+	ip->saddr = htonl(INADDR_LOOPBACK);
+	ip->daddr = htonl(INADDR_LOOPBACK);
+
+	udp->source = htons(9);
+	udp->dest = htons(9);
+	udp->len = htons(FRAME_LEN - sizeof(*eth) - sizeof(*ip));
+}
+
+static void run(void)
+{
+	char frame[FRAME_LEN];
+	unsigned int sent = 0;
+	long long elapsed_ms;
+	int retries = 1000;
+
+	packet_ring_create(&rx_ring, PACKET_RX_RING, lo_index,
+			   BLOCK_SIZE, BLOCK_NR, FRAME_SIZE);
+	packet_ring_create(&tx_ring, PACKET_TX_RING, lo_index,
+			   BLOCK_SIZE, BLOCK_NR, FRAME_SIZE);
+
+	build_frame(frame);
+	received = 0;
+
+	tst_timer_start(CLOCK_MONOTONIC);
+
+	while (sent < NFRAMES) {
+		while (sent < NFRAMES &&
+		       !packet_ring_tx_frame(&tx_ring, frame, FRAME_LEN))
+			sent++;
+
+		packet_ring_tx_kick(&tx_ring);
+
+		while (packet_ring_rx_reap(&rx_ring, count_frame))
+			;
+	}
+
+	while (received < NFRAMES && retries--) {
+		if (!packet_ring_rx_reap(&rx_ring, count_frame))
+			usleep(1000);
+	}
+
+	tst_timer_stop();
+	elapsed_ms = tst_timer_elapsed_ms();
+
+	tst_res(TINFO, "%u frames in %llims (%lli frames/s)", sent, elapsed_ms,
+		elapsed_ms ? sent * 1000LL / elapsed_ms : 0);
+
+	if (received >= NFRAMES)
+		tst_res(TPASS, "Received all %u looped frames", received);
+	else
+		tst_res(TFAIL, "Received %u out of %u looped frames",
+			received, NFRAMES);
+
+	packet_ring_destroy(&tx_ring);
+	packet_ring_destroy(&rx_ring);
+}
+
+static struct tst_test test = {
+	/* TPACKET_V3 tx rings were added in 4.11 */
+	.min_kver = "4.11",
+	.setup = setup,
+	.test_all = run,
+	.needs_root = 1,
+};
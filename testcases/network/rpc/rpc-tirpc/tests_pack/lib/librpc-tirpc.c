@@ -19,9 +19,13 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/ip.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <rpc/rpc.h>
+
+#include "librpc-tirpc.h"
 
 int bound_socket(int domain, int type)
 {
@@ -67,3 +71,61 @@ int bound_socket(int domain, int type)
 
 	return sock;
 }
+
+static CLIENT *cached_clnt;
+static char cached_key[256];
+
+CLIENT *rpc_client_get(const char *host, unsigned long prognum,
+		       unsigned long versnum, const char *proto)
+{
+	char key[sizeof(cached_key)];
+
+	snprintf(key, sizeof(key), "%s/%lu/%lu/%s",
+		 host, prognum, versnum, proto);
+
+	if (cached_clnt) {
+		if (!strcmp(key, cached_key))
+			return cached_clnt;
+
+		clnt_destroy(cached_clnt);
+		cached_clnt = NULL;
+	}
+
+	cached_clnt = clnt_create(host, prognum, versnum, proto);
+	if (cached_clnt)
+		strcpy(cached_key, key);
+
+	return cached_clnt;
+}
+
+void rpc_client_put(void)
+{
+	if (cached_clnt) {
+		clnt_destroy(cached_clnt);
+		cached_clnt = NULL;
+	}
+}
+
+enum clnt_stat rpc_pipeline_call(CLIENT *clnt, unsigned long procnum,
+				 xdrproc_t xargs, void *argsp)
+{
+	struct timeval to = { 0, 0 };
+	enum clnt_stat cs;
+
+	cs = clnt_call(clnt, procnum, xargs, argsp,
+		       (xdrproc_t)xdr_void, NULL, to);
+
+	/* the zero timeout queues the call without waiting for its reply */
+	if (cs == RPC_TIMEDOUT)
+		return RPC_SUCCESS;
+
+	return cs;
+}
+
+enum clnt_stat rpc_pipeline_flush(CLIENT *clnt, unsigned long procnum,
+				  xdrproc_t xargs, void *argsp,
+				  xdrproc_t xres, void *resp,
+				  struct timeval timeout)
+{
+	return clnt_call(clnt, procnum, xargs, argsp, xres, resp, timeout);
+}
@@ -19,6 +19,8 @@
 #ifndef __LIBRPC_TIRPC_H__
 #define __LIBRPC_TIRPC_H__
 
+#include <rpc/rpc.h>
+
 /*
  * Returns a network socket bound to an arbitrary port.
  * domain - AF_INET or AF_INET6,
@@ -27,4 +29,36 @@
  */
 int bound_socket(int domain, int type);
 
+/*
+ * Returns a persistent client handle for the given server. The handle is
+ * cached, so repeated calls with the same parameters reuse one connection
+ * and portmapper lookup instead of paying for both on every RPC call.
+ * Returns NULL if the handle could not be created.
+ */
+CLIENT *rpc_client_get(const char *host, unsigned long prognum,
+		       unsigned long versnum, const char *proto);
+
+/*
+ * Destroys the cached client handle, if any.
+ */
+void rpc_client_put(void);
+
+/*
+ * Queues an RPC call without waiting for its reply, so many calls can be
+ * outstanding on one (TCP) client handle at once. Returns RPC_SUCCESS when
+ * the call was queued. The replies stay pending until the next synchronous
+ * call on the handle, see rpc_pipeline_flush().
+ */
+enum clnt_stat rpc_pipeline_call(CLIENT *clnt, unsigned long procnum,
+				 xdrproc_t xargs, void *argsp);
+
+/*
+ * Performs a synchronous call which forces all queued calls out and
+ * matches the outstanding replies by xid, discarding all but its own.
+ */
+enum clnt_stat rpc_pipeline_flush(CLIENT *clnt, unsigned long procnum,
+				  xdrproc_t xargs, void *argsp,
+				  xdrproc_t xres, void *resp,
+				  struct timeval timeout);
+
 #endif /* __LIBRPC_TIRPC_H__ */
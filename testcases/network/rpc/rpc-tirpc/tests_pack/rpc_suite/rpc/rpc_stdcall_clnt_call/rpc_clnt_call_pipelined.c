@@ -0,0 +1,116 @@
+/*
+* Copyright (c) 2021 Linux Test Project
+*
+* This program is free software; you can redistribute it and/or modify it
+* under the terms of version 2 of the GNU General Public License as
+* published by the Free Software Foundation.
+*
+* This program is distributed in the hope that it would be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*
+* Concurrent-RPC variant of the clnt_call tests: instead of one fresh
+* connection and one synchronous round trip per call, a persistent TCP
+* client handle from the test library is reused and the calls are
+* pipelined - queued without waiting for the replies, then flushed with
+* one final synchronous call whose reply matching drains the backlog.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <rpc/rpc.h>
+
+#include "librpc-tirpc.h"
+
+//Standard define
+#define PROCNUM 1
+#define VERSNUM 1
+
+int main(int argn, char *argc[])
+{
+	//Program parameters : argc[1] : HostName or Host IP
+	//                                         argc[2] : Server Program Number
+	//                                         argc[3] : Number of pipelined calls
+	//                                         other arguments depend on test case
+
+	//run_mode can switch into stand alone program or program launch by shell script
+	//1 : stand alone, debug mode, more screen information
+	//0 : launch by shell script as test case, only one printf -> result status
+	int run_mode = 0;
+	int test_status = 1;	//Default test result set to FAILED
+	int i;
+	int maxIter;
+	struct timeval tv1, tv2;
+	struct timezone tz;
+	long long diff;
+	int progNum = atoi(argc[2]);
+	CLIENT *clnt = NULL;
+	enum clnt_stat cs;
+	struct timeval to;
+	int varSnd = 10;
+	int varRec = -1;
+
+	//Test initialisation
+	maxIter = (argn > 3) ? atoi(argc[3]) : 100;
+	to.tv_sec = 10;
+	to.tv_usec = 0;
+
+	clnt = rpc_client_get(argc[1], progNum, VERSNUM, "tcp");
+	if (clnt == NULL) {
+		clnt_pcreateerror("err");
+		printf("5\n");
+		return 5;
+	}
+
+	//The cached handle must be returned for repeated lookups
+	if (rpc_client_get(argc[1], progNum, VERSNUM, "tcp") != clnt) {
+		printf("1\n");
+		return 1;
+	}
+
+	gettimeofday(&tv1, &tz);
+
+	//Queue all calls but the last without waiting for replies
+	for (i = 0; i < maxIter - 1; i++) {
+		cs = rpc_pipeline_call(clnt, PROCNUM,
+				       (xdrproc_t) xdr_int, (char *)&varSnd);
+
+		if (cs != RPC_SUCCESS) {
+			clnt_perrno(cs);
+			printf("1\n");
+			return 1;
+		}
+	}
+
+	//The flush call drains the pipeline and matches its own reply
+	cs = rpc_pipeline_flush(clnt, PROCNUM,
+				(xdrproc_t) xdr_int, (char *)&varSnd,
+				(xdrproc_t) xdr_int, (char *)&varRec, to);
+
+	gettimeofday(&tv2, &tz);
+
+	if (cs == RPC_SUCCESS && varRec == varSnd)
+		test_status = 0;
+	else
+		clnt_perrno(cs);
+
+	if (run_mode) {
+		diff = (tv2.tv_sec - tv1.tv_sec) * 1000000L +
+		    (tv2.tv_usec - tv1.tv_usec);
+		fprintf(stderr, "%d pipelined calls in %lld usec\n",
+			maxIter, diff);
+	}
+
+	rpc_client_put();
+
+	//This last printf gives the result status to the tests suite
+	//normally should be 0: test has passed or 1: test has failed
+	printf("%d\n", test_status);
+
+	return test_status;
+}
@@ -10,23 +10,101 @@
 
 LOGFILE=${LOGFILE:=logfile}
 
+# Number of tests to run concurrently. The default of 1 keeps the
+# historic strictly serial execution; tests marked with a <name>.serial
+# file next to their <name>.args always run alone after the parallel
+# ones have finished, for the few tests that cannot share global
+# resources like named IPC objects.
+MAX_PARALLEL=${MAX_PARALLEL:-1}
+
 NUM_FAIL=0
 NUM_PASS=0
 NUM_TESTS=0
 
-run_test_loop() {
+count_result() {
+
+	if [ "$1" = "0" ]; then
+		NUM_PASS=$(expr $NUM_PASS + 1)
+	else
+		NUM_FAIL=$(expr $NUM_FAIL + 1)
+	fi
+	NUM_TESTS=$(expr $NUM_TESTS + 1)
+
+}
+
+# Runs one test in the background with a private TMPDIR, keeping its
+# output, log fragment and exit code under $JOB_DIR until the batch is
+# collected in submission order.
+run_test_job() {
+
+	(
+		TMPDIR=$(mktemp -d) || exit 2
+		export TMPDIR
+		LOGFILE="$JOB_DIR/$2.log"
+		: > "$LOGFILE"
+		run_test "$1" > "$JOB_DIR/$2.out" 2>&1
+		echo $? > "$JOB_DIR/$2.ret"
+		rm -rf "$TMPDIR"
+	) &
+
+}
+
+run_test_loop_parallel() {
+
+	JOB_DIR=$(mktemp -d) || exit 2
+	serial_tests=
+	njobs=0
 
 	for t in $*; do
 
-		if run_test "$t"; then
-			NUM_PASS=$(expr $NUM_PASS + 1)
-		else
-			NUM_FAIL=$(expr $NUM_FAIL + 1)
+		if [ -f "$(echo "$t" | sed 's,\.[^\.]*,,').serial" ]; then
+			serial_tests="$serial_tests $t"
+			continue
 		fi
-		NUM_TESTS=$(expr $NUM_TESTS + 1)
 
+		run_test_job "$t" $njobs
+		njobs=$(expr $njobs + 1)
+
+		if [ $(expr $njobs % $MAX_PARALLEL) -eq 0 ]; then
+			wait
+		fi
+
+	done
+
+	wait
+
+	job=0
+	while [ $job -lt $njobs ]; do
+		cat "$JOB_DIR/$job.out"
+		cat "$JOB_DIR/$job.log" >> "$LOGFILE"
+		count_result "$(cat "$JOB_DIR/$job.ret")"
+		job=$(expr $job + 1)
+	done
+
+	rm -rf "$JOB_DIR"
+
+	for t in $serial_tests; do
+		run_test "$t"
+		count_result $?
 	done
 
+}
+
+run_test_loop() {
+
+	if [ "$MAX_PARALLEL" -gt 1 ]; then
+		run_test_loop_parallel $*
+	else
+
+		for t in $*; do
+
+			run_test "$t"
+			count_result $?
+
+		done
+
+	fi
+
 	cat <<EOF
 *******************
 Testing $(basename $PWD)
@@ -28,8 +28,10 @@
  *      - The time the worker thread starts running is noted. Each of the
  *	  worker threads then waits on the same _condvar_. The time it
  *	  wakes up also noted.
- *      - Once all the threads finish execution, the start and wakeup times
- *	of all the threads is displayed.
+ *      - The wakeup cycle is repeated for a number of iterations and the
+ *	  wake chain latencies are collected across all of them.
+ *      - Once all the threads finish execution, the wakeup order of every
+ *	  iteration is checked and the latency statistics are displayed.
  *      - The output must indicate that the thread wakeup happened in a
  *	  priority order.
  *
@@ -56,20 +58,49 @@
 #include <librttest.h>
 #include <libstats.h>
 
+#define DEF_ITERATIONS 100
+
 volatile int running_threads = 0;
 static int rt_threads = 0;
 static int locked_broadcast = 1;
+static int iterations = DEF_ITERATIONS;
 static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t mutex;
 static volatile nsec_t beginrun;
 
 static int ret = 0;
 
+/* current wakeup round, advanced by the master under the mutex so the
+ * workers can tell a broadcast from a spurious wakeup */
+static volatile int round_num = 0;
+/* workers woken up in the current round */
+static volatile int woken = 0;
+/* rt_gettime() just before the broadcast of the current round */
+static volatile nsec_t bcast_time;
+/* rt_gettime() of the most recent wakeup in the current round, used to
+ * time the mutex handoff from one woken worker to the next */
+static nsec_t last_wake;
+
+/* The boost and dequeue steps of the wake chain happen inside the
+ * kernel; the edges visible from here are the broadcast, the return
+ * from pthread_cond_wait() (the worker is running with the mutex held)
+ * and the gap between consecutive returns (the PI mutex handoff). */
+static stats_container_t wake_lat;	/* broadcast to cond_wait return, us */
+static stats_container_t handoff_lat;	/* previous worker wake to ours, us */
+
+struct array {
+	int *arr;
+	int counter;
+};
+struct array wakeup = { NULL, 0 };
+
 void usage(void)
 {
 	rt_help();
 	printf("prio-wake specific options:\n");
 	printf("  -n#	   #: number of worker threads\n");
+	printf("  -i#	   #: number of wakeup iterations, defaults to %d\n",
+	       DEF_ITERATIONS);
 	printf("  -l#	   1:lock the mutex before broadcast, 0:don't\n");
 	printf("		defaults to 1\n");
 }
@@ -85,6 +116,9 @@ int parse_args(int c, char *v)
 	case 'n':
 		rt_threads = atoi(v);
 		break;
+	case 'i':
+		iterations = atoi(v);
+		break;
 	case 'l':
 		locked_broadcast = atoi(v);
 		break;
@@ -95,34 +129,57 @@ int parse_args(int c, char *v)
 	return handled;
 }
 
-struct array {
-	int *arr;
-	int counter;
-};
-struct array wakeup = { NULL, 0 };
+/* Check and reset the wakeup order of the round that just completed.
+ * Called by the master while every worker is blocked for the next
+ * round, so no locking is needed. */
+static void check_wakeup_order(int iter)
+{
+	int i;
+
+	for (i = 0; i < (wakeup.counter - 1); i++) {
+		if (wakeup.arr[i] < wakeup.arr[i + 1]) {
+			printf("FAIL: iteration %d: thread %d woken before %d\n",
+			       iter, wakeup.arr[i], wakeup.arr[i + 1]);
+			ret++;
+		}
+	}
+	wakeup.counter = 0;
+	woken = 0;
+}
 
 void *master_thread(void *arg)
 {
 	int rc;
 	nsec_t start;
-
-	/* make sure children are started */
-	while (running_threads < rt_threads)
+	int iter;
+
+	for (iter = 0; iter < iterations; iter++) {
+		/* make sure children are started */
+		while (running_threads < rt_threads)
+			usleep(1000);
+		/* give the worker threads a chance to get to sleep in the
+		 * kernel in the unlocked broadcast case. */
 		usleep(1000);
-	/* give the worker threads a chance to get to sleep in the kernel
-	 * in the unlocked broadcast case. */
-	usleep(1000);
-
-	start = rt_gettime() - beginrun;
 
-	printf("%08lld us: Master thread about to wake the workers\n",
-	       start / NS_PER_US);
-	/* start the children threads */
-	if (locked_broadcast)
-		rc = pthread_mutex_lock(&mutex);
-	rc = pthread_cond_broadcast(&cond);
-	if (locked_broadcast)
-		rc = pthread_mutex_unlock(&mutex);
+		start = rt_gettime() - beginrun;
+
+		if (iter == 0)
+			printf("%08lld us: Master thread about to wake the workers\n",
+			       start / NS_PER_US);
+		/* start the children threads */
+		if (locked_broadcast)
+			rc = pthread_mutex_lock(&mutex);
+		round_num++;
+		bcast_time = rt_gettime();
+		rc = pthread_cond_broadcast(&cond);
+		if (locked_broadcast)
+			rc = pthread_mutex_unlock(&mutex);
+
+		/* wait for the entire chain to run before scoring it */
+		while (woken < rt_threads)
+			usleep(1000);
+		check_wakeup_order(iter);
+	}
 
 	return NULL;
 }
@@ -134,7 +191,10 @@ void *worker_thread(void *arg)
 	int rc;
 	int mypri;
 	int j;
+	int myround = 0;
+	int iter;
 	nsec_t start, wake;
+	stats_record_t rec;
 	j = (intptr_t) arg;
 
 	if (pthread_getschedparam(pthread_self(), &policy, &sched_param) != 0) {
@@ -149,21 +209,63 @@ void *worker_thread(void *arg)
 	debug(0, "%08lld us: RealtimeThread-%03d pri %03d started\n",
 	      start / NS_PER_US, j, mypri);
 
-	rc = pthread_mutex_lock(&mutex);
-	running_threads++;
-	rc = pthread_cond_wait(&cond, &mutex);
-
-	wake = rt_gettime() - beginrun;
-	running_threads--;
-	wakeup.arr[wakeup.counter++] = mypri;
-	debug(0, "%08lld us: RealtimeThread-%03d pri %03d awake\n",
-	      wake / NS_PER_US, j, mypri);
+	for (iter = 0; iter < iterations; iter++) {
+		rc = pthread_mutex_lock(&mutex);
+		running_threads++;
+		do {
+			rc = pthread_cond_wait(&cond, &mutex);
+		} while (myround == round_num);
+		myround = round_num;
+
+		wake = rt_gettime();
+		running_threads--;
+		wakeup.arr[wakeup.counter++] = mypri;
+		if (iter == 0)
+			debug(0,
+			      "%08lld us: RealtimeThread-%03d pri %03d awake\n",
+			      (wake - beginrun) / NS_PER_US, j, mypri);
+
+		/* the mutex serializes the appends as well as the wakeups */
+		rec.x = iter;
+		rec.y = (wake - bcast_time) / NS_PER_US;
+		stats_container_append(&wake_lat, rec);
+		if (wakeup.counter > 1) {
+			rec.y = (wake - last_wake) / NS_PER_US;
+			stats_container_append(&handoff_lat, rec);
+		}
+		last_wake = wake;
+		woken++;
 
-	rc = pthread_mutex_unlock(&mutex);
+		rc = pthread_mutex_unlock(&mutex);
+	}
 
 	return NULL;
 }
 
+static void print_stats(const char *name, stats_container_t * data)
+{
+	stats_quantiles_t quantiles;
+	long nsamples = data->index + 1;
+
+	if (nsamples <= 0)
+		return;
+
+	printf("\n%s (us)\n", name);
+	printf("Samples: %ld\n", nsamples);
+	printf("Min: %ld\n", stats_min(data));
+	printf("Max: %ld\n", stats_max(data));
+	printf("Avg: %.4f\n", stats_avg(data));
+	printf("StdDev: %.4f\n", stats_stddev(data));
+
+	/* quantiles need at least two nines worth of samples */
+	if (nsamples >= 100 &&
+	    stats_quantiles_init(&quantiles, (int)log10(nsamples)) == 0) {
+		if (stats_quantiles_calc(data, &quantiles) == 0)
+			stats_quantiles_print(&quantiles);
+		stats_quantiles_free(&quantiles);
+	}
+}
+
 int main(int argc, char *argv[])
 {
 	int threads_per_prio;
@@ -173,18 +275,23 @@ int main(int argc, char *argv[])
 	int i;
 	setup();
 
-	rt_init("hn:l:", parse_args, argc, argv);
+	rt_init("hi:n:l:", parse_args, argc, argv);
 
 	if (rt_threads == 0) {
 		numcpus = sysconf(_SC_NPROCESSORS_ONLN);
 		rt_threads = numcpus;
 	}
+	if (iterations < 1)
+		iterations = 1;
 	wakeup.arr = malloc(rt_threads * sizeof(int));
 	wakeup.counter = 0;
+	stats_container_init(&wake_lat, (long)rt_threads * iterations);
+	stats_container_init(&handoff_lat, (long)rt_threads * iterations);
 	printf("\n-----------------------\n");
 	printf("Priority Ordered Wakeup\n");
 	printf("-----------------------\n");
 	printf("Worker Threads: %d\n", rt_threads);
+	printf("Iterations: %d\n", iterations);
 	printf("Calling pthread_cond_broadcast() with mutex: %s\n\n",
 	       locked_broadcast ? "LOCKED" : "UNLOCKED");
 
@@ -217,15 +324,13 @@ int main(int argc, char *argv[])
 
 	pthread_mutex_destroy(&mutex);
 
-	printf("\nCriteria: Threads should be woken up in priority order\n");
+	print_stats("Broadcast to wakeup latency", &wake_lat);
+	print_stats("Wakeup to wakeup (mutex handoff) latency", &handoff_lat);
 
-	for (i = 0; i < (wakeup.counter - 1); i++) {
-		if (wakeup.arr[i] < wakeup.arr[i + 1]) {
-			printf("FAIL: Thread %d woken before %d\n",
-			       wakeup.arr[i], wakeup.arr[i + 1]);
-			ret++;
-		}
-	}
+	stats_container_free(&wake_lat);
+	stats_container_free(&handoff_lat);
+
+	printf("\nCriteria: Threads should be woken up in priority order\n");
 	printf("Result: %s\n", ret ? "FAIL" : "PASS");
 	return ret;
 }
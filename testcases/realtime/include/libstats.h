@@ -72,6 +72,21 @@ typedef struct stats_quantiles {
 	long *quantiles;
 } stats_quantiles_t;
 
+/* number of sub-buckets per power of two in a stats stream, the
+ * relative quantile error is about 2^-STATS_STREAM_BITS
+ */
+#define STATS_STREAM_BITS 8
+
+typedef struct stats_stream {
+	long n;
+	long min;
+	long max;
+	double mean;
+	double m2;
+	long nbuckets;
+	long *buckets;
+} stats_stream_t;
+
 extern int save_stats;
 
 /* function prototypes */
@@ -163,6 +178,49 @@ void stats_hist_print(stats_container_t *hist);
  */
 int stats_container_save(char *filename, char *title, char *labelx, char *labely, stats_container_t *data, char *mode);
 
+/* stats_stream_init - allocate the buckets and zero the running terms
+ * stream: stats_stream_t destination pointer
+ * Unlike the containers above a stream never grows: insertion is O(1)
+ * and the memory stays fixed however long the test samples.
+ */
+int stats_stream_init(stats_stream_t *stream);
+
+/* stats_stream_free - free the buckets array
+ * stream: stats_stream_t to free
+ */
+int stats_stream_free(stats_stream_t *stream);
+
+/* stats_stream_add - account one sample in the running statistics
+ * stream: stats_stream_t accumulating the samples
+ * y: sample value, negative values count towards the lowest bucket
+ */
+void stats_stream_add(stats_stream_t *stream, long y);
+
+/* stats_stream_avg - return the running mean of the samples
+ * stream: stats_stream_t accumulating the samples
+ */
+float stats_stream_avg(stats_stream_t *stream);
+
+/* stats_stream_stddev - return the running standard deviation
+ * stream: stats_stream_t accumulating the samples
+ */
+float stats_stream_stddev(stats_stream_t *stream);
+
+/* stats_stream_quantile - return the quantile with the given number of
+ * nines, rounded down to the start of the bucket it fell into
+ * stream: stats_stream_t accumulating the samples
+ * nines: 2 for 99%, 3 for 99.9% and so on
+ */
+long stats_stream_quantile(stats_stream_t *stream, int nines);
+
+/* stats_stream_quantiles_print - print the quantiles from two nines up
+ * to the requested number, in the same format as stats_quantiles_print
+ * stream: stats_stream_t accumulating the samples
+ * nines: int number of nines in the most inclusive quantile
+ * Returns -1 when fewer than 10^nines samples have been added
+ */
+int stats_stream_quantiles_print(stats_stream_t *stream, int nines);
+
 /* stats_container_append - appends stats_record_t to data
  * data: stats_container_t structure for holding the records list, index of
  *       min and max elements in records list and the sum
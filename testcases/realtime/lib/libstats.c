@@ -310,6 +310,129 @@ void stats_hist_print(stats_container_t * hist)
 	}
 }
 
+/* streaming statistics
+ *
+ * The container based routines above keep every sample and re-sort the
+ * whole array per quantile query, which limits how long a test can
+ * sample. The stream keeps a running mean and variance (Welford's
+ * method) and counts samples in logarithmic buckets with 2^bits
+ * sub-buckets per power of two, so insertion is O(1), memory is fixed
+ * and quantiles stay within about 2^-bits relative error no matter how
+ * many samples go in.
+ */
+
+static long stats_stream_bucket(long y)
+{
+	unsigned long v = y;
+	unsigned long sub = 1ul << STATS_STREAM_BITS;
+	long e = 0;
+
+	if (y < 0)
+		return 0;
+
+	while (v >= 2 * sub) {
+		v >>= 1;
+		e++;
+	}
+
+	if (!e)
+		return v;
+
+	return (e + 1) * sub + (v - sub);
+}
+
+/* lowest y value that falls into a bucket, inverse of the above */
+static long stats_stream_bucket_low(long b)
+{
+	long sub = 1l << STATS_STREAM_BITS;
+	long e;
+
+	if (b < 2 * sub)
+		return b;
+
+	e = b / sub - 1;
+
+	return (sub + b % sub) << e;
+}
+
+int stats_stream_init(stats_stream_t * stream)
+{
+	memset(stream, 0, sizeof(*stream));
+	stream->nbuckets = (64 - STATS_STREAM_BITS) << STATS_STREAM_BITS;
+	stream->buckets = calloc(stream->nbuckets, sizeof(long));
+	if (!stream->buckets)
+		return -1;
+	return 0;
+}
+
+int stats_stream_free(stats_stream_t * stream)
+{
+	free(stream->buckets);
+	stream->buckets = NULL;
+	return 0;
+}
+
+void stats_stream_add(stats_stream_t * stream, long y)
+{
+	double delta;
+
+	if (!stream->n || y < stream->min)
+		stream->min = y;
+	if (!stream->n || y > stream->max)
+		stream->max = y;
+
+	stream->n++;
+	delta = y - stream->mean;
+	stream->mean += delta / stream->n;
+	stream->m2 += delta * (y - stream->mean);
+
+	stream->buckets[stats_stream_bucket(y)]++;
+}
+
+float stats_stream_avg(stats_stream_t * stream)
+{
+	return stream->mean;
+}
+
+float stats_stream_stddev(stats_stream_t * stream)
+{
+	if (!stream->n)
+		return 0.0;
+	return sqrt(stream->m2 / stream->n);
+}
+
+long stats_stream_quantile(stats_stream_t * stream, int nines)
+{
+	long b, count = 0;
+	long limit = stream->n - stream->n / (long)exp10(nines);
+
+	for (b = 0; b < stream->nbuckets; b++) {
+		count += stream->buckets[b];
+		if (count >= limit)
+			return stats_stream_bucket_low(b);
+	}
+
+	return stream->max;
+}
+
+int stats_stream_quantiles_print(stats_stream_t * stream, int nines)
+{
+	int i;
+	int fraction = 0;
+
+	/* insufficient data for the requested number of nines */
+	if (nines < 2 || stream->n < (long)exp10(nines))
+		return -1;
+
+	for (i = 2; i <= nines; i++) {
+		if (i > 2)
+			fraction += 9 * exp10(i - 3);
+		printf("99.%d%% < %ld\n", fraction,
+		       stats_stream_quantile(stream, i));
+	}
+	return 0;
+}
+
 int stats_container_save(char *filename, char *title, char *xlabel,
 			 char *ylabel, stats_container_t * data, char *mode)
 {
@@ -33,11 +33,15 @@
 usage()
 {
 	cat <<EOF
-usage: $(basename "$0") [-p profile] -t test-argument [-l num_of_loops]
+usage: $(basename "$0") [-p profile] [-j] -t test-argument [-l num_of_loops]
 
  -h			help
  -p profile		Use profile instead of default (see
 			doc/AUTOMATED_RUN)
+ -j			Run compatible tests concurrently on disjoint
+			cores, honoring the #@ cpus=N / #@ exclusive
+			annotations in the profile (see
+			scripts/run_parallel.sh)
  -t test-arguments	Where test-argument can be a space separated
 			sequence of:
 			func		all functional tests will be run
@@ -198,7 +202,7 @@ fi
 
 ISLOOP=0
 index=0
-while getopts "hl:p:t:" option
+while getopts "hjl:p:t:" option
 do
 	case "$option" in
 
@@ -224,6 +228,9 @@ do
 	p )
 		profile=$OPTARG
 		;;
+	j )
+		PARALLEL=1
+		;;
 	h )
 		usage
 		;;
@@ -237,6 +244,24 @@ tests[$index]=1
 
 i=0
 while [ $i -lt $index ]; do
-	find_test "$profile" ${tests[$i]} ${tests[$((i+1))]}
+	if [ "$PARALLEL" = 1 ]; then
+		loops=$(( 0 + ${tests[$((i+1))]} ))
+		[ $loops -eq 0 ] && loops=1
+		case ${tests[$i]} in
+		list | clean )
+			find_test "$profile" ${tests[$i]} ${tests[$((i+1))]}
+			;;
+		all )
+			$SCRIPTS_DIR/run_parallel.sh "${profile:-default}" \
+				$loops func stress perf
+			;;
+		* )
+			$SCRIPTS_DIR/run_parallel.sh "${profile:-default}" \
+				$loops ${tests[$i]}
+			;;
+		esac
+	else
+		find_test "$profile" ${tests[$i]} ${tests[$((i+1))]}
+	fi
 	: $(( i += 2 ))
 done
@@ -0,0 +1,228 @@
+#! /bin/bash
+
+#
+# Parallel scheduler for profile runs, used by run.sh -j.
+#
+# Usage: $0 profile loops subdir [ subdir ... ]
+#
+# Runs every profile line whose relative directory falls under one of
+# the given subdirs, like scripts/run_c_files.sh does, but schedules
+# mutually compatible tests concurrently on disjoint cores instead of
+# strictly serially. Each test is pinned with taskset to the cores it
+# was allotted, so concurrently running tests cannot disturb each
+# other's scheduling.
+#
+# How many cores a test needs comes from an annotation in the profile.
+# Annotations live behind "#@" so the serial parser, which strips
+# everything after "#", never sees them:
+#
+#	func/pi-tests	testpi-1		#@ cpus=2
+#	func/sched_latency sched_latency -c 100	#@ exclusive
+#
+#	cpus=N		test needs N cores (default 1)
+#	exclusive	test measures latency or loads the whole
+#			machine; everything else is drained first and
+#			the test runs alone, unpinned
+#
+# Unannotated lines default to one core, which can only make them run
+# on a quieter machine than the serial runner gives them.
+#
+
+[ $# -lt 3 ] && { echo >&2 "$0: too few arguments (at least three)" ; exit 1 ; }
+profile=$1
+loops=$2
+shift 2
+subdirs="$*"
+
+profile_path=$PROFILES_DIR/$profile
+[ ! -f "$profile_path" ] && { echo >&2 "$0: Could not find profile ($profile_path)" ; exit 1 ; }
+
+NCPUS=$(getconf _NPROCESSORS_ONLN)
+[ -z "$NCPUS" ] && NCPUS=1
+
+# cpu_pid[c] is the pid owning core c, empty if the core is free
+declare -a cpu_pid
+# job_desc[pid] describes the running test for failure reporting
+declare -A job_desc
+failures=0
+
+# Matches $1 against the requested subdirs (also taking a full
+# relative directory, as "run.sh -t func/pi-tests" does).
+dir_wanted()
+{
+	local sub
+
+	for sub in $subdirs; do
+		case $1 in
+		$sub | $sub/* ) return 0 ;;
+		esac
+	done
+	return 1
+}
+
+# Reaps every finished job and frees its cores.
+reap_jobs()
+{
+	local pid c
+
+	for pid in "${!job_desc[@]}"; do
+		kill -0 $pid 2>/dev/null && continue
+
+		wait $pid
+		if [ $? -gt 0 ]; then
+			echo " ${job_desc[$pid]} exited non-zero"
+			: $(( failures += 1 ))
+		fi
+
+		for c in $(seq 0 $(( NCPUS - 1 ))); do
+			[ "${cpu_pid[$c]}" = "$pid" ] && cpu_pid[$c]=
+		done
+		unset job_desc[$pid]
+	done
+}
+
+# Tries to grab $1 free cores; on success puts the taskset list in
+# $alloc_list and marks them with the placeholder owner "held".
+alloc_cpus()
+{
+	local want=$1 c got=0
+
+	alloc_list=
+	for c in $(seq 0 $(( NCPUS - 1 ))); do
+		[ -n "${cpu_pid[$c]}" ] && continue
+		alloc_list=${alloc_list:+$alloc_list,}$c
+		cpu_pid[$c]=held
+		: $(( got += 1 ))
+		[ $got -eq $want ] && return 0
+	done
+
+	# not enough; put them back
+	for c in $(seq 0 $(( NCPUS - 1 ))); do
+		[ "${cpu_pid[$c]}" = "held" ] && cpu_pid[$c]=
+	done
+	return 1
+}
+
+drain_jobs()
+{
+	while [ ${#job_desc[@]} -gt 0 ]; do
+		sleep 0.1
+		reap_jobs
+	done
+}
+
+# Runs one test the way run_c_files.sh does: from its directory, with
+# output appended to a log named after the command.
+exec_test()
+{
+	local reldir=$1 cpulist=$2 cmd=$3
+	shift 3
+	local params="$*"
+	local log="$LOG_DIR/$LOG_FORMAT-${cmd}${params// /}.log"
+
+	[ ! -d $LOG_DIR ] && mkdir -p $LOG_DIR
+
+	cd $TESTS_DIR/$reldir || exit 1
+	export TEST_REL_DIR=$reldir
+
+	(
+		echo "--- Running testcase $cmd $params (cpus: ${cpulist:-all}) ---"
+		date
+		echo "Logging to $log"
+		if [ -n "$cpulist" ]; then
+			eval taskset -c $cpulist ./$cmd 2>&1 $params
+		else
+			eval ./$cmd 2>&1 $params
+		fi
+		rc=$?
+		echo
+		date
+		echo "The $cmd test appears to have completed."
+		exit $rc
+	) | tee -a $log
+
+	return ${PIPESTATUS[0]}
+}
+
+# Build each involved test directory up front; make is not safe to
+# run concurrently with the tests of a neighbouring directory.
+built_dirs=
+build_dirs()
+{
+	local line reldir
+
+	sed 's/#.*//' < $profile_path | while read reldir cmd params; do
+		[ -z "$cmd" ] && continue
+		dir_wanted $reldir || continue
+		echo $reldir
+	done | sort -u | while read reldir; do
+		if [ -f $TESTS_DIR/$reldir/Makefile ]; then
+			make -C $TESTS_DIR/$reldir
+		fi
+	done
+}
+
+run_schedule()
+{
+	while read line; do
+		# split the annotation off before stripping comments
+		ann=
+		case $line in
+		*"#@"* ) ann=${line#*#@} ;;
+		esac
+		set -- ${line%%#*}
+		[ $# -lt 2 ] && continue
+
+		reldir=$1
+		shift
+		dir_wanted $reldir || continue
+
+		want=1
+		exclusive=0
+		for tok in $ann; do
+			case $tok in
+			cpus=* ) want=${tok#cpus=} ;;
+			exclusive ) exclusive=1 ;;
+			esac
+		done
+		[ $want -gt $NCPUS ] && want=$NCPUS
+
+		if [ $exclusive -eq 1 ]; then
+			drain_jobs
+			exec_test $reldir "" "$@"
+			if [ $? -gt 0 ]; then
+				echo " $reldir $1 exited non-zero"
+				: $(( failures += 1 ))
+			fi
+			continue
+		fi
+
+		until alloc_cpus $want; do
+			sleep 0.1
+			reap_jobs
+		done
+
+		( exec_test $reldir $alloc_list "$@" ) &
+		job_desc[$!]="$reldir $1"
+		for c in ${alloc_list//,/ }; do
+			cpu_pid[$c]=$!
+		done
+	done < $profile_path
+
+	drain_jobs
+}
+
+build_dirs
+
+iter=0
+while [ $iter -lt $loops ]; do
+	run_schedule
+	: $(( iter += 1 ))
+done
+
+if [ $failures -gt 0 ]; then
+	echo
+	echo " $failures test(s) exited non-zero"
+	echo
+	exit 1
+fi
@@ -17,6 +17,11 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#ifdef __linux__
+/* For CPU_SET and sched_setaffinity, used for NUMA worker placement.  */
+#define _GNU_SOURCE
+#endif
+
 #include <ctype.h>
 #include <errno.h>
 #include <libgen.h>
@@ -29,6 +34,15 @@
 #include <unistd.h>
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+/* Deterministic load profiles for the calibrated cpu hogs.  */
+#define PROFILE_STEP 0
+#define PROFILE_RAMP 1
+#define PROFILE_BURST 2
+
 /* By default, print all messages of severity info and above.  */
 static int global_debug = 2;
 
@@ -50,6 +64,18 @@ static char *global_progname = PACKAGE;
 /* By default, do not hang after allocating memory.  */
 static int global_vmhang = 0;
 
+/* By default, spin flat out rather than duty-cycle to a target load.  */
+static int global_cpuload = 100;
+
+/* By default, hold the target load constant.  */
+static int global_profile = PROFILE_STEP;
+
+/* By default, repeat ramp and burst profiles every 10 seconds.  */
+static int global_period = 10;
+
+/* By default, do not bind workers to NUMA nodes.  */
+static int global_numa = 0;
+
 /* Implemention of runtime-selectable severity message printing.  */
 #define dbg if (global_debug >= 3) \
             fprintf (stdout, "%s: debug: (%d) ", global_progname, __LINE__), \
@@ -79,6 +105,11 @@ int version(int status);
 long long atoll_s(const char *nptr);
 long long atoll_b(const char *nptr);
 
+/* Prototypes for the load calibration and placement helpers.  */
+int numa_discover(void);
+void numa_bind_worker(long long worker);
+int hogcpu_cycle(void);
+
 /* Prototypes for the worker functions.  */
 int hogcpu(long long forks);
 int hogio(long long forks);
@@ -162,6 +193,38 @@ int main(int argc, char **argv)
 			do_cpu = 1;
 			assert_arg("--cpu");
 			do_cpu_forks = atoll_b(arg);
+		} else if (strcmp(arg, "--cpu-load") == 0) {
+			assert_arg("--cpu-load");
+			global_cpuload = atoll(arg);
+			if (global_cpuload < 1 || global_cpuload > 100) {
+				err(stderr, "invalid target load: %i%%\n",
+				    global_cpuload);
+				exit(1);
+			}
+			dbg(stdout, "setting target load to %i%%\n",
+			    global_cpuload);
+		} else if (strcmp(arg, "--cpu-profile") == 0) {
+			assert_arg("--cpu-profile");
+			if (strcmp(arg, "step") == 0) {
+				global_profile = PROFILE_STEP;
+			} else if (strcmp(arg, "ramp") == 0) {
+				global_profile = PROFILE_RAMP;
+			} else if (strcmp(arg, "burst") == 0) {
+				global_profile = PROFILE_BURST;
+			} else {
+				err(stderr, "unrecognized profile: %s\n", arg);
+				exit(1);
+			}
+		} else if (strcmp(arg, "--profile-period") == 0) {
+			assert_arg("--profile-period");
+			global_period = atoll_s(arg);
+			if (global_period < 1) {
+				err(stderr, "invalid profile period: %i\n",
+				    global_period);
+				exit(1);
+			}
+		} else if (strcmp(arg, "--numa") == 0) {
+			global_numa = 1;
 		} else if (strcmp(arg, "--io") == 0 || strcmp(arg, "-i") == 0) {
 			do_io = 1;
 			assert_arg("--io");
@@ -196,6 +259,12 @@ int main(int argc, char **argv)
 		}
 	}
 
+	/* Discover the NUMA topology before dispatching any workers.  */
+	if (global_numa && numa_discover() == 0) {
+		wrn(stderr, "no NUMA topology found, placement disabled\n");
+		global_numa = 0;
+	}
+
 	/* Hog CPU option.  */
 	if (do_cpu) {
 		out(stdout, "dispatching %lli hogcpu forks\n", do_cpu_forks);
@@ -343,6 +412,10 @@ int usage(int status)
 	    " -t, --timeout n       timeout after n seconds\n"
 	    "     --backoff n       wait for factor of n us before starting work\n"
 	    " -c, --cpu n           spawn n procs spinning on sqrt()\n"
+	    "     --cpu-load p      duty-cycle each cpu proc to p percent load\n"
+	    "     --cpu-profile s   target load profile: step, ramp or burst\n"
+	    "     --profile-period n repeat ramp/burst profile every n seconds\n"
+	    "     --numa            bind workers round-robin to NUMA nodes\n"
 	    " -i, --io n            spawn n procs spinning on sync()\n"
 	    " -m, --vm n            spawn n procs spinning on malloc()\n"
 	    "     --vm-chunks c     malloc c chunks (default is 1)\n"
@@ -462,6 +535,159 @@ long long atoll_s(const char *nptr)
 	return factor;
 }
 
+#ifdef __linux__
+
+#define MAX_NODES 64
+
+static cpu_set_t node_cpus[MAX_NODES];
+static int numa_nodes = 0;
+
+/* Parse a sysfs cpulist such as "0-3,8-11" into a cpu set.  */
+static int parse_cpulist(const char *buf, cpu_set_t * set)
+{
+	int first, last, cpu;
+
+	CPU_ZERO(set);
+
+	while (*buf && *buf != '\n') {
+		if (sscanf(buf, "%d-%d", &first, &last) == 2) {
+		} else if (sscanf(buf, "%d", &first) == 1) {
+			last = first;
+		} else {
+			return -1;
+		}
+
+		for (cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+			CPU_SET(cpu, set);
+
+		while (*buf && *buf != ',' && *buf != '\n')
+			buf++;
+		if (*buf == ',')
+			buf++;
+	}
+
+	return 0;
+}
+
+/* Read the cpu set of every populated NUMA node from sysfs.  Returns the
+ * number of nodes found, zero on machines without the sysfs topology.
+ */
+int numa_discover(void)
+{
+	char path[64], buf[4096];
+	FILE *fp;
+	int node;
+
+	for (node = 0; node < MAX_NODES; node++) {
+		sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+		if ((fp = fopen(path, "r")) == NULL)
+			continue;
+		if (fgets(buf, sizeof(buf), fp) != NULL &&
+		    parse_cpulist(buf, &node_cpus[numa_nodes]) == 0)
+			numa_nodes++;
+		fclose(fp);
+	}
+
+	dbg(stdout, "found %i NUMA nodes\n", numa_nodes);
+
+	return numa_nodes;
+}
+
+/* Pin a worker to the cpus of one node, distributing workers round-robin
+ * over the nodes so that the load lands evenly on the machine.
+ */
+void numa_bind_worker(long long worker)
+{
+	if (!global_numa || numa_nodes == 0)
+		return;
+
+	if (sched_setaffinity(0, sizeof(cpu_set_t),
+			      &node_cpus[worker % numa_nodes]) == -1)
+		wrn(stderr, "failed to bind worker to node %lli\n",
+		    worker % numa_nodes);
+}
+
+#else /* !__linux__ */
+
+int numa_discover(void)
+{
+	return 0;
+}
+
+void numa_bind_worker(long long worker)
+{
+	(void)worker;
+}
+
+#endif /* __linux__ */
+
+/* Seconds on the monotonic clock, for the duty-cycle control loop.  */
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Target load in percent at a given time into the run.  Profiles are a
+ * function of absolute elapsed time, so all workers move in lockstep and
+ * a run is reproducible.
+ */
+static int profile_target(double elapsed)
+{
+	double phase =
+	    (elapsed - global_period * (long)(elapsed / global_period)) /
+	    global_period;
+
+	switch (global_profile) {
+	case PROFILE_RAMP:
+		return global_cpuload * phase;
+	case PROFILE_BURST:
+		return phase < 0.5 ? global_cpuload : 0;
+	default:
+		return global_cpuload;
+	}
+}
+
+/* Closed-loop duty cycle: in every 100ms slice spin for the target share
+ * and sleep the rest, carrying the measured overshoot or undershoot into
+ * the next slice so the average converges on the target regardless of
+ * scheduling noise.  Runs until the alarm fires.
+ */
+int hogcpu_cycle(void)
+{
+	const double slice = 0.1;
+	double start = now_s();
+	double debt = 0.0;
+	double t0, t1, busy;
+	double d;
+
+	while (1) {
+		t0 = now_s();
+		busy = slice * profile_target(t0 - start) / 100.0 + debt;
+
+		if (busy > slice)
+			busy = slice;
+		if (busy < 0)
+			busy = 0;
+
+		t1 = t0;
+		while (t1 - t0 < busy) {
+			d = sqrt(rand());
+			t1 = now_s();
+		}
+
+		debt = busy - (t1 - t0);
+
+		if (t1 - t0 < slice)
+			usleep((slice - (t1 - t0)) * 1e6);
+	}
+
+	return 0;
+}
+
 int hogcpu(long long forks)
 {
 	long long i;
@@ -480,10 +706,15 @@ int hogcpu(long long forks)
 		switch (pid = fork()) {
 		case 0:	/* child */
 			alarm(timeout);
+			numa_bind_worker(i);
 
 			/* Use a backoff sleep to ensure we get good fork throughput.  */
 			usleep(backoff);
 
+			if (global_cpuload < 100 ||
+			    global_profile != PROFILE_STEP)
+				exit(hogcpu_cycle());
+
 			while (1)
 				d = sqrt(rand());
 
@@ -556,6 +787,7 @@ int hogio(long long forks)
 		switch (pid = fork()) {
 		case 0:	/* child */
 			alarm(timeout);
+			numa_bind_worker(i);
 
 			/* Use a backoff sleep to ensure we get good fork throughput.  */
 			usleep(backoff);
@@ -637,6 +869,7 @@ int hogvm(long long forks, long long chunks, long long bytes)
 		switch (pid = fork()) {
 		case 0:	/* child */
 			alarm(timeout);
+			numa_bind_worker(i);
 
 			/* Use a backoff sleep to ensure we get good fork throughput.  */
 			usleep(backoff);
@@ -766,6 +999,7 @@ int hoghdd(long long forks, int clean, long long files, long long bytes)
 		switch (pid = fork()) {
 		case 0:	/* child */
 			alarm(timeout);
+			numa_bind_worker(i);
 
 			/* Use a backoff sleep to ensure we get good fork throughput.  */
 			usleep(backoff);